@@ -1,6 +1,8 @@
 #include "AssimpLoader.h"
+#include "MeshOptimizer.h"
 
-void CAssimpLoader::LoadStaticModelFromFile(const string& FileName, SModel& Model, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext)
+#if !defined(GRASSFIELD_NO_ASSIMP)
+void CAssimpLoader::LoadStaticModelFromFile(const string& FileName, SModel& Model)
 {
 	m_Scene = m_AssimpImporter.ReadFile(FileName, aiProcess_ConvertToLeftHanded | 
 		aiProcess_ValidateDataStructure | aiProcess_OptimizeMeshes | aiProcess_PreTransformVertices |
@@ -12,15 +14,17 @@ void CAssimpLoader::LoadStaticModelFromFile(const string& FileName, SModel& Mode
 	assert(m_Scene->mRootNode);
 
 	LoadMeshesFromFile(m_Scene, Model.vMeshes);
-	LoadMaterialsFromFile(m_Scene, Device, DeviceContext, Model.vMaterials);
+	LoadMaterialsFromFile(m_Scene, Model.vMaterials);
+
+	OptimizeMeshes(FileName, Model.vMeshes);
 }
 
-void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Model, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext)
+void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Model)
 {
 	m_AssimpImporter.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_NORMALS);
 	m_Scene = m_AssimpImporter.ReadFile(FileName, aiProcess_ConvertToLeftHanded |
 		aiProcess_ValidateDataStructure | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph |
-		aiProcess_SplitLargeMeshes | aiProcess_ImproveCacheLocality | aiProcess_FixInfacingNormals |
+		aiProcess_SplitLargeMeshes | aiProcess_FixInfacingNormals |
 		aiProcess_Triangulate | aiProcess_SplitByBoneCount | aiProcess_JoinIdenticalVertices |
 		aiProcess_RemoveComponent | aiProcess_GenSmoothNormals);
 
@@ -34,7 +38,7 @@ void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Mo
 		Mesh.vVerticesAnimation.resize(Mesh.vVertices.size());
 	}
 
-	LoadMaterialsFromFile(m_Scene, Device, DeviceContext, Model.vMaterials);
+	LoadMaterialsFromFile(m_Scene, Model.vMaterials);
 
 	// Scene  Node Tree .
 	LoadNodes(m_Scene, m_Scene->mRootNode, -1, Model);
@@ -54,6 +58,9 @@ void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Mo
 	// Scene Animation ҷ´.
 	LoadAnimations(m_Scene, Model);
 
+	// @important: vertices are reordered, so this must come after MatchWeightsAndVertices()
+	OptimizeMeshes(FileName, Model.vMeshes);
+
 	// Animation Name  Index ã  ֵ (map)Ѵ. 
 	for (auto& Animation : Model.vAnimations)
 	{
@@ -66,6 +73,39 @@ void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Mo
 	Model.bIsModelAnimated = true;
 }
 
+void CAssimpLoader::OptimizeMeshes(const string& FileName, vector<SMesh>& vMeshes)
+{
+	// One summary per model: ACMR is weighted by triangles, ATVR by vertices (so both stay ratios of the whole model)
+	double MissesBefore{};
+	double MissesAfter{};
+	double TransformsPerVertexBefore{};
+	double TransformsPerVertexAfter{};
+	size_t TriangleCount{};
+	size_t VertexCountBefore{};
+	size_t VertexCountAfter{};
+	ULONGLONG ElapsedMilliseconds{};
+	for (SMesh& Mesh : vMeshes)
+	{
+		CMeshOptimizer::SStats Stats{};
+		CMeshOptimizer::OptimizeMesh(Mesh, CMeshOptimizer::SDesc(), &Stats);
+
+		MissesBefore += static_cast<double>(Stats.Before.ACMR) * Stats.TriangleCount;
+		MissesAfter += static_cast<double>(Stats.After.ACMR) * Stats.TriangleCount;
+		TransformsPerVertexBefore += static_cast<double>(Stats.Before.ATVR) * Stats.VertexCountBefore;
+		TransformsPerVertexAfter += static_cast<double>(Stats.After.ATVR) * Stats.VertexCountAfter;
+		TriangleCount += Stats.TriangleCount;
+		VertexCountBefore += Stats.VertexCountBefore;
+		VertexCountAfter += Stats.VertexCountAfter;
+		ElapsedMilliseconds += Stats.ElapsedMilliseconds;
+	}
+	if (TriangleCount == 0) return;
+
+	OutputDebugString(("- Model [" + FileName + "] optimized. " + to_string(vMeshes.size()) + " meshes, " + to_string(TriangleCount) + " triangles, ACMR "
+		+ to_string(MissesBefore / TriangleCount) + " -> " + to_string(MissesAfter / TriangleCount) + ", ATVR "
+		+ to_string(TransformsPerVertexBefore / max(VertexCountBefore, (size_t)1)) + " -> "
+		+ to_string(TransformsPerVertexAfter / max(VertexCountAfter, (size_t)1)) + " [" + to_string(ElapsedMilliseconds) + "] elapsed.\n").c_str());
+}
+
 XMVECTOR CAssimpLoader::ConvertaiVector3DToXMVECTOR(const aiVector3D& Vector, float w)
 {
 	return XMVectorSet(Vector.x, Vector.y, Vector.z, w);
@@ -138,7 +178,7 @@ void CAssimpLoader::LoadMeshesFromFile(const aiScene* const Scene, vector<SMesh>
 	}
 }
 
-void CAssimpLoader::LoadMaterialsFromFile(const aiScene* const Scene, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext, vector<CMaterial>& vMaterials)
+void CAssimpLoader::LoadMaterialsFromFile(const aiScene* const Scene, vector<CMaterial>& vMaterials)
 {
 	unsigned int MaterialCount{ Scene->mNumMaterials };
 	vMaterials.resize(MaterialCount);
@@ -370,4 +410,16 @@ void CAssimpLoader::LoadAnimations(const aiScene* const Scene, SModel& Model)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+#else
+// Headless builds where the Assimp library isn't found (see CMakeLists.txt) import no models
+void CAssimpLoader::LoadStaticModelFromFile(const string& FileName, SModel& Model)
+{
+	OutputDebugString(("Assimp isn't linked, so " + FileName + " can't be imported\n").c_str());
+}
+
+void CAssimpLoader::LoadAnimatedModelFromFile(const string& FileName, SModel& Model)
+{
+	OutputDebugString(("Assimp isn't linked, so " + FileName + " can't be imported\n").c_str());
+}
+#endif
\ No newline at end of file
@@ -37,11 +37,19 @@ struct SInstanceGPUData
 	XMMATRIX	InstanceWorldMatrix{ KMatrixIdentity };
 };
 
+// Coarser level of an SMesh (see CMeshSimplifier)
+struct SMeshLOD
+{
+	vector<STriangle>			vTriangles{}; // Indices into SMesh::vVertices
+	float						RelativeError{}; // Simplification error / model's bounding radius
+};
+
 struct SMesh
 {
 	vector<SVertex3D>			vVertices{};
 	vector<SVertexAnimation>	vVerticesAnimation{};
 	vector<STriangle>			vTriangles{};
+	vector<SMeshLOD>			vLODs{}; // LOD 1, 2, ... (LOD 0 is vTriangles)
 
 	size_t						MaterialID{};
 };
@@ -113,8 +121,8 @@ public:
 	CAssimpLoader() {}
 	~CAssimpLoader() {}
 
-	void LoadStaticModelFromFile(const string& FileName, SModel& Model, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext);
-	void LoadAnimatedModelFromFile(const string& FileName, SModel& Model, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext);
+	void LoadStaticModelFromFile(const string& FileName, SModel& Model);
+	void LoadAnimatedModelFromFile(const string& FileName, SModel& Model);
 
 private:
 	XMVECTOR ConvertaiVector3DToXMVECTOR(const aiVector3D& Vector, float w);
@@ -122,7 +130,8 @@ private:
 	XMMATRIX ConvertaiMatrix4x4ToXMMATRIX(const aiMatrix4x4& Matrix);
 
 	void LoadMeshesFromFile(const aiScene* const Scene, vector<SMesh>& vMeshes);
-	void LoadMaterialsFromFile(const aiScene* const Scene, ID3D11Device* Device, ID3D11DeviceContext* DeviceContext, vector<CMaterial>& vMaterials);
+	void OptimizeMeshes(const string& FileName, vector<SMesh>& vMeshes);
+	void LoadMaterialsFromFile(const aiScene* const Scene, vector<CMaterial>& vMaterials);
 
 private:
 	void LoadTextureData(const aiScene* const Scene, const aiString& TextureFileName, CMaterial& Material, CMaterial::CTexture::EType eTextureType);
@@ -134,6 +143,8 @@ private:
 	void LoadAnimations(const aiScene* const Scene, SModel& Model);
 
 private:
+#if !defined(GRASSFIELD_NO_ASSIMP) // Headless builds where the Assimp library isn't found (see CMakeLists.txt)
 	Assimp::Importer	m_AssimpImporter{};
+#endif
 	const aiScene*		m_Scene{};
 };
\ No newline at end of file
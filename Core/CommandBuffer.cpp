@@ -0,0 +1,431 @@
+#include "CommandBuffer.h"
+
+template <typename T>
+static T* ToObject(const void* const PtrObject)
+{
+	return static_cast<T*>(const_cast<void*>(PtrObject));
+}
+
+void CCommandBuffer::SetVertexShader(ID3D11VertexShader* const PtrShader)
+{
+	Record(ECommandType::SetVertexShader, EShaderType::VertexShader, 0, PtrShader);
+}
+
+void CCommandBuffer::SetHullShader(ID3D11HullShader* const PtrShader)
+{
+	Record(ECommandType::SetHullShader, EShaderType::HullShader, 0, PtrShader);
+}
+
+void CCommandBuffer::SetDomainShader(ID3D11DomainShader* const PtrShader)
+{
+	Record(ECommandType::SetDomainShader, EShaderType::DomainShader, 0, PtrShader);
+}
+
+void CCommandBuffer::SetGeometryShader(ID3D11GeometryShader* const PtrShader)
+{
+	Record(ECommandType::SetGeometryShader, EShaderType::GeometryShader, 0, PtrShader);
+}
+
+void CCommandBuffer::SetPixelShader(ID3D11PixelShader* const PtrShader)
+{
+	Record(ECommandType::SetPixelShader, EShaderType::PixelShader, 0, PtrShader);
+}
+
+void CCommandBuffer::SetInputLayout(ID3D11InputLayout* const PtrInputLayout)
+{
+	Record(ECommandType::SetInputLayout, EShaderType::VertexShader, 0, PtrInputLayout);
+}
+
+void CCommandBuffer::SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer)
+{
+	Record(ECommandType::SetConstantBuffer, eShaderType, Slot, PtrBuffer);
+}
+
+void CCommandBuffer::SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView)
+{
+	Record(ECommandType::SetShaderResource, eShaderType, Slot, PtrShaderResourceView);
+}
+
+void CCommandBuffer::SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState)
+{
+	Record(ECommandType::SetSamplerState, eShaderType, Slot, PtrState);
+}
+
+void CCommandBuffer::SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant,
+	UINT ConstantCount)
+{
+	Record(ECommandType::SetConstantBufferRange, eShaderType, Slot, PtrBuffer, nullptr, FirstConstant, ConstantCount);
+}
+
+void CCommandBuffer::SetRasterizerState(ID3D11RasterizerState* const PtrState)
+{
+	Record(ECommandType::SetRasterizerState, EShaderType::PixelShader, 0, PtrState);
+}
+
+void CCommandBuffer::SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef)
+{
+	Record(ECommandType::SetDepthStencilState, EShaderType::PixelShader, 0, PtrState, nullptr, StencilRef);
+}
+
+void CCommandBuffer::SetBlendState(ID3D11BlendState* const PtrState)
+{
+	Record(ECommandType::SetBlendState, EShaderType::PixelShader, 0, PtrState);
+}
+
+void CCommandBuffer::SetViewport(const D3D11_VIEWPORT& Viewport)
+{
+	Record(ECommandType::SetViewport, EShaderType::PixelShader, 0, nullptr, CopyData(&Viewport, sizeof(Viewport)));
+}
+
+void CCommandBuffer::SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView)
+{
+	Record(ECommandType::SetRenderTarget, EShaderType::PixelShader, 0, PtrRenderTargetView, PtrDepthStencilView);
+}
+
+void CCommandBuffer::ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4])
+{
+	Record(ECommandType::ClearRenderTarget, EShaderType::PixelShader, 0, PtrRenderTargetView, CopyData(Color, sizeof(FLOAT) * 4));
+}
+
+void CCommandBuffer::ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+	UINT DepthBits{};
+	memcpy(&DepthBits, &Depth, sizeof(DepthBits));
+	Record(ECommandType::ClearDepthStencil, EShaderType::PixelShader, 0, PtrDepthStencilView, nullptr, ClearFlags, DepthBits,
+		static_cast<UINT>(Stencil));
+}
+
+void CCommandBuffer::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology)
+{
+	Record(ECommandType::SetPrimitiveTopology, EShaderType::VertexShader, 0, nullptr, nullptr, static_cast<UINT>(eTopology));
+}
+
+void CCommandBuffer::SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset)
+{
+	Record(ECommandType::SetVertexBuffer, EShaderType::VertexShader, Slot, PtrBuffer, nullptr, Stride, Offset);
+}
+
+void CCommandBuffer::SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+	Record(ECommandType::SetIndexBuffer, EShaderType::VertexShader, 0, PtrBuffer, nullptr, static_cast<UINT>(Format), Offset);
+}
+
+void* CCommandBuffer::Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize)
+{
+	assert(eMapType == D3D11_MAP_WRITE_DISCARD);
+	if (!PtrBuffer || eMapType != D3D11_MAP_WRITE_DISCARD || ByteSize == 0) return nullptr;
+
+	SPendingMap PendingMap{};
+	PendingMap.PtrBuffer = PtrBuffer;
+	PendingMap.PtrData = AllocateData(ByteSize);
+	PendingMap.ByteSize = ByteSize;
+	m_vPendingMaps.emplace_back(PendingMap);
+	return PendingMap.PtrData;
+}
+
+void CCommandBuffer::Unmap(ID3D11Buffer* const PtrBuffer)
+{
+	for (auto it = m_vPendingMaps.begin(); it != m_vPendingMaps.end(); ++it)
+	{
+		if (it->PtrBuffer != PtrBuffer) continue;
+
+		Record(ECommandType::WriteBuffer, EShaderType::VertexShader, 0, PtrBuffer, it->PtrData, static_cast<UINT>(it->ByteSize));
+		m_vPendingMaps.erase(it);
+		return;
+	}
+	assert(false); // The buffer isn't mapped
+}
+
+void CCommandBuffer::UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize)
+{
+	Record(ECommandType::UpdateBuffer, EShaderType::VertexShader, 0, PtrBuffer, CopyData(PtrData, ByteSize), ByteSize);
+}
+
+void CCommandBuffer::CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset,
+	UINT ByteSize)
+{
+	Record(ECommandType::CopyBufferRegion, EShaderType::VertexShader, 0, PtrDstBuffer, PtrSrcBuffer, DstOffset, SrcOffset, ByteSize);
+}
+
+bool CCommandBuffer::MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped)
+{
+	assert(false);
+	return false;
+}
+
+void CCommandBuffer::UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource)
+{
+	assert(false); // The texture can't be mapped
+}
+
+void CCommandBuffer::UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, const void* const PtrData,
+	UINT RowPitch)
+{
+	if (!PtrTexture || !PtrData) return;
+
+	D3D11_TEXTURE2D_DESC Desc{};
+	PtrTexture->GetDesc(&Desc);
+	UINT Mip{ Subresource % max(Desc.MipLevels, 1u) };
+	if (PtrBox)
+	{
+		Desc.Width = PtrBox->right - PtrBox->left;
+		Desc.Height = PtrBox->bottom - PtrBox->top;
+		Mip = 0;
+	}
+	UINT TightRowPitch{};
+	UINT RowCount{};
+	GetSubresourceByteSize(Desc, Mip, TightRowPitch, RowCount);
+
+	// @important: the last row is only read up to its last texel, as UpdateSubresource() does
+	const size_t KDataByteSize{ static_cast<size_t>(RowPitch) * (RowCount - 1) + TightRowPitch };
+	uint8_t* const PtrRecorded{ static_cast<uint8_t*>(AllocateData(sizeof(STextureRegion) + KDataByteSize)) };
+	STextureRegion Region{};
+	if (PtrBox) Region.Box = *PtrBox;
+	Region.bHasBox = (PtrBox != nullptr);
+	memcpy(PtrRecorded, &Region, sizeof(Region));
+	memcpy(PtrRecorded + sizeof(Region), PtrData, KDataByteSize);
+	Record(ECommandType::UpdateTexture, EShaderType::PixelShader, 0, PtrTexture, PtrRecorded, Subresource, RowPitch);
+}
+
+void CCommandBuffer::CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY,
+	ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox)
+{
+	STextureRegion Region{};
+	Region.PtrSrcTexture = PtrSrcTexture;
+	if (PtrSrcBox) Region.Box = *PtrSrcBox;
+	Region.bHasBox = (PtrSrcBox != nullptr);
+	Record(ECommandType::CopyTextureRegion, EShaderType::PixelShader, 0, PtrDstTexture, CopyData(&Region, sizeof(Region)), DstSubresource,
+		DstX, DstY, SrcSubresource);
+}
+
+void CCommandBuffer::GenerateMips(ID3D11ShaderResourceView* const PtrView)
+{
+	Record(ECommandType::GenerateMips, EShaderType::PixelShader, 0, PtrView);
+}
+
+void CCommandBuffer::SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD)
+{
+	UINT MinLODBits{};
+	memcpy(&MinLODBits, &MinLOD, sizeof(MinLODBits));
+	Record(ECommandType::SetResourceMinLOD, EShaderType::PixelShader, 0, PtrResource, nullptr, MinLODBits);
+}
+
+void CCommandBuffer::SignalFence(uint64_t FenceValue)
+{
+	Record(ECommandType::SignalFence, EShaderType::VertexShader, 0, nullptr, nullptr, static_cast<UINT>(FenceValue),
+		static_cast<UINT>(FenceValue >> 32));
+}
+
+void CCommandBuffer::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+	++m_DrawCallCount;
+	Record(ECommandType::Draw, EShaderType::VertexShader, 0, nullptr, nullptr, VertexCount, StartVertexLocation);
+}
+
+void CCommandBuffer::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+	++m_DrawCallCount;
+	Record(ECommandType::DrawIndexed, EShaderType::VertexShader, 0, nullptr, nullptr, IndexCount, StartIndexLocation,
+		static_cast<UINT>(BaseVertexLocation));
+}
+
+void CCommandBuffer::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+	UINT StartInstanceLocation)
+{
+	++m_DrawCallCount;
+	Record(ECommandType::DrawIndexedInstanced, EShaderType::VertexShader, 0, nullptr, nullptr, IndexCountPerInstance, InstanceCount,
+		StartIndexLocation, static_cast<UINT>(BaseVertexLocation), StartInstanceLocation);
+}
+
+void CCommandBuffer::Replay(CRenderDevice& Device) const
+{
+	assert(m_vPendingMaps.empty());
+
+	for (const SCommand& Command : m_vCommands)
+	{
+		const UINT* const Arguments{ Command.Arguments };
+		switch (Command.eType)
+		{
+		case ECommandType::SetVertexShader:
+			Device.SetVertexShader(ToObject<ID3D11VertexShader>(Command.PtrObject));
+			break;
+		case ECommandType::SetHullShader:
+			Device.SetHullShader(ToObject<ID3D11HullShader>(Command.PtrObject));
+			break;
+		case ECommandType::SetDomainShader:
+			Device.SetDomainShader(ToObject<ID3D11DomainShader>(Command.PtrObject));
+			break;
+		case ECommandType::SetGeometryShader:
+			Device.SetGeometryShader(ToObject<ID3D11GeometryShader>(Command.PtrObject));
+			break;
+		case ECommandType::SetPixelShader:
+			Device.SetPixelShader(ToObject<ID3D11PixelShader>(Command.PtrObject));
+			break;
+		case ECommandType::SetInputLayout:
+			Device.SetInputLayout(ToObject<ID3D11InputLayout>(Command.PtrObject));
+			break;
+		case ECommandType::SetConstantBuffer:
+			Device.SetConstantBuffer(Command.eShaderType, Command.Slot, ToObject<ID3D11Buffer>(Command.PtrObject));
+			break;
+		case ECommandType::SetShaderResource:
+			Device.SetShaderResource(Command.eShaderType, Command.Slot, ToObject<ID3D11ShaderResourceView>(Command.PtrObject));
+			break;
+		case ECommandType::SetSamplerState:
+			Device.SetSamplerState(Command.eShaderType, Command.Slot, ToObject<ID3D11SamplerState>(Command.PtrObject));
+			break;
+		case ECommandType::SetConstantBufferRange:
+			Device.SetConstantBufferRange(Command.eShaderType, Command.Slot, ToObject<ID3D11Buffer>(Command.PtrObject), Arguments[0], Arguments[1]);
+			break;
+		case ECommandType::SetRasterizerState:
+			Device.SetRasterizerState(ToObject<ID3D11RasterizerState>(Command.PtrObject));
+			break;
+		case ECommandType::SetDepthStencilState:
+			Device.SetDepthStencilState(ToObject<ID3D11DepthStencilState>(Command.PtrObject), Arguments[0]);
+			break;
+		case ECommandType::SetBlendState:
+			Device.SetBlendState(ToObject<ID3D11BlendState>(Command.PtrObject));
+			break;
+		case ECommandType::SetViewport:
+			Device.SetViewport(*static_cast<const D3D11_VIEWPORT*>(Command.PtrSecondary));
+			break;
+		case ECommandType::SetRenderTarget:
+			Device.SetRenderTarget(ToObject<ID3D11RenderTargetView>(Command.PtrObject), ToObject<ID3D11DepthStencilView>(Command.PtrSecondary));
+			break;
+		case ECommandType::ClearRenderTarget:
+			Device.ClearRenderTarget(ToObject<ID3D11RenderTargetView>(Command.PtrObject), static_cast<const FLOAT*>(Command.PtrSecondary));
+			break;
+		case ECommandType::ClearDepthStencil:
+		{
+			FLOAT Depth{};
+			memcpy(&Depth, &Arguments[1], sizeof(Depth));
+			Device.ClearDepthStencil(ToObject<ID3D11DepthStencilView>(Command.PtrObject), Arguments[0], Depth, static_cast<UINT8>(Arguments[2]));
+			break;
+		}
+		case ECommandType::SetPrimitiveTopology:
+			Device.SetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(Arguments[0]));
+			break;
+		case ECommandType::SetVertexBuffer:
+			Device.SetVertexBuffer(Command.Slot, ToObject<ID3D11Buffer>(Command.PtrObject), Arguments[0], Arguments[1]);
+			break;
+		case ECommandType::SetIndexBuffer:
+			Device.SetIndexBuffer(ToObject<ID3D11Buffer>(Command.PtrObject), static_cast<DXGI_FORMAT>(Arguments[0]), Arguments[1]);
+			break;
+		case ECommandType::WriteBuffer:
+		{
+			ID3D11Buffer* const PtrBuffer{ ToObject<ID3D11Buffer>(Command.PtrObject) };
+			if (void* const PtrMappedData{ Device.Map(PtrBuffer, D3D11_MAP_WRITE_DISCARD, Arguments[0]) })
+			{
+				memcpy(PtrMappedData, Command.PtrSecondary, Arguments[0]);
+				Device.Unmap(PtrBuffer);
+			}
+			break;
+		}
+		case ECommandType::UpdateBuffer:
+			Device.UpdateBuffer(ToObject<ID3D11Buffer>(Command.PtrObject), Command.PtrSecondary, Arguments[0]);
+			break;
+		case ECommandType::CopyBufferRegion:
+			Device.CopyBufferRegion(ToObject<ID3D11Buffer>(Command.PtrObject), Arguments[0], ToObject<ID3D11Buffer>(Command.PtrSecondary), Arguments[1], Arguments[2]);
+			break;
+		case ECommandType::UpdateTexture:
+		{
+			const STextureRegion* const PtrRegion{ static_cast<const STextureRegion*>(Command.PtrSecondary) };
+			Device.UpdateTexture(ToObject<ID3D11Texture2D>(Command.PtrObject), Arguments[0], (PtrRegion->bHasBox) ? &PtrRegion->Box : nullptr,
+				PtrRegion + 1, Arguments[1]);
+			break;
+		}
+		case ECommandType::CopyTextureRegion:
+		{
+			const STextureRegion* const PtrRegion{ static_cast<const STextureRegion*>(Command.PtrSecondary) };
+			Device.CopyTextureRegion(ToObject<ID3D11Texture2D>(Command.PtrObject), Arguments[0], Arguments[1], Arguments[2], 
+				PtrRegion->PtrSrcTexture, Arguments[3], (PtrRegion->bHasBox) ? &PtrRegion->Box : nullptr);
+			break;
+		}
+		case ECommandType::GenerateMips:
+			Device.GenerateMips(ToObject<ID3D11ShaderResourceView>(Command.PtrObject));
+			break;
+		case ECommandType::SetResourceMinLOD:
+		{
+			FLOAT MinLOD{};
+			memcpy(&MinLOD, &Arguments[0], sizeof(MinLOD));
+			Device.SetResourceMinLOD(ToObject<ID3D11Resource>(Command.PtrObject), MinLOD);
+			break;
+		}
+		case ECommandType::SignalFence:
+			Device.SignalFence(static_cast<uint64_t>(Arguments[0]) | (static_cast<uint64_t>(Arguments[1]) << 32));
+			break;
+		case ECommandType::Draw:
+			Device.Draw(Arguments[0], Arguments[1]);
+			break;
+		case ECommandType::DrawIndexed:
+			Device.DrawIndexed(Arguments[0], Arguments[1], static_cast<INT>(Arguments[2]));
+			break;
+		case ECommandType::DrawIndexedInstanced:
+			Device.DrawIndexedInstanced(Arguments[0], Arguments[1], Arguments[2], static_cast<INT>(Arguments[3]), Arguments[4]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void CCommandBuffer::Reset()
+{
+	assert(m_vPendingMaps.empty());
+
+	m_vCommands.clear();
+	m_DrawCallCount = 0;
+	m_CurrentDataBlock = 0;
+	m_DataBlockOffset = 0;
+	m_DataByteSize = 0;
+	m_vPendingMaps.clear();
+}
+
+void CCommandBuffer::Record(ECommandType eType, EShaderType eShaderType, UINT Slot, const void* const PtrObject, const void* const PtrSecondary,
+	UINT Argument0, UINT Argument1, UINT Argument2, UINT Argument3, UINT Argument4)
+{
+	SCommand Command{};
+	Command.eType = eType;
+	Command.eShaderType = eShaderType;
+	Command.Slot = Slot;
+	Command.Arguments[0] = Argument0;
+	Command.Arguments[1] = Argument1;
+	Command.Arguments[2] = Argument2;
+	Command.Arguments[3] = Argument3;
+	Command.Arguments[4] = Argument4;
+	Command.PtrObject = PtrObject;
+	Command.PtrSecondary = PtrSecondary;
+	m_vCommands.emplace_back(Command);
+}
+
+void* CCommandBuffer::AllocateData(size_t ByteSize)
+{
+	const size_t KAlignedByteSize{ (ByteSize + KDataAlignment - 1) / KDataAlignment * KDataAlignment };
+
+	// @important: blocks are never reallocated, so the memory handed out stays valid while recording
+	while (m_CurrentDataBlock < m_vDataBlocks.size() && m_DataBlockOffset + KAlignedByteSize > m_vDataBlocks[m_CurrentDataBlock].ByteSize)
+	{
+		++m_CurrentDataBlock;
+		m_DataBlockOffset = 0;
+	}
+	if (m_CurrentDataBlock == m_vDataBlocks.size())
+	{
+		SDataBlock Block{};
+		Block.ByteSize = max(KDataBlockByteSize, KAlignedByteSize);
+		Block.Data = make_unique<uint8_t[]>(Block.ByteSize);
+		m_vDataBlocks.emplace_back(std::move(Block));
+	}
+
+	void* const PtrData{ m_vDataBlocks[m_CurrentDataBlock].Data.get() + m_DataBlockOffset };
+	m_DataBlockOffset += KAlignedByteSize;
+	m_DataByteSize += KAlignedByteSize;
+	return PtrData;
+}
+
+const void* CCommandBuffer::CopyData(const void* const PtrData, size_t ByteSize)
+{
+	if (!PtrData || ByteSize == 0) return nullptr;
+
+	void* const PtrCopy{ AllocateData(ByteSize) };
+	memcpy(PtrCopy, PtrData, ByteSize);
+	return PtrCopy;
+}
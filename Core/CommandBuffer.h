@@ -0,0 +1,201 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+// Records render device calls as POD commands into a linear buffer, so that they can be recorded on any thread and replayed later
+// on any render device (the immediate context, a deferred context or CRenderDeviceNull)
+// @important: D3D11 objects are recorded as plain pointers (no references are added), so they must outlive the replay
+class CCommandBuffer final : public CRenderDevice
+{
+public:
+	enum class ECommandType : uint8_t
+	{
+		SetVertexShader,
+		SetHullShader,
+		SetDomainShader,
+		SetGeometryShader,
+		SetPixelShader,
+		SetInputLayout,
+		SetConstantBuffer,
+		SetShaderResource,
+		SetSamplerState,
+		SetConstantBufferRange,
+		SetRasterizerState,
+		SetDepthStencilState,
+		SetBlendState,
+		SetViewport,
+		SetRenderTarget,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		SetPrimitiveTopology,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		WriteBuffer, // Map(WRITE_DISCARD) + Unmap
+		UpdateBuffer,
+		CopyBufferRegion,
+		UpdateTexture,
+		CopyTextureRegion,
+		GenerateMips,
+		SetResourceMinLOD,
+		SignalFence,
+		Draw,
+		DrawIndexed,
+		DrawIndexedInstanced
+	};
+
+	struct SCommand
+	{
+		ECommandType	eType{};
+		EShaderType		eShaderType{};
+		UINT			Slot{};
+		UINT			Arguments[5]{};
+		const void*		PtrObject{};
+		const void*		PtrSecondary{}; // Depth-stencil view, copy source, or data recorded along (viewport, clear color, buffer/texture contents)
+	};
+
+public:
+	CCommandBuffer() {}
+	~CCommandBuffer() {}
+
+public:
+	// Objects can't be created while recording (return E_FAIL): create them through the device the commands are replayed on
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData, 
+		ID3D11Buffer** const PtrOutBuffer) override { return E_FAIL; }
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+		ID3D11Texture2D** const PtrOutTexture) override { return E_FAIL; }
+	HRESULT CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+		ID3D11ShaderResourceView** const PtrOutView) override { return E_FAIL; }
+	HRESULT CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+		ID3D11RenderTargetView** const PtrOutView) override { return E_FAIL; }
+	HRESULT CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+		ID3D11DepthStencilView** const PtrOutView) override { return E_FAIL; }
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState) override { return E_FAIL; }
+	HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState) override { return E_FAIL; }
+	HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState) override { return E_FAIL; }
+	HRESULT CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState) override { return E_FAIL; }
+	HRESULT CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader) override { return E_FAIL; }
+	HRESULT CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader) override { return E_FAIL; }
+	HRESULT CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader) override { return E_FAIL; }
+	HRESULT CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader) override 
+	{ 
+		return E_FAIL; 
+	}
+	HRESULT CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader) override { return E_FAIL; }
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount, const void* const PtrBytecode,
+		size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout) override { return E_FAIL; }
+	HRESULT CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override { return E_FAIL; }
+	HRESULT CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override { return E_FAIL; }
+
+public:
+	void SetVertexShader(ID3D11VertexShader* const PtrShader) override;
+	void SetHullShader(ID3D11HullShader* const PtrShader) override;
+	void SetDomainShader(ID3D11DomainShader* const PtrShader) override;
+	void SetGeometryShader(ID3D11GeometryShader* const PtrShader) override;
+	void SetPixelShader(ID3D11PixelShader* const PtrShader) override;
+	void SetInputLayout(ID3D11InputLayout* const PtrInputLayout) override;
+	void SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer) override;
+	void SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView) override;
+	void SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState) override;
+
+	// Ranges can be bound, but a transient buffer can't be suballocated while recording (see Map())
+	void SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant, UINT ConstantCount) override;
+	bool SupportsConstantBufferRanges() const override { return false; }
+
+	void SetRasterizerState(ID3D11RasterizerState* const PtrState) override;
+	void SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef) override;
+	void SetBlendState(ID3D11BlendState* const PtrState) override;
+	void SetViewport(const D3D11_VIEWPORT& Viewport) override;
+	void SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView) override;
+
+	void ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4]) override;
+	void ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) override;
+
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology) override;
+	void SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset) override;
+	void SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset) override;
+
+	// Returns memory of the command buffer, whose contents are written to the buffer on replay (recorded on Unmap())
+	// @important: only WRITE_DISCARD is supported, because the recorded contents replace the whole mapped range
+	void* Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize) override;
+	void Unmap(ID3D11Buffer* const PtrBuffer) override;
+	void UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize) override;
+	void CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset, UINT ByteSize) override;
+
+	// Textures can't be mapped while recording (returns false): update them with UpdateTexture() instead
+	bool MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped) override;
+	void UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource) override;
+	// The texels are copied (PtrTexture's GetDesc() gives the size of the subresource if there's no box)
+	void UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, const void* const PtrData,
+		UINT RowPitch) override;
+	void CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY, 
+		ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox) override;
+	void GenerateMips(ID3D11ShaderResourceView* const PtrView) override;
+	void SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD) override;
+
+	// Fences are only passed once the commands are replayed, so no fence is ever completed while recording
+	void SignalFence(uint64_t FenceValue) override;
+	uint64_t GetCompletedFence() override { return 0; }
+
+	void Draw(UINT VertexCount, UINT StartVertexLocation) override;
+	void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) override;
+	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+		UINT StartInstanceLocation) override;
+
+public:
+	// Issues the recorded commands in order
+	void Replay(CRenderDevice& Device) const;
+
+	// Clears the commands but keeps the memory, so that recording the next frame doesn't allocate
+	void Reset();
+
+	const vector<SCommand>& GetCommands() const { return m_vCommands; }
+	size_t GetDrawCallCount() const { return m_DrawCallCount; }
+	size_t GetDataByteSize() const { return m_DataByteSize; }
+
+private:
+	void Record(ECommandType eType, EShaderType eShaderType, UINT Slot, const void* const PtrObject, const void* const PtrSecondary = nullptr,
+		UINT Argument0 = 0, UINT Argument1 = 0, UINT Argument2 = 0, UINT Argument3 = 0, UINT Argument4 = 0);
+
+	// The memory stays valid until Reset()
+	void* AllocateData(size_t ByteSize);
+	const void* CopyData(const void* const PtrData, size_t ByteSize);
+
+public:
+	static constexpr size_t KDataBlockByteSize{ 64 * 1024 }; // Larger allocations get a block of their own
+	static constexpr size_t KDataAlignment{ 16 };
+
+private:
+	struct SDataBlock
+	{
+		unique_ptr<uint8_t[]>	Data{};
+		size_t					ByteSize{};
+	};
+
+	// Recorded along UpdateTexture (followed by the texels) and CopyTextureRegion
+	struct STextureRegion
+	{
+		ID3D11Texture2D*	PtrSrcTexture{};
+		D3D11_BOX			Box{};
+		bool				bHasBox{};
+	};
+
+	struct SPendingMap
+	{
+		ID3D11Buffer*	PtrBuffer{};
+		void*			PtrData{};
+		size_t			ByteSize{};
+	};
+
+private:
+	vector<SCommand>		m_vCommands{};
+	size_t					m_DrawCallCount{};
+
+private:
+	vector<SDataBlock>		m_vDataBlocks{};
+	size_t					m_CurrentDataBlock{};
+	size_t					m_DataBlockOffset{};
+	size_t					m_DataByteSize{};
+	vector<SPendingMap>		m_vPendingMaps{};
+};
@@ -0,0 +1,44 @@
+#include "CommandRecorder.h"
+
+void CCommandRecorder::Replay(CRenderDevice& Device) const
+{
+	Replay(Device, 0, m_JobCount);
+}
+
+void CCommandRecorder::Replay(CRenderDevice& Device, size_t FirstJob, size_t JobCount) const
+{
+	assert(FirstJob + JobCount <= m_JobCount);
+
+	for (size_t iJob = FirstJob; iJob < FirstJob + JobCount; ++iJob)
+	{
+		m_vCommandBuffers[iJob]->Replay(Device);
+	}
+}
+
+void CCommandRecorder::BeginRecording(size_t JobCount)
+{
+	while (m_vCommandBuffers.size() < JobCount)
+	{
+		m_vCommandBuffers.emplace_back(make_unique<CCommandBuffer>());
+	}
+	for (size_t iJob = 0; iJob < JobCount; ++iJob)
+	{
+		m_vCommandBuffers[iJob]->Reset();
+	}
+	m_JobCount = JobCount;
+}
+
+void CCommandRecorder::EndRecording(uint32_t ThreadCount, double ElapsedMilliseconds)
+{
+	m_Stats = SStats();
+	m_Stats.JobCount = m_JobCount;
+	m_Stats.ThreadCount = ThreadCount;
+	m_Stats.ElapsedMilliseconds = ElapsedMilliseconds;
+	for (size_t iJob = 0; iJob < m_JobCount; ++iJob)
+	{
+		const CCommandBuffer& CommandBuffer{ *m_vCommandBuffers[iJob] };
+		m_Stats.CommandCount += CommandBuffer.GetCommands().size();
+		m_Stats.DrawCallCount += CommandBuffer.GetDrawCallCount();
+		m_Stats.DataByteSize += CommandBuffer.GetDataByteSize();
+	}
+}
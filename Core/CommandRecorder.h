@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// Records jobs (terrain, grass tiles, object batches, particles...) in parallel, each into its own command buffer
+// Buffers are merged in job order, so the replayed commands never depend on the thread count or on which thread ran which job
+// Each job starts with an unknown device state: it must set every state it depends on (e.g. through its own CStateTracker)
+// @important: instead of Replay(), each command buffer can be replayed on its own deferred context (CRenderDeviceD3D11) and the command
+// lists executed in job order
+class CCommandRecorder final
+{
+public:
+	struct SStats
+	{
+		size_t		JobCount{};
+		uint32_t	ThreadCount{};
+		size_t		CommandCount{};
+		size_t		DrawCallCount{};
+		size_t		DataByteSize{};
+		double		ElapsedMilliseconds{}; // Of Record(), including starting and joining the threads
+	};
+
+public:
+	CCommandRecorder() {}
+	~CCommandRecorder() {}
+
+public:
+	// Calls Job(JobIndex, CommandBuffer) for every job in [0, JobCount); ThreadCount 0: std::thread::hardware_concurrency()
+	// Jobs must only share read-only data
+	template <typename TJob>
+	void Record(size_t JobCount, const TJob& Job, uint32_t ThreadCount = 0);
+
+	// Replays every command buffer in job order
+	void Replay(CRenderDevice& Device) const;
+	// Replays the command buffers of jobs [FirstJob, FirstJob + JobCount) in job order (to interleave them with other draws)
+	void Replay(CRenderDevice& Device, size_t FirstJob, size_t JobCount) const;
+
+	size_t GetCommandBufferCount() const { return m_JobCount; }
+	const CCommandBuffer& GetCommandBuffer(size_t JobIndex) const { return *m_vCommandBuffers[JobIndex]; }
+	const SStats& GetStats() const { return m_Stats; }
+
+private:
+	// Resets the command buffers (their memory is reused)
+	void BeginRecording(size_t JobCount);
+	void EndRecording(uint32_t ThreadCount, double ElapsedMilliseconds);
+
+private:
+	vector<unique_ptr<CCommandBuffer>>	m_vCommandBuffers{};
+	size_t								m_JobCount{};
+	SStats								m_Stats{};
+};
+
+template <typename TJob>
+void CCommandRecorder::Record(size_t JobCount, const TJob& Job, uint32_t ThreadCount)
+{
+	const std::chrono::steady_clock::time_point KStart{ std::chrono::steady_clock::now() };
+	BeginRecording(JobCount);
+
+	// Jobs are taken in any order, but each one only writes to its own command buffer
+	std::atomic<size_t> NextJob{};
+	auto RecordJobs{ [&]()
+	{
+		for (size_t iJob = NextJob++; iJob < JobCount; iJob = NextJob++)
+		{
+			Job(iJob, *m_vCommandBuffers[iJob]);
+		}
+	} };
+
+	if (ThreadCount == 0) ThreadCount = std::thread::hardware_concurrency();
+	ThreadCount = static_cast<uint32_t>(min(static_cast<size_t>(max(ThreadCount, (uint32_t)1)), max(JobCount, (size_t)1)));
+	vector<std::thread> vThreads{};
+	for (uint32_t iThread = 1; iThread < ThreadCount; ++iThread)
+	{
+		vThreads.emplace_back(RecordJobs);
+	}
+	RecordJobs();
+
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+
+	EndRecording(ThreadCount, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - KStart).count());
+}
@@ -0,0 +1,124 @@
+#include "ConstantBufferUploader.h"
+
+void CConstantBufferUploader::SetTransientBuffer(ID3D11Buffer* const PtrBuffer, size_t ByteSize)
+{
+	assert(m_PtrRenderDevice->SupportsConstantBufferRanges());
+
+	m_PtrTransientBuffer = PtrBuffer;
+	m_TransientByteSize = ByteSize;
+	m_TransientOffset = 0;
+	++m_TransientGeneration;
+	m_bShouldDiscardTransient = true;
+}
+
+bool CConstantBufferUploader::Upload(ID3D11Buffer* const PtrBuffer, const void* const PtrData, size_t ByteSize, SConstantBufferShadow& Shadow)
+{
+	if (!HasChanged(PtrData, ByteSize, Shadow))
+	{
+		++m_Stats.SkippedUploadCount;
+		return false;
+	}
+
+	void* const PtrMappedData{ m_PtrRenderDevice->Map(PtrBuffer, D3D11_MAP_WRITE_DISCARD, ByteSize) };
+	if (!PtrMappedData) return false;
+
+	memcpy(PtrMappedData, PtrData, ByteSize);
+	m_PtrRenderDevice->Unmap(PtrBuffer);
+
+	UpdateShadow(PtrData, ByteSize, Shadow);
+	++m_Stats.MapCount;
+	m_Stats.UploadedByteCount += ByteSize;
+	return true;
+}
+
+void CConstantBufferUploader::UploadTransient(EShaderType eShaderType, UINT Slot, const void* const PtrData, size_t ByteSize,
+	STransientConstantBuffer& Transient)
+{
+	if (Transient.Generation == m_TransientGeneration && !HasChanged(PtrData, ByteSize, Transient.Shadow))
+	{
+		++m_Stats.SkippedUploadCount;
+	}
+	else
+	{
+		if (!AllocateTransient(PtrData, ByteSize, Transient)) return;
+	}
+
+	m_PtrStateTracker->SetConstantBufferRange(eShaderType, Slot, m_PtrTransientBuffer, Transient.FirstConstant, Transient.ConstantCount);
+}
+
+void CConstantBufferUploader::UseTransient(EShaderType eShaderType, UINT Slot, STransientConstantBuffer& Transient)
+{
+	// Nothing has been uploaded yet
+	if (!Transient.Shadow.bIsUploaded) return;
+
+	if (Transient.Generation != m_TransientGeneration)
+	{
+		if (!AllocateTransient(Transient.Shadow.vData.data(), Transient.Shadow.vData.size(), Transient)) return;
+	}
+
+	m_PtrStateTracker->SetConstantBufferRange(eShaderType, Slot, m_PtrTransientBuffer, Transient.FirstConstant, Transient.ConstantCount);
+}
+
+void CConstantBufferUploader::BeginFrame()
+{
+	m_Stats = SStats();
+
+	// @important: ranges of the previous frame must not be reused after the next WRITE_DISCARD
+	++m_TransientGeneration;
+	m_bShouldDiscardTransient = true;
+}
+
+bool CConstantBufferUploader::HasChanged(const void* const PtrData, size_t ByteSize, const SConstantBufferShadow& Shadow) const
+{
+	if (!Shadow.bIsUploaded || Shadow.vData.size() != ByteSize) return true;
+	return memcmp(Shadow.vData.data(), PtrData, ByteSize) != 0;
+}
+
+void CConstantBufferUploader::UpdateShadow(const void* const PtrData, size_t ByteSize, SConstantBufferShadow& Shadow) const
+{
+	// @important: PtrData may point into Shadow.vData (re-uploads from the shadow)
+	if (Shadow.vData.data() != PtrData)
+	{
+		Shadow.vData.resize(ByteSize);
+		memcpy(Shadow.vData.data(), PtrData, ByteSize);
+	}
+	Shadow.bIsUploaded = true;
+}
+
+bool CConstantBufferUploader::AllocateTransient(const void* const PtrData, size_t ByteSize, STransientConstantBuffer& Transient)
+{
+	assert(m_PtrTransientBuffer);
+
+	const size_t KAlignmentByteSize{ KRangeAlignment * KConstantByteSize };
+	const size_t KAlignedByteSize{ (ByteSize + KAlignmentByteSize - 1) / KAlignmentByteSize * KAlignmentByteSize };
+	if (KAlignedByteSize > m_TransientByteSize) return false;
+
+	D3D11_MAP eMapType{ D3D11_MAP_WRITE_NO_OVERWRITE };
+	if (m_bShouldDiscardTransient || m_TransientOffset + KAlignedByteSize > m_TransientByteSize)
+	{
+		// @important: a full transient buffer is renamed by the driver, so the ranges in flight stay intact
+		if (!m_bShouldDiscardTransient) ++m_TransientGeneration;
+
+		eMapType = D3D11_MAP_WRITE_DISCARD;
+		m_TransientOffset = 0;
+		m_bShouldDiscardTransient = false;
+		++m_Stats.TransientDiscardCount;
+	}
+
+	uint8_t* const PtrMappedData{ static_cast<uint8_t*>(m_PtrRenderDevice->Map(m_PtrTransientBuffer, eMapType, m_TransientOffset + KAlignedByteSize)) };
+	if (!PtrMappedData) return false;
+
+	memcpy(PtrMappedData + m_TransientOffset, PtrData, ByteSize);
+	m_PtrRenderDevice->Unmap(m_PtrTransientBuffer);
+
+	UpdateShadow(PtrData, ByteSize, Transient.Shadow);
+	Transient.FirstConstant = static_cast<UINT>(m_TransientOffset / KConstantByteSize);
+	Transient.ConstantCount = static_cast<UINT>(KAlignedByteSize / KConstantByteSize);
+	Transient.Generation = m_TransientGeneration;
+	m_TransientOffset += KAlignedByteSize;
+
+	++m_Stats.MapCount;
+	++m_Stats.TransientAllocationCount;
+	m_Stats.UploadedByteCount += ByteSize;
+	return true;
+}
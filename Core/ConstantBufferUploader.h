@@ -0,0 +1,85 @@
+#pragma once
+
+#include "StateTracker.h"
+
+// Contents of the last upload of a constant buffer (uploads are skipped while the contents don't change)
+struct SConstantBufferShadow
+{
+	vector<uint8_t>	vData{};
+	bool			bIsUploaded{};
+};
+
+// Last range of the transient buffer that a constant buffer has been uploaded to
+struct STransientConstantBuffer
+{
+	SConstantBufferShadow	Shadow{};
+	UINT					FirstConstant{};
+	UINT					ConstantCount{};
+	uint64_t				Generation{ UINT64_MAX }; // The range is only valid while the transient buffer hasn't been discarded since
+};
+
+// Uploads constant buffers only when their contents change, and suballocates per-draw constant buffers from one transient buffer
+// (WRITE_DISCARD once per frame, then NO_OVERWRITE). Ranges are bound through the state tracker, so its cache stays valid.
+class CConstantBufferUploader final
+{
+public:
+	struct SStats
+	{
+		size_t	MapCount{};
+		size_t	UploadedByteCount{};
+		size_t	SkippedUploadCount{}; // Unchanged contents
+		size_t	TransientAllocationCount{};
+		size_t	TransientDiscardCount{}; // Once per frame, and whenever the transient buffer is full
+	};
+
+public:
+	CConstantBufferUploader(CRenderDevice* const PtrRenderDevice, CStateTracker* const PtrStateTracker) :
+		m_PtrRenderDevice{ PtrRenderDevice }, m_PtrStateTracker{ PtrStateTracker }
+	{
+		assert(m_PtrRenderDevice);
+		assert(m_PtrStateTracker);
+	}
+	~CConstantBufferUploader() {}
+
+public:
+	// PtrBuffer must be a dynamic constant buffer, and the render device must support constant buffer ranges
+	void SetTransientBuffer(ID3D11Buffer* const PtrBuffer, size_t ByteSize);
+	bool IsTransientBufferAvailable() const { return m_PtrTransientBuffer != nullptr; }
+
+	// Returns false if the upload has been skipped
+	bool Upload(ID3D11Buffer* const PtrBuffer, const void* const PtrData, size_t ByteSize, SConstantBufferShadow& Shadow);
+
+	// Uploads to a new range of the transient buffer (unless the contents and the last range are still valid) and binds it
+	void UploadTransient(EShaderType eShaderType, UINT Slot, const void* const PtrData, size_t ByteSize, STransientConstantBuffer& Transient);
+
+	// Binds the last range (re-uploaded from the shadow if the transient buffer has been discarded since)
+	void UseTransient(EShaderType eShaderType, UINT Slot, STransientConstantBuffer& Transient);
+
+	// Resets the stats, and the transient buffer is discarded on its next allocation
+	void BeginFrame();
+
+	const SStats& GetStats() const { return m_Stats; }
+	size_t GetTransientOffset() const { return m_TransientOffset; }
+	CStateTracker& GetStateTracker() { return *m_PtrStateTracker; }
+
+private:
+	bool HasChanged(const void* const PtrData, size_t ByteSize, const SConstantBufferShadow& Shadow) const;
+	void UpdateShadow(const void* const PtrData, size_t ByteSize, SConstantBufferShadow& Shadow) const;
+	bool AllocateTransient(const void* const PtrData, size_t ByteSize, STransientConstantBuffer& Transient);
+
+public:
+	static constexpr size_t KConstantByteSize{ 16 };
+	static constexpr size_t KRangeAlignment{ 16 }; // In constants (256 bytes)
+
+private:
+	CRenderDevice* const	m_PtrRenderDevice{};
+	CStateTracker* const	m_PtrStateTracker{};
+	SStats					m_Stats{};
+
+private:
+	ID3D11Buffer*			m_PtrTransientBuffer{};
+	size_t					m_TransientByteSize{};
+	size_t					m_TransientOffset{};
+	uint64_t				m_TransientGeneration{};
+	bool					m_bShouldDiscardTransient{ true };
+};
@@ -39,6 +39,24 @@ static constexpr D3D11_INPUT_ELEMENT_DESC KParticleInputElementDescs[]
 	{ "SCALING"	, 0, DXGI_FORMAT_R32G32_FLOAT		, 0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
+// Bound to references (XMVECTOR parameters), so they need definitions before C++17
+constexpr XMVECTOR CGame::KColorWhite;
+constexpr XMVECTOR CGame::KSkySphereColorUp;
+constexpr XMVECTOR CGame::KSkySphereColorBottom;
+
+// FNV-1a
+static uint64_t HashRenderQueueKey(uint64_t Hash, const void* const PtrData, size_t ByteSize)
+{
+	const uint8_t* const PtrBytes{ static_cast<const uint8_t*>(PtrData) };
+	for (size_t iByte = 0; iByte < ByteSize; ++iByte)
+	{
+		Hash ^= PtrBytes[iByte];
+		Hash *= 0x100000001B3;
+	}
+	return Hash;
+}
+
+#if defined(_WIN32)
 void CGame::CreateWin32(WNDPROC const WndProc, LPCTSTR const WindowName, const wstring& FontFileName, bool bWindowed)
 {
 	CreateWin32Window(WndProc, WindowName);
@@ -47,10 +65,25 @@ void CGame::CreateWin32(WNDPROC const WndProc, LPCTSTR const WindowName, const w
 
 	GetCurrentDirectoryA(MAX_PATH, m_WorkingDirectory);
 }
+#endif
+
+void CGame::CreateHeadless(unique_ptr<CRenderDevice> RenderDevice, unique_ptr<CShaderCompiler> ShaderCompiler, const string& ShaderCacheDirectory)
+{
+	assert(RenderDevice);
+	assert(ShaderCompiler);
+
+	m_RenderDevice = std::move(RenderDevice);
+	m_ShaderCompiler = std::move(ShaderCompiler);
+	InitializeRendering(ShaderCacheDirectory);
+
+	GetCurrentDirectoryA(MAX_PATH, m_WorkingDirectory);
+}
 
 void CGame::Destroy()
 {
-	DestroyWindow(m_hWnd);
+#if defined(_WIN32)
+	if (m_hWnd) DestroyWindow(m_hWnd);
+#endif
 }
 
 void CGame::LoadScene(const string& FileName)
@@ -245,6 +278,9 @@ void CGame::LoadScene(const string& FileName)
 		{
 			const char* TerrainFileName{ xmlSceneChild->Attribute("FileName") };
 			if (TerrainFileName) LoadTerrain(TerrainFileName);
+
+			const char* TileDirectory{ xmlSceneChild->Attribute("TileDirectory") };
+			if (TileDirectory) SetTerrainTileDirectory(TileDirectory);
 		}
 
 		if (strcmp(ID, "Sky") == 0)
@@ -271,6 +307,8 @@ void CGame::SaveScene(const string& FileName)
 		{
 			m_Terrain->Save(m_Terrain->GetFileName());
 		}
+
+		if (m_Terrain->GetStreamer()) m_Terrain->GetStreamer()->SaveDirtyTiles();
 	}
 
 	tinyxml2::XMLDocument xmlDocument{};
@@ -405,6 +443,7 @@ void CGame::SaveScene(const string& FileName)
 			if (m_Terrain)
 			{
 				xmlTerrain->SetAttribute("FileName", m_Terrain->GetFileName().c_str());
+				if (!m_TerrainTileDirectory.empty()) xmlTerrain->SetAttribute("TileDirectory", m_TerrainTileDirectory.c_str());
 			}
 
 			xmlRoot->InsertEndChild(xmlTerrain);
@@ -429,6 +468,7 @@ void CGame::SaveScene(const string& FileName)
 
 void CGame::SetPerspective(float FOV, float NearZ, float FarZ)
 {
+	m_FOV = FOV;
 	m_NearZ = NearZ;
 	m_FarZ = FarZ;
 
@@ -477,11 +517,10 @@ void CGame::UpdateHSTessFactor(float TessFactor)
 	m_cbHSTessFactor.TessFactor = TessFactor;
 }
 
-void CGame::UpdateDSDisplacementData(bool bUseDisplacement)
+void CGame::UpdateDSTerrainDisplacement(bool bUseDisplacement)
 {
-	m_cbDSDisplacementData.bUseDisplacement = bUseDisplacement;
-
-	m_DSTerrain->UpdateAllConstantBuffers();
+	EDSTerrainFeature eFeatures{ (bUseDisplacement) ? EDSTerrainFeature::UseDisplacement : EDSTerrainFeature::None };
+	m_DSTerrain->SetPermutation(*m_StateTracker, static_cast<uint32_t>(eFeatures));
 }
 
 void CGame::UpdateGSSpace()
@@ -502,11 +541,10 @@ void CGame::UpdatePSBaseMaterial(const CMaterial& Material)
 	m_cbPSBaseMaterialData.SpecularExponent = Material.GetSpecularExponent();
 	m_cbPSBaseMaterialData.SpecularIntensity = Material.GetSpecularIntensity();
 
-	m_cbPSBaseMaterialData.bHasDiffuseTexture = Material.HasTexture(CMaterial::CTexture::EType::DiffuseTexture);
-	m_cbPSBaseMaterialData.bHasNormalTexture = Material.HasTexture(CMaterial::CTexture::EType::NormalTexture);
-	m_cbPSBaseMaterialData.bHasOpacityTexture = Material.HasTexture(CMaterial::CTexture::EType::OpacityTexture);
+	m_PSBase->UpdateConstantBuffer(1);
 
-	m_PSBase->UpdateConstantBuffer(2);
+	// Switches variants only if PSBase is bound (terrain and gizmos draw their meshes with their own pixel shaders)
+	m_PSBase->SetPermutation(*m_StateTracker, static_cast<uint32_t>(m_ePSBaseObjectFeatures | GetPSBaseMaterialFeatures(Material)));
 }
 
 void CGame::UpdatePSTerrainSpace(const XMMATRIX& Matrix)
@@ -514,14 +552,16 @@ void CGame::UpdatePSTerrainSpace(const XMMATRIX& Matrix)
 	m_cbPSTerrainSpaceData.Matrix = XMMatrixTranspose(Matrix);
 }
 
-void CGame::UpdatePSTerrainSelection(const CTerrain::SCBPSTerrainSelectionData& Selection)
+void CGame::UpdatePSTerrainMaskingAtlas(const XMFLOAT2& MaskingTextureSize, const XMFLOAT2& AtlasSize, uint32_t AtlasSlotCountX)
 {
-	m_cbPSTerrainSelectionData = Selection;
+	m_cbPSTerrainSpaceData.MaskingTextureSize = MaskingTextureSize;
+	m_cbPSTerrainSpaceData.MaskingAtlasSize = AtlasSize;
+	m_cbPSTerrainSpaceData.MaskingAtlasSlotCountX = AtlasSlotCountX;
 }
 
-void CGame::UpdatePSGrassFieldFlags(const CGrassField::SCBPSFlags& Data)
+void CGame::UpdatePSTerrainSelection(const CTerrain::SCBPSTerrainSelectionData& Selection)
 {
-	m_cbPSGrassFieldFlags = Data;
+	m_cbPSTerrainSelectionData = Selection;
 }
 
 void CGame::UpdatePSBase2DFlagOn(EFlagPSBase2D Flag)
@@ -550,6 +590,41 @@ void CGame::UpdatePSBase2DFlagOff(EFlagPSBase2D Flag)
 	m_PSBase2D->UpdateConstantBuffer(0);
 }
 
+void CGame::RecordVSSpace(CRenderDevice& Device, CStateTracker& StateTracker, const CShader* const VS, const XMMATRIX& World) const
+{
+	SCBVSSpaceData Data{ m_cbVSSpaceData };
+	Data.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
+	Data.World = XMMatrixTranspose(World);
+	VS->RecordConstantBuffer(Device, StateTracker, 0, &Data);
+}
+
+void CGame::RecordHSTessFactor(CRenderDevice& Device, CStateTracker& StateTracker, const CShader* const HS, float TessFactor) const
+{
+	SCBHSTessFactorData Data{ m_cbHSTessFactor };
+	Data.TessFactor = TessFactor;
+	HS->RecordConstantBuffer(Device, StateTracker, 1, &Data);
+}
+
+void CGame::RecordPSBaseMaterial(CRenderDevice& Device, CStateTracker& StateTracker, const CMaterial& Material) const
+{
+	SCBPSBaseMaterialData Data{ m_cbPSBaseMaterialData };
+	Data.MaterialAmbient = Material.GetAmbientColor();
+	Data.MaterialDiffuse = Material.GetDiffuseColor();
+	Data.MaterialSpecular = Material.GetSpecularColor();
+	Data.SpecularExponent = Material.GetSpecularExponent();
+	Data.SpecularIntensity = Material.GetSpecularIntensity();
+	m_PSBase->RecordConstantBuffer(Device, StateTracker, 1, &Data);
+}
+
+void CGame::RecordPSTerrainSpace(CRenderDevice& Device, CStateTracker& StateTracker, const XMMATRIX& Matrix,
+	const XMFLOAT2& MaskingTextureSize) const
+{
+	SCBPSTerrainSpaceData Data{ m_cbPSTerrainSpaceData };
+	Data.Matrix = XMMatrixTranspose(Matrix);
+	Data.MaskingTextureSize = MaskingTextureSize;
+	m_PSTerrain->RecordConstantBuffer(Device, StateTracker, 0, &Data);
+}
+
 void CGame::SetSky(const string& SkyDataFileName, float ScalingFactor)
 {
 	using namespace tinyxml2;
@@ -593,7 +668,7 @@ void CGame::SetSky(const string& SkyDataFileName, float ScalingFactor)
 
 	m_SkyMaterial.SetTextureFileName(CMaterial::CTexture::EType::DiffuseTexture, m_SkyData.TextureFileName);
 
-	m_Object3DSkySphere = make_unique<CObject3D>("SkySphere", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DSkySphere = make_unique<CObject3D>("SkySphere", m_RenderDevice.get(), this);
 	m_Object3DSkySphere->Create(GenerateSphere(KSkySphereSegmentCount, KSkySphereColorUp, KSkySphereColorBottom), m_SkyMaterial);
 	m_Object3DSkySphere->ComponentTransform.Scaling = XMVectorSet(KSkyDistance, KSkyDistance, KSkyDistance, 0);
 	m_Object3DSkySphere->ComponentRender.PtrVS = m_VSSky.get();
@@ -601,7 +676,7 @@ void CGame::SetSky(const string& SkyDataFileName, float ScalingFactor)
 	m_Object3DSkySphere->ComponentPhysics.bIsPickable = false;
 	m_Object3DSkySphere->eFlagsRendering = CObject3D::EFlagsRendering::NoCulling | CObject3D::EFlagsRendering::NoLighting;
 
-	m_Object3DSun = make_unique<CObject3D>("Sun", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DSun = make_unique<CObject3D>("Sun", m_RenderDevice.get(), this);
 	m_Object3DSun->Create(GenerateSquareYZPlane(KColorWhite), m_SkyMaterial);
 	m_Object3DSun->UpdateQuadUV(m_SkyData.Sun.UVOffset, m_SkyData.Sun.UVSize);
 	m_Object3DSun->ComponentTransform.Scaling = XMVectorSet(1.0f, ScalingFactor, ScalingFactor * m_SkyData.Sun.WidthHeightRatio, 0);
@@ -611,7 +686,7 @@ void CGame::SetSky(const string& SkyDataFileName, float ScalingFactor)
 	m_Object3DSun->ComponentPhysics.bIsPickable = false;
 	m_Object3DSun->eFlagsRendering = CObject3D::EFlagsRendering::NoCulling | CObject3D::EFlagsRendering::NoLighting;
 	
-	m_Object3DMoon = make_unique<CObject3D>("Moon", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DMoon = make_unique<CObject3D>("Moon", m_RenderDevice.get(), this);
 	m_Object3DMoon->Create(GenerateSquareYZPlane(KColorWhite), m_SkyMaterial);
 	m_Object3DMoon->UpdateQuadUV(m_SkyData.Moon.UVOffset, m_SkyData.Moon.UVSize);
 	m_Object3DMoon->ComponentTransform.Scaling = XMVectorSet(1.0f, ScalingFactor, ScalingFactor * m_SkyData.Moon.WidthHeightRatio, 0);
@@ -627,7 +702,7 @@ void CGame::SetSky(const string& SkyDataFileName, float ScalingFactor)
 	CloudModel.vMaterials.resize(1);
 	CloudModel.vMaterials[0].SetDiffuseTextureFileName("Asset\\earth_clouds.png");
 
-	m_Object3DCloud = make_unique<CObject3D>("Cloud", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DCloud = make_unique<CObject3D>("Cloud", m_RenderDevice.get(), this);
 	m_Object3DCloud->Create(CloudModel);
 	m_Object3DCloud->ComponentTransform.Scaling = XMVectorSet(KSkyDistance * 2, KSkyDistance * 4, KSkyDistance * 2, 0);
 	m_Object3DCloud->ComponentTransform.Roll = -XM_PIDIV2;
@@ -693,21 +768,25 @@ float CGame::GetAmbientLightIntensity() const
 
 void CGame::CreateTerrain(const XMFLOAT2& TerrainSize, const CMaterial& Material, float MaskingDetail)
 {
+	if (m_Terrain) SetTerrainTileDirectory("");
 	m_Terrain.release();
-	m_Terrain = make_unique<CTerrain>(m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Terrain = make_unique<CTerrain>(m_RenderDevice.get(), this);
 	m_Terrain->Create(TerrainSize, Material, MaskingDetail);
 
-	ID3D11ShaderResourceView* NullSRVs[11]{};
-	m_DeviceContext->DSSetShaderResources(0, 1, NullSRVs);
-	m_DeviceContext->PSSetShaderResources(0, 11, NullSRVs);
+	m_StateTracker->SetShaderResource(EShaderType::DomainShader, 0, nullptr);
+	for (UINT iSlot = 0; iSlot < 11; ++iSlot)
+	{
+		m_StateTracker->SetShaderResource(EShaderType::PixelShader, iSlot, nullptr);
+	}
 }
 
 void CGame::LoadTerrain(const string& TerrainFileName)
 {
 	if (TerrainFileName.empty()) return;
 
+	if (m_Terrain) SetTerrainTileDirectory("");
 	m_Terrain.release();
-	m_Terrain = make_unique<CTerrain>(m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Terrain = make_unique<CTerrain>(m_RenderDevice.get(), this);
 	m_Terrain->Load(TerrainFileName);
 	
 	ClearMaterials();
@@ -720,6 +799,25 @@ void CGame::LoadTerrain(const string& TerrainFileName)
 	}
 }
 
+void CGame::SetTerrainTileDirectory(const string& Directory, const CTerrainStreamer::SDesc& Desc)
+{
+	if (!m_Terrain) return;
+
+	// The streamer saves its edited tiles to the old store before it goes
+	m_Terrain->DisableStreaming();
+	m_TerrainTileStore.reset();
+	m_TerrainTileDirectory = Directory;
+	if (Directory.empty()) return;
+
+	m_TerrainTileStore = make_unique<CTerrainTileFileStore>(Directory);
+	m_Terrain->EnableStreaming(m_TerrainTileStore.get(), Desc);
+}
+
+const string& CGame::GetTerrainTileDirectory() const
+{
+	return m_TerrainTileDirectory;
+}
+
 void CGame::SaveTerrain(const string& TerrainFileName)
 {
 	if (!m_Terrain) return;
@@ -760,6 +858,7 @@ CCamera* CGame::GetCamera(size_t Index)
 	return &m_vCameras[Index];
 }
 
+#if defined(_WIN32)
 void CGame::CreateWin32Window(WNDPROC const WndProc, LPCTSTR const WindowName)
 {
 	assert(!m_hWnd);
@@ -795,6 +894,48 @@ void CGame::CreateWin32Window(WNDPROC const WndProc, LPCTSTR const WindowName)
 void CGame::InitializeDirectX(const wstring& FontFileName, bool bWindowed)
 {
 	CreateSwapChain(bWindowed);
+	m_SwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), &m_BackBuffer);
+
+	m_RenderDevice = make_unique<CRenderDeviceD3D11>(m_DeviceContext.Get());
+	m_ShaderCompiler = make_unique<CShaderCompilerD3D>();
+	InitializeRendering(KShaderCacheDirectory);
+
+	m_SpriteBatch = make_unique<SpriteBatch>(m_DeviceContext.Get());
+	m_SpriteFont = make_unique<SpriteFont>(m_Device.Get(), FontFileName.c_str());
+}
+
+void CGame::CreateSwapChain(bool bWindowed)
+{
+	DXGI_SWAP_CHAIN_DESC SwapChainDesc{};
+	SwapChainDesc.BufferCount = 1;
+	SwapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	SwapChainDesc.BufferDesc.Width = static_cast<UINT>(m_WindowSize.x);
+	SwapChainDesc.BufferDesc.Height = static_cast<UINT>(m_WindowSize.y);
+	SwapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
+	SwapChainDesc.BufferDesc.RefreshRate.Numerator = 60;
+	SwapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+	SwapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+	SwapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	SwapChainDesc.Flags = 0;
+	SwapChainDesc.OutputWindow = m_hWnd;
+	SwapChainDesc.SampleDesc.Count = 1;
+	SwapChainDesc.SampleDesc.Quality = 0;
+	SwapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+	SwapChainDesc.Windowed = bWindowed;
+
+	D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+		&SwapChainDesc, &m_SwapChain, &m_Device, nullptr, &m_DeviceContext);
+}
+#endif
+
+void CGame::InitializeRendering(const string& ShaderCacheDirectory)
+{
+	m_StateTracker = make_unique<CStateTracker>(m_RenderDevice.get());
+	m_ConstantBufferUploader = make_unique<CConstantBufferUploader>(m_RenderDevice.get(), m_StateTracker.get());
+	m_ShaderCache = make_unique<CShaderCache>(m_ShaderCompiler.get(), ShaderCacheDirectory);
+	CreateTransientConstantBuffer();
+	m_TransientUploadRing = make_unique<CTransientUploadRing>(m_RenderDevice.get());
+	CreateTransientUploadRing();
 
 	CreateSetViews();
 
@@ -802,6 +943,8 @@ void CGame::InitializeDirectX(const wstring& FontFileName, bool bWindowed)
 
 	CreateDepthStencilStates();
 
+	CreateCommonStates();
+
 	SetPerspective(KDefaultFOV, KDefaultNearZ, KDefaultFarZ);
 
 	CreateInputDevices();
@@ -820,41 +963,57 @@ void CGame::InitializeDirectX(const wstring& FontFileName, bool bWindowed)
 	CreateSamplerStates();
 
 	m_MatrixProjection2D = XMMatrixOrthographicLH(m_WindowSize.x, m_WindowSize.y, 0.0f, 1.0f);
-	m_SpriteBatch = make_unique<SpriteBatch>(m_DeviceContext.Get());
-	m_SpriteFont = make_unique<SpriteFont>(m_Device.Get(), FontFileName.c_str());
-	m_CommonStates = make_unique<CommonStates>(m_Device.Get());
 }
 
+void CGame::CreateTransientConstantBuffer()
+{
+	// Per-draw constant buffers fall back to their own buffers
+	if (!m_RenderDevice->SupportsConstantBufferRanges()) return;
+
+	D3D11_BUFFER_DESC BufferDesc{};
+	BufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	BufferDesc.ByteWidth = static_cast<UINT>(KTransientConstantBufferByteSize);
+	BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	BufferDesc.MiscFlags = 0;
+	BufferDesc.StructureByteStride = 0;
+	BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	if (FAILED(m_RenderDevice->CreateBuffer(BufferDesc, nullptr, m_TransientConstantBuffer.ReleaseAndGetAddressOf()))) return;
 
-void CGame::CreateSwapChain(bool bWindowed)
+	m_ConstantBufferUploader->SetTransientBuffer(m_TransientConstantBuffer.Get(), KTransientConstantBufferByteSize);
+}
+
+void CGame::CreateTransientUploadRing()
 {
-	DXGI_SWAP_CHAIN_DESC SwapChainDesc{};
-	SwapChainDesc.BufferCount = 1;
-	SwapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	SwapChainDesc.BufferDesc.Width = static_cast<UINT>(m_WindowSize.x);
-	SwapChainDesc.BufferDesc.Height = static_cast<UINT>(m_WindowSize.y);
-	SwapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
-	SwapChainDesc.BufferDesc.RefreshRate.Numerator = 60;
-	SwapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-	SwapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-	SwapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	SwapChainDesc.Flags = 0;
-	SwapChainDesc.OutputWindow = m_hWnd;
-	SwapChainDesc.SampleDesc.Count = 1;
-	SwapChainDesc.SampleDesc.Quality = 0;
-	SwapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-	SwapChainDesc.Windowed = bWindowed;
+	D3D11_BUFFER_DESC BufferDesc{};
+	BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER;
+	BufferDesc.ByteWidth = static_cast<UINT>(KTransientUploadRingByteSize);
+	BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	BufferDesc.MiscFlags = 0;
+	BufferDesc.StructureByteStride = 0;
+	BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	if (FAILED(m_RenderDevice->CreateBuffer(BufferDesc, nullptr, m_TransientUploadRingBuffer.ReleaseAndGetAddressOf()))) return;
 
-	D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
-		&SwapChainDesc, &m_SwapChain, &m_Device, nullptr, &m_DeviceContext);
+	m_TransientUploadRing->SetBuffer(m_TransientUploadRingBuffer.Get(), KTransientUploadRingByteSize);
 }
 
 void CGame::CreateSetViews()
 {
-	ComPtr<ID3D11Texture2D> BackBuffer{};
-	m_SwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), &BackBuffer);
+	if (!m_BackBuffer)
+	{
+		// Headless: an offscreen target in the swap chain's format
+		D3D11_TEXTURE2D_DESC BackBufferDesc{};
+		BackBufferDesc.ArraySize = 1;
+		BackBufferDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+		BackBufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		BackBufferDesc.Width = static_cast<UINT>(m_WindowSize.x);
+		BackBufferDesc.Height = static_cast<UINT>(m_WindowSize.y);
+		BackBufferDesc.MipLevels = 1;
+		BackBufferDesc.SampleDesc.Count = 1;
+		BackBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		m_RenderDevice->CreateTexture2D(BackBufferDesc, nullptr, m_BackBuffer.ReleaseAndGetAddressOf());
+	}
 
-	m_Device->CreateRenderTargetView(BackBuffer.Get(), nullptr, &m_RenderTargetView);
+	m_RenderDevice->CreateRenderTargetView(m_BackBuffer.Get(), nullptr, m_RenderTargetView.ReleaseAndGetAddressOf());
 
 	D3D11_TEXTURE2D_DESC DepthStencilBufferDesc{};
 	DepthStencilBufferDesc.ArraySize = 1;
@@ -868,10 +1027,10 @@ void CGame::CreateSetViews()
 	DepthStencilBufferDesc.SampleDesc.Count = 1;
 	DepthStencilBufferDesc.SampleDesc.Quality = 0;
 	DepthStencilBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	m_Device->CreateTexture2D(&DepthStencilBufferDesc, nullptr, &m_DepthStencilBuffer);
-	m_Device->CreateDepthStencilView(m_DepthStencilBuffer.Get(), nullptr, &m_DepthStencilView);
+	m_RenderDevice->CreateTexture2D(DepthStencilBufferDesc, nullptr, m_DepthStencilBuffer.ReleaseAndGetAddressOf());
+	m_RenderDevice->CreateDepthStencilView(m_DepthStencilBuffer.Get(), nullptr, m_DepthStencilView.ReleaseAndGetAddressOf());
 
-	m_DeviceContext->OMSetRenderTargets(1, m_RenderTargetView.GetAddressOf(), m_DepthStencilView.Get());
+	m_StateTracker->SetRenderTarget(m_RenderTargetView.Get(), m_DepthStencilView.Get());
 }
 
 void CGame::SetViewports()
@@ -933,12 +1092,66 @@ void CGame::CreateDepthStencilStates()
 	DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
 	DepthStencilDesc.StencilEnable = FALSE;
 
-	assert(SUCCEEDED(m_Device->CreateDepthStencilState(&DepthStencilDesc, m_DepthStencilStateLessEqualNoWrite.GetAddressOf())));
+	HRESULT Result{ m_RenderDevice->CreateDepthStencilState(DepthStencilDesc, m_DepthStencilStateLessEqualNoWrite.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(Result));
 
 	DepthStencilDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
 	DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
 
-	assert(SUCCEEDED(m_Device->CreateDepthStencilState(&DepthStencilDesc, m_DepthStencilStateAlways.GetAddressOf())));
+	Result = m_RenderDevice->CreateDepthStencilState(DepthStencilDesc, m_DepthStencilStateAlways.ReleaseAndGetAddressOf());
+	assert(SUCCEEDED(Result));
+}
+
+void CGame::CreateCommonStates()
+{
+	// Same descs as DirectXTK's CommonStates
+	D3D11_RASTERIZER_DESC RasterizerDesc{};
+	RasterizerDesc.FillMode = D3D11_FILL_SOLID;
+	RasterizerDesc.DepthClipEnable = TRUE;
+	RasterizerDesc.MultisampleEnable = TRUE;
+
+	RasterizerDesc.CullMode = D3D11_CULL_NONE;
+	m_RenderDevice->CreateRasterizerState(RasterizerDesc,
+		m_RasterizerStates[static_cast<size_t>(ERasterizerState::CullNone)].ReleaseAndGetAddressOf());
+
+	RasterizerDesc.CullMode = D3D11_CULL_FRONT;
+	m_RenderDevice->CreateRasterizerState(RasterizerDesc,
+		m_RasterizerStates[static_cast<size_t>(ERasterizerState::CullClockwise)].ReleaseAndGetAddressOf());
+
+	RasterizerDesc.CullMode = D3D11_CULL_BACK;
+	m_RenderDevice->CreateRasterizerState(RasterizerDesc,
+		m_RasterizerStates[static_cast<size_t>(ERasterizerState::CullCounterClockwise)].ReleaseAndGetAddressOf());
+
+	RasterizerDesc.FillMode = D3D11_FILL_WIREFRAME;
+	m_RenderDevice->CreateRasterizerState(RasterizerDesc,
+		m_RasterizerStates[static_cast<size_t>(ERasterizerState::WireFrame)].ReleaseAndGetAddressOf());
+
+	D3D11_DEPTH_STENCIL_DESC DepthStencilDesc{};
+	DepthStencilDesc.DepthEnable = TRUE;
+	DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	DepthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+	DepthStencilDesc.StencilEnable = FALSE;
+	m_RenderDevice->CreateDepthStencilState(DepthStencilDesc, m_DepthStencilStateDefault.ReleaseAndGetAddressOf());
+
+	DepthStencilDesc.DepthEnable = FALSE;
+	DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	m_RenderDevice->CreateDepthStencilState(DepthStencilDesc, m_DepthStencilStateNone.ReleaseAndGetAddressOf());
+
+	D3D11_BLEND_DESC BlendDesc{};
+	BlendDesc.RenderTarget[0].BlendEnable = TRUE;
+	BlendDesc.RenderTarget[0].SrcBlend = BlendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_SRC_ALPHA;
+	BlendDesc.RenderTarget[0].DestBlend = BlendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+	BlendDesc.RenderTarget[0].BlendOp = BlendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	BlendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	m_RenderDevice->CreateBlendState(BlendDesc, m_BlendStateNonPremultiplied.ReleaseAndGetAddressOf());
+
+	D3D11_SAMPLER_DESC SamplerDesc{};
+	SamplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	SamplerDesc.AddressU = SamplerDesc.AddressV = SamplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	SamplerDesc.MaxAnisotropy = D3D11_MAX_MAXANISOTROPY;
+	SamplerDesc.MaxLOD = FLT_MAX;
+	SamplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+	m_RenderDevice->CreateSamplerState(SamplerDesc, m_SamplerLinearWrap.ReleaseAndGetAddressOf());
 }
 
 void CGame::CreateInputDevices()
@@ -946,147 +1159,198 @@ void CGame::CreateInputDevices()
 	m_Keyboard = make_unique<Keyboard>();
 
 	m_Mouse = make_unique<Mouse>();
-	m_Mouse->SetWindow(m_hWnd);
+	if (m_hWnd) m_Mouse->SetWindow(m_hWnd);
 	m_Mouse->SetMode(Mouse::Mode::MODE_ABSOLUTE);
 }
 
+void CGame::CreateShaderPermutationSets()
+{
+	m_PSBasePermutationSet.AddFeature(static_cast<uint32_t>(EPSBaseFeature::UseTexture), "USE_TEXTURE");
+	m_PSBasePermutationSet.AddFeature(static_cast<uint32_t>(EPSBaseFeature::UseLighting), "USE_LIGHTING");
+	m_PSBasePermutationSet.AddFeature(static_cast<uint32_t>(EPSBaseFeature::HasDiffuseTexture), "HAS_DIFFUSE_TEXTURE",
+		static_cast<uint32_t>(EPSBaseFeature::UseTexture));
+	m_PSBasePermutationSet.AddFeature(static_cast<uint32_t>(EPSBaseFeature::HasOpacityTexture), "HAS_OPACITY_TEXTURE");
+
+	m_DSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(EDSTerrainFeature::UseDisplacement), "USE_DISPLACEMENT");
+
+	m_PSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(CTerrain::EPSFeature::UseLayer1), "USE_LAYER1");
+	m_PSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(CTerrain::EPSFeature::UseLayer2), "USE_LAYER2");
+	m_PSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(CTerrain::EPSFeature::UseLayer3), "USE_LAYER3");
+	m_PSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(CTerrain::EPSFeature::UseLayer4), "USE_LAYER4");
+	m_PSTerrainPermutationSet.AddFeature(static_cast<uint32_t>(CTerrain::EPSFeature::UseTileMasking), "USE_TILE_MASKING");
+	m_PSTerrainPermutationSet.AddConstant("MASKING_MAX_MIP", to_string(CTerrain::KMaskingMaxMip));
+
+	m_PSGrassFieldPermutationSet.AddFeature(static_cast<uint32_t>(CGrassField::EPSFeature::UseTexture), "USE_TEXTURE");
+	m_PSGrassFieldPermutationSet.AddConstant("BLADE_ALPHA_REFERENCE", to_string(CGrassField::KBladeAlphaReference));
+}
+
 void CGame::CreateBaseShaders()
 {
-	m_VSBase = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	CreateShaderPermutationSets();
+
+	// Shaders are created when the batch ends: cached bytecode is loaded, the rest is compiled in parallel
+	m_ShaderCache->BeginBatch();
+
+	m_VSBase = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSBase->Create(EShaderType::VertexShader, L"Shader\\VSBase.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSBase->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSBase->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSInstance = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSInstance = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSInstance->Create(EShaderType::VertexShader, L"Shader\\VSInstance.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSInstance->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSInstance->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSAnimation = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSAnimation = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSAnimation->Create(EShaderType::VertexShader, L"Shader\\VSAnimation.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSAnimation->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSAnimation->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 	m_VSAnimation->AddConstantBuffer(&m_cbVSAnimationBonesData, sizeof(SCBVSAnimationBonesData));
 
-	m_VSSky = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSBaseCompressed = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_VSBaseCompressed->Create(EShaderType::VertexShader, L"Shader\\VSBase.hlsl", "mainCompressed",
+		CVertexCompressor::KInputElementDescs, ARRAYSIZE(CVertexCompressor::KInputElementDescs));
+	m_VSBaseCompressed->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
+	m_VSBaseCompressed->AddConstantBuffer(&m_cbVSVertexQuantizationData, sizeof(CVertexCompressor::SCBVSVertexQuantizationData));
+
+	m_VSInstanceCompressed = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_VSInstanceCompressed->Create(EShaderType::VertexShader, L"Shader\\VSInstance.hlsl", "mainCompressed",
+		CVertexCompressor::KInputElementDescs, ARRAYSIZE(CVertexCompressor::KInputElementDescs));
+	m_VSInstanceCompressed->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
+	m_VSInstanceCompressed->AddConstantBuffer(&m_cbVSVertexQuantizationData, sizeof(CVertexCompressor::SCBVSVertexQuantizationData));
+
+	m_VSAnimationCompressed = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_VSAnimationCompressed->Create(EShaderType::VertexShader, L"Shader\\VSAnimation.hlsl", "mainCompressed",
+		CVertexCompressor::KInputElementDescs, ARRAYSIZE(CVertexCompressor::KInputElementDescs));
+	m_VSAnimationCompressed->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
+	m_VSAnimationCompressed->AddConstantBuffer(&m_cbVSAnimationBonesData, sizeof(SCBVSAnimationBonesData));
+	m_VSAnimationCompressed->AddConstantBuffer(&m_cbVSVertexQuantizationData, sizeof(CVertexCompressor::SCBVSVertexQuantizationData));
+
+	m_VSSky = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSSky->Create(EShaderType::VertexShader, L"Shader\\VSSky.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSSky->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSSky->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSLine = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSLine = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSLine->Create(EShaderType::VertexShader, L"Shader\\VSLine.hlsl", "main", KVSLineInputElementDescs, ARRAYSIZE(KVSLineInputElementDescs));
-	m_VSLine->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSLine->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSGizmo = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSGizmo = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSGizmo->Create(EShaderType::VertexShader, L"Shader\\VSGizmo.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSGizmo->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSGizmo->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSTerrain = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSTerrain = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSTerrain->Create(EShaderType::VertexShader, L"Shader\\VSTerrain.hlsl", "main", KBaseInputElementDescs, ARRAYSIZE(KBaseInputElementDescs));
-	m_VSTerrain->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSTerrain->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 	m_VSTerrain->AddConstantBuffer(&m_cbVSTerrainData, sizeof(CTerrain::SCBVSTerrainData));
 
-	m_VSParticle = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSParticle = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSParticle->Create(EShaderType::VertexShader, L"Shader\\VSParticle.hlsl", "main", KParticleInputElementDescs, ARRAYSIZE(KParticleInputElementDescs));
 
-	m_VSGrassField = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSGrassField = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSGrassField->Create(EShaderType::VertexShader, L"Shader\\VSGrassField.hlsl", "main", 
 		CGrassField::KInputElementDescs, ARRAYSIZE(CGrassField::KInputElementDescs));
-	m_VSGrassField->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData));
+	m_VSGrassField->AddConstantBuffer(&m_cbVSSpaceData, sizeof(SCBVSSpaceData), true);
 
-	m_VSBase2D = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_VSBase2D = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_VSBase2D->Create(EShaderType::VertexShader, L"Shader\\VSBase2D.hlsl", "main", KVS2DBaseInputLayout, ARRAYSIZE(KVS2DBaseInputLayout));
 	m_VSBase2D->AddConstantBuffer(&m_cbVS2DSpaceData, sizeof(SCBVS2DSpaceData));
 
-	m_HSTerrain = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_HSTerrain = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_HSTerrain->Create(EShaderType::HullShader, L"Shader\\HSTerrain.hlsl", "main");
 	m_HSTerrain->AddConstantBuffer(&m_cbHSCameraData, sizeof(SCBHSCameraData));
 	m_HSTerrain->AddConstantBuffer(&m_cbHSTessFactor, sizeof(SCBHSTessFactorData));
 
-	m_HSWater = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_HSWater = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_HSWater->Create(EShaderType::HullShader, L"Shader\\HSWater.hlsl", "main");
 	m_HSWater->AddConstantBuffer(&m_cbHSCameraData, sizeof(SCBHSCameraData));
 	m_HSWater->AddConstantBuffer(&m_cbHSTessFactor, sizeof(SCBHSTessFactorData));
 
-	m_DSTerrain = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
-	m_DSTerrain->Create(EShaderType::DomainShader, L"Shader\\DSTerrain.hlsl", "main");
+	m_DSTerrain = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_DSTerrain->Create(EShaderType::DomainShader, L"Shader\\DSTerrain.hlsl", "main", m_DSTerrainPermutationSet);
 	m_DSTerrain->AddConstantBuffer(&m_cbDSSpaceData, sizeof(SCBDSSpaceData));
-	m_DSTerrain->AddConstantBuffer(&m_cbDSDisplacementData, sizeof(SCBDSDisplacementData));
 
-	m_DSWater = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_DSWater = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_DSWater->Create(EShaderType::DomainShader, L"Shader\\DSWater.hlsl", "main");
 	m_DSWater->AddConstantBuffer(&m_cbDSSpaceData, sizeof(SCBDSSpaceData));
 	m_DSWater->AddConstantBuffer(&m_cbWaterTimeData, sizeof(SCBWaterTimeData));
 
-	m_GSNormal = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_GSNormal = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_GSNormal->Create(EShaderType::GeometryShader, L"Shader\\GSNormal.hlsl", "main");
 	m_GSNormal->AddConstantBuffer(&m_cbGSSpaceData, sizeof(SCBGSSpaceData));
 
-	m_GSParticle = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_GSParticle = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_GSParticle->Create(EShaderType::GeometryShader, L"Shader\\GSParticle.hlsl", "main");
 	m_GSParticle->AddConstantBuffer(&m_cbGSSpaceData, sizeof(SCBGSSpaceData));
 
-	m_GSGrassField = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_GSGrassField = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_GSGrassField->Create(EShaderType::GeometryShader, L"Shader\\GSGrassField.hlsl", "main");
 	m_GSGrassField->AddConstantBuffer(&m_cbGSSpaceData, sizeof(SCBGSSpaceData));
 	m_GSGrassField->AddConstantBuffer(&m_cbGSGrassData, sizeof(CGrassField::SCBGSGrassData));
 
-	m_PSBase = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
-	m_PSBase->Create(EShaderType::PixelShader, L"Shader\\PSBase.hlsl", "main");
-	m_PSBase->AddConstantBuffer(&m_cbPSBaseFlagsData, sizeof(SCBPSBaseFlagsData));
+	m_PSBase = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_PSBase->Create(EShaderType::PixelShader, L"Shader\\PSBase.hlsl", "main", m_PSBasePermutationSet);
 	m_PSBase->AddConstantBuffer(&m_cbPSLightsData, sizeof(SCBPSLightsData));
 	m_PSBase->AddConstantBuffer(&m_cbPSBaseMaterialData, sizeof(SCBPSBaseMaterialData));
 
-	m_PSVertexColor = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSVertexColor = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSVertexColor->Create(EShaderType::PixelShader, L"Shader\\PSVertexColor.hlsl", "main");
 
-	m_PSSky = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSSky = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSSky->Create(EShaderType::PixelShader, L"Shader\\PSSky.hlsl", "main");
 	m_PSSky->AddConstantBuffer(&m_cbPSSkyTimeData, sizeof(SCBPSSkyTimeData));
 
-	m_PSCloud = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSCloud = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSCloud->Create(EShaderType::PixelShader, L"Shader\\PSCloud.hlsl", "main");
 	m_PSCloud->AddConstantBuffer(&m_cbPSSkyTimeData, sizeof(SCBPSSkyTimeData));
 
-	m_PSLine = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSLine = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSLine->Create(EShaderType::PixelShader, L"Shader\\PSLine.hlsl", "main");
 
-	m_PSGizmo = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSGizmo = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSGizmo->Create(EShaderType::PixelShader, L"Shader\\PSGizmo.hlsl", "main");
 	m_PSGizmo->AddConstantBuffer(&m_cbPSGizmoColorFactorData, sizeof(SCBPSGizmoColorFactorData));
 
-	m_PSTerrain = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
-	m_PSTerrain->Create(EShaderType::PixelShader, L"Shader\\PSTerrain.hlsl", "main");
+	m_PSTerrain = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_PSTerrain->Create(EShaderType::PixelShader, L"Shader\\PSTerrain.hlsl", "main", m_PSTerrainPermutationSet);
 	m_PSTerrain->AddConstantBuffer(&m_cbPSTerrainSpaceData, sizeof(SCBPSTerrainSpaceData));
 	m_PSTerrain->AddConstantBuffer(&m_cbPSLightsData, sizeof(SCBPSLightsData));
 	m_PSTerrain->AddConstantBuffer(&m_cbPSTerrainSelectionData, sizeof(CTerrain::SCBPSTerrainSelectionData));
 	m_PSTerrain->AddConstantBuffer(&m_cbEditorTimeData, sizeof(SCBEditorTimeData));
 
-	m_PSWater = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSWater = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSWater->Create(EShaderType::PixelShader, L"Shader\\PSWater.hlsl", "main");
 	m_PSWater->AddConstantBuffer(&m_cbWaterTimeData, sizeof(SCBWaterTimeData));
 	m_PSWater->AddConstantBuffer(&m_cbPSLightsData, sizeof(SCBPSLightsData));
 
-	m_PSParticle = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSParticle = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSParticle->Create(EShaderType::PixelShader, L"Shader\\PSParticle.hlsl", "main");
 
-	m_PSGrassField = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
-	m_PSGrassField->Create(EShaderType::PixelShader, L"Shader\\PSGrassField.hlsl", "main");
-	m_PSGrassField->AddConstantBuffer(&m_cbPSGrassFieldFlags, sizeof(CGrassField::SCBPSFlags));
+	m_PSGrassField = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
+	m_PSGrassField->Create(EShaderType::PixelShader, L"Shader\\PSGrassField.hlsl", "main", m_PSGrassFieldPermutationSet);
 	m_PSGrassField->AddConstantBuffer(&m_cbPSLightsData, sizeof(SCBPSLightsData));
 
-	m_PSBase2D = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSBase2D = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSBase2D->Create(EShaderType::PixelShader, L"Shader\\PSBase2D.hlsl", "main");
 	m_PSBase2D->AddConstantBuffer(&m_cbPS2DFlagsData, sizeof(SCBPS2DFlagsData));
 
-	m_PSMasking2D = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSMasking2D = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSMasking2D->Create(EShaderType::PixelShader, L"Shader\\PSMasking2D.hlsl", "main");
 
-	m_PSHeightMap2D = make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get());
+	m_PSHeightMap2D = make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get());
 	m_PSHeightMap2D->Create(EShaderType::PixelShader, L"Shader\\PSHeightMap2D.hlsl", "main");
+
+	m_ShaderCache->EndBatch();
+
+	const CShaderCache::SStats& ShaderCacheStats{ m_ShaderCache->GetStats() };
+	OutputDebugString((to_string(ShaderCacheStats.RequestCount) + " shaders are created (" + to_string(ShaderCacheStats.HitCount) + " cached, "
+		+ to_string(ShaderCacheStats.MissCount) + " compiled on " + to_string(ShaderCacheStats.ThreadCount) + " threads, "
+		+ to_string(ShaderCacheStats.FailureCount) + " failed). [" + to_string(ShaderCacheStats.ElapsedMilliseconds) + "] elapsed.\n").c_str());
+	OutputDebugString(("Shader variants: PSBase " + to_string(m_PSBase->GetVariantCount()) + ", DSTerrain " + to_string(m_DSTerrain->GetVariantCount())
+		+ ", PSTerrain " + to_string(m_PSTerrain->GetVariantCount()) + ", PSGrassField " + to_string(m_PSGrassField->GetVariantCount()) + "\n").c_str());
 }
 
 void CGame::CreateMiniAxes()
 {
-	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisX", m_Device.Get(), m_DeviceContext.Get(), this));
-	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisY", m_Device.Get(), m_DeviceContext.Get(), this));
-	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisZ", m_Device.Get(), m_DeviceContext.Get(), this));
+	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisX", m_RenderDevice.get(), this));
+	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisY", m_RenderDevice.get(), this));
+	m_vObject3DMiniAxes.emplace_back(make_unique<CObject3D>("AxisZ", m_RenderDevice.get(), this));
 
 	SMesh Cone{ GenerateCone(0, 1.0f, 1.0f, 16) };
 	vector<CMaterial> vMaterials{};
@@ -1119,7 +1383,7 @@ void CGame::CreateMiniAxes()
 
 void CGame::CreatePickingRay()
 {
-	m_Object3DLinePickingRay = make_unique<CObject3DLine>("PickingRay", m_Device.Get(), m_DeviceContext.Get());
+	m_Object3DLinePickingRay = make_unique<CObject3DLine>("PickingRay", m_RenderDevice.get(), m_TransientUploadRing.get());
 
 	vector<SVertex3DLine> Vertices{};
 	Vertices.emplace_back(XMVectorSet(0, 0, 0, 1), XMVectorSet(1, 0, 0, 1));
@@ -1130,14 +1394,14 @@ void CGame::CreatePickingRay()
 
 void CGame::CreateBoundingSphere()
 {
-	m_Object3DBoundingSphere = make_unique<CObject3D>("BoundingSphere", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DBoundingSphere = make_unique<CObject3D>("BoundingSphere", m_RenderDevice.get(), this);
 
 	m_Object3DBoundingSphere->Create(GenerateSphere(16));
 }
 
 void CGame::CreatePickedTriangle()
 {
-	m_Object3DPickedTriangle = make_unique<CObject3D>("PickedTriangle", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3DPickedTriangle = make_unique<CObject3D>("PickedTriangle", m_RenderDevice.get(), this);
 
 	m_Object3DPickedTriangle->Create(GenerateTriangle(XMVectorSet(0, 0, 1.5f, 1), XMVectorSet(+1.0f, 0, 0, 1), XMVectorSet(-1.0f, 0, 0, 1),
 		XMVectorSet(1.0f, 1.0f, 0.0f, 1.0f)));
@@ -1149,7 +1413,7 @@ void CGame::Create3DGizmos()
 	const static XMVECTOR ColorY{ XMVectorSet(0.1f, 1.0f, 0.1f, 1) };
 	const static XMVECTOR ColorZ{ XMVectorSet(0.1f, 0.1f, 1.0f, 1) };
 
-	m_Object3D_3DGizmoRotationPitch = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoRotationPitch = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshRing{ GenerateTorus(ColorX, 0.05f) };
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorX) };
@@ -1161,7 +1425,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoRotationPitch->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoRotationYaw = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoRotationYaw = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshRing{ GenerateTorus(ColorY, 0.05f) };
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorY) };
@@ -1172,7 +1436,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoRotationYaw->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoRotationRoll = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoRotationRoll = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshRing{ GenerateTorus(ColorZ, 0.05f) };
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorZ) };
@@ -1185,7 +1449,7 @@ void CGame::Create3DGizmos()
 	}
 
 
-	m_Object3D_3DGizmoTranslationX = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoTranslationX = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorX) };
 		SMesh MeshCone{ GenerateCone(0, 0.1f, 0.5f, 16, ColorX) };
@@ -1198,7 +1462,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoTranslationX->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoTranslationY = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoTranslationY = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorY) };
 		SMesh MeshCone{ GenerateCone(0, 0.1f, 0.5f, 16, ColorY) };
@@ -1210,7 +1474,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoTranslationY->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoTranslationZ = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoTranslationZ = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorZ) };
 		SMesh MeshCone{ GenerateCone(0, 0.1f, 0.5f, 16, ColorZ) };
@@ -1224,7 +1488,7 @@ void CGame::Create3DGizmos()
 	}
 
 
-	m_Object3D_3DGizmoScalingX = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoScalingX = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorX) };
 		SMesh MeshCube{ GenerateCube(ColorX) };
@@ -1238,7 +1502,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoScalingX->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoScalingY = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoScalingY = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorY) };
 		SMesh MeshCube{ GenerateCube(ColorY) };
@@ -1251,7 +1515,7 @@ void CGame::Create3DGizmos()
 		m_Object3D_3DGizmoScalingY->ComponentRender.PtrPS = m_PSGizmo.get();
 	}
 
-	m_Object3D_3DGizmoScalingZ = make_unique<CObject3D>("Gizmo", m_Device.Get(), m_DeviceContext.Get(), this);
+	m_Object3D_3DGizmoScalingZ = make_unique<CObject3D>("Gizmo", m_RenderDevice.get(), this);
 	{
 		SMesh MeshAxis{ GenerateCylinder(0.05f, 1.0f, 16, ColorZ) };
 		SMesh MeshCube{ GenerateCube(ColorZ) };
@@ -1281,12 +1545,12 @@ void CGame::CreateSamplerStates()
 	SamplerDesc.MinLOD = 0.0f;
 	SamplerDesc.MipLODBias = 0.0f;
 
-	m_Device->CreateSamplerState(&SamplerDesc, m_SamplerLinearMirror.ReleaseAndGetAddressOf());
+	m_RenderDevice->CreateSamplerState(SamplerDesc, m_SamplerLinearMirror.ReleaseAndGetAddressOf());
 }
 
 CShader* CGame::AddShader()
 {
-	m_vShaders.emplace_back(make_unique<CShader>(m_Device.Get(), m_DeviceContext.Get()));
+	m_vShaders.emplace_back(make_unique<CShader>(m_RenderDevice.get(), m_ConstantBufferUploader.get(), m_ShaderCache.get()));
 	return m_vShaders.back().get();
 }
 
@@ -1310,6 +1574,15 @@ CShader* CGame::GetBaseShader(EBaseShader eShader) const
 	case EBaseShader::VSAnimation:
 		Result = m_VSAnimation.get();
 		break;
+	case EBaseShader::VSBaseCompressed:
+		Result = m_VSBaseCompressed.get();
+		break;
+	case EBaseShader::VSInstanceCompressed:
+		Result = m_VSInstanceCompressed.get();
+		break;
+	case EBaseShader::VSAnimationCompressed:
+		Result = m_VSAnimationCompressed.get();
+		break;
 	case EBaseShader::VSSky:
 		Result = m_VSSky.get();
 		break;
@@ -1418,7 +1691,7 @@ void CGame::InsertObject3D(const string& Name)
 		return;
 	}
 
-	m_vObject3Ds.emplace_back(make_unique<CObject3D>(Name, m_Device.Get(), m_DeviceContext.Get(), this));
+	m_vObject3Ds.emplace_back(make_unique<CObject3D>(Name, m_RenderDevice.get(), this));
 	m_vObject3Ds.back()->ComponentRender.PtrVS = m_VSBase.get();
 	m_vObject3Ds.back()->ComponentRender.PtrPS = m_PSBase.get();
 
@@ -1452,6 +1725,9 @@ void CGame::EraseObject3D(const string& Name)
 		}
 	}
 
+	UnregisterObject3DTextures(m_vObject3Ds.back().get());
+	UnbatchObject3D(m_vObject3Ds.back().get());
+
 	m_vObject3Ds.back().release();
 	m_vObject3Ds.pop_back();
 	m_mapObject3DNameToIndex.erase(Name);
@@ -1459,6 +1735,12 @@ void CGame::EraseObject3D(const string& Name)
 
 void CGame::ClearObject3Ds()
 {
+	for (auto& Object3D : m_vObject3Ds)
+	{
+		UnregisterObject3DTextures(Object3D.get());
+	}
+	ClearStaticBatches();
+
 	m_mapObject3DNameToIndex.clear();
 	m_vObject3Ds.clear();
 
@@ -1479,7 +1761,7 @@ void CGame::InsertObject3DLine(const string& Name)
 {
 	assert(m_umapObject3DLineNameToIndex.find(Name) == m_umapObject3DLineNameToIndex.end());
 
-	m_vObject3DLines.emplace_back(make_unique<CObject3DLine>(Name, m_Device.Get(), m_DeviceContext.Get()));
+	m_vObject3DLines.emplace_back(make_unique<CObject3DLine>(Name, m_RenderDevice.get(), m_TransientUploadRing.get()));
 	
 	m_umapObject3DLineNameToIndex[Name] = m_vObject3DLines.size() - 1;
 }
@@ -1493,7 +1775,7 @@ CObject3DLine* CGame::GetObject3DLine(const string& Name) const
 void CGame::InsertObject2D(const string& Name)
 {
 	assert(m_umapObject2DNameToIndex.find(Name) == m_umapObject2DNameToIndex.end());
-	m_vObject2Ds.emplace_back(make_unique<CObject2D>(Name, m_Device.Get(), m_DeviceContext.Get()));
+	m_vObject2Ds.emplace_back(make_unique<CObject2D>(Name, m_RenderDevice.get(), m_TransientUploadRing.get()));
 	
 	m_umapObject2DNameToIndex[Name] = m_vObject2Ds.size() - 1;
 }
@@ -1504,6 +1786,18 @@ CObject2D* CGame::GetObject2D(const string& Name) const
 	return m_vObject2Ds[m_umapObject2DNameToIndex.at(Name)].get();
 }
 
+void CGame::AddGrassField(CGrassField* const PtrGrassField)
+{
+	assert(PtrGrassField);
+	m_vGrassFields.emplace_back(PtrGrassField);
+}
+
+void CGame::AddParticlePool(CParticlePool* const PtrParticlePool)
+{
+	assert(PtrParticlePool);
+	m_vParticlePools.emplace_back(PtrParticlePool);
+}
+
 CMaterial* CGame::AddMaterial(const CMaterial& Material)
 {
 	if (m_mapMaterialNameToIndex.find(Material.GetName()) != m_mapMaterialNameToIndex.end()) return nullptr;
@@ -1577,22 +1871,22 @@ void CGame::CreateMaterialTexture(CMaterial::CTexture::EType eType, CMaterial& M
 		switch (eType)
 		{
 		case CMaterial::CTexture::EType::DiffuseTexture:
-			m_vMaterialDiffuseTextures.back() = make_unique<CMaterial::CTexture>(m_Device.Get(), m_DeviceContext.Get());
+			m_vMaterialDiffuseTextures.back() = make_unique<CMaterial::CTexture>(m_RenderDevice.get());
 			PtrTexture = m_vMaterialDiffuseTextures.back().get();
 			iTexture = m_vMaterialDiffuseTextures.size() - 1;
 			break;
 		case CMaterial::CTexture::EType::NormalTexture:
-			m_vMaterialNormalTextures.back() = make_unique<CMaterial::CTexture>(m_Device.Get(), m_DeviceContext.Get());
+			m_vMaterialNormalTextures.back() = make_unique<CMaterial::CTexture>(m_RenderDevice.get());
 			PtrTexture = m_vMaterialNormalTextures.back().get();
 			iTexture = m_vMaterialNormalTextures.size() - 1;
 			break;
 		case CMaterial::CTexture::EType::DisplacementTexture:
-			m_vMaterialDisplacementTextures.back() = make_unique<CMaterial::CTexture>(m_Device.Get(), m_DeviceContext.Get());
+			m_vMaterialDisplacementTextures.back() = make_unique<CMaterial::CTexture>(m_RenderDevice.get());
 			PtrTexture = m_vMaterialDisplacementTextures.back().get();
 			iTexture = m_vMaterialDisplacementTextures.size() - 1;
 			break;
 		case CMaterial::CTexture::EType::OpacityTexture:
-			m_vMaterialOpacityTextures.back() = make_unique<CMaterial::CTexture>(m_Device.Get(), m_DeviceContext.Get());
+			m_vMaterialOpacityTextures.back() = make_unique<CMaterial::CTexture>(m_RenderDevice.get());
 			PtrTexture = m_vMaterialOpacityTextures.back().get();
 			iTexture = m_vMaterialOpacityTextures.size() - 1;
 			break;
@@ -1909,14 +2203,17 @@ void CGame::SetTerrainMaskingSize(float Size)
 
 void CGame::BeginRendering(const FLOAT* ClearColor)
 {
-	m_DeviceContext->ClearRenderTargetView(m_RenderTargetView.Get(), Colors::CornflowerBlue);
-	m_DeviceContext->ClearDepthStencilView(m_DepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	m_ConstantBufferUploader->BeginFrame();
+	m_TransientUploadRing->BeginFrame();
+	m_StateTracker->BeginFrame();
 
-	ID3D11SamplerState* SamplerState{ m_CommonStates->LinearWrap() };
-	m_DeviceContext->PSSetSamplers(0, 1, &SamplerState);
-	m_DeviceContext->DSSetSamplers(0, 1, &SamplerState); // @important: in order to use displacement mapping
+	m_StateTracker->ClearRenderTarget(m_RenderTargetView.Get(), Colors::CornflowerBlue);
+	m_StateTracker->ClearDepthStencil(m_DepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-	m_DeviceContext->OMSetBlendState(m_CommonStates->NonPremultiplied(), nullptr, 0xFFFFFFFF);
+	m_StateTracker->SetSamplerState(EShaderType::PixelShader, 0, m_SamplerLinearWrap.Get());
+	m_StateTracker->SetSamplerState(EShaderType::DomainShader, 0, m_SamplerLinearWrap.Get()); // @important: in order to use displacement mapping
+
+	m_StateTracker->SetBlendState(m_BlendStateNonPremultiplied.Get());
 
 	SetUniversalRasterizerState();
 
@@ -1943,7 +2240,16 @@ void CGame::Draw(float DeltaTime)
 	m_cbWaterTimeData.Time += DeltaTime * 0.1f;
 	if (m_cbWaterTimeData.Time > 1.0f) m_cbWaterTimeData.Time = 0.0f;
 
-	m_DeviceContext->RSSetViewports(1, &m_vViewports[0]);
+	m_TextureStreamer.BeginFrame();
+
+	// The tiles around the camera are requested before anything reads them (the recording jobs included)
+	if (m_Terrain)
+	{
+		const XMVECTOR& KEyePosition{ m_vCameras[m_CurrentCameraIndex].GetEyePosition() };
+		m_Terrain->UpdateStreaming(XMFLOAT2(XMVectorGetX(KEyePosition), XMVectorGetZ(KEyePosition)));
+	}
+
+	m_StateTracker->SetViewport(m_vViewports[0]);
 
 	m_cbPSLightsData.EyePosition = m_vCameras[m_CurrentCameraIndex].GetEyePosition();
 
@@ -1956,6 +2262,9 @@ void CGame::Draw(float DeltaTime)
 		m_eRasterizerState = ERasterizerState::CullCounterClockwise;
 	}
 
+	m_ViewFrustum = CMeshletCuller::ExtractFrustum(m_MatrixView * m_MatrixProjection);
+	m_MeshletCullerStats = CMeshletCuller::SStats();
+
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawMiniAxes))
 	{
 		DrawMiniAxes();
@@ -1978,77 +2287,159 @@ void CGame::Draw(float DeltaTime)
 		Draw3DGizmos();
 	}
 
-	DrawTerrain();
+	const bool bShouldRecord{ EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::RecordInParallel) };
+	if (!bShouldRecord)
+	{
+		DrawTerrain();
+
+		DrawGrassFields();
+	}
+
+	UpdateStaticBatches();
 
-	for (auto& Object3D : m_vObject3Ds)
+	BuildRenderQueue();
+
+	if (bShouldRecord)
 	{
-		if (Object3D->ComponentRender.bIsTransparent) continue;
+		PrepareRecording();
 
-		UpdateObject3D(Object3D.get());
-		DrawObject3D(Object3D.get());
+		m_CommandRecorder.Record(m_vRecordingJobs.size(), [this](size_t iJob, CCommandBuffer& CommandBuffer)
+			{
+				RecordJob(iJob, CommandBuffer);
+			}, m_RecordingThreadCount);
 
-		if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawBoundingSphere))
-		{
-			DrawObject3DBoundingSphere(Object3D.get());
-		}
+		// The terrain, the grass and the opaque static batches, then the rest of the opaque packets
+		m_CommandRecorder.Replay(*m_RenderDevice, 0, m_RecordingOpaqueJobCount);
+
+		DrawTerrainTextures();
 	}
 
-	DrawObject3DLines();
+	// Opaque packets come first (front to back), then the transparent ones (back to front)
+	const vector<CRenderQueue::SPacket>& vPackets{ m_RenderQueue.GetPackets() };
+	size_t iPacket{};
 
-	// Transparent Object3Ds
-	for (auto& Object3D : m_vObject3Ds)
+	m_StateTracker->BeginTracking();
+	for (; iPacket < vPackets.size(); ++iPacket)
 	{
-		if (!Object3D->ComponentRender.bIsTransparent) continue;
+		if (CRenderQueue::GetPass(vPackets[iPacket].SortKey) != CRenderQueue::EPass::Opaque) break;
+		if (bShouldRecord && (vPackets[iPacket].ItemIndex & KRenderQueueStaticBatchFlag)) continue;
 
-		UpdateObject3D(Object3D.get());
-		DrawObject3D(Object3D.get());
+		SubmitRenderPacket(vPackets[iPacket]);
+	}
 
-		if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawBoundingSphere))
+	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawBoundingSphere))
+	{
+		for (auto& Object3D : m_vObject3Ds)
 		{
-			DrawObject3DBoundingSphere(Object3D.get());
+			if (IsObject3DStaticBatched(Object3D.get())) DrawObject3DBoundingSphere(Object3D.get());
 		}
 	}
+	m_StateTracker->EndTracking();
+
+	DrawObject3DLines();
+
+	m_StateTracker->BeginTracking();
+	for (; iPacket < vPackets.size(); ++iPacket)
+	{
+		SubmitRenderPacket(vPackets[iPacket]);
+	}
+	m_StateTracker->EndTracking();
+
+	if (bShouldRecord)
+	{
+		m_CommandRecorder.Replay(*m_RenderDevice, m_RecordingOpaqueJobCount, m_vRecordingJobs.size() - m_RecordingOpaqueJobCount);
+	}
+	else
+	{
+		DrawParticlePools();
+	}
 
 	DrawObject2Ds();
+
+	UpdateTextureStreaming();
 }
 
-void CGame::UpdateObject3D(CObject3D* const PtrObject3D)
+void CGame::SelectObject3DShaders(const CObject3D* const PtrObject3D, CShader** const PtrOutVS, CShader** const PtrOutPS) const
 {
-	if (!PtrObject3D) return;
-
-	assert(PtrObject3D->ComponentRender.PtrVS);
-	assert(PtrObject3D->ComponentRender.PtrPS);
 	CShader* VS{ PtrObject3D->ComponentRender.PtrVS };
 	CShader* PS{ PtrObject3D->ComponentRender.PtrPS };
 
-	m_cbVSSpaceData.World = XMMatrixTranspose(PtrObject3D->ComponentTransform.MatrixWorld);
-	m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
-	PtrObject3D->UpdateWorldMatrix();
+	if (PtrObject3D->IsVertexCompressed())
+	{
+		// @important: compressed vertex buffers need the shaders' mainCompressed() variants
+		if (VS == m_VSBase.get()) VS = m_VSBaseCompressed.get();
+		if (VS == m_VSInstance.get()) VS = m_VSInstanceCompressed.get();
+		if (VS == m_VSAnimation.get()) VS = m_VSAnimationCompressed.get();
+	}
 
 	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::UseRawVertexColor))
 	{
 		PS = m_PSVertexColor.get();
 	}
 
-	SetUniversalbUseLighiting();
-	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoLighting))
+	*PtrOutVS = VS;
+	*PtrOutPS = PS;
+}
+
+EPSBaseFeature CGame::GetPSBaseObjectFeatures(const CObject3D* const PtrObject3D) const
+{
+	EPSBaseFeature eFeatures{};
+	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::UseLighting) && 
+		EFLAG_HAS_NO(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoLighting))
+	{
+		eFeatures |= EPSBaseFeature::UseLighting;
+	}
+	if (EFLAG_HAS_NO(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoTexture))
 	{
-		m_cbPSBaseFlagsData.bUseLighting = FALSE;
+		eFeatures |= EPSBaseFeature::UseTexture;
 	}
+	return eFeatures;
+}
+
+EPSBaseFeature CGame::GetPSBaseMaterialFeatures(const CMaterial& Material)
+{
+	EPSBaseFeature eFeatures{};
+	if (Material.HasTexture(CMaterial::CTexture::EType::DiffuseTexture)) eFeatures |= EPSBaseFeature::HasDiffuseTexture;
+	if (Material.HasTexture(CMaterial::CTexture::EType::OpacityTexture)) eFeatures |= EPSBaseFeature::HasOpacityTexture;
+	return eFeatures;
+}
+
+void CGame::UpdateObject3D(CObject3D* const PtrObject3D)
+{
+	if (!PtrObject3D) return;
+
+	assert(PtrObject3D->ComponentRender.PtrVS);
+	assert(PtrObject3D->ComponentRender.PtrPS);
+	CShader* VS{};
+	CShader* PS{};
+	SelectObject3DShaders(PtrObject3D, &VS, &PS);
+
+	m_cbVSSpaceData.World = XMMatrixTranspose(PtrObject3D->ComponentTransform.MatrixWorld);
+	m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
+	PtrObject3D->UpdateWorldMatrix();
 
-	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoTexture))
+	if (PtrObject3D->IsVertexCompressed())
 	{
-		m_cbPSBaseFlagsData.bUseTexture = FALSE;
+		m_cbVSVertexQuantizationData = PtrObject3D->GetVertexQuantization();
 	}
-	else
+
+	// The first mesh's material is assumed, so that single-material objects don't switch variants in UpdatePSBaseMaterial()
+	m_ePSBaseObjectFeatures = GetPSBaseObjectFeatures(PtrObject3D);
+	if (PS == m_PSBase.get())
 	{
-		m_cbPSBaseFlagsData.bUseTexture = TRUE;
+		EPSBaseFeature eFeatures{ m_ePSBaseObjectFeatures };
+		const SModel& Model{ PtrObject3D->GetModel() };
+		if (Model.vMeshes.size() && Model.vMeshes[0].MaterialID < Model.vMaterials.size())
+		{
+			eFeatures |= GetPSBaseMaterialFeatures(Model.vMaterials[Model.vMeshes[0].MaterialID]);
+		}
+		PS->SetPermutation(static_cast<uint32_t>(eFeatures));
 	}
 	
-	VS->Use();
+	VS->Use(*m_StateTracker);
 	VS->UpdateAllConstantBuffers();
 
-	PS->Use();
+	PS->Use(*m_StateTracker);
 	PS->UpdateAllConstantBuffers();
 }
 
@@ -2058,23 +2449,23 @@ void CGame::DrawObject3D(const CObject3D* const PtrObject3D)
 
 	if (PtrObject3D->ShouldTessellate())
 	{
-		m_HSTerrain->Use();
+		m_HSTerrain->Use(*m_StateTracker);
 		m_cbHSCameraData.EyePosition = m_vCameras[m_CurrentCameraIndex].GetEyePosition();
 		m_HSTerrain->UpdateConstantBuffer(0);
 
-		m_DSTerrain->Use();
+		m_DSTerrain->Use(*m_StateTracker);
 		m_cbDSSpaceData.ViewProjection = GetTransposedVPMatrix();
 		m_DSTerrain->UpdateConstantBuffer(0);
 	}
 	else
 	{
-		m_DeviceContext->HSSetShader(nullptr, nullptr, 0);
-		m_DeviceContext->DSSetShader(nullptr, nullptr, 0);
+		m_StateTracker->SetHullShader(nullptr);
+		m_StateTracker->SetDomainShader(nullptr);
 	}
 
 	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoCulling))
 	{
-		m_DeviceContext->RSSetState(m_CommonStates->CullNone());
+		m_StateTracker->SetRasterizerState(GetRasterizerState(ERasterizerState::CullNone));
 	}
 	else
 	{
@@ -2083,23 +2474,23 @@ void CGame::DrawObject3D(const CObject3D* const PtrObject3D)
 
 	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoDepthComparison))
 	{
-		m_DeviceContext->OMSetDepthStencilState(m_CommonStates->DepthNone(), 0);
+		m_StateTracker->SetDepthStencilState(m_DepthStencilStateNone.Get(), 0);
 	}
 	else
 	{
-		m_DeviceContext->OMSetDepthStencilState(m_CommonStates->DepthDefault(), 0);
+		m_StateTracker->SetDepthStencilState(m_DepthStencilStateDefault.Get(), 0);
 	}
 
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals))
 	{
 		UpdateGSSpace();
 
-		m_GSNormal->Use();
+		m_GSNormal->Use(*m_StateTracker);
 		m_GSNormal->UpdateAllConstantBuffers();
 		
 		PtrObject3D->Draw();
 
-		m_DeviceContext->GSSetShader(nullptr, nullptr, 0);
+		m_StateTracker->SetGeometryShader(nullptr);
 	}
 	else
 	{
@@ -2109,7 +2500,7 @@ void CGame::DrawObject3D(const CObject3D* const PtrObject3D)
 
 void CGame::DrawObject3DBoundingSphere(const CObject3D* const PtrObject3D)
 {
-	m_VSBase->Use();
+	m_VSBase->Use(*m_StateTracker);
 
 	XMMATRIX Translation{ XMMatrixTranslationFromVector(PtrObject3D->ComponentTransform.Translation + 
 		PtrObject3D->ComponentPhysics.BoundingSphere.CenterOffset) };
@@ -2120,53 +2511,614 @@ void CGame::DrawObject3DBoundingSphere(const CObject3D* const PtrObject3D)
 	m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
 	m_VSBase->UpdateConstantBuffer(0);
 
-	m_DeviceContext->RSSetState(m_CommonStates->Wireframe());
+	m_StateTracker->SetRasterizerState(GetRasterizerState(ERasterizerState::WireFrame));
 
 	m_Object3DBoundingSphere->Draw();
 
 	SetUniversalRasterizerState();
 }
 
-void CGame::DrawObject3DLines()
+void CGame::SelectObject3DLOD(CObject3D* const PtrObject3D)
 {
-	m_VSLine->Use();
-	m_PSLine->Use();
+	if (PtrObject3D->GetLODCount() <= 1) return;
 
-	for (auto& Object3DLine : m_vObject3DLines)
+	// Largest projected radius among the instances
+	const auto& BoundingSphere{ PtrObject3D->ComponentPhysics.BoundingSphere };
+	XMVECTOR EyePosition{ m_vCameras[m_CurrentCameraIndex].GetEyePosition() };
+	float MinDistance{ FLT_MAX };
+	if (PtrObject3D->IsInstanced())
 	{
-		if (Object3DLine)
+		int InstanceCount{ (int)PtrObject3D->GetInstanceCount() };
+		for (int iInstance = 0; iInstance < InstanceCount; ++iInstance)
 		{
-			if (!Object3DLine->bIsVisible) continue;
-
-			Object3DLine->UpdateWorldMatrix();
-
-			m_cbVSSpaceData.World = XMMatrixTranspose(Object3DLine->ComponentTransform.MatrixWorld);
-			m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
-			m_VSLine->UpdateConstantBuffer(0);
-
-			Object3DLine->Draw();
+			XMVECTOR Center{ PtrObject3D->GetInstance(iInstance).Translation + BoundingSphere.CenterOffset };
+			MinDistance = min(MinDistance, XMVectorGetX(XMVector3Length(Center - EyePosition)));
 		}
 	}
+	else
+	{
+		XMVECTOR Center{ PtrObject3D->ComponentTransform.Translation + BoundingSphere.CenterOffset };
+		MinDistance = XMVectorGetX(XMVector3Length(Center - EyePosition));
+	}
+
+	float ProjectedRadius{ FLT_MAX };
+	if (MinDistance > BoundingSphere.Radius)
+	{
+		ProjectedRadius = BoundingSphere.Radius / (sqrtf(MinDistance * MinDistance - BoundingSphere.Radius * BoundingSphere.Radius) *
+			tanf(m_FOV * 0.5f)) * m_WindowSize.y * 0.5f;
+	}
+	PtrObject3D->SelectLOD(ProjectedRadius);
 }
 
-void CGame::DrawObject2Ds()
+void CGame::CullObject3DMeshlets(CObject3D* const PtrObject3D)
 {
-	m_DeviceContext->OMSetDepthStencilState(m_CommonStates->DepthNone(), 0);
-	m_DeviceContext->OMSetBlendState(m_CommonStates->NonPremultiplied(), nullptr, 0xFFFFFFFF);
-	
-	m_cbVS2DSpaceData.Projection = XMMatrixTranspose(m_MatrixProjection2D);
+	// Wireframe doesn't cull back faces
+	bool bUseConeCulling{ m_eRasterizerState == ERasterizerState::CullCounterClockwise };
+	PtrObject3D->CullMeshlets(m_ViewFrustum, m_vCameras[m_CurrentCameraIndex].GetEyePosition(), bUseConeCulling, &m_MeshletCullerStats);
+}
 
-	m_VSBase2D->Use();
-	m_PSBase2D->Use();
+void CGame::ReportObject3DTextureUsage(CObject3D* const PtrObject3D)
+{
+	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoTexture)) return;
 
-	for (auto& Object2D : m_vObject2Ds)
+	// Largest screen coverage among the instances
+	const auto& BoundingSphere{ PtrObject3D->ComponentPhysics.BoundingSphere };
+	XMVECTOR EyePosition{ m_vCameras[m_CurrentCameraIndex].GetEyePosition() };
+	float ScreenPixelArea{};
+	if (PtrObject3D->IsInstanced())
 	{
-		if (Object2D)
+		int InstanceCount{ (int)PtrObject3D->GetInstanceCount() };
+		for (int iInstance = 0; iInstance < InstanceCount; ++iInstance)
 		{
-			if (!Object2D->bIsVisible) continue;
+			XMVECTOR Center{ PtrObject3D->GetInstance(iInstance).Translation + BoundingSphere.CenterOffset };
+			float Distance{ XMVectorGetX(XMVector3Length(Center - EyePosition)) };
+			ScreenPixelArea = max(ScreenPixelArea, CTextureStreamer::CalculateScreenPixelArea(BoundingSphere.Radius, Distance, m_FOV, m_WindowSize));
+		}
+	}
+	else
+	{
+		XMVECTOR Center{ PtrObject3D->ComponentTransform.Translation + BoundingSphere.CenterOffset };
+		float Distance{ XMVectorGetX(XMVector3Length(Center - EyePosition)) };
+		ScreenPixelArea = CTextureStreamer::CalculateScreenPixelArea(BoundingSphere.Radius, Distance, m_FOV, m_WindowSize);
+	}
 
-			Object2D->UpdateWorldMatrix();
-			m_cbVS2DSpaceData.World = XMMatrixTranspose(Object2D->ComponentTransform.MatrixWorld);
+	static constexpr CMaterial::CTexture::EType KTextureTypes[]{ CMaterial::CTexture::EType::DiffuseTexture, 
+		CMaterial::CTexture::EType::NormalTexture, CMaterial::CTexture::EType::DisplacementTexture, CMaterial::CTexture::EType::OpacityTexture };
+
+	const SModel& Model{ PtrObject3D->GetModel() };
+	for (size_t iMesh = 0; iMesh < Model.vMeshes.size(); ++iMesh)
+	{
+		if (Model.vMeshes[iMesh].MaterialID >= Model.vMaterials.size()) continue;
+		const CMaterial& Material{ Model.vMaterials[Model.vMeshes[iMesh].MaterialID] };
+
+		// @important: roughly half of a closed mesh faces the camera
+		float UVArea{ PtrObject3D->GetMeshUVArea(iMesh) * 0.5f };
+
+		for (CMaterial::CTexture::EType eType : KTextureTypes)
+		{
+			CMaterial::CTexture* PtrTexture{ Material.GetTexture(eType) };
+			if (!PtrTexture || !PtrTexture->IsStreamable()) continue;
+
+			if (PtrTexture->GetStreamingID() == CTextureStreamer::KInvalidID)
+			{
+				const XMFLOAT2& TextureSize{ PtrTexture->GetStreamingTextureSize() };
+				size_t StreamingID{ m_TextureStreamer.RegisterTexture(CTextureStreamer::MakeTextureDesc(PtrTexture->GetFormat(),
+					static_cast<uint32_t>(TextureSize.x), static_cast<uint32_t>(TextureSize.y), PtrTexture->GetStreamingMipLevels())) };
+				PtrTexture->SetStreamingID(StreamingID);
+				PtrTexture->RequestResidentMip(m_TextureStreamer.GetResidentMip(StreamingID), m_TextureMipLoader);
+
+				if (m_vStreamingTextures.size() <= StreamingID) m_vStreamingTextures.resize(StreamingID + 1);
+				m_vStreamingTextures[StreamingID] = PtrTexture;
+			}
+
+			m_TextureStreamer.ReportUsage(PtrTexture->GetStreamingID(), ScreenPixelArea, UVArea);
+		}
+	}
+}
+
+void CGame::UnregisterObject3DTextures(CObject3D* const PtrObject3D)
+{
+	static constexpr CMaterial::CTexture::EType KTextureTypes[]{ CMaterial::CTexture::EType::DiffuseTexture,
+		CMaterial::CTexture::EType::NormalTexture, CMaterial::CTexture::EType::DisplacementTexture, CMaterial::CTexture::EType::OpacityTexture };
+
+	for (const CMaterial& Material : PtrObject3D->GetModel().vMaterials)
+	{
+		for (CMaterial::CTexture::EType eType : KTextureTypes)
+		{
+			CMaterial::CTexture* PtrTexture{ Material.GetTexture(eType) };
+			if (!PtrTexture || PtrTexture->GetStreamingID() == CTextureStreamer::KInvalidID) continue;
+
+			m_TextureStreamer.UnregisterTexture(PtrTexture->GetStreamingID());
+			m_vStreamingTextures[PtrTexture->GetStreamingID()] = nullptr;
+			PtrTexture->SetStreamingID(CTextureStreamer::KInvalidID);
+			PtrTexture->CancelMipLoad();
+		}
+	}
+}
+
+void CGame::UpdateTextureStreaming()
+{
+	// The mips read since the last frame are copied in (and sampled from the next frame on)
+	m_TextureMipLoader.TakeResults(m_vTextureMipLoads);
+	for (const auto& Load : m_vTextureMipLoads)
+	{
+		CMaterial::CTexture* PtrTexture{ (Load.TextureID < m_vStreamingTextures.size()) ? m_vStreamingTextures[Load.TextureID] : nullptr };
+		if (!PtrTexture) continue;
+
+		if (!PtrTexture->ApplyLoadedMips(Load.LoadID, Load.FirstMip, Load.vMips, m_TextureMipLoader))
+		{
+			OutputDebugString(("Failed to stream " + PtrTexture->GetFileName() + " (mip " + to_string(Load.FirstMip) + ")\n").c_str());
+		}
+	}
+
+	m_TextureStreamer.Update(m_vTextureStreamingRequests);
+
+	for (const auto& Request : m_vTextureStreamingRequests)
+	{
+		CMaterial::CTexture* PtrTexture{ m_vStreamingTextures[Request.TextureID] };
+		if (!PtrTexture) continue;
+
+		PtrTexture->RequestResidentMip(Request.ResidentMip, m_TextureMipLoader);
+	}
+}
+
+bool CGame::IsObject3DStaticBatchable(const CObject3D* const PtrObject3D) const
+{
+	if (!PtrObject3D->IsCreated()) return false;
+	if (PtrObject3D->IsInstanced() || PtrObject3D->IsRiggedModel() || PtrObject3D->ShouldTessellate()) return false;
+	if (PtrObject3D->ComponentRender.bIsTransparent || PtrObject3D->ComponentRender.bShouldAnimate) return false;
+
+	// @important: batches are drawn with m_VSBase since their vertices are already in world space (and not compressed)
+	if (PtrObject3D->ComponentRender.PtrVS != m_VSBase.get()) return false;
+
+	size_t TriangleCount{};
+	for (const SMesh& Mesh : PtrObject3D->GetModel().vMeshes)
+	{
+		TriangleCount += Mesh.vTriangles.size();
+	}
+	return TriangleCount < KMaxStaticBatchMemberTriangleCount;
+}
+
+bool CGame::IsObject3DStaticBatched(const CObject3D* const PtrObject3D) const
+{
+	return m_umapObject3DToStaticBatchObjects.find(PtrObject3D) != m_umapObject3DToStaticBatchObjects.end();
+}
+
+uint64_t CGame::CalculateStaticBatchKey(const CObject3D* const PtrObject3D, size_t MeshIndex) const
+{
+	static constexpr CMaterial::CTexture::EType KTextureTypes[]{ CMaterial::CTexture::EType::DiffuseTexture,
+		CMaterial::CTexture::EType::NormalTexture, CMaterial::CTexture::EType::DisplacementTexture, CMaterial::CTexture::EType::OpacityTexture };
+
+	static constexpr uint64_t KHashSeed{ 0xCBF29CE484222325 };
+
+	const SModel& Model{ PtrObject3D->GetModel() };
+	const CMaterial& Material{ Model.vMaterials[Model.vMeshes[MeshIndex].MaterialID] };
+
+	// @important: every object has its own copy of its materials, so materials are compared by their contents
+	const CShader* const PtrPS{ PtrObject3D->ComponentRender.PtrPS };
+	const uint32_t KFlags{ static_cast<uint32_t>(PtrObject3D->eFlagsRendering) };
+	uint64_t Key{ HashRenderQueueKey(KHashSeed, &PtrPS, sizeof(PtrPS)) };
+	Key = HashRenderQueueKey(Key, &KFlags, sizeof(KFlags));
+
+	const float KMaterialData[]{ Material.GetAmbientColor().x, Material.GetAmbientColor().y, Material.GetAmbientColor().z,
+		Material.GetDiffuseColor().x, Material.GetDiffuseColor().y, Material.GetDiffuseColor().z,
+		Material.GetSpecularColor().x, Material.GetSpecularColor().y, Material.GetSpecularColor().z,
+		Material.GetSpecularExponent(), Material.GetSpecularIntensity() };
+	Key = HashRenderQueueKey(Key, KMaterialData, sizeof(KMaterialData));
+	for (CMaterial::CTexture::EType eType : KTextureTypes)
+	{
+		// The type goes first, so that the same file in another slot doesn't hash the same
+		const uint32_t KType{ (Material.HasTexture(eType)) ? static_cast<uint32_t>(eType) + 1 : 0 };
+		Key = HashRenderQueueKey(Key, &KType, sizeof(KType));
+		if (!KType) continue;
+
+		// Embedded textures are only identical within the same model file
+		if (Material.IsTextureEmbedded(eType))
+		{
+			const string& KModelFileName{ PtrObject3D->GetModelFileName() };
+			Key = HashRenderQueueKey(Key, KModelFileName.data(), KModelFileName.size() + 1);
+		}
+		const string& KTextureFileName{ Material.GetTextureFileName(eType) };
+		Key = HashRenderQueueKey(Key, KTextureFileName.data(), KTextureFileName.size() + 1);
+	}
+	return Key;
+}
+
+void CGame::UnbatchObject3D(const CObject3D* const PtrObject3D)
+{
+	auto it{ m_umapObject3DToStaticBatchObjects.find(PtrObject3D) };
+	if (it == m_umapObject3DToStaticBatchObjects.end()) return;
+
+	for (size_t MemberID : it->second.vMemberIDs)
+	{
+		m_StaticBatcher.UnregisterMember(MemberID);
+		m_vStaticBatchMembers[MemberID] = SStaticBatchMember();
+	}
+	m_umapObject3DToStaticBatchObjects.erase(it);
+}
+
+void CGame::ClearStaticBatches()
+{
+	m_StaticBatcher.Clear();
+	m_vStaticBatchMembers.clear();
+	m_vStaticBatchBuffers.clear();
+	m_umapObject3DToStaticBatchObjects.clear();
+	m_StaticBatchDrawCount = 0;
+}
+
+void CGame::UpdateStaticBatches()
+{
+	if (EFLAG_HAS_NO(m_eFlagsRendering, EFlagsRendering::UseStaticBatching))
+	{
+		if (m_umapObject3DToStaticBatchObjects.size()) ClearStaticBatches();
+		return;
+	}
+
+	for (auto& Object3D : m_vObject3Ds)
+	{
+		CObject3D* const PtrObject3D{ Object3D.get() };
+		if (!IsObject3DStaticBatchable(PtrObject3D))
+		{
+			UnbatchObject3D(PtrObject3D);
+			continue;
+		}
+
+		// @important: batched objects are not drawn, so their world matrices must be updated here to detect movement
+		PtrObject3D->UpdateWorldMatrix();
+
+		const XMMATRIX& World{ PtrObject3D->ComponentTransform.MatrixWorld };
+		const vector<SMesh>& vMeshes{ PtrObject3D->GetModel().vMeshes };
+		auto it{ m_umapObject3DToStaticBatchObjects.find(PtrObject3D) };
+		if (it != m_umapObject3DToStaticBatchObjects.end() && (it->second.ModelVersion != PtrObject3D->GetModelVersion() ||
+			it->second.PtrPS != PtrObject3D->ComponentRender.PtrPS || it->second.eFlagsRendering != PtrObject3D->eFlagsRendering))
+		{
+			// The model, its materials or the object's states have changed, so the keys have to be calculated again
+			UnbatchObject3D(PtrObject3D);
+			it = m_umapObject3DToStaticBatchObjects.end();
+		}
+
+		if (it == m_umapObject3DToStaticBatchObjects.end())
+		{
+			SStaticBatchObject& Object{ m_umapObject3DToStaticBatchObjects[PtrObject3D] };
+			Object.ModelVersion = PtrObject3D->GetModelVersion();
+			Object.PtrPS = PtrObject3D->ComponentRender.PtrPS;
+			Object.eFlagsRendering = PtrObject3D->eFlagsRendering;
+			for (size_t iMesh = 0; iMesh < vMeshes.size(); ++iMesh)
+			{
+				const uint64_t KKey{ CalculateStaticBatchKey(PtrObject3D, iMesh) };
+				size_t MemberID{ m_StaticBatcher.RegisterMember(&vMeshes[iMesh], World, KKey) };
+				if (MemberID >= m_vStaticBatchMembers.size()) m_vStaticBatchMembers.resize(MemberID + 1);
+
+				m_vStaticBatchMembers[MemberID].PtrObject3D = PtrObject3D;
+				m_vStaticBatchMembers[MemberID].MeshIndex = iMesh;
+				m_vStaticBatchMembers[MemberID].Key = KKey;
+				Object.vMemberIDs.emplace_back(MemberID);
+			}
+		}
+		else
+		{
+			for (size_t MemberID : it->second.vMemberIDs)
+			{
+				m_StaticBatcher.UpdateMember(MemberID, World, m_vStaticBatchMembers[MemberID].Key);
+			}
+		}
+	}
+
+	m_StaticBatcher.Update();
+
+#if defined(_DEBUG)
+	const CStaticBatcher::SStats& Stats{ m_StaticBatcher.GetStats() };
+	if (Stats.RebuiltBatchCount)
+	{
+		OutputDebugString(("- Static batches rebuilt. [" + to_string(Stats.RebuiltBatchCount) + "] batches, [" +
+			to_string(Stats.RebuiltVertexCount) + "] vertices, [" + to_string(Stats.MemberCount) + "] meshes -> [" +
+			to_string(Stats.BatchCount) + "] batches, [" + to_string(Stats.ElapsedMilliseconds) + "] ms elapsed.\n").c_str());
+	}
+#endif
+
+	const vector<CStaticBatcher::SBatch>& vBatches{ m_StaticBatcher.GetBatches() };
+	m_vStaticBatchBuffers.resize(vBatches.size());
+	for (size_t iBatch = 0; iBatch < vBatches.size(); ++iBatch)
+	{
+		if (m_vStaticBatchBuffers[iBatch].Version == vBatches[iBatch].Version) continue;
+
+		UploadStaticBatch(iBatch);
+	}
+}
+
+void CGame::UploadStaticBatch(size_t BatchIndex)
+{
+	const SMesh& Mesh{ m_StaticBatcher.GetBatches()[BatchIndex].Mesh };
+	SStaticBatchBuffers& Buffers{ m_vStaticBatchBuffers[BatchIndex] };
+	Buffers.Version = m_StaticBatcher.GetBatches()[BatchIndex].Version;
+	if (Mesh.vTriangles.empty()) return;
+
+	// @important: buffers grow with slack so that members moving between cells rarely recreate them
+	if (Mesh.vVertices.size() > Buffers.VertexCapacity)
+	{
+		Buffers.VertexCapacity = Mesh.vVertices.size() + Mesh.vVertices.size() / 2;
+
+		D3D11_BUFFER_DESC BufferDesc{};
+		BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(SVertex3D) * Buffers.VertexCapacity);
+		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		BufferDesc.MiscFlags = 0;
+		BufferDesc.StructureByteStride = 0;
+		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		m_RenderDevice->CreateBuffer(BufferDesc, nullptr, Buffers.VertexBuffer.ReleaseAndGetAddressOf());
+	}
+
+	if (Mesh.vTriangles.size() > Buffers.TriangleCapacity)
+	{
+		Buffers.TriangleCapacity = Mesh.vTriangles.size() + Mesh.vTriangles.size() / 2;
+
+		D3D11_BUFFER_DESC BufferDesc{};
+		BufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(STriangle) * Buffers.TriangleCapacity);
+		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		BufferDesc.MiscFlags = 0;
+		BufferDesc.StructureByteStride = 0;
+		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		m_RenderDevice->CreateBuffer(BufferDesc, nullptr, Buffers.IndexBuffer.ReleaseAndGetAddressOf());
+	}
+
+	const size_t KVertexByteSize{ sizeof(SVertex3D) * Mesh.vVertices.size() };
+	if (void* const PtrMappedData{ m_RenderDevice->Map(Buffers.VertexBuffer.Get(), D3D11_MAP_WRITE_DISCARD, KVertexByteSize) })
+	{
+		memcpy(PtrMappedData, &Mesh.vVertices[0], KVertexByteSize);
+
+		m_RenderDevice->Unmap(Buffers.VertexBuffer.Get());
+	}
+
+	const size_t KTriangleByteSize{ sizeof(STriangle) * Mesh.vTriangles.size() };
+	if (void* const PtrMappedData{ m_RenderDevice->Map(Buffers.IndexBuffer.Get(), D3D11_MAP_WRITE_DISCARD, KTriangleByteSize) })
+	{
+		memcpy(PtrMappedData, &Mesh.vTriangles[0], KTriangleByteSize);
+
+		m_RenderDevice->Unmap(Buffers.IndexBuffer.Get());
+	}
+}
+
+void CGame::DrawStaticBatch(size_t BatchIndex)
+{
+	const CStaticBatcher::SBatch& Batch{ m_StaticBatcher.GetBatches()[BatchIndex] };
+
+	// Every member has the same states, so the first one's are used
+	const SStaticBatchMember& Member{ m_vStaticBatchMembers[Batch.vMemberIDs.front()] };
+	CObject3D* const PtrObject3D{ Member.PtrObject3D };
+	const SModel& Model{ PtrObject3D->GetModel() };
+	const CMaterial& Material{ Model.vMaterials[Model.vMeshes[Member.MeshIndex].MaterialID] };
+
+	UpdateObject3D(PtrObject3D);
+	m_cbVSSpaceData.World = XMMatrixTranspose(KMatrixIdentity);
+	m_VSBase->Use(*m_StateTracker);
+	m_VSBase->UpdateAllConstantBuffers();
+
+	UpdatePSBaseMaterial(Material);
+	if (Material.HasTexture()) Material.UseTextures(*m_StateTracker);
+
+	m_StateTracker->SetHullShader(nullptr);
+	m_StateTracker->SetDomainShader(nullptr);
+
+	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoCulling))
+	{
+		m_StateTracker->SetRasterizerState(GetRasterizerState(ERasterizerState::CullNone));
+	}
+	else
+	{
+		SetUniversalRasterizerState();
+	}
+
+	if (EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoDepthComparison))
+	{
+		m_StateTracker->SetDepthStencilState(m_DepthStencilStateNone.Get(), 0);
+	}
+	else
+	{
+		m_StateTracker->SetDepthStencilState(m_DepthStencilStateDefault.Get(), 0);
+	}
+
+	const SStaticBatchBuffers& Buffers{ m_vStaticBatchBuffers[BatchIndex] };
+	m_StateTracker->SetIndexBuffer(Buffers.IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	m_StateTracker->SetVertexBuffer(0, Buffers.VertexBuffer.Get(), sizeof(SVertex3D), 0);
+	m_StateTracker->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals))
+	{
+		UpdateGSSpace();
+
+		m_GSNormal->Use(*m_StateTracker);
+		m_GSNormal->UpdateAllConstantBuffers();
+
+		m_StateTracker->DrawIndexed(static_cast<UINT>(Batch.Mesh.vTriangles.size() * 3), 0, 0);
+
+		m_StateTracker->SetGeometryShader(nullptr);
+	}
+	else
+	{
+		m_StateTracker->DrawIndexed(static_cast<UINT>(Batch.Mesh.vTriangles.size() * 3), 0, 0);
+	}
+	++m_StaticBatchDrawCount;
+}
+
+uint32_t CGame::InternRenderQueueID(unordered_map<uint64_t, uint32_t>& umapIDs, uint64_t Key)
+{
+	auto it{ umapIDs.find(Key) };
+	if (it != umapIDs.end()) return it->second;
+
+	uint32_t ID{ static_cast<uint32_t>(umapIDs.size()) };
+	umapIDs[Key] = ID;
+	return ID;
+}
+
+uint64_t CGame::CalculateRenderSortKey(const CObject3D* const PtrObject3D, size_t MeshIndex, const XMVECTOR& Center, bool bIsTransparent,
+	CShader* const VS, CShader* const PS)
+{
+	static constexpr CMaterial::CTexture::EType KTextureTypes[]{ CMaterial::CTexture::EType::DiffuseTexture,
+		CMaterial::CTexture::EType::NormalTexture, CMaterial::CTexture::EType::DisplacementTexture, CMaterial::CTexture::EType::OpacityTexture };
+	static constexpr uint64_t KHashSeed{ 0xCBF29CE484222325 };
+
+	const SModel& Model{ PtrObject3D->GetModel() };
+
+	// @important: objects with several meshes are sorted by their first mesh's material
+	const CMaterial* PtrMaterial{};
+	if (MeshIndex < Model.vMeshes.size() && Model.vMeshes[MeshIndex].MaterialID < Model.vMaterials.size())
+	{
+		PtrMaterial = &Model.vMaterials[Model.vMeshes[MeshIndex].MaterialID];
+	}
+
+	// Each PSBase variant is a pixel shader of its own
+	uint32_t PSVariantIndex{};
+	if (PS == m_PSBase.get())
+	{
+		EPSBaseFeature eFeatures{ GetPSBaseObjectFeatures(PtrObject3D) };
+		if (PtrMaterial) eFeatures |= GetPSBaseMaterialFeatures(*PtrMaterial);
+		PSVariantIndex = static_cast<uint32_t>(m_PSBasePermutationSet.GetVariantIndex(static_cast<uint32_t>(eFeatures)));
+	}
+
+	const CShader* const Shaders[2]{ VS, PS };
+	uint64_t ShaderKey{ HashRenderQueueKey(KHashSeed, Shaders, sizeof(Shaders)) };
+	ShaderKey = HashRenderQueueKey(ShaderKey, &PSVariantIndex, sizeof(PSVariantIndex));
+	uint32_t ShaderID{ InternRenderQueueID(m_umapRenderQueueShaderIDs, ShaderKey) };
+
+	uint32_t TextureSetID{};
+	uint32_t MaterialID{};
+	if (PtrMaterial)
+	{
+		const CMaterial& Material{ *PtrMaterial };
+
+		// Every object has its own textures, so texture sets are compared by their SRVs (what the state tracker compares)
+		if (Material.HasTexture() && EFLAG_HAS_NO(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoTexture))
+		{
+			uint64_t TextureSetKey{ KHashSeed };
+			for (CMaterial::CTexture::EType eType : KTextureTypes)
+			{
+				CMaterial::CTexture* const PtrTexture{ Material.GetTexture(eType) };
+				const ID3D11ShaderResourceView* const PtrSRV{ (PtrTexture) ? PtrTexture->GetShaderResourceViewPtr() : nullptr };
+				TextureSetKey = HashRenderQueueKey(TextureSetKey, &PtrSRV, sizeof(PtrSRV));
+			}
+			TextureSetID = InternRenderQueueID(m_umapRenderQueueTextureSetIDs, TextureSetKey) + 1;
+		}
+
+		const float MaterialData[]{ Material.GetAmbientColor().x, Material.GetAmbientColor().y, Material.GetAmbientColor().z,
+			Material.GetDiffuseColor().x, Material.GetDiffuseColor().y, Material.GetDiffuseColor().z,
+			Material.GetSpecularColor().x, Material.GetSpecularColor().y, Material.GetSpecularColor().z,
+			Material.GetSpecularExponent(), Material.GetSpecularIntensity() };
+		MaterialID = InternRenderQueueID(m_umapRenderQueueMaterialIDs, HashRenderQueueKey(KHashSeed, MaterialData, sizeof(MaterialData)));
+	}
+
+	float Distance{ XMVectorGetX(XMVector3Length(Center - m_vCameras[m_CurrentCameraIndex].GetEyePosition())) };
+	float NormalizedDepth{ Distance / m_FarZ };
+	if (bIsTransparent) return CRenderQueue::MakeTransparentSortKey(NormalizedDepth, ShaderID, TextureSetID, MaterialID);
+	return CRenderQueue::MakeOpaqueSortKey(ShaderID, TextureSetID, MaterialID, NormalizedDepth);
+}
+
+void CGame::BuildRenderQueue()
+{
+	m_RenderQueue.Clear();
+	m_umapRenderQueueShaderIDs.clear();
+	m_umapRenderQueueTextureSetIDs.clear();
+	m_umapRenderQueueMaterialIDs.clear();
+	m_StaticBatchDrawCount = 0;
+
+	for (size_t iObject3D = 0; iObject3D < m_vObject3Ds.size(); ++iObject3D)
+	{
+		CObject3D* const PtrObject3D{ m_vObject3Ds[iObject3D].get() };
+		ReportObject3DTextureUsage(PtrObject3D);
+
+		// Static batches are queued below
+		if (IsObject3DStaticBatched(PtrObject3D)) continue;
+
+		CShader* VS{};
+		CShader* PS{};
+		SelectObject3DShaders(PtrObject3D, &VS, &PS);
+
+		XMVECTOR Center{ PtrObject3D->ComponentTransform.Translation + PtrObject3D->ComponentPhysics.BoundingSphere.CenterOffset };
+		m_RenderQueue.Add(CalculateRenderSortKey(PtrObject3D, 0, Center, PtrObject3D->ComponentRender.bIsTransparent, VS, PS),
+			static_cast<uint32_t>(iObject3D));
+	}
+
+	const vector<CStaticBatcher::SBatch>& vBatches{ m_StaticBatcher.GetBatches() };
+	for (size_t iBatch = 0; iBatch < vBatches.size(); ++iBatch)
+	{
+		const CStaticBatcher::SBatch& Batch{ vBatches[iBatch] };
+		if (Batch.vMemberIDs.empty()) continue;
+
+		XMVECTOR Center{ XMVectorSetW(XMLoadFloat3(&Batch.BoundingSphereCenter), 1.0f) };
+		if (!CMeshletCuller::IsSphereInFrustum(m_ViewFrustum, Center, Batch.BoundingSphereRadius)) continue;
+
+		const SStaticBatchMember& Member{ m_vStaticBatchMembers[Batch.vMemberIDs.front()] };
+		CShader* VS{};
+		CShader* PS{};
+		SelectObject3DShaders(Member.PtrObject3D, &VS, &PS);
+
+		m_RenderQueue.Add(CalculateRenderSortKey(Member.PtrObject3D, Member.MeshIndex, Center, false, m_VSBase.get(), PS),
+			KRenderQueueStaticBatchFlag | static_cast<uint32_t>(iBatch));
+	}
+
+	m_RenderQueue.Sort();
+}
+
+void CGame::SubmitRenderPacket(const CRenderQueue::SPacket& Packet)
+{
+	if (Packet.ItemIndex & KRenderQueueStaticBatchFlag)
+	{
+		DrawStaticBatch(Packet.ItemIndex & ~KRenderQueueStaticBatchFlag);
+		return;
+	}
+
+	CObject3D* const PtrObject3D{ m_vObject3Ds[Packet.ItemIndex].get() };
+	UpdateObject3D(PtrObject3D);
+	SelectObject3DLOD(PtrObject3D);
+	CullObject3DMeshlets(PtrObject3D);
+	DrawObject3D(PtrObject3D);
+
+	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawBoundingSphere))
+	{
+		DrawObject3DBoundingSphere(PtrObject3D);
+	}
+}
+
+void CGame::DrawObject3DLines()
+{
+	m_VSLine->Use();
+	m_PSLine->Use();
+
+	for (auto& Object3DLine : m_vObject3DLines)
+	{
+		if (Object3DLine)
+		{
+			if (!Object3DLine->bIsVisible) continue;
+
+			Object3DLine->UpdateWorldMatrix();
+
+			m_cbVSSpaceData.World = XMMatrixTranspose(Object3DLine->ComponentTransform.MatrixWorld);
+			m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
+			m_VSLine->UpdateConstantBuffer(0);
+
+			Object3DLine->Draw(*m_StateTracker);
+		}
+	}
+}
+
+void CGame::DrawObject2Ds()
+{
+	m_StateTracker->SetDepthStencilState(m_DepthStencilStateNone.Get(), 0);
+	m_StateTracker->SetBlendState(m_BlendStateNonPremultiplied.Get());
+	
+	m_cbVS2DSpaceData.Projection = XMMatrixTranspose(m_MatrixProjection2D);
+
+	m_VSBase2D->Use();
+	m_PSBase2D->Use();
+
+	for (auto& Object2D : m_vObject2Ds)
+	{
+		if (Object2D)
+		{
+			if (!Object2D->bIsVisible) continue;
+
+			Object2D->UpdateWorldMatrix();
+			m_cbVS2DSpaceData.World = XMMatrixTranspose(Object2D->ComponentTransform.MatrixWorld);
 			m_VSBase2D->UpdateConstantBuffer(0);
 
 			/*
@@ -2183,16 +3135,16 @@ void CGame::DrawObject2Ds()
 			}
 			*/
 
-			Object2D->Draw();
+			Object2D->Draw(*m_StateTracker);
 		}
 	}
 
-	m_DeviceContext->OMSetDepthStencilState(m_CommonStates->DepthDefault(), 0);
+	m_StateTracker->SetDepthStencilState(m_DepthStencilStateDefault.Get(), 0);
 }
 
 void CGame::DrawMiniAxes()
 {
-	m_DeviceContext->RSSetViewports(1, &m_vViewports[1]);
+	m_StateTracker->SetViewport(m_vViewports[1]);
 
 	for (auto& Object3D : m_vObject3DMiniAxes)
 	{
@@ -2206,7 +3158,7 @@ void CGame::DrawMiniAxes()
 		Object3D->UpdateWorldMatrix();
 	}
 
-	m_DeviceContext->RSSetViewports(1, &m_vViewports[0]);
+	m_StateTracker->SetViewport(m_vViewports[0]);
 }
 
 void CGame::UpdatePickingRay()
@@ -2223,11 +3175,11 @@ void CGame::DrawPickingRay()
 	m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
 	m_VSLine->UpdateConstantBuffer(0);
 
-	m_DeviceContext->GSSetShader(nullptr, nullptr, 0);
+	m_StateTracker->SetGeometryShader(nullptr);
 	
 	m_PSLine->Use();
 
-	m_Object3DLinePickingRay->Draw();
+	m_Object3DLinePickingRay->Draw(*m_StateTracker);
 }
 
 void CGame::DrawPickedTriangle()
@@ -2237,7 +3189,7 @@ void CGame::DrawPickedTriangle()
 	m_cbVSSpaceData.ViewProjection = XMMatrixTranspose(m_MatrixView * m_MatrixProjection);
 	m_VSBase->UpdateConstantBuffer(0);
 
-	m_DeviceContext->GSSetShader(nullptr, nullptr, 0);
+	m_StateTracker->SetGeometryShader(nullptr);
 	
 	m_PSVertexColor->Use();
 
@@ -2303,6 +3255,17 @@ void CGame::DrawSky(float DeltaTime)
 	DrawObject3D(m_Object3DMoon.get());
 }
 
+void CGame::UpdateTerrainTessellation()
+{
+	m_cbHSCameraData.EyePosition = m_vCameras[m_CurrentCameraIndex].GetEyePosition();
+	m_cbHSTessFactor.TessFactor = m_Terrain->GetTerrainTessFactor();
+	m_cbHSTessFactor.TessPixelError = m_Terrain->GetTerrainTessPixelError();
+	m_cbHSTessFactor.ProjectionScale = m_WindowSize.y / (2.0f * tanf(m_FOV * 0.5f));
+	m_cbHSTessFactor.TerrainSize = m_Terrain->GetSize();
+
+	m_cbDSSpaceData.ViewProjection = GetTransposedVPMatrix();
+}
+
 void CGame::DrawTerrain()
 {
 	if (!m_Terrain) return;
@@ -2311,38 +3274,237 @@ void CGame::DrawTerrain()
 
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::TessellateTerrain))
 	{
-		m_cbHSCameraData.EyePosition = m_vCameras[m_CurrentCameraIndex].GetEyePosition();
-		m_cbHSTessFactor.TessFactor = m_Terrain->GetTerrainTessFactor();
+		UpdateTerrainTessellation();
 		m_HSTerrain->UpdateAllConstantBuffers();
 		m_HSTerrain->Use();
 
-		m_cbDSSpaceData.ViewProjection = GetTransposedVPMatrix();
 		m_DSTerrain->UpdateAllConstantBuffers();
 		m_DSTerrain->Use();
 
 		m_Terrain->Draw(EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals));
 
-		m_DeviceContext->HSSetShader(nullptr, nullptr, 0);
-		m_DeviceContext->DSSetShader(nullptr, nullptr, 0);
+		m_StateTracker->SetHullShader(nullptr);
+		m_StateTracker->SetDomainShader(nullptr);
 	}
 	else
 	{
 		m_Terrain->Draw(EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals));
 	}
-	
+
+	DrawTerrainTextures();
+}
+
+void CGame::DrawTerrainTextures()
+{
+	if (!m_Terrain) return;
+
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawTerrainHeightMapTexture))
 	{
-		m_DeviceContext->RSSetViewports(1, &m_vViewports[2]);
+		m_StateTracker->SetViewport(m_vViewports[2]);
 		m_Terrain->DrawHeightMapTexture();
 	}
 
 	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawTerrainMaskingTexture))
 	{
-		m_DeviceContext->RSSetViewports(1, &m_vViewports[3]);
+		m_StateTracker->SetViewport(m_vViewports[3]);
 		m_Terrain->DrawMaskingTexture();
 	}
 
-	m_DeviceContext->RSSetViewports(1, &m_vViewports[0]);
+	m_StateTracker->SetViewport(m_vViewports[0]);
+}
+
+void CGame::DrawGrassFields()
+{
+	for (CGrassField* const PtrGrassField : m_vGrassFields)
+	{
+		PtrGrassField->Draw();
+	}
+}
+
+void CGame::DrawParticlePools()
+{
+	if (m_vParticlePools.empty()) return;
+
+	UpdateGSSpace();
+
+	m_StateTracker->BeginTracking();
+	m_StateTracker->SetRasterizerState(GetRasterizerState(ERasterizerState::CullNone));
+	m_StateTracker->SetDepthStencilState(m_DepthStencilStateLessEqualNoWrite.Get(), 0);
+	m_VSParticle->Use(*m_StateTracker);
+	m_GSParticle->Use(*m_StateTracker);
+	m_GSParticle->UpdateAllConstantBuffers();
+	m_PSParticle->Use(*m_StateTracker);
+	for (const CParticlePool* const PtrParticlePool : m_vParticlePools)
+	{
+		PtrParticlePool->Draw(*m_StateTracker);
+	}
+	m_StateTracker->SetGeometryShader(nullptr);
+	m_StateTracker->SetDepthStencilState(m_DepthStencilStateDefault.Get(), 0);
+	SetUniversalRasterizerState();
+	m_StateTracker->EndTracking();
+}
+
+void CGame::PrepareRecording()
+{
+	m_vRecordingJobs.clear();
+	m_vRecordingStaticBatches.clear();
+
+	UpdateGSSpace();
+
+	if (m_Terrain)
+	{
+		UpdateTerrainTessellation();
+
+		m_vRecordingJobs.emplace_back();
+		m_vRecordingJobs.back().eType = ERecordingJob::Terrain;
+	}
+
+	for (size_t iGrassField = 0; iGrassField < m_vGrassFields.size(); ++iGrassField)
+	{
+		const size_t KTileCount{ m_vGrassFields[iGrassField]->GetTileCount() };
+		for (size_t iFirstTile = 0; iFirstTile < KTileCount; iFirstTile += KRecordingJobGrassTileCount)
+		{
+			m_vRecordingJobs.emplace_back();
+			m_vRecordingJobs.back().eType = ERecordingJob::GrassFieldTiles;
+			m_vRecordingJobs.back().Index = iGrassField;
+			m_vRecordingJobs.back().First = iFirstTile;
+			m_vRecordingJobs.back().Count = min(KRecordingJobGrassTileCount, KTileCount - iFirstTile);
+		}
+	}
+
+	// Static batches keep their queue order (the rest of the opaque packets are drawn after them)
+	for (const CRenderQueue::SPacket& Packet : m_RenderQueue.GetPackets())
+	{
+		if (CRenderQueue::GetPass(Packet.SortKey) != CRenderQueue::EPass::Opaque) break;
+		if (Packet.ItemIndex & KRenderQueueStaticBatchFlag) m_vRecordingStaticBatches.emplace_back(Packet.ItemIndex & ~KRenderQueueStaticBatchFlag);
+	}
+	m_StaticBatchDrawCount += m_vRecordingStaticBatches.size();
+	for (size_t iFirst = 0; iFirst < m_vRecordingStaticBatches.size(); iFirst += KRecordingJobStaticBatchCount)
+	{
+		m_vRecordingJobs.emplace_back();
+		m_vRecordingJobs.back().eType = ERecordingJob::StaticBatches;
+		m_vRecordingJobs.back().First = iFirst;
+		m_vRecordingJobs.back().Count = min(KRecordingJobStaticBatchCount, m_vRecordingStaticBatches.size() - iFirst);
+	}
+	m_RecordingOpaqueJobCount = m_vRecordingJobs.size();
+
+	for (size_t iParticlePool = 0; iParticlePool < m_vParticlePools.size(); ++iParticlePool)
+	{
+		m_vParticlePools[iParticlePool]->PrepareRecording();
+
+		m_vRecordingJobs.emplace_back();
+		m_vRecordingJobs.back().eType = ERecordingJob::ParticlePool;
+		m_vRecordingJobs.back().Index = iParticlePool;
+	}
+}
+
+void CGame::RecordJob(size_t JobIndex, CCommandBuffer& CommandBuffer)
+{
+	const SRecordingJob& Job{ m_vRecordingJobs[JobIndex] };
+	CStateTracker StateTracker{ &CommandBuffer };
+	StateTracker.BeginTracking();
+	RecordCommonStates(StateTracker);
+
+	switch (Job.eType)
+	{
+	case ERecordingJob::Terrain:
+		// @important: the only job that changes anything (the terrain's own textures), and there is one of it
+		m_Terrain->Record(CommandBuffer, StateTracker, EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::TessellateTerrain),
+			EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals));
+		break;
+	case ERecordingJob::GrassFieldTiles:
+		for (size_t iTile = Job.First; iTile < Job.First + Job.Count; ++iTile)
+		{
+			m_vGrassFields[Job.Index]->Record(CommandBuffer, StateTracker, iTile);
+		}
+		break;
+	case ERecordingJob::StaticBatches:
+		for (size_t iBatch = Job.First; iBatch < Job.First + Job.Count; ++iBatch)
+		{
+			RecordStaticBatch(CommandBuffer, StateTracker, m_vRecordingStaticBatches[iBatch]);
+		}
+		break;
+	case ERecordingJob::ParticlePool:
+		RecordParticlePool(CommandBuffer, StateTracker, m_vParticlePools[Job.Index]);
+		break;
+	default:
+		break;
+	}
+
+	StateTracker.EndTracking();
+}
+
+void CGame::RecordCommonStates(CStateTracker& StateTracker) const
+{
+	StateTracker.SetSamplerState(EShaderType::PixelShader, 0, m_SamplerLinearWrap.Get());
+	StateTracker.SetSamplerState(EShaderType::DomainShader, 0, m_SamplerLinearWrap.Get());
+	StateTracker.SetBlendState(m_BlendStateNonPremultiplied.Get());
+	StateTracker.SetRasterizerState(GetRasterizerState(m_eRasterizerState));
+	StateTracker.SetDepthStencilState(m_DepthStencilStateDefault.Get(), 0);
+	StateTracker.SetHullShader(nullptr);
+	StateTracker.SetDomainShader(nullptr);
+	StateTracker.SetGeometryShader(nullptr);
+}
+
+void CGame::RecordStaticBatch(CRenderDevice& Device, CStateTracker& StateTracker, size_t BatchIndex) const
+{
+	const CStaticBatcher::SBatch& Batch{ m_StaticBatcher.GetBatches()[BatchIndex] };
+	const SStaticBatchBuffers& Buffers{ m_vStaticBatchBuffers[BatchIndex] };
+	if (!Buffers.IndexBuffer || Batch.Mesh.vTriangles.empty()) return;
+
+	// The same states as DrawStaticBatch()
+	const SStaticBatchMember& Member{ m_vStaticBatchMembers[Batch.vMemberIDs.front()] };
+	const CObject3D* const PtrObject3D{ Member.PtrObject3D };
+	const SModel& Model{ PtrObject3D->GetModel() };
+	const CMaterial& Material{ Model.vMaterials[Model.vMeshes[Member.MeshIndex].MaterialID] };
+
+	m_VSBase->Record(StateTracker);
+	RecordVSSpace(Device, StateTracker, m_VSBase.get(), KMatrixIdentity);
+
+	CShader* VS{};
+	CShader* PS{};
+	SelectObject3DShaders(PtrObject3D, &VS, &PS);
+	if (PS == m_PSBase.get())
+	{
+		PS->Record(StateTracker, static_cast<uint32_t>(GetPSBaseObjectFeatures(PtrObject3D) | GetPSBaseMaterialFeatures(Material)));
+		PS->RecordConstantBuffer(Device, StateTracker, 0);
+		RecordPSBaseMaterial(Device, StateTracker, Material);
+	}
+	else
+	{
+		PS->Record(StateTracker);
+		PS->RecordAllConstantBuffers(Device, StateTracker);
+	}
+	if (Material.HasTexture()) Material.UseTextures(StateTracker);
+
+	StateTracker.SetRasterizerState(GetRasterizerState(EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoCulling) ?
+		ERasterizerState::CullNone : m_eRasterizerState));
+	StateTracker.SetDepthStencilState(EFLAG_HAS(PtrObject3D->eFlagsRendering, CObject3D::EFlagsRendering::NoDepthComparison) ?
+		m_DepthStencilStateNone.Get() : m_DepthStencilStateDefault.Get(), 0);
+
+	StateTracker.SetIndexBuffer(Buffers.IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	StateTracker.SetVertexBuffer(0, Buffers.VertexBuffer.Get(), sizeof(SVertex3D), 0);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::DrawNormals))
+	{
+		m_GSNormal->Record(StateTracker);
+		m_GSNormal->RecordAllConstantBuffers(Device, StateTracker);
+	}
+	StateTracker.DrawIndexed(static_cast<UINT>(Batch.Mesh.vTriangles.size() * 3), 0, 0);
+	StateTracker.SetGeometryShader(nullptr);
+}
+
+void CGame::RecordParticlePool(CRenderDevice& Device, CStateTracker& StateTracker, const CParticlePool* const PtrParticlePool) const
+{
+	StateTracker.SetRasterizerState(GetRasterizerState(ERasterizerState::CullNone));
+	StateTracker.SetDepthStencilState(m_DepthStencilStateLessEqualNoWrite.Get(), 0);
+	m_VSParticle->Record(StateTracker);
+	m_GSParticle->Record(StateTracker);
+	m_GSParticle->RecordAllConstantBuffers(Device, StateTracker);
+	m_PSParticle->Record(StateTracker);
+	PtrParticlePool->Record(StateTracker);
+	StateTracker.SetGeometryShader(nullptr);
 }
 
 void CGame::Interact3DGizmos()
@@ -2751,36 +3913,21 @@ void CGame::Draw3DGizmo(CObject3D* const Gizmo, bool bShouldHighlight)
 
 void CGame::SetUniversalRasterizerState()
 {
-	switch (m_eRasterizerState)
-	{
-	case ERasterizerState::CullNone:
-		m_DeviceContext->RSSetState(m_CommonStates->CullNone());
-		break;
-	case ERasterizerState::CullClockwise:
-		m_DeviceContext->RSSetState(m_CommonStates->CullClockwise());
-		break;
-	case ERasterizerState::CullCounterClockwise:
-		m_DeviceContext->RSSetState(m_CommonStates->CullCounterClockwise());
-		break;
-	case ERasterizerState::WireFrame:
-		m_DeviceContext->RSSetState(m_CommonStates->Wireframe());
-		break;
-	default:
-		break;
-	}
+	m_StateTracker->SetRasterizerState(GetRasterizerState(m_eRasterizerState));
 }
 
-void CGame::SetUniversalbUseLighiting()
+void CGame::EndRendering()
 {
-	if (EFLAG_HAS(m_eFlagsRendering, EFlagsRendering::UseLighting))
-	{
-		m_cbPSBaseFlagsData.bUseLighting = TRUE;
-	}
+	m_TransientUploadRing->EndFrame();
+
+#if defined(_WIN32)
+	if (m_SwapChain) m_SwapChain->Present(0, 0);
+#endif
 }
 
-void CGame::EndRendering()
+void CGame::SetRecordingThreadCount(uint32_t ThreadCount)
 {
-	m_SwapChain->Present(0, 0);
+	m_RecordingThreadCount = ThreadCount;
 }
 
 Keyboard::State CGame::GetKeyState() const
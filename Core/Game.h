@@ -12,7 +12,18 @@
 #include "Object2D.h"
 #include "PrimitiveGenerator.h"
 #include "Terrain.h"
+#include "TextureStreamer.h"
+#include "TextureMipLoader.h"
+#include "StaticBatcher.h"
+#if defined(_WIN32)
+#include "RenderDeviceD3D11.h"
+#endif
+#include "StateTracker.h"
+#include "TransientUploadRing.h"
+#include "RenderQueue.h"
 #include "GrassField.h"
+#include "ParticlePool.h"
+#include "CommandRecorder.h"
 #include "TinyXml2/tinyxml2.h"
 
 enum class EBaseShader
@@ -20,6 +31,9 @@ enum class EBaseShader
 	VSBase,
 	VSInstance,
 	VSAnimation,
+	VSBaseCompressed,
+	VSInstanceCompressed,
+	VSAnimationCompressed,
 	VSSky,
 	VSLine,
 	VSGizmo,
@@ -70,6 +84,32 @@ struct SSkyData
 	SSkyObjectData	Cloud{};
 };
 
+// Member of CStaticBatcher (indexed by member ID)
+struct SStaticBatchMember
+{
+	CObject3D*	PtrObject3D{};
+	size_t		MeshIndex{};
+	uint64_t	Key{}; // Calculated at registration
+};
+
+// An object's members; they are registered again only if what their keys depend on changes
+struct SStaticBatchObject
+{
+	vector<size_t>				vMemberIDs{}; // One per mesh
+	uint32_t					ModelVersion{}; // CObject3D::GetModelVersion() at registration
+	const CShader*				PtrPS{};
+	CObject3D::EFlagsRendering	eFlagsRendering{};
+};
+
+struct SStaticBatchBuffers
+{
+	ComPtr<ID3D11Buffer>	VertexBuffer{};
+	ComPtr<ID3D11Buffer>	IndexBuffer{};
+	size_t					VertexCapacity{};
+	size_t					TriangleCapacity{};
+	uint32_t				Version{}; // CStaticBatcher::SBatch::Version of the uploaded mesh
+};
+
 struct SCBVS2DSpaceData
 {
 	XMMATRIX	Projection{};
@@ -95,7 +135,11 @@ struct SCBHSCameraData
 struct SCBHSTessFactorData
 {
 	float		TessFactor{};
-	float		Pads[3]{};
+	float		TessPixelError{}; // Terrain only (as the rest)
+	float		ProjectionScale{}; // Pixels per world unit at a distance of 1
+	float		Pad{};
+	XMFLOAT2	TerrainSize{};
+	float		Pads[2]{};
 };
 
 struct SCBDSSpaceData
@@ -103,12 +147,6 @@ struct SCBDSSpaceData
 	XMMATRIX	ViewProjection{};
 };
 
-struct SCBDSDisplacementData
-{
-	BOOL		bUseDisplacement{};
-	float		Pads[3]{};
-};
-
 struct SCBGSSpaceData
 {
 	XMMATRIX	ViewProjection{};
@@ -119,13 +157,6 @@ enum class EFlagPSBase2D
 	UseTexture
 };
 
-struct SCBPSBaseFlagsData
-{
-	BOOL		bUseTexture{};
-	BOOL		bUseLighting{};
-	BOOL		Pads[2]{};
-};
-
 struct SCBPSLightsData
 {
 	XMVECTOR	DirectionalLightDirection{ XMVectorSet(0, 1, 0, 0) };
@@ -142,11 +173,7 @@ struct SCBPSBaseMaterialData
 	XMFLOAT3	MaterialDiffuse{};
 	float		SpecularIntensity{ 0 };
 	XMFLOAT3	MaterialSpecular{};
-	BOOL		bHasDiffuseTexture{};
-
-	BOOL		bHasNormalTexture{};
-	BOOL		bHasOpacityTexture{};
-	BOOL		Pad[2]{};
+	float		Pad{};
 };
 
 struct SCBPSSkyTimeData
@@ -163,6 +190,10 @@ struct SCBPSGizmoColorFactorData
 struct SCBPSTerrainSpaceData
 {
 	XMMATRIX	Matrix{};
+	XMFLOAT2	MaskingTextureSize{}; // In texels
+	XMFLOAT2	MaskingAtlasSize{}; // In texels
+	uint32_t	MaskingAtlasSlotCountX{};
+	float		Pads[3]{};
 };
 
 struct SCBPS2DFlagsData
@@ -184,6 +215,23 @@ struct SCBEditorTimeData
 	float		Pads[2]{};
 };
 
+// Feature bits of PSBase.hlsl variants
+enum class EPSBaseFeature : uint32_t
+{
+	None = 0x0,
+	UseTexture = 0x1,
+	UseLighting = 0x2,
+	HasDiffuseTexture = 0x4, // Needs UseTexture
+	HasOpacityTexture = 0x8
+};
+
+// Feature bits of DSTerrain.hlsl variants
+enum class EDSTerrainFeature : uint32_t
+{
+	None = 0x0,
+	UseDisplacement = 0x1
+};
+
 class CGame
 {
 public:
@@ -199,7 +247,9 @@ public:
 		Use3DGizmos = 0x040,
 		TessellateTerrain = 0x080,
 		DrawTerrainHeightMapTexture = 0x100,
-		DrawTerrainMaskingTexture = 0x200
+		DrawTerrainMaskingTexture = 0x200,
+		UseStaticBatching = 0x400,
+		RecordInParallel = 0x800 // The terrain, grass tiles, static batches and particles are recorded by CCommandRecorder jobs
 	};
 
 	enum class ERasterizerState
@@ -236,22 +286,35 @@ public:
 	~CGame() {}
 
 public:
+#if defined(_WIN32)
 	void CreateWin32(WNDPROC const WndProc, LPCTSTR const WindowName, const wstring& FontFileName, bool bWindowed);
+#endif
+	// Without a window nor a swap chain (e.g. on CRenderDeviceNull): frames are drawn into an offscreen target of the window size
+	// Shaders are compiled by ShaderCompiler through the shader cache in ShaderCacheDirectory
+	void CreateHeadless(unique_ptr<CRenderDevice> RenderDevice, unique_ptr<CShaderCompiler> ShaderCompiler, const string& ShaderCacheDirectory);
 	void Destroy();
 
 	void LoadScene(const string& FileName);
 	void SaveScene(const string& FileName);
 
 private:
+#if defined(_WIN32)
 	void CreateWin32Window(WNDPROC const WndProc, LPCTSTR const WindowName);
 	void InitializeDirectX(const wstring& FontFileName, bool bWindowed);
+	void CreateSwapChain(bool bWindowed);
+#endif
+	// Everything but the window, the swap chain and the sprites, on m_RenderDevice
+	void InitializeRendering(const string& ShaderCacheDirectory);
 
 private:
-	void CreateSwapChain(bool bWindowed);
+	void CreateTransientConstantBuffer();
+	void CreateTransientUploadRing();
 	void CreateSetViews();
 	void SetViewports();
 	void CreateDepthStencilStates();
+	void CreateCommonStates();
 	void CreateInputDevices();
+	void CreateShaderPermutationSets();
 	void CreateBaseShaders();
 	void CreateMiniAxes();
 	void CreatePickingRay();
@@ -267,9 +330,7 @@ public:
 	void ToggleGameRenderingFlags(EFlagsRendering Flags);
 	void Set3DGizmoMode(E3DGizmoMode Mode);
 	void SetUniversalRasterizerState();
-	void SetUniversalbUseLighiting();
 	E3DGizmoMode Get3DGizmoMode() { return m_e3DGizmoMode; }
-	CommonStates* GetCommonStates() { return m_CommonStates.get(); }
 
 // Shader-related settings
 public:
@@ -280,18 +341,28 @@ public:
 
 	void UpdateHSTessFactor(float TessFactor);
 
-	void UpdateDSDisplacementData(bool bUseDisplacement);
+	// Selects the DSTerrain variant
+	void UpdateDSTerrainDisplacement(bool bUseDisplacement);
 
 	void UpdateGSSpace();
 	void UpdateGSGrass(const CGrassField::SCBGSGrassData& Data);
 
+	// Also selects the PSBase variant (for the object being drawn, see UpdateObject3D())
 	void UpdatePSBaseMaterial(const CMaterial& Material);
 	void UpdatePSTerrainSpace(const XMMATRIX& Matrix);
+	void UpdatePSTerrainMaskingAtlas(const XMFLOAT2& MaskingTextureSize, const XMFLOAT2& AtlasSize, uint32_t AtlasSlotCountX);
 	void UpdatePSTerrainSelection(const CTerrain::SCBPSTerrainSelectionData& Selection);
-	void UpdatePSGrassFieldFlags(const CGrassField::SCBPSFlags& Data);
 	void UpdatePSBase2DFlagOn(EFlagPSBase2D Flag);
 	void UpdatePSBase2DFlagOff(EFlagPSBase2D Flag);
 
+	// For CCommandRecorder jobs: the constants are built on the stack from the frame's (which don't change while recording)
+	// and written through Device (see CShader::RecordConstantBuffer()), so nothing in the game changes
+	void RecordVSSpace(CRenderDevice& Device, CStateTracker& StateTracker, const CShader* const VS, const XMMATRIX& World) const;
+	void RecordHSTessFactor(CRenderDevice& Device, CStateTracker& StateTracker, const CShader* const HS, float TessFactor) const;
+	void RecordPSBaseMaterial(CRenderDevice& Device, CStateTracker& StateTracker, const CMaterial& Material) const;
+	// For the streamed terrain's tiles, each of which has its own masking texture (see CTerrain::EnableStreaming())
+	void RecordPSTerrainSpace(CRenderDevice& Device, CStateTracker& StateTracker, const XMMATRIX& Matrix, const XMFLOAT2& MaskingTextureSize) const;
+
 public:
 	void SetSky(const string& SkyDataFileName, float ScalingFactor);
 	
@@ -307,6 +378,10 @@ public:
 	void CreateTerrain(const XMFLOAT2& TerrainSize, const CMaterial& Material, float MaskingDetail);
 	void LoadTerrain(const string& TerrainFileName);
 	void SaveTerrain(const string& TerrainFileName);
+	// Streams the terrain from the tiles in Directory, which replace the whole terrain (see CTerrain::EnableStreaming())
+	// "": stops streaming
+	void SetTerrainTileDirectory(const string& Directory, const CTerrainStreamer::SDesc& Desc = CTerrainStreamer::SDesc());
+	const string& GetTerrainTileDirectory() const;
 	void AddTerrainMaterial(const CMaterial& Material);
 	void SetTerrainMaterial(int MaterialID, const CMaterial& Material);
 	CTerrain* GetTerrain() const { return m_Terrain.get(); }
@@ -336,6 +411,10 @@ public:
 	void InsertObject2D(const string& Name);
 	CObject2D* GetObject2D(const string& Name) const;
 
+	// Drawn by Draw() until the game is destroyed, so they must outlive it
+	void AddGrassField(CGrassField* const PtrGrassField);
+	void AddParticlePool(CParticlePool* const PtrParticlePool);
+
 	CMaterial* AddMaterial(const CMaterial& Material);
 	CMaterial* GetMaterial(const string& Name) const;
 	void ClearMaterials();
@@ -386,27 +465,73 @@ public:
 	void Draw(float DeltaTime);
 	void EndRendering();
 
+	// Of CCommandRecorder::Record() while EFlagsRendering::RecordInParallel is set (0: std::thread::hardware_concurrency())
+	void SetRecordingThreadCount(uint32_t ThreadCount);
+
 public:
 	HWND GethWnd() const { return m_hWnd; }
+#if defined(_WIN32)
 	ID3D11Device* GetDevicePtr() const { return m_Device.Get(); }
 	ID3D11DeviceContext* GetDeviceContextPtr() const { return m_DeviceContext.Get(); }
-	Keyboard::State GetKeyState() const;
-	Mouse::State GetMouseState() const;
 	SpriteBatch* GetSpriteBatchPtr() const { return m_SpriteBatch.get(); }
 	SpriteFont* GetSpriteFontPtr() const { return m_SpriteFont.get(); }
+#endif
+	Keyboard::State GetKeyState() const;
+	Mouse::State GetMouseState() const;
 	const XMFLOAT2& GetWindowSize() const;
 	const XMFLOAT2& GetTerrainSelectionPosition() const;
 	float GetSkyTime() const;
 	XMMATRIX GetTransposedVPMatrix() const;
 	ID3D11DepthStencilState* GetDepthStencilStateLessEqualNoWrite() const { return m_DepthStencilStateLessEqualNoWrite.Get(); }
+	ID3D11DepthStencilState* GetDepthStencilStateDefault() const { return m_DepthStencilStateDefault.Get(); }
+	ID3D11DepthStencilState* GetDepthStencilStateNone() const { return m_DepthStencilStateNone.Get(); }
+	ID3D11RasterizerState* GetRasterizerState(ERasterizerState eState) const { return m_RasterizerStates[static_cast<size_t>(eState)].Get(); }
 	ID3D11SamplerState* GetSamplerLinearMirror() const { return m_SamplerLinearMirror.Get(); }
 	const char* GetWorkingDirectory() const { return m_WorkingDirectory; }
+	CTextureStreamer& GetTextureStreamer() { return m_TextureStreamer; }
+	const CTextureStreamer::SStats& GetTextureStreamerStats() const { return m_TextureStreamer.GetStats(); }
+	const CMeshletCuller::SStats& GetMeshletCullerStats() const { return m_MeshletCullerStats; }
+	const CStaticBatcher::SStats& GetStaticBatcherStats() const { return m_StaticBatcher.GetStats(); }
+	size_t GetStaticBatchDrawCount() const { return m_StaticBatchDrawCount; }
+	const CCommandRecorder::SStats& GetCommandRecorderStats() const { return m_CommandRecorder.GetStats(); }
+	CRenderDevice& GetRenderDevice() { return *m_RenderDevice; }
+	CStateTracker& GetStateTracker() { return *m_StateTracker; }
+	const CStateTracker::SStats& GetStateTrackerStats() const { return m_StateTracker->GetStats(); }
+	const CConstantBufferUploader::SStats& GetConstantBufferUploaderStats() const { return m_ConstantBufferUploader->GetStats(); }
+	const CShaderCache::SStats& GetShaderCacheStats() const { return m_ShaderCache->GetStats(); }
+	CTransientUploadRing& GetTransientUploadRing() { return *m_TransientUploadRing; }
+	const CTransientUploadRing::SStats& GetTransientUploadRingStats() const { return m_TransientUploadRing->GetStats(); }
+	float GetTransientUploadRingOccupancy() const { return m_TransientUploadRing->GetOccupancy(); }
 
 private:
+	void SelectObject3DShaders(const CObject3D* const PtrObject3D, CShader** const PtrOutVS, CShader** const PtrOutPS) const;
+	EPSBaseFeature GetPSBaseObjectFeatures(const CObject3D* const PtrObject3D) const;
+	static EPSBaseFeature GetPSBaseMaterialFeatures(const CMaterial& Material);
 	void UpdateObject3D(CObject3D* const PtrObject3D);
 	void DrawObject3D(const CObject3D* const PtrObject3D);
 	void DrawObject3DBoundingSphere(const CObject3D* const PtrObject3D);
 
+	void SelectObject3DLOD(CObject3D* const PtrObject3D);
+	void CullObject3DMeshlets(CObject3D* const PtrObject3D);
+	void ReportObject3DTextureUsage(CObject3D* const PtrObject3D);
+	void UnregisterObject3DTextures(CObject3D* const PtrObject3D);
+	void UpdateTextureStreaming();
+
+	bool IsObject3DStaticBatchable(const CObject3D* const PtrObject3D) const;
+	bool IsObject3DStaticBatched(const CObject3D* const PtrObject3D) const;
+	uint64_t CalculateStaticBatchKey(const CObject3D* const PtrObject3D, size_t MeshIndex) const;
+	void UnbatchObject3D(const CObject3D* const PtrObject3D);
+	void ClearStaticBatches();
+	void UpdateStaticBatches();
+	void UploadStaticBatch(size_t BatchIndex);
+	void DrawStaticBatch(size_t BatchIndex);
+
+	uint32_t InternRenderQueueID(unordered_map<uint64_t, uint32_t>& umapIDs, uint64_t Key);
+	uint64_t CalculateRenderSortKey(const CObject3D* const PtrObject3D, size_t MeshIndex, const XMVECTOR& Center, bool bIsTransparent,
+		CShader* const VS, CShader* const PS);
+	void BuildRenderQueue();
+	void SubmitRenderPacket(const CRenderQueue::SPacket& Packet);
+
 	void DrawObject3DLines();
 
 	void DrawObject2Ds();
@@ -418,7 +543,19 @@ private:
 	void DrawPickedTriangle();
 
 	void DrawSky(float DeltaTime);
+	void UpdateTerrainTessellation();
 	void DrawTerrain();
+	void DrawTerrainTextures();
+	void DrawGrassFields();
+	void DrawParticlePools();
+
+	// Collects the jobs after BuildRenderQueue() and updates what they read (on this thread, since the jobs must not write anything shared)
+	void PrepareRecording();
+	void RecordJob(size_t JobIndex, CCommandBuffer& CommandBuffer);
+	// The states every job sets first (the render target and the viewport are the frame's)
+	void RecordCommonStates(CStateTracker& StateTracker) const;
+	void RecordStaticBatch(CRenderDevice& Device, CStateTracker& StateTracker, size_t BatchIndex) const;
+	void RecordParticlePool(CRenderDevice& Device, CStateTracker& StateTracker, const CParticlePool* const PtrParticlePool) const;
 
 	bool ShouldSelectRotationGizmo(const CObject3D* const Gizmo, E3DGizmoAxis Axis);
 	bool ShouldSelectTranslationScalingGizmo(const CObject3D* const Gizmo, E3DGizmoAxis Axis);
@@ -449,12 +586,19 @@ public:
 	static constexpr float KBSRadiusMinLimit{ 0.001f };
 	static constexpr float KBSRadiusMaxLimit{ 10.0f };
 	static constexpr int KObject3DNameMaxLength{ 100 };
+	static constexpr size_t KMaxStaticBatchMemberTriangleCount{ 4096 }; // Larger objects keep their own LODs and meshlet culling
+	static constexpr uint32_t KRenderQueueStaticBatchFlag{ 0x80000000 }; // Packets of static batches (the rest of ItemIndex is the batch index)
+	static constexpr const char* KShaderCacheDirectory{ "Shader\\Cache" };
+	static constexpr size_t KRecordingJobStaticBatchCount{ 16 };
+	static constexpr size_t KRecordingJobGrassTileCount{ 4 };
 	
 private:
 	static constexpr float KDefaultFOV{ 50.0f / 360.0f * XM_2PI };
 	static constexpr float KDefaultNearZ{ 0.1f };
 	static constexpr float KDefaultFarZ{ 1000.0f };
 	static constexpr float KSkyDistance{ 100.0f };
+	static constexpr size_t KTransientConstantBufferByteSize{ 4 * 1024 * 1024 }; // 16384 draws of 256 bytes per frame before renaming
+	static constexpr size_t KTransientUploadRingByteSize{ 8 * 1024 * 1024 }; // Shared by the frames in flight
 	static constexpr float KSkyTimeFactorAbsolute{ 0.04f };
 	static constexpr float KPickingRayLength{ 1000.0f };
 	static constexpr uint32_t KSkySphereSegmentCount{ 32 };
@@ -470,6 +614,9 @@ private:
 	unique_ptr<CShader>	m_VSBase{};
 	unique_ptr<CShader>	m_VSInstance{};
 	unique_ptr<CShader>	m_VSAnimation{};
+	unique_ptr<CShader>	m_VSBaseCompressed{};
+	unique_ptr<CShader>	m_VSInstanceCompressed{};
+	unique_ptr<CShader>	m_VSAnimationCompressed{};
 	unique_ptr<CShader>	m_VSSky{};
 	unique_ptr<CShader>	m_VSLine{};
 	unique_ptr<CShader>	m_VSGizmo{};
@@ -504,9 +651,17 @@ private:
 	unique_ptr<CShader>	m_PSMasking2D{};
 	unique_ptr<CShader>	m_PSHeightMap2D{};
 
+private:
+	CShaderPermutationSet	m_PSBasePermutationSet{};
+	CShaderPermutationSet	m_DSTerrainPermutationSet{};
+	CShaderPermutationSet	m_PSTerrainPermutationSet{};
+	CShaderPermutationSet	m_PSGrassFieldPermutationSet{};
+	EPSBaseFeature			m_ePSBaseObjectFeatures{}; // Of the object being drawn; materials add their own
+
 private:
 	SCBVSSpaceData				m_cbVSSpaceData{};
 	SCBVSAnimationBonesData		m_cbVSAnimationBonesData{};
+	CVertexCompressor::SCBVSVertexQuantizationData	m_cbVSVertexQuantizationData{};
 	CTerrain::SCBVSTerrainData	m_cbVSTerrainData{};
 
 	SCBVS2DSpaceData			m_cbVS2DSpaceData{};
@@ -515,17 +670,14 @@ private:
 	SCBHSTessFactorData			m_cbHSTessFactor{};
 
 	SCBDSSpaceData				m_cbDSSpaceData{};
-	SCBDSDisplacementData		m_cbDSDisplacementData{};
 
 	SCBGSSpaceData				m_cbGSSpaceData{};
 	CGrassField::SCBGSGrassData m_cbGSGrassData{};
 
 	SCBPSLightsData				m_cbPSLightsData{};
-	SCBPSBaseFlagsData			m_cbPSBaseFlagsData{};
 	SCBPSBaseMaterialData		m_cbPSBaseMaterialData{};
 	SCBPSGizmoColorFactorData	m_cbPSGizmoColorFactorData{};
 	SCBPSSkyTimeData			m_cbPSSkyTimeData{};
-	CGrassField::SCBPSFlags		m_cbPSGrassFieldFlags{};
 	SCBWaterTimeData			m_cbWaterTimeData{};
 
 	SCBPS2DFlagsData					m_cbPS2DFlagsData{};
@@ -595,6 +747,7 @@ private:
 private:
 	XMMATRIX		m_MatrixProjection{};
 	XMMATRIX		m_MatrixProjection2D{};
+	float			m_FOV{};
 	float			m_NearZ{};
 	float			m_FarZ{};
 
@@ -616,16 +769,77 @@ private:
 	EEditMode	m_eEditMode{};
 
 private:
-	unique_ptr<CTerrain>	m_Terrain{};
+	// Outlives the terrain, whose streamer writes its edited tiles to it when it goes
+	unique_ptr<CTerrainTileFileStore>	m_TerrainTileStore{};
+	string								m_TerrainTileDirectory{};
+	unique_ptr<CTerrain>				m_Terrain{};
+
+private:
+	CTextureStreamer					m_TextureStreamer{};
+	CMeshletCuller::SFrustum			m_ViewFrustum{};
+	CMeshletCuller::SStats				m_MeshletCullerStats{};
+	vector<CTextureStreamer::SRequest>	m_vTextureStreamingRequests{};
+	vector<CMaterial::CTexture*>		m_vStreamingTextures{}; // Indexed by streaming ID
+	CTextureMipLoader					m_TextureMipLoader{};
+	vector<CTextureMipLoader::SResult>	m_vTextureMipLoads{};
+
+private:
+	CStaticBatcher										m_StaticBatcher{};
+	vector<SStaticBatchMember>							m_vStaticBatchMembers{}; // Indexed by member ID
+	vector<SStaticBatchBuffers>							m_vStaticBatchBuffers{}; // Indexed by batch index
+	unordered_map<const CObject3D*, SStaticBatchObject>	m_umapObject3DToStaticBatchObjects{};
+	size_t												m_StaticBatchDrawCount{};
+
+private:
+	enum class ERecordingJob
+	{
+		Terrain,
+		GrassFieldTiles, // [First, First + Count) of m_vGrassFields[Index]
+		StaticBatches, // [First, First + Count) of m_vRecordingStaticBatches
+		ParticlePool // m_vParticlePools[Index]
+	};
+
+	struct SRecordingJob
+	{
+		ERecordingJob	eType{};
+		size_t			Index{};
+		size_t			First{};
+		size_t			Count{};
+	};
+
+	vector<CGrassField*>		m_vGrassFields{};
+	vector<CParticlePool*>		m_vParticlePools{};
+	CCommandRecorder			m_CommandRecorder{};
+	uint32_t					m_RecordingThreadCount{};
+	vector<SRecordingJob>		m_vRecordingJobs{}; // The opaque ones come first
+	size_t						m_RecordingOpaqueJobCount{};
+	vector<size_t>				m_vRecordingStaticBatches{}; // Batch indices of the opaque packets, in queue order
+
+private:
+	unique_ptr<CRenderDevice>			m_RenderDevice{};
+	unique_ptr<CStateTracker>			m_StateTracker{};
+	unique_ptr<CConstantBufferUploader>	m_ConstantBufferUploader{};
+	unique_ptr<CShaderCompiler>			m_ShaderCompiler{};
+	unique_ptr<CShaderCache>			m_ShaderCache{};
+	ComPtr<ID3D11Buffer>				m_TransientConstantBuffer{};
+	unique_ptr<CTransientUploadRing>	m_TransientUploadRing{};
+	ComPtr<ID3D11Buffer>				m_TransientUploadRingBuffer{};
+	CRenderQueue						m_RenderQueue{};
+	unordered_map<uint64_t, uint32_t>	m_umapRenderQueueShaderIDs{}; // Rebuilt every frame
+	unordered_map<uint64_t, uint32_t>	m_umapRenderQueueTextureSetIDs{};
+	unordered_map<uint64_t, uint32_t>	m_umapRenderQueueMaterialIDs{};
 
 private:
 	ERasterizerState	m_eRasterizerState{ ERasterizerState::CullCounterClockwise };
 	EFlagsRendering		m_eFlagsRendering{};
 
 private:
+#if defined(_WIN32)
 	ComPtr<IDXGISwapChain>			m_SwapChain{};
 	ComPtr<ID3D11Device>			m_Device{};
 	ComPtr<ID3D11DeviceContext>		m_DeviceContext{};
+#endif
+	ComPtr<ID3D11Texture2D>			m_BackBuffer{}; // Offscreen (headless) or the swap chain's
 	ComPtr<ID3D11RenderTargetView>	m_RenderTargetView{};
 	ComPtr<ID3D11DepthStencilView>	m_DepthStencilView{};
 	ComPtr<ID3D11Texture2D>			m_DepthStencilBuffer{};
@@ -633,13 +847,22 @@ private:
 	ComPtr<ID3D11DepthStencilState>	m_DepthStencilStateAlways{};
 	ComPtr<ID3D11SamplerState>		m_SamplerLinearMirror{};
 
+	// The states DirectXTK's CommonStates would create, created through m_RenderDevice
+	ComPtr<ID3D11RasterizerState>	m_RasterizerStates[4]{}; // Indexed by ERasterizerState
+	ComPtr<ID3D11DepthStencilState>	m_DepthStencilStateDefault{};
+	ComPtr<ID3D11DepthStencilState>	m_DepthStencilStateNone{};
+	ComPtr<ID3D11BlendState>		m_BlendStateNonPremultiplied{};
+	ComPtr<ID3D11SamplerState>		m_SamplerLinearWrap{};
+
 	unique_ptr<Keyboard>			m_Keyboard{};
 	unique_ptr<Mouse>				m_Mouse{};
 	int								m_PrevMouseX{};
 	int								m_PrevMouseY{};
+#if defined(_WIN32)
 	unique_ptr<SpriteBatch>			m_SpriteBatch{};
 	unique_ptr<SpriteFont>			m_SpriteFont{};
-	unique_ptr<CommonStates>		m_CommonStates{};
+#endif
 };
 
-ENUM_CLASS_FLAG(CGame::EFlagsRendering)
\ No newline at end of file
+ENUM_CLASS_FLAG(CGame::EFlagsRendering)
+ENUM_CLASS_FLAG(EPSBaseFeature)
\ No newline at end of file
@@ -0,0 +1,510 @@
+#include "GeometryProcessor.h"
+#include <thread>
+
+static constexpr uint32_t KInvalidIndex{ UINT32_MAX };
+
+static uint32_t GetThreadCount(const CGeometryProcessor::SDesc& Desc)
+{
+	uint32_t ThreadCount{ (Desc.ThreadCount) ? Desc.ThreadCount : std::thread::hardware_concurrency() };
+	return max(ThreadCount, (uint32_t)1);
+}
+
+// Splits [0, Count) into contiguous ranges (one per thread) and calls Function(Begin, End) for each of them
+// Function must only write to its own range
+template<typename TFunction>
+static void ParallelFor(size_t Count, uint32_t ThreadCount, const TFunction& Function)
+{
+	static constexpr size_t KMinRangeSize{ 4096 };
+
+	size_t RangeCount{ min(static_cast<size_t>(ThreadCount), (Count + KMinRangeSize - 1) / KMinRangeSize) };
+	if (RangeCount <= 1)
+	{
+		Function(static_cast<size_t>(0), Count);
+		return;
+	}
+
+	size_t RangeSize{ (Count + RangeCount - 1) / RangeCount };
+	vector<std::thread> vThreads{};
+	for (size_t iRange = 1; iRange < RangeCount; ++iRange)
+	{
+		size_t Begin{ min(iRange * RangeSize, Count) };
+		size_t End{ min(Begin + RangeSize, Count) };
+		vThreads.emplace_back([&Function, Begin, End]() { Function(Begin, End); });
+	}
+	Function(static_cast<size_t>(0), RangeSize);
+
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+}
+
+static size_t GetHashTableSize(size_t Count)
+{
+	size_t Size{ 16 };
+	while (Size < Count * 2) Size <<= 1;
+	return Size;
+}
+
+static uint64_t HashCell(int64_t X, int64_t Y, int64_t Z)
+{
+	uint64_t Hash{ static_cast<uint64_t>(X) * 0x9E3779B97F4A7C15ull };
+	Hash ^= static_cast<uint64_t>(Y) * 0xC2B2AE3D27D4EB4Full + (Hash << 6) + (Hash >> 2);
+	Hash ^= static_cast<uint64_t>(Z) * 0x165667B19E3779F9ull + (Hash << 6) + (Hash >> 2);
+	return Hash ^ (Hash >> 29);
+}
+
+static uint64_t HashKey(const int32_t* const PtrKey, size_t Stride)
+{
+	uint64_t Hash{ 0xCBF29CE484222325ull };
+	for (size_t iValue = 0; iValue < Stride; ++iValue)
+	{
+		Hash = (Hash ^ static_cast<uint32_t>(PtrKey[iValue])) * 0x100000001B3ull;
+	}
+	return Hash ^ (Hash >> 32);
+}
+
+static int32_t Quantize(float Value, float InverseStep)
+{
+	static constexpr float KLimit{ 2'000'000'000.0f };
+	return static_cast<int32_t>(max(min(floorf(Value * InverseStep + 0.5f), KLimit), -KLimit));
+}
+
+// Assigns the same ID to equal keys (rows of Stride values), in the order of first occurrence
+static size_t AssignKeyIDs(const vector<int32_t>& vKeys, size_t Stride, vector<uint32_t>& vOutIDs)
+{
+	const size_t KKeyCount{ vKeys.size() / Stride };
+	vector<uint32_t> vTable(GetHashTableSize(KKeyCount), KInvalidIndex); // Index of the first key of each ID
+	const size_t KTableMask{ vTable.size() - 1 };
+
+	vOutIDs.resize(KKeyCount);
+	size_t IDCount{};
+	for (size_t iKey = 0; iKey < KKeyCount; ++iKey)
+	{
+		const int32_t* const PtrKey{ &vKeys[iKey * Stride] };
+		size_t Slot{ HashKey(PtrKey, Stride) & KTableMask };
+		while (vTable[Slot] != KInvalidIndex && memcmp(&vKeys[vTable[Slot] * Stride], PtrKey, sizeof(int32_t) * Stride) != 0)
+		{
+			Slot = (Slot + 1) & KTableMask;
+		}
+
+		if (vTable[Slot] == KInvalidIndex)
+		{
+			vTable[Slot] = static_cast<uint32_t>(iKey);
+			vOutIDs[iKey] = static_cast<uint32_t>(IDCount++);
+		}
+		else
+		{
+			vOutIDs[iKey] = vOutIDs[vTable[Slot]];
+		}
+	}
+	return IDCount;
+}
+
+// Groups corners (3 per triangle) by vCornerGroupIDs with a counting sort (CSR)
+static void BuildCornerLists(const vector<uint32_t>& vCornerGroupIDs, size_t GroupCount,
+	vector<uint32_t>& vOutOffsets, vector<uint32_t>& vOutCorners)
+{
+	vOutOffsets.assign(GroupCount + 1, 0);
+	for (uint32_t GroupID : vCornerGroupIDs)
+	{
+		++vOutOffsets[GroupID + 1];
+	}
+	for (size_t iGroup = 0; iGroup < GroupCount; ++iGroup)
+	{
+		vOutOffsets[iGroup + 1] += vOutOffsets[iGroup];
+	}
+
+	vOutCorners.resize(vCornerGroupIDs.size());
+	vector<uint32_t> vCursors(vOutOffsets.begin(), vOutOffsets.end() - 1);
+	for (size_t iCorner = 0; iCorner < vCornerGroupIDs.size(); ++iCorner)
+	{
+		vOutCorners[vCursors[vCornerGroupIDs[iCorner]]++] = static_cast<uint32_t>(iCorner);
+	}
+}
+
+static void CalculateCornerAngles(const XMVECTOR& P0, const XMVECTOR& P1, const XMVECTOR& P2, float (&OutAngles)[3])
+{
+	XMVECTOR Edge01{ XMVector3Normalize(P1 - P0) };
+	XMVECTOR Edge02{ XMVector3Normalize(P2 - P0) };
+	XMVECTOR Edge12{ XMVector3Normalize(P2 - P1) };
+
+	OutAngles[0] = acosf(max(min(XMVectorGetX(XMVector3Dot(Edge01, Edge02)), 1.0f), -1.0f));
+	OutAngles[1] = acosf(max(min(-XMVectorGetX(XMVector3Dot(Edge01, Edge12)), 1.0f), -1.0f));
+	OutAngles[2] = max(XM_PI - OutAngles[0] - OutAngles[1], 0.0f);
+}
+
+static uint32_t GetCornerVertex(const STriangle& Triangle, size_t iCorner)
+{
+	return (iCorner == 0) ? Triangle.I0 : (iCorner == 1) ? Triangle.I1 : Triangle.I2;
+}
+
+static void FillStats(CGeometryProcessor::SStats* const PtrOutStats, const SMesh& Mesh, size_t VertexCountBefore, size_t PositionCount,
+	uint32_t ThreadCount, ULONGLONG StartTimePoint)
+{
+	if (!PtrOutStats) return;
+
+	CGeometryProcessor::SStats Stats{};
+	Stats.TriangleCount = Mesh.vTriangles.size();
+	Stats.VertexCountBefore = VertexCountBefore;
+	Stats.VertexCountAfter = Mesh.vVertices.size();
+	Stats.PositionCount = PositionCount;
+	Stats.ThreadCount = ThreadCount;
+	Stats.ElapsedMilliseconds = GetTickCount64() - StartTimePoint;
+	Stats.MegaTrianglesPerSecond = static_cast<float>(Stats.TriangleCount) / 1'000.0f / static_cast<float>(max(Stats.ElapsedMilliseconds, (ULONGLONG)1));
+
+	*PtrOutStats = Stats;
+}
+
+size_t CGeometryProcessor::WeldPositions(const vector<SVertex3D>& vVertices, float Epsilon, vector<uint32_t>& vOutPositionIDs)
+{
+	struct SCell
+	{
+		int64_t		X{};
+		int64_t		Y{};
+		int64_t		Z{};
+		uint32_t	FirstVertex{ KInvalidIndex };
+	};
+
+	const size_t KVertexCount{ vVertices.size() };
+	const bool KbShouldSearchNeighbors{ Epsilon > 0.0f };
+	const float KInverseCellSize{ 1.0f / max(Epsilon, KDefaultWeldEpsilon) };
+	const float KEpsilonSquare{ Epsilon * Epsilon };
+
+	vector<SCell> vCells(GetHashTableSize(KVertexCount));
+	const size_t KCellMask{ vCells.size() - 1 };
+	vector<uint32_t> vNextVertices(KVertexCount, KInvalidIndex); // Chains the representative vertices of a cell
+
+	auto FindCell{ [&](int64_t X, int64_t Y, int64_t Z) -> SCell&
+	{
+		size_t Slot{ HashCell(X, Y, Z) & KCellMask };
+		while (vCells[Slot].FirstVertex != KInvalidIndex && (vCells[Slot].X != X || vCells[Slot].Y != Y || vCells[Slot].Z != Z))
+		{
+			Slot = (Slot + 1) & KCellMask;
+		}
+		return vCells[Slot];
+	} };
+
+	vOutPositionIDs.resize(KVertexCount);
+	size_t PositionCount{};
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		const XMVECTOR& Position{ vVertices[iVertex].Position };
+		const int64_t X{ static_cast<int64_t>(floorf(XMVectorGetX(Position) * KInverseCellSize)) };
+		const int64_t Y{ static_cast<int64_t>(floorf(XMVectorGetY(Position) * KInverseCellSize)) };
+		const int64_t Z{ static_cast<int64_t>(floorf(XMVectorGetZ(Position) * KInverseCellSize)) };
+
+		// Own cell first (exact duplicates are the common case), then the 26 neighbors
+		uint32_t Found{ KInvalidIndex };
+		const int KCellCount{ (KbShouldSearchNeighbors) ? 27 : 1 };
+		for (int iCell = 0; iCell < KCellCount && Found == KInvalidIndex; ++iCell)
+		{
+			int Offset{ (iCell + 13) % 27 };
+			const SCell& Cell{ FindCell(X + Offset % 3 - 1, Y + (Offset / 3) % 3 - 1, Z + Offset / 9 - 1) };
+			for (uint32_t iCandidate = Cell.FirstVertex; iCandidate != KInvalidIndex; iCandidate = vNextVertices[iCandidate])
+			{
+				XMVECTOR Difference{ XMVectorSetW(Position - vVertices[iCandidate].Position, 0) };
+				if (XMVectorGetX(XMVector3LengthSq(Difference)) <= KEpsilonSquare)
+				{
+					Found = iCandidate;
+					break;
+				}
+			}
+		}
+
+		if (Found != KInvalidIndex)
+		{
+			vOutPositionIDs[iVertex] = vOutPositionIDs[Found];
+		}
+		else
+		{
+			SCell& Cell{ FindCell(X, Y, Z) };
+			Cell.X = X;
+			Cell.Y = Y;
+			Cell.Z = Z;
+			vNextVertices[iVertex] = Cell.FirstVertex;
+			Cell.FirstVertex = static_cast<uint32_t>(iVertex);
+
+			vOutPositionIDs[iVertex] = static_cast<uint32_t>(PositionCount++);
+		}
+	}
+	return PositionCount;
+}
+
+void CGeometryProcessor::WeldVertices(SMesh& Mesh, const SDesc& Desc, SStats* const PtrOutStats)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	const uint32_t KThreadCount{ GetThreadCount(Desc) };
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const bool KbHasAnimation{ Mesh.vVerticesAnimation.size() == KVertexCount && KVertexCount };
+
+	vector<uint32_t> vPositionIDs{};
+	size_t PositionCount{ WeldPositions(Mesh.vVertices, Desc.WeldEpsilon, vPositionIDs) };
+
+	// Position ID + color 4 + texcoord 3 + normal 3 + tangent 3 + bitangent 3 (+ bone IDs 4 + weights 4)
+	const size_t KStride{ (KbHasAnimation) ? 25u : 17u };
+	const float KInverseStep{ 1.0f / KAttributeEpsilon };
+	vector<int32_t> vKeys(KVertexCount * KStride);
+	ParallelFor(KVertexCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+		{
+			const SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+			int32_t* PtrKey{ &vKeys[iVertex * KStride] };
+			*PtrKey++ = static_cast<int32_t>(vPositionIDs[iVertex]);
+
+			XMFLOAT4 Values[5]{};
+			XMStoreFloat4(&Values[0], Vertex.Color);
+			XMStoreFloat4(&Values[1], Vertex.TexCoord);
+			XMStoreFloat4(&Values[2], Vertex.Normal);
+			XMStoreFloat4(&Values[3], Vertex.Tangent);
+			XMStoreFloat4(&Values[4], Vertex.Bitangent);
+			*PtrKey++ = Quantize(Values[0].w, KInverseStep);
+			for (const XMFLOAT4& Value : Values)
+			{
+				*PtrKey++ = Quantize(Value.x, KInverseStep);
+				*PtrKey++ = Quantize(Value.y, KInverseStep);
+				*PtrKey++ = Quantize(Value.z, KInverseStep);
+			}
+
+			if (KbHasAnimation)
+			{
+				const SVertexAnimation& VertexAnimation{ Mesh.vVerticesAnimation[iVertex] };
+				for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight)
+				{
+					*PtrKey++ = static_cast<int32_t>(VertexAnimation.BoneIDs[iWeight]);
+					*PtrKey++ = Quantize(VertexAnimation.Weights[iWeight], KInverseStep);
+				}
+			}
+		}
+	});
+
+	vector<uint32_t> vVertexIDs{};
+	size_t VertexCount{ AssignKeyIDs(vKeys, KStride, vVertexIDs) };
+
+	if (VertexCount < KVertexCount)
+	{
+		// IDs are assigned in the order of first occurrence, so the first vertex of each ID is kept
+		vector<SVertex3D> vVertices{};
+		vector<SVertexAnimation> vVerticesAnimation{};
+		vVertices.reserve(VertexCount);
+		if (KbHasAnimation) vVerticesAnimation.reserve(VertexCount);
+		for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+		{
+			if (vVertexIDs[iVertex] != vVertices.size()) continue;
+
+			vVertices.emplace_back(Mesh.vVertices[iVertex]);
+			if (KbHasAnimation) vVerticesAnimation.emplace_back(Mesh.vVerticesAnimation[iVertex]);
+		}
+
+		ParallelFor(Mesh.vTriangles.size(), KThreadCount, [&](size_t Begin, size_t End)
+		{
+			for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+			{
+				STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+				Triangle.I0 = vVertexIDs[Triangle.I0];
+				Triangle.I1 = vVertexIDs[Triangle.I1];
+				Triangle.I2 = vVertexIDs[Triangle.I2];
+			}
+		});
+
+		Mesh.vVertices = std::move(vVertices);
+		if (KbHasAnimation) Mesh.vVerticesAnimation = std::move(vVerticesAnimation);
+	}
+
+	FillStats(PtrOutStats, Mesh, KVertexCount, PositionCount, KThreadCount, StartTimePoint);
+}
+
+void CGeometryProcessor::CalculateNormals(SMesh& Mesh, const SDesc& Desc, SStats* const PtrOutStats)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	const uint32_t KThreadCount{ GetThreadCount(Desc) };
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+
+	vector<uint32_t> vPositionIDs{};
+	size_t PositionCount{ WeldPositions(Mesh.vVertices, Desc.WeldEpsilon, vPositionIDs) };
+
+	// Angle-weighted face normal of every corner
+	vector<XMFLOAT3> vCornerNormals(KTriangleCount * 3);
+	vector<uint32_t> vCornerPositionIDs(KTriangleCount * 3);
+	ParallelFor(KTriangleCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			const XMVECTOR& P0{ Mesh.vVertices[Triangle.I0].Position };
+			const XMVECTOR& P1{ Mesh.vVertices[Triangle.I1].Position };
+			const XMVECTOR& P2{ Mesh.vVertices[Triangle.I2].Position };
+
+			XMVECTOR FaceNormal{ XMVector3Normalize(XMVector3Cross(P1 - P0, P2 - P0)) };
+			float Angles[3]{};
+			CalculateCornerAngles(P0, P1, P2, Angles);
+
+			for (size_t iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				XMStoreFloat3(&vCornerNormals[iTriangle * 3 + iCorner], FaceNormal * Angles[iCorner]);
+				vCornerPositionIDs[iTriangle * 3 + iCorner] = vPositionIDs[GetCornerVertex(Triangle, iCorner)];
+			}
+		}
+	});
+
+	vector<uint32_t> vOffsets{};
+	vector<uint32_t> vCorners{};
+	BuildCornerLists(vCornerPositionIDs, PositionCount, vOffsets, vCorners);
+
+	// Gather (instead of scattering with atomics) so that the sum order never depends on the thread count
+	vector<XMFLOAT3> vPositionNormals(PositionCount);
+	ParallelFor(PositionCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iPosition = Begin; iPosition < End; ++iPosition)
+		{
+			XMVECTOR NormalSum{};
+			for (uint32_t iCorner = vOffsets[iPosition]; iCorner < vOffsets[iPosition + 1]; ++iCorner)
+			{
+				NormalSum += XMLoadFloat3(&vCornerNormals[vCorners[iCorner]]);
+			}
+			XMStoreFloat3(&vPositionNormals[iPosition], XMVector3Normalize(NormalSum));
+		}
+	});
+
+	ParallelFor(KVertexCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+		{
+			XMVECTOR Normal{ XMLoadFloat3(&vPositionNormals[vPositionIDs[iVertex]]) };
+
+			// @important: unreferenced vertices keep their normals
+			if (XMVector3Equal(Normal, XMVectorZero())) continue;
+			Mesh.vVertices[iVertex].Normal = Normal;
+		}
+	});
+
+	FillStats(PtrOutStats, Mesh, KVertexCount, PositionCount, KThreadCount, StartTimePoint);
+}
+
+void CGeometryProcessor::CalculateTangents(SMesh& Mesh, const SDesc& Desc, SStats* const PtrOutStats)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	const uint32_t KThreadCount{ GetThreadCount(Desc) };
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+	const size_t KTriangleCount{ Mesh.vTriangles.size() };
+
+	vector<uint32_t> vPositionIDs{};
+	size_t PositionCount{ WeldPositions(Mesh.vVertices, Desc.WeldEpsilon, vPositionIDs) };
+
+	// Vertices that share position, normal and texture coordinate share a tangent frame
+	static constexpr size_t KStride{ 6 };
+	const float KInverseStep{ 1.0f / KAttributeEpsilon };
+	vector<int32_t> vKeys(KVertexCount * KStride);
+	ParallelFor(KVertexCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+		{
+			const SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+			XMVECTOR Normal{ XMVector3Normalize(Vertex.Normal) };
+			int32_t* const PtrKey{ &vKeys[iVertex * KStride] };
+			PtrKey[0] = static_cast<int32_t>(vPositionIDs[iVertex]);
+			PtrKey[1] = Quantize(XMVectorGetX(Normal), KInverseStep);
+			PtrKey[2] = Quantize(XMVectorGetY(Normal), KInverseStep);
+			PtrKey[3] = Quantize(XMVectorGetZ(Normal), KInverseStep);
+			PtrKey[4] = Quantize(XMVectorGetX(Vertex.TexCoord), KInverseStep);
+			PtrKey[5] = Quantize(XMVectorGetY(Vertex.TexCoord), KInverseStep);
+		}
+	});
+
+	vector<uint32_t> vFrameIDs{};
+	size_t FrameCount{ AssignKeyIDs(vKeys, KStride, vFrameIDs) };
+
+	// Angle-weighted face tangent of every corner, projected onto the plane of the vertex normal
+	// Mirrored corners (negative handedness) are accumulated separately: group = frame ID * 2 + (is mirrored)
+	vector<XMFLOAT4> vCornerTangents(KTriangleCount * 3); // w: weight
+	vector<uint32_t> vCornerGroupIDs(KTriangleCount * 3);
+	ParallelFor(KTriangleCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			const SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
+			const SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
+			const SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
+
+			XMVECTOR Edge01{ V1.Position - V0.Position };
+			XMVECTOR Edge02{ V2.Position - V0.Position };
+
+			float U01{ XMVectorGetX(V1.TexCoord - V0.TexCoord) };
+			float V01{ XMVectorGetY(V1.TexCoord - V0.TexCoord) };
+			float U02{ XMVectorGetX(V2.TexCoord - V0.TexCoord) };
+			float V02{ XMVectorGetY(V2.TexCoord - V0.TexCoord) };
+
+			// See CalculateTangents() in PrimitiveGenerator.h
+			float Determinant{ U01 * V02 - V01 * U02 };
+			bool bIsDegenerate{ fabsf(Determinant) < FLT_EPSILON * FLT_EPSILON };
+			float InverseDeterminant{ (bIsDegenerate) ? 0.0f : 1.0f / Determinant };
+			XMVECTOR FaceTangent{ (V02 * Edge01 - V01 * Edge02) * InverseDeterminant };
+			XMVECTOR FaceBitangent{ (U01 * Edge02 - U02 * Edge01) * InverseDeterminant };
+
+			float Angles[3]{};
+			CalculateCornerAngles(V0.Position, V1.Position, V2.Position, Angles);
+
+			for (size_t iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				const uint32_t KVertex{ GetCornerVertex(Triangle, iCorner) };
+				XMVECTOR Normal{ XMVector3Normalize(Mesh.vVertices[KVertex].Normal) };
+				XMVECTOR Tangent{ XMVector3Normalize(FaceTangent - Normal * XMVector3Dot(Normal, FaceTangent)) };
+				bool bIsMirrored{ XMVectorGetX(XMVector3Dot(XMVector3Cross(Normal, FaceTangent), FaceBitangent)) < 0.0f };
+				float Weight{ (bIsDegenerate) ? 0.0f : Angles[iCorner] };
+
+				XMStoreFloat4(&vCornerTangents[iTriangle * 3 + iCorner], XMVectorSetW(Tangent * Weight, Weight));
+				vCornerGroupIDs[iTriangle * 3 + iCorner] = vFrameIDs[KVertex] * 2 + ((bIsMirrored) ? 1 : 0);
+			}
+		}
+	});
+
+	vector<uint32_t> vOffsets{};
+	vector<uint32_t> vCorners{};
+	BuildCornerLists(vCornerGroupIDs, FrameCount * 2, vOffsets, vCorners);
+
+	vector<XMFLOAT4> vGroupTangents(FrameCount * 2); // w: weight sum
+	ParallelFor(FrameCount * 2, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iGroup = Begin; iGroup < End; ++iGroup)
+		{
+			XMVECTOR TangentSum{};
+			for (uint32_t iCorner = vOffsets[iGroup]; iCorner < vOffsets[iGroup + 1]; ++iCorner)
+			{
+				TangentSum += XMLoadFloat4(&vCornerTangents[vCorners[iCorner]]);
+			}
+			XMStoreFloat4(&vGroupTangents[iGroup], TangentSum);
+		}
+	});
+
+	ParallelFor(KVertexCount, KThreadCount, [&](size_t Begin, size_t End)
+	{
+		for (size_t iVertex = Begin; iVertex < End; ++iVertex)
+		{
+			// A vertex that is used by both mirrored and non-mirrored triangles takes the dominant handedness
+			const XMFLOAT4& Right{ vGroupTangents[vFrameIDs[iVertex] * 2 + 0] };
+			const XMFLOAT4& Mirrored{ vGroupTangents[vFrameIDs[iVertex] * 2 + 1] };
+			bool bIsMirrored{ Mirrored.w > Right.w };
+			const XMFLOAT4& Group{ (bIsMirrored) ? Mirrored : Right };
+			if (Group.w <= 0.0f) continue;
+
+			SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+			XMVECTOR Normal{ XMVector3Normalize(Vertex.Normal) };
+			XMVECTOR Tangent{ XMVectorSet(Group.x, Group.y, Group.z, 0) };
+
+			// Gram-Schmidt
+			Tangent = XMVector3Normalize(Tangent - Normal * XMVector3Dot(Normal, Tangent));
+			if (XMVector3Equal(Tangent, XMVectorZero())) continue;
+
+			Vertex.Tangent = Tangent;
+			Vertex.Bitangent = XMVector3Cross(Normal, Tangent) * ((bIsMirrored) ? -1.0f : 1.0f);
+		}
+	});
+
+	FillStats(PtrOutStats, Mesh, KVertexCount, PositionCount, KThreadCount, StartTimePoint);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AssimpLoader.h"
+
+// Welds vertices with a spatial hash and generates smooth normals and tangents in parallel over triangle ranges
+// Every pass is deterministic (threads only write to their own ranges and results are gathered, not scattered)
+class CGeometryProcessor
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+
+		float		WeldEpsilon{ KDefaultWeldEpsilon }; // Positions closer than this are treated as the same position
+		uint32_t	ThreadCount{}; // 0: std::thread::hardware_concurrency()
+	};
+
+	struct SStats
+	{
+		size_t		TriangleCount{};
+		size_t		VertexCountBefore{};
+		size_t		VertexCountAfter{};
+		size_t		PositionCount{}; // Unique positions after welding
+		uint32_t	ThreadCount{};
+		ULONGLONG	ElapsedMilliseconds{};
+		float		MegaTrianglesPerSecond{};
+	};
+
+public:
+	// Returns the number of unique positions; vOutPositionIDs maps each vertex to [0, unique position count)
+	// IDs are assigned in the order of first occurrence
+	static size_t WeldPositions(const vector<SVertex3D>& vVertices, float Epsilon, vector<uint32_t>& vOutPositionIDs);
+
+	// Merges vertices that share a (welded) position and all other attributes (vVerticesAnimation is merged along)
+	static void WeldVertices(SMesh& Mesh, const SDesc& Desc = SDesc(), SStats* const PtrOutStats = nullptr);
+
+	// Angle-weighted face normals, accumulated over every vertex that shares the (welded) position
+	static void CalculateNormals(SMesh& Mesh, const SDesc& Desc = SDesc(), SStats* const PtrOutStats = nullptr);
+
+	// MikkTSpace-style: angle-weighted face tangents projected onto the vertex normal, accumulated over vertices that share
+	// position, normal, texture coordinate and handedness; Bitangent = cross(Normal, Tangent) * handedness
+	// Normals must be calculated beforehand
+	static void CalculateTangents(SMesh& Mesh, const SDesc& Desc = SDesc(), SStats* const PtrOutStats = nullptr);
+
+public:
+	static constexpr float KDefaultWeldEpsilon{ 0.00001f };
+	static constexpr float KAttributeEpsilon{ 0.0001f }; // Quantization step of normals, texture coordinates and colors
+};
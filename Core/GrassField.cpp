@@ -1,6 +1,9 @@
 #include "GrassField.h"
 #include "Game.h"
 
+// Taken by address (CShader::Create()), so it needs a definition before C++17
+constexpr D3D11_INPUT_ELEMENT_DESC CGrassField::KInputElementDescs[];
+
 void CGrassField::Create(size_t BladeCount, float MinBladeLength, float MaxBladeLength, float BladeWidth, 
 	float MinBendingAngleRadian, float MaxBendingAngleRadian, float BladeDisplacementFromCenter,
 	const XMVECTOR& GroundSegmentColor, const XMVECTOR& TipSegmentColor, const char* BladeTextureFileName)
@@ -44,20 +47,20 @@ void CGrassField::Create(size_t BladeCount, float MinBladeLength, float MaxBlade
 
 	if (BladeTextureFileName)
 	{
-		m_BladeTexture.CreateTextureFromFile(BladeTextureFileName, true);
-		m_cbPSFlags.bUseTexture = TRUE;
-		m_PtrGame->UpdatePSGrassFieldFlags(m_cbPSFlags);
+		m_BladeTexture.CreateAlphaTestedTextureFromFile(BladeTextureFileName, KBladeAlphaReference);
+		m_ePSFeatures = EPSFeature::UseTexture;
 	}
 }
 
 void CGrassField::Draw()
 {
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
 	m_PtrGame->UpdateVSSpace(XMMatrixIdentity());
 	m_PtrGame->UpdateGSSpace();
 
 	if (m_BladeTexture.IsCreated())
 	{
-		m_BladeTexture.Use();
+		m_BladeTexture.Use(StateTracker);
 	}
 
 	CShader* const VS{ m_PtrGame->GetBaseShader(EBaseShader::VSGrassField) };
@@ -71,16 +74,53 @@ void CGrassField::Draw()
 	GS->Use();
 
 	PS->UpdateAllConstantBuffers();
+	PS->SetPermutation(static_cast<uint32_t>(m_ePSFeatures));
 	PS->Use();
 
-	ID3D11SamplerState* SamplerState{ m_PtrGame->GetSamplerLinearMirror() };
-	m_PtrDeviceContext->PSSetSamplers(0, 1, &SamplerState);
+	StateTracker.SetSamplerState(EShaderType::PixelShader, 0, m_PtrGame->GetSamplerLinearMirror());
 	
-	m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_VertexBufferSet.Buffer.GetAddressOf(), &m_VertexBufferSet.Stride, &m_VertexBufferSet.Offset);
-	m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-	m_PtrDeviceContext->Draw(static_cast<UINT>(m_vVertices.size()), 0);
+	StateTracker.SetVertexBuffer(0, m_VertexBufferSet.Buffer.Get(), m_VertexBufferSet.Stride, m_VertexBufferSet.Offset);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	StateTracker.Draw(static_cast<UINT>(m_vVertices.size()), 0);
+
+	StateTracker.SetGeometryShader(nullptr);
+}
+
+size_t CGrassField::GetTileCount() const
+{
+	return (m_vVertices.size() + KTileBladeCount - 1) / KTileBladeCount;
+}
+
+void CGrassField::Record(CRenderDevice& Device, CStateTracker& StateTracker, size_t TileIndex) const
+{
+	const size_t KFirstBlade{ TileIndex * KTileBladeCount };
+	if (KFirstBlade >= m_vVertices.size()) return;
+
+	if (m_BladeTexture.IsCreated())
+	{
+		m_BladeTexture.Use(StateTracker);
+	}
+
+	const CShader* const VS{ m_PtrGame->GetBaseShader(EBaseShader::VSGrassField) };
+	const CShader* const GS{ m_PtrGame->GetBaseShader(EBaseShader::GSGrassField) };
+	const CShader* const PS{ m_PtrGame->GetBaseShader(EBaseShader::PSGrassField) };
+
+	VS->Record(StateTracker);
+	m_PtrGame->RecordVSSpace(Device, StateTracker, VS, XMMatrixIdentity());
+
+	GS->Record(StateTracker);
+	GS->RecordAllConstantBuffers(Device, StateTracker);
+
+	PS->Record(StateTracker, static_cast<uint32_t>(m_ePSFeatures));
+	PS->RecordAllConstantBuffers(Device, StateTracker);
+
+	StateTracker.SetSamplerState(EShaderType::PixelShader, 0, m_PtrGame->GetSamplerLinearMirror());
+
+	StateTracker.SetVertexBuffer(0, m_VertexBufferSet.Buffer.Get(), m_VertexBufferSet.Stride, m_VertexBufferSet.Offset);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	StateTracker.Draw(static_cast<UINT>(min(KTileBladeCount, m_vVertices.size() - KFirstBlade)), static_cast<UINT>(KFirstBlade));
 
-	m_PtrDeviceContext->GSSetShader(nullptr, nullptr, 0);
+	StateTracker.SetGeometryShader(nullptr);
 }
 
 void CGrassField::CreateVertexBuffer()
@@ -95,5 +135,5 @@ void CGrassField::CreateVertexBuffer()
 
 	D3D11_SUBRESOURCE_DATA SubresourceData{};
 	SubresourceData.pSysMem = &m_vVertices[0];
-	m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_VertexBufferSet.Buffer);
+	m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, m_VertexBufferSet.Buffer.ReleaseAndGetAddressOf());
 }
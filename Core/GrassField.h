@@ -41,18 +41,18 @@ public:
 		float	Pads[3]{};
 	};
 
-	struct SCBPSFlags
+	// Feature bits of PSGrassField.hlsl variants
+	enum class EPSFeature : uint32_t
 	{
-		BOOL	bUseTexture{ FALSE };
-		float	Pads[3]{};
+		None = 0x0,
+		UseTexture = 0x1
 	};
 
 public:
-	CGrassField(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, CGame* const PtrGame) :
-		m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }, m_PtrGame{ PtrGame }
+	CGrassField(CRenderDevice* const PtrRenderDevice, CGame* const PtrGame) :
+		m_PtrRenderDevice{ PtrRenderDevice }, m_PtrGame{ PtrGame }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 		assert(m_PtrGame);
 	}
 	~CGrassField() {}
@@ -64,6 +64,11 @@ public:
 
 	void Draw();
 
+	// Blades are drawn in tiles of KTileBladeCount consecutive blades, each of which can be recorded by its own CCommandRecorder job
+	// on any thread (CGame's frame constants must be up to date, see CGame::PrepareRecording())
+	size_t GetTileCount() const;
+	void Record(CRenderDevice& Device, CStateTracker& StateTracker, size_t TileIndex) const;
+
 private:
 	void CreateVertexBuffer();
 
@@ -72,6 +77,8 @@ public:
 	static constexpr float KBladeWidthMaxLimit{ 2.0f };
 	static constexpr size_t KMinBladeCount{ 1 };
 	static constexpr size_t KMaxBladeCount{ 18 };
+	static constexpr float KBladeAlphaReference{ 0.5f }; // Blade texels below it are clipped (PSGrassField.hlsl)
+	static constexpr size_t KTileBladeCount{ 4096 };
 	static constexpr D3D11_INPUT_ELEMENT_DESC KInputElementDescs[]
 	{
 		{ "POSITION"	, 0, DXGI_FORMAT_R32G32B32A32_FLOAT	, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -81,8 +88,7 @@ public:
 	};
 
 private:
-	ID3D11Device* const			m_PtrDevice{};
-	ID3D11DeviceContext* const	m_PtrDeviceContext{};
+	CRenderDevice* const		m_PtrRenderDevice{};
 	CGame* const				m_PtrGame{};
 
 private:
@@ -91,6 +97,6 @@ private:
 	std::vector<SVertexGrass>	m_vVertices{};
 	size_t						m_BladeCount{};
 	SCBGSGrassData				m_cbGSGrassData{};
-	SCBPSFlags					m_cbPSFlags{};
-	CMaterial::CTexture			m_BladeTexture{ m_PtrDevice, m_PtrDeviceContext };
+	EPSFeature					m_ePSFeatures{};
+	CMaterial::CTexture			m_BladeTexture{ m_PtrRenderDevice };
 };
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "HeightFieldRayCaster.h"
+
+// In texels along the normalized direction: a position on a cell boundary is taken as inside the cell the ray enters
+static constexpr double KBoundaryNudge{ 1.0e-6 };
+
+static double SampleBilinear(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, double U, double V)
+{
+	const uint32_t KU{ static_cast<uint32_t>(min(max(floor(U), 0.0), static_cast<double>(Width - 2))) };
+	const uint32_t KV{ static_cast<uint32_t>(min(max(floor(V), 0.0), static_cast<double>(Height - 2))) };
+	const double KS{ U - KU };
+	const double KR{ V - KV };
+	const SPixel8UInt* const PtrRow0{ PtrHeights + static_cast<size_t>(KV) * Width + KU };
+	const SPixel8UInt* const PtrRow1{ PtrRow0 + Width };
+	return (PtrRow0[0].R * (1.0 - KS) + PtrRow0[1].R * KS) * (1.0 - KR) + (PtrRow1[0].R * (1.0 - KS) + PtrRow1[1].R * KS) * KR;
+}
+
+void CHeightFieldRayCaster::Create(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+	m_vLevels.clear();
+	if (m_Width < 2 || m_Height < 2) return;
+
+	SLevel Level{};
+	Level.Width = m_Width - 1;
+	Level.Height = m_Height - 1;
+	while (true)
+	{
+		Level.vCells.resize(static_cast<size_t>(Level.Width) * Level.Height);
+		m_vLevels.emplace_back(Level);
+		if (Level.Width == 1 && Level.Height == 1) break;
+
+		Level.Width = (Level.Width + 1) / 2;
+		Level.Height = (Level.Height + 1) / 2;
+	}
+
+	CMipGenerator::SRect CellRect{};
+	CellRect.Right = m_vLevels[0].Width;
+	CellRect.Bottom = m_vLevels[0].Height;
+	BuildLevels(PtrHeights, CellRect);
+}
+
+void CHeightFieldRayCaster::Update(const SPixel8UInt* const PtrHeights, const CMipGenerator::SRect& DirtyRect)
+{
+	if (DirtyRect.IsEmpty() || m_vLevels.empty()) return;
+
+	// Texel U is a corner of cells U - 1 and U
+	CMipGenerator::SRect CellRect{};
+	CellRect.Left = (DirtyRect.Left > 0) ? DirtyRect.Left - 1 : 0;
+	CellRect.Top = (DirtyRect.Top > 0) ? DirtyRect.Top - 1 : 0;
+	CellRect.Right = min(DirtyRect.Right, m_vLevels[0].Width);
+	CellRect.Bottom = min(DirtyRect.Bottom, m_vLevels[0].Height);
+	if (CellRect.IsEmpty()) return;
+
+	BuildLevels(PtrHeights, CellRect);
+}
+
+bool CHeightFieldRayCaster::CastRay(const SPixel8UInt* const PtrHeights, const XMFLOAT3& Origin, const XMFLOAT3& Direction, SHit& OutHit,
+	SStats* const PtrOutStats) const
+{
+	assert(PtrHeights);
+
+	if (PtrOutStats) *PtrOutStats = SStats();
+	if (m_vLevels.empty()) return false;
+
+	const double KLength{ sqrt(static_cast<double>(Direction.x) * Direction.x + static_cast<double>(Direction.y) * Direction.y +
+		static_cast<double>(Direction.z) * Direction.z) };
+	if (KLength <= 0.0) return false;
+
+	// Traversed in double precision, so that the boundary nudge holds on large height maps
+	const double KOrigin[3]{ Origin.x, Origin.y, Origin.z };
+	const double KDirection[3]{ Direction.x / KLength, Direction.y / KLength, Direction.z / KLength };
+
+	// Clip the ray to the bounds of the height field (everything below the surface counts as inside)
+	const SMinMax& KRoot{ m_vLevels.back().vCells[0] };
+	const double KBoundsMin[3]{ 0.0, -DBL_MAX, 0.0 };
+	const double KBoundsMax[3]{ static_cast<double>(m_Width - 1), static_cast<double>(KRoot.Max), static_cast<double>(m_Height - 1) };
+	double TMin{ 0.0 };
+	double TMax{ DBL_MAX };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		if (KDirection[iAxis] == 0.0)
+		{
+			if (KOrigin[iAxis] < KBoundsMin[iAxis] || KOrigin[iAxis] > KBoundsMax[iAxis]) return false;
+			continue;
+		}
+
+		double T0{ (KBoundsMin[iAxis] - KOrigin[iAxis]) / KDirection[iAxis] };
+		double T1{ (KBoundsMax[iAxis] - KOrigin[iAxis]) / KDirection[iAxis] };
+		if (T0 > T1) std::swap(T0, T1);
+		TMin = max(TMin, T0);
+		TMax = min(TMax, T1);
+		if (TMin > TMax) return false;
+	}
+
+	// A ray that enters the height field below its surface hits it where it enters
+	// Otherwise the ray enters every cell above the surface, so cells it passes entirely below can't be hit first
+	double T{ TMin };
+	const double KEnterU{ KOrigin[0] + KDirection[0] * T };
+	const double KEnterV{ KOrigin[2] + KDirection[2] * T };
+	if (KOrigin[1] + KDirection[1] * T <= SampleBilinear(PtrHeights, m_Width, m_Height, KEnterU, KEnterV))
+	{
+		OutHit.T = static_cast<float>(T / KLength);
+		OutHit.Position.x = static_cast<float>(KOrigin[0] + KDirection[0] * T);
+		OutHit.Position.y = static_cast<float>(KOrigin[1] + KDirection[1] * T);
+		OutHit.Position.z = static_cast<float>(KOrigin[2] + KDirection[2] * T);
+		return true;
+	}
+
+	const uint32_t KTopLevel{ static_cast<uint32_t>(m_vLevels.size() - 1) };
+	uint32_t Level{ KTopLevel };
+	for (uint32_t iStep = 0; iStep < KMaxStepCount && T < TMax; ++iStep)
+	{
+		const SLevel& KLevel{ m_vLevels[Level] };
+		const uint32_t KCellSize{ 1u << Level };
+		const double KU{ KOrigin[0] + KDirection[0] * (T + KBoundaryNudge) };
+		const double KV{ KOrigin[2] + KDirection[2] * (T + KBoundaryNudge) };
+		const uint32_t KCellU{ static_cast<uint32_t>(min(max(floor(KU / KCellSize), 0.0), static_cast<double>(KLevel.Width - 1))) };
+		const uint32_t KCellV{ static_cast<uint32_t>(min(max(floor(KV / KCellSize), 0.0), static_cast<double>(KLevel.Height - 1))) };
+
+		// Where the ray leaves the cell (the last cell of a level may be narrower than KCellSize)
+		const double KU0{ static_cast<double>(KCellU * KCellSize) };
+		const double KV0{ static_cast<double>(KCellV * KCellSize) };
+		const double KU1{ static_cast<double>(min((KCellU + 1) * KCellSize, m_vLevels[0].Width)) };
+		const double KV1{ static_cast<double>(min((KCellV + 1) * KCellSize, m_vLevels[0].Height)) };
+		double TExit{ TMax };
+		if (KDirection[0] > 0.0) TExit = min(TExit, (KU1 - KOrigin[0]) / KDirection[0]);
+		if (KDirection[0] < 0.0) TExit = min(TExit, (KU0 - KOrigin[0]) / KDirection[0]);
+		if (KDirection[2] > 0.0) TExit = min(TExit, (KV1 - KOrigin[2]) / KDirection[2]);
+		if (KDirection[2] < 0.0) TExit = min(TExit, (KV0 - KOrigin[2]) / KDirection[2]);
+
+		if (PtrOutStats) ++PtrOutStats->VisitedNodeCount;
+
+		// The ray's height is linear, so it can meet the cell only if its range over the cell overlaps the cell's
+		const SMinMax& KCell{ KLevel.vCells[static_cast<size_t>(KCellV) * KLevel.Width + KCellU] };
+		const double KHeightEnter{ KOrigin[1] + KDirection[1] * T };
+		const double KHeightExit{ KOrigin[1] + KDirection[1] * TExit };
+		if (max(KHeightEnter, KHeightExit) >= KCell.Min && min(KHeightEnter, KHeightExit) <= KCell.Max)
+		{
+			if (Level > 0)
+			{
+				--Level;
+				continue;
+			}
+
+			if (PtrOutStats) ++PtrOutStats->TestedPatchCount;
+
+			const double KPatchOrigin[3]{ KOrigin[0] + KDirection[0] * T - KU0, KHeightEnter, KOrigin[2] + KDirection[2] * T - KV0 };
+			double PatchT{};
+			if (IntersectPatch(PtrHeights, m_Width, KCellU, KCellV, KPatchOrigin, KDirection, TExit - T, PatchT))
+			{
+				T += PatchT;
+				OutHit.T = static_cast<float>(T / KLength);
+				OutHit.Position.x = static_cast<float>(KOrigin[0] + KDirection[0] * T);
+				OutHit.Position.y = static_cast<float>(KOrigin[1] + KDirection[1] * T);
+				OutHit.Position.z = static_cast<float>(KOrigin[2] + KDirection[2] * T);
+				return true;
+			}
+		}
+
+		// Step to the next cell and try the coarser level again
+		T = max(TExit, T + KBoundaryNudge);
+		if (Level < KTopLevel) ++Level;
+	}
+
+	return false;
+}
+
+bool CHeightFieldRayCaster::IntersectPatch(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t CellU, uint32_t CellV,
+	const double (&Origin)[3], const double (&Direction)[3], double MaxT, double& OutT)
+{
+	const SPixel8UInt* const PtrRow0{ PtrHeights + static_cast<size_t>(CellV) * Width + CellU };
+	const SPixel8UInt* const PtrRow1{ PtrRow0 + Width };
+
+	// Surface(s, r) = H00 + B * s + C * r + D * s * r, s and r in [0, 1]
+	const double KH00{ static_cast<double>(PtrRow0[0].R) };
+	const double KB{ static_cast<double>(PtrRow0[1].R) - KH00 };
+	const double KC{ static_cast<double>(PtrRow1[0].R) - KH00 };
+	const double KD{ KH00 - PtrRow0[1].R - PtrRow1[0].R + PtrRow1[1].R };
+
+	// F(t) = Surface(s(t), r(t)) - Height(t) = QA * t^2 + QB * t + QC, which is positive below the surface
+	const double KS{ Origin[0] };
+	const double KR{ Origin[2] };
+	const double KQA{ KD * Direction[0] * Direction[2] };
+	const double KQB{ KB * Direction[0] + KC * Direction[2] + KD * (KS * Direction[2] + KR * Direction[0]) - Direction[1] };
+	const double KQC{ KH00 + KB * KS + KC * KR + KD * KS * KR - Origin[1] };
+
+	// A ray that enters the patch below the surface hits it where it enters
+	if (KQC >= 0.0)
+	{
+		OutT = 0.0;
+		return true;
+	}
+
+	double Roots[2]{ -1.0, -1.0 };
+	if (KQA == 0.0)
+	{
+		if (KQB == 0.0) return false;
+		Roots[0] = -KQC / KQB;
+	}
+	else
+	{
+		const double KDiscriminant{ KQB * KQB - 4.0 * KQA * KQC };
+		if (KDiscriminant < 0.0) return false;
+
+		// Numerically stable form of the quadratic formula
+		const double KQ{ -0.5 * (KQB + ((KQB >= 0.0) ? +sqrt(KDiscriminant) : -sqrt(KDiscriminant))) };
+		Roots[0] = KQ / KQA;
+		if (KQ != 0.0) Roots[1] = KQC / KQ;
+	}
+
+	double NearestT{ DBL_MAX };
+	for (double Root : Roots)
+	{
+		if (Root >= 0.0 && Root <= MaxT) NearestT = min(NearestT, Root);
+	}
+	if (NearestT == DBL_MAX) return false;
+
+	OutT = NearestT;
+	return true;
+}
+
+void CHeightFieldRayCaster::BuildLevels(const SPixel8UInt* const PtrHeights, const CMipGenerator::SRect& CellRect)
+{
+	assert(PtrHeights);
+
+	// A bilinear patch never leaves the range of its 4 corners
+	SLevel& Level0{ m_vLevels[0] };
+	for (uint32_t CellV = CellRect.Top; CellV < CellRect.Bottom; ++CellV)
+	{
+		const SPixel8UInt* const PtrRow0{ PtrHeights + static_cast<size_t>(CellV) * m_Width };
+		const SPixel8UInt* const PtrRow1{ PtrRow0 + m_Width };
+		for (uint32_t CellU = CellRect.Left; CellU < CellRect.Right; ++CellU)
+		{
+			SMinMax& Cell{ Level0.vCells[static_cast<size_t>(CellV) * Level0.Width + CellU] };
+			Cell.Min = min(min(PtrRow0[CellU].R, PtrRow0[CellU + 1].R), min(PtrRow1[CellU].R, PtrRow1[CellU + 1].R));
+			Cell.Max = max(max(PtrRow0[CellU].R, PtrRow0[CellU + 1].R), max(PtrRow1[CellU].R, PtrRow1[CellU + 1].R));
+		}
+	}
+
+	CMipGenerator::SRect Rect{ CellRect };
+	for (size_t iLevel = 1; iLevel < m_vLevels.size(); ++iLevel)
+	{
+		const SLevel& Child{ m_vLevels[iLevel - 1] };
+		SLevel& Parent{ m_vLevels[iLevel] };
+		Rect.Left /= 2;
+		Rect.Top /= 2;
+		Rect.Right = min((Rect.Right + 1) / 2, Parent.Width);
+		Rect.Bottom = min((Rect.Bottom + 1) / 2, Parent.Height);
+		for (uint32_t CellV = Rect.Top; CellV < Rect.Bottom; ++CellV)
+		{
+			for (uint32_t CellU = Rect.Left; CellU < Rect.Right; ++CellU)
+			{
+				SMinMax Cell{ UINT8_MAX, 0 };
+				for (uint32_t ChildV = CellV * 2; ChildV < min(CellV * 2 + 2, Child.Height); ++ChildV)
+				{
+					for (uint32_t ChildU = CellU * 2; ChildU < min(CellU * 2 + 2, Child.Width); ++ChildU)
+					{
+						const SMinMax& KChild{ Child.vCells[static_cast<size_t>(ChildV) * Child.Width + ChildU] };
+						Cell.Min = min(Cell.Min, KChild.Min);
+						Cell.Max = max(Cell.Max, KChild.Max);
+					}
+				}
+				Parent.vCells[static_cast<size_t>(CellV) * Parent.Width + CellU] = Cell;
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "MipGenerator.h"
+
+// Intersects rays with the bilinear surface of an 8-bit height map
+// Height field space: X = U (in texels), Y = height (in steps of the height map, 0 ~ 255), Z = V (in texels)
+// Each cell (the square between 4 adjacent texels) is bounded by a min/max pyramid, which is traversed from the top
+// and is stepped through cell by cell (DDA) at the bottom level, where the ray is intersected with the cell's bilinear patch
+class CHeightFieldRayCaster final
+{
+public:
+	struct SMinMax
+	{
+		uint8_t	Min{};
+		uint8_t	Max{};
+	};
+
+	struct SLevel
+	{
+		uint32_t		Width{}; // In cells
+		uint32_t		Height{}; // In cells
+		vector<SMinMax>	vCells{};
+	};
+
+	struct SHit
+	{
+		float		T{}; // Along the given direction (as it is, not normalized)
+		XMFLOAT3	Position{}; // In height field space
+	};
+
+	struct SStats
+	{
+		size_t	VisitedNodeCount{}; // Pyramid cells of any level the ray passed through
+		size_t	TestedPatchCount{}; // Bilinear patches intersected with the ray
+	};
+
+public:
+	CHeightFieldRayCaster() {}
+	~CHeightFieldRayCaster() {}
+
+public:
+	void Create(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height);
+	// Rebuilds only the pyramid cells that DirtyRect (in texels) reaches
+	void Update(const SPixel8UInt* const PtrHeights, const CMipGenerator::SRect& DirtyRect);
+
+	// PtrHeights must be the height map the pyramid was built (and updated) from
+	bool CastRay(const SPixel8UInt* const PtrHeights, const XMFLOAT3& Origin, const XMFLOAT3& Direction, SHit& OutHit,
+		SStats* const PtrOutStats = nullptr) const;
+
+	const vector<SLevel>& GetLevels() const { return m_vLevels; }
+
+	// Smallest T in [0, MaxT] where the ray meets the bilinear patch of the cell at (CellU, CellV)
+	// Origin is relative to the cell's first texel
+	static bool IntersectPatch(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t CellU, uint32_t CellV,
+		const double (&Origin)[3], const double (&Direction)[3], double MaxT, double& OutT);
+
+private:
+	void BuildLevels(const SPixel8UInt* const PtrHeights, const CMipGenerator::SRect& CellRect);
+
+private:
+	static constexpr uint32_t KMaxStepCount{ 1 << 24 };
+
+private:
+	uint32_t		m_Width{}; // In texels
+	uint32_t		m_Height{}; // In texels
+	vector<SLevel>	m_vLevels{};
+};
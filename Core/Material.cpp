@@ -1,23 +1,48 @@
 #include "Material.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+#include "TextureMipLoader.h"
+#include "StateTracker.h"
+#include "RenderDevice.h"
 
-void CMaterial::CTexture::CreateTextureFromFile(const string& TextureFileName, bool bShouldGenerateMipMap)
+void CMaterial::CTexture::CreateTextureFromFile(const string& TextureFileName, bool bShouldGenerateMipMap, bool bShouldStream)
 {
 	m_TextureFileName = TextureFileName;
 
 	size_t found{ m_TextureFileName.find_last_of(L'.') };
 	string Ext{ m_TextureFileName.substr(found) };
-	wstring wFileName{ m_TextureFileName.begin(), m_TextureFileName.end() };
 	for (auto& c : Ext)
 	{
 		c = toupper(c);
 	}
-	assert(Ext != ".DDS");
+	// A cooked file that is older than its source is ignored until the source is cooked again (Tool/CookTexture.cpp)
+	string CookedFileName{ CTextureCooker::GetCookedFileName(m_TextureFileName) };
+	if (Ext != ".DDS" && !CTextureCooker::IsCookedFileUpToDate(m_TextureFileName, CookedFileName)) CookedFileName.clear();
 
-	if (bShouldGenerateMipMap)
+	if (bShouldStream)
+	{
+		// Falls back to the non-streaming path if there's no DDS file with a mip chain
+		if (CreateStreamingTextureFromDDSFile((Ext == ".DDS") ? m_TextureFileName : CookedFileName)) return;
+	}
+
+	if (Ext == ".DDS")
+	{
+		if (FAILED(m_PtrRenderDevice->CreateTextureFromFile(m_TextureFileName, 0, m_Texture2D.ReleaseAndGetAddressOf(), 
+			m_ShaderResourceView.ReleaseAndGetAddressOf())))
+		{
+			MessageBox(nullptr, ("ؽó ã  ϴ." + m_TextureFileName).c_str(), "  ", MB_OK | MB_ICONEXCLAMATION);
+			return;
+		}
+	}
+	else if (CookedFileName.size() && SUCCEEDED(m_PtrRenderDevice->CreateTextureFromFile(CookedFileName, 0, m_Texture2D.ReleaseAndGetAddressOf(),
+		m_ShaderResourceView.ReleaseAndGetAddressOf())))
+	{
+		// @important: cooked texture (block-compressed, with precomputed mip chain) takes precedence over the source
+	}
+	else if (bShouldGenerateMipMap)
 	{
-		wstring wFileName{ m_TextureFileName.begin(), m_TextureFileName.end() };
 		ComPtr<ID3D11Texture2D> NonMipMappedTexture{};
-		CreateWICTextureFromFile(m_PtrDevice, wFileName.c_str(), (ID3D11Resource**)NonMipMappedTexture.GetAddressOf(), nullptr);
+		m_PtrRenderDevice->CreateTextureFromFile(m_TextureFileName, 0, NonMipMappedTexture.GetAddressOf(), nullptr);
 
 		if (!NonMipMappedTexture)
 		{
@@ -33,18 +58,23 @@ void CMaterial::CTexture::CreateTextureFromFile(const string& TextureFileName, b
 		Texture2DDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
 		Texture2DDesc.Usage = D3D11_USAGE_DEFAULT;
 
-		assert(SUCCEEDED(m_PtrDevice->CreateTexture2D(&Texture2DDesc, nullptr, m_Texture2D.GetAddressOf())));
+		if (FAILED(m_PtrRenderDevice->CreateTexture2D(Texture2DDesc, nullptr, m_Texture2D.ReleaseAndGetAddressOf()))) return;
 
-		m_PtrDeviceContext->ResolveSubresource(m_Texture2D.Get(), 0, NonMipMappedTexture.Get(), 0, Texture2DDesc.Format);
+		m_PtrRenderDevice->CopyTextureRegion(m_Texture2D.Get(), 0, 0, 0, NonMipMappedTexture.Get(), 0, nullptr);
 
-		m_PtrDevice->CreateShaderResourceView(m_Texture2D.Get(), nullptr, m_ShaderResourceView.GetAddressOf());
+		m_PtrRenderDevice->CreateShaderResourceView(m_Texture2D.Get(), nullptr, m_ShaderResourceView.ReleaseAndGetAddressOf());
 
-		m_PtrDeviceContext->GenerateMips(m_ShaderResourceView.Get());
+		m_PtrRenderDevice->GenerateMips(m_ShaderResourceView.Get());
 
 	}
 	else
 	{
-		assert(SUCCEEDED(CreateWICTextureFromFile(m_PtrDevice, wFileName.c_str(), (ID3D11Resource**)m_Texture2D.GetAddressOf(), &m_ShaderResourceView)));
+		if (FAILED(m_PtrRenderDevice->CreateTextureFromFile(m_TextureFileName, 0, m_Texture2D.ReleaseAndGetAddressOf(),
+			m_ShaderResourceView.ReleaseAndGetAddressOf())))
+		{
+			MessageBox(nullptr, ("ؽó ã  ϴ." + m_TextureFileName).c_str(), "  ", MB_OK | MB_ICONEXCLAMATION);
+			return;
+		}
 	}
 
 	SetTextureSize();
@@ -52,19 +82,200 @@ void CMaterial::CTexture::CreateTextureFromFile(const string& TextureFileName, b
 	m_bIsCreated = true;
 }
 
+bool CMaterial::CTexture::CreateStreamingTextureFromDDSFile(const string& DDSFileName)
+{
+	uint32_t Width{};
+	uint32_t Height{};
+	uint32_t MipLevels{};
+	DXGI_FORMAT Format{};
+	if (!CTextureCooker::ReadDDSFileSize(DDSFileName, Width, Height, MipLevels, &Format)) return false;
+	if (MipLevels <= 1) return false;
+
+	// The tail mips are small, so they are read right away; the finer ones are streamed in
+	const UINT KTailMip{ CTextureStreamer::GetAllocatableMip(CTextureStreamer::MakeTextureDesc(Format, Width, Height, MipLevels),
+		CTextureStreamer::GetTailMip(Width, Height, MipLevels)) };
+	vector<vector<uint8_t>> vTailMips{};
+	if (!CTextureCooker::ReadDDSFileMips(DDSFileName, KTailMip, MipLevels - KTailMip, vTailMips)) return false;
+
+	m_StreamingTextureSize = XMFLOAT2(static_cast<float>(Width), static_cast<float>(Height));
+	m_StreamingMipLevels = MipLevels;
+	m_Format = Format;
+	if (!Reallocate(KTailMip, vTailMips)) return false;
+
+	m_StreamingFileName = DDSFileName;
+	m_TextureSize = m_StreamingTextureSize;
+	m_RequestedResidentMip = KTailMip;
+
+	m_bIsCreated = true;
+	return true;
+}
+
+void CMaterial::CTexture::RequestResidentMip(UINT ResidentMip, CTextureMipLoader& MipLoader)
+{
+	assert(IsStreamable());
+	m_RequestedResidentMip = CTextureStreamer::GetAllocatableMip(CTextureStreamer::MakeTextureDesc(m_Format,
+		static_cast<uint32_t>(m_StreamingTextureSize.x), static_cast<uint32_t>(m_StreamingTextureSize.y), m_StreamingMipLevels),
+		min(ResidentMip, m_StreamingMipLevels - 1));
+
+	// Evicted mips are released right away; they are read again if they are requested later
+	if (m_RequestedResidentMip > m_ResidentMip)
+	{
+		// The pending load's mips are finer than the evicted ones
+		m_PendingLoadID = 0;
+		if (!Reallocate(m_RequestedResidentMip, {}))
+		{
+			OutputDebugString(("Failed to evict the mips of " + m_TextureFileName + "\n").c_str());
+		}
+	}
+
+	// One load at a time per texture; the mips requested meanwhile are loaded once it's applied
+	if (m_RequestedResidentMip < m_ResidentMip && m_PendingLoadID == 0)
+	{
+		m_PendingLoadID = MipLoader.Load(m_StreamingID, m_StreamingFileName, m_RequestedResidentMip, m_ResidentMip - m_RequestedResidentMip);
+	}
+}
+
+bool CMaterial::CTexture::ApplyLoadedMips(uint64_t LoadID, UINT FirstMip, const vector<vector<uint8_t>>& vMips, CTextureMipLoader& MipLoader)
+{
+	if (m_PendingLoadID == 0 || LoadID != m_PendingLoadID) return true;
+
+	m_PendingLoadID = 0;
+	if (vMips.empty() || FirstMip + vMips.size() != m_ResidentMip) return false;
+
+	// The mips that stopped being requested while they were read are dropped
+	const UINT KResidentMip{ max(FirstMip, m_RequestedResidentMip) };
+	if (KResidentMip < m_ResidentMip)
+	{
+		if (!Reallocate(KResidentMip, vector<vector<uint8_t>>(vMips.begin() + (KResidentMip - FirstMip), vMips.end()))) return false;
+	}
+	RequestResidentMip(m_RequestedResidentMip, MipLoader);
+	return true;
+}
+
+bool CMaterial::CTexture::Reallocate(UINT ResidentMip, const vector<vector<uint8_t>>& vLoadedMips)
+{
+	assert(ResidentMip + vLoadedMips.size() <= m_StreamingMipLevels);
+	assert(m_Texture2D || ResidentMip + vLoadedMips.size() == m_StreamingMipLevels);
+
+	D3D11_TEXTURE2D_DESC Texture2DDesc{};
+	Texture2DDesc.Width = max(static_cast<UINT>(m_StreamingTextureSize.x) >> ResidentMip, 1u);
+	Texture2DDesc.Height = max(static_cast<UINT>(m_StreamingTextureSize.y) >> ResidentMip, 1u);
+	Texture2DDesc.MipLevels = m_StreamingMipLevels - ResidentMip;
+	Texture2DDesc.ArraySize = 1;
+	Texture2DDesc.Format = m_Format;
+	Texture2DDesc.SampleDesc.Count = 1;
+	Texture2DDesc.SampleDesc.Quality = 0;
+	Texture2DDesc.Usage = D3D11_USAGE_DEFAULT;
+	Texture2DDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	ComPtr<ID3D11Texture2D> Texture2D{};
+	ComPtr<ID3D11ShaderResourceView> ShaderResourceView{};
+	if (FAILED(m_PtrRenderDevice->CreateTexture2D(Texture2DDesc, nullptr, Texture2D.GetAddressOf()))) return false;
+	if (FAILED(m_PtrRenderDevice->CreateShaderResourceView(Texture2D.Get(), nullptr, ShaderResourceView.GetAddressOf()))) return false;
+
+	if (vLoadedMips.size()) UploadMips(Texture2D.Get(), vLoadedMips);
+
+	// The coarser mips are already on the GPU
+	for (UINT iMip = ResidentMip + static_cast<UINT>(vLoadedMips.size()); iMip < m_StreamingMipLevels; ++iMip)
+	{
+		m_PtrRenderDevice->CopyTextureRegion(Texture2D.Get(), iMip - ResidentMip, 0, 0, m_Texture2D.Get(), iMip - m_ResidentMip, nullptr);
+	}
+
+	// @important: the old texture is released here (the context keeps it alive while it's bound or used by queued commands)
+	m_Texture2D = Texture2D;
+	m_ShaderResourceView = ShaderResourceView;
+	m_ResidentMip = ResidentMip;
+	m_MipLevels = Texture2DDesc.MipLevels;
+	return true;
+}
+
+void CMaterial::CTexture::UploadMips(ID3D11Texture2D* const PtrTexture, const vector<vector<uint8_t>>& vMips)
+{
+	D3D11_TEXTURE2D_DESC UploadDesc{};
+	PtrTexture->GetDesc(&UploadDesc);
+	UploadDesc.MipLevels = static_cast<UINT>(vMips.size());
+	UploadDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	vector<D3D11_SUBRESOURCE_DATA> vSubresourceData{};
+	for (UINT iMip = 0; iMip < UploadDesc.MipLevels; ++iMip)
+	{
+		UINT RowPitch{};
+		UINT RowCount{};
+		CRenderDevice::GetSubresourceByteSize(UploadDesc, iMip, RowPitch, RowCount);
+		vSubresourceData.push_back({ vMips[iMip].data(), RowPitch, 0 });
+	}
+
+	// The mips are copied from an upload texture (CopySubresourceRegion); its top mip is the texture's, so it's made of whole blocks
+	ComPtr<ID3D11Texture2D> UploadTexture{};
+	if (SUCCEEDED(m_PtrRenderDevice->CreateTexture2D(UploadDesc, vSubresourceData.data(), UploadTexture.GetAddressOf())))
+	{
+		for (UINT iMip = 0; iMip < UploadDesc.MipLevels; ++iMip)
+		{
+			m_PtrRenderDevice->CopyTextureRegion(PtrTexture, iMip, 0, 0, UploadTexture.Get(), iMip, nullptr);
+		}
+	}
+	else
+	{
+		for (UINT iMip = 0; iMip < UploadDesc.MipLevels; ++iMip)
+		{
+			m_PtrRenderDevice->UpdateTexture(PtrTexture, iMip, nullptr, vMips[iMip].data(), vSubresourceData[iMip].SysMemPitch);
+		}
+	}
+}
+
+void CMaterial::CTexture::CreateAlphaTestedTextureFromFile(const string& TextureFileName, float AlphaReference)
+{
+	m_TextureFileName = TextureFileName;
+
+	CTextureCooker::SImage Image{};
+	if (!CTextureCooker::LoadImageFromFile(m_TextureFileName, Image))
+	{
+		MessageBox(nullptr, ("ؽó ã  ϴ." + m_TextureFileName).c_str(), "  ", MB_OK | MB_ICONEXCLAMATION);
+		return;
+	}
+
+	vector<CTextureCooker::SImage> vMipChain{};
+	CTextureCooker::GenerateMipChain(Image, CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser, false, true, AlphaReference), vMipChain);
+
+	vector<D3D11_SUBRESOURCE_DATA> vSubresourceData{};
+	for (const CTextureCooker::SImage& Level : vMipChain)
+	{
+		vSubresourceData.push_back({ Level.vPixels.data(), static_cast<UINT>(Level.Width * sizeof(SPixel32UInt)), 0 });
+	}
+
+	D3D11_TEXTURE2D_DESC Texture2DDesc{};
+	Texture2DDesc.Width = Image.Width;
+	Texture2DDesc.Height = Image.Height;
+	Texture2DDesc.MipLevels = static_cast<UINT>(vMipChain.size());
+	Texture2DDesc.ArraySize = 1;
+	Texture2DDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Texture2DDesc.SampleDesc.Count = 1;
+	Texture2DDesc.SampleDesc.Quality = 0;
+	Texture2DDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	Texture2DDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	if (FAILED(m_PtrRenderDevice->CreateTexture2D(Texture2DDesc, vSubresourceData.data(), m_Texture2D.ReleaseAndGetAddressOf()))) return;
+	if (FAILED(m_PtrRenderDevice->CreateShaderResourceView(m_Texture2D.Get(), nullptr, m_ShaderResourceView.ReleaseAndGetAddressOf()))) return;
+
+	SetTextureSize();
+	m_MipLevels = Texture2DDesc.MipLevels;
+	m_Format = Texture2DDesc.Format;
+
+	m_bIsCreated = true;
+}
+
 void CMaterial::CTexture::CreateTextureFromMemory(const vector<uint8_t>& RawData)
 {
-	assert(SUCCEEDED(CreateWICTextureFromMemory(m_PtrDevice, &RawData[0], RawData.size(), 
-		(ID3D11Resource**)m_Texture2D.GetAddressOf(), &m_ShaderResourceView)));
+	if (FAILED(m_PtrRenderDevice->CreateTextureFromMemory(&RawData[0], RawData.size(), m_Texture2D.ReleaseAndGetAddressOf(),
+		m_ShaderResourceView.ReleaseAndGetAddressOf()))) return;
 
 	SetTextureSize();
 
 	m_bIsCreated = true;
 }
 
-void CMaterial::CTexture::CreateBlankTexture(DXGI_FORMAT Format, const XMFLOAT2& TextureSize)
+void CMaterial::CTexture::CreateBlankTexture(DXGI_FORMAT Format, const XMFLOAT2& TextureSize, UINT MipLevels, bool bShouldUpdateRegions)
 {
 	m_TextureSize = TextureSize;
+	m_MipLevels = max(MipLevels, 1u);
 
 	D3D11_TEXTURE2D_DESC Texture2DDesc{};
 	Texture2DDesc.ArraySize = 1;
@@ -72,14 +283,20 @@ void CMaterial::CTexture::CreateBlankTexture(DXGI_FORMAT Format, const XMFLOAT2&
 	Texture2DDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 	Texture2DDesc.Format = Format;
 	Texture2DDesc.Height = static_cast<UINT>(m_TextureSize.y);
-	Texture2DDesc.MipLevels = 1;
+	Texture2DDesc.MipLevels = m_MipLevels;
 	Texture2DDesc.SampleDesc.Count = 1;
 	Texture2DDesc.SampleDesc.Quality = 0;
 	Texture2DDesc.Usage = D3D11_USAGE_DYNAMIC;
 	Texture2DDesc.Width = static_cast<UINT>(m_TextureSize.x);
+	if (m_MipLevels > 1 || bShouldUpdateRegions)
+	{
+		// @important: dynamic textures can't have mip levels nor be updated by regions
+		Texture2DDesc.CPUAccessFlags = 0;
+		Texture2DDesc.Usage = D3D11_USAGE_DEFAULT;
+	}
 
-	m_PtrDevice->CreateTexture2D(&Texture2DDesc, nullptr, m_Texture2D.GetAddressOf());
-	m_PtrDevice->CreateShaderResourceView(m_Texture2D.Get(), nullptr, m_ShaderResourceView.GetAddressOf());
+	if (FAILED(m_PtrRenderDevice->CreateTexture2D(Texture2DDesc, nullptr, m_Texture2D.ReleaseAndGetAddressOf()))) return;
+	if (FAILED(m_PtrRenderDevice->CreateShaderResourceView(m_Texture2D.Get(), nullptr, m_ShaderResourceView.ReleaseAndGetAddressOf()))) return;
 
 	m_bIsCreated = true;
 }
@@ -95,8 +312,14 @@ void CMaterial::CTexture::SetTextureSize()
 
 void CMaterial::CTexture::UpdateTextureRawData(const SPixel8UInt* const PtrData)
 {
+	if (m_MipLevels > 1)
+	{
+		UpdateTextureRawData(PtrData, 0, static_cast<UINT>(m_TextureSize.x));
+		return;
+	}
+
 	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_Texture2D.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	if (m_PtrRenderDevice->MapTexture(m_Texture2D.Get(), 0, D3D11_MAP_WRITE_DISCARD, MappedSubresource))
 	{
 		size_t SrcRowPixelCount{ (size_t)m_TextureSize.x };
 		uint8_t* PtrDest{ (uint8_t*)MappedSubresource.pData };
@@ -111,14 +334,20 @@ void CMaterial::CTexture::UpdateTextureRawData(const SPixel8UInt* const PtrData)
 				SrcRowPixelCount * sizeof(SPixel8UInt));
 		}
 
-		m_PtrDeviceContext->Unmap(m_Texture2D.Get(), 0);
+		m_PtrRenderDevice->UnmapTexture(m_Texture2D.Get(), 0);
 	}
 }
 
 void CMaterial::CTexture::UpdateTextureRawData(const SPixel32UInt* const PtrData)
 {
+	if (m_MipLevels > 1)
+	{
+		UpdateTextureRawData(PtrData, 0, static_cast<UINT>(m_TextureSize.x));
+		return;
+	}
+
 	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_Texture2D.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	if (m_PtrRenderDevice->MapTexture(m_Texture2D.Get(), 0, D3D11_MAP_WRITE_DISCARD, MappedSubresource))
 	{
 		size_t SrcRowPixelCount{ (size_t)m_TextureSize.x };
 		uint8_t* PtrDest{ (uint8_t*)MappedSubresource.pData };
@@ -133,10 +362,51 @@ void CMaterial::CTexture::UpdateTextureRawData(const SPixel32UInt* const PtrData
 				SrcRowPixelCount * sizeof(SPixel32UInt));
 		}
 
-		m_PtrDeviceContext->Unmap(m_Texture2D.Get(), 0);
+		m_PtrRenderDevice->UnmapTexture(m_Texture2D.Get(), 0);
 	}
 }
 
+void CMaterial::CTexture::UpdateTextureRawData(const SPixel8UInt* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox)
+{
+	assert(MipLevel < m_MipLevels);
+
+	const SPixel8UInt* PtrSrc{ PtrData };
+	if (PtrBox) PtrSrc += static_cast<size_t>(PtrBox->top) * MipWidth + PtrBox->left;
+
+	m_PtrRenderDevice->UpdateTexture(m_Texture2D.Get(), D3D11CalcSubresource(MipLevel, 0, m_MipLevels), PtrBox, PtrSrc,
+		static_cast<UINT>(MipWidth * sizeof(SPixel8UInt)));
+}
+
+void CMaterial::CTexture::UpdateTextureRawData(const SPixel16Int* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox)
+{
+	assert(MipLevel < m_MipLevels);
+
+	const SPixel16Int* PtrSrc{ PtrData };
+	if (PtrBox) PtrSrc += static_cast<size_t>(PtrBox->top) * MipWidth + PtrBox->left;
+
+	m_PtrRenderDevice->UpdateTexture(m_Texture2D.Get(), D3D11CalcSubresource(MipLevel, 0, m_MipLevels), PtrBox, PtrSrc,
+		static_cast<UINT>(MipWidth * sizeof(SPixel16Int)));
+}
+
+void CMaterial::CTexture::UpdateTextureRawData(const SPixel32UInt* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox)
+{
+	assert(MipLevel < m_MipLevels);
+
+	const SPixel32UInt* PtrSrc{ PtrData };
+	if (PtrBox) PtrSrc += static_cast<size_t>(PtrBox->top) * MipWidth + PtrBox->left;
+
+	m_PtrRenderDevice->UpdateTexture(m_Texture2D.Get(), D3D11CalcSubresource(MipLevel, 0, m_MipLevels), PtrBox, PtrSrc,
+		static_cast<UINT>(MipWidth * sizeof(SPixel32UInt)));
+}
+
+void CMaterial::CTexture::UpdateTextureRegion(const SPixel32UInt* const PtrRegionData, UINT MipLevel, const D3D11_BOX& Box)
+{
+	assert(MipLevel < m_MipLevels);
+
+	m_PtrRenderDevice->UpdateTexture(m_Texture2D.Get(), D3D11CalcSubresource(MipLevel, 0, m_MipLevels), &Box, PtrRegionData,
+		static_cast<UINT>((Box.right - Box.left) * sizeof(SPixel32UInt)));
+}
+
 void CMaterial::CTexture::SetSlot(UINT Slot)
 {
 	m_Slot = Slot;
@@ -152,26 +422,15 @@ void CMaterial::CTexture::Use(int ForcedSlot) const
 	UINT Slot{ m_Slot };
 	if (ForcedSlot != -1) Slot = static_cast<UINT>(ForcedSlot);
 
-	switch (m_eShaderType)
-	{
-	case EShaderType::VertexShader:
-		m_PtrDeviceContext->VSSetShaderResources(Slot, 1, m_ShaderResourceView.GetAddressOf());
-		break;
-	case EShaderType::HullShader:
-		m_PtrDeviceContext->HSSetShaderResources(Slot, 1, m_ShaderResourceView.GetAddressOf());
-		break;
-	case EShaderType::DomainShader:
-		m_PtrDeviceContext->DSSetShaderResources(Slot, 1, m_ShaderResourceView.GetAddressOf());
-		break;
-	case EShaderType::GeometryShader:
-		m_PtrDeviceContext->GSSetShaderResources(Slot, 1, m_ShaderResourceView.GetAddressOf());
-		break;
-	case EShaderType::PixelShader:
-		m_PtrDeviceContext->PSSetShaderResources(Slot, 1, m_ShaderResourceView.GetAddressOf());
-		break;
-	default:
-		break;
-	}
+	m_PtrRenderDevice->SetShaderResource(m_eShaderType, Slot, m_ShaderResourceView.Get());
+}
+
+void CMaterial::CTexture::Use(CStateTracker& StateTracker, int ForcedSlot) const
+{
+	UINT Slot{ m_Slot };
+	if (ForcedSlot != -1) Slot = static_cast<UINT>(ForcedSlot);
+
+	StateTracker.SetShaderResource(m_eShaderType, Slot, m_ShaderResourceView.Get());
 }
 
 bool CMaterial::CTexture::IsCreated() const
@@ -248,12 +507,12 @@ void CMaterial::SetTextureFileName(CTexture::EType eType, const string& FileName
 	}
 }
 
-void CMaterial::CreateTextures(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext)
+void CMaterial::CreateTextures(CRenderDevice* const PtrRenderDevice, bool bShouldStreamTextures)
 {
-	CreateTexture(CTexture::EType::DiffuseTexture, PtrDevice, PtrDeviceContext);
-	CreateTexture(CTexture::EType::NormalTexture, PtrDevice, PtrDeviceContext);
-	CreateTexture(CTexture::EType::DisplacementTexture, PtrDevice, PtrDeviceContext);
-	CreateTexture(CTexture::EType::OpacityTexture, PtrDevice, PtrDeviceContext);
+	CreateTexture(CTexture::EType::DiffuseTexture, PtrRenderDevice, bShouldStreamTextures);
+	CreateTexture(CTexture::EType::NormalTexture, PtrRenderDevice, bShouldStreamTextures);
+	CreateTexture(CTexture::EType::DisplacementTexture, PtrRenderDevice, bShouldStreamTextures);
+	CreateTexture(CTexture::EType::OpacityTexture, PtrRenderDevice, bShouldStreamTextures);
 }
 
 void CMaterial::UseTextures() const
@@ -264,7 +523,15 @@ void CMaterial::UseTextures() const
 	if (m_OpacityTexture) m_OpacityTexture->Use();
 }
 
-void CMaterial::CreateTexture(CMaterial::CTexture::EType eType, ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext)
+void CMaterial::UseTextures(CStateTracker& StateTracker) const
+{
+	if (m_DiffuseTexture) m_DiffuseTexture->Use(StateTracker);
+	if (m_NormalTexture) m_NormalTexture->Use(StateTracker);
+	if (m_DisplacementTexture) m_DisplacementTexture->Use(StateTracker);
+	if (m_OpacityTexture) m_OpacityTexture->Use(StateTracker);
+}
+
+void CMaterial::CreateTexture(CMaterial::CTexture::EType eType, CRenderDevice* const PtrRenderDevice, bool bShouldStreamTexture)
 {
 	if (HasTexture(eType))
 	{
@@ -273,19 +540,19 @@ void CMaterial::CreateTexture(CMaterial::CTexture::EType eType, ID3D11Device* co
 		switch (eType)
 		{
 		case CMaterial::CTexture::EType::DiffuseTexture:
-			m_DiffuseTexture = make_unique<CMaterial::CTexture>(PtrDevice, PtrDeviceContext);
+			m_DiffuseTexture = make_unique<CMaterial::CTexture>(PtrRenderDevice);
 			PtrTexture = m_DiffuseTexture.get();
 			break;
 		case CMaterial::CTexture::EType::NormalTexture:
-			m_NormalTexture = make_unique<CMaterial::CTexture>(PtrDevice, PtrDeviceContext);
+			m_NormalTexture = make_unique<CMaterial::CTexture>(PtrRenderDevice);
 			PtrTexture = m_NormalTexture.get();
 			break;
 		case CMaterial::CTexture::EType::DisplacementTexture:
-			m_DisplacementTexture = make_unique<CMaterial::CTexture>(PtrDevice, PtrDeviceContext);
+			m_DisplacementTexture = make_unique<CMaterial::CTexture>(PtrRenderDevice);
 			PtrTexture = m_DisplacementTexture.get();
 			break;
 		case CMaterial::CTexture::EType::OpacityTexture:
-			m_OpacityTexture = make_unique<CMaterial::CTexture>(PtrDevice, PtrDeviceContext);
+			m_OpacityTexture = make_unique<CMaterial::CTexture>(PtrRenderDevice);
 			PtrTexture = m_OpacityTexture.get();
 			break;
 		default:
@@ -299,7 +566,7 @@ void CMaterial::CreateTexture(CMaterial::CTexture::EType eType, ID3D11Device* co
 		}
 		else
 		{
-			PtrTexture->CreateTextureFromFile(GetTextureFileName(eType), ShouldGenerateAutoMipMap());
+			PtrTexture->CreateTextureFromFile(GetTextureFileName(eType), ShouldGenerateAutoMipMap(), bShouldStreamTexture);
 		}
 
 		UINT Offset{};
@@ -446,3 +713,20 @@ const vector<uint8_t>& CMaterial::GetTextureRawData(CTexture::EType eType) const
 		return m_vEmbeddedDiffuseTextureRawData;
 	}
 }
+
+CMaterial::CTexture* CMaterial::GetTexture(CTexture::EType eType) const
+{
+	switch (eType)
+	{
+	case CMaterial::CTexture::EType::DiffuseTexture:
+		return m_DiffuseTexture.get();
+	case CMaterial::CTexture::EType::NormalTexture:
+		return m_NormalTexture.get();
+	case CMaterial::CTexture::EType::DisplacementTexture:
+		return m_DisplacementTexture.get();
+	case CMaterial::CTexture::EType::OpacityTexture:
+		return m_OpacityTexture.get();
+	default:
+		return nullptr;
+	}
+}
@@ -2,11 +2,21 @@
 
 #include "SharedHeader.h"
 
+class CStateTracker;
+class CRenderDevice;
+class CTextureMipLoader;
+
 struct SPixel8UInt
 {
 	uint8_t R{};
 };
 
+struct alignas(2) SPixel16Int
+{
+	int8_t R{};
+	int8_t G{};
+};
+
 struct alignas(4) SPixel32UInt
 {
 	uint8_t R{};
@@ -30,28 +40,64 @@ public:
 		};
 
 	public:
-		CTexture(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-			m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+		CTexture(CRenderDevice* const PtrRenderDevice) :
+			m_PtrRenderDevice{ PtrRenderDevice }
 		{
-			assert(m_PtrDevice);
-			assert(m_PtrDeviceContext);
+			assert(m_PtrRenderDevice);
 		}
 		~CTexture() {}
 
 	public:
-		void CreateTextureFromFile(const string& TextureFileName, bool bShouldGenerateMipMap);
+		// bShouldStream: DDS textures (cooked or not) are created with only their tail mips resident
+		void CreateTextureFromFile(const string& TextureFileName, bool bShouldGenerateMipMap, bool bShouldStream = false);
+		// For alpha-tested textures: mips are generated on the CPU so that each keeps mip 0's alpha coverage at AlphaReference
+		// (the GPU's auto mips average the alpha down, so alpha-tested edges thin out and vanish with distance)
+		void CreateAlphaTestedTextureFromFile(const string& TextureFileName, float AlphaReference);
 		void CreateTextureFromMemory(const vector<uint8_t>& RawData);
-		void CreateBlankTexture(DXGI_FORMAT Format, const XMFLOAT2& TextureSize);
+		// bShouldUpdateRegions: a texture without mip levels is created as a default texture too, so that it can be updated by regions
+		void CreateBlankTexture(DXGI_FORMAT Format, const XMFLOAT2& TextureSize, UINT MipLevels = 1, bool bShouldUpdateRegions = false);
 
 	private:
 		void SetTextureSize();
+		bool CreateStreamingTextureFromDDSFile(const string& DDSFileName);
+		// Replaces the texture with one that has only mips [ResidentMip, m_StreamingMipLevels): mips [ResidentMip, ResidentMip + vLoadedMips.size())
+		// are uploaded, the others are copied from the current texture. The current texture is kept if the new one can't be created
+		bool Reallocate(UINT ResidentMip, const vector<vector<uint8_t>>& vLoadedMips);
+		// Copies vMips into mips [0, vMips.size()) of PtrTexture
+		void UploadMips(ID3D11Texture2D* const PtrTexture, const vector<vector<uint8_t>>& vMips);
 
 	public:
 		void UpdateTextureRawData(const SPixel8UInt* const PtrData);
 		void UpdateTextureRawData(const SPixel32UInt* const PtrData);
+		
+		// For textures with mip levels or created with bShouldUpdateRegions (updated through CRenderDevice::UpdateTexture())
+		// PtrData points to the whole mip level, PtrBox limits the update to a region of it
+		void UpdateTextureRawData(const SPixel8UInt* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox = nullptr);
+		void UpdateTextureRawData(const SPixel16Int* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox = nullptr);
+		void UpdateTextureRawData(const SPixel32UInt* const PtrData, UINT MipLevel, UINT MipWidth, const D3D11_BOX* const PtrBox = nullptr);
+		// PtrRegionData points to the region's first texel (Box.right - Box.left texels per row)
+		void UpdateTextureRegion(const SPixel32UInt* const PtrRegionData, UINT MipLevel, const D3D11_BOX& Box);
 		void SetSlot(UINT Slot);
 		void SetShaderType(EShaderType eShaderType);
 		void Use(int ForcedSlot = -1) const;
+		void Use(CStateTracker& StateTracker, int ForcedSlot = -1) const;
+
+	public:
+		// The texture is allocated with its resident mips only. Evicting mips reallocates it right away (freeing their memory), finer mips are
+		// read by MipLoader and the texture is reallocated with them by ApplyLoadedMips()
+		// @important: for block-compressed textures, ResidentMip is rounded down to a mip made of whole blocks
+		void RequestResidentMip(UINT ResidentMip, CTextureMipLoader& MipLoader);
+		// Returns false if the load failed; the results of canceled or other textures' loads are ignored
+		bool ApplyLoadedMips(uint64_t LoadID, UINT FirstMip, const vector<vector<uint8_t>>& vMips, CTextureMipLoader& MipLoader);
+		// The pending load's result will be ignored (e.g. when the texture stops being streamed)
+		void CancelMipLoad() { m_PendingLoadID = 0; }
+		void SetStreamingID(size_t StreamingID) { m_StreamingID = StreamingID; }
+		size_t GetStreamingID() const { return m_StreamingID; }
+		bool IsStreamable() const { return m_StreamingFileName.size() > 0; }
+		UINT GetResidentMip() const { return m_ResidentMip; }
+		UINT GetStreamingMipLevels() const { return m_StreamingMipLevels; }
+		const XMFLOAT2& GetStreamingTextureSize() const { return m_StreamingTextureSize; }
+		DXGI_FORMAT GetFormat() const { return m_Format; }
 
 	public:
 		bool IsCreated() const;
@@ -59,16 +105,26 @@ public:
 		ID3D11ShaderResourceView* GetShaderResourceViewPtr() { return m_ShaderResourceView.Get(); }
 
 	private:
-		ID3D11Device* const					m_PtrDevice{};
-		ID3D11DeviceContext* const			m_PtrDeviceContext{};
+		CRenderDevice* const				m_PtrRenderDevice{};
 
 	private:
 		string								m_TextureFileName{};
 		XMFLOAT2							m_TextureSize{};
 		UINT								m_Slot{};
+		UINT								m_MipLevels{ 1 };
 		EShaderType							m_eShaderType{ EShaderType::PixelShader };
 		bool								m_bIsCreated{ false };
 
+	private:
+		string								m_StreamingFileName{};
+		XMFLOAT2							m_StreamingTextureSize{}; // Mip 0 size
+		UINT								m_StreamingMipLevels{};
+		UINT								m_ResidentMip{}; // The texture's mip 0 is the file's m_ResidentMip
+		UINT								m_RequestedResidentMip{};
+		uint64_t							m_PendingLoadID{}; // 0: none
+		DXGI_FORMAT							m_Format{};
+		size_t								m_StreamingID{ SIZE_MAX }; // CTextureStreamer::KInvalidID
+
 	private:
 		ComPtr<ID3D11Texture2D>				m_Texture2D{};
 		ComPtr<ID3D11ShaderResourceView>	m_ShaderResourceView{};
@@ -124,11 +180,12 @@ public:
 	void SetTextureRawData(CTexture::EType eType, const vector<uint8_t>& Data);
 	void SetTextureFileName(CTexture::EType eType, const string& FileName);
 
-	void CreateTextures(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext);
+	void CreateTextures(CRenderDevice* const PtrRenderDevice, bool bShouldStreamTextures = false);
 	void UseTextures() const;
+	void UseTextures(CStateTracker& StateTracker) const;
 
 private:
-	void CreateTexture(CMaterial::CTexture::EType eType, ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext);
+	void CreateTexture(CMaterial::CTexture::EType eType, CRenderDevice* const PtrRenderDevice, bool bShouldStreamTexture);
 
 public:
 	void SetUniformColor(const XMFLOAT3& Color);
@@ -147,6 +204,7 @@ public:
 	bool IsTextureEmbedded(CTexture::EType eType) const;
 	const string& GetTextureFileName(CTexture::EType eType) const;
 	const vector<uint8_t>& GetTextureRawData(CTexture::EType eType) const;
+	CTexture* GetTexture(CTexture::EType eType) const;
 
 	void ShouldGenerateAutoMipMap(bool Value) { m_bShouldGenerateAutoMipMap = Value; }
 	bool ShouldGenerateAutoMipMap() const { return m_bShouldGenerateAutoMipMap; }
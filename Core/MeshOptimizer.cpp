@@ -0,0 +1,340 @@
+#include "MeshOptimizer.h"
+
+// FIFO cache emulated with insertion time stamps: a vertex is cached if it was inserted less than CacheSize insertions ago
+// TimeStamp must start at CacheSize + 1 (and be advanced by CacheSize + 1 to flush the cache)
+static uint32_t SimulateTriangle(const STriangle& Triangle, vector<uint32_t>& vCacheTimeStamps, uint32_t& TimeStamp, uint32_t CacheSize)
+{
+	uint32_t MissCount{};
+	const uint32_t Indices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+	for (uint32_t Index : Indices)
+	{
+		if (TimeStamp - vCacheTimeStamps[Index] > CacheSize)
+		{
+			vCacheTimeStamps[Index] = TimeStamp++;
+			++MissCount;
+		}
+	}
+	return MissCount;
+}
+
+void CMeshOptimizer::OptimizeMesh(SMesh& Mesh, const SDesc& Desc, SStats* const PtrOutStats)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	SStats Stats{};
+	Stats.TriangleCount = Mesh.vTriangles.size();
+	Stats.VertexCountBefore = Mesh.vVertices.size();
+	Stats.Before = AnalyzeVertexCache(Mesh.vTriangles, Mesh.vVertices.size(), Desc.CacheSize);
+
+	OptimizeVertexCache(Mesh.vTriangles, Mesh.vVertices.size(), Desc.CacheSize);
+
+	if (Desc.bShouldOptimizeOverdraw)
+	{
+		OptimizeOverdraw(Mesh.vVertices, Mesh.vTriangles, Desc.CacheSize, Desc.OverdrawThreshold);
+	}
+
+	if (Desc.bShouldOptimizeVertexFetch)
+	{
+		OptimizeVertexFetch(Mesh);
+	}
+
+	Stats.VertexCountAfter = Mesh.vVertices.size();
+	Stats.After = AnalyzeVertexCache(Mesh.vTriangles, Mesh.vVertices.size(), Desc.CacheSize);
+	Stats.ElapsedMilliseconds = GetTickCount64() - StartTimePoint;
+	Stats.MegaTrianglesPerSecond = static_cast<float>(Stats.TriangleCount) / 1'000.0f / static_cast<float>(max(Stats.ElapsedMilliseconds, (ULONGLONG)1));
+
+	if (PtrOutStats) *PtrOutStats = Stats;
+}
+
+void CMeshOptimizer::OptimizeVertexCache(vector<STriangle>& vTriangles, size_t VertexCount, uint32_t CacheSize)
+{
+	const size_t KTriangleCount{ vTriangles.size() };
+	if (!KTriangleCount || !VertexCount) return;
+
+	// Vertex -> triangle adjacency
+	vector<uint32_t> vLiveTriangleCounts(VertexCount);
+	for (const STriangle& Triangle : vTriangles)
+	{
+		++vLiveTriangleCounts[Triangle.I0];
+		++vLiveTriangleCounts[Triangle.I1];
+		++vLiveTriangleCounts[Triangle.I2];
+	}
+
+	vector<uint32_t> vAdjacencyOffsets(VertexCount + 1);
+	for (size_t iVertex = 0; iVertex < VertexCount; ++iVertex)
+	{
+		vAdjacencyOffsets[iVertex + 1] = vAdjacencyOffsets[iVertex] + vLiveTriangleCounts[iVertex];
+	}
+
+	vector<uint32_t> vAdjacency(KTriangleCount * 3);
+	{
+		vector<uint32_t> vCursors(vAdjacencyOffsets.begin(), vAdjacencyOffsets.end() - 1);
+		for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+		{
+			const STriangle& Triangle{ vTriangles[iTriangle] };
+			vAdjacency[vCursors[Triangle.I0]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I1]++] = static_cast<uint32_t>(iTriangle);
+			vAdjacency[vCursors[Triangle.I2]++] = static_cast<uint32_t>(iTriangle);
+		}
+	}
+
+	vector<uint32_t> vCacheTimeStamps(VertexCount);
+	vector<uint8_t> vbIsEmitted(KTriangleCount);
+	vector<uint32_t> vDeadEndStack{};
+	vector<uint32_t> vCandidates{};
+	vector<STriangle> vOptimizedTriangles{};
+	vDeadEndStack.reserve(KTriangleCount * 3);
+	vOptimizedTriangles.reserve(KTriangleCount);
+
+	uint32_t TimeStamp{ CacheSize + 1 };
+	size_t Cursor{};
+	int64_t FanningVertex{};
+	while (FanningVertex >= 0)
+	{
+		// Emit every live triangle around the fanning vertex
+		vCandidates.clear();
+		for (uint32_t iAdjacency = vAdjacencyOffsets[FanningVertex]; iAdjacency < vAdjacencyOffsets[FanningVertex + 1]; ++iAdjacency)
+		{
+			uint32_t iTriangle{ vAdjacency[iAdjacency] };
+			if (vbIsEmitted[iTriangle]) continue;
+
+			const STriangle& Triangle{ vTriangles[iTriangle] };
+			const uint32_t Indices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+			for (uint32_t Index : Indices)
+			{
+				vDeadEndStack.emplace_back(Index);
+				vCandidates.emplace_back(Index);
+				--vLiveTriangleCounts[Index];
+				if (TimeStamp - vCacheTimeStamps[Index] > CacheSize)
+				{
+					vCacheTimeStamps[Index] = TimeStamp++;
+				}
+			}
+
+			vOptimizedTriangles.emplace_back(Triangle);
+			vbIsEmitted[iTriangle] = 1;
+		}
+
+		// The oldest candidate that will still be in the cache after its own fan is emitted
+		int64_t NextVertex{ -1 };
+		int64_t HighestPriority{ -1 };
+		for (uint32_t Candidate : vCandidates)
+		{
+			if (vLiveTriangleCounts[Candidate] == 0) continue;
+
+			int64_t Priority{};
+			if (TimeStamp - vCacheTimeStamps[Candidate] + 2 * vLiveTriangleCounts[Candidate] <= CacheSize)
+			{
+				Priority = TimeStamp - vCacheTimeStamps[Candidate];
+			}
+			if (Priority > HighestPriority)
+			{
+				HighestPriority = Priority;
+				NextVertex = Candidate;
+			}
+		}
+
+		// Dead end
+		if (NextVertex == -1)
+		{
+			while (vDeadEndStack.size())
+			{
+				uint32_t Vertex{ vDeadEndStack.back() };
+				vDeadEndStack.pop_back();
+				if (vLiveTriangleCounts[Vertex] > 0)
+				{
+					NextVertex = Vertex;
+					break;
+				}
+			}
+		}
+		if (NextVertex == -1)
+		{
+			while (Cursor < VertexCount)
+			{
+				if (vLiveTriangleCounts[Cursor] > 0)
+				{
+					NextVertex = static_cast<int64_t>(Cursor);
+					break;
+				}
+				++Cursor;
+			}
+		}
+
+		FanningVertex = NextVertex;
+	}
+
+	vTriangles = std::move(vOptimizedTriangles);
+}
+
+void CMeshOptimizer::OptimizeOverdraw(const vector<SVertex3D>& vVertices, vector<STriangle>& vTriangles, uint32_t CacheSize, float Threshold)
+{
+	const size_t KTriangleCount{ vTriangles.size() };
+	if (!KTriangleCount) return;
+
+	vector<uint32_t> vCacheTimeStamps(vVertices.size());
+	uint32_t TimeStamp{ CacheSize + 1 };
+
+	// Hard boundaries: a triangle whose vertices all miss the cache starts a new cluster
+	vector<uint32_t> vHardClusterOffsets{};
+	for (size_t iTriangle = 0; iTriangle < KTriangleCount; ++iTriangle)
+	{
+		uint32_t MissCount{ SimulateTriangle(vTriangles[iTriangle], vCacheTimeStamps, TimeStamp, CacheSize) };
+		if (iTriangle == 0 || MissCount == 3) vHardClusterOffsets.emplace_back(static_cast<uint32_t>(iTriangle));
+	}
+	vHardClusterOffsets.emplace_back(static_cast<uint32_t>(KTriangleCount));
+
+	// Soft boundaries: split a hard cluster as soon as its ACMR so far is within Threshold of the whole cluster's ACMR
+	vector<uint32_t> vClusterOffsets{};
+	for (size_t iHardCluster = 0; iHardCluster + 1 < vHardClusterOffsets.size(); ++iHardCluster)
+	{
+		uint32_t Begin{ vHardClusterOffsets[iHardCluster] };
+		uint32_t End{ vHardClusterOffsets[iHardCluster + 1] };
+
+		TimeStamp += CacheSize + 1;
+		uint32_t ClusterMissCount{};
+		for (uint32_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			ClusterMissCount += SimulateTriangle(vTriangles[iTriangle], vCacheTimeStamps, TimeStamp, CacheSize);
+		}
+		float ClusterThreshold{ Threshold * static_cast<float>(ClusterMissCount) / static_cast<float>(End - Begin) };
+
+		TimeStamp += CacheSize + 1;
+		uint32_t SoftBegin{ Begin };
+		uint32_t MissCount{};
+		vClusterOffsets.emplace_back(Begin);
+		for (uint32_t iTriangle = Begin; iTriangle < End; ++iTriangle)
+		{
+			MissCount += SimulateTriangle(vTriangles[iTriangle], vCacheTimeStamps, TimeStamp, CacheSize);
+			if (iTriangle + 1 < End && static_cast<float>(MissCount) / static_cast<float>(iTriangle + 1 - SoftBegin) <= ClusterThreshold)
+			{
+				SoftBegin = iTriangle + 1;
+				MissCount = 0;
+				TimeStamp += CacheSize + 1;
+				vClusterOffsets.emplace_back(SoftBegin);
+			}
+		}
+	}
+	vClusterOffsets.emplace_back(static_cast<uint32_t>(KTriangleCount));
+	const size_t KClusterCount{ vClusterOffsets.size() - 1 };
+
+	// Area-weighted centroids and normals
+	XMVECTOR MeshCentroid{};
+	float MeshArea{};
+	vector<XMFLOAT3> vClusterCentroids(KClusterCount);
+	vector<XMFLOAT3> vClusterNormals(KClusterCount);
+	for (size_t iCluster = 0; iCluster < KClusterCount; ++iCluster)
+	{
+		XMVECTOR ClusterCentroid{};
+		XMVECTOR ClusterNormal{};
+		float ClusterArea{};
+		for (uint32_t iTriangle = vClusterOffsets[iCluster]; iTriangle < vClusterOffsets[iCluster + 1]; ++iTriangle)
+		{
+			const STriangle& Triangle{ vTriangles[iTriangle] };
+			const XMVECTOR& P0{ vVertices[Triangle.I0].Position };
+			const XMVECTOR& P1{ vVertices[Triangle.I1].Position };
+			const XMVECTOR& P2{ vVertices[Triangle.I2].Position };
+
+			XMVECTOR Normal{ XMVector3Cross(P1 - P0, P2 - P0) };
+			float Area{ XMVectorGetX(XMVector3Length(Normal)) * 0.5f };
+			XMVECTOR Centroid{ (P0 + P1 + P2) / 3.0f };
+
+			ClusterCentroid += Centroid * Area;
+			ClusterNormal += Normal;
+			ClusterArea += Area;
+		}
+
+		MeshCentroid += ClusterCentroid;
+		MeshArea += ClusterArea;
+		if (ClusterArea > 0.0f) ClusterCentroid /= ClusterArea;
+
+		XMStoreFloat3(&vClusterCentroids[iCluster], ClusterCentroid);
+		XMStoreFloat3(&vClusterNormals[iCluster], XMVector3Normalize(ClusterNormal));
+	}
+	if (MeshArea > 0.0f) MeshCentroid /= MeshArea;
+
+	vector<float> vClusterSortKeys(KClusterCount);
+	for (size_t iCluster = 0; iCluster < KClusterCount; ++iCluster)
+	{
+		XMVECTOR Direction{ XMLoadFloat3(&vClusterCentroids[iCluster]) - MeshCentroid };
+		vClusterSortKeys[iCluster] = XMVectorGetX(XMVector3Dot(Direction, XMLoadFloat3(&vClusterNormals[iCluster])));
+	}
+
+	vector<uint32_t> vClusterOrder(KClusterCount);
+	for (size_t iCluster = 0; iCluster < KClusterCount; ++iCluster) vClusterOrder[iCluster] = static_cast<uint32_t>(iCluster);
+	std::sort(vClusterOrder.begin(), vClusterOrder.end(), [&](uint32_t A, uint32_t B)
+		{
+			if (vClusterSortKeys[A] != vClusterSortKeys[B]) return vClusterSortKeys[A] > vClusterSortKeys[B];
+			return A < B;
+		});
+
+	vector<STriangle> vSortedTriangles{};
+	vSortedTriangles.reserve(KTriangleCount);
+	for (uint32_t iCluster : vClusterOrder)
+	{
+		vSortedTriangles.insert(vSortedTriangles.end(),
+			vTriangles.begin() + vClusterOffsets[iCluster], vTriangles.begin() + vClusterOffsets[iCluster + 1]);
+	}
+	vTriangles = std::move(vSortedTriangles);
+}
+
+void CMeshOptimizer::OptimizeVertexFetch(SMesh& Mesh)
+{
+	static constexpr uint32_t KUnused{ UINT32_MAX };
+
+	const bool bHasAnimation{ Mesh.vVerticesAnimation.size() == Mesh.vVertices.size() };
+	vector<uint32_t> vRemap(Mesh.vVertices.size(), KUnused);
+	vector<SVertex3D> vVertices{};
+	vector<SVertexAnimation> vVerticesAnimation{};
+	vVertices.reserve(Mesh.vVertices.size());
+	if (bHasAnimation) vVerticesAnimation.reserve(Mesh.vVertices.size());
+
+	for (STriangle& Triangle : Mesh.vTriangles)
+	{
+		uint32_t* const Indices[3]{ &Triangle.I0, &Triangle.I1, &Triangle.I2 };
+		for (uint32_t* const PtrIndex : Indices)
+		{
+			uint32_t& Remapped{ vRemap[*PtrIndex] };
+			if (Remapped == KUnused)
+			{
+				Remapped = static_cast<uint32_t>(vVertices.size());
+				vVertices.emplace_back(Mesh.vVertices[*PtrIndex]);
+				if (bHasAnimation) vVerticesAnimation.emplace_back(Mesh.vVerticesAnimation[*PtrIndex]);
+			}
+			*PtrIndex = Remapped;
+		}
+	}
+
+	Mesh.vVertices = std::move(vVertices);
+	if (bHasAnimation) Mesh.vVerticesAnimation = std::move(vVerticesAnimation);
+}
+
+CMeshOptimizer::SCacheStats CMeshOptimizer::AnalyzeVertexCache(const vector<STriangle>& vTriangles, size_t VertexCount, uint32_t CacheSize)
+{
+	SCacheStats Result{};
+	if (vTriangles.empty() || !VertexCount) return Result;
+
+	vector<uint32_t> vCacheTimeStamps(VertexCount);
+	vector<uint8_t> vbIsReferenced(VertexCount);
+	uint32_t TimeStamp{ CacheSize + 1 };
+	size_t MissCount{};
+	size_t ReferencedVertexCount{};
+	for (const STriangle& Triangle : vTriangles)
+	{
+		MissCount += SimulateTriangle(Triangle, vCacheTimeStamps, TimeStamp, CacheSize);
+
+		const uint32_t Indices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+		for (uint32_t Index : Indices)
+		{
+			if (!vbIsReferenced[Index])
+			{
+				vbIsReferenced[Index] = 1;
+				++ReferencedVertexCount;
+			}
+		}
+	}
+
+	Result.ACMR = static_cast<float>(MissCount) / static_cast<float>(vTriangles.size());
+	Result.ATVR = static_cast<float>(MissCount) / static_cast<float>(ReferencedVertexCount);
+	return Result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "AssimpLoader.h"
+
+// Reorders triangles and vertices of an SMesh for the post-transform vertex cache, overdraw and vertex fetch
+// Every pass is deterministic (the same input always yields the same output)
+class CMeshOptimizer
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+
+		uint32_t	CacheSize{ KDefaultCacheSize };
+		bool		bShouldOptimizeOverdraw{ true };
+		float		OverdrawThreshold{ 1.05f }; // Allowed ACMR increase (ratio) for better overdraw order
+		bool		bShouldOptimizeVertexFetch{ true };
+	};
+
+	struct SCacheStats
+	{
+		float	ACMR{}; // Average cache miss ratio (vertex shader invocations / triangle), [0.5, 3]
+		float	ATVR{}; // Average transformed vertex ratio (vertex shader invocations / vertex), [1, 6]
+	};
+
+	struct SStats
+	{
+		SCacheStats	Before{};
+		SCacheStats	After{};
+		size_t		TriangleCount{};
+		size_t		VertexCountBefore{};
+		size_t		VertexCountAfter{};
+		ULONGLONG	ElapsedMilliseconds{};
+		float		MegaTrianglesPerSecond{};
+	};
+
+public:
+	static void OptimizeMesh(SMesh& Mesh, const SDesc& Desc = SDesc(), SStats* const PtrOutStats = nullptr);
+
+	// Tipsify (Sander et al. 2007)
+	static void OptimizeVertexCache(vector<STriangle>& vTriangles, size_t VertexCount, uint32_t CacheSize = KDefaultCacheSize);
+
+	// View-independent: clusters that face outward are drawn first
+	// vTriangles must be already optimized for the vertex cache
+	static void OptimizeOverdraw(const vector<SVertex3D>& vVertices, vector<STriangle>& vTriangles, uint32_t CacheSize, float Threshold);
+
+	// Reorders vertices by first use and removes unreferenced ones (vVerticesAnimation is reordered along)
+	static void OptimizeVertexFetch(SMesh& Mesh);
+
+	// FIFO cache simulation
+	static SCacheStats AnalyzeVertexCache(const vector<STriangle>& vTriangles, size_t VertexCount, uint32_t CacheSize = KDefaultCacheSize);
+
+public:
+	static constexpr uint32_t KDefaultCacheSize{ 16 };
+};
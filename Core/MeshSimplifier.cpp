@@ -0,0 +1,449 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "GeometryProcessor.h"
+#include <thread>
+#include <atomic>
+
+// Symmetric 4x4 error quadric: Error(p) = (p^T * A * p + 2 * B . p + C) / Weight
+struct SQuadric
+{
+	double A00{}, A01{}, A02{}, A11{}, A12{}, A22{};
+	double B0{}, B1{}, B2{};
+	double C{};
+	double Weight{};
+};
+
+static void AddPlaneToQuadric(SQuadric& Quadric, const XMFLOAT3& Normal, double Distance, double Weight)
+{
+	const double X{ Normal.x }, Y{ Normal.y }, Z{ Normal.z };
+	Quadric.A00 += Weight * X * X;
+	Quadric.A01 += Weight * X * Y;
+	Quadric.A02 += Weight * X * Z;
+	Quadric.A11 += Weight * Y * Y;
+	Quadric.A12 += Weight * Y * Z;
+	Quadric.A22 += Weight * Z * Z;
+	Quadric.B0 += Weight * X * Distance;
+	Quadric.B1 += Weight * Y * Distance;
+	Quadric.B2 += Weight * Z * Distance;
+	Quadric.C += Weight * Distance * Distance;
+	Quadric.Weight += Weight;
+}
+
+static void AddQuadric(SQuadric& Quadric, const SQuadric& Other)
+{
+	Quadric.A00 += Other.A00;
+	Quadric.A01 += Other.A01;
+	Quadric.A02 += Other.A02;
+	Quadric.A11 += Other.A11;
+	Quadric.A12 += Other.A12;
+	Quadric.A22 += Other.A22;
+	Quadric.B0 += Other.B0;
+	Quadric.B1 += Other.B1;
+	Quadric.B2 += Other.B2;
+	Quadric.C += Other.C;
+	Quadric.Weight += Other.Weight;
+}
+
+static double EvaluateQuadric(const SQuadric& A, const SQuadric& B, const XMFLOAT3& P)
+{
+	const double X{ P.x }, Y{ P.y }, Z{ P.z };
+	double Result{};
+	Result += (A.A00 + B.A00) * X * X + (A.A11 + B.A11) * Y * Y + (A.A22 + B.A22) * Z * Z;
+	Result += 2.0 * ((A.A01 + B.A01) * X * Y + (A.A02 + B.A02) * X * Z + (A.A12 + B.A12) * Y * Z);
+	Result += 2.0 * ((A.B0 + B.B0) * X + (A.B1 + B.B1) * Y + (A.B2 + B.B2) * Z);
+	Result += A.C + B.C;
+
+	// Area-weighted mean of the squared distances to the planes
+	double Weight{ A.Weight + B.Weight };
+	return (Weight > 0.0) ? max(Result / Weight, 0.0) : 0.0;
+}
+
+static XMVECTOR CalculateFaceNormal(const XMFLOAT3& P0, const XMFLOAT3& P1, const XMFLOAT3& P2)
+{
+	XMVECTOR V0{ XMLoadFloat3(&P0) };
+	return XMVector3Cross(XMLoadFloat3(&P1) - V0, XMLoadFloat3(&P2) - V0);
+}
+
+vector<STriangle> CMeshSimplifier::SimplifyMesh(const SMesh& Mesh, const vector<STriangle>& vTriangles, const SDesc& Desc,
+	SStats* const PtrOutStats)
+{
+	struct SCollapse
+	{
+		double		Cost{};
+		uint32_t	From{}; // Vertex
+		uint32_t	To{}; // Vertex
+	};
+
+	const size_t KVertexCount{ Mesh.vVertices.size() };
+
+	SStats Stats{};
+	Stats.TriangleCountBefore = vTriangles.size();
+
+	vector<STriangle> vResult{ vTriangles };
+	if (vResult.size() <= Desc.TargetTriangleCount || !KVertexCount)
+	{
+		Stats.TriangleCountAfter = vResult.size();
+		if (PtrOutStats) *PtrOutStats = Stats;
+		return vResult;
+	}
+
+	vector<XMFLOAT3> vPositions(KVertexCount);
+	vector<XMFLOAT3> vNormals(KVertexCount);
+	for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+	{
+		XMStoreFloat3(&vPositions[iVertex], Mesh.vVertices[iVertex].Position);
+		XMStoreFloat3(&vNormals[iVertex], XMVector3Normalize(Mesh.vVertices[iVertex].Normal));
+	}
+
+	// Split vertices (UV/normal seams) share a position ID
+	vector<uint32_t> vPositionIDs{};
+	const size_t KPositionCount{ CGeometryProcessor::WeldPositions(Mesh.vVertices, CGeometryProcessor::KDefaultWeldEpsilon, vPositionIDs) };
+
+	// Locked positions: seams (more than one referenced vertex), open borders and non-manifold edges
+	vector<bool> vLockedPositions(KPositionCount);
+	{
+		vector<uint32_t> vFirstVertices(KPositionCount, UINT32_MAX);
+		vector<uint64_t> vEdges{};
+		vEdges.reserve(vResult.size() * 3);
+		for (const STriangle& Triangle : vResult)
+		{
+			const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+			for (int iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				uint32_t Vertex{ KIndices[iCorner] };
+				uint32_t& FirstVertex{ vFirstVertices[vPositionIDs[Vertex]] };
+				if (FirstVertex == UINT32_MAX) FirstVertex = Vertex;
+				if (FirstVertex != Vertex) vLockedPositions[vPositionIDs[Vertex]] = true;
+
+				uint64_t A{ vPositionIDs[KIndices[iCorner]] };
+				uint64_t B{ vPositionIDs[KIndices[(iCorner + 1) % 3]] };
+				vEdges.emplace_back((A << 32) | B);
+			}
+		}
+		std::sort(vEdges.begin(), vEdges.end());
+
+		for (size_t iEdge = 0; iEdge < vEdges.size(); ++iEdge)
+		{
+			uint64_t Edge{ vEdges[iEdge] };
+			uint64_t Reverse{ (Edge << 32) | (Edge >> 32) };
+			auto Range{ std::equal_range(vEdges.begin(), vEdges.end(), Reverse) };
+			bool bIsDuplicate{ (iEdge > 0 && vEdges[iEdge - 1] == Edge) || (iEdge + 1 < vEdges.size() && vEdges[iEdge + 1] == Edge) };
+			if (Range.first == Range.second || Range.second - Range.first > 1 || bIsDuplicate)
+			{
+				vLockedPositions[static_cast<uint32_t>(Edge >> 32)] = true;
+				vLockedPositions[static_cast<uint32_t>(Edge & UINT32_MAX)] = true;
+			}
+		}
+	}
+
+	// Area-weighted plane quadrics
+	vector<SQuadric> vQuadrics(KPositionCount);
+	for (const STriangle& Triangle : vResult)
+	{
+		XMVECTOR Normal{ CalculateFaceNormal(vPositions[Triangle.I0], vPositions[Triangle.I1], vPositions[Triangle.I2]) };
+		float DoubleArea{ XMVectorGetX(XMVector3Length(Normal)) };
+		if (DoubleArea <= 0.0f) continue;
+
+		XMFLOAT3 UnitNormal{};
+		XMStoreFloat3(&UnitNormal, Normal / DoubleArea);
+		const XMFLOAT3& P0{ vPositions[Triangle.I0] };
+		double Distance{ -(static_cast<double>(UnitNormal.x) * P0.x + static_cast<double>(UnitNormal.y) * P0.y + static_cast<double>(UnitNormal.z) * P0.z) };
+		for (uint32_t Vertex : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			AddPlaneToQuadric(vQuadrics[vPositionIDs[Vertex]], UnitNormal, Distance, DoubleArea * 0.5);
+		}
+	}
+
+	const double KMaxCost{ static_cast<double>(Desc.MaxError) * static_cast<double>(Desc.MaxError) };
+	double MaxAppliedCost{};
+	vector<uint32_t> vAdjacencyOffsets{};
+	vector<uint32_t> vAdjacency{};
+	vector<uint32_t> vCollapseTargets(KVertexCount);
+	vector<bool> vTouchedPositions(KPositionCount);
+	vector<SCollapse> vCollapses{};
+	while (vResult.size() > Desc.TargetTriangleCount)
+	{
+		++Stats.PassCount;
+
+		// Position -> triangle adjacency
+		vAdjacencyOffsets.assign(KPositionCount + 1, 0);
+		for (const STriangle& Triangle : vResult)
+		{
+			++vAdjacencyOffsets[vPositionIDs[Triangle.I0] + 1];
+			++vAdjacencyOffsets[vPositionIDs[Triangle.I1] + 1];
+			++vAdjacencyOffsets[vPositionIDs[Triangle.I2] + 1];
+		}
+		for (size_t iPosition = 0; iPosition < KPositionCount; ++iPosition)
+		{
+			vAdjacencyOffsets[iPosition + 1] += vAdjacencyOffsets[iPosition];
+		}
+		vAdjacency.resize(vResult.size() * 3);
+		{
+			vector<uint32_t> vCursors(vAdjacencyOffsets.begin(), vAdjacencyOffsets.end() - 1);
+			for (size_t iTriangle = 0; iTriangle < vResult.size(); ++iTriangle)
+			{
+				const STriangle& Triangle{ vResult[iTriangle] };
+				vAdjacency[vCursors[vPositionIDs[Triangle.I0]]++] = static_cast<uint32_t>(iTriangle);
+				vAdjacency[vCursors[vPositionIDs[Triangle.I1]]++] = static_cast<uint32_t>(iTriangle);
+				vAdjacency[vCursors[vPositionIDs[Triangle.I2]]++] = static_cast<uint32_t>(iTriangle);
+			}
+		}
+
+		// Candidates (both directions of every edge)
+		vCollapses.clear();
+		for (const STriangle& Triangle : vResult)
+		{
+			const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+			for (int iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				uint32_t From{ KIndices[iCorner] };
+				uint32_t To{ KIndices[(iCorner + 1) % 3] };
+				for (int iDirection = 0; iDirection < 2; ++iDirection)
+				{
+					if (iDirection == 1) std::swap(From, To);
+					if (vLockedPositions[vPositionIDs[From]]) continue;
+
+					const XMFLOAT3& PFrom{ vPositions[From] };
+					const XMFLOAT3& PTo{ vPositions[To] };
+					double EdgeLengthSquare{ static_cast<double>(PFrom.x - PTo.x) * (PFrom.x - PTo.x) +
+						static_cast<double>(PFrom.y - PTo.y) * (PFrom.y - PTo.y) + static_cast<double>(PFrom.z - PTo.z) * (PFrom.z - PTo.z) };
+					double NormalDot{ static_cast<double>(vNormals[From].x) * vNormals[To].x +
+						static_cast<double>(vNormals[From].y) * vNormals[To].y + static_cast<double>(vNormals[From].z) * vNormals[To].z };
+
+					double Cost{ EvaluateQuadric(vQuadrics[vPositionIDs[From]], vQuadrics[vPositionIDs[To]], PTo) };
+					Cost += Desc.NormalWeight * (1.0 - NormalDot) * EdgeLengthSquare;
+					if (Cost > KMaxCost) continue;
+
+					vCollapses.push_back(SCollapse{ Cost, From, To });
+				}
+			}
+		}
+		if (vCollapses.empty()) break;
+
+		std::sort(vCollapses.begin(), vCollapses.end(), [](const SCollapse& A, const SCollapse& B)
+			{
+				if (A.Cost != B.Cost) return A.Cost < B.Cost;
+				if (A.From != B.From) return A.From < B.From;
+				return A.To < B.To;
+			});
+
+		// Independent collapses: a position is changed at most once per pass
+		for (size_t iVertex = 0; iVertex < KVertexCount; ++iVertex)
+		{
+			vCollapseTargets[iVertex] = static_cast<uint32_t>(iVertex);
+		}
+		vTouchedPositions.assign(KPositionCount, false);
+
+		const size_t KTrianglesToRemove{ vResult.size() - Desc.TargetTriangleCount };
+		size_t RemovedTriangleCount{};
+		size_t CollapseCount{};
+		for (const SCollapse& Collapse : vCollapses)
+		{
+			if (RemovedTriangleCount >= KTrianglesToRemove) break;
+
+			const uint32_t KFromPosition{ vPositionIDs[Collapse.From] };
+			const uint32_t KToPosition{ vPositionIDs[Collapse.To] };
+			if (vTouchedPositions[KFromPosition] || vTouchedPositions[KToPosition]) continue;
+
+			// The vertex of 'To' that the triangles around 'From' must use (they must agree on it)
+			uint32_t Target{ UINT32_MAX };
+			bool bIsValid{ true };
+			size_t SharedTriangleCount{};
+			for (uint32_t iAdjacency = vAdjacencyOffsets[KFromPosition]; iAdjacency < vAdjacencyOffsets[KFromPosition + 1] && bIsValid; ++iAdjacency)
+			{
+				const STriangle& Triangle{ vResult[vAdjacency[iAdjacency]] };
+				uint32_t Indices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+
+				bool bHasTo{ false };
+				for (uint32_t Index : Indices)
+				{
+					if (vPositionIDs[Index] != KToPosition) continue;
+					if (Target != UINT32_MAX && Target != Index) bIsValid = false;
+					Target = Index;
+					bHasTo = true;
+				}
+				if (bHasTo)
+				{
+					++SharedTriangleCount;
+					continue;
+				}
+
+				// Face normals must not flip or rotate too much
+				XMVECTOR NormalBefore{ CalculateFaceNormal(vPositions[Indices[0]], vPositions[Indices[1]], vPositions[Indices[2]]) };
+				for (uint32_t& Index : Indices)
+				{
+					if (vPositionIDs[Index] == KFromPosition) Index = Collapse.To;
+				}
+				XMVECTOR NormalAfter{ CalculateFaceNormal(vPositions[Indices[0]], vPositions[Indices[1]], vPositions[Indices[2]]) };
+
+				float LengthProduct{ XMVectorGetX(XMVector3Length(NormalBefore)) * XMVectorGetX(XMVector3Length(NormalAfter)) };
+				if (XMVectorGetX(XMVector3Dot(NormalBefore, NormalAfter)) <= KMinNormalDot * LengthProduct) bIsValid = false;
+			}
+			if (!bIsValid || Target == UINT32_MAX) continue;
+
+			vCollapseTargets[Collapse.From] = Target;
+			AddQuadric(vQuadrics[KToPosition], vQuadrics[KFromPosition]);
+			MaxAppliedCost = max(MaxAppliedCost, Collapse.Cost);
+
+			// The one-ring of 'From' has changed
+			for (uint32_t iAdjacency = vAdjacencyOffsets[KFromPosition]; iAdjacency < vAdjacencyOffsets[KFromPosition + 1]; ++iAdjacency)
+			{
+				const STriangle& Triangle{ vResult[vAdjacency[iAdjacency]] };
+				vTouchedPositions[vPositionIDs[Triangle.I0]] = true;
+				vTouchedPositions[vPositionIDs[Triangle.I1]] = true;
+				vTouchedPositions[vPositionIDs[Triangle.I2]] = true;
+			}
+
+			RemovedTriangleCount += SharedTriangleCount;
+			++CollapseCount;
+		}
+		if (!CollapseCount) break;
+
+		size_t TriangleCount{};
+		for (const STriangle& Triangle : vResult)
+		{
+			STriangle Collapsed{ vCollapseTargets[Triangle.I0], vCollapseTargets[Triangle.I1], vCollapseTargets[Triangle.I2] };
+			uint32_t P0{ vPositionIDs[Collapsed.I0] };
+			uint32_t P1{ vPositionIDs[Collapsed.I1] };
+			uint32_t P2{ vPositionIDs[Collapsed.I2] };
+			if (P0 == P1 || P1 == P2 || P2 == P0) continue;
+
+			vResult[TriangleCount++] = Collapsed;
+		}
+		vResult.resize(TriangleCount);
+	}
+
+	CMeshOptimizer::OptimizeVertexCache(vResult, KVertexCount);
+
+	Stats.TriangleCountAfter = vResult.size();
+	Stats.Error = static_cast<float>(sqrt(MaxAppliedCost));
+	if (PtrOutStats) *PtrOutStats = Stats;
+
+	return vResult;
+}
+
+void CMeshSimplifier::GenerateLODs(SModel& Model, const SLODDesc& Desc, SLODStats* const PtrOutStats)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	const float KBoundingRadius{ max(CalculateBoundingRadius(Model.vMeshes), FLT_EPSILON) };
+	const size_t KMeshCount{ Model.vMeshes.size() };
+
+	// Meshes are independent, so the result does not depend on the thread count
+	std::atomic<size_t> NextMesh{};
+	auto SimplifyMeshes{ [&]()
+	{
+		for (size_t iMesh = NextMesh++; iMesh < KMeshCount; iMesh = NextMesh++)
+		{
+			SMesh& Mesh{ Model.vMeshes[iMesh] };
+			Mesh.vLODs.clear();
+			if (Mesh.vTriangles.size() < Desc.MinTriangleCount) continue;
+
+			const vector<STriangle>* PtrTriangles{ &Mesh.vTriangles };
+			for (uint32_t iLOD = 0; iLOD < Desc.LODCount; ++iLOD)
+			{
+				SDesc SimplifierDesc{};
+				SimplifierDesc.TargetTriangleCount = static_cast<size_t>(PtrTriangles->size() * Desc.TriangleRatio);
+				SimplifierDesc.MaxError = Desc.MaxRelativeError * KBoundingRadius;
+
+				SStats Stats{};
+				SMeshLOD LOD{};
+				LOD.vTriangles = SimplifyMesh(Mesh, *PtrTriangles, SimplifierDesc, &Stats);
+
+				// @important: stop when the mesh can not be reduced meaningfully any more
+				if (LOD.vTriangles.size() * 10 > PtrTriangles->size() * 9) break;
+
+				// Each LOD is simplified from the previous one, so the errors add up (upper bound)
+				float PreviousError{ (Mesh.vLODs.empty()) ? 0.0f : Mesh.vLODs.back().RelativeError };
+				LOD.RelativeError = PreviousError + Stats.Error / KBoundingRadius;
+
+				Mesh.vLODs.emplace_back(std::move(LOD));
+				PtrTriangles = &Mesh.vLODs.back().vTriangles;
+			}
+		}
+	} };
+
+	uint32_t ThreadCount{ (Desc.ThreadCount) ? Desc.ThreadCount : std::thread::hardware_concurrency() };
+	ThreadCount = static_cast<uint32_t>(min(static_cast<size_t>(max(ThreadCount, (uint32_t)1)), max(KMeshCount, (size_t)1)));
+	vector<std::thread> vThreads{};
+	for (uint32_t iThread = 1; iThread < ThreadCount; ++iThread)
+	{
+		vThreads.emplace_back(SimplifyMeshes);
+	}
+	SimplifyMeshes();
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+
+	if (PtrOutStats)
+	{
+		SLODStats Stats{};
+		size_t LODCount{};
+		for (const SMesh& Mesh : Model.vMeshes)
+		{
+			LODCount = max(LODCount, Mesh.vLODs.size());
+		}
+		Stats.vTriangleCounts.resize(LODCount + 1);
+		Stats.vRelativeErrors.resize(LODCount + 1);
+		for (const SMesh& Mesh : Model.vMeshes)
+		{
+			Stats.vTriangleCounts[0] += Mesh.vTriangles.size();
+			for (size_t iLOD = 1; iLOD <= LODCount; ++iLOD)
+			{
+				if (Mesh.vLODs.empty())
+				{
+					Stats.vTriangleCounts[iLOD] += Mesh.vTriangles.size();
+					continue;
+				}
+				const SMeshLOD& LOD{ Mesh.vLODs[min(iLOD, Mesh.vLODs.size()) - 1] };
+				Stats.vTriangleCounts[iLOD] += LOD.vTriangles.size();
+				Stats.vRelativeErrors[iLOD] = max(Stats.vRelativeErrors[iLOD], LOD.RelativeError);
+			}
+		}
+		Stats.ElapsedMilliseconds = GetTickCount64() - StartTimePoint;
+
+		*PtrOutStats = Stats;
+	}
+}
+
+float CMeshSimplifier::CalculateBoundingRadius(const vector<SMesh>& vMeshes)
+{
+	XMVECTOR Min{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR Max{ XMVectorReplicate(-FLT_MAX) };
+	for (const SMesh& Mesh : vMeshes)
+	{
+		for (const SVertex3D& Vertex : Mesh.vVertices)
+		{
+			Min = XMVectorMin(Min, Vertex.Position);
+			Max = XMVectorMax(Max, Vertex.Position);
+		}
+	}
+	if (XMVectorGetX(Min) > XMVectorGetX(Max)) return 0.0f;
+
+	return XMVectorGetX(XMVector3Length(Max - Min)) * 0.5f;
+}
+
+size_t CMeshSimplifier::SelectLOD(const vector<SMesh>& vMeshes, float ProjectedRadius, float MaxPixelError)
+{
+	size_t LODCount{};
+	for (const SMesh& Mesh : vMeshes)
+	{
+		LODCount = max(LODCount, Mesh.vLODs.size());
+	}
+
+	size_t Result{};
+	for (size_t iLOD = 1; iLOD <= LODCount; ++iLOD)
+	{
+		float RelativeError{};
+		for (const SMesh& Mesh : vMeshes)
+		{
+			if (Mesh.vLODs.empty()) continue;
+			RelativeError = max(RelativeError, Mesh.vLODs[min(iLOD, Mesh.vLODs.size()) - 1].RelativeError);
+		}
+		if (RelativeError * ProjectedRadius > MaxPixelError) break;
+
+		Result = iLOD;
+	}
+	return Result;
+}
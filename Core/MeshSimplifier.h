@@ -0,0 +1,65 @@
+#pragma once
+
+#include "AssimpLoader.h"
+
+// Quadric error metric (Garland & Heckbert 1997) simplifier with half-edge collapses
+// Vertices are never moved or created, so every LOD is an index list into the original vertices
+// Vertices on UV/normal seams (split vertices) and on open borders (mesh = material boundaries) are never removed
+// Every pass is deterministic (the same input always yields the same output)
+class CMeshSimplifier
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+
+		size_t		TargetTriangleCount{};
+		float		MaxError{ FLT_MAX }; // In model space
+		float		NormalWeight{ 1.0f }; // Penalty for collapsing vertices with different normals
+	};
+
+	struct SStats
+	{
+		size_t		TriangleCountBefore{};
+		size_t		TriangleCountAfter{};
+		float		Error{}; // In model space
+		uint32_t	PassCount{};
+	};
+
+	struct SLODDesc
+	{
+		SLODDesc() {}
+
+		uint32_t	LODCount{ 3 }; // Excluding LOD 0
+		float		TriangleRatio{ 0.5f }; // Triangle count of LOD n+1 / LOD n
+		float		MaxRelativeError{ 0.05f }; // Error / model's bounding radius
+		size_t		MinTriangleCount{ 64 }; // Meshes with fewer triangles are not simplified
+		uint32_t	ThreadCount{}; // 0: std::thread::hardware_concurrency()
+	};
+
+	struct SLODStats
+	{
+		vector<size_t>	vTriangleCounts{}; // Of every LOD (all meshes)
+		vector<float>	vRelativeErrors{}; // Of every LOD (largest among the meshes)
+		ULONGLONG		ElapsedMilliseconds{};
+	};
+
+public:
+	// Simplifies vTriangles (an index list into Mesh.vVertices)
+	static vector<STriangle> SimplifyMesh(const SMesh& Mesh, const vector<STriangle>& vTriangles, const SDesc& Desc = SDesc(),
+		SStats* const PtrOutStats = nullptr);
+
+	// Fills SMesh::vLODs of every mesh; meshes are processed in parallel
+	static void GenerateLODs(SModel& Model, const SLODDesc& Desc = SLODDesc(), SLODStats* const PtrOutStats = nullptr);
+
+	static float CalculateBoundingRadius(const vector<SMesh>& vMeshes);
+
+	// The coarsest LOD whose error is at most MaxPixelError when the bounding sphere's projected radius is ProjectedRadius pixels
+	static size_t SelectLOD(const vector<SMesh>& vMeshes, float ProjectedRadius, float MaxPixelError = KDefaultMaxPixelError);
+
+public:
+	static constexpr float KDefaultMaxPixelError{ 1.0f };
+
+private:
+	static constexpr float KMinNormalDot{ 0.2f }; // Collapses that rotate a face normal further than ~78 degrees are rejected
+};
@@ -0,0 +1,127 @@
+#include "MeshletBuilder.h"
+
+static void CalculateMeshletBounds(const SMesh& Mesh, SMeshlet& Meshlet)
+{
+	const uint32_t KTriangleEnd{ Meshlet.TriangleOffset + Meshlet.TriangleCount };
+
+	// Bounding sphere (center of the AABB)
+	XMVECTOR Min{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR Max{ XMVectorReplicate(-FLT_MAX) };
+	for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < KTriangleEnd; ++iTriangle)
+	{
+		const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		for (uint32_t Index : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			Min = XMVectorMin(Min, Mesh.vVertices[Index].Position);
+			Max = XMVectorMax(Max, Mesh.vVertices[Index].Position);
+		}
+	}
+	XMVECTOR Center{ XMVectorSetW((Min + Max) * 0.5f, 0) };
+	float RadiusSquare{};
+	for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < KTriangleEnd; ++iTriangle)
+	{
+		const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		for (uint32_t Index : { Triangle.I0, Triangle.I1, Triangle.I2 })
+		{
+			XMVECTOR Offset{ XMVectorSetW(Mesh.vVertices[Index].Position, 0) - Center };
+			RadiusSquare = max(RadiusSquare, XMVectorGetX(XMVector3LengthSq(Offset)));
+		}
+	}
+	XMStoreFloat3(&Meshlet.BoundingSphereCenter, Center);
+	Meshlet.BoundingSphereRadius = sqrtf(RadiusSquare);
+
+	// Normal cone (axis: average of the face normals)
+	vector<XMVECTOR> vFaceNormals{};
+	vFaceNormals.reserve(Meshlet.TriangleCount);
+	XMVECTOR AxisSum{};
+	for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < KTriangleEnd; ++iTriangle)
+	{
+		const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		const XMVECTOR& P0{ Mesh.vVertices[Triangle.I0].Position };
+		XMVECTOR Normal{ XMVector3Cross(Mesh.vVertices[Triangle.I1].Position - P0, Mesh.vVertices[Triangle.I2].Position - P0) };
+		if (XMVectorGetX(XMVector3LengthSq(Normal)) <= 0.0f) continue; // Degenerate
+
+		Normal = XMVector3Normalize(Normal);
+		vFaceNormals.emplace_back(Normal);
+		AxisSum += Normal;
+	}
+
+	Meshlet.ConeCutoff = 1.0f;
+	Meshlet.ConeAxis = XMFLOAT3(0, 0, 0);
+	Meshlet.ConeApex = Meshlet.BoundingSphereCenter;
+	if (vFaceNormals.empty() || XMVectorGetX(XMVector3LengthSq(AxisSum)) <= 0.0f) return;
+
+	XMVECTOR Axis{ XMVector3Normalize(AxisSum) };
+	float MinDot{ 1.0f };
+	for (const XMVECTOR& Normal : vFaceNormals)
+	{
+		MinDot = min(MinDot, XMVectorGetX(XMVector3Dot(Normal, Axis)));
+	}
+	XMStoreFloat3(&Meshlet.ConeAxis, Axis);
+
+	// @important: the cone is wider than a hemisphere, so some triangles always face the camera
+	if (MinDot <= 0.1f) return;
+
+	// Apex: moved back along the axis until every triangle's plane is in front of it
+	float MaxT{};
+	size_t iNormal{};
+	for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < KTriangleEnd; ++iTriangle)
+	{
+		const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		const XMVECTOR& P0{ Mesh.vVertices[Triangle.I0].Position };
+		XMVECTOR Normal{ XMVector3Cross(Mesh.vVertices[Triangle.I1].Position - P0, Mesh.vVertices[Triangle.I2].Position - P0) };
+		if (XMVectorGetX(XMVector3LengthSq(Normal)) <= 0.0f) continue;
+
+		const XMVECTOR& UnitNormal{ vFaceNormals[iNormal++] };
+		float DistanceToPlane{ XMVectorGetX(XMVector3Dot(Center - XMVectorSetW(P0, 0), UnitNormal)) };
+		float AxisDot{ XMVectorGetX(XMVector3Dot(Axis, UnitNormal)) };
+		MaxT = max(MaxT, DistanceToPlane / AxisDot);
+	}
+	XMStoreFloat3(&Meshlet.ConeApex, Center - Axis * MaxT);
+	Meshlet.ConeCutoff = sqrtf(1.0f - MinDot * MinDot);
+}
+
+void CMeshletBuilder::BuildMeshlets(const SMesh& Mesh, vector<SMeshlet>& vOutMeshlets, uint32_t MaxVertexCount, uint32_t MaxTriangleCount)
+{
+	vOutMeshlets.clear();
+	if (Mesh.vTriangles.empty()) return;
+
+	// Meshlet index + 1 of the last meshlet that used the vertex
+	vector<uint32_t> vVertexStamps(Mesh.vVertices.size());
+
+	SMeshlet Meshlet{};
+	uint32_t Stamp{ 1 };
+	for (uint32_t iTriangle = 0; iTriangle < static_cast<uint32_t>(Mesh.vTriangles.size()); ++iTriangle)
+	{
+		const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+		uint32_t NewVertexCount{};
+		NewVertexCount += (vVertexStamps[Triangle.I0] != Stamp) ? 1 : 0;
+		NewVertexCount += (vVertexStamps[Triangle.I1] != Stamp && Triangle.I1 != Triangle.I0) ? 1 : 0;
+		NewVertexCount += (vVertexStamps[Triangle.I2] != Stamp && Triangle.I2 != Triangle.I0 && Triangle.I2 != Triangle.I1) ? 1 : 0;
+
+		if (Meshlet.VertexCount + NewVertexCount > MaxVertexCount || Meshlet.TriangleCount + 1 > MaxTriangleCount)
+		{
+			vOutMeshlets.emplace_back(Meshlet);
+
+			Meshlet = SMeshlet{};
+			Meshlet.TriangleOffset = iTriangle;
+			++Stamp;
+			NewVertexCount = 3 - ((Triangle.I1 == Triangle.I0) ? 1 : 0) - ((Triangle.I2 == Triangle.I0 || Triangle.I2 == Triangle.I1) ? 1 : 0);
+		}
+
+		vVertexStamps[Triangle.I0] = vVertexStamps[Triangle.I1] = vVertexStamps[Triangle.I2] = Stamp;
+		Meshlet.VertexCount += NewVertexCount;
+		++Meshlet.TriangleCount;
+	}
+	vOutMeshlets.emplace_back(Meshlet);
+
+	UpdateMeshletBounds(Mesh, vOutMeshlets);
+}
+
+void CMeshletBuilder::UpdateMeshletBounds(const SMesh& Mesh, vector<SMeshlet>& vMeshlets)
+{
+	for (SMeshlet& Meshlet : vMeshlets)
+	{
+		CalculateMeshletBounds(Mesh, Meshlet);
+	}
+}
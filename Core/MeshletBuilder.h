@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AssimpLoader.h"
+
+// A contiguous range of SMesh::vTriangles (D3D11 has no mesh shaders, so meshlets are drawn as index ranges)
+struct SMeshlet
+{
+	uint32_t	TriangleOffset{};
+	uint32_t	TriangleCount{};
+	uint32_t	VertexCount{}; // Unique vertices
+
+	XMFLOAT3	BoundingSphereCenter{};
+	float		BoundingSphereRadius{};
+
+	// Normal cone: every triangle is back-facing if dot(normalize(ConeApex - EyePosition), ConeAxis) >= ConeCutoff
+	XMFLOAT3	ConeApex{};
+	XMFLOAT3	ConeAxis{};
+	float		ConeCutoff{ 1.0f }; // 1: the cone is too wide to cull
+};
+
+// Splits an SMesh into meshlets in its current triangle order (so optimize the mesh for the vertex cache first)
+class CMeshletBuilder
+{
+public:
+	static void BuildMeshlets(const SMesh& Mesh, vector<SMeshlet>& vOutMeshlets,
+		uint32_t MaxVertexCount = KMaxVertexCount, uint32_t MaxTriangleCount = KMaxTriangleCount);
+
+	// Recalculates the bounds after the vertices have been edited
+	static void UpdateMeshletBounds(const SMesh& Mesh, vector<SMeshlet>& vMeshlets);
+
+public:
+	static constexpr uint32_t KMaxVertexCount{ 64 };
+	static constexpr uint32_t KMaxTriangleCount{ 124 };
+};
@@ -0,0 +1,119 @@
+#include "MeshletCuller.h"
+
+CMeshletCuller::SFrustum CMeshletCuller::ExtractFrustum(const XMMATRIX& ViewProjection)
+{
+	// Gribb & Hartmann; clip = v * ViewProjection, so the planes are built from the columns
+	XMMATRIX Transposed{ XMMatrixTranspose(ViewProjection) };
+	const XMVECTOR& Column0{ Transposed.r[0] };
+	const XMVECTOR& Column1{ Transposed.r[1] };
+	const XMVECTOR& Column2{ Transposed.r[2] };
+	const XMVECTOR& Column3{ Transposed.r[3] };
+
+	const XMVECTOR KPlanes[6]
+	{
+		Column3 + Column0, // Left
+		Column3 - Column0, // Right
+		Column3 + Column1, // Bottom
+		Column3 - Column1, // Top
+		Column2, // Near (D3D: 0 <= z)
+		Column3 - Column2, // Far
+	};
+
+	SFrustum Frustum{};
+	for (int iPlane = 0; iPlane < 6; ++iPlane)
+	{
+		XMStoreFloat4(&Frustum.Planes[iPlane], XMPlaneNormalize(KPlanes[iPlane]));
+	}
+	return Frustum;
+}
+
+bool CMeshletCuller::IsSphereInFrustum(const SFrustum& Frustum, const XMVECTOR& Center, float Radius)
+{
+	for (const XMFLOAT4& Plane : Frustum.Planes)
+	{
+		if (XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&Plane), Center)) < -Radius) return false;
+	}
+	return true;
+}
+
+void CMeshletCuller::CullMeshlets(const vector<SMeshlet>& vMeshlets, const XMMATRIX& World, const SFrustum& Frustum, const XMVECTOR& EyePosition,
+	vector<SDrawIndexedArgs>& vOutDraws, const SDesc& Desc, SStats* const PtrOutStats)
+{
+	const float KScaleX{ XMVectorGetX(XMVector3Length(World.r[0])) };
+	const float KScaleY{ XMVectorGetX(XMVector3Length(World.r[1])) };
+	const float KScaleZ{ XMVectorGetX(XMVector3Length(World.r[2])) };
+	const float KMaxScale{ max(KScaleX, max(KScaleY, KScaleZ)) };
+	const float KMinScale{ min(KScaleX, min(KScaleY, KScaleZ)) };
+	const bool KbUseConeCulling{ Desc.bUseConeCulling && KMinScale > 0.0f && (KMaxScale - KMinScale) <= KMaxScale * KMaxUniformScaleDeviation };
+
+	const XMVECTOR KEyePosition{ XMVectorSetW(EyePosition, 1.0f) };
+
+	SStats Stats{};
+	bool bIsPreviousVisible{};
+	for (const SMeshlet& Meshlet : vMeshlets)
+	{
+		++Stats.MeshletCount;
+		Stats.TriangleCount += Meshlet.TriangleCount;
+
+		XMVECTOR Center{ XMVector3TransformCoord(XMLoadFloat3(&Meshlet.BoundingSphereCenter), World) };
+		float Radius{ Meshlet.BoundingSphereRadius * KMaxScale };
+
+		// Distance
+		float Distance{ XMVectorGetX(XMVector3Length(Center - KEyePosition)) };
+		if (Distance - Radius > Desc.MaxDistance)
+		{
+			++Stats.DistanceCulledCount;
+			bIsPreviousVisible = false;
+			continue;
+		}
+
+		// Frustum
+		if (Desc.bUseFrustumCulling && !IsSphereInFrustum(Frustum, Center, Radius))
+		{
+			++Stats.FrustumCulledCount;
+			bIsPreviousVisible = false;
+			continue;
+		}
+
+		// Normal cone
+		if (KbUseConeCulling && Meshlet.ConeCutoff < 1.0f)
+		{
+			XMVECTOR Apex{ XMVector3TransformCoord(XMLoadFloat3(&Meshlet.ConeApex), World) };
+			XMVECTOR Axis{ XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&Meshlet.ConeAxis), World)) };
+			if (XMVectorGetX(XMVector3Dot(XMVector3Normalize(Apex - KEyePosition), Axis)) >= Meshlet.ConeCutoff)
+			{
+				++Stats.ConeCulledCount;
+				bIsPreviousVisible = false;
+				continue;
+			}
+		}
+
+		++Stats.VisibleMeshletCount;
+		Stats.VisibleTriangleCount += Meshlet.TriangleCount;
+		if (bIsPreviousVisible)
+		{
+			vOutDraws.back().IndexCountPerInstance += Meshlet.TriangleCount * 3;
+		}
+		else
+		{
+			SDrawIndexedArgs Draw{};
+			Draw.IndexCountPerInstance = Meshlet.TriangleCount * 3;
+			Draw.StartIndexLocation = Meshlet.TriangleOffset * 3;
+			vOutDraws.emplace_back(Draw);
+			++Stats.DrawCount;
+		}
+		bIsPreviousVisible = true;
+	}
+
+	if (PtrOutStats)
+	{
+		PtrOutStats->MeshletCount += Stats.MeshletCount;
+		PtrOutStats->VisibleMeshletCount += Stats.VisibleMeshletCount;
+		PtrOutStats->TriangleCount += Stats.TriangleCount;
+		PtrOutStats->VisibleTriangleCount += Stats.VisibleTriangleCount;
+		PtrOutStats->FrustumCulledCount += Stats.FrustumCulledCount;
+		PtrOutStats->ConeCulledCount += Stats.ConeCulledCount;
+		PtrOutStats->DistanceCulledCount += Stats.DistanceCulledCount;
+		PtrOutStats->DrawCount += Stats.DrawCount;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MeshletBuilder.h"
+
+// Same layout as D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS
+struct SDrawIndexedArgs
+{
+	uint32_t	IndexCountPerInstance{};
+	uint32_t	InstanceCount{ 1 };
+	uint32_t	StartIndexLocation{};
+	int32_t		BaseVertexLocation{};
+	uint32_t	StartInstanceLocation{};
+};
+
+// Per-frame CPU culling of meshlets (frustum, back-facing normal cone and distance)
+class CMeshletCuller
+{
+public:
+	struct SFrustum
+	{
+		XMFLOAT4	Planes[6]{}; // Normalized, pointing inwards
+	};
+
+	struct SDesc
+	{
+		SDesc() {}
+
+		float		MaxDistance{ FLT_MAX }; // From the eye to the bounding sphere
+		bool		bUseFrustumCulling{ true };
+		bool		bUseConeCulling{ true };
+	};
+
+	struct SStats
+	{
+		size_t		MeshletCount{};
+		size_t		VisibleMeshletCount{};
+		size_t		TriangleCount{};
+		size_t		VisibleTriangleCount{};
+		size_t		FrustumCulledCount{}; // Meshlets
+		size_t		ConeCulledCount{}; // Meshlets
+		size_t		DistanceCulledCount{}; // Meshlets
+		size_t		DrawCount{}; // Merged index ranges
+	};
+
+public:
+	// World-space planes if ViewProjection = View * Projection
+	static SFrustum ExtractFrustum(const XMMATRIX& ViewProjection);
+
+	static bool IsSphereInFrustum(const SFrustum& Frustum, const XMVECTOR& Center, float Radius);
+
+	// Appends the visible meshlets to vOutDraws as index ranges (adjacent meshlets are merged); stats are accumulated
+	static void CullMeshlets(const vector<SMeshlet>& vMeshlets, const XMMATRIX& World, const SFrustum& Frustum, const XMVECTOR& EyePosition,
+		vector<SDrawIndexedArgs>& vOutDraws, const SDesc& Desc = SDesc(), SStats* const PtrOutStats = nullptr);
+
+private:
+	static constexpr float KMaxUniformScaleDeviation{ 0.01f }; // Cone culling is disabled for non-uniformly scaled objects
+};
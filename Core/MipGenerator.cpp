@@ -0,0 +1,441 @@
+#include "MipGenerator.h"
+#include "WorkerPool.h"
+
+static constexpr float KKaiserAlpha{ 4.0f };
+static constexpr float KFilterSupports[]{ 0.5f, 2.0f, 2.0f }; // In destination texels (Box, Kaiser, Lanczos)
+static constexpr uint32_t KLinearToSRGBTableSize{ 4096 };
+
+struct SConversionTables
+{
+	SConversionTables()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			float C{ i / 255.0f };
+			SRGBToLinear[i] = (C <= 0.04045f) ? C / 12.92f : powf((C + 0.055f) / 1.055f, 2.4f);
+		}
+		for (uint32_t i = 0; i < KLinearToSRGBTableSize; ++i)
+		{
+			float L{ i / static_cast<float>(KLinearToSRGBTableSize - 1) };
+			float C{ (L <= 0.0031308f) ? L * 12.92f : 1.055f * powf(L, 1.0f / 2.4f) - 0.055f };
+			LinearToSRGB[i] = static_cast<uint8_t>(min(max(C, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+	float	SRGBToLinear[256]{};
+	uint8_t	LinearToSRGB[KLinearToSRGBTableSize]{};
+};
+
+struct SFilterTable
+{
+	uint32_t		Stride{};
+	vector<uint32_t> vCounts{};
+	vector<uint32_t> vIndices{}; // Clamped source indices
+	vector<float>	vWeights{};
+};
+
+static const SConversionTables& GetConversionTables()
+{
+	static const SConversionTables KTables{};
+	return KTables;
+}
+
+static float BesselI0(float X)
+{
+	float Sum{ 1.0f };
+	float Term{ 1.0f };
+	float HalfXSquared{ X * X * 0.25f };
+	for (int k = 1; k < 32; ++k)
+	{
+		Term *= HalfXSquared / static_cast<float>(k * k);
+		Sum += Term;
+		if (Term < Sum * 1e-7f) break;
+	}
+	return Sum;
+}
+
+static float Sinc(float X)
+{
+	if (fabsf(X) < 1e-5f) return 1.0f;
+	X *= XM_PI;
+	return sinf(X) / X;
+}
+
+static float EvaluateFilter(CMipGenerator::EFilter eFilter, float T)
+{
+	T = fabsf(T);
+	switch (eFilter)
+	{
+	case CMipGenerator::EFilter::Box:
+		return (T <= 0.5f) ? 1.0f : 0.0f;
+	case CMipGenerator::EFilter::Kaiser:
+	{
+		const float KWidth{ KFilterSupports[(int)CMipGenerator::EFilter::Kaiser] };
+		if (T >= KWidth) return 0.0f;
+		float R{ T / KWidth };
+		return Sinc(T) * BesselI0(KKaiserAlpha * sqrtf(1.0f - R * R)) / BesselI0(KKaiserAlpha);
+	}
+	case CMipGenerator::EFilter::Lanczos:
+	{
+		const float KWidth{ KFilterSupports[(int)CMipGenerator::EFilter::Lanczos] };
+		if (T >= KWidth) return 0.0f;
+		return Sinc(T) * Sinc(T / KWidth);
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+static void BuildFilterTable(CMipGenerator::EFilter eFilter, uint32_t SrcSize, uint32_t DestSize, SFilterTable& OutTable)
+{
+	const float KScale{ static_cast<float>(SrcSize) / static_cast<float>(DestSize) };
+	const float KSupport{ KFilterSupports[(int)eFilter] * KScale }; // In source texels
+
+	OutTable.Stride = static_cast<uint32_t>(ceilf(KSupport * 2.0f)) + 2;
+	OutTable.vCounts.assign(DestSize, 0);
+	OutTable.vIndices.assign(static_cast<size_t>(DestSize) * OutTable.Stride, 0);
+	OutTable.vWeights.assign(static_cast<size_t>(DestSize) * OutTable.Stride, 0.0f);
+
+	for (uint32_t iDest = 0; iDest < DestSize; ++iDest)
+	{
+		const float KCenter{ (iDest + 0.5f) * KScale };
+		const int KFirst{ static_cast<int>(floorf(KCenter - KSupport)) };
+		const int KLast{ static_cast<int>(ceilf(KCenter + KSupport)) };
+
+		uint32_t* const PtrIndices{ &OutTable.vIndices[static_cast<size_t>(iDest) * OutTable.Stride] };
+		float* const PtrWeights{ &OutTable.vWeights[static_cast<size_t>(iDest) * OutTable.Stride] };
+		uint32_t& Count{ OutTable.vCounts[iDest] };
+
+		float WeightSum{};
+		for (int iSrc = KFirst; iSrc <= KLast && Count < OutTable.Stride; ++iSrc)
+		{
+			float Weight{ EvaluateFilter(eFilter, (iSrc + 0.5f - KCenter) / KScale) };
+			if (Weight == 0.0f) continue;
+
+			PtrIndices[Count] = static_cast<uint32_t>(min(max(iSrc, 0), static_cast<int>(SrcSize) - 1));
+			PtrWeights[Count] = Weight;
+			WeightSum += Weight;
+			++Count;
+		}
+
+		if (Count == 0 || WeightSum == 0.0f)
+		{
+			Count = 1;
+			PtrIndices[0] = min(static_cast<uint32_t>(KCenter), SrcSize - 1);
+			PtrWeights[0] = 1.0f;
+			continue;
+		}
+
+		for (uint32_t iTap = 0; iTap < Count; ++iTap) PtrWeights[iTap] /= WeightSum;
+	}
+}
+
+static XMVECTOR LoadPixel(const SPixel8UInt& Pixel, bool bIsSRGB)
+{
+	return XMVectorSet(Pixel.R / 255.0f, 0, 0, 0);
+}
+
+static XMVECTOR LoadPixel(const SPixel32UInt& Pixel, bool bIsSRGB)
+{
+	if (bIsSRGB)
+	{
+		const SConversionTables& KTables{ GetConversionTables() };
+		return XMVectorSet(KTables.SRGBToLinear[Pixel.R], KTables.SRGBToLinear[Pixel.G], KTables.SRGBToLinear[Pixel.B], Pixel.A / 255.0f);
+	}
+	return XMVectorScale(XMVectorSet(Pixel.R, Pixel.G, Pixel.B, Pixel.A), 1.0f / 255.0f);
+}
+
+static void StorePixel(FXMVECTOR Value, bool bIsSRGB, SPixel8UInt& OutPixel)
+{
+	OutPixel.R = static_cast<uint8_t>(XMVectorGetX(XMVectorSaturate(Value)) * 255.0f + 0.5f);
+}
+
+static void StorePixel(FXMVECTOR Value, bool bIsSRGB, SPixel32UInt& OutPixel)
+{
+	XMFLOAT4 Color{};
+	XMStoreFloat4(&Color, XMVectorSaturate(Value));
+	if (bIsSRGB)
+	{
+		const SConversionTables& KTables{ GetConversionTables() };
+		const float KLastIndex{ static_cast<float>(KLinearToSRGBTableSize - 1) };
+		OutPixel.R = KTables.LinearToSRGB[static_cast<uint32_t>(Color.x * KLastIndex + 0.5f)];
+		OutPixel.G = KTables.LinearToSRGB[static_cast<uint32_t>(Color.y * KLastIndex + 0.5f)];
+		OutPixel.B = KTables.LinearToSRGB[static_cast<uint32_t>(Color.z * KLastIndex + 0.5f)];
+	}
+	else
+	{
+		OutPixel.R = static_cast<uint8_t>(Color.x * 255.0f + 0.5f);
+		OutPixel.G = static_cast<uint8_t>(Color.y * 255.0f + 0.5f);
+		OutPixel.B = static_cast<uint8_t>(Color.z * 255.0f + 0.5f);
+	}
+	OutPixel.A = static_cast<uint8_t>(Color.w * 255.0f + 0.5f);
+}
+
+// Separable filtering of one tile (a band of destination rows)
+template <typename TPixel>
+static void DownsampleTile(const TPixel* const PtrSrc, uint32_t SrcWidth, TPixel* const PtrDest, uint32_t DestWidth,
+	const SFilterTable& TableX, const SFilterTable& TableY, bool bIsSRGB, const CMipGenerator::SRect& Tile, vector<XMFLOAT4>& vRowBuffer)
+{
+	uint32_t RowMin{ UINT32_MAX };
+	uint32_t RowMax{};
+	for (uint32_t y = Tile.Top; y < Tile.Bottom; ++y)
+	{
+		const uint32_t* const PtrIndices{ &TableY.vIndices[static_cast<size_t>(y) * TableY.Stride] };
+		RowMin = min(RowMin, PtrIndices[0]);
+		RowMax = max(RowMax, PtrIndices[TableY.vCounts[y] - 1]);
+	}
+
+	const uint32_t KTileWidth{ Tile.Right - Tile.Left };
+	vRowBuffer.resize(static_cast<size_t>(RowMax - RowMin + 1) * KTileWidth);
+
+	// Horizontal pass
+	for (uint32_t iRow = RowMin; iRow <= RowMax; ++iRow)
+	{
+		const TPixel* const PtrSrcRow{ PtrSrc + static_cast<size_t>(iRow) * SrcWidth };
+		XMFLOAT4* const PtrBufferRow{ &vRowBuffer[static_cast<size_t>(iRow - RowMin) * KTileWidth] };
+		for (uint32_t x = Tile.Left; x < Tile.Right; ++x)
+		{
+			const size_t KTableOffset{ static_cast<size_t>(x) * TableX.Stride };
+			XMVECTOR Sum{ XMVectorZero() };
+			for (uint32_t iTap = 0; iTap < TableX.vCounts[x]; ++iTap)
+			{
+				Sum = XMVectorMultiplyAdd(LoadPixel(PtrSrcRow[TableX.vIndices[KTableOffset + iTap]], bIsSRGB),
+					XMVectorReplicate(TableX.vWeights[KTableOffset + iTap]), Sum);
+			}
+			XMStoreFloat4(&PtrBufferRow[x - Tile.Left], Sum);
+		}
+	}
+
+	// Vertical pass
+	for (uint32_t y = Tile.Top; y < Tile.Bottom; ++y)
+	{
+		const size_t KTableOffset{ static_cast<size_t>(y) * TableY.Stride };
+		TPixel* const PtrDestRow{ PtrDest + static_cast<size_t>(y) * DestWidth };
+		for (uint32_t x = Tile.Left; x < Tile.Right; ++x)
+		{
+			XMVECTOR Sum{ XMVectorZero() };
+			for (uint32_t iTap = 0; iTap < TableY.vCounts[y]; ++iTap)
+			{
+				const XMFLOAT4& Value{ vRowBuffer[static_cast<size_t>(TableY.vIndices[KTableOffset + iTap] - RowMin) * KTileWidth + (x - Tile.Left)] };
+				Sum = XMVectorMultiplyAdd(XMLoadFloat4(&Value), XMVectorReplicate(TableY.vWeights[KTableOffset + iTap]), Sum);
+			}
+			StorePixel(Sum, bIsSRGB, PtrDestRow[x]);
+		}
+	}
+}
+
+template <typename TPixel>
+static void DownsampleRegion(const TPixel* const PtrSrc, uint32_t SrcWidth, uint32_t SrcHeight, TPixel* const PtrDest, uint32_t DestWidth,
+	uint32_t DestHeight, const CMipGenerator::SDesc& Desc, const CMipGenerator::SRect& Region)
+{
+	SFilterTable TableX{};
+	SFilterTable TableY{};
+	BuildFilterTable(Desc.eFilter, SrcWidth, DestWidth, TableX);
+	BuildFilterTable(Desc.eFilter, SrcHeight, DestHeight, TableY);
+
+	const uint32_t KTileCount{ (Region.Bottom - Region.Top + CMipGenerator::KTileRowCount - 1) / CMipGenerator::KTileRowCount };
+	const size_t KPixelCount{ static_cast<size_t>(Region.Right - Region.Left) * (Region.Bottom - Region.Top) };
+	const uint32_t KThreadCount{ (KPixelCount < CMipGenerator::KMultithreadingMinPixelCount) ? 1u : 0u };
+
+	CWorkerPool::GetShared().ForEach(KTileCount, KThreadCount, [&](uint32_t iTile)
+		{
+			// Reused by the tiles each thread runs
+			static thread_local vector<XMFLOAT4> vRowBuffer{};
+
+			CMipGenerator::SRect Tile{ Region };
+			Tile.Top = Region.Top + iTile * CMipGenerator::KTileRowCount;
+			Tile.Bottom = min(Tile.Top + CMipGenerator::KTileRowCount, Region.Bottom);
+			DownsampleTile(PtrSrc, SrcWidth, PtrDest, DestWidth, TableX, TableY, Desc.bIsSRGB, Tile, vRowBuffer);
+		});
+}
+
+static float CalculateAlphaCoverage(const SPixel32UInt* const PtrPixels, size_t PixelCount, float Reference, float Scale)
+{
+	size_t CoveredCount{};
+	for (size_t iPixel = 0; iPixel < PixelCount; ++iPixel)
+	{
+		if (PtrPixels[iPixel].A / 255.0f * Scale > Reference) ++CoveredCount;
+	}
+	return static_cast<float>(CoveredCount) / static_cast<float>(max(PixelCount, (size_t)1));
+}
+
+static void PreserveAlphaCoverage(const SPixel32UInt* const PtrSource, size_t SourcePixelCount, float Reference,
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>>& vMipChain)
+{
+	const float KTargetCoverage{ CalculateAlphaCoverage(PtrSource, SourcePixelCount, Reference, 1.0f) };
+	for (auto& Level : vMipChain)
+	{
+		// Binary search for the alpha scale that matches the coverage of mip 0
+		float MinScale{ 0.0f };
+		float MaxScale{ 4.0f };
+		for (int iIteration = 0; iIteration < 10; ++iIteration)
+		{
+			float Scale{ (MinScale + MaxScale) * 0.5f };
+			if (CalculateAlphaCoverage(Level.vPixels.data(), Level.vPixels.size(), Reference, Scale) < KTargetCoverage)
+			{
+				MinScale = Scale;
+			}
+			else
+			{
+				MaxScale = Scale;
+			}
+		}
+
+		const float KScale{ (MinScale + MaxScale) * 0.5f };
+		for (auto& Pixel : Level.vPixels)
+		{
+			Pixel.A = static_cast<uint8_t>(min(Pixel.A * KScale + 0.5f, 255.0f));
+		}
+	}
+}
+
+static void PreserveAlphaCoverage(const SPixel8UInt* const, size_t, float, vector<CMipGenerator::SMipLevel<SPixel8UInt>>&)
+{
+	// Single-channel textures have no alpha
+}
+
+template <typename TPixel>
+static void GenerateMipChainImpl(const TPixel* const PtrSource, uint32_t Width, uint32_t Height, const CMipGenerator::SDesc& Desc,
+	vector<CMipGenerator::SMipLevel<TPixel>>& vOutMipChain, CMipGenerator::SStats* const PtrOutStats)
+{
+	assert(PtrSource);
+	assert(Width && Height);
+
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+	size_t PixelCount{};
+
+	vOutMipChain.clear();
+	vOutMipChain.reserve(CMipGenerator::GetMipCount(Width, Height) - 1);
+
+	const TPixel* PtrPrev{ PtrSource };
+	uint32_t PrevWidth{ Width };
+	uint32_t PrevHeight{ Height };
+	while (PrevWidth > 1 || PrevHeight > 1)
+	{
+		vOutMipChain.emplace_back();
+
+		CMipGenerator::SMipLevel<TPixel>& Level{ vOutMipChain.back() };
+		Level.Width = max(PrevWidth / 2, 1u);
+		Level.Height = max(PrevHeight / 2, 1u);
+		Level.vPixels.resize(static_cast<size_t>(Level.Width) * Level.Height);
+
+		DownsampleRegion(PtrPrev, PrevWidth, PrevHeight, Level.vPixels.data(), Level.Width, Level.Height, Desc,
+			CMipGenerator::SRect{ 0, 0, Level.Width, Level.Height });
+
+		PixelCount += Level.vPixels.size();
+		PtrPrev = Level.vPixels.data();
+		PrevWidth = Level.Width;
+		PrevHeight = Level.Height;
+	}
+
+	if (Desc.bShouldPreserveAlphaCoverage)
+	{
+		PreserveAlphaCoverage(PtrSource, static_cast<size_t>(Width) * Height, Desc.AlphaCoverageReference, vOutMipChain);
+	}
+
+	if (PtrOutStats)
+	{
+		PtrOutStats->PixelCount = PixelCount;
+		PtrOutStats->ElapsedMilliseconds = GetTickCount64() - StartTimePoint;
+		PtrOutStats->MegaPixelsPerSecond = static_cast<float>(PixelCount) / 1'000.0f / static_cast<float>(max(PtrOutStats->ElapsedMilliseconds, 1ULL));
+	}
+}
+
+template <typename TPixel>
+static void UpdateMipChainImpl(const TPixel* const PtrSource, uint32_t Width, uint32_t Height, const CMipGenerator::SDesc& Desc,
+	const CMipGenerator::SRect& DirtyRect, vector<CMipGenerator::SMipLevel<TPixel>>& vMipChain, vector<CMipGenerator::SRect>& vOutDirtyRects)
+{
+	assert(vMipChain.size() + 1 == CMipGenerator::GetMipCount(Width, Height));
+
+	vOutDirtyRects.clear();
+
+	CMipGenerator::SRect Dirty{ DirtyRect };
+	Dirty.Right = min(Dirty.Right, Width);
+	Dirty.Bottom = min(Dirty.Bottom, Height);
+
+	const TPixel* PtrPrev{ PtrSource };
+	uint32_t PrevWidth{ Width };
+	uint32_t PrevHeight{ Height };
+	for (auto& Level : vMipChain)
+	{
+		CMipGenerator::SRect Region{};
+		if (!Dirty.IsEmpty())
+		{
+			SFilterTable TableX{};
+			SFilterTable TableY{};
+			BuildFilterTable(Desc.eFilter, PrevWidth, Level.Width, TableX);
+			BuildFilterTable(Desc.eFilter, PrevHeight, Level.Height, TableY);
+
+			// Every destination texel with at least one tap inside the dirty region
+			Region.Left = Level.Width;
+			Region.Top = Level.Height;
+			for (uint32_t x = 0; x < Level.Width; ++x)
+			{
+				uint32_t First{ TableX.vIndices[static_cast<size_t>(x) * TableX.Stride] };
+				uint32_t Last{ TableX.vIndices[static_cast<size_t>(x) * TableX.Stride + TableX.vCounts[x] - 1] };
+				if (Last >= Dirty.Left && First < Dirty.Right)
+				{
+					Region.Left = min(Region.Left, x);
+					Region.Right = x + 1;
+				}
+			}
+			for (uint32_t y = 0; y < Level.Height; ++y)
+			{
+				uint32_t First{ TableY.vIndices[static_cast<size_t>(y) * TableY.Stride] };
+				uint32_t Last{ TableY.vIndices[static_cast<size_t>(y) * TableY.Stride + TableY.vCounts[y] - 1] };
+				if (Last >= Dirty.Top && First < Dirty.Bottom)
+				{
+					Region.Top = min(Region.Top, y);
+					Region.Bottom = y + 1;
+				}
+			}
+
+			if (!Region.IsEmpty())
+			{
+				DownsampleRegion(PtrPrev, PrevWidth, PrevHeight, Level.vPixels.data(), Level.Width, Level.Height, Desc, Region);
+			}
+		}
+
+		vOutDirtyRects.emplace_back(Region);
+		Dirty = Region;
+		PtrPrev = Level.vPixels.data();
+		PrevWidth = Level.Width;
+		PrevHeight = Level.Height;
+	}
+}
+
+void CMipGenerator::GenerateMipChain(const SPixel8UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	vector<SMipLevel<SPixel8UInt>>& vOutMipChain, SStats* const PtrOutStats)
+{
+	GenerateMipChainImpl(PtrSource, Width, Height, Desc, vOutMipChain, PtrOutStats);
+}
+
+void CMipGenerator::GenerateMipChain(const SPixel32UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	vector<SMipLevel<SPixel32UInt>>& vOutMipChain, SStats* const PtrOutStats)
+{
+	GenerateMipChainImpl(PtrSource, Width, Height, Desc, vOutMipChain, PtrOutStats);
+}
+
+void CMipGenerator::UpdateMipChain(const SPixel8UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const SRect& DirtyRect, vector<SMipLevel<SPixel8UInt>>& vMipChain, vector<SRect>& vOutDirtyRects)
+{
+	UpdateMipChainImpl(PtrSource, Width, Height, Desc, DirtyRect, vMipChain, vOutDirtyRects);
+}
+
+void CMipGenerator::UpdateMipChain(const SPixel32UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const SRect& DirtyRect, vector<SMipLevel<SPixel32UInt>>& vMipChain, vector<SRect>& vOutDirtyRects)
+{
+	UpdateMipChainImpl(PtrSource, Width, Height, Desc, DirtyRect, vMipChain, vOutDirtyRects);
+}
+
+UINT CMipGenerator::GetMipCount(uint32_t Width, uint32_t Height)
+{
+	UINT MipCount{ 1 };
+	uint32_t Size{ max(Width, Height) };
+	while (Size > 1)
+	{
+		Size /= 2;
+		++MipCount;
+	}
+	return MipCount;
+}
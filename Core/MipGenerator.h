@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "Material.h"
+
+class CMipGenerator
+{
+public:
+	enum class EFilter
+	{
+		Box, // 2x2 average
+		Kaiser, // Kaiser-windowed sinc (width 2, alpha 4)
+		Lanczos // Lanczos2
+	};
+
+	struct SDesc
+	{
+		SDesc() {}
+		SDesc(EFilter _eFilter, bool _bIsSRGB = false, bool _bShouldPreserveAlphaCoverage = false, float _AlphaCoverageReference = 0.5f) :
+			eFilter{ _eFilter }, bIsSRGB{ _bIsSRGB }, bShouldPreserveAlphaCoverage{ _bShouldPreserveAlphaCoverage },
+			AlphaCoverageReference{ _AlphaCoverageReference } {}
+
+		EFilter	eFilter{ EFilter::Box };
+		bool	bIsSRGB{ false }; // RGB is filtered in linear space, alpha is always linear
+		bool	bShouldPreserveAlphaCoverage{ false }; // For alpha-tested textures
+		float	AlphaCoverageReference{ 0.5f };
+	};
+
+	template <typename TPixel>
+	struct SMipLevel
+	{
+		uint32_t		Width{};
+		uint32_t		Height{};
+		vector<TPixel>	vPixels{};
+	};
+
+	// [Left, Right) x [Top, Bottom)
+	struct SRect
+	{
+		uint32_t	Left{};
+		uint32_t	Top{};
+		uint32_t	Right{};
+		uint32_t	Bottom{};
+
+		bool IsEmpty() const { return (Left >= Right) || (Top >= Bottom); }
+	};
+
+	struct SStats
+	{
+		size_t		PixelCount{}; // Written pixels, all levels
+		ULONGLONG	ElapsedMilliseconds{};
+		float		MegaPixelsPerSecond{};
+	};
+
+public:
+	// vOutMipChain excludes the source level (mip 0), so vOutMipChain[0] is mip 1
+	static void GenerateMipChain(const SPixel8UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		vector<SMipLevel<SPixel8UInt>>& vOutMipChain, SStats* const PtrOutStats = nullptr);
+	static void GenerateMipChain(const SPixel32UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		vector<SMipLevel<SPixel32UInt>>& vOutMipChain, SStats* const PtrOutStats = nullptr);
+
+	// Regenerates only the texels of each level that are affected by DirtyRect (in mip 0 texels)
+	// vOutDirtyRects[i] is the updated region of vMipChain[i]
+	// @important: alpha coverage is not re-evaluated here
+	static void UpdateMipChain(const SPixel8UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const SRect& DirtyRect, vector<SMipLevel<SPixel8UInt>>& vMipChain, vector<SRect>& vOutDirtyRects);
+	static void UpdateMipChain(const SPixel32UInt* const PtrSource, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const SRect& DirtyRect, vector<SMipLevel<SPixel32UInt>>& vMipChain, vector<SRect>& vOutDirtyRects);
+
+	static UINT GetMipCount(uint32_t Width, uint32_t Height);
+
+public:
+	static constexpr uint32_t KTileRowCount{ 32 };
+	static constexpr size_t KMultithreadingMinPixelCount{ 128 * 128 };
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Object3D.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include <fstream>
 
 // ###########################
@@ -37,6 +39,11 @@
 // # 4B (uint32_t) vid 0
 // # 4B (uint32_t) vid 1
 // # 4B (uint32_t) vid 2
+// ##### LOD ##### (optional: older files end above)
+// # 1B (uint8_t) LOD count (per mesh, in mesh order)
+// # # 4B (float) relative error
+// # # 4B (uint32_t) Triangle count
+// # # 12B (uint32_t x 3) vid 0, 1, 2 (each triangle)
 // ###########################
 
 #define READ_BYTES(ByteCount) memset(ReadBytes, 0, sizeof(ReadBytes)); ifs.read(ReadBytes, ByteCount);
@@ -58,9 +65,12 @@
 static SModel ImportStaticModel(const string& FileName);
 static void _ReadStaticModelFile(std::ifstream& ifs, SModel& Model);
 static void _ReadModelMaterials(std::ifstream& ifs, vector<CMaterial>& vMaterials);
+static bool _ReadModelLODs(std::ifstream& ifs, vector<SMesh>& vMeshes);
+
 static void ExportStaticModel(const SModel& Model, const string& FileName);
 static void _WriteStaticModelFile(std::ofstream& ofs, const SModel& Model);
 static void _WriteModelMaterials(std::ofstream& ofs, const vector<CMaterial>& vMaterials);
+static void _WriteModelLODs(std::ofstream& ofs, const vector<SMesh>& vMeshes);
 
 static void GetByteFromBool(bool Value, char& Bytes)
 {
@@ -176,6 +186,20 @@ static SModel ImportStaticModel(const string& FileName)
 
 	SModel Model{};
 	_ReadStaticModelFile(ifs, Model);
+	bool bHasLODs{ _ReadModelLODs(ifs, Model.vMeshes) };
+
+	// @important: LODs index the stored vertices, so the vertices must keep their order
+	CMeshOptimizer::SDesc OptimizerDesc{};
+	OptimizerDesc.bShouldOptimizeVertexFetch = !bHasLODs;
+	for (SMesh& Mesh : Model.vMeshes)
+	{
+		CMeshOptimizer::OptimizeMesh(Mesh, OptimizerDesc);
+	}
+
+	if (!bHasLODs)
+	{
+		CMeshSimplifier::GenerateLODs(Model);
+	}
 
 	return Model;
 }
@@ -313,6 +337,37 @@ static void _ReadModelMaterials(std::ifstream& ifs, vector<CMaterial>& vMaterial
 	}
 }
 
+static bool _ReadModelLODs(std::ifstream& ifs, vector<SMesh>& vMeshes)
+{
+	char ReadBytes[512]{};
+
+	if (ifs.peek() == std::ifstream::traits_type::eof()) return false;
+
+	for (SMesh& Mesh : vMeshes)
+	{
+		// # 1B (uint8_t) LOD count
+		READ_BYTES(1);
+		Mesh.vLODs.resize(READ_BYTES_TO_UINT8);
+		for (SMeshLOD& LOD : Mesh.vLODs)
+		{
+			// # # 4B (float) relative error
+			READ_BYTES(4);
+			LOD.RelativeError = READ_BYTES_TO_FLOAT;
+
+			// # # 4B (uint32_t) Triangle count
+			READ_BYTES(4);
+			LOD.vTriangles.resize(READ_BYTES_TO_UINT32);
+			for (STriangle& Triangle : LOD.vTriangles)
+			{
+				// # # 12B (uint32_t x 3) vid 0, 1, 2
+				READ_BYTES(12);
+				memcpy(&Triangle, ReadBytes, sizeof(STriangle));
+			}
+		}
+	}
+	return true;
+}
+
 static void ExportStaticModel(const SModel& Model, const string& FileName)
 {
 	std::ofstream ofs{};
@@ -323,6 +378,7 @@ static void ExportStaticModel(const SModel& Model, const string& FileName)
 	ofs.write("SMOD_KJW", 8);
 
 	_WriteStaticModelFile(ofs, Model);
+	_WriteModelLODs(ofs, Model.vMeshes);
 
 	ofs.close();
 }
@@ -468,4 +524,28 @@ static void _WriteModelMaterials(std::ofstream& ofs, const vector<CMaterial>& vM
 
 		++iMaterial;
 	}
+}
+
+static void _WriteModelLODs(std::ofstream& ofs, const vector<SMesh>& vMeshes)
+{
+	char Uint32Bytes[4]{};
+	char FloatBytes[4]{};
+
+	for (const SMesh& Mesh : vMeshes)
+	{
+		// 1B (uint8_t) LOD count
+		ofs.put((uint8_t)Mesh.vLODs.size());
+
+		for (const SMeshLOD& LOD : Mesh.vLODs)
+		{
+			// 4B (float) relative error
+			WRITE_FLOAT_TO_BYTES(LOD.RelativeError);
+
+			// 4B (uint32_t) Triangle count
+			WRITE_UINT32_TO_BYTES(LOD.vTriangles.size());
+
+			// 12B (uint32_t x 3) vid 0, 1, 2
+			ofs.write(reinterpret_cast<const char*>(LOD.vTriangles.data()), sizeof(STriangle) * LOD.vTriangles.size());
+		}
+	}
 }
\ No newline at end of file
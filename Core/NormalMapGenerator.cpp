@@ -0,0 +1,189 @@
+#include "NormalMapGenerator.h"
+#include <DirectXPackedVector.h>
+
+using namespace PackedVector;
+
+// Sobel weights add up to 4 on each side of a texel, 2 texels apart, so the gradient is G / (8 * spacing)
+// The normal (-dH/dX, 1, -dH/dZ) is scaled by (8 * spacing) to skip the division; the encoding normalizes it anyway
+static void EncodeGradients(FXMVECTOR GradientU, FXMVECTOR GradientV, const CNormalMapGenerator::SDesc& Desc,
+	XMVECTOR& OutEncodedX, XMVECTOR& OutEncodedZ)
+{
+	const XMVECTOR KNormalX{ XMVectorScale(GradientU, -Desc.HeightScale) };
+	const XMVECTOR KNormalY{ XMVectorReplicate(8.0f * Desc.TexelSpacing) };
+	const XMVECTOR KNormalZ{ XMVectorScale(GradientV, +Desc.HeightScale) }; // +V is -Z
+	const XMVECTOR KL1Norm{ XMVectorAdd(XMVectorAdd(XMVectorAbs(KNormalX), KNormalY), XMVectorAbs(KNormalZ)) };
+	const XMVECTOR KScale{ XMVectorDivide(XMVectorReplicate(CNormalMapGenerator::KEncodingScale), KL1Norm) };
+
+	OutEncodedX = XMVectorRound(XMVectorMultiply(KNormalX, KScale));
+	OutEncodedZ = XMVectorRound(XMVectorMultiply(KNormalZ, KScale));
+}
+
+void CNormalMapGenerator::GenerateNormalMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	vector<SPixel16Int>& vOutNormals)
+{
+	vOutNormals.clear();
+	vOutNormals.resize(static_cast<size_t>(Width) * Height);
+	if (vOutNormals.empty()) return;
+
+	CMipGenerator::SRect Rect{};
+	Rect.Right = Width;
+	Rect.Bottom = Height;
+	FilterRect(PtrHeights, Width, Height, Desc, Rect, &vOutNormals[0]);
+}
+
+void CNormalMapGenerator::UpdateNormalMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const CMipGenerator::SRect& DirtyRect, vector<SPixel16Int>& vNormals, CMipGenerator::SRect& OutUpdatedRect)
+{
+	OutUpdatedRect = CMipGenerator::SRect();
+	if (vNormals.size() != static_cast<size_t>(Width) * Height)
+	{
+		GenerateNormalMap(PtrHeights, Width, Height, Desc, vNormals);
+		OutUpdatedRect.Right = Width;
+		OutUpdatedRect.Bottom = Height;
+		return;
+	}
+
+	// A height texel is a Sobel tap of its 8 neighbours
+	OutUpdatedRect.Left = (DirtyRect.Left > 0) ? DirtyRect.Left - 1 : 0;
+	OutUpdatedRect.Top = (DirtyRect.Top > 0) ? DirtyRect.Top - 1 : 0;
+	OutUpdatedRect.Right = min(DirtyRect.Right + 1, Width);
+	OutUpdatedRect.Bottom = min(DirtyRect.Bottom + 1, Height);
+	if (OutUpdatedRect.IsEmpty())
+	{
+		OutUpdatedRect = CMipGenerator::SRect();
+		return;
+	}
+
+	FilterRect(PtrHeights, Width, Height, Desc, OutUpdatedRect, &vNormals[0]);
+}
+
+SPixel16Int CNormalMapGenerator::EncodeNormal(const XMVECTOR& Normal)
+{
+	XMFLOAT3 N{};
+	XMStoreFloat3(&N, Normal);
+
+	float L1Norm{ fabsf(N.x) + fabsf(N.y) + fabsf(N.z) };
+	if (L1Norm <= 0.0f) return SPixel16Int{ 0, 0 };
+
+	float X{ N.x / L1Norm };
+	float Z{ N.z / L1Norm };
+	if (N.y < 0.0f)
+	{
+		// Lower hemisphere is folded over the diagonals
+		float FoldedX{ (1.0f - fabsf(Z)) * ((X >= 0.0f) ? +1.0f : -1.0f) };
+		float FoldedZ{ (1.0f - fabsf(X)) * ((Z >= 0.0f) ? +1.0f : -1.0f) };
+		X = FoldedX;
+		Z = FoldedZ;
+	}
+
+	SPixel16Int Result{};
+	Result.R = static_cast<int8_t>(roundf(X * KEncodingScale));
+	Result.G = static_cast<int8_t>(roundf(Z * KEncodingScale));
+	return Result;
+}
+
+XMVECTOR CNormalMapGenerator::DecodeNormal(const SPixel16Int& Encoded)
+{
+	// As R8G8_SNORM is sampled (-128 is -1 too)
+	float X{ max(Encoded.R / KEncodingScale, -1.0f) };
+	float Z{ max(Encoded.G / KEncodingScale, -1.0f) };
+	float Y{ 1.0f - fabsf(X) - fabsf(Z) };
+	if (Y < 0.0f)
+	{
+		X += (X >= 0.0f) ? Y : -Y;
+		Z += (Z >= 0.0f) ? Y : -Y;
+	}
+	return XMVector3Normalize(XMVectorSet(X, Y, Z, 0));
+}
+
+void CNormalMapGenerator::FilterRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const CMipGenerator::SRect& Rect, SPixel16Int* const PtrNormals)
+{
+	assert(PtrHeights);
+	assert(PtrNormals);
+
+	// Only the texels with both horizontal neighbours inside the texture are filtered 4 at a time
+	const uint32_t KVectorLeft{ max(Rect.Left, 1u) };
+	const uint32_t KVectorRight{ (Width > 1) ? min(Rect.Right, Width - 1) : 0 };
+	const XMVECTOR KTwo{ XMVectorReplicate(2.0f) };
+	for (uint32_t V = Rect.Top; V < Rect.Bottom; ++V)
+	{
+		const uint8_t* const PtrRow0{ &PtrHeights[static_cast<size_t>((V > 0) ? V - 1 : 0) * Width].R };
+		const uint8_t* const PtrRow1{ &PtrHeights[static_cast<size_t>(V) * Width].R };
+		const uint8_t* const PtrRow2{ &PtrHeights[static_cast<size_t>(min(V + 1, Height - 1)) * Width].R };
+		SPixel16Int* const PtrNormalRow{ PtrNormals + static_cast<size_t>(V) * Width };
+
+		uint32_t U{ Rect.Left };
+		for (; U < Rect.Right && U < KVectorLeft; ++U)
+		{
+			PtrNormalRow[U] = FilterTexel(PtrHeights, Width, Height, Desc, U, V);
+		}
+		for (; U + 4 <= KVectorRight; U += 4)
+		{
+			const XMVECTOR KRow0Minus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow0 + U - 1)) };
+			const XMVECTOR KRow0Center{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow0 + U)) };
+			const XMVECTOR KRow0Plus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow0 + U + 1)) };
+			const XMVECTOR KRow1Minus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow1 + U - 1)) };
+			const XMVECTOR KRow1Plus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow1 + U + 1)) };
+			const XMVECTOR KRow2Minus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow2 + U - 1)) };
+			const XMVECTOR KRow2Center{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow2 + U)) };
+			const XMVECTOR KRow2Plus{ XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(PtrRow2 + U + 1)) };
+
+			// [-1 0 +1] x [1 2 1]^T and [1 2 1] x [-1 0 +1]^T
+			XMVECTOR GradientU{ XMVectorSubtract(KRow0Plus, KRow0Minus) };
+			GradientU = XMVectorMultiplyAdd(KTwo, XMVectorSubtract(KRow1Plus, KRow1Minus), GradientU);
+			GradientU = XMVectorAdd(GradientU, XMVectorSubtract(KRow2Plus, KRow2Minus));
+			XMVECTOR GradientV{ XMVectorSubtract(KRow2Minus, KRow0Minus) };
+			GradientV = XMVectorMultiplyAdd(KTwo, XMVectorSubtract(KRow2Center, KRow0Center), GradientV);
+			GradientV = XMVectorAdd(GradientV, XMVectorSubtract(KRow2Plus, KRow0Plus));
+
+			XMVECTOR EncodedX{};
+			XMVECTOR EncodedZ{};
+			EncodeGradients(GradientU, GradientV, Desc, EncodedX, EncodedZ);
+
+			int32_t X[4]{};
+			int32_t Z[4]{};
+			XMStoreInt4(reinterpret_cast<uint32_t*>(X), XMConvertVectorFloatToInt(EncodedX, 0));
+			XMStoreInt4(reinterpret_cast<uint32_t*>(Z), XMConvertVectorFloatToInt(EncodedZ, 0));
+			for (uint32_t iLane = 0; iLane < 4; ++iLane)
+			{
+				PtrNormalRow[U + iLane].R = static_cast<int8_t>(X[iLane]);
+				PtrNormalRow[U + iLane].G = static_cast<int8_t>(Z[iLane]);
+			}
+		}
+		for (; U < Rect.Right; ++U)
+		{
+			PtrNormalRow[U] = FilterTexel(PtrHeights, Width, Height, Desc, U, V);
+		}
+	}
+}
+
+SPixel16Int CNormalMapGenerator::FilterTexel(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	uint32_t U, uint32_t V)
+{
+	// Taps outside the texture are clamped to its edge
+	const size_t KU[3]{ (U > 0) ? U - 1 : 0, U, min(U + 1, Width - 1) };
+	const size_t KV[3]{ (V > 0) ? V - 1 : 0, V, min(V + 1, Height - 1) };
+	int H[3][3]{};
+	for (int iRow = 0; iRow < 3; ++iRow)
+	{
+		for (int iColumn = 0; iColumn < 3; ++iColumn)
+		{
+			H[iRow][iColumn] = PtrHeights[KV[iRow] * Width + KU[iColumn]].R;
+		}
+	}
+
+	const int KGradientU{ (H[0][2] - H[0][0]) + 2 * (H[1][2] - H[1][0]) + (H[2][2] - H[2][0]) };
+	const int KGradientV{ (H[2][0] - H[0][0]) + 2 * (H[2][1] - H[0][1]) + (H[2][2] - H[0][2]) };
+
+	// Same encoding as the 4-wide path, so that both give identical results
+	XMVECTOR EncodedX{};
+	XMVECTOR EncodedZ{};
+	EncodeGradients(XMVectorReplicate(static_cast<float>(KGradientU)), XMVectorReplicate(static_cast<float>(KGradientV)), Desc,
+		EncodedX, EncodedZ);
+
+	SPixel16Int Result{};
+	Result.R = static_cast<int8_t>(XMVectorGetX(EncodedX));
+	Result.G = static_cast<int8_t>(XMVectorGetX(EncodedZ));
+	return Result;
+}
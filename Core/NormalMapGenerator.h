@@ -0,0 +1,41 @@
+#pragma once
+
+#include "MipGenerator.h"
+
+// Derives a normal map (octahedral, R8G8_SNORM) from an 8-bit height map with a Sobel filter
+// +U of the height map is +X and +V is -Z (as CTerrain's height map), +Y is up
+// Normals always point up, so the octahedral encoding is done around +Y: (R, G) = (X, Z) / (|X| + |Y| + |Z|)
+class CNormalMapGenerator
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+		SDesc(float _HeightScale, float _TexelSpacing = 1.0f) : HeightScale{ _HeightScale }, TexelSpacing{ _TexelSpacing } {}
+
+		float	HeightScale{ 1.0f }; // World height of 1 step of the height map
+		float	TexelSpacing{ 1.0f }; // World distance between adjacent texels
+	};
+
+public:
+	static void GenerateNormalMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		vector<SPixel16Int>& vOutNormals);
+
+	// Recomputes the texels that DirtyRect (in height map texels) and its 1-texel border reach
+	// OutUpdatedRect is the updated region of vNormals
+	static void UpdateNormalMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const CMipGenerator::SRect& DirtyRect, vector<SPixel16Int>& vNormals, CMipGenerator::SRect& OutUpdatedRect);
+
+	static SPixel16Int EncodeNormal(const XMVECTOR& Normal);
+	static XMVECTOR DecodeNormal(const SPixel16Int& Encoded);
+
+private:
+	// Interior texels of each row are filtered 4 at a time
+	static void FilterRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const CMipGenerator::SRect& Rect, SPixel16Int* const PtrNormals);
+	static SPixel16Int FilterTexel(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		uint32_t U, uint32_t V);
+
+public:
+	static constexpr float KEncodingScale{ 127.0f };
+};
@@ -1,4 +1,5 @@
 #include "Object2D.h"
+#include "StateTracker.h"
 
 void CObject2D::CreateStatic(const SData& Data)
 {
@@ -17,7 +18,8 @@ void CObject2D::CreateStatic(const SData& Data)
 	D3D11_SUBRESOURCE_DATA subresource_data{};
 	subresource_data.pSysMem = &m_Data.vVertices[0];
 
-	assert(SUCCEEDED(m_PtrDevice->CreateBuffer(&buffer_desc, &subresource_data, &m_VertexBuffer)));
+	const HRESULT KResult{ m_PtrRenderDevice->CreateBuffer(buffer_desc, &subresource_data, m_VertexBuffer.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(KResult));
 
 	CreateIndexBuffer();
 }
@@ -29,6 +31,12 @@ void CObject2D::CreateDynamic(const SData& Data)
 
 	m_Data = Data;
 
+	if (m_PtrUploadRing && m_PtrUploadRing->IsAvailable())
+	{
+		CreateIndexBuffer();
+		return;
+	}
+
 	D3D11_BUFFER_DESC buffer_desc{};
 	buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
 	buffer_desc.ByteWidth = static_cast<UINT>(sizeof(SVertex2D) * m_Data.vVertices.size());
@@ -39,7 +47,8 @@ void CObject2D::CreateDynamic(const SData& Data)
 	D3D11_SUBRESOURCE_DATA subresource_data{};
 	subresource_data.pSysMem = &m_Data.vVertices[0];
 
-	assert(SUCCEEDED(m_PtrDevice->CreateBuffer(&buffer_desc, &subresource_data, &m_VertexBuffer)));
+	const HRESULT KResult{ m_PtrRenderDevice->CreateBuffer(buffer_desc, &subresource_data, m_VertexBuffer.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(KResult));
 
 	CreateIndexBuffer();
 }
@@ -56,16 +65,20 @@ void CObject2D::CreateIndexBuffer()
 	D3D11_SUBRESOURCE_DATA subresource_data{};
 	subresource_data.pSysMem = &m_Data.vTriangles[0];
 
-	assert(SUCCEEDED(m_PtrDevice->CreateBuffer(&buffer_desc, &subresource_data, &m_IndexBuffer)));
+	const HRESULT KResult{ m_PtrRenderDevice->CreateBuffer(buffer_desc, &subresource_data, m_IndexBuffer.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(KResult));
 }
 
 void CObject2D::UpdateVertexBuffer()
 {
-	D3D11_MAPPED_SUBRESOURCE mapped_subresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_subresource)))
+	// The vertices are read on the next draw
+	if (!m_VertexBuffer) return;
+
+	const size_t KByteSize{ sizeof(SVertex2D) * m_Data.vVertices.size() };
+	if (void* const PtrMappedData{ m_PtrRenderDevice->Map(m_VertexBuffer.Get(), D3D11_MAP_WRITE_DISCARD, KByteSize) })
 	{
-		memcpy(mapped_subresource.pData, &m_Data.vVertices[0], sizeof(SVertex2D) * m_Data.vVertices.size());
-		m_PtrDeviceContext->Unmap(m_VertexBuffer.Get(), 0);
+		memcpy(PtrMappedData, &m_Data.vVertices[0], KByteSize);
+		m_PtrRenderDevice->Unmap(m_VertexBuffer.Get());
 	}
 }
 
@@ -78,11 +91,21 @@ void CObject2D::UpdateWorldMatrix()
 	ComponentTransform.MatrixWorld = Scaling * Rotation * Translation;
 }
 
-void CObject2D::Draw() const
+void CObject2D::Draw(CStateTracker& StateTracker) const
 {
-	m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_VertexBuffer.GetAddressOf(), &m_VertexBufferStride, &m_VertexBufferOffset);
-	m_PtrDeviceContext->IASetIndexBuffer(m_IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-	m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (m_VertexBuffer)
+	{
+		StateTracker.SetVertexBuffer(0, m_VertexBuffer.Get(), m_VertexBufferStride, m_VertexBufferOffset);
+	}
+	else
+	{
+		STransientAllocation Allocation{};
+		if (!m_PtrUploadRing->Upload(&m_Data.vVertices[0], sizeof(SVertex2D) * m_Data.vVertices.size(), Allocation)) return;
+
+		StateTracker.SetVertexBuffer(0, Allocation.PtrBuffer, m_VertexBufferStride, Allocation.Offset);
+	}
+	StateTracker.SetIndexBuffer(m_IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	m_PtrDeviceContext->DrawIndexed(static_cast<UINT>(m_Data.vTriangles.size() * 3), 0, 0);
+	StateTracker.DrawIndexed(static_cast<UINT>(m_Data.vTriangles.size() * 3), 0, 0);
 }
\ No newline at end of file
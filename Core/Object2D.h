@@ -1,6 +1,8 @@
 #pragma once
 
-#include "SharedHeader.h"
+#include "TransientUploadRing.h"
+
+class CStateTracker;
 
 struct SVertex2D
 {
@@ -31,11 +33,11 @@ public:
 	};
 
 public:
-	CObject2D(const string& Name, ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-		m_Name{ Name }, m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+	// PtrUploadRing: the vertices of dynamic objects are uploaded to the ring on every draw instead of to a buffer of their own
+	CObject2D(const string& Name, CRenderDevice* const PtrRenderDevice, CTransientUploadRing* const PtrUploadRing = nullptr) :
+		m_Name{ Name }, m_PtrRenderDevice{ PtrRenderDevice }, m_PtrUploadRing{ PtrUploadRing }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 	}
 	~CObject2D() {}
 
@@ -57,7 +59,7 @@ public:
 	void UpdateVertexBuffer();
 	void UpdateWorldMatrix();
 
-	void Draw() const;
+	void Draw(CStateTracker& StateTracker) const;
 
 public:
 	SData& GetData() { return m_Data; }
@@ -71,8 +73,8 @@ public:
 	bool						bIsVisible{ true };
 
 private:
-	ID3D11Device* const			m_PtrDevice{};
-	ID3D11DeviceContext* const	m_PtrDeviceContext{};
+	CRenderDevice* const		m_PtrRenderDevice{};
+	CTransientUploadRing* const	m_PtrUploadRing{};
 
 private:
 	string						m_Name{};
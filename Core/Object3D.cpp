@@ -57,19 +57,24 @@ void CObject3D::CreateFromFile(const string& FileName, bool bIsModelRigged)
 	ULONGLONG StartTimePoint{ GetTickCount64() };
 	if (bIsModelRigged)
 	{
-		m_AssimpLoader.LoadAnimatedModelFromFile(FileName, m_Model, m_PtrDevice, m_PtrDeviceContext);
+		m_AssimpLoader.LoadAnimatedModelFromFile(FileName, m_Model);
 
 		ComponentRender.PtrVS = m_PtrGame->GetBaseShader(EBaseShader::VSAnimation);
 	}
 	else
 	{
-		m_AssimpLoader.LoadStaticModelFromFile(FileName, m_Model, m_PtrDevice, m_PtrDeviceContext);
+		m_AssimpLoader.LoadStaticModelFromFile(FileName, m_Model);
 	}
 	OutputDebugString(("- Model [" + FileName + "] loaded. [" + to_string(GetTickCount64() - StartTimePoint) + "] elapsed.\n").c_str());
 
+	// Imported models are drawn with the compressed vertex formats
+	m_bIsVertexCompressed = true;
+
 	CreateMeshBuffers();
 	CreateMaterialTextures();
 
+	GenerateLODs();
+
 	for (const CMaterial& Material : m_Model.vMaterials)
 	{
 		// @important
@@ -204,45 +209,83 @@ CObject3D::SInstanceCPUData& CObject3D::GetInstance(const string& Name)
 
 void CObject3D::CreateMeshBuffers()
 {
+	++m_ModelVersion;
+
 	m_vMeshBuffers.clear();
 	m_vMeshBuffers.resize(m_Model.vMeshes.size());
+	m_vMeshUVAreas.clear();
+	m_vMeshUVAreas.resize(m_Model.vMeshes.size());
+
+	if (m_bIsVertexCompressed)
+	{
+		m_VertexQuantization = CVertexCompressor::CalculateQuantization(m_Model.vMeshes);
+
+		CVertexCompressor::SErrorStats Stats{ CVertexCompressor::AnalyzeError(m_Model.vMeshes, m_VertexQuantization) };
+		OutputDebugString(("- Vertices of [" + m_Name + "] compressed. [" + to_string(Stats.ByteSizeBefore) + "] -> [" +
+			to_string(Stats.ByteSizeAfter) + "] bytes, max position error [" + to_string(Stats.MaxPositionError) +
+			"], max normal error [" + to_string(Stats.MaxNormalAngleError) + "] degrees.\n").c_str());
+	}
+
 	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
 	{
 		CreateMeshBuffer(iMesh, m_Model.bIsModelAnimated);
+		CalculateMeshUVArea(iMesh);
 	}
 }
 
 void CObject3D::CreateMeshBuffer(size_t MeshIndex, bool IsAnimated)
 {
 	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+	SMeshBuffers& MeshBuffers{ m_vMeshBuffers[MeshIndex] };
+
+	vector<SVertex3DCompressed> vCompressedVertices{};
+	vector<SVertexAnimationCompressed> vCompressedVerticesAnimation{};
+	const void* PtrVertices{ &Mesh.vVertices[0] };
+	const void* PtrVerticesAnimation{ (IsAnimated) ? &Mesh.vVerticesAnimation[0] : nullptr };
+	MeshBuffers.VertexBufferStride = sizeof(SVertex3D);
+	MeshBuffers.VertexBufferAnimationStride = sizeof(SVertexAnimation);
+	if (m_bIsVertexCompressed)
+	{
+		CVertexCompressor::CompressVertices(Mesh.vVertices, m_VertexQuantization, vCompressedVertices);
+		PtrVertices = &vCompressedVertices[0];
+		MeshBuffers.VertexBufferStride = sizeof(SVertex3DCompressed);
+
+		if (IsAnimated)
+		{
+			CVertexCompressor::CompressVerticesAnimation(Mesh.vVerticesAnimation, vCompressedVerticesAnimation);
+			PtrVerticesAnimation = &vCompressedVerticesAnimation[0];
+			MeshBuffers.VertexBufferAnimationStride = sizeof(SVertexAnimationCompressed);
+		}
+	}
 
 	{
+		// @important: edits are staged through the transient upload ring (see UploadVertexBuffer())
 		D3D11_BUFFER_DESC BufferDesc{};
 		BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(SVertex3D) * Mesh.vVertices.size());
-		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		BufferDesc.ByteWidth = static_cast<UINT>(MeshBuffers.VertexBufferStride * Mesh.vVertices.size());
+		BufferDesc.CPUAccessFlags = 0;
 		BufferDesc.MiscFlags = 0;
 		BufferDesc.StructureByteStride = 0;
-		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		BufferDesc.Usage = D3D11_USAGE_DEFAULT;
 
 		D3D11_SUBRESOURCE_DATA SubresourceData{};
-		SubresourceData.pSysMem = &Mesh.vVertices[0];
-		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vMeshBuffers[MeshIndex].VertexBuffer);
+		SubresourceData.pSysMem = PtrVertices;
+		m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, MeshBuffers.VertexBuffer.ReleaseAndGetAddressOf());
 	}
 
 	if (IsAnimated)
 	{
 		D3D11_BUFFER_DESC BufferDesc{};
 		BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(SVertexAnimation) * Mesh.vVerticesAnimation.size());
+		BufferDesc.ByteWidth = static_cast<UINT>(MeshBuffers.VertexBufferAnimationStride * Mesh.vVerticesAnimation.size());
 		BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 		BufferDesc.MiscFlags = 0;
 		BufferDesc.StructureByteStride = 0;
 		BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 
 		D3D11_SUBRESOURCE_DATA SubresourceData{};
-		SubresourceData.pSysMem = &Mesh.vVerticesAnimation[0];
-		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vMeshBuffers[MeshIndex].VertexBufferAnimation);
+		SubresourceData.pSysMem = PtrVerticesAnimation;
+		m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, MeshBuffers.VertexBufferAnimation.ReleaseAndGetAddressOf());
 	}
 
 	{
@@ -256,8 +299,114 @@ void CObject3D::CreateMeshBuffer(size_t MeshIndex, bool IsAnimated)
 
 		D3D11_SUBRESOURCE_DATA SubresourceData{};
 		SubresourceData.pSysMem = &Mesh.vTriangles[0];
-		m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vMeshBuffers[MeshIndex].IndexBuffer);
+		m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, MeshBuffers.IndexBuffer.ReleaseAndGetAddressOf());
+	}
+
+	CreateLODIndexBuffers(MeshIndex);
+
+	// @important: animated vertices move away from the meshlets' bounds
+	MeshBuffers.vMeshlets.clear();
+	MeshBuffers.vVisibleDraws.clear();
+	MeshBuffers.bUseVisibleDraws = false;
+	if (!IsAnimated && Mesh.vTriangles.size() >= KMinMeshletCullingTriangleCount)
+	{
+		CMeshletBuilder::BuildMeshlets(Mesh, MeshBuffers.vMeshlets);
+	}
+}
+
+void CObject3D::CreateLODIndexBuffers(size_t MeshIndex)
+{
+	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+	SMeshBuffers& MeshBuffers{ m_vMeshBuffers[MeshIndex] };
+
+	MeshBuffers.vLODIndexBuffers.clear();
+	MeshBuffers.vLODIndexBuffers.resize(Mesh.vLODs.size());
+	for (size_t iLOD = 0; iLOD < Mesh.vLODs.size(); ++iLOD)
+	{
+		const SMeshLOD& LOD{ Mesh.vLODs[iLOD] };
+		if (LOD.vTriangles.empty()) continue;
+
+		D3D11_BUFFER_DESC BufferDesc{};
+		BufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		BufferDesc.ByteWidth = static_cast<UINT>(sizeof(STriangle) * LOD.vTriangles.size());
+		BufferDesc.CPUAccessFlags = 0;
+		BufferDesc.MiscFlags = 0;
+		BufferDesc.StructureByteStride = 0;
+		BufferDesc.Usage = D3D11_USAGE_DEFAULT;
+
+		D3D11_SUBRESOURCE_DATA SubresourceData{};
+		SubresourceData.pSysMem = &LOD.vTriangles[0];
+		m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, MeshBuffers.vLODIndexBuffers[iLOD].ReleaseAndGetAddressOf());
+	}
+}
+
+void CObject3D::GenerateLODs(const CMeshSimplifier::SLODDesc& Desc)
+{
+	CMeshSimplifier::SLODStats Stats{};
+	CMeshSimplifier::GenerateLODs(m_Model, Desc, &Stats);
+
+	string Report{};
+	for (size_t iLOD = 0; iLOD < Stats.vTriangleCounts.size(); ++iLOD)
+	{
+		Report += " [" + to_string(Stats.vTriangleCounts[iLOD]) + "]";
+	}
+	OutputDebugString(("- LODs of [" + m_Name + "] generated. Triangles" + Report + ", max relative error [" +
+		to_string(Stats.vRelativeErrors.back()) + "], [" + to_string(Stats.ElapsedMilliseconds) + "] elapsed.\n").c_str());
+
+	for (size_t iMesh = 0; iMesh < m_vMeshBuffers.size(); ++iMesh)
+	{
+		CreateLODIndexBuffers(iMesh);
+	}
+	m_CurrentLOD = 0;
+}
+
+void CObject3D::SelectLOD(float ProjectedRadius)
+{
+	m_CurrentLOD = CMeshSimplifier::SelectLOD(m_Model.vMeshes, ProjectedRadius);
+}
+
+void CObject3D::CullMeshlets(const CMeshletCuller::SFrustum& Frustum, const XMVECTOR& EyePosition, bool bUseConeCulling,
+	CMeshletCuller::SStats* const PtrOutStats)
+{
+	// Instances share one draw call, tessellated meshes are displaced and LODs have their own triangle lists
+	const bool KbCanCull{ !IsInstanced() && !m_Model.bIsModelAnimated && !m_bShouldTesselate && m_CurrentLOD == 0 };
+
+	CMeshletCuller::SDesc Desc{};
+	Desc.bUseConeCulling = bUseConeCulling && EFLAG_HAS_NO(eFlagsRendering, EFlagsRendering::NoCulling);
+	for (SMeshBuffers& MeshBuffers : m_vMeshBuffers)
+	{
+		MeshBuffers.vVisibleDraws.clear();
+		MeshBuffers.bUseVisibleDraws = KbCanCull && !MeshBuffers.vMeshlets.empty();
+		if (!MeshBuffers.bUseVisibleDraws) continue;
+
+		CMeshletCuller::CullMeshlets(MeshBuffers.vMeshlets, ComponentTransform.MatrixWorld, Frustum, EyePosition,
+			MeshBuffers.vVisibleDraws, Desc, PtrOutStats);
+	}
+}
+
+void CObject3D::SetVisibleDraws(size_t MeshIndex, const vector<SDrawIndexedArgs>& vDraws)
+{
+	m_vMeshBuffers[MeshIndex].vVisibleDraws = vDraws;
+	m_vMeshBuffers[MeshIndex].bUseVisibleDraws = true;
+}
+
+void CObject3D::ResetVisibleDraws()
+{
+	for (SMeshBuffers& MeshBuffers : m_vMeshBuffers)
+	{
+		MeshBuffers.vVisibleDraws.clear();
+		MeshBuffers.bUseVisibleDraws = false;
+	}
+}
+
+size_t CObject3D::GetLODCount() const
+{
+	size_t LODCount{};
+	for (const SMesh& Mesh : m_Model.vMeshes)
+	{
+		LODCount = max(LODCount, Mesh.vLODs.size());
 	}
+	return LODCount + 1;
 }
 
 void CObject3D::CreateInstanceBuffers()
@@ -284,17 +433,34 @@ void CObject3D::CreateInstanceBuffer(size_t MeshIndex)
 
 	D3D11_SUBRESOURCE_DATA SubresourceData{};
 	SubresourceData.pSysMem = &m_vInstanceGPUData[0];
-	m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, &m_vInstanceBuffers[MeshIndex].Buffer);
+	m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, m_vInstanceBuffers[MeshIndex].Buffer.ReleaseAndGetAddressOf());
 }
 
 void CObject3D::CreateMaterialTextures()
 {
+	++m_ModelVersion;
+
 	for (CMaterial& Material : m_Model.vMaterials)
 	{
-		Material.CreateTextures(m_PtrDevice, m_PtrDeviceContext);
+		Material.CreateTextures(m_PtrRenderDevice, true);
 	}
 }
 
+void CObject3D::CalculateMeshUVArea(size_t MeshIndex)
+{
+	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+
+	float UVArea{};
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		XMVECTOR UV0{ Mesh.vVertices[Triangle.I0].TexCoord };
+		XMVECTOR Edge01{ Mesh.vVertices[Triangle.I1].TexCoord - UV0 };
+		XMVECTOR Edge02{ Mesh.vVertices[Triangle.I2].TexCoord - UV0 };
+		UVArea += fabsf(XMVectorGetX(Edge01) * XMVectorGetY(Edge02) - XMVectorGetY(Edge01) * XMVectorGetX(Edge02)) * 0.5f;
+	}
+	m_vMeshUVAreas[MeshIndex] = UVArea;
+}
+
 void CObject3D::UpdateQuadUV(const XMFLOAT2& UVOffset, const XMFLOAT2& UVSize)
 {
 	float U0{ UVOffset.x };
@@ -308,17 +474,50 @@ void CObject3D::UpdateQuadUV(const XMFLOAT2& UVOffset, const XMFLOAT2& UVSize)
 	m_Model.vMeshes[0].vVertices[3].TexCoord = XMVectorSet(U1, V1, 0, 0);
 
 	UpdateMeshBuffer();
+	CalculateMeshUVArea(0);
 }
 
 void CObject3D::UpdateMeshBuffer(size_t MeshIndex)
 {
-	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	++m_ModelVersion;
+
+	if (!m_vMeshBuffers[MeshIndex].vMeshlets.empty())
 	{
-		memcpy(MappedSubresource.pData, &m_Model.vMeshes[MeshIndex].vVertices[0], sizeof(SVertex3D) * m_Model.vMeshes[MeshIndex].vVertices.size());
+		CMeshletBuilder::UpdateMeshletBounds(m_Model.vMeshes[MeshIndex], m_vMeshBuffers[MeshIndex].vMeshlets);
+	}
 
-		m_PtrDeviceContext->Unmap(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), 0);
+	if (m_bIsVertexCompressed)
+	{
+		// @important: the edited vertices may have moved the bounds, so every mesh is quantized again
+		m_VertexQuantization = CVertexCompressor::CalculateQuantization(m_Model.vMeshes);
+		for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
+		{
+			UpdateCompressedMeshBuffer(iMesh);
+		}
+		return;
 	}
+
+	UploadVertexBuffer(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), &m_Model.vMeshes[MeshIndex].vVertices[0],
+		sizeof(SVertex3D) * m_Model.vMeshes[MeshIndex].vVertices.size());
+}
+
+void CObject3D::UpdateCompressedMeshBuffer(size_t MeshIndex)
+{
+	vector<SVertex3DCompressed> vCompressedVertices{};
+	CVertexCompressor::CompressVertices(m_Model.vMeshes[MeshIndex].vVertices, m_VertexQuantization, vCompressedVertices);
+
+	UploadVertexBuffer(m_vMeshBuffers[MeshIndex].VertexBuffer.Get(), &vCompressedVertices[0], sizeof(SVertex3DCompressed) * vCompressedVertices.size());
+}
+
+void CObject3D::UploadVertexBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, size_t ByteSize)
+{
+	// The vertex buffer isn't renamed, only the shared ring is written
+	// @important: large meshes (e.g. a terrain being sculpted) would fill the ring every frame, so they are updated directly
+	CTransientUploadRing& UploadRing{ m_PtrGame->GetTransientUploadRing() };
+	const bool KbShouldStage{ UploadRing.IsAvailable() && ByteSize <= UploadRing.GetByteSize() / KMaxStagingRingFraction };
+	if (KbShouldStage && UploadRing.UploadToBuffer(PtrBuffer, 0, PtrData, ByteSize)) return;
+
+	m_PtrRenderDevice->UpdateBuffer(PtrBuffer, PtrData, static_cast<UINT>(ByteSize));
 }
 
 void CObject3D::UpdateInstanceBuffers()
@@ -331,12 +530,13 @@ void CObject3D::UpdateInstanceBuffers()
 
 void CObject3D::UpdateInstanceBuffer(size_t MeshIndex)
 {
-	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_vInstanceBuffers[MeshIndex].Buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	ID3D11Buffer* const PtrBuffer{ m_vInstanceBuffers[MeshIndex].Buffer.Get() };
+	const size_t KByteSize{ sizeof(SInstanceGPUData) * m_vInstanceGPUData.size() };
+	if (void* const PtrMappedData{ m_PtrRenderDevice->Map(PtrBuffer, D3D11_MAP_WRITE_DISCARD, KByteSize) })
 	{
-		memcpy(MappedSubresource.pData, &m_vInstanceGPUData[0], sizeof(SInstanceGPUData) * m_vInstanceGPUData.size());
+		memcpy(PtrMappedData, &m_vInstanceGPUData[0], KByteSize);
 
-		m_PtrDeviceContext->Unmap(m_vInstanceBuffers[MeshIndex].Buffer.Get(), 0);
+		m_PtrRenderDevice->Unmap(PtrBuffer);
 	}
 }
 
@@ -370,7 +570,7 @@ void CObject3D::UpdateWorldMatrix()
 	ComponentTransform.MatrixWorld = Scaling * BoundingSphereTranslationOpposite * Rotation * Translation * BoundingSphereTranslation;
 }
 
-void CObject3D::UpdateInstanceWorldMatrix(size_t InstanceID)
+void CObject3D::UpdateInstanceWorldMatrix(size_t InstanceID, bool bShouldUpdateInstanceBuffers)
 {
 	if (InstanceID >= m_vInstanceCPUData.size()) return;
 
@@ -397,7 +597,7 @@ void CObject3D::UpdateInstanceWorldMatrix(size_t InstanceID)
 	// Update GPU data
 	m_vInstanceGPUData[InstanceID].InstanceWorldMatrix = Scaling * BoundingSphereTranslationOpposite * Rotation * Translation * BoundingSphereTranslation;
 
-	UpdateInstanceBuffers();
+	if (bShouldUpdateInstanceBuffers) UpdateInstanceBuffers();
 }
 
 void CObject3D::Animate()
@@ -508,13 +708,18 @@ void CObject3D::CalculateAnimatedBoneMatrices(const SModel::SNode& Node, XMMATRI
 
 void CObject3D::Draw(bool bIgnoreOwnTexture) const
 {
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
+
 	for (size_t iMesh = 0; iMesh < m_Model.vMeshes.size(); ++iMesh)
 	{
 		const SMesh& Mesh{ m_Model.vMeshes[iMesh] };
 		const CMaterial& Material{ m_Model.vMaterials[Mesh.MaterialID] };
 
+		// Every meshlet has been culled
+		if (m_vMeshBuffers[iMesh].bUseVisibleDraws && m_vMeshBuffers[iMesh].vVisibleDraws.empty()) continue;
+
 		m_PtrGame->UpdatePSBaseMaterial(Material);
-		m_PtrGame->UpdateDSDisplacementData(false);
+		m_PtrGame->UpdateDSTerrainDisplacement(false);
 
 		if (m_Model.bUseMultipleTexturesInSingleMesh) // This bool is for CTerrain
 		{
@@ -524,9 +729,9 @@ void CObject3D::Draw(bool bIgnoreOwnTexture) const
 				{
 					if (Material.HasTexture(CMaterial::CTexture::EType::DisplacementTexture))
 					{
-						m_PtrGame->UpdateDSDisplacementData(true);
+						m_PtrGame->UpdateDSTerrainDisplacement(true);
 					}
-					Material.UseTextures();
+					Material.UseTextures(StateTracker);
 				}
 			}
 		}
@@ -537,45 +742,70 @@ void CObject3D::Draw(bool bIgnoreOwnTexture) const
 			{
 				if (Material.HasTexture(CMaterial::CTexture::EType::DisplacementTexture))
 				{
-					m_PtrGame->UpdateDSDisplacementData(true);
+					m_PtrGame->UpdateDSTerrainDisplacement(true);
 				}
-				Material.UseTextures();
+				Material.UseTextures(StateTracker);
 			}
 		}
 
-		m_PtrDeviceContext->IASetIndexBuffer(m_vMeshBuffers[iMesh].IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		DrawMesh(StateTracker, iMesh);
+	}
+}
 
-		m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_vMeshBuffers[iMesh].VertexBuffer.GetAddressOf(), 
-			&m_vMeshBuffers[iMesh].VertexBufferStride, &m_vMeshBuffers[iMesh].VertexBufferOffset);
+void CObject3D::DrawMesh(CStateTracker& StateTracker, size_t MeshIndex, const vector<SDrawIndexedArgs>* const PtrDraws) const
+{
+	const SMesh& Mesh{ m_Model.vMeshes[MeshIndex] };
+	const SMeshBuffers& MeshBuffers{ m_vMeshBuffers[MeshIndex] };
+	const vector<SDrawIndexedArgs>* const PtrUsedDraws{ (!PtrDraws && MeshBuffers.bUseVisibleDraws) ? &MeshBuffers.vVisibleDraws : PtrDraws };
 
-		if (m_Model.bIsModelAnimated)
-		{
-			m_PtrDeviceContext->IASetVertexBuffers(1, 1, m_vMeshBuffers[iMesh].VertexBufferAnimation.GetAddressOf(),
-				&m_vMeshBuffers[iMesh].VertexBufferAnimationStride, &m_vMeshBuffers[iMesh].VertexBufferAnimationOffset);
-		}
+	// Meshes with fewer LODs use their coarsest one
+	const vector<STriangle>* PtrTriangles{ &Mesh.vTriangles };
+	ID3D11Buffer* PtrIndexBuffer{ MeshBuffers.IndexBuffer.Get() };
+	if (m_CurrentLOD && !Mesh.vLODs.empty())
+	{
+		size_t LODIndex{ min(m_CurrentLOD, Mesh.vLODs.size()) - 1 };
+		PtrTriangles = &Mesh.vLODs[LODIndex].vTriangles;
+		PtrIndexBuffer = MeshBuffers.vLODIndexBuffers[LODIndex].Get();
+	}
 
-		if (IsInstanced())
-		{
-			m_PtrDeviceContext->IASetVertexBuffers(2, 1, m_vInstanceBuffers[iMesh].Buffer.GetAddressOf(),
-				&m_vInstanceBuffers[iMesh].Stride, &m_vInstanceBuffers[iMesh].Offset);
-		}
+	StateTracker.SetIndexBuffer(PtrIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-		if (m_bShouldTesselate)
-		{
-			m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
-		}
-		else
-		{
-			m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		}
-		
-		if (m_vInstanceCPUData.size())
-		{
-			m_PtrDeviceContext->DrawIndexedInstanced(static_cast<UINT>(Mesh.vTriangles.size() * 3), static_cast<UINT>(m_vInstanceCPUData.size()), 0, 0, 0);
-		}
-		else
+	StateTracker.SetVertexBuffer(0, MeshBuffers.VertexBuffer.Get(), MeshBuffers.VertexBufferStride, MeshBuffers.VertexBufferOffset);
+
+	if (m_Model.bIsModelAnimated)
+	{
+		StateTracker.SetVertexBuffer(1, MeshBuffers.VertexBufferAnimation.Get(),
+			MeshBuffers.VertexBufferAnimationStride, MeshBuffers.VertexBufferAnimationOffset);
+	}
+
+	if (IsInstanced())
+	{
+		StateTracker.SetVertexBuffer(2, m_vInstanceBuffers[MeshIndex].Buffer.Get(),
+			m_vInstanceBuffers[MeshIndex].Stride, m_vInstanceBuffers[MeshIndex].Offset);
+	}
+
+	if (m_bShouldTesselate)
+	{
+		StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+	}
+	else
+	{
+		StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	}
+	
+	if (m_vInstanceCPUData.size())
+	{
+		StateTracker.DrawIndexedInstanced(static_cast<UINT>(PtrTriangles->size() * 3), static_cast<UINT>(m_vInstanceCPUData.size()), 0, 0, 0);
+	}
+	else if (PtrUsedDraws)
+	{
+		for (const SDrawIndexedArgs& Draw : *PtrUsedDraws)
 		{
-			m_PtrDeviceContext->DrawIndexed(static_cast<UINT>(Mesh.vTriangles.size() * 3), 0, 0);
+			StateTracker.DrawIndexed(Draw.IndexCountPerInstance, Draw.StartIndexLocation, Draw.BaseVertexLocation);
 		}
 	}
+	else
+	{
+		StateTracker.DrawIndexed(static_cast<UINT>(PtrTriangles->size() * 3), 0, 0);
+	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
-#include "AssimpLoader.h"
+#include "VertexCompressor.h"
+#include "MeshSimplifier.h"
+#include "MeshletCuller.h"
 
 class CGame;
 class CShader;
@@ -72,6 +74,11 @@ private:
 		UINT					VertexBufferAnimationOffset{};
 
 		ComPtr<ID3D11Buffer>	IndexBuffer{};
+		vector<ComPtr<ID3D11Buffer>>	vLODIndexBuffers{}; // LOD 1, 2, ...
+
+		vector<SMeshlet>				vMeshlets{}; // Of LOD 0 (empty if the mesh is too small)
+		vector<SDrawIndexedArgs>		vVisibleDraws{};
+		bool							bUseVisibleDraws{ false };
 	};
 
 	struct SInstanceBuffer
@@ -82,11 +89,10 @@ private:
 	};
 
 public:
-	CObject3D(const string& Name, ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, CGame* const PtrGame) :
-		m_Name{ Name }, m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }, m_PtrGame{ PtrGame }
+	CObject3D(const string& Name, CRenderDevice* const PtrRenderDevice, CGame* const PtrGame) :
+		m_Name{ Name }, m_PtrRenderDevice{ PtrRenderDevice }, m_PtrGame{ PtrGame }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 		assert(m_PtrGame);
 	}
 	~CObject3D() {}
@@ -127,10 +133,25 @@ public:
 	void UpdateInstanceBuffer(size_t MeshIndex = 0);
 
 	void UpdateWorldMatrix();
-	void UpdateInstanceWorldMatrix(size_t InstanceID);
+	// bShouldUpdateInstanceBuffers: false when many instances are updated at once (call UpdateInstanceBuffers() after them)
+	void UpdateInstanceWorldMatrix(size_t InstanceID, bool bShouldUpdateInstanceBuffers = true);
+
+	// Generates LODs of every mesh (see CMeshSimplifier) and their index buffers
+	void GenerateLODs(const CMeshSimplifier::SLODDesc& Desc = CMeshSimplifier::SLODDesc());
+	// ProjectedRadius: the bounding sphere's radius on the screen in pixels
+	void SelectLOD(float ProjectedRadius);
+	// Chooses the visible meshlets for the next Draw() (see CMeshletCuller); objects that can't be culled are drawn whole
+	void CullMeshlets(const CMeshletCuller::SFrustum& Frustum, const XMVECTOR& EyePosition, bool bUseConeCulling,
+		CMeshletCuller::SStats* const PtrOutStats = nullptr);
+	// Draws only these index ranges of the mesh until CullMeshlets() or ResetVisibleDraws() is called (for CTerrain's tiles)
+	void SetVisibleDraws(size_t MeshIndex, const vector<SDrawIndexedArgs>& vDraws);
+	void ResetVisibleDraws();
 
 	void Animate();
 	void Draw(bool bIgnoreOwnTexture = false) const;
+	// Binds the mesh's buffers and draws it (PtrDraws: these index ranges instead of the visible draws or the whole mesh)
+	// Neither materials nor CGame's constants are touched, so CCommandRecorder jobs can call it on any thread
+	void DrawMesh(CStateTracker& StateTracker, size_t MeshIndex, const vector<SDrawIndexedArgs>* const PtrDraws = nullptr) const;
 
 public:
 	bool ShouldTessellate() const { return m_bShouldTesselate; }
@@ -139,22 +160,35 @@ public:
 public:
 	bool IsCreated() const { return m_bIsCreated; }
 	bool IsRiggedModel() const { return m_Model.bIsModelAnimated; }
+	bool IsVertexCompressed() const { return m_bIsVertexCompressed; }
+	const CVertexCompressor::SCBVSVertexQuantizationData& GetVertexQuantization() const { return m_VertexQuantization; }
 	bool IsInstanced() const { return (m_vInstanceCPUData.size() > 0) ? true : false; }
 	size_t GetInstanceCount() const { return m_vInstanceCPUData.size(); }
+	size_t GetLODCount() const;
+	size_t GetCurrentLOD() const { return m_CurrentLOD; }
 	const SModel& GetModel() const { return m_Model; }
 	SModel& GetModel() { return m_Model; }
 	const string& GetName() const { return m_Name; }
 	const string& GetModelFileName() const { return m_ModelFileName; }
+	// Increased whenever the meshes or the materials are replaced or updated (e.g. for CGame's static batches)
+	uint32_t GetModelVersion() const { return m_ModelVersion; }
 	const map<string, size_t>& GetInstanceMap() const { return m_mapInstanceNameToIndex; }
+	// Sum of the texture coordinate areas of the mesh's triangles (for texture streaming)
+	float GetMeshUVArea(size_t MeshIndex) const { return m_vMeshUVAreas[MeshIndex]; }
 
 private:
 	void CreateMeshBuffers();
 	void CreateMeshBuffer(size_t MeshIndex, bool IsAnimated);
+	void CreateLODIndexBuffers(size_t MeshIndex);
+	void UpdateCompressedMeshBuffer(size_t MeshIndex);
+	void UploadVertexBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, size_t ByteSize);
 
 	void CreateInstanceBuffer(size_t MeshIndex);
 
 	void CreateMaterialTextures();
 
+	void CalculateMeshUVArea(size_t MeshIndex);
+
 	void CalculateAnimatedBoneMatrices(const SModel::SNode& Node, XMMATRIX ParentTransform);
 
 	void LimitFloatRotation(float& Value, const float Min, const float Max);
@@ -164,6 +198,8 @@ public:
 
 private:
 	static constexpr float KBoundingSphereDefaultRadius{ 1.0f };
+	static constexpr size_t KMinMeshletCullingTriangleCount{ 4096 };
+	static constexpr size_t KMaxStagingRingFraction{ 4 }; // Vertex uploads larger than 1/4 of the transient upload ring aren't staged
 
 public:
 	SComponentTransform			ComponentTransform{};
@@ -172,8 +208,7 @@ public:
 	EFlagsRendering				eFlagsRendering{};
 
 private:
-	ID3D11Device* const			m_PtrDevice{};
-	ID3D11DeviceContext* const	m_PtrDeviceContext{};
+	CRenderDevice* const		m_PtrRenderDevice{};
 	CGame* const				m_PtrGame{};
 
 private:
@@ -181,8 +216,13 @@ private:
 	string						m_ModelFileName{};
 	bool						m_bIsCreated{ false };
 	SModel						m_Model{};
+	uint32_t					m_ModelVersion{};
 	vector<SMeshBuffers>		m_vMeshBuffers{};
 	vector<SInstanceBuffer>		m_vInstanceBuffers{};
+	vector<float>				m_vMeshUVAreas{};
+	bool						m_bIsVertexCompressed{ false };
+	CVertexCompressor::SCBVSVertexQuantizationData	m_VertexQuantization{};
+	size_t						m_CurrentLOD{};
 
 	XMMATRIX					m_AnimatedBoneMatrices[KMaxBoneMatrixCount]{};
 	size_t						m_CurrentAnimationIndex{};
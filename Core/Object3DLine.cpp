@@ -1,8 +1,10 @@
 #include "Object3DLine.h"
+#include "StateTracker.h"
 
 void CObject3DLine::Create(const vector<SVertex3DLine>& vVertices)
 {
 	m_vVertices = vVertices;
+	if (m_PtrUploadRing && m_PtrUploadRing->IsAvailable()) return;
 
 	D3D11_BUFFER_DESC BufferDesc{};
 	BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
@@ -15,17 +17,20 @@ void CObject3DLine::Create(const vector<SVertex3DLine>& vVertices)
 	D3D11_SUBRESOURCE_DATA SubresourceData{};
 	SubresourceData.pSysMem = &m_vVertices[0];
 
-	m_PtrDevice->CreateBuffer(&BufferDesc, &SubresourceData, m_VertexBuffer.GetAddressOf());
+	m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, m_VertexBuffer.ReleaseAndGetAddressOf());
 }
 
 void CObject3DLine::UpdateVertexBuffer()
 {
-	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	// The vertices are read on the next draw
+	if (!m_VertexBuffer) return;
+
+	const size_t KByteSize{ sizeof(SVertex3DLine) * m_vVertices.size() };
+	if (void* const PtrMappedData{ m_PtrRenderDevice->Map(m_VertexBuffer.Get(), D3D11_MAP_WRITE_DISCARD, KByteSize) })
 	{
-		memcpy(MappedSubresource.pData, &m_vVertices[0], sizeof(SVertex3DLine) * m_vVertices.size());
+		memcpy(PtrMappedData, &m_vVertices[0], KByteSize);
 
-		m_PtrDeviceContext->Unmap(m_VertexBuffer.Get(), 0);
+		m_PtrRenderDevice->Unmap(m_VertexBuffer.Get());
 	}
 }
 
@@ -38,10 +43,20 @@ void CObject3DLine::UpdateWorldMatrix()
 	ComponentTransform.MatrixWorld = Scaling * Rotation * Translation;
 }
 
-void CObject3DLine::Draw() const
+void CObject3DLine::Draw(CStateTracker& StateTracker) const
 {
-	m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_VertexBuffer.GetAddressOf(), &m_VertexBufferStride, &m_VertexBufferOffset);
-	m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	if (m_VertexBuffer)
+	{
+		StateTracker.SetVertexBuffer(0, m_VertexBuffer.Get(), m_VertexBufferStride, m_VertexBufferOffset);
+	}
+	else
+	{
+		STransientAllocation Allocation{};
+		if (!m_PtrUploadRing->Upload(&m_vVertices[0], sizeof(SVertex3DLine) * m_vVertices.size(), Allocation)) return;
+
+		StateTracker.SetVertexBuffer(0, Allocation.PtrBuffer, m_VertexBufferStride, Allocation.Offset);
+	}
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
 
-	m_PtrDeviceContext->Draw(static_cast<UINT>(m_vVertices.size()), 0);
+	StateTracker.Draw(static_cast<UINT>(m_vVertices.size()), 0);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
-#include "SharedHeader.h"
+#include "TransientUploadRing.h"
+
+class CStateTracker;
 
 struct SVertex3DLine
 {
@@ -22,11 +24,11 @@ class CObject3DLine
 	};
 
 public:
-	CObject3DLine(const string& Name, ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-		m_Name{ Name }, m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+	// PtrUploadRing: the vertices are uploaded to the ring on every draw instead of to a buffer of their own
+	CObject3DLine(const string& Name, CRenderDevice* const PtrRenderDevice, CTransientUploadRing* const PtrUploadRing = nullptr) :
+		m_Name{ Name }, m_PtrRenderDevice{ PtrRenderDevice }, m_PtrUploadRing{ PtrUploadRing }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 	}
 	~CObject3DLine() {}
 
@@ -45,7 +47,7 @@ public:
 	void Create(const vector<SVertex3DLine>& vVertices);
 	void UpdateVertexBuffer();
 	void UpdateWorldMatrix();
-	void Draw() const;
+	void Draw(CStateTracker& StateTracker) const;
 
 public:
 	vector<SVertex3DLine>& GetVertices() { return m_vVertices; }
@@ -56,8 +58,8 @@ public:
 	bool						bIsVisible{ true };
 
 private:
-	ID3D11Device* const			m_PtrDevice{};
-	ID3D11DeviceContext* const	m_PtrDeviceContext{};
+	CRenderDevice* const		m_PtrRenderDevice{};
+	CTransientUploadRing* const	m_PtrUploadRing{};
 
 private:
 	string						m_Name{};
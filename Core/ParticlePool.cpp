@@ -1,4 +1,5 @@
 #include "ParticlePool.h"
+#include "StateTracker.h"
 #include "Math.h"
 
 void CParticlePool::Create(size_t MaxParticleCount)
@@ -20,7 +21,7 @@ void CParticlePool::SetSpawningInterval(float Value)
 
 void CParticlePool::SetTexture(const string& FileName)
 {
-	m_ParticleTexture = make_unique<CMaterial::CTexture>(m_PtrDevice, m_PtrDeviceContext);
+	m_ParticleTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
 	m_ParticleTexture->CreateTextureFromFile(FileName, false);
 	m_ParticleTexture->SetSlot(0);
 
@@ -96,21 +97,62 @@ void CParticlePool::Update(float DeltaTime)
 	UpdateVertexBuffer();
 }
 
-void CParticlePool::Draw() const
+void CParticlePool::Draw(CStateTracker& StateTracker) const
+{
+	if (m_VertexBuffer)
+	{
+		DrawVertices(StateTracker, m_VertexBuffer.Get(), m_VertexBufferOffset);
+		return;
+	}
+
+	if (m_vVertexParticles.empty()) return;
+
+	STransientAllocation Allocation{};
+	if (!m_PtrUploadRing->Upload(&m_vVertexParticles[0], sizeof(SVertexParticle) * m_vVertexParticles.size(), Allocation)) return;
+
+	DrawVertices(StateTracker, Allocation.PtrBuffer, Allocation.Offset);
+}
+
+void CParticlePool::PrepareRecording()
+{
+	m_RecordedAllocation = STransientAllocation();
+	if (m_VertexBuffer || m_vVertexParticles.empty()) return;
+
+	// The allocation is only consumed on replay, which comes before the ring is renamed as long as the frame doesn't overflow it
+	if (!m_PtrUploadRing->Upload(&m_vVertexParticles[0], sizeof(SVertexParticle) * m_vVertexParticles.size(), m_RecordedAllocation))
+	{
+		m_RecordedAllocation = STransientAllocation();
+	}
+}
+
+void CParticlePool::Record(CStateTracker& StateTracker) const
+{
+	if (m_VertexBuffer)
+	{
+		DrawVertices(StateTracker, m_VertexBuffer.Get(), m_VertexBufferOffset);
+	}
+	else if (m_RecordedAllocation.PtrBuffer)
+	{
+		DrawVertices(StateTracker, m_RecordedAllocation.PtrBuffer, m_RecordedAllocation.Offset);
+	}
+}
+
+void CParticlePool::DrawVertices(CStateTracker& StateTracker, ID3D11Buffer* const PtrBuffer, UINT Offset) const
 {
 	if (m_bUseTexture)
 	{
-		if (m_ParticleTexture) m_ParticleTexture->Use();
+		if (m_ParticleTexture) m_ParticleTexture->Use(StateTracker);
 	}
 
-	m_PtrDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	m_PtrDeviceContext->IASetVertexBuffers(0, 1, m_VertexBuffer.GetAddressOf(), &m_VertexBufferStride, &m_VertexBufferOffset);
-	
-	m_PtrDeviceContext->Draw(static_cast<UINT>(m_vVertexParticles.size()), 0);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	StateTracker.SetVertexBuffer(0, PtrBuffer, m_VertexBufferStride, Offset);
+	StateTracker.Draw(static_cast<UINT>(m_vVertexParticles.size()), 0);
 }
 
 void CParticlePool::CreateVertexBuffer()
 {
+	if (m_PtrUploadRing && m_PtrUploadRing->IsAvailable()) return;
+
 	D3D11_BUFFER_DESC BufferDesc{};
 	BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	BufferDesc.ByteWidth = static_cast<UINT>(sizeof(SVertexParticle) * m_MaxParticleCount);
@@ -119,24 +161,28 @@ void CParticlePool::CreateVertexBuffer()
 	BufferDesc.StructureByteStride = 0;
 	BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 
-	assert(SUCCEEDED(m_PtrDevice->CreateBuffer(&BufferDesc, nullptr, m_VertexBuffer.ReleaseAndGetAddressOf())));
+	const HRESULT KResult{ m_PtrRenderDevice->CreateBuffer(BufferDesc, nullptr, m_VertexBuffer.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(KResult));
 }
 
 void CParticlePool::UpdateVertexBuffer()
 {
-	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_VertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	// The particles are read on the next draw
+	if (!m_VertexBuffer) return;
+
+	const size_t KByteSize{ sizeof(SVertexParticle) * max(m_vVertexParticles.size(), (size_t)1) };
+	if (void* const PtrMappedData{ m_PtrRenderDevice->Map(m_VertexBuffer.Get(), D3D11_MAP_WRITE_DISCARD, KByteSize) })
 	{
 		if (m_vVertexParticles.size())
 		{
-			memcpy(MappedSubresource.pData, &m_vVertexParticles[0], sizeof(SVertexParticle) * m_vVertexParticles.size());
+			memcpy(PtrMappedData, &m_vVertexParticles[0], sizeof(SVertexParticle) * m_vVertexParticles.size());
 		}
 		else
 		{
-			memset(MappedSubresource.pData, 0, sizeof(SVertexParticle));
+			memset(PtrMappedData, 0, sizeof(SVertexParticle));
 		}
 
-		m_PtrDeviceContext->Unmap(m_VertexBuffer.Get(), 0);
+		m_PtrRenderDevice->Unmap(m_VertexBuffer.Get());
 	}
 }
 
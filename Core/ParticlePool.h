@@ -2,6 +2,9 @@
 
 #include "SharedHeader.h"
 #include "Material.h"
+#include "TransientUploadRing.h"
+
+class CStateTracker;
 
 class CParticlePool
 {
@@ -30,11 +33,11 @@ protected:
 	};
 
 public:
-	CParticlePool(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-		m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+	// PtrUploadRing: the particles are uploaded to the ring on every draw instead of to a buffer of their own
+	CParticlePool(CRenderDevice* const PtrRenderDevice, CTransientUploadRing* const PtrUploadRing = nullptr) :
+		m_PtrRenderDevice{ PtrRenderDevice }, m_PtrUploadRing{ PtrUploadRing }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 	}
 	virtual ~CParticlePool() {}
 
@@ -48,25 +51,32 @@ public:
 
 	virtual void SpawnParticle();
 	virtual void Update(float DeltaTime);
-	virtual void Draw() const;
+	virtual void Draw(CStateTracker& StateTracker) const;
+
+	// For CCommandRecorder jobs: PrepareRecording() uploads the particles to the ring (on the thread that owns the render device),
+	// then Record() draws them like Draw() from any thread
+	virtual void PrepareRecording();
+	virtual void Record(CStateTracker& StateTracker) const;
 
 protected:
 	virtual void CreateVertexBuffer();
 	virtual void UpdateVertexBuffer();
 	virtual void SetLastParticleTexColor();
 	virtual void SetLastParticleScalingFactor();
+	void DrawVertices(CStateTracker& StateTracker, ID3D11Buffer* const PtrBuffer, UINT Offset) const;
 
 protected:
 	static constexpr float			KSpawningIntervalDefault{ 1.0f };
 
 protected:
-	ID3D11Device* const				m_PtrDevice{};
-	ID3D11DeviceContext* const		m_PtrDeviceContext{};
+	CRenderDevice* const			m_PtrRenderDevice{};
+	CTransientUploadRing* const		m_PtrUploadRing{};
 
 protected:
 	ComPtr<ID3D11Buffer>			m_VertexBuffer{};
 	UINT							m_VertexBufferStride{ sizeof(SVertexParticle) };
 	UINT							m_VertexBufferOffset{};
+	STransientAllocation			m_RecordedAllocation{}; // Of PrepareRecording()
 
 protected:
 	size_t							m_MaxParticleCount{};
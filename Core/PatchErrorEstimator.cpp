@@ -0,0 +1,214 @@
+#include "PatchErrorEstimator.h"
+
+// Offsets of the window's texels (columns and rows) from the cell's center
+static constexpr float KWindowOffsets[CPatchErrorEstimator::KWindowSize]{ -1.5f, -0.5f, +0.5f, +1.5f };
+
+// Largest |height - plane| of 4 windows at a time, the plane being the least-squares fit of the window
+// The offsets are symmetric, so the plane's height at the center is the mean and its slope along an axis is
+// sum(height * offset) / sum(offset^2), sum(offset^2) being 4 rows * 5
+static XMVECTOR CalculateMaxDeviation(const XMVECTOR(&Window)[CPatchErrorEstimator::KWindowSize][CPatchErrorEstimator::KWindowSize])
+{
+	const XMVECTOR KOuter{ XMVectorReplicate(KWindowOffsets[3]) };
+	const XMVECTOR KInner{ XMVectorReplicate(KWindowOffsets[2]) };
+
+	XMVECTOR RowSums[CPatchErrorEstimator::KWindowSize]{};
+	XMVECTOR SumX{ XMVectorZero() };
+	for (uint32_t iRow = 0; iRow < CPatchErrorEstimator::KWindowSize; ++iRow)
+	{
+		const XMVECTOR* const Row{ Window[iRow] };
+		RowSums[iRow] = XMVectorAdd(XMVectorAdd(Row[0], Row[1]), XMVectorAdd(Row[2], Row[3]));
+		SumX = XMVectorMultiplyAdd(KOuter, XMVectorSubtract(Row[3], Row[0]), SumX);
+		SumX = XMVectorMultiplyAdd(KInner, XMVectorSubtract(Row[2], Row[1]), SumX);
+	}
+	const XMVECTOR KSum{ XMVectorAdd(XMVectorAdd(RowSums[0], RowSums[1]), XMVectorAdd(RowSums[2], RowSums[3])) };
+	XMVECTOR SumZ{ XMVectorMultiply(KOuter, XMVectorSubtract(RowSums[3], RowSums[0])) };
+	SumZ = XMVectorMultiplyAdd(KInner, XMVectorSubtract(RowSums[2], RowSums[1]), SumZ);
+
+	const XMVECTOR KMean{ XMVectorScale(KSum, 1.0f / 16.0f) };
+	const XMVECTOR KSlopeX{ XMVectorScale(SumX, 1.0f / 20.0f) };
+	const XMVECTOR KSlopeZ{ XMVectorScale(SumZ, 1.0f / 20.0f) };
+
+	XMVECTOR MaxDeviation{ XMVectorZero() };
+	for (uint32_t iRow = 0; iRow < CPatchErrorEstimator::KWindowSize; ++iRow)
+	{
+		const XMVECTOR KRowPlane{ XMVectorMultiplyAdd(KSlopeZ, XMVectorReplicate(KWindowOffsets[iRow]), KMean) };
+		for (uint32_t iColumn = 0; iColumn < CPatchErrorEstimator::KWindowSize; ++iColumn)
+		{
+			const XMVECTOR KPlane{ XMVectorMultiplyAdd(KSlopeX, XMVectorReplicate(KWindowOffsets[iColumn]), KRowPlane) };
+			MaxDeviation = XMVectorMax(MaxDeviation, XMVectorAbs(XMVectorSubtract(Window[iRow][iColumn], KPlane)));
+		}
+	}
+	return MaxDeviation;
+}
+
+void CPatchErrorEstimator::GenerateErrorMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	vector<float>& vOutErrors)
+{
+	vOutErrors.clear();
+	vOutErrors.resize(static_cast<size_t>(Width) * Height);
+	if (Width < 2 || Height < 2) return; // No cells
+
+	CMipGenerator::SRect Rect{};
+	Rect.Right = Width;
+	Rect.Bottom = Height;
+	UpdateVertexRect(PtrHeights, Width, Height, Desc, Rect, &vOutErrors[0]);
+}
+
+void CPatchErrorEstimator::UpdateErrorMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const CMipGenerator::SRect& DirtyRect, vector<float>& vErrors, CMipGenerator::SRect& OutUpdatedRect)
+{
+	OutUpdatedRect = CMipGenerator::SRect();
+	if (vErrors.size() != static_cast<size_t>(Width) * Height)
+	{
+		GenerateErrorMap(PtrHeights, Width, Height, Desc, vErrors);
+		OutUpdatedRect.Right = Width;
+		OutUpdatedRect.Bottom = Height;
+		return;
+	}
+	if (Width < 2 || Height < 2) return;
+
+	// A height texel is in the windows of the cells 2 texels left ~ 1 texel right of it, and a vertex takes the cells on both of its sides
+	OutUpdatedRect.Left = (DirtyRect.Left > 2) ? DirtyRect.Left - 2 : 0;
+	OutUpdatedRect.Top = (DirtyRect.Top > 2) ? DirtyRect.Top - 2 : 0;
+	OutUpdatedRect.Right = min(DirtyRect.Right + 2, Width);
+	OutUpdatedRect.Bottom = min(DirtyRect.Bottom + 2, Height);
+	if (OutUpdatedRect.IsEmpty())
+	{
+		OutUpdatedRect = CMipGenerator::SRect();
+		return;
+	}
+
+	UpdateVertexRect(PtrHeights, Width, Height, Desc, OutUpdatedRect, &vErrors[0]);
+}
+
+float CPatchErrorEstimator::EstimateCellError(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	uint32_t CellX, uint32_t CellZ)
+{
+	assert(PtrHeights);
+	assert(CellX + 1 < Width && CellZ + 1 < Height);
+
+	XMVECTOR Window[KWindowSize][KWindowSize]{};
+	for (uint32_t iRow = 0; iRow < KWindowSize; ++iRow)
+	{
+		for (uint32_t iColumn = 0; iColumn < KWindowSize; ++iColumn)
+		{
+			Window[iRow][iColumn] = XMVectorReplicate(GetExtrapolatedHeight(PtrHeights, Width, Height,
+				static_cast<int>(CellX + iColumn) - 1, static_cast<int>(CellZ + iRow) - 1));
+		}
+	}
+	return XMVectorGetX(XMVectorScale(CalculateMaxDeviation(Window), Desc.HeightScale));
+}
+
+void CPatchErrorEstimator::UpdateVertexRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const CMipGenerator::SRect& VertexRect, float* const PtrErrors)
+{
+	assert(PtrErrors);
+
+	// The cells around the vertices
+	CMipGenerator::SRect CellRect{};
+	CellRect.Left = (VertexRect.Left > 0) ? VertexRect.Left - 1 : 0;
+	CellRect.Top = (VertexRect.Top > 0) ? VertexRect.Top - 1 : 0;
+	CellRect.Right = min(VertexRect.Right, Width - 1);
+	CellRect.Bottom = min(VertexRect.Bottom, Height - 1);
+
+	const uint32_t KCellCountX{ CellRect.Right - CellRect.Left };
+	vector<float> vCellErrors(static_cast<size_t>(KCellCountX) * (CellRect.Bottom - CellRect.Top));
+	EstimateCellRect(PtrHeights, Width, Height, Desc, CellRect, &vCellErrors[0]);
+
+	for (uint32_t V = VertexRect.Top; V < VertexRect.Bottom; ++V)
+	{
+		const uint32_t KCellZ0{ ((V > 0) ? V - 1 : 0) - CellRect.Top };
+		const uint32_t KCellZ1{ min(V, Height - 2) - CellRect.Top };
+		const float* const PtrCellRow0{ &vCellErrors[static_cast<size_t>(KCellZ0) * KCellCountX] };
+		const float* const PtrCellRow1{ &vCellErrors[static_cast<size_t>(KCellZ1) * KCellCountX] };
+		float* const PtrErrorRow{ PtrErrors + static_cast<size_t>(V) * Width };
+		for (uint32_t U = VertexRect.Left; U < VertexRect.Right; ++U)
+		{
+			const uint32_t KCellX0{ ((U > 0) ? U - 1 : 0) - CellRect.Left };
+			const uint32_t KCellX1{ min(U, Width - 2) - CellRect.Left };
+			PtrErrorRow[U] = max(max(PtrCellRow0[KCellX0], PtrCellRow0[KCellX1]), max(PtrCellRow1[KCellX0], PtrCellRow1[KCellX1]));
+		}
+	}
+}
+
+void CPatchErrorEstimator::EstimateCellRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+	const CMipGenerator::SRect& CellRect, float* const PtrCellErrors)
+{
+	assert(PtrHeights);
+	assert(PtrCellErrors);
+
+	// The window rows of a cell row are converted to float once, texels (CellRect.Left - 1) ~ (CellRect.Right + 1), and kept in a ring
+	// (texel row V is in (V + 1) % KWindowSize), so that each cell row converts only 1 new texel row
+	const uint32_t KCellCountX{ CellRect.Right - CellRect.Left };
+	const uint32_t KRowSize{ KCellCountX + KWindowSize - 1 };
+	vector<float> vRows(static_cast<size_t>(KRowSize) * KWindowSize);
+	auto LoadRow{ [&](int V)
+		{
+			float* const PtrRow{ &vRows[static_cast<size_t>((V + 1) % KWindowSize) * KRowSize] };
+			for (uint32_t iTexel = 0; iTexel < KRowSize; ++iTexel)
+			{
+				PtrRow[iTexel] = GetExtrapolatedHeight(PtrHeights, Width, Height, static_cast<int>(CellRect.Left + iTexel) - 1, V);
+			}
+		}
+	};
+
+	for (int V = static_cast<int>(CellRect.Top) - 1; V < static_cast<int>(CellRect.Top) + 2; ++V)
+	{
+		LoadRow(V);
+	}
+	for (uint32_t Z = CellRect.Top; Z < CellRect.Bottom; ++Z)
+	{
+		LoadRow(static_cast<int>(Z) + 2);
+
+		const float* PtrRows[KWindowSize]{};
+		for (uint32_t iRow = 0; iRow < KWindowSize; ++iRow)
+		{
+			PtrRows[iRow] = &vRows[static_cast<size_t>((Z + iRow) % KWindowSize) * KRowSize];
+		}
+		float* const PtrErrorRow{ PtrCellErrors + static_cast<size_t>(Z - CellRect.Top) * KCellCountX };
+
+		// Each lane is a cell, so each window texel is an unaligned load of 4 adjacent texels
+		XMVECTOR Window[KWindowSize][KWindowSize]{};
+		uint32_t X{};
+		for (; X + 4 <= KCellCountX; X += 4)
+		{
+			for (uint32_t iRow = 0; iRow < KWindowSize; ++iRow)
+			{
+				for (uint32_t iColumn = 0; iColumn < KWindowSize; ++iColumn)
+				{
+					Window[iRow][iColumn] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(PtrRows[iRow] + X + iColumn));
+				}
+			}
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(PtrErrorRow + X), XMVectorScale(CalculateMaxDeviation(Window), Desc.HeightScale));
+		}
+		for (; X < KCellCountX; ++X)
+		{
+			for (uint32_t iRow = 0; iRow < KWindowSize; ++iRow)
+			{
+				for (uint32_t iColumn = 0; iColumn < KWindowSize; ++iColumn)
+				{
+					Window[iRow][iColumn] = XMVectorReplicate(PtrRows[iRow][X + iColumn]);
+				}
+			}
+			PtrErrorRow[X] = XMVectorGetX(XMVectorScale(CalculateMaxDeviation(Window), Desc.HeightScale));
+		}
+	}
+}
+
+float CPatchErrorEstimator::GetExtrapolatedHeight(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, int U, int V)
+{
+	const int KWidth{ static_cast<int>(Width) };
+	const int KHeight{ static_cast<int>(Height) };
+	if (V < 0) return 2.0f * GetExtrapolatedHeight(PtrHeights, Width, Height, U, 0) - GetExtrapolatedHeight(PtrHeights, Width, Height, U, 1);
+	if (V >= KHeight)
+	{
+		return 2.0f * GetExtrapolatedHeight(PtrHeights, Width, Height, U, KHeight - 1) -
+			GetExtrapolatedHeight(PtrHeights, Width, Height, U, KHeight - 2);
+	}
+	if (U < 0) return 2.0f * PtrHeights[static_cast<size_t>(V) * Width].R - PtrHeights[static_cast<size_t>(V) * Width + 1].R;
+	if (U >= KWidth)
+	{
+		return 2.0f * PtrHeights[static_cast<size_t>(V) * Width + KWidth - 1].R - PtrHeights[static_cast<size_t>(V) * Width + KWidth - 2].R;
+	}
+	return static_cast<float>(PtrHeights[static_cast<size_t>(V) * Width + U].R);
+}
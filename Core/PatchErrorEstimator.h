@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MipGenerator.h"
+
+// Estimates how far the terrain's tessellation patches are from flat, in world units, for the hull shader's screen-space error
+// A cell (the quad between texels (X, Z) and (X + 1, Z + 1)) gets the largest deviation of its 4 x 4 texel neighbourhood from their
+// least-squares plane, so slopes cost nothing and only curvature (ridges, cliffs, bumps) asks for more triangles
+// A vertex (texel) gets the largest error of the cells around it; patches that share an edge read the same 2 vertices, so there are no cracks
+// Texels outside the height map are extrapolated linearly from the edge, so that the border doesn't look curved
+class CPatchErrorEstimator
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+		SDesc(float _HeightScale) : HeightScale{ _HeightScale } {}
+
+		float	HeightScale{ 1.0f }; // World height of 1 step of the height map
+	};
+
+public:
+	// vOutErrors: 1 per height map texel
+	static void GenerateErrorMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		vector<float>& vOutErrors);
+
+	// Recomputes the vertices whose cells reach DirtyRect (in height map texels), i.e. DirtyRect and its 2-texel border
+	// OutUpdatedRect is the updated region of vErrors
+	static void UpdateErrorMap(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const CMipGenerator::SRect& DirtyRect, vector<float>& vErrors, CMipGenerator::SRect& OutUpdatedRect);
+
+	// CellX < Width - 1, CellZ < Height - 1 (gives the same result as the 4-wide path)
+	static float EstimateCellError(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		uint32_t CellX, uint32_t CellZ);
+
+private:
+	static void UpdateVertexRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const CMipGenerator::SRect& VertexRect, float* const PtrErrors);
+	// Cells of each row are estimated 4 at a time; PtrCellErrors has (CellRect.Right - CellRect.Left) cells per row
+	static void EstimateCellRect(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, const SDesc& Desc,
+		const CMipGenerator::SRect& CellRect, float* const PtrCellErrors);
+	// U in [-1, Width], V in [-1, Height]
+	static float GetExtrapolatedHeight(const SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, int U, int V);
+
+public:
+	static constexpr uint32_t KWindowSize{ 4 };
+};
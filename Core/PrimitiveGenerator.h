@@ -3,13 +3,12 @@
 #include "Object3D.h"
 #include "Object3DLine.h"
 #include "Object2D.h"
-#include <unordered_map>
+#include "MeshOptimizer.h"
+#include "GeometryProcessor.h"
 
 static const XMVECTOR KColorWhite{ XMVectorSet(1, 1, 1 ,1) };
 
-static string ConvertXMVECTORToString(const XMVECTOR& Vector);
 static void CalculateNormals(SMesh& Mesh);
-static void AverageNormals(SMesh& Mesh);
 static void CalculateTangents(SMesh& Mesh);
 static vector<STriangle> GenerateContinuousQuads(int QuadCount);
 static SMesh GenerateTriangle(const XMVECTOR& V0, const XMVECTOR& V1, const XMVECTOR& V2, const XMVECTOR& Color = KColorWhite);
@@ -40,17 +39,6 @@ static bool operator==(const XMVECTOR& A, const XMVECTOR& B)
 	return XMVector3Equal(A, B);
 }
 
-static string ConvertXMVECTORToString(const XMVECTOR& Vector)
-{
-	float X{ XMVectorGetX(Vector) };
-	float Y{ XMVectorGetY(Vector) };
-	float Z{ XMVectorGetZ(Vector) };
-	float W{ XMVectorGetW(Vector) };
-
-	string Result{ to_string(X) + "#" + to_string(Y) + "#" + to_string(Z) + "#" + to_string(W) };
-	return Result;
-}
-
 static void CalculateNormals(SMesh& Mesh)
 {
 	for (const STriangle& Triangle : Mesh.vTriangles)
@@ -68,55 +56,6 @@ static void CalculateNormals(SMesh& Mesh)
 	}
 }
 
-static void AverageNormals(SMesh& Mesh)
-{
-	std::unordered_map<string, vector<XMVECTOR>> mapVertexToNormals{};
-	for (const STriangle& Triangle : Mesh.vTriangles)
-	{
-		const SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
-		const SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
-		const SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
-
-		string V0PositionStr{ ConvertXMVECTORToString(V0.Position) };
-		string V1PositionStr{ ConvertXMVECTORToString(V1.Position) };
-		string V2PositionStr{ ConvertXMVECTORToString(V2.Position) };
-
-		const vector<XMVECTOR>& vV0Normals{ mapVertexToNormals[V0PositionStr] };
-		{
-			auto found{ std::find(vV0Normals.begin(), vV0Normals.end(), V0.Normal) };
-			if (found == vV0Normals.end()) mapVertexToNormals[V0PositionStr].emplace_back(V0.Normal);
-		}
-
-		const vector<XMVECTOR>& vV1Normals{ mapVertexToNormals[V1PositionStr] };
-		{
-			auto found{ std::find(vV1Normals.begin(), vV1Normals.end(), V1.Normal) };
-			if (found == vV1Normals.end()) mapVertexToNormals[V1PositionStr].emplace_back(V1.Normal);
-		}
-
-		const vector<XMVECTOR>& vV2Normals{ mapVertexToNormals[V2PositionStr] };
-		{
-			auto found{ std::find(vV2Normals.begin(), vV2Normals.end(), V2.Normal) };
-			if (found == vV2Normals.end()) mapVertexToNormals[V2PositionStr].emplace_back(V2.Normal);
-		}
-	}
-
-	for (SVertex3D& Vertex : Mesh.vVertices)
-	{
-		string VStr{ ConvertXMVECTORToString(Vertex.Position) };
-
-		const vector<XMVECTOR>& vNormals{ mapVertexToNormals[VStr] };
-
-		XMVECTOR NormalSum{};
-		for (const auto& Normal : vNormals)
-		{
-			NormalSum += Normal;
-		}
-		XMVECTOR TriangleNormal{ NormalSum / (float)vNormals.size() };
-
-		Vertex.Normal = TriangleNormal;
-	}
-}
-
 static void CalculateTangents(SMesh& Mesh)
 {
 	for (STriangle& Triangle : Mesh.vTriangles)
@@ -154,55 +93,6 @@ static void CalculateTangents(SMesh& Mesh)
 	}
 }
 
-static void AverageTangents(SMesh& Mesh)
-{
-	std::unordered_map<string, vector<XMVECTOR>> mapVertexToTangents{};
-	for (const STriangle& Triangle : Mesh.vTriangles)
-	{
-		const SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
-		const SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
-		const SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
-
-		string V0PositionStr{ ConvertXMVECTORToString(V0.Position) };
-		string V1PositionStr{ ConvertXMVECTORToString(V1.Position) };
-		string V2PositionStr{ ConvertXMVECTORToString(V2.Position) };
-
-		const vector<XMVECTOR>& vV0Tangents{ mapVertexToTangents[V0PositionStr] };
-		{
-			auto found{ std::find(vV0Tangents.begin(), vV0Tangents.end(), V0.Tangent) };
-			if (found == vV0Tangents.end()) mapVertexToTangents[V0PositionStr].emplace_back(V0.Tangent);
-		}
-
-		const vector<XMVECTOR>& vV1Tangents{ mapVertexToTangents[V1PositionStr] };
-		{
-			auto found{ std::find(vV1Tangents.begin(), vV1Tangents.end(), V1.Tangent) };
-			if (found == vV1Tangents.end()) mapVertexToTangents[V1PositionStr].emplace_back(V1.Tangent);
-		}
-
-		const vector<XMVECTOR>& vV2Tangents{ mapVertexToTangents[V2PositionStr] };
-		{
-			auto found{ std::find(vV2Tangents.begin(), vV2Tangents.end(), V2.Tangent) };
-			if (found == vV2Tangents.end()) mapVertexToTangents[V2PositionStr].emplace_back(V2.Tangent);
-		}
-	}
-
-	for (SVertex3D& Vertex : Mesh.vVertices)
-	{
-		string VStr{ ConvertXMVECTORToString(Vertex.Position) };
-
-		const vector<XMVECTOR>& vTangents{ mapVertexToTangents[VStr] };
-
-		XMVECTOR TangentSum{};
-		for (const auto& Tangent : vTangents)
-		{
-			TangentSum += Tangent;
-		}
-		XMVECTOR TriangleTangent{ TangentSum / (float)vTangents.size() };
-
-		Vertex.Tangent = TriangleTangent;
-	}
-}
-
 static vector<STriangle> GenerateContinuousQuads(int QuadCount)
 {
 	vector<STriangle> vTriangles{};
@@ -231,9 +121,7 @@ static SMesh GenerateTriangle(const XMVECTOR& V0, const XMVECTOR& V1, const XMVE
 
 	Mesh.vTriangles.emplace_back(0, 1, 2);
 
-	CalculateNormals(Mesh);
-
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
 	return Mesh;
 }
@@ -252,9 +140,9 @@ static SMesh GenerateSquareXYPlane(const XMVECTOR& Color)
 
 	Mesh.vTriangles = GenerateContinuousQuads(1);
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
 
 	return Mesh;
 }
@@ -273,9 +161,9 @@ static SMesh GenerateSquareXZPlane(const XMVECTOR& Color)
 
 	Mesh.vTriangles = GenerateContinuousQuads(1);
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
 
 	return Mesh;
 }
@@ -294,9 +182,9 @@ static SMesh GenerateSquareYZPlane(const XMVECTOR& Color)
 
 	Mesh.vTriangles = GenerateContinuousQuads(1);
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
 
 	return Mesh;
 }
@@ -341,6 +229,8 @@ static SMesh GenerateTerrainBase(const XMFLOAT2& Size, bool bSubdivideTexCoord,
 	CalculateTangents(Mesh);
 
 	TranslateMesh(Mesh, XMVectorSet(static_cast<float>(-SizeX / 2), 0, static_cast<float>(SizeZ / 2), 1));
+
+	CMeshOptimizer::OptimizeMesh(Mesh);
 	
 	return Mesh;
 }
@@ -374,9 +264,11 @@ static SMesh GenerateCircleXZPlane(uint32_t SideCount, const XMVECTOR& Color)
 		Mesh.vTriangles.emplace_back(iSide * 3 + 0, iSide * 3 + 1, iSide * 3 + 2);
 	}
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
+
+	CGeometryProcessor::WeldVertices(Mesh);
 
-	AverageNormals(Mesh);
+	CMeshOptimizer::OptimizeMesh(Mesh);
 
 	return Mesh;
 }
@@ -425,9 +317,7 @@ static SMesh GeneratePyramid(const XMVECTOR& Color)
 		Mesh.vTriangles.emplace_back(13, 15, 14);
 	}
 
-	CalculateNormals(Mesh);
-
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
 	return Mesh;
 }
@@ -479,9 +369,9 @@ static SMesh GenerateCube(const XMVECTOR& Color)
 
 	Mesh.vTriangles = GenerateContinuousQuads(6);
 	
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
 
 	return Mesh;
 }
@@ -529,9 +419,11 @@ static SMesh GenerateCone(float RadiusRatio, float Radius, float Height, uint32_
 		Mesh.vTriangles.emplace_back(iSide * 6 + 1, iSide * 6 + 4, iSide * 6 + 2);
 	}
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::WeldVertices(Mesh);
+
+	CMeshOptimizer::OptimizeMesh(Mesh);
 
 	return Mesh;
 }
@@ -602,9 +494,13 @@ static SMesh GenerateSphere(uint32_t SegmentCount, const XMVECTOR& ColorTop, con
 		Mesh.vTriangles.emplace_back(iSide * 6 + 3, iSide * 6 + 4, iSide * 6 + 5);
 	}
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
 
-	AverageNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
+
+	CGeometryProcessor::WeldVertices(Mesh);
+
+	CMeshOptimizer::OptimizeMesh(Mesh);
 
 	return Mesh;
 }
@@ -669,9 +565,11 @@ static SMesh GenerateTorus(const XMVECTOR& Color, float InnerRadius, uint32_t Si
 		}
 	}
 
-	CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateNormals(Mesh);
+
+	CGeometryProcessor::WeldVertices(Mesh);
 
-	AverageNormals(Mesh);
+	CMeshOptimizer::OptimizeMesh(Mesh);
 
 	return Mesh;
 }
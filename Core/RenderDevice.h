@@ -0,0 +1,141 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Resource creation, immediate-context state and draw calls, so that they can be tracked (CStateTracker) or recorded without a GPU
+// (CRenderDeviceNull)
+class CRenderDevice
+{
+public:
+	CRenderDevice() {}
+	virtual ~CRenderDevice() {}
+
+public:
+	// Creation returns the device's HRESULT; created objects are returned with a reference the caller owns (as ID3D11Device does)
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData, 
+		ID3D11Buffer** const PtrOutBuffer) = 0;
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+		ID3D11Texture2D** const PtrOutTexture) = 0;
+	// PtrDesc nullptr: a view of the whole resource
+	virtual HRESULT CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+		ID3D11ShaderResourceView** const PtrOutView) = 0;
+	virtual HRESULT CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+		ID3D11RenderTargetView** const PtrOutView) = 0;
+	virtual HRESULT CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+		ID3D11DepthStencilView** const PtrOutView) = 0;
+	virtual HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState) = 0;
+	virtual HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState) = 0;
+	virtual HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState) = 0;
+	virtual HRESULT CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState) = 0;
+	virtual HRESULT CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader) = 0;
+	virtual HRESULT CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader) = 0;
+	virtual HRESULT CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader) = 0;
+	virtual HRESULT CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader) = 0;
+	virtual HRESULT CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader) = 0;
+	virtual HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount, const void* const PtrBytecode,
+		size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout) = 0;
+
+	// DDS files (MaxSize > 0 skips the mips larger than it) or any other image file (WIC), as shader resources without generated mips
+	// PtrOutTexture or PtrOutView may be nullptr
+	virtual HRESULT CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) = 0;
+	// An image file's contents (WIC)
+	virtual HRESULT CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) = 0;
+
+public:
+	virtual void SetVertexShader(ID3D11VertexShader* const PtrShader) = 0;
+	virtual void SetHullShader(ID3D11HullShader* const PtrShader) = 0;
+	virtual void SetDomainShader(ID3D11DomainShader* const PtrShader) = 0;
+	virtual void SetGeometryShader(ID3D11GeometryShader* const PtrShader) = 0;
+	virtual void SetPixelShader(ID3D11PixelShader* const PtrShader) = 0;
+	virtual void SetInputLayout(ID3D11InputLayout* const PtrInputLayout) = 0;
+	virtual void SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer) = 0;
+	virtual void SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView) = 0;
+	virtual void SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState) = 0;
+
+	// FirstConstant and ConstantCount are in 16-byte constants and multiples of 16 (D3D11.1)
+	virtual void SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant, UINT ConstantCount) = 0;
+
+	// Constant buffer ranges and NO_OVERWRITE maps of dynamic constant buffers
+	virtual bool SupportsConstantBufferRanges() const = 0;
+
+	virtual void SetRasterizerState(ID3D11RasterizerState* const PtrState) = 0;
+	virtual void SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef) = 0;
+	// Blend factor (1, 1, 1, 1) and every sample
+	virtual void SetBlendState(ID3D11BlendState* const PtrState) = 0;
+	virtual void SetViewport(const D3D11_VIEWPORT& Viewport) = 0;
+	virtual void SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView) = 0;
+
+	virtual void ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4]) = 0;
+	virtual void ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) = 0;
+
+	virtual void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology) = 0;
+	virtual void SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset) = 0;
+	virtual void SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset) = 0;
+
+	// The caller writes within [0, ByteSize) of the returned memory (nullptr on failure)
+	virtual void* Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize) = 0;
+	virtual void Unmap(ID3D11Buffer* const PtrBuffer) = 0;
+	// PtrBuffer must be a default-usage buffer, whose whole contents are replaced
+	virtual void UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize) = 0;
+	virtual void CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset, UINT ByteSize) = 0;
+
+	// PtrTexture must be a dynamic texture; returns false on failure
+	virtual bool MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped) = 0;
+	virtual void UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource) = 0;
+	// PtrTexture must be a default-usage texture; PtrBox nullptr: the whole subresource (PtrData points to the box's first texel)
+	virtual void UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, const void* const PtrData,
+		UINT RowPitch) = 0;
+	// PtrSrcBox nullptr: the whole source subresource
+	virtual void CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY, 
+		ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox) = 0;
+	// The view's texture must be created with D3D11_RESOURCE_MISC_GENERATE_MIPS
+	virtual void GenerateMips(ID3D11ShaderResourceView* const PtrView) = 0;
+	// The mips finer than MinLOD aren't sampled (e.g. while they are streamed in); 0: every mip
+	virtual void SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD) = 0;
+
+	// Fence values must increase. GetCompletedFence() returns the last fence value the GPU has passed (without waiting)
+	virtual void SignalFence(uint64_t FenceValue) = 0;
+	virtual uint64_t GetCompletedFence() = 0;
+
+	virtual void Draw(UINT VertexCount, UINT StartVertexLocation) = 0;
+	virtual void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) = 0;
+	virtual void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+		UINT StartInstanceLocation) = 0;
+
+public:
+	// Bytes per texel, or per 4x4 block of block-compressed formats (OutBlockSize 4, otherwise 1)
+	static UINT GetFormatElementByteSize(DXGI_FORMAT Format, UINT& OutBlockSize)
+	{
+		OutBlockSize = 1;
+		if ((Format >= DXGI_FORMAT_BC1_TYPELESS && Format <= DXGI_FORMAT_BC5_SNORM) || 
+			(Format >= DXGI_FORMAT_BC6H_TYPELESS && Format <= DXGI_FORMAT_BC7_UNORM_SRGB))
+		{
+			OutBlockSize = 4;
+			const bool KbIsHalfBlock{ Format <= DXGI_FORMAT_BC1_UNORM_SRGB || (Format >= DXGI_FORMAT_BC4_TYPELESS && Format <= DXGI_FORMAT_BC4_SNORM) };
+			return (KbIsHalfBlock) ? 8 : 16;
+		}
+		if (Format == DXGI_FORMAT_UNKNOWN) return 0;
+		if (Format <= DXGI_FORMAT_R32G32B32A32_SINT) return 16;
+		if (Format <= DXGI_FORMAT_R32G32B32_SINT) return 12;
+		if (Format <= DXGI_FORMAT_X32_TYPELESS_G8X24_UINT) return 8;
+		if (Format <= DXGI_FORMAT_X24_TYPELESS_G8_UINT) return 4;
+		if (Format <= DXGI_FORMAT_R16_SINT) return 2;
+		if (Format <= DXGI_FORMAT_R1_UNORM) return 1;
+		if (Format == DXGI_FORMAT_B5G6R5_UNORM || Format == DXGI_FORMAT_B5G5R5A1_UNORM) return 2;
+		return 4;
+	}
+
+	// MipLevels of Desc must be resolved (not 0); OutRowCount is in rows of blocks for block-compressed formats
+	static size_t GetSubresourceByteSize(const D3D11_TEXTURE2D_DESC& Desc, UINT MipLevel, UINT& OutRowPitch, UINT& OutRowCount)
+	{
+		UINT BlockSize{};
+		const UINT KElementByteSize{ GetFormatElementByteSize(Desc.Format, BlockSize) };
+		const UINT KWidth{ max(Desc.Width >> MipLevel, 1u) };
+		const UINT KHeight{ max(Desc.Height >> MipLevel, 1u) };
+		OutRowPitch = (KWidth + BlockSize - 1) / BlockSize * KElementByteSize;
+		OutRowCount = (KHeight + BlockSize - 1) / BlockSize;
+		return static_cast<size_t>(OutRowPitch) * OutRowCount;
+	}
+};
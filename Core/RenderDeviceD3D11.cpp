@@ -0,0 +1,450 @@
+#include "RenderDeviceD3D11.h"
+
+CRenderDeviceD3D11::CRenderDeviceD3D11(ID3D11DeviceContext* const PtrDeviceContext) : m_PtrDeviceContext{ PtrDeviceContext }
+{
+	assert(m_PtrDeviceContext);
+
+	m_PtrDeviceContext->GetDevice(m_Device.ReleaseAndGetAddressOf());
+
+	// @important: fences can't be polled on deferred contexts (GetData() is immediate-only)
+	m_bIsDeferred = (m_PtrDeviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED);
+	if (!m_bIsDeferred)
+	{
+		D3D11_QUERY_DESC QueryDesc{};
+		QueryDesc.Query = D3D11_QUERY_EVENT;
+		for (auto& FenceQuery : m_FenceQueries)
+		{
+			m_Device->CreateQuery(&QueryDesc, FenceQuery.Query.ReleaseAndGetAddressOf());
+		}
+	}
+
+	// @important: without the D3D11.1 runtime and driver support, constant buffers are never bound by ranges
+	if (FAILED(m_PtrDeviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), 
+		reinterpret_cast<void**>(m_DeviceContext1.ReleaseAndGetAddressOf())))) return;
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS Options{};
+	if (SUCCEEDED(m_Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &Options, sizeof(Options))))
+	{
+		m_bSupportsConstantBufferRanges = Options.ConstantBufferOffsetting && Options.MapNoOverwriteOnDynamicConstantBuffer;
+	}
+}
+
+HRESULT CRenderDeviceD3D11::CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+	ID3D11Buffer** const PtrOutBuffer)
+{
+	return m_Device->CreateBuffer(&Desc, PtrInitialData, PtrOutBuffer);
+}
+
+HRESULT CRenderDeviceD3D11::CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+	ID3D11Texture2D** const PtrOutTexture)
+{
+	return m_Device->CreateTexture2D(&Desc, PtrInitialData, PtrOutTexture);
+}
+
+HRESULT CRenderDeviceD3D11::CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	return m_Device->CreateShaderResourceView(PtrResource, PtrDesc, PtrOutView);
+}
+
+HRESULT CRenderDeviceD3D11::CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+	ID3D11RenderTargetView** const PtrOutView)
+{
+	return m_Device->CreateRenderTargetView(PtrResource, PtrDesc, PtrOutView);
+}
+
+HRESULT CRenderDeviceD3D11::CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+	ID3D11DepthStencilView** const PtrOutView)
+{
+	return m_Device->CreateDepthStencilView(PtrResource, PtrDesc, PtrOutView);
+}
+
+HRESULT CRenderDeviceD3D11::CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState)
+{
+	return m_Device->CreateSamplerState(&Desc, PtrOutState);
+}
+
+HRESULT CRenderDeviceD3D11::CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState)
+{
+	return m_Device->CreateRasterizerState(&Desc, PtrOutState);
+}
+
+HRESULT CRenderDeviceD3D11::CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState)
+{
+	return m_Device->CreateDepthStencilState(&Desc, PtrOutState);
+}
+
+HRESULT CRenderDeviceD3D11::CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState)
+{
+	return m_Device->CreateBlendState(&Desc, PtrOutState);
+}
+
+HRESULT CRenderDeviceD3D11::CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader)
+{
+	return m_Device->CreateVertexShader(PtrBytecode, ByteSize, nullptr, PtrOutShader);
+}
+
+HRESULT CRenderDeviceD3D11::CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader)
+{
+	return m_Device->CreateHullShader(PtrBytecode, ByteSize, nullptr, PtrOutShader);
+}
+
+HRESULT CRenderDeviceD3D11::CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader)
+{
+	return m_Device->CreateDomainShader(PtrBytecode, ByteSize, nullptr, PtrOutShader);
+}
+
+HRESULT CRenderDeviceD3D11::CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader)
+{
+	return m_Device->CreateGeometryShader(PtrBytecode, ByteSize, nullptr, PtrOutShader);
+}
+
+HRESULT CRenderDeviceD3D11::CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader)
+{
+	return m_Device->CreatePixelShader(PtrBytecode, ByteSize, nullptr, PtrOutShader);
+}
+
+HRESULT CRenderDeviceD3D11::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount,
+	const void* const PtrBytecode, size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout)
+{
+	return m_Device->CreateInputLayout(PtrElementDescs, ElementCount, PtrBytecode, ByteSize, PtrOutInputLayout);
+}
+
+HRESULT CRenderDeviceD3D11::CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	string Ext{ FileName.substr(min(FileName.find_last_of('.'), FileName.size())) };
+	for (auto& c : Ext)
+	{
+		c = static_cast<char>(toupper(c));
+	}
+	const wstring KwFileName{ FileName.begin(), FileName.end() };
+	if (Ext == ".DDS")
+	{
+		return CreateDDSTextureFromFileEx(m_Device.Get(), KwFileName.c_str(), MaxSize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+			false, reinterpret_cast<ID3D11Resource**>(PtrOutTexture), PtrOutView);
+	}
+	return CreateWICTextureFromFileEx(m_Device.Get(), KwFileName.c_str(), MaxSize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+		WIC_LOADER_DEFAULT, reinterpret_cast<ID3D11Resource**>(PtrOutTexture), PtrOutView);
+}
+
+HRESULT CRenderDeviceD3D11::CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	return CreateWICTextureFromMemory(m_Device.Get(), PtrData, ByteSize, reinterpret_cast<ID3D11Resource**>(PtrOutTexture), PtrOutView);
+}
+
+void CRenderDeviceD3D11::SetVertexShader(ID3D11VertexShader* const PtrShader)
+{
+	m_PtrDeviceContext->VSSetShader(PtrShader, nullptr, 0);
+}
+
+void CRenderDeviceD3D11::SetHullShader(ID3D11HullShader* const PtrShader)
+{
+	m_PtrDeviceContext->HSSetShader(PtrShader, nullptr, 0);
+}
+
+void CRenderDeviceD3D11::SetDomainShader(ID3D11DomainShader* const PtrShader)
+{
+	m_PtrDeviceContext->DSSetShader(PtrShader, nullptr, 0);
+}
+
+void CRenderDeviceD3D11::SetGeometryShader(ID3D11GeometryShader* const PtrShader)
+{
+	m_PtrDeviceContext->GSSetShader(PtrShader, nullptr, 0);
+}
+
+void CRenderDeviceD3D11::SetPixelShader(ID3D11PixelShader* const PtrShader)
+{
+	m_PtrDeviceContext->PSSetShader(PtrShader, nullptr, 0);
+}
+
+void CRenderDeviceD3D11::SetInputLayout(ID3D11InputLayout* const PtrInputLayout)
+{
+	m_PtrDeviceContext->IASetInputLayout(PtrInputLayout);
+}
+
+void CRenderDeviceD3D11::SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer)
+{
+	ID3D11Buffer* const Buffers[1]{ PtrBuffer };
+	switch (eShaderType)
+	{
+	case EShaderType::VertexShader:
+		m_PtrDeviceContext->VSSetConstantBuffers(Slot, 1, Buffers);
+		break;
+	case EShaderType::HullShader:
+		m_PtrDeviceContext->HSSetConstantBuffers(Slot, 1, Buffers);
+		break;
+	case EShaderType::DomainShader:
+		m_PtrDeviceContext->DSSetConstantBuffers(Slot, 1, Buffers);
+		break;
+	case EShaderType::GeometryShader:
+		m_PtrDeviceContext->GSSetConstantBuffers(Slot, 1, Buffers);
+		break;
+	case EShaderType::PixelShader:
+		m_PtrDeviceContext->PSSetConstantBuffers(Slot, 1, Buffers);
+		break;
+	default:
+		break;
+	}
+}
+
+void CRenderDeviceD3D11::SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView)
+{
+	ID3D11ShaderResourceView* const ShaderResourceViews[1]{ PtrShaderResourceView };
+	switch (eShaderType)
+	{
+	case EShaderType::VertexShader:
+		m_PtrDeviceContext->VSSetShaderResources(Slot, 1, ShaderResourceViews);
+		break;
+	case EShaderType::HullShader:
+		m_PtrDeviceContext->HSSetShaderResources(Slot, 1, ShaderResourceViews);
+		break;
+	case EShaderType::DomainShader:
+		m_PtrDeviceContext->DSSetShaderResources(Slot, 1, ShaderResourceViews);
+		break;
+	case EShaderType::GeometryShader:
+		m_PtrDeviceContext->GSSetShaderResources(Slot, 1, ShaderResourceViews);
+		break;
+	case EShaderType::PixelShader:
+		m_PtrDeviceContext->PSSetShaderResources(Slot, 1, ShaderResourceViews);
+		break;
+	default:
+		break;
+	}
+}
+
+void CRenderDeviceD3D11::SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState)
+{
+	ID3D11SamplerState* const SamplerStates[1]{ PtrState };
+	switch (eShaderType)
+	{
+	case EShaderType::VertexShader:
+		m_PtrDeviceContext->VSSetSamplers(Slot, 1, SamplerStates);
+		break;
+	case EShaderType::HullShader:
+		m_PtrDeviceContext->HSSetSamplers(Slot, 1, SamplerStates);
+		break;
+	case EShaderType::DomainShader:
+		m_PtrDeviceContext->DSSetSamplers(Slot, 1, SamplerStates);
+		break;
+	case EShaderType::GeometryShader:
+		m_PtrDeviceContext->GSSetSamplers(Slot, 1, SamplerStates);
+		break;
+	case EShaderType::PixelShader:
+		m_PtrDeviceContext->PSSetSamplers(Slot, 1, SamplerStates);
+		break;
+	default:
+		break;
+	}
+}
+
+void CRenderDeviceD3D11::SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant,
+	UINT ConstantCount)
+{
+	assert(m_bSupportsConstantBufferRanges);
+
+	ID3D11Buffer* const Buffers[1]{ PtrBuffer };
+	switch (eShaderType)
+	{
+	case EShaderType::VertexShader:
+		m_DeviceContext1->VSSetConstantBuffers1(Slot, 1, Buffers, &FirstConstant, &ConstantCount);
+		break;
+	case EShaderType::HullShader:
+		m_DeviceContext1->HSSetConstantBuffers1(Slot, 1, Buffers, &FirstConstant, &ConstantCount);
+		break;
+	case EShaderType::DomainShader:
+		m_DeviceContext1->DSSetConstantBuffers1(Slot, 1, Buffers, &FirstConstant, &ConstantCount);
+		break;
+	case EShaderType::GeometryShader:
+		m_DeviceContext1->GSSetConstantBuffers1(Slot, 1, Buffers, &FirstConstant, &ConstantCount);
+		break;
+	case EShaderType::PixelShader:
+		m_DeviceContext1->PSSetConstantBuffers1(Slot, 1, Buffers, &FirstConstant, &ConstantCount);
+		break;
+	default:
+		break;
+	}
+}
+
+void CRenderDeviceD3D11::SetRasterizerState(ID3D11RasterizerState* const PtrState)
+{
+	m_PtrDeviceContext->RSSetState(PtrState);
+}
+
+void CRenderDeviceD3D11::SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef)
+{
+	m_PtrDeviceContext->OMSetDepthStencilState(PtrState, StencilRef);
+}
+
+void CRenderDeviceD3D11::SetBlendState(ID3D11BlendState* const PtrState)
+{
+	m_PtrDeviceContext->OMSetBlendState(PtrState, nullptr, 0xFFFFFFFF);
+}
+
+void CRenderDeviceD3D11::SetViewport(const D3D11_VIEWPORT& Viewport)
+{
+	m_PtrDeviceContext->RSSetViewports(1, &Viewport);
+}
+
+void CRenderDeviceD3D11::SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView)
+{
+	ID3D11RenderTargetView* const RenderTargetViews[1]{ PtrRenderTargetView };
+	m_PtrDeviceContext->OMSetRenderTargets(1, RenderTargetViews, PtrDepthStencilView);
+}
+
+void CRenderDeviceD3D11::ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4])
+{
+	m_PtrDeviceContext->ClearRenderTargetView(PtrRenderTargetView, Color);
+}
+
+void CRenderDeviceD3D11::ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+	m_PtrDeviceContext->ClearDepthStencilView(PtrDepthStencilView, ClearFlags, Depth, Stencil);
+}
+
+void CRenderDeviceD3D11::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology)
+{
+	m_PtrDeviceContext->IASetPrimitiveTopology(eTopology);
+}
+
+void CRenderDeviceD3D11::SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset)
+{
+	ID3D11Buffer* const Buffers[1]{ PtrBuffer };
+	m_PtrDeviceContext->IASetVertexBuffers(Slot, 1, Buffers, &Stride, &Offset);
+}
+
+void CRenderDeviceD3D11::SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+	m_PtrDeviceContext->IASetIndexBuffer(PtrBuffer, Format, Offset);
+}
+
+void* CRenderDeviceD3D11::Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize)
+{
+	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
+	if (FAILED(m_PtrDeviceContext->Map(PtrBuffer, 0, eMapType, 0, &MappedSubresource))) return nullptr;
+	return MappedSubresource.pData;
+}
+
+void CRenderDeviceD3D11::Unmap(ID3D11Buffer* const PtrBuffer)
+{
+	m_PtrDeviceContext->Unmap(PtrBuffer, 0);
+}
+
+void CRenderDeviceD3D11::UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize)
+{
+	m_PtrDeviceContext->UpdateSubresource(PtrBuffer, 0, nullptr, PtrData, ByteSize, 0);
+}
+
+void CRenderDeviceD3D11::CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset,
+	UINT ByteSize)
+{
+	D3D11_BOX Box{};
+	Box.left = SrcOffset;
+	Box.right = SrcOffset + ByteSize;
+	Box.top = 0;
+	Box.bottom = 1;
+	Box.front = 0;
+	Box.back = 1;
+	m_PtrDeviceContext->CopySubresourceRegion(PtrDstBuffer, 0, DstOffset, 0, 0, PtrSrcBuffer, 0, &Box);
+}
+
+bool CRenderDeviceD3D11::MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, 
+	D3D11_MAPPED_SUBRESOURCE& OutMapped)
+{
+	return SUCCEEDED(m_PtrDeviceContext->Map(PtrTexture, Subresource, eMapType, 0, &OutMapped));
+}
+
+void CRenderDeviceD3D11::UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource)
+{
+	m_PtrDeviceContext->Unmap(PtrTexture, Subresource);
+}
+
+void CRenderDeviceD3D11::UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, 
+	const void* const PtrData, UINT RowPitch)
+{
+	m_PtrDeviceContext->UpdateSubresource(PtrTexture, Subresource, PtrBox, PtrData, RowPitch, 0);
+}
+
+void CRenderDeviceD3D11::CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY,
+	ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox)
+{
+	m_PtrDeviceContext->CopySubresourceRegion(PtrDstTexture, DstSubresource, DstX, DstY, 0, PtrSrcTexture, SrcSubresource, PtrSrcBox);
+}
+
+void CRenderDeviceD3D11::GenerateMips(ID3D11ShaderResourceView* const PtrView)
+{
+	m_PtrDeviceContext->GenerateMips(PtrView);
+}
+
+void CRenderDeviceD3D11::SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD)
+{
+	m_PtrDeviceContext->SetResourceMinLOD(PtrResource, MinLOD);
+}
+
+void CRenderDeviceD3D11::SignalFence(uint64_t FenceValue)
+{
+	assert(!m_bIsDeferred);
+
+	// Every query is in flight, so the oldest one has to be waited for
+	if (m_PendingFenceCount == KFenceQueryCount)
+	{
+		SFenceQuery& OldestFenceQuery{ m_FenceQueries[m_OldestFenceIndex] };
+		while (m_PtrDeviceContext->GetData(OldestFenceQuery.Query.Get(), nullptr, 0, 0) == S_FALSE);
+		m_CompletedFence = OldestFenceQuery.FenceValue;
+		m_OldestFenceIndex = (m_OldestFenceIndex + 1) % KFenceQueryCount;
+		--m_PendingFenceCount;
+	}
+
+	SFenceQuery& FenceQuery{ m_FenceQueries[(m_OldestFenceIndex + m_PendingFenceCount) % KFenceQueryCount] };
+	FenceQuery.FenceValue = FenceValue;
+	m_PtrDeviceContext->End(FenceQuery.Query.Get());
+	++m_PendingFenceCount;
+}
+
+uint64_t CRenderDeviceD3D11::GetCompletedFence()
+{
+	if (m_bIsDeferred) return m_CompletedFence;
+
+	while (m_PendingFenceCount)
+	{
+		SFenceQuery& OldestFenceQuery{ m_FenceQueries[m_OldestFenceIndex] };
+		if (m_PtrDeviceContext->GetData(OldestFenceQuery.Query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+
+		m_CompletedFence = OldestFenceQuery.FenceValue;
+		m_OldestFenceIndex = (m_OldestFenceIndex + 1) % KFenceQueryCount;
+		--m_PendingFenceCount;
+	}
+	return m_CompletedFence;
+}
+
+void CRenderDeviceD3D11::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+	m_PtrDeviceContext->Draw(VertexCount, StartVertexLocation);
+}
+
+void CRenderDeviceD3D11::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+	m_PtrDeviceContext->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void CRenderDeviceD3D11::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+	UINT StartInstanceLocation)
+{
+	m_PtrDeviceContext->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+}
+
+bool CRenderDeviceD3D11::FinishCommandList(ComPtr<ID3D11CommandList>& OutCommandList)
+{
+	assert(m_bIsDeferred);
+
+	return SUCCEEDED(m_PtrDeviceContext->FinishCommandList(FALSE, OutCommandList.ReleaseAndGetAddressOf()));
+}
+
+void CRenderDeviceD3D11::ExecuteCommandList(ID3D11CommandList* const PtrCommandList)
+{
+	assert(!m_bIsDeferred);
+
+	// @important: the state isn't restored afterwards (the context is left in the default state)
+	m_PtrDeviceContext->ExecuteCommandList(PtrCommandList, FALSE);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <d3d11_1.h>
+#include "RenderDevice.h"
+
+class CRenderDeviceD3D11 final : public CRenderDevice
+{
+	struct SFenceQuery
+	{
+		ComPtr<ID3D11Query>	Query{};
+		uint64_t			FenceValue{};
+	};
+
+public:
+	CRenderDeviceD3D11(ID3D11DeviceContext* const PtrDeviceContext);
+	~CRenderDeviceD3D11() {}
+
+public:
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData, 
+		ID3D11Buffer** const PtrOutBuffer) override;
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+		ID3D11Texture2D** const PtrOutTexture) override;
+	HRESULT CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+	HRESULT CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+		ID3D11RenderTargetView** const PtrOutView) override;
+	HRESULT CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+		ID3D11DepthStencilView** const PtrOutView) override;
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState) override;
+	HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState) override;
+	HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState) override;
+	HRESULT CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState) override;
+	HRESULT CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader) override;
+	HRESULT CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader) override;
+	HRESULT CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader) override;
+	HRESULT CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader) override;
+	HRESULT CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader) override;
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount, const void* const PtrBytecode,
+		size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout) override;
+
+	// DirectXTK's DDS and WIC loaders
+	HRESULT CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+	HRESULT CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+
+public:
+	void SetVertexShader(ID3D11VertexShader* const PtrShader) override;
+	void SetHullShader(ID3D11HullShader* const PtrShader) override;
+	void SetDomainShader(ID3D11DomainShader* const PtrShader) override;
+	void SetGeometryShader(ID3D11GeometryShader* const PtrShader) override;
+	void SetPixelShader(ID3D11PixelShader* const PtrShader) override;
+	void SetInputLayout(ID3D11InputLayout* const PtrInputLayout) override;
+	void SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer) override;
+	void SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView) override;
+	void SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState) override;
+
+	void SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant, UINT ConstantCount) override;
+	bool SupportsConstantBufferRanges() const override { return m_bSupportsConstantBufferRanges; }
+
+	void SetRasterizerState(ID3D11RasterizerState* const PtrState) override;
+	void SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef) override;
+	void SetBlendState(ID3D11BlendState* const PtrState) override;
+	void SetViewport(const D3D11_VIEWPORT& Viewport) override;
+	void SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView) override;
+
+	void ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4]) override;
+	void ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) override;
+
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology) override;
+	void SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset) override;
+	void SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset) override;
+
+	void* Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize) override;
+	void Unmap(ID3D11Buffer* const PtrBuffer) override;
+	void UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize) override;
+	void CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset, UINT ByteSize) override;
+
+	bool MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped) override;
+	void UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource) override;
+	void UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, const void* const PtrData,
+		UINT RowPitch) override;
+	void CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY, 
+		ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox) override;
+	void GenerateMips(ID3D11ShaderResourceView* const PtrView) override;
+	void SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD) override;
+
+	// Event queries (D3D11_QUERY_EVENT)
+	void SignalFence(uint64_t FenceValue) override;
+	uint64_t GetCompletedFence() override;
+
+	void Draw(UINT VertexCount, UINT StartVertexLocation) override;
+	void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) override;
+	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+		UINT StartInstanceLocation) override;
+
+public:
+	// A deferred context records command lists (e.g. to replay command buffers on other threads), which the immediate context executes
+	bool IsDeferred() const { return m_bIsDeferred; }
+	bool FinishCommandList(ComPtr<ID3D11CommandList>& OutCommandList);
+	void ExecuteCommandList(ID3D11CommandList* const PtrCommandList);
+
+public:
+	static constexpr size_t			KFenceQueryCount{ 8 };
+
+public:
+	ID3D11Device* GetDevicePtr() const { return m_Device.Get(); }
+
+private:
+	ComPtr<ID3D11Device>			m_Device{};
+	ID3D11DeviceContext* const		m_PtrDeviceContext{};
+	ComPtr<ID3D11DeviceContext1>	m_DeviceContext1{};
+	bool							m_bSupportsConstantBufferRanges{};
+	bool							m_bIsDeferred{};
+
+private:
+	SFenceQuery						m_FenceQueries[KFenceQueryCount]{};
+	size_t							m_OldestFenceIndex{};
+	size_t							m_PendingFenceCount{};
+	uint64_t						m_CompletedFence{};
+};
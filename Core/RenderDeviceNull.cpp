@@ -0,0 +1,801 @@
+#include "RenderDeviceNull.h"
+#include "TextureCooker.h"
+#include <atomic>
+
+// Reference-counted like COM objects (deleted on the last Release()), without a device or private data
+template <typename TInterface>
+class CNullDeviceChild : public TInterface
+{
+public:
+	CNullDeviceChild() {}
+	virtual ~CNullDeviceChild() {}
+
+public:
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+	{
+		if (ppvObject) *ppvObject = nullptr;
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		const ULONG KRefCount{ --m_RefCount };
+		if (KRefCount == 0) delete this;
+		return KRefCount;
+	}
+
+public:
+	void STDMETHODCALLTYPE GetDevice(ID3D11Device** ppDevice) override { if (ppDevice) *ppDevice = nullptr; }
+	HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override { return E_FAIL; }
+	HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override { return E_FAIL; }
+	HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override { return E_FAIL; }
+
+private:
+	std::atomic<ULONG>	m_RefCount{ 1 };
+};
+
+template <typename TInterface, typename TDesc, D3D11_RESOURCE_DIMENSION KDimension>
+class CNullResource final : public CNullDeviceChild<TInterface>
+{
+public:
+	CNullResource(const TDesc& Desc) : m_Desc{ Desc } {}
+	~CNullResource() {}
+
+public:
+	void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) override { *pResourceDimension = KDimension; }
+	void STDMETHODCALLTYPE SetEvictionPriority(UINT EvictionPriority) override { m_EvictionPriority = EvictionPriority; }
+	UINT STDMETHODCALLTYPE GetEvictionPriority() override { return m_EvictionPriority; }
+	void STDMETHODCALLTYPE GetDesc(TDesc* pDesc) override { *pDesc = m_Desc; }
+
+private:
+	TDesc	m_Desc{};
+	UINT	m_EvictionPriority{};
+};
+
+// Keeps its resource alive, as D3D11 views do
+template <typename TInterface, typename TDesc>
+class CNullView final : public CNullDeviceChild<TInterface>
+{
+public:
+	CNullView(ID3D11Resource* const PtrResource, const TDesc& Desc) : m_Resource{ PtrResource }, m_Desc{ Desc } {}
+	~CNullView() {}
+
+public:
+	void STDMETHODCALLTYPE GetResource(ID3D11Resource** ppResource) override
+	{
+		*ppResource = m_Resource.Get();
+		if (*ppResource) (*ppResource)->AddRef();
+	}
+	void STDMETHODCALLTYPE GetDesc(TDesc* pDesc) override { *pDesc = m_Desc; }
+
+private:
+	ComPtr<ID3D11Resource>	m_Resource{};
+	TDesc					m_Desc{};
+};
+
+template <typename TInterface, typename TDesc>
+class CNullState final : public CNullDeviceChild<TInterface>
+{
+public:
+	CNullState(const TDesc& Desc) : m_Desc{ Desc } {}
+	~CNullState() {}
+
+public:
+	void STDMETHODCALLTYPE GetDesc(TDesc* pDesc) override { *pDesc = m_Desc; }
+
+private:
+	TDesc	m_Desc{};
+};
+
+using CNullBuffer = CNullResource<ID3D11Buffer, D3D11_BUFFER_DESC, D3D11_RESOURCE_DIMENSION_BUFFER>;
+using CNullTexture2D = CNullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE2D>;
+
+template <typename TInterface>
+static HRESULT OutputObject(TInterface* const PtrObject, TInterface** const PtrOutObject)
+{
+	if (!PtrOutObject)
+	{
+		// @important: D3D11 validates the arguments without creating the object when the output is nullptr
+		PtrObject->Release();
+		return S_FALSE;
+	}
+	*PtrOutObject = PtrObject;
+	return S_OK;
+}
+
+template <typename TInterface>
+static HRESULT CreateShaderObject(const void* const PtrBytecode, size_t ByteSize, TInterface** const PtrOutShader)
+{
+	if (!PtrBytecode || ByteSize == 0) return E_INVALIDARG;
+	return OutputObject<TInterface>(new CNullDeviceChild<TInterface>(), PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+	ID3D11Buffer** const PtrOutBuffer)
+{
+	const bool KbIsDynamic{ Desc.Usage == D3D11_USAGE_DYNAMIC };
+	Validate(Desc.ByteWidth > 0, "empty buffer");
+	Validate(!(Desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) || Desc.ByteWidth % 16 == 0, "constant buffer size not a multiple of 16");
+	Validate(KbIsDynamic == ((Desc.CPUAccessFlags & D3D11_CPU_ACCESS_WRITE) != 0), "dynamic buffers (only) need CPU write access");
+	Validate(Desc.Usage != D3D11_USAGE_IMMUTABLE || PtrInitialData != nullptr, "immutable buffer without initial data");
+	if (Desc.ByteWidth == 0) return E_INVALIDARG;
+	if (!PtrOutBuffer) return S_FALSE;
+
+	ID3D11Buffer* const PtrBuffer{ new CNullBuffer(Desc) };
+	SBufferMemory& Memory{ m_umapBufferMemory[PtrBuffer] };
+	Memory = SBufferMemory();
+	if (PtrInitialData && PtrInitialData->pSysMem)
+	{
+		const uint8_t* const PtrBytes{ static_cast<const uint8_t*>(PtrInitialData->pSysMem) };
+		Memory.vData.assign(PtrBytes, PtrBytes + Desc.ByteWidth);
+	}
+
+	++m_Stats.CreationCount;
+	m_Stats.CreatedByteCount += Desc.ByteWidth;
+	return OutputObject(PtrBuffer, PtrOutBuffer);
+}
+
+HRESULT CRenderDeviceNull::CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+	ID3D11Texture2D** const PtrOutTexture)
+{
+	const bool KbIsDynamic{ Desc.Usage == D3D11_USAGE_DYNAMIC };
+	UINT BlockSize{};
+	Validate(Desc.Width > 0 && Desc.Height > 0 && Desc.Width <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION &&
+		Desc.Height <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION, "invalid texture size");
+	Validate(Desc.ArraySize > 0, "texture without array slices");
+	Validate(GetFormatElementByteSize(Desc.Format, BlockSize) > 0, "texture without a format");
+	Validate(!KbIsDynamic || Desc.MipLevels == 1, "dynamic textures can't have mips");
+	Validate(KbIsDynamic == ((Desc.CPUAccessFlags & D3D11_CPU_ACCESS_WRITE) != 0), "dynamic textures (only) need CPU write access");
+	Validate(!(Desc.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS) ||
+		((Desc.BindFlags & D3D11_BIND_RENDER_TARGET) && (Desc.BindFlags & D3D11_BIND_SHADER_RESOURCE)), "mips generated without render target binding");
+	Validate(Desc.Usage != D3D11_USAGE_IMMUTABLE || PtrInitialData != nullptr, "immutable texture without initial data");
+	if (Desc.Width == 0 || Desc.Height == 0 || Desc.ArraySize == 0 || Desc.Format == DXGI_FORMAT_UNKNOWN) return E_INVALIDARG;
+
+	return CreateTexture(Desc, PtrOutTexture, nullptr);
+}
+
+HRESULT CRenderDeviceNull::CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	const D3D11_TEXTURE2D_DESC* const PtrTextureDesc{ GetTextureDesc(static_cast<ID3D11Texture2D*>(PtrResource)) };
+	Validate(PtrTextureDesc != nullptr, "shader resource view of a texture the device didn't create");
+	Validate(!PtrTextureDesc || (PtrTextureDesc->BindFlags & D3D11_BIND_SHADER_RESOURCE), "shader resource view without binding");
+	if (!PtrTextureDesc) return E_INVALIDARG;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC Desc{};
+	if (PtrDesc)
+	{
+		Desc = *PtrDesc;
+	}
+	else
+	{
+		Desc.Format = PtrTextureDesc->Format;
+		Desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		Desc.Texture2D.MipLevels = PtrTextureDesc->MipLevels;
+	}
+	return OutputObject<ID3D11ShaderResourceView>(
+		new CNullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC>(PtrResource, Desc), PtrOutView);
+}
+
+HRESULT CRenderDeviceNull::CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+	ID3D11RenderTargetView** const PtrOutView)
+{
+	const D3D11_TEXTURE2D_DESC* const PtrTextureDesc{ GetTextureDesc(static_cast<ID3D11Texture2D*>(PtrResource)) };
+	Validate(PtrTextureDesc != nullptr, "render target view of a texture the device didn't create");
+	Validate(!PtrTextureDesc || (PtrTextureDesc->BindFlags & D3D11_BIND_RENDER_TARGET), "render target view without binding");
+	if (!PtrTextureDesc) return E_INVALIDARG;
+
+	D3D11_RENDER_TARGET_VIEW_DESC Desc{};
+	if (PtrDesc)
+	{
+		Desc = *PtrDesc;
+	}
+	else
+	{
+		Desc.Format = PtrTextureDesc->Format;
+		Desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+	}
+	return OutputObject<ID3D11RenderTargetView>(new CNullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC>(PtrResource, Desc), 
+		PtrOutView);
+}
+
+HRESULT CRenderDeviceNull::CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+	ID3D11DepthStencilView** const PtrOutView)
+{
+	const D3D11_TEXTURE2D_DESC* const PtrTextureDesc{ GetTextureDesc(static_cast<ID3D11Texture2D*>(PtrResource)) };
+	Validate(PtrTextureDesc != nullptr, "depth-stencil view of a texture the device didn't create");
+	Validate(!PtrTextureDesc || (PtrTextureDesc->BindFlags & D3D11_BIND_DEPTH_STENCIL), "depth-stencil view without binding");
+	if (!PtrTextureDesc) return E_INVALIDARG;
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC Desc{};
+	if (PtrDesc)
+	{
+		Desc = *PtrDesc;
+	}
+	else
+	{
+		Desc.Format = PtrTextureDesc->Format;
+		Desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	}
+	return OutputObject<ID3D11DepthStencilView>(new CNullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC>(PtrResource, Desc), 
+		PtrOutView);
+}
+
+HRESULT CRenderDeviceNull::CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState)
+{
+	Validate(Desc.MaxAnisotropy <= D3D11_MAX_MAXANISOTROPY && Desc.MinLOD <= Desc.MaxLOD, "invalid sampler state");
+	return OutputObject<ID3D11SamplerState>(new CNullState<ID3D11SamplerState, D3D11_SAMPLER_DESC>(Desc), PtrOutState);
+}
+
+HRESULT CRenderDeviceNull::CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState)
+{
+	Validate(Desc.FillMode != 0 && Desc.CullMode != 0, "invalid rasterizer state");
+	return OutputObject<ID3D11RasterizerState>(new CNullState<ID3D11RasterizerState, D3D11_RASTERIZER_DESC>(Desc), PtrOutState);
+}
+
+HRESULT CRenderDeviceNull::CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState)
+{
+	Validate(!Desc.DepthEnable || Desc.DepthFunc != 0, "depth test without a comparison");
+	return OutputObject<ID3D11DepthStencilState>(new CNullState<ID3D11DepthStencilState, D3D11_DEPTH_STENCIL_DESC>(Desc), PtrOutState);
+}
+
+HRESULT CRenderDeviceNull::CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState)
+{
+	Validate(!Desc.RenderTarget[0].BlendEnable || (Desc.RenderTarget[0].SrcBlend != 0 && Desc.RenderTarget[0].DestBlend != 0), 
+		"blending without blend factors");
+	return OutputObject<ID3D11BlendState>(new CNullState<ID3D11BlendState, D3D11_BLEND_DESC>(Desc), PtrOutState);
+}
+
+HRESULT CRenderDeviceNull::CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader)
+{
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "shader without bytecode");
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader)
+{
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "shader without bytecode");
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader)
+{
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "shader without bytecode");
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader)
+{
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "shader without bytecode");
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader)
+{
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "shader without bytecode");
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutShader);
+}
+
+HRESULT CRenderDeviceNull::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount,
+	const void* const PtrBytecode, size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout)
+{
+	Validate(PtrElementDescs != nullptr && ElementCount > 0, "input layout without elements");
+	Validate(PtrBytecode != nullptr && ByteSize > 0, "input layout without vertex shader bytecode");
+	if (!PtrElementDescs || ElementCount == 0) return E_INVALIDARG;
+	return CreateShaderObject(PtrBytecode, ByteSize, PtrOutInputLayout);
+}
+
+HRESULT CRenderDeviceNull::CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	D3D11_TEXTURE2D_DESC Desc{};
+	Desc.ArraySize = 1;
+	Desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Desc.SampleDesc.Count = 1;
+	Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	if (CTextureCooker::ReadDDSFileSize(FileName, Desc.Width, Desc.Height, Desc.MipLevels, &Desc.Format))
+	{
+		// The mips larger than MaxSize are skipped, as DirectXTK's DDS loader does
+		while (MaxSize && Desc.MipLevels > 1 && max(Desc.Width, Desc.Height) > MaxSize)
+		{
+			Desc.Width = max(Desc.Width / 2, 1u);
+			Desc.Height = max(Desc.Height / 2, 1u);
+			--Desc.MipLevels;
+		}
+	}
+	else
+	{
+		CTextureCooker::SImage Image{};
+		if (!CTextureCooker::LoadImageFromFile(FileName, Image)) return E_FAIL;
+
+		Desc.Width = Image.Width;
+		Desc.Height = Image.Height;
+		Desc.MipLevels = 1;
+	}
+	return CreateTexture(Desc, PtrOutTexture, PtrOutView);
+}
+
+HRESULT CRenderDeviceNull::CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	Validate(PtrData != nullptr && ByteSize > 0, "texture from empty memory");
+	if (!PtrData || ByteSize == 0) return E_INVALIDARG;
+
+	D3D11_TEXTURE2D_DESC Desc{};
+	Desc.Width = 1;
+	Desc.Height = 1;
+	Desc.MipLevels = 1;
+	Desc.ArraySize = 1;
+	Desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Desc.SampleDesc.Count = 1;
+	Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	return CreateTexture(Desc, PtrOutTexture, PtrOutView);
+}
+
+void CRenderDeviceNull::SetVertexShader(ID3D11VertexShader* const PtrShader)
+{
+	m_PtrVertexShader = PtrShader;
+	Record(ECommandType::SetVertexShader, EShaderType::VertexShader, 0, PtrShader);
+}
+
+void CRenderDeviceNull::SetHullShader(ID3D11HullShader* const PtrShader)
+{
+	m_PtrHullShader = PtrShader;
+	Record(ECommandType::SetHullShader, EShaderType::HullShader, 0, PtrShader);
+}
+
+void CRenderDeviceNull::SetDomainShader(ID3D11DomainShader* const PtrShader)
+{
+	m_PtrDomainShader = PtrShader;
+	Record(ECommandType::SetDomainShader, EShaderType::DomainShader, 0, PtrShader);
+}
+
+void CRenderDeviceNull::SetGeometryShader(ID3D11GeometryShader* const PtrShader)
+{
+	Record(ECommandType::SetGeometryShader, EShaderType::GeometryShader, 0, PtrShader);
+}
+
+void CRenderDeviceNull::SetPixelShader(ID3D11PixelShader* const PtrShader)
+{
+	m_PtrPixelShader = PtrShader;
+	Record(ECommandType::SetPixelShader, EShaderType::PixelShader, 0, PtrShader);
+}
+
+void CRenderDeviceNull::SetInputLayout(ID3D11InputLayout* const PtrInputLayout)
+{
+	Record(ECommandType::SetInputLayout, EShaderType::VertexShader, 0, PtrInputLayout);
+}
+
+void CRenderDeviceNull::SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer)
+{
+	Validate(Slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, "constant buffer slot out of range");
+	Record(ECommandType::SetConstantBuffer, eShaderType, Slot, PtrBuffer);
+}
+
+void CRenderDeviceNull::SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView)
+{
+	Validate(Slot < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, "shader resource slot out of range");
+	Record(ECommandType::SetShaderResource, eShaderType, Slot, PtrShaderResourceView);
+}
+
+void CRenderDeviceNull::SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState)
+{
+	Validate(Slot < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, "sampler slot out of range");
+	Record(ECommandType::SetSamplerState, eShaderType, Slot, PtrState);
+}
+
+void CRenderDeviceNull::SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant,
+	UINT ConstantCount)
+{
+	static constexpr UINT KConstantAlignment{ 16 };
+
+	Validate(m_bSupportsConstantBufferRanges, "constant buffer range without support");
+	Validate(Slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, "constant buffer slot out of range");
+	Validate(FirstConstant % KConstantAlignment == 0, "constant buffer range offset not aligned");
+	Validate(ConstantCount >= KConstantAlignment && ConstantCount % KConstantAlignment == 0 &&
+		ConstantCount <= D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT, "invalid constant buffer range size");
+	Record(ECommandType::SetConstantBufferRange, eShaderType, Slot, PtrBuffer, FirstConstant, ConstantCount);
+}
+
+void CRenderDeviceNull::SetRasterizerState(ID3D11RasterizerState* const PtrState)
+{
+	Record(ECommandType::SetRasterizerState, EShaderType::PixelShader, 0, PtrState);
+}
+
+void CRenderDeviceNull::SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef)
+{
+	Record(ECommandType::SetDepthStencilState, EShaderType::PixelShader, 0, PtrState, StencilRef);
+}
+
+void CRenderDeviceNull::SetBlendState(ID3D11BlendState* const PtrState)
+{
+	Record(ECommandType::SetBlendState, EShaderType::PixelShader, 0, PtrState);
+}
+
+void CRenderDeviceNull::SetViewport(const D3D11_VIEWPORT& Viewport)
+{
+	Validate(Viewport.Width > 0 && Viewport.Height > 0, "empty viewport");
+	Validate(Viewport.MinDepth >= 0 && Viewport.MaxDepth <= 1 && Viewport.MinDepth <= Viewport.MaxDepth, "invalid viewport depth range");
+	Record(ECommandType::SetViewport, EShaderType::PixelShader, 0, nullptr, static_cast<UINT>(Viewport.TopLeftX), 
+		static_cast<UINT>(Viewport.TopLeftY), static_cast<UINT>(Viewport.Width), static_cast<UINT>(Viewport.Height));
+}
+
+void CRenderDeviceNull::SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView)
+{
+	Validate(PtrRenderTargetView != nullptr || PtrDepthStencilView != nullptr, "no render target and depth-stencil view");
+	Record(ECommandType::SetRenderTarget, EShaderType::PixelShader, 0, PtrRenderTargetView);
+}
+
+void CRenderDeviceNull::ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4])
+{
+	Validate(PtrRenderTargetView != nullptr, "clear of a null render target view");
+	Record(ECommandType::ClearRenderTarget, EShaderType::PixelShader, 0, PtrRenderTargetView);
+}
+
+void CRenderDeviceNull::ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+	Validate(PtrDepthStencilView != nullptr, "clear of a null depth-stencil view");
+	Validate(ClearFlags != 0 && Depth >= 0 && Depth <= 1, "invalid depth-stencil clear");
+	Record(ECommandType::ClearDepthStencil, EShaderType::PixelShader, 0, PtrDepthStencilView, ClearFlags, static_cast<UINT>(Stencil));
+}
+
+void CRenderDeviceNull::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology)
+{
+	m_eTopology = eTopology;
+	Record(ECommandType::SetPrimitiveTopology, EShaderType::VertexShader, 0, nullptr, static_cast<UINT>(eTopology));
+}
+
+void CRenderDeviceNull::SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset)
+{
+	Validate(Slot < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, "vertex buffer slot out of range");
+	Validate(!PtrBuffer || Stride > 0, "vertex buffer without stride");
+	Record(ECommandType::SetVertexBuffer, EShaderType::VertexShader, Slot, PtrBuffer, Stride, Offset);
+}
+
+void CRenderDeviceNull::SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+	Validate(!PtrBuffer || Format == DXGI_FORMAT_R32_UINT || Format == DXGI_FORMAT_R16_UINT, "invalid index buffer format");
+	m_PtrIndexBuffer = PtrBuffer;
+	Record(ECommandType::SetIndexBuffer, EShaderType::VertexShader, 0, PtrBuffer, static_cast<UINT>(Format), Offset);
+}
+
+void* CRenderDeviceNull::Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize)
+{
+	Validate(PtrBuffer != nullptr, "map of a null buffer");
+	Record(ECommandType::Map, EShaderType::VertexShader, 0, PtrBuffer, static_cast<UINT>(eMapType), static_cast<UINT>(ByteSize));
+	if (!PtrBuffer) return nullptr;
+
+	SBufferMemory& Memory{ m_umapBufferMemory[PtrBuffer] };
+	Validate(!Memory.bIsMapped, "map of a mapped buffer");
+	if (Memory.vData.size() < ByteSize) Memory.vData.resize(ByteSize);
+	Memory.bIsMapped = true;
+
+	++m_Stats.MapCount;
+	m_Stats.MappedByteCount += ByteSize;
+	return Memory.vData.data();
+}
+
+void CRenderDeviceNull::Unmap(ID3D11Buffer* const PtrBuffer)
+{
+	Record(ECommandType::Unmap, EShaderType::VertexShader, 0, PtrBuffer);
+
+	auto it{ m_umapBufferMemory.find(PtrBuffer) };
+	Validate(it != m_umapBufferMemory.end() && it->second.bIsMapped, "unmap of a buffer that isn't mapped");
+	if (it != m_umapBufferMemory.end()) it->second.bIsMapped = false;
+}
+
+void CRenderDeviceNull::UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize)
+{
+	Validate(PtrBuffer != nullptr && PtrData != nullptr && ByteSize > 0, "invalid buffer update");
+	Record(ECommandType::UpdateBuffer, EShaderType::VertexShader, 0, PtrBuffer, ByteSize);
+	if (!PtrBuffer || !PtrData) return;
+
+	SBufferMemory& Memory{ m_umapBufferMemory[PtrBuffer] };
+	Validate(!Memory.bIsMapped, "update of a mapped buffer");
+	if (Memory.vData.size() < ByteSize) Memory.vData.resize(ByteSize);
+	memcpy(Memory.vData.data(), PtrData, ByteSize);
+
+	m_Stats.UpdatedByteCount += ByteSize;
+}
+
+void CRenderDeviceNull::CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset,
+	UINT ByteSize)
+{
+	Record(ECommandType::CopyBufferRegion, EShaderType::VertexShader, 0, PtrDstBuffer, DstOffset, SrcOffset, ByteSize);
+
+	auto itSrc{ m_umapBufferMemory.find(PtrSrcBuffer) };
+	const bool KbIsSrcValid{ itSrc != m_umapBufferMemory.end() && !itSrc->second.bIsMapped && 
+		static_cast<size_t>(SrcOffset) + ByteSize <= itSrc->second.vData.size() };
+	Validate(PtrDstBuffer != nullptr && PtrDstBuffer != PtrSrcBuffer, "invalid copy destination");
+	Validate(KbIsSrcValid, "copy from an invalid source range");
+	if (!KbIsSrcValid || !PtrDstBuffer || PtrDstBuffer == PtrSrcBuffer) return;
+
+	SBufferMemory& DstMemory{ m_umapBufferMemory[PtrDstBuffer] };
+	if (DstMemory.vData.size() < static_cast<size_t>(DstOffset) + ByteSize) DstMemory.vData.resize(static_cast<size_t>(DstOffset) + ByteSize);
+	memcpy(&DstMemory.vData[DstOffset], &m_umapBufferMemory[PtrSrcBuffer].vData[SrcOffset], ByteSize);
+
+	++m_Stats.CopyCount;
+	m_Stats.CopiedByteCount += ByteSize;
+}
+
+bool CRenderDeviceNull::MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped)
+{
+	Record(ECommandType::MapTexture, EShaderType::PixelShader, Subresource, PtrTexture, static_cast<UINT>(eMapType));
+	const D3D11_TEXTURE2D_DESC* const PtrDesc{ GetTextureDesc(PtrTexture) };
+	Validate(PtrDesc != nullptr && PtrDesc->Usage == D3D11_USAGE_DYNAMIC, "map of a texture that isn't dynamic");
+	if (!PtrDesc || Subresource >= PtrDesc->MipLevels * PtrDesc->ArraySize) return false;
+
+	SBufferMemory& Memory{ m_umapMappedTextureMemory[PtrTexture] };
+	Validate(!Memory.bIsMapped, "map of a mapped texture");
+	UINT RowCount{};
+	const size_t KByteSize{ GetSubresourceByteSize(*PtrDesc, Subresource % PtrDesc->MipLevels, OutMapped.RowPitch, RowCount) };
+	if (Memory.vData.size() < KByteSize) Memory.vData.resize(KByteSize);
+	Memory.bIsMapped = true;
+	OutMapped.pData = Memory.vData.data();
+	OutMapped.DepthPitch = static_cast<UINT>(KByteSize);
+
+	++m_Stats.MapCount;
+	m_Stats.MappedByteCount += KByteSize;
+	return true;
+}
+
+void CRenderDeviceNull::UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource)
+{
+	Record(ECommandType::UnmapTexture, EShaderType::PixelShader, Subresource, PtrTexture);
+
+	auto it{ m_umapMappedTextureMemory.find(PtrTexture) };
+	Validate(it != m_umapMappedTextureMemory.end() && it->second.bIsMapped, "unmap of a texture that isn't mapped");
+	if (it != m_umapMappedTextureMemory.end()) it->second.bIsMapped = false;
+}
+
+void CRenderDeviceNull::UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox,
+	const void* const PtrData, UINT RowPitch)
+{
+	Record(ECommandType::UpdateTexture, EShaderType::PixelShader, Subresource, PtrTexture, RowPitch);
+	const size_t KByteSize{ ValidateTextureBox(PtrTexture, Subresource, PtrBox, "invalid texture update") };
+	const D3D11_TEXTURE2D_DESC* const PtrDesc{ GetTextureDesc(PtrTexture) };
+	Validate(PtrData != nullptr, "texture update without data");
+	Validate(!PtrDesc || PtrDesc->Usage == D3D11_USAGE_DEFAULT, "update of a texture that isn't default-usage");
+
+	m_Stats.UpdatedByteCount += KByteSize;
+}
+
+void CRenderDeviceNull::CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY,
+	ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox)
+{
+	Record(ECommandType::CopyTextureRegion, EShaderType::PixelShader, DstSubresource, PtrDstTexture, DstX, DstY, SrcSubresource);
+	const size_t KByteSize{ ValidateTextureBox(PtrSrcTexture, SrcSubresource, PtrSrcBox, "copy from an invalid texture region") };
+	const D3D11_TEXTURE2D_DESC* const PtrDstDesc{ GetTextureDesc(PtrDstTexture) };
+	const D3D11_TEXTURE2D_DESC* const PtrSrcDesc{ GetTextureDesc(PtrSrcTexture) };
+	Validate(PtrDstDesc != nullptr && PtrDstDesc->Usage != D3D11_USAGE_IMMUTABLE && PtrDstTexture != PtrSrcTexture && 
+		DstSubresource < PtrDstDesc->MipLevels * PtrDstDesc->ArraySize, "invalid texture copy destination");
+	if (PtrDstDesc && PtrSrcDesc)
+	{
+		UINT DstBlockSize{};
+		UINT SrcBlockSize{};
+		Validate(GetFormatElementByteSize(PtrDstDesc->Format, DstBlockSize) == GetFormatElementByteSize(PtrSrcDesc->Format, SrcBlockSize) &&
+			DstBlockSize == SrcBlockSize, "texture copy between incompatible formats");
+
+		// The box must fit in the destination subresource too
+		const UINT KDstMip{ DstSubresource % PtrDstDesc->MipLevels };
+		const UINT KSrcMip{ SrcSubresource % PtrSrcDesc->MipLevels };
+		const UINT KWidth{ (PtrSrcBox) ? PtrSrcBox->right - PtrSrcBox->left : max(PtrSrcDesc->Width >> KSrcMip, 1u) };
+		const UINT KHeight{ (PtrSrcBox) ? PtrSrcBox->bottom - PtrSrcBox->top : max(PtrSrcDesc->Height >> KSrcMip, 1u) };
+		Validate(DstX + KWidth <= max(PtrDstDesc->Width >> KDstMip, 1u) && DstY + KHeight <= max(PtrDstDesc->Height >> KDstMip, 1u),
+			"texture copy out of the destination");
+	}
+	if (!KByteSize) return;
+
+	++m_Stats.CopyCount;
+	m_Stats.CopiedByteCount += KByteSize;
+}
+
+void CRenderDeviceNull::GenerateMips(ID3D11ShaderResourceView* const PtrView)
+{
+	Record(ECommandType::GenerateMips, EShaderType::PixelShader, 0, PtrView);
+	Validate(PtrView != nullptr, "mips generated for a null view");
+}
+
+void CRenderDeviceNull::SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD)
+{
+	ID3D11Texture2D* const PtrTexture{ static_cast<ID3D11Texture2D*>(PtrResource) };
+	UINT MinLODBits{};
+	memcpy(&MinLODBits, &MinLOD, sizeof(MinLODBits));
+	Record(ECommandType::SetResourceMinLOD, EShaderType::PixelShader, 0, PtrResource, MinLODBits);
+	Validate(GetTextureDesc(PtrTexture) != nullptr, "min LOD of a texture the device didn't create");
+	Validate(MinLOD >= 0.0f, "negative min LOD");
+	if (!GetTextureDesc(PtrTexture)) return;
+
+	m_umapTextureMinLODs[PtrTexture] = MinLOD;
+}
+
+void CRenderDeviceNull::SignalFence(uint64_t FenceValue)
+{
+	Validate(FenceValue > m_LastSignaledFence, "fence values must increase");
+	Record(ECommandType::SignalFence, EShaderType::VertexShader, 0, nullptr, static_cast<UINT>(FenceValue));
+	m_LastSignaledFence = FenceValue;
+
+	// Without a GPU, a fence is passed once FenceLatency newer fences have been signaled
+	m_vPendingFences.emplace_back(FenceValue);
+	if (m_vPendingFences.size() > m_FenceLatency)
+	{
+		const size_t KPassedFenceCount{ m_vPendingFences.size() - m_FenceLatency };
+		m_CompletedFence = m_vPendingFences[KPassedFenceCount - 1];
+		m_vPendingFences.erase(m_vPendingFences.begin(), m_vPendingFences.begin() + KPassedFenceCount);
+	}
+}
+
+void CRenderDeviceNull::SetFenceLatency(size_t FenceLatency)
+{
+	m_FenceLatency = FenceLatency;
+}
+
+void CRenderDeviceNull::CompleteFences()
+{
+	if (m_vPendingFences.empty()) return;
+
+	m_CompletedFence = m_vPendingFences.back();
+	m_vPendingFences.clear();
+}
+
+void CRenderDeviceNull::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+	ValidateDraw(false, VertexCount);
+	Record(ECommandType::Draw, EShaderType::VertexShader, 0, nullptr, VertexCount, StartVertexLocation);
+}
+
+void CRenderDeviceNull::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+	ValidateDraw(true, IndexCount);
+	Record(ECommandType::DrawIndexed, EShaderType::VertexShader, 0, nullptr, IndexCount, StartIndexLocation, static_cast<UINT>(BaseVertexLocation));
+}
+
+void CRenderDeviceNull::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+	UINT StartInstanceLocation)
+{
+	ValidateDraw(true, IndexCountPerInstance * InstanceCount);
+	Record(ECommandType::DrawIndexedInstanced, EShaderType::VertexShader, 0, nullptr, IndexCountPerInstance, InstanceCount, StartIndexLocation,
+		static_cast<UINT>(BaseVertexLocation), StartInstanceLocation);
+}
+
+void CRenderDeviceNull::Reset()
+{
+	m_vCommands.clear();
+	m_Stats = SStats();
+	m_LastValidationError.clear();
+}
+
+const vector<uint8_t>* CRenderDeviceNull::GetBufferMemory(const ID3D11Buffer* const PtrBuffer) const
+{
+	auto it{ m_umapBufferMemory.find(PtrBuffer) };
+	if (it == m_umapBufferMemory.end()) return nullptr;
+	return &it->second.vData;
+}
+
+const D3D11_TEXTURE2D_DESC* CRenderDeviceNull::GetTextureDesc(const ID3D11Texture2D* const PtrTexture) const
+{
+	auto it{ m_umapTextureDescs.find(PtrTexture) };
+	if (it == m_umapTextureDescs.end()) return nullptr;
+	return &it->second;
+}
+
+FLOAT CRenderDeviceNull::GetResourceMinLOD(const ID3D11Texture2D* const PtrTexture) const
+{
+	auto it{ m_umapTextureMinLODs.find(PtrTexture) };
+	if (it == m_umapTextureMinLODs.end()) return 0.0f;
+	return it->second;
+}
+
+HRESULT CRenderDeviceNull::CreateTexture(const D3D11_TEXTURE2D_DESC& Desc, ID3D11Texture2D** const PtrOutTexture, 
+	ID3D11ShaderResourceView** const PtrOutView)
+{
+	if (!PtrOutTexture && !PtrOutView) return S_FALSE;
+
+	// MipLevels 0 is the full chain
+	D3D11_TEXTURE2D_DESC ResolvedDesc{ Desc };
+	if (ResolvedDesc.MipLevels == 0)
+	{
+		for (UINT Size = max(Desc.Width, Desc.Height); Size; Size >>= 1) ++ResolvedDesc.MipLevels;
+	}
+
+	size_t ByteSize{};
+	for (UINT iMip = 0; iMip < ResolvedDesc.MipLevels; ++iMip)
+	{
+		UINT RowPitch{};
+		UINT RowCount{};
+		ByteSize += GetSubresourceByteSize(ResolvedDesc, iMip, RowPitch, RowCount) * ResolvedDesc.ArraySize;
+	}
+
+	ComPtr<ID3D11Texture2D> Texture{};
+	Texture.Attach(new CNullTexture2D(ResolvedDesc));
+	m_umapTextureDescs[Texture.Get()] = ResolvedDesc;
+	m_umapMappedTextureMemory.erase(Texture.Get());
+	m_umapTextureMinLODs.erase(Texture.Get());
+
+	++m_Stats.CreationCount;
+	m_Stats.CreatedByteCount += ByteSize;
+
+	if (PtrOutView && FAILED(CreateShaderResourceView(Texture.Get(), nullptr, PtrOutView))) return E_FAIL;
+	if (PtrOutTexture) *PtrOutTexture = Texture.Detach();
+	return S_OK;
+}
+
+void CRenderDeviceNull::Record(ECommandType eType, EShaderType eShaderType, UINT Slot, const void* const PtrObject,
+	UINT Argument0, UINT Argument1, UINT Argument2, UINT Argument3, UINT Argument4)
+{
+	++m_Stats.CallCount;
+	if (!m_bShouldRecord) return;
+
+	SCommand Command{};
+	Command.eType = eType;
+	Command.eShaderType = eShaderType;
+	Command.Slot = Slot;
+	Command.PtrObject = PtrObject;
+	Command.Arguments[0] = Argument0;
+	Command.Arguments[1] = Argument1;
+	Command.Arguments[2] = Argument2;
+	Command.Arguments[3] = Argument3;
+	Command.Arguments[4] = Argument4;
+	m_vCommands.emplace_back(Command);
+}
+
+void CRenderDeviceNull::Validate(bool bCondition, const char* const Message)
+{
+	if (bCondition) return;
+
+	++m_Stats.ValidationErrorCount;
+	m_LastValidationError = Message;
+}
+
+size_t CRenderDeviceNull::ValidateTextureBox(const ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox,
+	const char* const Message)
+{
+	const D3D11_TEXTURE2D_DESC* const PtrDesc{ GetTextureDesc(PtrTexture) };
+	const bool KbIsSubresourceValid{ PtrDesc != nullptr && Subresource < PtrDesc->MipLevels * PtrDesc->ArraySize };
+	Validate(KbIsSubresourceValid, Message);
+	if (!KbIsSubresourceValid) return 0;
+
+	UINT RowPitch{};
+	UINT RowCount{};
+	const UINT KMip{ Subresource % PtrDesc->MipLevels };
+	const size_t KByteSize{ GetSubresourceByteSize(*PtrDesc, KMip, RowPitch, RowCount) };
+	if (!PtrBox) return KByteSize;
+
+	const UINT KWidth{ max(PtrDesc->Width >> KMip, 1u) };
+	const UINT KHeight{ max(PtrDesc->Height >> KMip, 1u) };
+	const bool KbIsBoxValid{ PtrBox->left < PtrBox->right && PtrBox->top < PtrBox->bottom && PtrBox->right <= KWidth && 
+		PtrBox->bottom <= KHeight && PtrBox->front == 0 && PtrBox->back == 1 };
+	Validate(KbIsBoxValid, Message);
+	if (!KbIsBoxValid) return 0;
+
+	D3D11_TEXTURE2D_DESC BoxDesc{ *PtrDesc };
+	BoxDesc.Width = PtrBox->right - PtrBox->left;
+	BoxDesc.Height = PtrBox->bottom - PtrBox->top;
+	return GetSubresourceByteSize(BoxDesc, 0, RowPitch, RowCount);
+}
+
+void CRenderDeviceNull::ValidateDraw(bool bIsIndexed, UINT VertexCount)
+{
+	Validate(m_PtrVertexShader != nullptr, "draw without a vertex shader");
+	Validate(m_PtrPixelShader != nullptr, "draw without a pixel shader");
+	Validate(m_eTopology != D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED, "draw without a primitive topology");
+	Validate(!bIsIndexed || m_PtrIndexBuffer != nullptr, "indexed draw without an index buffer");
+
+	const bool KbIsPatchList{ m_eTopology == D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST };
+	Validate(KbIsPatchList == (m_PtrHullShader != nullptr && m_PtrDomainShader != nullptr), "tessellation shaders and topology mismatch");
+
+	++m_Stats.DrawCallCount;
+	switch (m_eTopology)
+	{
+	case D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST:
+	case D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST:
+		m_Stats.PrimitiveCount += VertexCount / 3;
+		break;
+	case D3D11_PRIMITIVE_TOPOLOGY_LINELIST:
+		m_Stats.PrimitiveCount += VertexCount / 2;
+		break;
+	default:
+		m_Stats.PrimitiveCount += VertexCount;
+		break;
+	}
+}
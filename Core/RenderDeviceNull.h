@@ -0,0 +1,220 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+// Records and validates the calls instead of issuing them (no GPU needed, for headless tests and benchmarks)
+// Created objects are reference-counted stand-ins that implement the SDK interfaces (GetDesc() etc.) but own no memory for texels
+// @important: other D3D11 objects passed in are only used as handles, so they are never dereferenced
+class CRenderDeviceNull final : public CRenderDevice
+{
+public:
+	enum class ECommandType
+	{
+		SetVertexShader,
+		SetHullShader,
+		SetDomainShader,
+		SetGeometryShader,
+		SetPixelShader,
+		SetInputLayout,
+		SetConstantBuffer,
+		SetShaderResource,
+		SetSamplerState,
+		SetConstantBufferRange,
+		SetRasterizerState,
+		SetDepthStencilState,
+		SetBlendState,
+		SetViewport,
+		SetRenderTarget,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		SetPrimitiveTopology,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		Map,
+		Unmap,
+		UpdateBuffer,
+		CopyBufferRegion,
+		MapTexture,
+		UnmapTexture,
+		UpdateTexture,
+		CopyTextureRegion,
+		GenerateMips,
+		SetResourceMinLOD,
+		SignalFence,
+		Draw,
+		DrawIndexed,
+		DrawIndexedInstanced
+	};
+
+	struct SCommand
+	{
+		ECommandType	eType{};
+		EShaderType		eShaderType{};
+		UINT			Slot{};
+		const void*		PtrObject{};
+		UINT			Arguments[5]{};
+	};
+
+	struct SStats
+	{
+		size_t		CallCount{};
+		size_t		DrawCallCount{};
+		size_t		PrimitiveCount{}; // Including instances
+		size_t		CreationCount{};
+		size_t		CreatedByteCount{}; // Buffers and textures (all mips)
+		size_t		MapCount{};
+		size_t		MappedByteCount{};
+		size_t		UpdatedByteCount{}; // UpdateBuffer() and UpdateTexture()
+		size_t		CopyCount{};
+		size_t		CopiedByteCount{};
+		size_t		ValidationErrorCount{};
+	};
+
+public:
+	CRenderDeviceNull(bool bShouldRecord = true, bool bSupportsConstantBufferRanges = true) :
+		m_bShouldRecord{ bShouldRecord }, m_bSupportsConstantBufferRanges{ bSupportsConstantBufferRanges } {}
+	~CRenderDeviceNull() {}
+
+public:
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData, 
+		ID3D11Buffer** const PtrOutBuffer) override;
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC& Desc, const D3D11_SUBRESOURCE_DATA* const PtrInitialData,
+		ID3D11Texture2D** const PtrOutTexture) override;
+	HRESULT CreateShaderResourceView(ID3D11Resource* const PtrResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* const PtrDesc,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+	HRESULT CreateRenderTargetView(ID3D11Resource* const PtrResource, const D3D11_RENDER_TARGET_VIEW_DESC* const PtrDesc,
+		ID3D11RenderTargetView** const PtrOutView) override;
+	HRESULT CreateDepthStencilView(ID3D11Resource* const PtrResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* const PtrDesc,
+		ID3D11DepthStencilView** const PtrOutView) override;
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC& Desc, ID3D11SamplerState** const PtrOutState) override;
+	HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC& Desc, ID3D11RasterizerState** const PtrOutState) override;
+	HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& Desc, ID3D11DepthStencilState** const PtrOutState) override;
+	HRESULT CreateBlendState(const D3D11_BLEND_DESC& Desc, ID3D11BlendState** const PtrOutState) override;
+	HRESULT CreateVertexShader(const void* const PtrBytecode, size_t ByteSize, ID3D11VertexShader** const PtrOutShader) override;
+	HRESULT CreateHullShader(const void* const PtrBytecode, size_t ByteSize, ID3D11HullShader** const PtrOutShader) override;
+	HRESULT CreateDomainShader(const void* const PtrBytecode, size_t ByteSize, ID3D11DomainShader** const PtrOutShader) override;
+	HRESULT CreateGeometryShader(const void* const PtrBytecode, size_t ByteSize, ID3D11GeometryShader** const PtrOutShader) override;
+	HRESULT CreatePixelShader(const void* const PtrBytecode, size_t ByteSize, ID3D11PixelShader** const PtrOutShader) override;
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* const PtrElementDescs, UINT ElementCount, const void* const PtrBytecode,
+		size_t ByteSize, ID3D11InputLayout** const PtrOutInputLayout) override;
+
+	// Only the header of DDS files is read (other files are decoded for their size), and the texture is R8G8B8A8 unless the DDS says otherwise
+	HRESULT CreateTextureFromFile(const string& FileName, size_t MaxSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+	// The contents aren't decoded, so the texture is a 1 x 1 placeholder
+	HRESULT CreateTextureFromMemory(const uint8_t* const PtrData, size_t ByteSize, ID3D11Texture2D** const PtrOutTexture,
+		ID3D11ShaderResourceView** const PtrOutView) override;
+
+public:
+	void SetVertexShader(ID3D11VertexShader* const PtrShader) override;
+	void SetHullShader(ID3D11HullShader* const PtrShader) override;
+	void SetDomainShader(ID3D11DomainShader* const PtrShader) override;
+	void SetGeometryShader(ID3D11GeometryShader* const PtrShader) override;
+	void SetPixelShader(ID3D11PixelShader* const PtrShader) override;
+	void SetInputLayout(ID3D11InputLayout* const PtrInputLayout) override;
+	void SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer) override;
+	void SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView) override;
+	void SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState) override;
+
+	void SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant, UINT ConstantCount) override;
+	bool SupportsConstantBufferRanges() const override { return m_bSupportsConstantBufferRanges; }
+
+	void SetRasterizerState(ID3D11RasterizerState* const PtrState) override;
+	void SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef) override;
+	void SetBlendState(ID3D11BlendState* const PtrState) override;
+	void SetViewport(const D3D11_VIEWPORT& Viewport) override;
+	void SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView) override;
+
+	void ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4]) override;
+	void ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil) override;
+
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology) override;
+	void SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset) override;
+	void SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset) override;
+
+	// Returns memory owned by the null device (kept per buffer, so the contents can be inspected with GetBufferMemory())
+	void* Map(ID3D11Buffer* const PtrBuffer, D3D11_MAP eMapType, size_t ByteSize) override;
+	void Unmap(ID3D11Buffer* const PtrBuffer) override;
+	void UpdateBuffer(ID3D11Buffer* const PtrBuffer, const void* const PtrData, UINT ByteSize) override;
+	void CopyBufferRegion(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, ID3D11Buffer* const PtrSrcBuffer, UINT SrcOffset, UINT ByteSize) override;
+
+	// Texel contents aren't kept: mapped memory is scratch memory of the null device
+	bool MapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, D3D11_MAP eMapType, D3D11_MAPPED_SUBRESOURCE& OutMapped) override;
+	void UnmapTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource) override;
+	void UpdateTexture(ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, const void* const PtrData,
+		UINT RowPitch) override;
+	void CopyTextureRegion(ID3D11Texture2D* const PtrDstTexture, UINT DstSubresource, UINT DstX, UINT DstY, 
+		ID3D11Texture2D* const PtrSrcTexture, UINT SrcSubresource, const D3D11_BOX* const PtrSrcBox) override;
+	void GenerateMips(ID3D11ShaderResourceView* const PtrView) override;
+	void SetResourceMinLOD(ID3D11Resource* const PtrResource, FLOAT MinLOD) override;
+
+	void SignalFence(uint64_t FenceValue) override;
+	uint64_t GetCompletedFence() override { return m_CompletedFence; }
+
+	void Draw(UINT VertexCount, UINT StartVertexLocation) override;
+	void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) override;
+	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+		UINT StartInstanceLocation) override;
+
+public:
+	// Clears the recorded commands and the stats (the bound state is kept, like the real context's)
+	void Reset();
+
+	const vector<SCommand>& GetCommands() const { return m_vCommands; }
+	const SStats& GetStats() const { return m_Stats; }
+	const string& GetLastValidationError() const { return m_LastValidationError; }
+	const vector<uint8_t>* GetBufferMemory(const ID3D11Buffer* const PtrBuffer) const;
+	// nullptr if the texture wasn't created by this device
+	const D3D11_TEXTURE2D_DESC* GetTextureDesc(const ID3D11Texture2D* const PtrTexture) const;
+	// 0 unless SetResourceMinLOD() was called for the texture
+	FLOAT GetResourceMinLOD(const ID3D11Texture2D* const PtrTexture) const;
+
+	// The number of newer fences that must be signaled before a fence is passed (0: passed immediately)
+	void SetFenceLatency(size_t FenceLatency);
+	// Passes every pending fence, as if the GPU were idle
+	void CompleteFences();
+
+private:
+	void Record(ECommandType eType, EShaderType eShaderType, UINT Slot, const void* const PtrObject,
+		UINT Argument0 = 0, UINT Argument1 = 0, UINT Argument2 = 0, UINT Argument3 = 0, UINT Argument4 = 0);
+	void Validate(bool bCondition, const char* const Message);
+	void ValidateDraw(bool bIsIndexed, UINT VertexCount);
+	// The byte size of the subresource's box (the whole subresource if PtrBox is nullptr), 0 if the texture or the box is invalid
+	size_t ValidateTextureBox(const ID3D11Texture2D* const PtrTexture, UINT Subresource, const D3D11_BOX* const PtrBox, 
+		const char* const Message);
+	HRESULT CreateTexture(const D3D11_TEXTURE2D_DESC& Desc, ID3D11Texture2D** const PtrOutTexture, ID3D11ShaderResourceView** const PtrOutView);
+
+private:
+	struct SBufferMemory
+	{
+		vector<uint8_t>	vData{};
+		bool			bIsMapped{};
+	};
+
+private:
+	bool						m_bShouldRecord{};
+	bool						m_bSupportsConstantBufferRanges{};
+	vector<SCommand>			m_vCommands{};
+	SStats						m_Stats{};
+	string						m_LastValidationError{};
+
+private:
+	const void*					m_PtrVertexShader{};
+	const void*					m_PtrHullShader{};
+	const void*					m_PtrDomainShader{};
+	const void*					m_PtrPixelShader{};
+	const void*					m_PtrIndexBuffer{};
+	D3D11_PRIMITIVE_TOPOLOGY	m_eTopology{ D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED };
+
+private:
+	unordered_map<const ID3D11Buffer*, SBufferMemory>	m_umapBufferMemory{};
+	unordered_map<const ID3D11Texture2D*, D3D11_TEXTURE2D_DESC>	m_umapTextureDescs{};
+	unordered_map<const ID3D11Texture2D*, SBufferMemory>	m_umapMappedTextureMemory{};
+	unordered_map<const ID3D11Texture2D*, FLOAT>			m_umapTextureMinLODs{};
+
+private:
+	size_t						m_FenceLatency{};
+	vector<uint64_t>			m_vPendingFences{};
+	uint64_t					m_LastSignaledFence{};
+	uint64_t					m_CompletedFence{};
+};
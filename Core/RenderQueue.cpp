@@ -0,0 +1,90 @@
+#include "RenderQueue.h"
+
+void CRenderQueue::Clear()
+{
+	m_vPackets.clear();
+}
+
+void CRenderQueue::Add(uint64_t SortKey, uint32_t ItemIndex)
+{
+	SPacket Packet{};
+	Packet.SortKey = SortKey;
+	Packet.ItemIndex = ItemIndex;
+	m_vPackets.emplace_back(Packet);
+}
+
+void CRenderQueue::Sort()
+{
+	if (m_vPackets.size() <= 1) return;
+
+	// Digits that are the same in every key don't change the order
+	uint64_t AndKeys{ UINT64_MAX };
+	uint64_t OrKeys{};
+	for (const SPacket& Packet : m_vPackets)
+	{
+		AndKeys &= Packet.SortKey;
+		OrKeys |= Packet.SortKey;
+	}
+	const uint64_t KVaryingBits{ AndKeys ^ OrKeys };
+
+	m_vSortBuffer.resize(m_vPackets.size());
+	for (uint32_t Shift = 0; Shift < 64; Shift += 8)
+	{
+		if (((KVaryingBits >> Shift) & 0xFF) == 0) continue;
+
+		size_t Offsets[256]{};
+		for (const SPacket& Packet : m_vPackets)
+		{
+			++Offsets[(Packet.SortKey >> Shift) & 0xFF];
+		}
+
+		size_t Sum{};
+		for (size_t& Offset : Offsets)
+		{
+			size_t Count{ Offset };
+			Offset = Sum;
+			Sum += Count;
+		}
+
+		for (const SPacket& Packet : m_vPackets)
+		{
+			m_vSortBuffer[Offsets[(Packet.SortKey >> Shift) & 0xFF]++] = Packet;
+		}
+		m_vPackets.swap(m_vSortBuffer);
+	}
+}
+
+uint64_t CRenderQueue::MakeOpaqueSortKey(uint32_t ShaderID, uint32_t TextureSetID, uint32_t MaterialID, float NormalizedDepth)
+{
+	uint64_t Key{ static_cast<uint64_t>(EPass::Opaque) << KPassShift };
+	Key |= Pack(ShaderID, 12, 50);
+	Key |= Pack(TextureSetID, 16, 34);
+	Key |= Pack(MaterialID, 16, 18);
+	Key |= QuantizeDepth(NormalizedDepth, 18);
+	return Key;
+}
+
+uint64_t CRenderQueue::MakeTransparentSortKey(float NormalizedDepth, uint32_t ShaderID, uint32_t TextureSetID, uint32_t MaterialID)
+{
+	const uint32_t KMaxDepth{ (1u << 24) - 1 };
+
+	uint64_t Key{ static_cast<uint64_t>(EPass::Transparent) << KPassShift };
+	Key |= static_cast<uint64_t>(KMaxDepth - QuantizeDepth(NormalizedDepth, 24)) << 38;
+	Key |= Pack(ShaderID, 12, 26);
+	Key |= Pack(TextureSetID, 13, 13);
+	Key |= Pack(MaterialID, 13, 0);
+	return Key;
+}
+
+uint64_t CRenderQueue::Pack(uint32_t Value, uint32_t BitCount, uint32_t Shift)
+{
+	const uint32_t KMaxValue{ (1u << BitCount) - 1 };
+	return static_cast<uint64_t>(min(Value, KMaxValue)) << Shift;
+}
+
+uint32_t CRenderQueue::QuantizeDepth(float NormalizedDepth, uint32_t BitCount)
+{
+	const uint32_t KMaxValue{ (1u << BitCount) - 1 };
+	float Depth{ max(min(NormalizedDepth, 1.0f), 0.0f) };
+	return static_cast<uint32_t>(Depth * static_cast<float>(KMaxValue));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Draw packets sorted by 64-bit keys (rebuilt and radix-sorted every frame)
+class CRenderQueue final
+{
+public:
+	enum class EPass
+	{
+		Opaque,
+		Transparent
+	};
+
+	struct SPacket
+	{
+		uint64_t	SortKey{};
+		uint32_t	ItemIndex{};
+	};
+
+public:
+	CRenderQueue() {}
+	~CRenderQueue() {}
+
+public:
+	void Clear();
+	void Add(uint64_t SortKey, uint32_t ItemIndex);
+
+	// Stable LSD radix sort (8-bit digits, the digits every key shares are skipped)
+	void Sort();
+
+	const vector<SPacket>& GetPackets() const { return m_vPackets; }
+
+public:
+	// [pass 2][shader 12][texture set 16][material 16][depth 18], front to back
+	// @important: texture sets come before materials because they cost SRV binds while materials only update a constant buffer
+	static uint64_t MakeOpaqueSortKey(uint32_t ShaderID, uint32_t TextureSetID, uint32_t MaterialID, float NormalizedDepth);
+
+	// [pass 2][inverted depth 24][shader 12][texture set 13][material 13], back to front
+	static uint64_t MakeTransparentSortKey(float NormalizedDepth, uint32_t ShaderID, uint32_t TextureSetID, uint32_t MaterialID);
+
+	static EPass GetPass(uint64_t SortKey) { return static_cast<EPass>(SortKey >> KPassShift); }
+
+private:
+	// IDs that don't fit in their fields are clamped, which only costs sorting quality
+	static uint64_t Pack(uint32_t Value, uint32_t BitCount, uint32_t Shift);
+	static uint32_t QuantizeDepth(float NormalizedDepth, uint32_t BitCount);
+
+public:
+	static constexpr uint32_t	KPassShift{ 62 };
+
+private:
+	vector<SPacket>				m_vPackets{};
+	vector<SPacket>				m_vSortBuffer{};
+};
@@ -0,0 +1,96 @@
+#include "RingAllocator.h"
+
+void CRingAllocator::Reset(size_t ByteSize)
+{
+	m_ByteSize = ByteSize;
+
+	Reset();
+}
+
+void CRingAllocator::Reset()
+{
+	m_Head = 0;
+	m_Tail = 0;
+	m_UsedByteSize = 0;
+	m_FrameByteSize = 0;
+	m_vPendingFrames.clear();
+}
+
+bool CRingAllocator::Allocate(size_t ByteSize, size_t Alignment, size_t& OutOffset)
+{
+	assert(Alignment && (Alignment & (Alignment - 1)) == 0);
+
+	if (ByteSize == 0 || ByteSize > m_ByteSize) return false;
+
+	const size_t KAlignedHead{ (m_Head + Alignment - 1) & ~(Alignment - 1) };
+	const bool KbFitsAtHead{ KAlignedHead <= m_ByteSize && ByteSize <= m_ByteSize - KAlignedHead };
+
+	// @important: m_Head == m_Tail means either an empty or a full ring
+	size_t Offset{};
+	if (m_UsedByteSize == 0)
+	{
+		Offset = (KbFitsAtHead) ? KAlignedHead : 0;
+	}
+	else if (m_Head > m_Tail)
+	{
+		// Free: [m_Head, m_ByteSize) and [0, m_Tail)
+		if (KbFitsAtHead)
+		{
+			Offset = KAlignedHead;
+		}
+		else if (ByteSize <= m_Tail)
+		{
+			Offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (m_Head < m_Tail)
+	{
+		// Free: [m_Head, m_Tail)
+		if (KAlignedHead > m_Tail || ByteSize > m_Tail - KAlignedHead) return false;
+		Offset = KAlignedHead;
+	}
+	else
+	{
+		return false;
+	}
+
+	// The padding before the range (or the unused end of the ring) is freed with it
+	const size_t KPaddingByteSize{ (Offset == 0 && m_Head != 0) ? m_ByteSize - m_Head : Offset - m_Head };
+	m_UsedByteSize += KPaddingByteSize + ByteSize;
+	m_FrameByteSize += KPaddingByteSize + ByteSize;
+	m_Head = Offset + ByteSize;
+
+	OutOffset = Offset;
+	return true;
+}
+
+void CRingAllocator::EndFrame(uint64_t FenceValue)
+{
+	assert(m_vPendingFrames.empty() || FenceValue > m_vPendingFrames.back().FenceValue);
+
+	SFrame Frame{};
+	Frame.FenceValue = FenceValue;
+	Frame.EndOffset = m_Head;
+	Frame.ByteSize = m_FrameByteSize;
+	m_vPendingFrames.emplace_back(Frame);
+
+	m_FrameByteSize = 0;
+}
+
+void CRingAllocator::Retire(uint64_t CompletedFenceValue)
+{
+	size_t RetiredFrameCount{};
+	for (const SFrame& Frame : m_vPendingFrames)
+	{
+		if (Frame.FenceValue > CompletedFenceValue) break;
+
+		m_Tail = Frame.EndOffset;
+		m_UsedByteSize -= Frame.ByteSize;
+		++RetiredFrameCount;
+	}
+	m_vPendingFrames.erase(m_vPendingFrames.begin(), m_vPendingFrames.begin() + RetiredFrameCount);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Suballocates byte ranges of a ring buffer frame by frame (CPU only, no device access)
+// The ranges of a frame are freed together once its fence value has been passed by the GPU
+class CRingAllocator final
+{
+	struct SFrame
+	{
+		uint64_t	FenceValue{};
+		size_t		EndOffset{};
+		size_t		ByteSize{}; // Including alignment padding and the unused end of the ring when it wraps
+	};
+
+public:
+	CRingAllocator() {}
+	~CRingAllocator() {}
+
+public:
+	// Frees everything
+	void Reset(size_t ByteSize);
+	void Reset();
+
+	// Alignment must be a power of 2. Returns false if the range would overwrite a range that is still in flight
+	bool Allocate(size_t ByteSize, size_t Alignment, size_t& OutOffset);
+
+	// The ranges allocated since the last call belong to this fence value
+	void EndFrame(uint64_t FenceValue);
+	void Retire(uint64_t CompletedFenceValue);
+
+public:
+	size_t GetByteSize() const { return m_ByteSize; }
+	size_t GetUsedByteSize() const { return m_UsedByteSize; }
+	size_t GetFrameByteSize() const { return m_FrameByteSize; }
+	size_t GetPendingFrameCount() const { return m_vPendingFrames.size(); }
+
+private:
+	size_t			m_ByteSize{};
+	size_t			m_Head{}; // Next allocation
+	size_t			m_Tail{}; // Oldest range in flight
+	size_t			m_UsedByteSize{};
+	size_t			m_FrameByteSize{};
+	vector<SFrame>	m_vPendingFrames{};
+};
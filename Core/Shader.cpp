@@ -1,12 +1,13 @@
 #include "Shader.h"
 
-void CShader::CConstantBuffer::Create(EShaderType ShaderType, const void* const PtrData, size_t DataByteWidth)
+void CShader::CConstantBuffer::Create(EShaderType ShaderType, const void* const PtrData, size_t DataByteWidth, UINT Slot, bool bIsTransient)
 {
 	assert(PtrData);
 
 	m_eShaderType = ShaderType;
 	m_PtrData = PtrData;
 	m_DataByteWidth = DataByteWidth;
+	m_Slot = Slot;
 
 	D3D11_BUFFER_DESC BufferDesc{};
 	BufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
@@ -16,97 +17,236 @@ void CShader::CConstantBuffer::Create(EShaderType ShaderType, const void* const
 	BufferDesc.StructureByteStride = 0;
 	BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 
-	assert(SUCCEEDED(m_PtrDevice->CreateBuffer(&BufferDesc, nullptr, m_ConstantBuffer.GetAddressOf())));
+	// @important: recorded commands write a buffer of their own, so that replaying them never invalidates m_Shadow
+	HRESULT Result{ m_PtrRenderDevice->CreateBuffer(BufferDesc, nullptr, m_RecordingBuffer.ReleaseAndGetAddressOf()) };
+	assert(SUCCEEDED(Result));
+
+	// @important: without constant buffer ranges (D3D11.1) transient data falls back to its own buffer
+	m_bIsTransient = bIsTransient && m_PtrUploader && m_PtrUploader->IsTransientBufferAvailable();
+	if (m_bIsTransient) return;
+
+	Result = m_PtrRenderDevice->CreateBuffer(BufferDesc, nullptr, m_ConstantBuffer.ReleaseAndGetAddressOf());
+	assert(SUCCEEDED(Result));
 }
 
 void CShader::CConstantBuffer::Update()
 {
-	D3D11_MAPPED_SUBRESOURCE MappedSubresource{};
-	if (SUCCEEDED(m_PtrDeviceContext->Map(m_ConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource)))
+	if (m_bIsTransient)
+	{
+		// Binds the new range as well, since the shader is already in use
+		m_PtrUploader->UploadTransient(m_eShaderType, m_Slot, m_PtrData, m_DataByteWidth, m_Transient);
+		return;
+	}
+
+	if (m_PtrUploader)
+	{
+		m_PtrUploader->Upload(m_ConstantBuffer.Get(), m_PtrData, m_DataByteWidth, m_Shadow);
+		return;
+	}
+
+	if (void* const PtrMappedData{ m_PtrRenderDevice->Map(m_ConstantBuffer.Get(), D3D11_MAP_WRITE_DISCARD, m_DataByteWidth) })
+	{
+		memcpy(PtrMappedData, m_PtrData, m_DataByteWidth);
+
+		m_PtrRenderDevice->Unmap(m_ConstantBuffer.Get());
+	}
+}
+
+void CShader::CConstantBuffer::Use(UINT Slot)
+{
+	if (m_bIsTransient)
+	{
+		m_PtrUploader->UseTransient(m_eShaderType, Slot, m_Transient);
+		return;
+	}
+
+	m_PtrRenderDevice->SetConstantBuffer(m_eShaderType, Slot, m_ConstantBuffer.Get());
+}
+
+void CShader::CConstantBuffer::Record(CRenderDevice& Device, CStateTracker& StateTracker, const void* const PtrData) const
+{
+	if (void* const PtrMappedData{ Device.Map(m_RecordingBuffer.Get(), D3D11_MAP_WRITE_DISCARD, m_DataByteWidth) })
 	{
-		memcpy(MappedSubresource.pData, m_PtrData, m_DataByteWidth);
+		memcpy(PtrMappedData, (PtrData) ? PtrData : m_PtrData, m_DataByteWidth);
 
-		m_PtrDeviceContext->Unmap(m_ConstantBuffer.Get(), 0);
+		Device.Unmap(m_RecordingBuffer.Get());
 	}
+
+	StateTracker.SetConstantBuffer(m_eShaderType, m_Slot, m_RecordingBuffer.Get());
 }
 
-void CShader::CConstantBuffer::Use(UINT Slot) const
+void CShader::CConstantBuffer::Use(CStateTracker& StateTracker, UINT Slot)
 {
-	switch (m_eShaderType)
+	if (m_bIsTransient)
+	{
+		m_PtrUploader->UseTransient(m_eShaderType, Slot, m_Transient);
+		return;
+	}
+
+	StateTracker.SetConstantBuffer(m_eShaderType, Slot, m_ConstantBuffer.Get());
+}
+
+void CShader::Create(EShaderType Type, const wstring& FileName, const string& EntryPoint,
+	const D3D11_INPUT_ELEMENT_DESC* InputElementDescs, UINT NumElements)
+{
+	if (InputElementDescs) assert(Type == EShaderType::VertexShader);
+	if (Type == EShaderType::VertexShader) assert(InputElementDescs);
+
+	m_ShaderType = Type;
+	m_PtrPermutationSet = nullptr;
+	m_vVariants.clear();
+	m_vVariants.resize(1);
+	m_VariantIndex = 0;
+
+	CreateVariant(0, MakeCompileDesc(FileName, EntryPoint), InputElementDescs, NumElements);
+}
+
+void CShader::Create(EShaderType Type, const wstring& FileName, const string& EntryPoint, const CShaderPermutationSet& PermutationSet,
+	const D3D11_INPUT_ELEMENT_DESC* InputElementDescs, UINT NumElements)
+{
+	if (InputElementDescs) assert(Type == EShaderType::VertexShader);
+	if (Type == EShaderType::VertexShader) assert(InputElementDescs);
+
+	m_ShaderType = Type;
+	m_PtrPermutationSet = &PermutationSet;
+	m_vVariants.clear();
+	m_vVariants.resize(PermutationSet.GetVariantCount());
+	m_VariantIndex = 0;
+
+	SShaderCompileDesc Desc{ MakeCompileDesc(FileName, EntryPoint) };
+	for (size_t iVariant = 0; iVariant < m_vVariants.size(); ++iVariant)
+	{
+		Desc.vDefines = PermutationSet.GetDefines(PermutationSet.GetVariantKey(iVariant));
+		CreateVariant(iVariant, Desc, InputElementDescs, NumElements);
+	}
+}
+
+void CShader::SetPermutation(uint32_t Key)
+{
+	m_VariantIndex = (m_PtrPermutationSet) ? m_PtrPermutationSet->GetVariantIndex(Key) : 0;
+}
+
+void CShader::SetPermutation(CStateTracker& StateTracker, uint32_t Key)
+{
+	const void* const PtrCurrentShader{ GetVariantShader(m_VariantIndex) };
+	const bool bIsBound{ PtrCurrentShader && StateTracker.GetLastShader(m_ShaderType) == PtrCurrentShader };
+
+	SetPermutation(Key);
+
+	if (bIsBound) UseVariant(StateTracker, m_VariantIndex);
+}
+
+SShaderCompileDesc CShader::MakeCompileDesc(const wstring& FileName, const string& EntryPoint) const
+{
+	SShaderCompileDesc Desc{};
+	Desc.FileName.assign(FileName.begin(), FileName.end());
+	Desc.EntryPoint = EntryPoint;
+	Desc.Flags = CShaderCompilerD3D::KDefaultFlags;
+	switch (m_ShaderType)
 	{
 	case EShaderType::VertexShader:
-		m_PtrDeviceContext->VSSetConstantBuffers(Slot, 1, m_ConstantBuffer.GetAddressOf());
+		Desc.Profile = "vs_4_0";
 		break;
 	case EShaderType::HullShader:
-		m_PtrDeviceContext->HSSetConstantBuffers(Slot, 1, m_ConstantBuffer.GetAddressOf());
+		Desc.Profile = "hs_5_0";
 		break;
 	case EShaderType::DomainShader:
-		m_PtrDeviceContext->DSSetConstantBuffers(Slot, 1, m_ConstantBuffer.GetAddressOf());
+		Desc.Profile = "ds_5_0";
 		break;
 	case EShaderType::GeometryShader:
-		m_PtrDeviceContext->GSSetConstantBuffers(Slot, 1, m_ConstantBuffer.GetAddressOf());
+		Desc.Profile = "gs_4_0";
 		break;
 	case EShaderType::PixelShader:
-		m_PtrDeviceContext->PSSetConstantBuffers(Slot, 1, m_ConstantBuffer.GetAddressOf());
+		Desc.Profile = "ps_4_0";
 		break;
 	default:
 		break;
 	}
+	return Desc;
 }
 
-void CShader::Create(EShaderType Type, const wstring& FileName, const string& EntryPoint,
-	const D3D11_INPUT_ELEMENT_DESC* InputElementDescs, UINT NumElements)
+void CShader::CreateVariant(size_t VariantIndex, const SShaderCompileDesc& Desc, const D3D11_INPUT_ELEMENT_DESC* InputElementDescs,
+	UINT NumElements)
 {
-	if (InputElementDescs) assert(Type == EShaderType::VertexShader);
+	if (m_PtrShaderCache)
+	{
+		m_PtrShaderCache->Request(Desc, [this, VariantIndex, InputElementDescs, NumElements](const vector<uint8_t>& Bytecode)
+			{
+				CreateFromBytecode(VariantIndex, Bytecode, InputElementDescs, NumElements);
+			});
+		return;
+	}
 
-	m_ShaderType = Type;
+#if defined(_WIN32)
+	CShaderCompilerD3D Compiler{};
+	vector<uint8_t> vBytecode{};
+	string Errors{};
+	if (!Compiler.Compile(Desc, vBytecode, Errors))
+	{
+		OutputDebugString((Desc.FileName + " (" + Desc.EntryPoint + ") failed to compile.\n" + Errors).c_str());
+		return;
+	}
+	CreateFromBytecode(VariantIndex, vBytecode, InputElementDescs, NumElements);
+#else
+	// @important: the headless build has no D3D compiler, so shaders are only created through a cache (and its compiler)
+	OutputDebugString((Desc.FileName + " (" + Desc.EntryPoint + ") can't be compiled without a shader cache.\n").c_str());
+#endif
+}
 
+void CShader::CreateFromBytecode(size_t VariantIndex, const vector<uint8_t>& Bytecode, const D3D11_INPUT_ELEMENT_DESC* InputElementDescs,
+	UINT NumElements)
+{
+	SVariant& Variant{ m_vVariants[VariantIndex] };
 	switch (m_ShaderType)
 	{
 	case EShaderType::VertexShader:
-		assert(InputElementDescs);
-
-		D3DCompileFromFile(FileName.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, EntryPoint.c_str(),
-			"vs_4_0", D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &m_Blob, nullptr);
-
-		m_PtrDevice->CreateVertexShader(m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), nullptr, &m_VertexShader);
+		m_PtrRenderDevice->CreateVertexShader(Bytecode.data(), Bytecode.size(), Variant.VertexShader.ReleaseAndGetAddressOf());
 
-		m_PtrDevice->CreateInputLayout(InputElementDescs, NumElements,
-			m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), &m_InputLayout);
+		m_PtrRenderDevice->CreateInputLayout(InputElementDescs, NumElements, Bytecode.data(), Bytecode.size(), 
+			Variant.InputLayout.ReleaseAndGetAddressOf());
 		break;
 	case EShaderType::HullShader:
-		D3DCompileFromFile(FileName.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, EntryPoint.c_str(),
-			"hs_5_0", D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &m_Blob, nullptr);
-
-		m_PtrDevice->CreateHullShader(m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), nullptr, &m_HullShader);
+		m_PtrRenderDevice->CreateHullShader(Bytecode.data(), Bytecode.size(), Variant.HullShader.ReleaseAndGetAddressOf());
 		break;
 	case EShaderType::DomainShader:
-		D3DCompileFromFile(FileName.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, EntryPoint.c_str(),
-			"ds_5_0", D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &m_Blob, nullptr);
-
-		m_PtrDevice->CreateDomainShader(m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), nullptr, &m_DomainShader);
+		m_PtrRenderDevice->CreateDomainShader(Bytecode.data(), Bytecode.size(), Variant.DomainShader.ReleaseAndGetAddressOf());
 		break;
 	case EShaderType::GeometryShader:
-		D3DCompileFromFile(FileName.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, EntryPoint.c_str(),
-			"gs_4_0", D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &m_Blob, nullptr);
-
-		m_PtrDevice->CreateGeometryShader(m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), nullptr, &m_GeometryShader);
+		m_PtrRenderDevice->CreateGeometryShader(Bytecode.data(), Bytecode.size(), Variant.GeometryShader.ReleaseAndGetAddressOf());
 		break;
 	case EShaderType::PixelShader:
-		D3DCompileFromFile(FileName.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, EntryPoint.c_str(),
-			"ps_4_0", D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &m_Blob, nullptr);
-
-		m_PtrDevice->CreatePixelShader(m_Blob->GetBufferPointer(), m_Blob->GetBufferSize(), nullptr, &m_PixelShader);
+		m_PtrRenderDevice->CreatePixelShader(Bytecode.data(), Bytecode.size(), Variant.PixelShader.ReleaseAndGetAddressOf());
 		break;
 	default:
 		break;
 	}
 }
 
-void CShader::AddConstantBuffer(const void* const PtrData, size_t DataByteWidth)
+const void* CShader::GetVariantShader(size_t VariantIndex) const
 {
-	m_vConstantBuffers.emplace_back(make_unique<CConstantBuffer>(m_PtrDevice, m_PtrDeviceContext));
-	m_vConstantBuffers.back()->Create(m_ShaderType, PtrData, DataByteWidth);
+	const SVariant& Variant{ m_vVariants[VariantIndex] };
+	switch (m_ShaderType)
+	{
+	case EShaderType::VertexShader:
+		return Variant.VertexShader.Get();
+	case EShaderType::HullShader:
+		return Variant.HullShader.Get();
+	case EShaderType::DomainShader:
+		return Variant.DomainShader.Get();
+	case EShaderType::GeometryShader:
+		return Variant.GeometryShader.Get();
+	case EShaderType::PixelShader:
+		return Variant.PixelShader.Get();
+	default:
+		return nullptr;
+	}
+}
+
+void CShader::AddConstantBuffer(const void* const PtrData, size_t DataByteWidth, bool bIsTransient)
+{
+	UINT Slot{ static_cast<UINT>(m_vConstantBuffers.size()) };
+	m_vConstantBuffers.emplace_back(make_unique<CConstantBuffer>(m_PtrRenderDevice, m_PtrUploader));
+	m_vConstantBuffers.back()->Create(m_ShaderType, PtrData, DataByteWidth, Slot, bIsTransient);
 }
 
 void CShader::UpdateConstantBuffer(size_t ConstantBufferIndex)
@@ -126,23 +266,30 @@ void CShader::UpdateAllConstantBuffers()
 
 void CShader::Use()
 {
+	if (m_PtrUploader)
+	{
+		Use(m_PtrUploader->GetStateTracker());
+		return;
+	}
+
+	const SVariant& Variant{ m_vVariants[m_VariantIndex] };
 	switch (m_ShaderType)
 	{
 	case EShaderType::VertexShader:
-		m_PtrDeviceContext->VSSetShader(m_VertexShader.Get(), nullptr, 0);
-		m_PtrDeviceContext->IASetInputLayout(m_InputLayout.Get());
+		m_PtrRenderDevice->SetVertexShader(Variant.VertexShader.Get());
+		m_PtrRenderDevice->SetInputLayout(Variant.InputLayout.Get());
 		break;
 	case EShaderType::HullShader:
-		m_PtrDeviceContext->HSSetShader(m_HullShader.Get(), nullptr, 0);
+		m_PtrRenderDevice->SetHullShader(Variant.HullShader.Get());
 		break;
 	case EShaderType::DomainShader:
-		m_PtrDeviceContext->DSSetShader(m_DomainShader.Get(), nullptr, 0);
+		m_PtrRenderDevice->SetDomainShader(Variant.DomainShader.Get());
 		break;
 	case EShaderType::GeometryShader:
-		m_PtrDeviceContext->GSSetShader(m_GeometryShader.Get(), nullptr, 0);
+		m_PtrRenderDevice->SetGeometryShader(Variant.GeometryShader.Get());
 		break;
 	case EShaderType::PixelShader:
-		m_PtrDeviceContext->PSSetShader(m_PixelShader.Get(), nullptr, 0);
+		m_PtrRenderDevice->SetPixelShader(Variant.PixelShader.Get());
 		break;
 	default:
 		break;
@@ -152,4 +299,61 @@ void CShader::Use()
 	{
 		m_vConstantBuffers[iCB]->Use(static_cast<UINT>(iCB));
 	}
-}
\ No newline at end of file
+}
+
+void CShader::Use(CStateTracker& StateTracker)
+{
+	UseVariant(StateTracker, m_VariantIndex);
+
+	for (size_t iCB = 0; iCB < m_vConstantBuffers.size(); ++iCB)
+	{
+		m_vConstantBuffers[iCB]->Use(StateTracker, static_cast<UINT>(iCB));
+	}
+}
+
+void CShader::Record(CStateTracker& StateTracker, uint32_t PermutationKey) const
+{
+	UseVariant(StateTracker, (m_PtrPermutationSet) ? m_PtrPermutationSet->GetVariantIndex(PermutationKey) : 0);
+}
+
+void CShader::RecordConstantBuffer(CRenderDevice& Device, CStateTracker& StateTracker, size_t ConstantBufferIndex, 
+	const void* const PtrData) const
+{
+	if (ConstantBufferIndex >= m_vConstantBuffers.size()) return;
+
+	m_vConstantBuffers[ConstantBufferIndex]->Record(Device, StateTracker, PtrData);
+}
+
+void CShader::RecordAllConstantBuffers(CRenderDevice& Device, CStateTracker& StateTracker) const
+{
+	for (const auto& CB : m_vConstantBuffers)
+	{
+		CB->Record(Device, StateTracker, nullptr);
+	}
+}
+
+void CShader::UseVariant(CStateTracker& StateTracker, size_t VariantIndex) const
+{
+	const SVariant& Variant{ m_vVariants[VariantIndex] };
+	switch (m_ShaderType)
+	{
+	case EShaderType::VertexShader:
+		StateTracker.SetVertexShader(Variant.VertexShader.Get());
+		StateTracker.SetInputLayout(Variant.InputLayout.Get());
+		break;
+	case EShaderType::HullShader:
+		StateTracker.SetHullShader(Variant.HullShader.Get());
+		break;
+	case EShaderType::DomainShader:
+		StateTracker.SetDomainShader(Variant.DomainShader.Get());
+		break;
+	case EShaderType::GeometryShader:
+		StateTracker.SetGeometryShader(Variant.GeometryShader.Get());
+		break;
+	case EShaderType::PixelShader:
+		StateTracker.SetPixelShader(Variant.PixelShader.Get());
+		break;
+	default:
+		break;
+	}
+}
@@ -1,72 +1,119 @@
 #pragma once
 
-#include <d3dcompiler.h>
-#include "SharedHeader.h"
-
-#pragma comment(lib, "d3dcompiler.lib")
+#include "ConstantBufferUploader.h"
+#include "ShaderCompilerD3D.h"
+#include "ShaderCache.h"
+#include "ShaderPermutationSet.h"
+#include "RenderDevice.h"
 
 class CShader final
 {
 	class CConstantBuffer
 	{
 	public:
-		CConstantBuffer(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-			m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+		CConstantBuffer(CRenderDevice* const PtrRenderDevice, CConstantBufferUploader* const PtrUploader) :
+			m_PtrRenderDevice{ PtrRenderDevice }, m_PtrUploader{ PtrUploader }
 		{
-			assert(m_PtrDevice);
-			assert(m_PtrDeviceContext);
+			assert(m_PtrRenderDevice);
 		}
 		~CConstantBuffer() {}
 
 	public:
-		void Create(EShaderType ShaderType, const void* const PtrData, size_t DataByteWidth);
+		// bIsTransient: per-draw data, suballocated from the uploader's transient buffer when it is available
+		void Create(EShaderType ShaderType, const void* const PtrData, size_t DataByteWidth, UINT Slot, bool bIsTransient);
 		void Update();
-		void Use(UINT Slot) const;
+		void Use(UINT Slot);
+		void Use(CStateTracker& StateTracker, UINT Slot);
+
+		// Writes PtrData (the registered data if it's nullptr) to the buffer through Device and binds it, touching no other member
+		void Record(CRenderDevice& Device, CStateTracker& StateTracker, const void* const PtrData) const;
 
 	private:
-		ID3D11Device* const			m_PtrDevice{};
-		ID3D11DeviceContext* const	m_PtrDeviceContext{};
+		CRenderDevice* const			m_PtrRenderDevice{};
+		CConstantBufferUploader* const	m_PtrUploader{};
 
 	private:
-		ComPtr<ID3D11Buffer>		m_ConstantBuffer{};
+		ComPtr<ID3D11Buffer>			m_ConstantBuffer{};
+		ComPtr<ID3D11Buffer>			m_RecordingBuffer{}; // Written by Record() only
+
+		EShaderType						m_eShaderType{};
+		size_t							m_DataByteWidth{};
+		const void*						m_PtrData{};
+		UINT							m_Slot{};
+		bool							m_bIsTransient{};
+		SConstantBufferShadow			m_Shadow{};
+		STransientConstantBuffer		m_Transient{};
+	};
 
-		EShaderType					m_eShaderType{};
-		size_t						m_DataByteWidth{};
-		const void*					m_PtrData{};
+	struct SVariant
+	{
+		ComPtr<ID3D11VertexShader>		VertexShader{};
+		ComPtr<ID3D11HullShader>		HullShader{};
+		ComPtr<ID3D11DomainShader>		DomainShader{};
+		ComPtr<ID3D11GeometryShader>	GeometryShader{};
+		ComPtr<ID3D11PixelShader>		PixelShader{};
+
+		ComPtr<ID3D11InputLayout>		InputLayout{};
 	};
 
 public:
-	CShader(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext) :
-		m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }
+	// PtrUploader: constant buffers are uploaded only when they change (always uploaded if it's nullptr),
+	// and Use() binds through the uploader's state tracker
+	// PtrShaderCache: bytecode is loaded from the cache (compiled every time if it's nullptr, which needs the D3D compiler)
+	CShader(CRenderDevice* const PtrRenderDevice, CConstantBufferUploader* const PtrUploader = nullptr, CShaderCache* const PtrShaderCache = nullptr) :
+		m_PtrRenderDevice{ PtrRenderDevice }, m_PtrUploader{ PtrUploader }, m_PtrShaderCache{ PtrShaderCache }
 	{
-		assert(m_PtrDevice); 
-		assert(m_PtrDeviceContext); 
+		assert(m_PtrRenderDevice); 
 	}
 	~CShader() {}
 
+	// @important: if the cache is batching, the shader is created by CShaderCache::EndBatch(), so InputElementDescs must outlive it
 	void Create(EShaderType Type, const wstring& FileName, const string& EntryPoint, 
 		const D3D11_INPUT_ELEMENT_DESC* InputElementDescs = nullptr, UINT NumElements = 0);
 
-	void AddConstantBuffer(const void* const PtrData, size_t DataByteWidth);
+	// Creates every variant of PermutationSet (which must outlive the shader); SetPermutation() selects the one Use() binds
+	void Create(EShaderType Type, const wstring& FileName, const string& EntryPoint, const CShaderPermutationSet& PermutationSet,
+		const D3D11_INPUT_ELEMENT_DESC* InputElementDescs = nullptr, UINT NumElements = 0);
+
+	void SetPermutation(uint32_t Key);
+	// Also binds the new variant if the current one is what StateTracker bound last (to switch variants between draws)
+	void SetPermutation(CStateTracker& StateTracker, uint32_t Key);
+	size_t GetVariantCount() const { return m_vVariants.size(); }
+
+	void AddConstantBuffer(const void* const PtrData, size_t DataByteWidth, bool bIsTransient = false);
 	void UpdateConstantBuffer(size_t ConstantBufferIndex);
 	void UpdateAllConstantBuffers();
 
 	void Use();
+	void Use(CStateTracker& StateTracker);
 
-private:
-	ID3D11Device* const					m_PtrDevice{};
-	ID3D11DeviceContext* const			m_PtrDeviceContext{};
+	// For CCommandRecorder jobs, which may run on any thread: nothing in the shader changes, so jobs can share it
+	// Record() binds the variant of PermutationKey, RecordConstantBuffer() writes PtrData (the registered data if it's nullptr) through
+	// Device (the job's command buffer) and binds it
+	// @important: constant buffers are written to buffers kept for recording (the transient buffer can't be suballocated while recording)
+	void Record(CStateTracker& StateTracker, uint32_t PermutationKey = 0) const;
+	void RecordConstantBuffer(CRenderDevice& Device, CStateTracker& StateTracker, size_t ConstantBufferIndex, 
+		const void* const PtrData = nullptr) const;
+	void RecordAllConstantBuffers(CRenderDevice& Device, CStateTracker& StateTracker) const;
 
 private:
-	ComPtr<ID3DBlob>					m_Blob{};
+	void CreateVariant(size_t VariantIndex, const SShaderCompileDesc& Desc, const D3D11_INPUT_ELEMENT_DESC* InputElementDescs, UINT NumElements);
+	void CreateFromBytecode(size_t VariantIndex, const vector<uint8_t>& Bytecode, const D3D11_INPUT_ELEMENT_DESC* InputElementDescs,
+		UINT NumElements);
+	SShaderCompileDesc MakeCompileDesc(const wstring& FileName, const string& EntryPoint) const;
 
-	ComPtr<ID3D11VertexShader>			m_VertexShader{};
-	ComPtr<ID3D11HullShader>			m_HullShader{};
-	ComPtr<ID3D11DomainShader>			m_DomainShader{};
-	ComPtr<ID3D11GeometryShader>		m_GeometryShader{};
-	ComPtr<ID3D11PixelShader>			m_PixelShader{};
+	void UseVariant(CStateTracker& StateTracker, size_t VariantIndex) const;
+	const void* GetVariantShader(size_t VariantIndex) const;
 
-	ComPtr<ID3D11InputLayout>			m_InputLayout{};
+private:
+	CRenderDevice* const				m_PtrRenderDevice{};
+	CConstantBufferUploader* const		m_PtrUploader{};
+	CShaderCache* const					m_PtrShaderCache{};
+
+private:
+	vector<SVariant>					m_vVariants{ SVariant() };
+	const CShaderPermutationSet*		m_PtrPermutationSet{}; // nullptr: a single variant
+	size_t								m_VariantIndex{};
 
 	EShaderType							m_ShaderType{};
 
@@ -0,0 +1,292 @@
+#include "ShaderCache.h"
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+static constexpr uint32_t KShaderCacheMagic{ 0x43434853 }; // "SHCC"
+static constexpr uint64_t KFNVOffsetBasis{ 0xCBF29CE484222325 };
+static constexpr uint64_t KFNVPrime{ 0x100000001B3 };
+
+static void HashBytes(uint64_t& Hash, const void* const PtrData, size_t ByteSize)
+{
+	const uint8_t* const PtrBytes{ static_cast<const uint8_t*>(PtrData) };
+	for (size_t iByte = 0; iByte < ByteSize; ++iByte)
+	{
+		Hash ^= PtrBytes[iByte];
+		Hash *= KFNVPrime;
+	}
+}
+
+// The size goes first, so that ("ab", "c") and ("a", "bc") don't hash the same
+static void HashString(uint64_t& Hash, const string& String)
+{
+	uint64_t Size{ String.size() };
+	HashBytes(Hash, &Size, sizeof(Size));
+	HashBytes(Hash, String.data(), String.size());
+}
+
+static string GetDirectoryName(const string& FileName)
+{
+	size_t Found{ FileName.find_last_of("\\/") };
+	if (Found == string::npos) return string();
+	return FileName.substr(0, Found + 1);
+}
+
+CShaderCache::CShaderCache(CShaderCompiler* const PtrCompiler, const string& Directory) :
+	m_PtrCompiler{ PtrCompiler }, m_Directory{ Directory }
+{
+	assert(m_PtrCompiler);
+
+	// Fails if the directory exists already, which is fine
+	if (m_Directory.size()) CreateDirectoryA(m_Directory.c_str(), nullptr);
+}
+
+void CShaderCache::Request(const SShaderCompileDesc& Desc, const std::function<void(const vector<uint8_t>&)>& OnBytecode)
+{
+	m_vRequests.emplace_back();
+	m_vRequests.back().Desc = Desc;
+	m_vRequests.back().OnBytecode = OnBytecode;
+
+	if (!m_bIsBatching) ResolveRequests(1);
+}
+
+void CShaderCache::BeginBatch()
+{
+	assert(!m_bIsBatching);
+
+	m_bIsBatching = true;
+}
+
+void CShaderCache::EndBatch(uint32_t ThreadCount)
+{
+	assert(m_bIsBatching);
+
+	m_bIsBatching = false;
+	ResolveRequests(ThreadCount);
+}
+
+uint64_t CShaderCache::CalculateKey(const SShaderCompileDesc& Desc)
+{
+	uint64_t Key{ HashDesc(Desc) };
+	m_umapSourceFiles.clear();
+	return Key;
+}
+
+uint64_t CShaderCache::HashDesc(const SShaderCompileDesc& Desc)
+{
+	if (!ReadSourceFile(Desc.FileName)) return 0;
+
+	uint64_t Hash{ KFNVOffsetBasis };
+	uint32_t Version{ KVersion };
+	HashBytes(Hash, &Version, sizeof(Version));
+
+	vector<string> vVisitedFileNames{};
+	HashSourceFile(Desc.FileName, Hash, vVisitedFileNames);
+
+	HashString(Hash, Desc.EntryPoint);
+	HashString(Hash, Desc.Profile);
+	for (const SShaderDefine& Define : Desc.vDefines)
+	{
+		HashString(Hash, Define.Name);
+		HashString(Hash, Define.Value);
+	}
+	HashBytes(Hash, &Desc.Flags, sizeof(Desc.Flags));
+
+	// 0 means "not cached"
+	return (Hash == 0) ? 1 : Hash;
+}
+
+string CShaderCache::GetCacheFileName(uint64_t Key) const
+{
+	char KeyString[17]{};
+	sprintf_s(KeyString, "%016llX", static_cast<unsigned long long>(Key));
+
+	if (m_Directory.empty()) return string(KeyString) + ".cso";
+	return m_Directory + "/" + KeyString + ".cso";
+}
+
+void CShaderCache::ResolveRequests(uint32_t ThreadCount)
+{
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	// Keys and cache files are read serially, since the source files are shared between requests
+	// Requests that share a key are compiled once, by the first of them (vMisses)
+	vector<size_t> vMisses{};
+	unordered_map<uint64_t, size_t> umapKeyToFirstRequest{};
+	for (size_t iRequest = 0; iRequest < m_vRequests.size(); ++iRequest)
+	{
+		SRequest& Request{ m_vRequests[iRequest] };
+		Request.Key = HashDesc(Request.Desc);
+
+		if (Request.Key)
+		{
+			if (umapKeyToFirstRequest.find(Request.Key) != umapKeyToFirstRequest.end()) continue;
+			umapKeyToFirstRequest[Request.Key] = iRequest;
+
+			if (ReadCacheFile(Request.Key, Request.vBytecode))
+			{
+				Request.bIsReady = true;
+				++m_Stats.HitCount;
+				continue;
+			}
+		}
+		vMisses.emplace_back(iRequest);
+	}
+	m_umapSourceFiles.clear();
+
+	std::atomic<size_t> NextMiss{};
+	auto CompileMisses{ [&]()
+	{
+		string Errors{};
+		for (size_t iMiss = NextMiss++; iMiss < vMisses.size(); iMiss = NextMiss++)
+		{
+			SRequest& Request{ m_vRequests[vMisses[iMiss]] };
+			Request.bIsReady = m_PtrCompiler->Compile(Request.Desc, Request.vBytecode, Errors);
+			if (!Request.bIsReady)
+			{
+				OutputDebugString((Request.Desc.FileName + " (" + Request.Desc.EntryPoint + ") failed to compile.\n" + Errors).c_str());
+				continue;
+			}
+			if (Request.Key) WriteCacheFile(Request.Key, Request.vBytecode);
+		}
+	} };
+
+	if (ThreadCount == 0) ThreadCount = std::thread::hardware_concurrency();
+	ThreadCount = static_cast<uint32_t>(min(static_cast<size_t>(max(ThreadCount, (uint32_t)1)), max(vMisses.size(), (size_t)1)));
+	vector<std::thread> vThreads{};
+	for (uint32_t iThread = 1; iThread < ThreadCount; ++iThread)
+	{
+		vThreads.emplace_back(CompileMisses);
+	}
+	CompileMisses();
+
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+
+	// Callbacks create device objects, so they run in request order on this thread
+	for (SRequest& Request : m_vRequests)
+	{
+		const SRequest* const PtrSource{ (Request.Key) ? &m_vRequests[umapKeyToFirstRequest[Request.Key]] : &Request };
+		if (PtrSource == &Request && !Request.bIsReady) ++m_Stats.FailureCount;
+
+		if (PtrSource->bIsReady && Request.OnBytecode) Request.OnBytecode(PtrSource->vBytecode);
+	}
+
+	m_Stats.RequestCount += m_vRequests.size();
+	m_Stats.MissCount += vMisses.size();
+	m_Stats.ThreadCount = ThreadCount;
+	m_Stats.ElapsedMilliseconds += GetTickCount64() - StartTimePoint;
+
+	m_vRequests.clear();
+}
+
+void CShaderCache::HashSourceFile(const string& FileName, uint64_t& Hash, vector<string>& vVisitedFileNames)
+{
+	// Each file is hashed once, which also cuts include cycles
+	if (std::find(vVisitedFileNames.begin(), vVisitedFileNames.end(), FileName) != vVisitedFileNames.end()) return;
+	vVisitedFileNames.emplace_back(FileName);
+
+	// A missing include only hashes its name; the compiler reports the error
+	HashString(Hash, FileName);
+	const string* const PtrSource{ ReadSourceFile(FileName) };
+	if (!PtrSource)
+	{
+		HashString(Hash, "<missing>");
+		return;
+	}
+	HashString(Hash, *PtrSource);
+
+	// #include "File" and #include <File>, relative to the including file (as D3D_COMPILE_STANDARD_FILE_INCLUDE does)
+	const string& Source{ *PtrSource };
+	const string KDirectory{ GetDirectoryName(FileName) };
+	size_t Found{ Source.find("#include") };
+	while (Found != string::npos)
+	{
+		size_t Begin{ Source.find_first_of("\"<\n", Found + 8) };
+		if (Begin != string::npos && Source[Begin] != '\n')
+		{
+			const char KClosing{ (Source[Begin] == '"') ? '"' : '>' };
+			size_t End{ Source.find_first_of(string(1, KClosing) + "\n", Begin + 1) };
+			if (End != string::npos && Source[End] == KClosing)
+			{
+				HashSourceFile(KDirectory + Source.substr(Begin + 1, End - Begin - 1), Hash, vVisitedFileNames);
+			}
+		}
+		Found = Source.find("#include", Found + 8);
+	}
+}
+
+const string* CShaderCache::ReadSourceFile(const string& FileName)
+{
+	auto Found{ m_umapSourceFiles.find(FileName) };
+	if (Found != m_umapSourceFiles.end()) return &Found->second;
+
+	// The engine names shaders with '\\' separators, which only Windows resolves ('/' works everywhere)
+	string Path{ FileName };
+	std::replace(Path.begin(), Path.end(), '\\', '/');
+
+	std::ifstream ifs{};
+	ifs.open(Path, std::ifstream::binary);
+	if (!ifs.is_open()) return nullptr;
+
+	std::stringstream Stream{};
+	Stream << ifs.rdbuf();
+	return &(m_umapSourceFiles[FileName] = Stream.str());
+}
+
+bool CShaderCache::ReadCacheFile(uint64_t Key, vector<uint8_t>& OutBytecode) const
+{
+	if (m_Directory.empty()) return false;
+
+	std::ifstream ifs{};
+	ifs.open(GetCacheFileName(Key), std::ifstream::binary);
+	if (!ifs.is_open()) return false;
+
+	uint32_t Magic{};
+	uint32_t Version{};
+	uint64_t FileKey{};
+	uint64_t ByteSize{};
+	uint64_t BytecodeHash{};
+	ifs.read((char*)&Magic, sizeof(Magic));
+	ifs.read((char*)&Version, sizeof(Version));
+	ifs.read((char*)&FileKey, sizeof(FileKey));
+	ifs.read((char*)&ByteSize, sizeof(ByteSize));
+	ifs.read((char*)&BytecodeHash, sizeof(BytecodeHash));
+	if (!ifs.good() || Magic != KShaderCacheMagic || Version != KVersion || FileKey != Key || ByteSize == 0) return false;
+
+	OutBytecode.resize(static_cast<size_t>(ByteSize));
+	ifs.read((char*)OutBytecode.data(), OutBytecode.size());
+	if (ifs.gcount() != static_cast<std::streamsize>(ByteSize)) return false;
+
+	// A truncated or damaged file is compiled again (and overwritten)
+	uint64_t Hash{ KFNVOffsetBasis };
+	HashBytes(Hash, OutBytecode.data(), OutBytecode.size());
+	return (Hash == BytecodeHash);
+}
+
+bool CShaderCache::WriteCacheFile(uint64_t Key, const vector<uint8_t>& Bytecode) const
+{
+	if (m_Directory.empty()) return false;
+
+	std::ofstream ofs{};
+	ofs.open(GetCacheFileName(Key), std::ofstream::binary);
+	if (!ofs.is_open()) return false;
+
+	uint32_t Version{ KVersion };
+	uint64_t ByteSize{ Bytecode.size() };
+	uint64_t BytecodeHash{ KFNVOffsetBasis };
+	HashBytes(BytecodeHash, Bytecode.data(), Bytecode.size());
+	ofs.write((const char*)&KShaderCacheMagic, sizeof(KShaderCacheMagic));
+	ofs.write((const char*)&Version, sizeof(Version));
+	ofs.write((const char*)&Key, sizeof(Key));
+	ofs.write((const char*)&ByteSize, sizeof(ByteSize));
+	ofs.write((const char*)&BytecodeHash, sizeof(BytecodeHash));
+	ofs.write((const char*)Bytecode.data(), Bytecode.size());
+
+	bool bSucceeded{ ofs.good() };
+	ofs.close();
+	return bSucceeded;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+#include <functional>
+
+// ###########################
+// << SHADER CACHE FILE (<Directory>/<Key>.cso) >>
+// 4B "SHCC" magic
+// 4B (uint32_t) Version
+// 8B (uint64_t) Key
+// 8B (uint64_t) Bytecode byte size
+// 8B (uint64_t) Bytecode hash
+// # Bytecode
+// ###########################
+
+// Stores compiled bytecode keyed by a hash of the source file, every file it #includes (transitively), the entry point, the profile,
+// the defines and the flags, so that changing any of them compiles the shader again (stale files are left behind, but never read)
+// Requests made between BeginBatch() and EndBatch() are loaded and compiled in parallel
+// An empty directory disables the files (every request is compiled)
+class CShaderCache final
+{
+	struct SRequest
+	{
+		SShaderCompileDesc								Desc{};
+		std::function<void(const vector<uint8_t>&)>		OnBytecode{};
+		uint64_t										Key{};
+		vector<uint8_t>									vBytecode{};
+		bool											bIsReady{};
+	};
+
+public:
+	struct SStats
+	{
+		size_t		RequestCount{};
+		size_t		HitCount{}; // Loaded from the cache directory
+		size_t		MissCount{}; // Compiled (requests that share a key are compiled once)
+		size_t		FailureCount{};
+		uint32_t	ThreadCount{}; // Of the last batch
+		ULONGLONG	ElapsedMilliseconds{}; // In total
+	};
+
+public:
+	CShaderCache(CShaderCompiler* const PtrCompiler, const string& Directory);
+	~CShaderCache() {}
+
+public:
+	// OnBytecode is called with the bytecode, and not called at all if the shader fails to compile
+	// Outside of a batch it is called before Request() returns, otherwise by EndBatch() (in request order, on the calling thread)
+	void Request(const SShaderCompileDesc& Desc, const std::function<void(const vector<uint8_t>&)>& OnBytecode);
+
+	void BeginBatch();
+	// ThreadCount 0: std::thread::hardware_concurrency()
+	void EndBatch(uint32_t ThreadCount = 0);
+
+	// Returns 0 if the source file can't be read (such shaders are compiled but never cached)
+	uint64_t CalculateKey(const SShaderCompileDesc& Desc);
+	string GetCacheFileName(uint64_t Key) const;
+
+	bool IsBatching() const { return m_bIsBatching; }
+	const SStats& GetStats() const { return m_Stats; }
+
+private:
+	void ResolveRequests(uint32_t ThreadCount);
+	// Source files are read once until m_umapSourceFiles is cleared
+	uint64_t HashDesc(const SShaderCompileDesc& Desc);
+	void HashSourceFile(const string& FileName, uint64_t& Hash, vector<string>& vVisitedFileNames);
+	const string* ReadSourceFile(const string& FileName);
+
+	bool ReadCacheFile(uint64_t Key, vector<uint8_t>& OutBytecode) const;
+	bool WriteCacheFile(uint64_t Key, const vector<uint8_t>& Bytecode) const;
+
+public:
+	static constexpr uint32_t	KVersion{ 1 }; // Bump to invalidate every cached file
+
+private:
+	CShaderCompiler* const				m_PtrCompiler{};
+	string								m_Directory{};
+	bool								m_bIsBatching{};
+	vector<SRequest>					m_vRequests{};
+	SStats								m_Stats{};
+
+private:
+	// Cleared once the requests are resolved, so files edited in between are read again
+	unordered_map<string, string>		m_umapSourceFiles{};
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+struct SShaderDefine
+{
+	string	Name{};
+	string	Value{};
+};
+
+struct SShaderCompileDesc
+{
+	string					FileName{};
+	string					EntryPoint{};
+	string					Profile{}; // e.g. "vs_4_0"
+	vector<SShaderDefine>	vDefines{};
+	UINT					Flags{}; // D3DCOMPILE_*
+};
+
+// Compiles HLSL files to bytecode (abstracted so that the shader cache can be tested without the D3D compiler)
+// @important: Compile() is called from multiple threads at once
+class CShaderCompiler
+{
+public:
+	CShaderCompiler() {}
+	virtual ~CShaderCompiler() {}
+
+public:
+	// #includes are resolved relative to the including file
+	virtual bool Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors) = 0;
+};
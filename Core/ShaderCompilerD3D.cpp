@@ -0,0 +1,25 @@
+#include "ShaderCompilerD3D.h"
+
+bool CShaderCompilerD3D::Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors)
+{
+	vector<D3D_SHADER_MACRO> vMacros{};
+	for (const SShaderDefine& Define : Desc.vDefines)
+	{
+		vMacros.push_back({ Define.Name.c_str(), Define.Value.c_str() });
+	}
+	vMacros.push_back({ nullptr, nullptr });
+
+	const wstring KFileName{ Desc.FileName.begin(), Desc.FileName.end() };
+	ComPtr<ID3DBlob> Blob{};
+	ComPtr<ID3DBlob> ErrorBlob{};
+	HRESULT Result{ D3DCompileFromFile(KFileName.c_str(), vMacros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, Desc.EntryPoint.c_str(),
+		Desc.Profile.c_str(), Desc.Flags, 0, Blob.GetAddressOf(), ErrorBlob.GetAddressOf()) };
+
+	OutErrors.clear();
+	if (ErrorBlob) OutErrors.assign(static_cast<const char*>(ErrorBlob->GetBufferPointer()), ErrorBlob->GetBufferSize());
+	if (FAILED(Result) || !Blob) return false;
+
+	const uint8_t* const PtrBytecode{ static_cast<const uint8_t*>(Blob->GetBufferPointer()) };
+	OutBytecode.assign(PtrBytecode, PtrBytecode + Blob->GetBufferSize());
+	return true;
+}
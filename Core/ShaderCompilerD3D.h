@@ -0,0 +1,24 @@
+#pragma once
+
+#include <d3dcompiler.h>
+#include "ShaderCompiler.h"
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+class CShaderCompilerD3D final : public CShaderCompiler
+{
+public:
+	CShaderCompilerD3D() {}
+	~CShaderCompilerD3D() {}
+
+public:
+	bool Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors) override;
+
+public:
+	// Release builds ship optimized bytecode; debug builds keep it debuggable (the flags are part of the cache key)
+#if defined(_DEBUG)
+	static constexpr UINT KDefaultFlags{ D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION };
+#else
+	static constexpr UINT KDefaultFlags{ D3DCOMPILE_OPTIMIZATION_LEVEL3 };
+#endif
+};
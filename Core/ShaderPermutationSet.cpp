@@ -0,0 +1,73 @@
+#include "ShaderPermutationSet.h"
+
+void CShaderPermutationSet::AddFeature(uint32_t Bit, const string& Define, uint32_t RequiredBits)
+{
+	assert(Bit && (Bit & (Bit - 1)) == 0);
+	assert(Bit < (1u << KMaxFeatureCount));
+	assert((m_FeatureMask & Bit) == 0);
+	assert((m_FeatureMask & RequiredBits) == RequiredBits);
+
+	m_vFeatures.push_back({ Bit, Define, RequiredBits });
+	m_FeatureMask |= Bit;
+
+	BuildVariants();
+}
+
+void CShaderPermutationSet::AddConstant(const string& Define, const string& Value)
+{
+	assert(!Define.empty() && !Value.empty());
+
+	m_vConstants.push_back({ Define, Value });
+}
+
+uint32_t CShaderPermutationSet::Normalize(uint32_t Key) const
+{
+	Key &= m_FeatureMask;
+
+	// Requirements are always on earlier features, so a single pass in order also settles chains of them
+	for (const SFeature& Feature : m_vFeatures)
+	{
+		if ((Key & Feature.Bit) && (Key & Feature.RequiredBits) != Feature.RequiredBits) Key &= ~Feature.Bit;
+	}
+	return Key;
+}
+
+size_t CShaderPermutationSet::GetVariantIndex(uint32_t Key) const
+{
+	return m_vKeyToVariantIndex[Key & m_FeatureMask];
+}
+
+vector<SShaderDefine> CShaderPermutationSet::GetDefines(uint32_t Key) const
+{
+	Key = Normalize(Key);
+
+	vector<SShaderDefine> vDefines{};
+	for (const SFeature& Feature : m_vFeatures)
+	{
+		vDefines.push_back({ Feature.Define, (Key & Feature.Bit) ? "1" : "0" });
+	}
+	vDefines.insert(vDefines.end(), m_vConstants.begin(), m_vConstants.end());
+	return vDefines;
+}
+
+void CShaderPermutationSet::BuildVariants()
+{
+	const uint32_t KKeyCount{ m_FeatureMask + 1 };
+
+	m_vVariantKeys.clear();
+	m_vKeyToVariantIndex.assign(KKeyCount, 0);
+	for (uint32_t Key = 0; Key < KKeyCount; ++Key)
+	{
+		if ((Key & m_FeatureMask) != Key) continue;
+		if (Normalize(Key) != Key) continue;
+
+		m_vKeyToVariantIndex[Key] = static_cast<uint32_t>(m_vVariantKeys.size());
+		m_vVariantKeys.emplace_back(Key);
+	}
+
+	// Pruned and out-of-mask keys use their normalized key's variant
+	for (uint32_t Key = 0; Key < KKeyCount; ++Key)
+	{
+		m_vKeyToVariantIndex[Key] = m_vKeyToVariantIndex[Normalize(Key)];
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+
+// Feature bits of a shader that are compiled into separate variants (each feature is a #define that is 1 or 0) instead of being
+// branched on at runtime
+// Combinations that can't differ are pruned: a feature whose required features are missing is cleared from the key, so all such keys
+// share one variant
+class CShaderPermutationSet final
+{
+	struct SFeature
+	{
+		uint32_t	Bit{};
+		string		Define{};
+		uint32_t	RequiredBits{};
+	};
+
+public:
+	CShaderPermutationSet() {}
+	~CShaderPermutationSet() {}
+
+public:
+	// Bit: a single bit below (1 << KMaxFeatureCount) that isn't used yet; RequiredBits: features added before this one
+	void AddFeature(uint32_t Bit, const string& Define, uint32_t RequiredBits = 0);
+
+	// Defined with the same value in every variant, for constants that the shader shares with the C++ code
+	void AddConstant(const string& Define, const string& Value);
+
+	// Any key is accepted (unknown bits are ignored)
+	uint32_t Normalize(uint32_t Key) const;
+	size_t GetVariantIndex(uint32_t Key) const;
+
+	// Variants are sorted by key, so variant 0 has no features
+	size_t GetVariantCount() const { return m_vVariantKeys.size(); }
+	uint32_t GetVariantKey(size_t VariantIndex) const { return m_vVariantKeys[VariantIndex]; }
+
+	// Every feature is defined (as 1 or 0), so that shaders use #if; constants follow the features
+	vector<SShaderDefine> GetDefines(uint32_t Key) const;
+
+	size_t GetFeatureCount() const { return m_vFeatures.size(); }
+	uint32_t GetFeatureMask() const { return m_FeatureMask; }
+
+private:
+	void BuildVariants();
+
+public:
+	static constexpr uint32_t KMaxFeatureCount{ 12 };
+
+private:
+	vector<SFeature>		m_vFeatures{};
+	uint32_t				m_FeatureMask{};
+	vector<SShaderDefine>	m_vConstants{};
+
+private:
+	vector<uint32_t>	m_vVariantKeys{ 0 };
+	vector<uint32_t>	m_vKeyToVariantIndex{ 0 }; // Indexed by (Key & m_FeatureMask), so every key is looked up directly
+};
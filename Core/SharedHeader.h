@@ -5,16 +5,21 @@
 #include <string>
 #include <vector>
 #include <cassert>
+#include <cfloat>
 #include <d3d11.h>
 #include <wrl.h>
 #include <memory>
 #include <algorithm>
 #include <map>
 #include <unordered_map>
+#if defined(_WIN32)
 #include "../DirectXTK/DirectXTK.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "DirectXTK.lib")
+#else
+#include "../Headless/DirectXTK.h"
+#endif
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
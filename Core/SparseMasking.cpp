@@ -0,0 +1,234 @@
+#include "SparseMasking.h"
+
+// Bound to references (vector::resize), so it needs a definition before C++17
+constexpr uint32_t CSparseMasking::KEmptySlot;
+
+void CSparseMasking::Create(uint32_t Width, uint32_t Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+	m_TileCountX = (m_Width + KTileSize - 1) / KTileSize;
+	m_TileCountY = (m_Height + KTileSize - 1) / KTileSize;
+
+	Clear();
+}
+
+void CSparseMasking::Clear()
+{
+	m_vTileSlots.clear();
+	m_vTileSlots.resize(static_cast<size_t>(m_TileCountX) * m_TileCountY, KEmptySlot);
+	m_vPoolPages.clear();
+	m_vFreeSlots.clear();
+	m_AllocatedTileCount = 0;
+}
+
+SPixel32UInt CSparseMasking::GetTexel(uint32_t U, uint32_t V) const
+{
+	assert(U < m_Width && V < m_Height);
+
+	const uint32_t KSlot{ GetTileSlot(U / KTileSize, V / KTileSize) };
+	if (KSlot == KEmptySlot) return SPixel32UInt();
+	return GetSlotTexels(KSlot)[(V % KTileSize) * KTileSize + (U % KTileSize)];
+}
+
+SPixel32UInt* CSparseMasking::FindTexel(uint32_t U, uint32_t V)
+{
+	assert(U < m_Width && V < m_Height);
+
+	const uint32_t KSlot{ GetTileSlot(U / KTileSize, V / KTileSize) };
+	if (KSlot == KEmptySlot) return nullptr;
+	return &GetSlotTexels(KSlot)[(V % KTileSize) * KTileSize + (U % KTileSize)];
+}
+
+SPixel32UInt* CSparseMasking::GetTexelForWrite(uint32_t U, uint32_t V)
+{
+	assert(U < m_Width && V < m_Height);
+
+	uint32_t Slot{ GetTileSlot(U / KTileSize, V / KTileSize) };
+	if (Slot == KEmptySlot) Slot = AllocateTile(U / KTileSize, V / KTileSize);
+	return &GetSlotTexels(Slot)[(V % KTileSize) * KTileSize + (U % KTileSize)];
+}
+
+void CSparseMasking::ReadRect(const CMipGenerator::SRect& Rect, SPixel32UInt* const PtrOut, uint32_t OutWidth) const
+{
+	if (Rect.IsEmpty()) return;
+
+	for (uint32_t V = Rect.Top; V < Rect.Bottom; ++V)
+	{
+		memset(PtrOut + static_cast<size_t>(V - Rect.Top) * OutWidth, 0, (Rect.Right - Rect.Left) * sizeof(SPixel32UInt));
+	}
+
+	ForEachAllocatedTile(Rect, [&](const SPixel32UInt* const PtrTileTexels, uint32_t TileX, uint32_t TileY, const CMipGenerator::SRect& TileRect)
+		{
+			const uint32_t KOutLeft{ TileX * KTileSize + TileRect.Left - Rect.Left };
+			for (uint32_t V = TileRect.Top; V < TileRect.Bottom; ++V)
+			{
+				memcpy(PtrOut + static_cast<size_t>(TileY * KTileSize + V - Rect.Top) * OutWidth + KOutLeft,
+					PtrTileTexels + V * KTileSize + TileRect.Left, (TileRect.Right - TileRect.Left) * sizeof(SPixel32UInt));
+			}
+		});
+}
+
+void CSparseMasking::WriteRect(const CMipGenerator::SRect& Rect, const SPixel32UInt* const PtrSource, uint32_t SourceWidth)
+{
+	if (Rect.IsEmpty()) return;
+
+	const uint32_t KTileRight{ min((Rect.Right - 1) / KTileSize + 1, m_TileCountX) };
+	const uint32_t KTileBottom{ min((Rect.Bottom - 1) / KTileSize + 1, m_TileCountY) };
+	for (uint32_t TileY = Rect.Top / KTileSize; TileY < KTileBottom; ++TileY)
+	{
+		for (uint32_t TileX = Rect.Left / KTileSize; TileX < KTileRight; ++TileX)
+		{
+			const uint32_t KLeft{ max(Rect.Left, TileX * KTileSize) };
+			const uint32_t KTop{ max(Rect.Top, TileY * KTileSize) };
+			const uint32_t KRight{ min(Rect.Right, (TileX + 1) * KTileSize) };
+			const uint32_t KBottom{ min(Rect.Bottom, (TileY + 1) * KTileSize) };
+			auto GetSourceRow{ [&](uint32_t V) { return PtrSource + static_cast<size_t>(V - Rect.Top) * SourceWidth + (KLeft - Rect.Left); } };
+
+			uint32_t Slot{ GetTileSlot(TileX, TileY) };
+			if (Slot == KEmptySlot)
+			{
+				// Writing zeros to an unallocated tile changes nothing
+				uint32_t Bits{};
+				for (uint32_t V = KTop; V < KBottom && !Bits; ++V)
+				{
+					const uint32_t* const PtrRow{ reinterpret_cast<const uint32_t*>(GetSourceRow(V)) };
+					for (uint32_t U = 0; U < KRight - KLeft; ++U) Bits |= PtrRow[U];
+				}
+				if (!Bits) continue;
+
+				Slot = AllocateTile(TileX, TileY);
+			}
+
+			SPixel32UInt* const PtrTileTexels{ GetSlotTexels(Slot) };
+			for (uint32_t V = KTop; V < KBottom; ++V)
+			{
+				memcpy(PtrTileTexels + (V - TileY * KTileSize) * KTileSize + (KLeft - TileX * KTileSize), GetSourceRow(V),
+					(KRight - KLeft) * sizeof(SPixel32UInt));
+			}
+		}
+	}
+}
+
+size_t CSparseMasking::ReleaseZeroTiles(const CMipGenerator::SRect& Rect)
+{
+	if (Rect.IsEmpty()) return 0;
+
+	size_t ReleasedTileCount{};
+	const uint32_t KTileRight{ min((Rect.Right - 1) / KTileSize + 1, m_TileCountX) };
+	const uint32_t KTileBottom{ min((Rect.Bottom - 1) / KTileSize + 1, m_TileCountY) };
+	for (uint32_t TileY = Rect.Top / KTileSize; TileY < KTileBottom; ++TileY)
+	{
+		for (uint32_t TileX = Rect.Left / KTileSize; TileX < KTileRight; ++TileX)
+		{
+			uint32_t& Slot{ m_vTileSlots[static_cast<size_t>(TileY) * m_TileCountX + TileX] };
+			if (Slot == KEmptySlot) continue;
+
+			const uint32_t* const PtrTexels{ reinterpret_cast<const uint32_t*>(GetSlotTexels(Slot)) };
+			uint32_t Bits{};
+			for (uint32_t iTexel = 0; iTexel < KTileTexelCount && !Bits; ++iTexel) Bits |= PtrTexels[iTexel];
+			if (Bits) continue;
+
+			m_vFreeSlots.emplace_back(Slot);
+			Slot = KEmptySlot;
+			--m_AllocatedTileCount;
+			++ReleasedTileCount;
+		}
+	}
+	return ReleasedTileCount;
+}
+
+void CSparseMasking::ReadAtlasSlot(uint32_t TileX, uint32_t TileY, SPixel32UInt* const PtrOut) const
+{
+	assert(TileX < m_TileCountX && TileY < m_TileCountY);
+
+	// Texels outside the texture repeat its edge, as D3D11_TEXTURE_ADDRESS_CLAMP does for the whole texture
+	const int KOriginU{ static_cast<int>(TileX * KTileSize) - static_cast<int>(KAtlasBorder) };
+	const int KOriginV{ static_cast<int>(TileY * KTileSize) - static_cast<int>(KAtlasBorder) };
+	const int KMaxU{ static_cast<int>(m_Width) - 1 };
+	const int KMaxV{ static_cast<int>(m_Height) - 1 };
+	for (uint32_t Y = 0; Y < KAtlasSlotSize; ++Y)
+	{
+		const uint32_t KV{ static_cast<uint32_t>(min(max(KOriginV + static_cast<int>(Y), 0), KMaxV)) };
+		for (uint32_t X = 0; X < KAtlasSlotSize; ++X)
+		{
+			const uint32_t KU{ static_cast<uint32_t>(min(max(KOriginU + static_cast<int>(X), 0), KMaxU)) };
+			PtrOut[Y * KAtlasSlotSize + X] = GetTexel(KU, KV);
+		}
+	}
+}
+
+void CSparseMasking::Downsample(uint32_t Factor, const CMipGenerator::SRect& Rect, SPixel32UInt* const PtrOut, uint32_t OutWidth) const
+{
+	assert(Factor && (KTileSize % Factor) == 0);
+
+	for (uint32_t BlockY = Rect.Top; BlockY < Rect.Bottom; ++BlockY)
+	{
+		for (uint32_t BlockX = Rect.Left; BlockX < Rect.Right; ++BlockX)
+		{
+			SPixel32UInt& Out{ PtrOut[static_cast<size_t>(BlockY - Rect.Top) * OutWidth + (BlockX - Rect.Left)] };
+			Out = SPixel32UInt();
+
+			// A block lies in one tile
+			const uint32_t KSlot{ GetTileSlot((BlockX * Factor) / KTileSize, (BlockY * Factor) / KTileSize) };
+			if (KSlot == KEmptySlot) continue;
+
+			const SPixel32UInt* const PtrTileTexels{ GetSlotTexels(KSlot) };
+			const uint32_t KLeft{ (BlockX * Factor) % KTileSize };
+			const uint32_t KTop{ (BlockY * Factor) % KTileSize };
+			const uint32_t KRight{ KLeft + min(Factor, m_Width - BlockX * Factor) };
+			const uint32_t KBottom{ KTop + min(Factor, m_Height - BlockY * Factor) };
+			uint32_t Sums[4]{};
+			for (uint32_t V = KTop; V < KBottom; ++V)
+			{
+				for (uint32_t U = KLeft; U < KRight; ++U)
+				{
+					const SPixel32UInt& Texel{ PtrTileTexels[V * KTileSize + U] };
+					Sums[0] += Texel.R;
+					Sums[1] += Texel.G;
+					Sums[2] += Texel.B;
+					Sums[3] += Texel.A;
+				}
+			}
+
+			const uint32_t KCount{ (KRight - KLeft) * (KBottom - KTop) };
+			Out.R = static_cast<uint8_t>((Sums[0] + KCount / 2) / KCount);
+			Out.G = static_cast<uint8_t>((Sums[1] + KCount / 2) / KCount);
+			Out.B = static_cast<uint8_t>((Sums[2] + KCount / 2) / KCount);
+			Out.A = static_cast<uint8_t>((Sums[3] + KCount / 2) / KCount);
+		}
+	}
+}
+
+CSparseMasking::SStats CSparseMasking::GetStats() const
+{
+	SStats Stats{};
+	Stats.TileCount = m_vTileSlots.size();
+	Stats.AllocatedTileCount = m_AllocatedTileCount;
+	Stats.PoolTileCount = GetPoolTileCount();
+	Stats.MemoryBytes = Stats.PoolTileCount * KTileTexelCount * sizeof(SPixel32UInt) + m_vTileSlots.size() * sizeof(uint32_t);
+	Stats.DenseMemoryBytes = static_cast<size_t>(m_Width) * m_Height * sizeof(SPixel32UInt);
+	return Stats;
+}
+
+uint32_t CSparseMasking::AllocateTile(uint32_t TileX, uint32_t TileY)
+{
+	if (m_vFreeSlots.empty())
+	{
+		// Slots are handed out from the lowest, so that the atlas stays compact
+		const uint32_t KFirstSlot{ static_cast<uint32_t>(GetPoolTileCount()) };
+		m_vPoolPages.emplace_back(make_unique<SPixel32UInt[]>(static_cast<size_t>(KPoolPageTileCount) * KTileTexelCount));
+		for (uint32_t iSlot = KPoolPageTileCount; iSlot > 0; --iSlot)
+		{
+			m_vFreeSlots.emplace_back(KFirstSlot + iSlot - 1);
+		}
+	}
+
+	const uint32_t KSlot{ m_vFreeSlots.back() };
+	m_vFreeSlots.pop_back();
+	memset(GetSlotTexels(KSlot), 0, KTileTexelCount * sizeof(SPixel32UInt));
+
+	m_vTileSlots[static_cast<size_t>(TileY) * m_TileCountX + TileX] = KSlot;
+	++m_AllocatedTileCount;
+	return KSlot;
+}
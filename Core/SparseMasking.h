@@ -0,0 +1,112 @@
+#pragma once
+
+#include "MipGenerator.h"
+
+// The terrain's masking texels, stored in KTileSize x KTileSize tiles that are allocated only when a non-zero texel is written to them
+// Unallocated tiles hold no memory and read as 0; allocated tiles come from a pool that grows by pages and reuses released tiles
+// ReadAtlasSlot() pads a tile with KAtlasBorder texels of its neighbours for the GPU atlas (see CTerrain)
+class CSparseMasking final
+{
+public:
+	struct SStats
+	{
+		size_t		TileCount{};
+		size_t		AllocatedTileCount{};
+		size_t		PoolTileCount{}; // Allocated + free
+		size_t		MemoryBytes{}; // Pool pages + tile table
+		size_t		DenseMemoryBytes{}; // Of the same texels stored in a plain array
+	};
+
+public:
+	CSparseMasking() {}
+	~CSparseMasking() {}
+
+public:
+	// Every tile is unallocated (every texel is 0)
+	void Create(uint32_t Width, uint32_t Height);
+	// Releases every tile and frees the pool
+	void Clear();
+
+	SPixel32UInt GetTexel(uint32_t U, uint32_t V) const;
+	// nullptr if the texel's tile isn't allocated
+	SPixel32UInt* FindTexel(uint32_t U, uint32_t V);
+	// Allocates the texel's tile (with 0 texels) if it isn't allocated
+	SPixel32UInt* GetTexelForWrite(uint32_t U, uint32_t V);
+
+	// PtrOut has OutWidth texels per row, Rect is in texels
+	void ReadRect(const CMipGenerator::SRect& Rect, SPixel32UInt* const PtrOut, uint32_t OutWidth) const;
+	// Zero texels don't allocate tiles
+	void WriteRect(const CMipGenerator::SRect& Rect, const SPixel32UInt* const PtrSource, uint32_t SourceWidth);
+	// Releases the tiles that Rect (in texels) reaches and whose texels are all 0; returns how many were released
+	size_t ReleaseZeroTiles(const CMipGenerator::SRect& Rect);
+
+	// Calls Function(PtrTileTexels, TileX, TileY, TileRect) for every allocated tile that Rect (in texels) reaches
+	// PtrTileTexels has KTileSize texels per row, TileRect is the part of Rect in the tile (in the tile's texels)
+	template<typename TFunction>
+	void ForEachAllocatedTile(const CMipGenerator::SRect& Rect, const TFunction& Function) const;
+
+	// PtrOut: KAtlasSlotSize x KAtlasSlotSize texels, the tile and KAtlasBorder texels around it (clamped to the texture's edge)
+	void ReadAtlasSlot(uint32_t TileX, uint32_t TileY, SPixel32UInt* const PtrOut) const;
+	// Averages of Factor x Factor texel blocks (Factor must divide KTileSize); Rect is in blocks, PtrOut has OutWidth blocks per row
+	void Downsample(uint32_t Factor, const CMipGenerator::SRect& Rect, SPixel32UInt* const PtrOut, uint32_t OutWidth) const;
+
+	// KEmptySlot if the tile isn't allocated
+	uint32_t GetTileSlot(uint32_t TileX, uint32_t TileY) const { return m_vTileSlots[static_cast<size_t>(TileY) * m_TileCountX + TileX]; }
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	uint32_t GetTileCountX() const { return m_TileCountX; }
+	uint32_t GetTileCountY() const { return m_TileCountY; }
+	size_t GetPoolTileCount() const { return m_vPoolPages.size() * KPoolPageTileCount; }
+	SStats GetStats() const;
+
+private:
+	SPixel32UInt* GetSlotTexels(uint32_t Slot) { return m_vPoolPages[Slot / KPoolPageTileCount].get() + (Slot % KPoolPageTileCount) * KTileTexelCount; }
+	const SPixel32UInt* GetSlotTexels(uint32_t Slot) const
+	{
+		return m_vPoolPages[Slot / KPoolPageTileCount].get() + (Slot % KPoolPageTileCount) * KTileTexelCount;
+	}
+	uint32_t AllocateTile(uint32_t TileX, uint32_t TileY);
+
+public:
+	static constexpr uint32_t KTileSize{ 32 };
+	static constexpr uint32_t KTileTexelCount{ KTileSize * KTileSize };
+	static constexpr uint32_t KPoolPageTileCount{ 64 };
+	static constexpr uint32_t KEmptySlot{ UINT32_MAX };
+	static constexpr uint32_t KAtlasBorder{ 4 }; // Keeps bilinear filtering of mips 0 ~ (KAtlasMipCount - 1) inside the slot
+	static constexpr uint32_t KAtlasSlotSize{ KTileSize + 2 * KAtlasBorder };
+	static constexpr uint32_t KAtlasMipCount{ 3 };
+
+private:
+	uint32_t							m_Width{};
+	uint32_t							m_Height{};
+	uint32_t							m_TileCountX{};
+	uint32_t							m_TileCountY{};
+	vector<uint32_t>					m_vTileSlots{};
+	vector<unique_ptr<SPixel32UInt[]>>	m_vPoolPages{};
+	vector<uint32_t>					m_vFreeSlots{};
+	size_t								m_AllocatedTileCount{};
+};
+
+template<typename TFunction>
+void CSparseMasking::ForEachAllocatedTile(const CMipGenerator::SRect& Rect, const TFunction& Function) const
+{
+	if (Rect.IsEmpty()) return;
+
+	const uint32_t KTileRight{ min((Rect.Right - 1) / KTileSize + 1, m_TileCountX) };
+	const uint32_t KTileBottom{ min((Rect.Bottom - 1) / KTileSize + 1, m_TileCountY) };
+	for (uint32_t TileY = Rect.Top / KTileSize; TileY < KTileBottom; ++TileY)
+	{
+		for (uint32_t TileX = Rect.Left / KTileSize; TileX < KTileRight; ++TileX)
+		{
+			const uint32_t KSlot{ GetTileSlot(TileX, TileY) };
+			if (KSlot == KEmptySlot) continue;
+
+			CMipGenerator::SRect TileRect{};
+			TileRect.Left = max(Rect.Left, TileX * KTileSize) - TileX * KTileSize;
+			TileRect.Top = max(Rect.Top, TileY * KTileSize) - TileY * KTileSize;
+			TileRect.Right = min(Rect.Right, (TileX + 1) * KTileSize) - TileX * KTileSize;
+			TileRect.Bottom = min(Rect.Bottom, (TileY + 1) * KTileSize) - TileY * KTileSize;
+			Function(GetSlotTexels(KSlot), TileX, TileY, TileRect);
+		}
+	}
+}
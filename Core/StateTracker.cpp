@@ -0,0 +1,245 @@
+#include "StateTracker.h"
+
+template <typename T>
+bool CStateTracker::ShouldIssue(SCachedState<T>& State, const T& NewValue)
+{
+	if (m_bIsTracking && !State.Update(NewValue))
+	{
+		++m_Stats.SkippedCallCount;
+		return false;
+	}
+
+	++m_Stats.IssuedCallCount;
+	return true;
+}
+
+void CStateTracker::SetVertexShader(ID3D11VertexShader* const PtrShader)
+{
+	m_PtrLastShaders[static_cast<size_t>(EShaderType::VertexShader)] = PtrShader;
+	if (ShouldIssue(m_VertexShader, PtrShader)) m_PtrRenderDevice->SetVertexShader(PtrShader);
+}
+
+void CStateTracker::SetHullShader(ID3D11HullShader* const PtrShader)
+{
+	m_PtrLastShaders[static_cast<size_t>(EShaderType::HullShader)] = PtrShader;
+	if (ShouldIssue(m_HullShader, PtrShader)) m_PtrRenderDevice->SetHullShader(PtrShader);
+}
+
+void CStateTracker::SetDomainShader(ID3D11DomainShader* const PtrShader)
+{
+	m_PtrLastShaders[static_cast<size_t>(EShaderType::DomainShader)] = PtrShader;
+	if (ShouldIssue(m_DomainShader, PtrShader)) m_PtrRenderDevice->SetDomainShader(PtrShader);
+}
+
+void CStateTracker::SetGeometryShader(ID3D11GeometryShader* const PtrShader)
+{
+	m_PtrLastShaders[static_cast<size_t>(EShaderType::GeometryShader)] = PtrShader;
+	if (ShouldIssue(m_GeometryShader, PtrShader)) m_PtrRenderDevice->SetGeometryShader(PtrShader);
+}
+
+void CStateTracker::SetPixelShader(ID3D11PixelShader* const PtrShader)
+{
+	m_PtrLastShaders[static_cast<size_t>(EShaderType::PixelShader)] = PtrShader;
+	if (ShouldIssue(m_PixelShader, PtrShader)) m_PtrRenderDevice->SetPixelShader(PtrShader);
+}
+
+void CStateTracker::SetInputLayout(ID3D11InputLayout* const PtrInputLayout)
+{
+	if (ShouldIssue(m_InputLayout, PtrInputLayout)) m_PtrRenderDevice->SetInputLayout(PtrInputLayout);
+}
+
+void CStateTracker::SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer)
+{
+	if (Slot < KTrackedConstantBufferSlotCount)
+	{
+		SConstantBufferBinding Binding{};
+		Binding.PtrBuffer = PtrBuffer;
+		if (!ShouldIssue(m_ConstantBuffers[static_cast<size_t>(eShaderType)][Slot], Binding)) return;
+	}
+	else
+	{
+		++m_Stats.IssuedCallCount;
+	}
+	m_PtrRenderDevice->SetConstantBuffer(eShaderType, Slot, PtrBuffer);
+}
+
+void CStateTracker::SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView)
+{
+	if (Slot < KTrackedShaderResourceSlotCount)
+	{
+		if (!ShouldIssue(m_ShaderResources[static_cast<size_t>(eShaderType)][Slot], PtrShaderResourceView)) return;
+	}
+	else
+	{
+		++m_Stats.IssuedCallCount;
+	}
+	m_PtrRenderDevice->SetShaderResource(eShaderType, Slot, PtrShaderResourceView);
+}
+
+void CStateTracker::SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant,
+	UINT ConstantCount)
+{
+	if (Slot < KTrackedConstantBufferSlotCount)
+	{
+		SConstantBufferBinding Binding{};
+		Binding.PtrBuffer = PtrBuffer;
+		Binding.FirstConstant = FirstConstant;
+		Binding.ConstantCount = ConstantCount;
+		if (!ShouldIssue(m_ConstantBuffers[static_cast<size_t>(eShaderType)][Slot], Binding)) return;
+	}
+	else
+	{
+		++m_Stats.IssuedCallCount;
+	}
+	m_PtrRenderDevice->SetConstantBufferRange(eShaderType, Slot, PtrBuffer, FirstConstant, ConstantCount);
+}
+
+void CStateTracker::SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState)
+{
+	if (Slot < KTrackedSamplerSlotCount)
+	{
+		if (!ShouldIssue(m_SamplerStates[static_cast<size_t>(eShaderType)][Slot], PtrState)) return;
+	}
+	else
+	{
+		++m_Stats.IssuedCallCount;
+	}
+	m_PtrRenderDevice->SetSamplerState(eShaderType, Slot, PtrState);
+}
+
+void CStateTracker::SetRasterizerState(ID3D11RasterizerState* const PtrState)
+{
+	if (ShouldIssue(m_RasterizerState, PtrState)) m_PtrRenderDevice->SetRasterizerState(PtrState);
+}
+
+void CStateTracker::SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef)
+{
+	SDepthStencilBinding Binding{};
+	Binding.PtrState = PtrState;
+	Binding.StencilRef = StencilRef;
+	if (ShouldIssue(m_DepthStencilState, Binding)) m_PtrRenderDevice->SetDepthStencilState(PtrState, StencilRef);
+}
+
+void CStateTracker::SetBlendState(ID3D11BlendState* const PtrState)
+{
+	if (ShouldIssue(m_BlendState, PtrState)) m_PtrRenderDevice->SetBlendState(PtrState);
+}
+
+void CStateTracker::SetViewport(const D3D11_VIEWPORT& Viewport)
+{
+	++m_Stats.IssuedCallCount;
+	m_PtrRenderDevice->SetViewport(Viewport);
+}
+
+void CStateTracker::SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView)
+{
+	++m_Stats.IssuedCallCount;
+	m_PtrRenderDevice->SetRenderTarget(PtrRenderTargetView, PtrDepthStencilView);
+}
+
+void CStateTracker::ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4])
+{
+	++m_Stats.IssuedCallCount;
+	m_PtrRenderDevice->ClearRenderTarget(PtrRenderTargetView, Color);
+}
+
+void CStateTracker::ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+	++m_Stats.IssuedCallCount;
+	m_PtrRenderDevice->ClearDepthStencil(PtrDepthStencilView, ClearFlags, Depth, Stencil);
+}
+
+void CStateTracker::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology)
+{
+	if (ShouldIssue(m_PrimitiveTopology, eTopology)) m_PtrRenderDevice->SetPrimitiveTopology(eTopology);
+}
+
+void CStateTracker::SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset)
+{
+	if (Slot < KTrackedVertexBufferSlotCount)
+	{
+		SVertexBufferBinding Binding{};
+		Binding.PtrBuffer = PtrBuffer;
+		Binding.Stride = Stride;
+		Binding.Offset = Offset;
+		if (!ShouldIssue(m_VertexBuffers[Slot], Binding)) return;
+	}
+	else
+	{
+		++m_Stats.IssuedCallCount;
+	}
+	m_PtrRenderDevice->SetVertexBuffer(Slot, PtrBuffer, Stride, Offset);
+}
+
+void CStateTracker::SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+	SIndexBufferBinding Binding{};
+	Binding.PtrBuffer = PtrBuffer;
+	Binding.Format = Format;
+	Binding.Offset = Offset;
+	if (ShouldIssue(m_IndexBuffer, Binding)) m_PtrRenderDevice->SetIndexBuffer(PtrBuffer, Format, Offset);
+}
+
+void CStateTracker::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+	++m_Stats.DrawCallCount;
+	m_PtrRenderDevice->Draw(VertexCount, StartVertexLocation);
+}
+
+void CStateTracker::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+	++m_Stats.DrawCallCount;
+	m_PtrRenderDevice->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void CStateTracker::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+	UINT StartInstanceLocation)
+{
+	++m_Stats.DrawCallCount;
+	m_PtrRenderDevice->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+}
+
+void CStateTracker::BeginFrame()
+{
+	m_Stats = SStats();
+}
+
+void CStateTracker::BeginTracking()
+{
+	Invalidate();
+
+	m_bIsTracking = true;
+}
+
+void CStateTracker::EndTracking()
+{
+	m_bIsTracking = false;
+}
+
+void CStateTracker::Invalidate()
+{
+	m_VertexShader.bIsValid = false;
+	m_HullShader.bIsValid = false;
+	m_DomainShader.bIsValid = false;
+	m_GeometryShader.bIsValid = false;
+	m_PixelShader.bIsValid = false;
+	m_InputLayout.bIsValid = false;
+	for (auto& ConstantBuffers : m_ConstantBuffers)
+	{
+		for (auto& ConstantBuffer : ConstantBuffers) ConstantBuffer.bIsValid = false;
+	}
+	for (auto& ShaderResources : m_ShaderResources)
+	{
+		for (auto& ShaderResource : ShaderResources) ShaderResource.bIsValid = false;
+	}
+	for (auto& SamplerStates : m_SamplerStates)
+	{
+		for (auto& SamplerState : SamplerStates) SamplerState.bIsValid = false;
+	}
+	m_RasterizerState.bIsValid = false;
+	m_DepthStencilState.bIsValid = false;
+	m_BlendState.bIsValid = false;
+	m_PrimitiveTopology.bIsValid = false;
+	for (auto& VertexBuffer : m_VertexBuffers) VertexBuffer.bIsValid = false;
+	m_IndexBuffer.bIsValid = false;
+}
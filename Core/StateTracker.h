@@ -0,0 +1,169 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+// Skips the calls that would set the state that is already bound
+// @important: the cache is only used between BeginTracking() and EndTracking(), so code that calls the device context directly
+// must not run inside that range. Outside of it every call is forwarded.
+class CStateTracker final
+{
+	template <typename T>
+	struct SCachedState
+	{
+		// Returns true if the call must be issued
+		bool Update(const T& NewValue)
+		{
+			if (bIsValid && Value == NewValue) return false;
+
+			Value = NewValue;
+			bIsValid = true;
+			return true;
+		}
+
+		T		Value{};
+		bool	bIsValid{};
+	};
+
+	// ConstantCount is 0 when the whole buffer is bound
+	struct SConstantBufferBinding
+	{
+		bool operator==(const SConstantBufferBinding& b) const
+		{
+			return (PtrBuffer == b.PtrBuffer && FirstConstant == b.FirstConstant && ConstantCount == b.ConstantCount);
+		}
+
+		ID3D11Buffer*	PtrBuffer{};
+		UINT			FirstConstant{};
+		UINT			ConstantCount{};
+	};
+
+	struct SVertexBufferBinding
+	{
+		bool operator==(const SVertexBufferBinding& b) const
+		{
+			return (PtrBuffer == b.PtrBuffer && Stride == b.Stride && Offset == b.Offset);
+		}
+
+		ID3D11Buffer*	PtrBuffer{};
+		UINT			Stride{};
+		UINT			Offset{};
+	};
+
+	struct SIndexBufferBinding
+	{
+		bool operator==(const SIndexBufferBinding& b) const
+		{
+			return (PtrBuffer == b.PtrBuffer && Format == b.Format && Offset == b.Offset);
+		}
+
+		ID3D11Buffer*	PtrBuffer{};
+		DXGI_FORMAT		Format{};
+		UINT			Offset{};
+	};
+
+	struct SDepthStencilBinding
+	{
+		bool operator==(const SDepthStencilBinding& b) const
+		{
+			return (PtrState == b.PtrState && StencilRef == b.StencilRef);
+		}
+
+		ID3D11DepthStencilState*	PtrState{};
+		UINT						StencilRef{};
+	};
+
+public:
+	struct SStats
+	{
+		size_t	IssuedCallCount{};
+		size_t	SkippedCallCount{}; // State changes avoided
+		size_t	DrawCallCount{};
+	};
+
+public:
+	CStateTracker(CRenderDevice* const PtrRenderDevice) : m_PtrRenderDevice{ PtrRenderDevice }
+	{
+		assert(m_PtrRenderDevice);
+	}
+	~CStateTracker() {}
+
+public:
+	void SetVertexShader(ID3D11VertexShader* const PtrShader);
+	void SetHullShader(ID3D11HullShader* const PtrShader);
+	void SetDomainShader(ID3D11DomainShader* const PtrShader);
+	void SetGeometryShader(ID3D11GeometryShader* const PtrShader);
+	void SetPixelShader(ID3D11PixelShader* const PtrShader);
+	void SetInputLayout(ID3D11InputLayout* const PtrInputLayout);
+	void SetConstantBuffer(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer);
+	void SetShaderResource(EShaderType eShaderType, UINT Slot, ID3D11ShaderResourceView* const PtrShaderResourceView);
+	void SetConstantBufferRange(EShaderType eShaderType, UINT Slot, ID3D11Buffer* const PtrBuffer, UINT FirstConstant, UINT ConstantCount);
+	void SetSamplerState(EShaderType eShaderType, UINT Slot, ID3D11SamplerState* const PtrState);
+
+	void SetRasterizerState(ID3D11RasterizerState* const PtrState);
+	void SetDepthStencilState(ID3D11DepthStencilState* const PtrState, UINT StencilRef);
+	void SetBlendState(ID3D11BlendState* const PtrState);
+
+	// Not cached
+	void SetViewport(const D3D11_VIEWPORT& Viewport);
+	void SetRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, ID3D11DepthStencilView* const PtrDepthStencilView);
+	void ClearRenderTarget(ID3D11RenderTargetView* const PtrRenderTargetView, const FLOAT Color[4]);
+	void ClearDepthStencil(ID3D11DepthStencilView* const PtrDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil);
+
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY eTopology);
+	void SetVertexBuffer(UINT Slot, ID3D11Buffer* const PtrBuffer, UINT Stride, UINT Offset);
+	void SetIndexBuffer(ID3D11Buffer* const PtrBuffer, DXGI_FORMAT Format, UINT Offset);
+
+	void Draw(UINT VertexCount, UINT StartVertexLocation);
+	void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation);
+	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+		UINT StartInstanceLocation);
+
+public:
+	// Resets the stats
+	void BeginFrame();
+
+	// The bound state is unknown when tracking begins, so the cache starts invalid
+	void BeginTracking();
+	void EndTracking();
+	void Invalidate();
+
+	bool IsTracking() const { return m_bIsTracking; }
+	const SStats& GetStats() const { return m_Stats; }
+
+	// The shader last set through the tracker, also outside of tracking ranges (shaders set on the device directly aren't seen)
+	const void* GetLastShader(EShaderType eShaderType) const { return m_PtrLastShaders[static_cast<size_t>(eShaderType)]; }
+
+private:
+	template <typename T>
+	bool ShouldIssue(SCachedState<T>& State, const T& NewValue);
+
+public:
+	static constexpr size_t KShaderTypeCount{ 5 };
+	static constexpr size_t KTrackedConstantBufferSlotCount{ D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT };
+	static constexpr size_t KTrackedShaderResourceSlotCount{ 16 }; // Higher slots are always forwarded
+	static constexpr size_t KTrackedVertexBufferSlotCount{ 4 }; // Higher slots are always forwarded
+	static constexpr size_t KTrackedSamplerSlotCount{ D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT };
+
+private:
+	CRenderDevice* const								m_PtrRenderDevice{};
+	bool												m_bIsTracking{};
+	SStats												m_Stats{};
+	const void*											m_PtrLastShaders[KShaderTypeCount]{};
+
+private:
+	SCachedState<ID3D11VertexShader*>					m_VertexShader{};
+	SCachedState<ID3D11HullShader*>						m_HullShader{};
+	SCachedState<ID3D11DomainShader*>					m_DomainShader{};
+	SCachedState<ID3D11GeometryShader*>					m_GeometryShader{};
+	SCachedState<ID3D11PixelShader*>					m_PixelShader{};
+	SCachedState<ID3D11InputLayout*>					m_InputLayout{};
+	SCachedState<SConstantBufferBinding>				m_ConstantBuffers[KShaderTypeCount][KTrackedConstantBufferSlotCount]{};
+	SCachedState<ID3D11ShaderResourceView*>				m_ShaderResources[KShaderTypeCount][KTrackedShaderResourceSlotCount]{};
+	SCachedState<ID3D11SamplerState*>					m_SamplerStates[KShaderTypeCount][KTrackedSamplerSlotCount]{};
+	SCachedState<ID3D11RasterizerState*>				m_RasterizerState{};
+	SCachedState<SDepthStencilBinding>					m_DepthStencilState{};
+	SCachedState<ID3D11BlendState*>						m_BlendState{};
+	SCachedState<D3D11_PRIMITIVE_TOPOLOGY>				m_PrimitiveTopology{};
+	SCachedState<SVertexBufferBinding>					m_VertexBuffers[KTrackedVertexBufferSlotCount]{};
+	SCachedState<SIndexBufferBinding>					m_IndexBuffer{};
+};
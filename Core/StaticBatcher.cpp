@@ -0,0 +1,227 @@
+#include "StaticBatcher.h"
+
+size_t CStaticBatcher::RegisterMember(const SMesh* const PtrMesh, const XMMATRIX& World, uint64_t Key)
+{
+	assert(PtrMesh);
+
+	size_t MemberID{};
+	if (m_vFreeMemberIDs.size())
+	{
+		MemberID = m_vFreeMemberIDs.back();
+		m_vFreeMemberIDs.pop_back();
+	}
+	else
+	{
+		MemberID = m_vMembers.size();
+		m_vMembers.emplace_back();
+	}
+
+	XMVECTOR Min{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR Max{ XMVectorReplicate(-FLT_MAX) };
+	for (const SVertex3D& Vertex : PtrMesh->vVertices)
+	{
+		Min = XMVectorMin(Min, Vertex.Position);
+		Max = XMVectorMax(Max, Vertex.Position);
+	}
+
+	SMember& Member{ m_vMembers[MemberID] };
+	Member = SMember();
+	Member.PtrMesh = PtrMesh;
+	Member.World = World;
+	Member.Key = Key;
+	if (PtrMesh->vVertices.size()) XMStoreFloat3(&Member.LocalCenter, (Min + Max) * 0.5f);
+	Member.bIsRegistered = true;
+
+	AssignMember(MemberID);
+	return MemberID;
+}
+
+void CStaticBatcher::UnregisterMember(size_t MemberID)
+{
+	if (!IsMemberRegistered(MemberID)) return;
+
+	DetachMember(MemberID);
+
+	m_vMembers[MemberID] = SMember();
+	m_vFreeMemberIDs.emplace_back(MemberID);
+}
+
+void CStaticBatcher::Clear()
+{
+	m_vMembers.clear();
+	m_vFreeMemberIDs.clear();
+	m_vBatches.clear();
+	m_vFreeBatchIndices.clear();
+	m_mapBatchKeyToIndex.clear();
+	m_Stats = SStats();
+}
+
+void CStaticBatcher::UpdateMember(size_t MemberID, const XMMATRIX& World, uint64_t Key)
+{
+	if (!IsMemberRegistered(MemberID)) return;
+
+	SMember& Member{ m_vMembers[MemberID] };
+	if (Member.Key == Key && memcmp(&Member.World, &World, sizeof(XMMATRIX)) == 0) return;
+
+	DetachMember(MemberID);
+	Member.World = World;
+	Member.Key = Key;
+	AssignMember(MemberID);
+}
+
+void CStaticBatcher::Update()
+{
+	const std::chrono::steady_clock::time_point KStart{ std::chrono::steady_clock::now() };
+
+	m_Stats.RebuiltBatchCount = 0;
+	m_Stats.RebuiltVertexCount = 0;
+	for (SBatch& Batch : m_vBatches)
+	{
+		if (!Batch.bIsDirty) continue;
+
+		RebuildBatch(Batch);
+
+		++m_Stats.RebuiltBatchCount;
+		m_Stats.RebuiltVertexCount += Batch.Mesh.vVertices.size();
+	}
+
+	m_Stats.MemberCount = m_vMembers.size() - m_vFreeMemberIDs.size();
+	m_Stats.BatchCount = m_mapBatchKeyToIndex.size();
+	m_Stats.ElapsedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - KStart).count();
+}
+
+bool CStaticBatcher::IsMemberRegistered(size_t MemberID) const
+{
+	return (MemberID < m_vMembers.size()) ? m_vMembers[MemberID].bIsRegistered : false;
+}
+
+void CStaticBatcher::AssignMember(size_t MemberID)
+{
+	SMember& Member{ m_vMembers[MemberID] };
+
+	XMVECTOR WorldCenter{ XMVector3TransformCoord(XMLoadFloat3(&Member.LocalCenter), Member.World) };
+	SBatchKey BatchKey{};
+	BatchKey.Key = Member.Key;
+	BatchKey.CellX = static_cast<int32_t>(floorf(XMVectorGetX(WorldCenter) / m_Desc.CellSize));
+	BatchKey.CellY = static_cast<int32_t>(floorf(XMVectorGetY(WorldCenter) / m_Desc.CellSize));
+	BatchKey.CellZ = static_cast<int32_t>(floorf(XMVectorGetZ(WorldCenter) / m_Desc.CellSize));
+
+	size_t BatchIndex{};
+	auto it{ m_mapBatchKeyToIndex.find(BatchKey) };
+	if (it != m_mapBatchKeyToIndex.end())
+	{
+		BatchIndex = it->second;
+	}
+	else
+	{
+		if (m_vFreeBatchIndices.size())
+		{
+			BatchIndex = m_vFreeBatchIndices.back();
+			m_vFreeBatchIndices.pop_back();
+		}
+		else
+		{
+			BatchIndex = m_vBatches.size();
+			m_vBatches.emplace_back();
+		}
+		m_mapBatchKeyToIndex[BatchKey] = BatchIndex;
+
+		SBatch& Batch{ m_vBatches[BatchIndex] };
+		Batch.Key = BatchKey.Key;
+		Batch.CellX = BatchKey.CellX;
+		Batch.CellY = BatchKey.CellY;
+		Batch.CellZ = BatchKey.CellZ;
+	}
+
+	SBatch& Batch{ m_vBatches[BatchIndex] };
+	Batch.vMemberIDs.insert(lower_bound(Batch.vMemberIDs.begin(), Batch.vMemberIDs.end(), MemberID), MemberID);
+	Batch.bIsDirty = true;
+	Member.BatchIndex = BatchIndex;
+}
+
+void CStaticBatcher::DetachMember(size_t MemberID)
+{
+	SMember& Member{ m_vMembers[MemberID] };
+	if (Member.BatchIndex == KInvalidID) return;
+
+	SBatch& Batch{ m_vBatches[Member.BatchIndex] };
+	auto it{ lower_bound(Batch.vMemberIDs.begin(), Batch.vMemberIDs.end(), MemberID) };
+	assert(it != Batch.vMemberIDs.end() && *it == MemberID);
+	Batch.vMemberIDs.erase(it);
+	Batch.bIsDirty = true;
+
+	// @important: the emptied batch is kept dirty so that its mesh is cleared in Update() even if it's not reused
+	if (Batch.vMemberIDs.empty())
+	{
+		SBatchKey BatchKey{};
+		BatchKey.Key = Batch.Key;
+		BatchKey.CellX = Batch.CellX;
+		BatchKey.CellY = Batch.CellY;
+		BatchKey.CellZ = Batch.CellZ;
+		m_mapBatchKeyToIndex.erase(BatchKey);
+		m_vFreeBatchIndices.emplace_back(Member.BatchIndex);
+	}
+
+	Member.BatchIndex = KInvalidID;
+}
+
+void CStaticBatcher::RebuildBatch(SBatch& Batch)
+{
+	size_t VertexCount{};
+	size_t TriangleCount{};
+	for (size_t MemberID : Batch.vMemberIDs)
+	{
+		VertexCount += m_vMembers[MemberID].PtrMesh->vVertices.size();
+		TriangleCount += m_vMembers[MemberID].PtrMesh->vTriangles.size();
+	}
+
+	SMesh& Mesh{ Batch.Mesh };
+	Mesh.vVertices.clear();
+	Mesh.vTriangles.clear();
+	Mesh.vVertices.reserve(VertexCount);
+	Mesh.vTriangles.reserve(TriangleCount);
+
+	XMVECTOR Min{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR Max{ XMVectorReplicate(-FLT_MAX) };
+	for (size_t MemberID : Batch.vMemberIDs)
+	{
+		const SMember& Member{ m_vMembers[MemberID] };
+		const uint32_t KVertexOffset{ static_cast<uint32_t>(Mesh.vVertices.size()) };
+
+		// @important: normals are transformed the same way as in VSBase (mul(Normal, World))
+		for (const SVertex3D& Source : Member.PtrMesh->vVertices)
+		{
+			SVertex3D Vertex{ Source };
+			Vertex.Position = XMVectorSetW(XMVector3TransformCoord(Source.Position, Member.World), 1.0f);
+			Vertex.Normal = XMVector3Normalize(XMVector3TransformNormal(Source.Normal, Member.World));
+			Vertex.Tangent = XMVector3Normalize(XMVector3TransformNormal(Source.Tangent, Member.World));
+			Vertex.Bitangent = XMVector3Normalize(XMVector3TransformNormal(Source.Bitangent, Member.World));
+			Mesh.vVertices.emplace_back(Vertex);
+
+			Min = XMVectorMin(Min, Vertex.Position);
+			Max = XMVectorMax(Max, Vertex.Position);
+		}
+
+		for (const STriangle& Triangle : Member.PtrMesh->vTriangles)
+		{
+			Mesh.vTriangles.emplace_back(Triangle.I0 + KVertexOffset, Triangle.I1 + KVertexOffset, Triangle.I2 + KVertexOffset);
+		}
+	}
+
+	Batch.BoundingSphereCenter = XMFLOAT3(0, 0, 0);
+	Batch.BoundingSphereRadius = 0.0f;
+	if (Mesh.vVertices.size())
+	{
+		XMVECTOR Center{ XMVectorSetW((Min + Max) * 0.5f, 1.0f) };
+		float RadiusSquare{};
+		for (const SVertex3D& Vertex : Mesh.vVertices)
+		{
+			RadiusSquare = max(RadiusSquare, XMVectorGetX(XMVector3LengthSq(Vertex.Position - Center)));
+		}
+		XMStoreFloat3(&Batch.BoundingSphereCenter, Center);
+		Batch.BoundingSphereRadius = sqrtf(RadiusSquare);
+	}
+
+	++Batch.Version;
+	Batch.bIsDirty = false;
+}
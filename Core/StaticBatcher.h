@@ -0,0 +1,108 @@
+#pragma once
+
+#include "AssimpLoader.h"
+#include <chrono>
+
+// Merges static meshes that can be drawn with the same states into world-space batches, one per (key, spatial cell)
+// Only the batches whose members have moved (or joined/left) are rebuilt (CPU only, no device access)
+class CStaticBatcher
+{
+public:
+	struct SDesc
+	{
+		SDesc() {}
+
+		float		CellSize{ 64.0f }; // Members are assigned to cells by the center of their world-space bounds
+	};
+
+	struct SBatch
+	{
+		uint64_t		Key{};
+		int32_t			CellX{};
+		int32_t			CellY{};
+		int32_t			CellZ{};
+
+		SMesh			Mesh{}; // World space, empty if the batch has no members
+		XMFLOAT3		BoundingSphereCenter{};
+		float			BoundingSphereRadius{};
+		uint32_t		Version{}; // Increased every time Mesh is rebuilt
+
+		vector<size_t>	vMemberIDs{}; // Sorted
+		bool			bIsDirty{ false };
+	};
+
+	struct SStats
+	{
+		size_t		MemberCount{}; // Draw calls without batching
+		size_t		BatchCount{}; // Draw calls with batching (before culling)
+		size_t		RebuiltBatchCount{}; // This update
+		size_t		RebuiltVertexCount{}; // This update
+		double		ElapsedMilliseconds{}; // This update
+	};
+
+private:
+	struct SBatchKey
+	{
+		uint64_t	Key{};
+		int32_t		CellX{};
+		int32_t		CellY{};
+		int32_t		CellZ{};
+
+		bool operator<(const SBatchKey& b) const
+		{
+			if (Key != b.Key) return Key < b.Key;
+			if (CellX != b.CellX) return CellX < b.CellX;
+			if (CellY != b.CellY) return CellY < b.CellY;
+			return CellZ < b.CellZ;
+		}
+	};
+
+	struct SMember
+	{
+		const SMesh*	PtrMesh{};
+		XMMATRIX		World{};
+		uint64_t		Key{};
+		XMFLOAT3		LocalCenter{}; // Of the mesh's AABB
+		size_t			BatchIndex{ KInvalidID };
+		bool			bIsRegistered{ false };
+	};
+
+public:
+	CStaticBatcher(const SDesc& Desc = SDesc()) : m_Desc{ Desc } {}
+	~CStaticBatcher() {}
+
+public:
+	// @important: the mesh must outlive its membership, and its vertices are assumed not to change
+	// Key: members are merged only if their keys are equal (material, shaders, rendering flags)
+	size_t RegisterMember(const SMesh* const PtrMesh, const XMMATRIX& World, uint64_t Key);
+	void UnregisterMember(size_t MemberID);
+	void Clear();
+
+	// Dirties the member's batches only if World or Key has changed
+	void UpdateMember(size_t MemberID, const XMMATRIX& World, uint64_t Key);
+
+	// Rebuilds the dirty batches
+	void Update();
+
+public:
+	const vector<SBatch>& GetBatches() const { return m_vBatches; }
+	const SStats& GetStats() const { return m_Stats; }
+	bool IsMemberRegistered(size_t MemberID) const;
+
+private:
+	void AssignMember(size_t MemberID);
+	void DetachMember(size_t MemberID);
+	void RebuildBatch(SBatch& Batch);
+
+public:
+	static constexpr size_t KInvalidID{ SIZE_MAX };
+
+private:
+	SDesc							m_Desc{};
+	vector<SMember>					m_vMembers{};
+	vector<size_t>					m_vFreeMemberIDs{};
+	vector<SBatch>					m_vBatches{};
+	vector<size_t>					m_vFreeBatchIndices{};
+	map<SBatchKey, size_t>			m_mapBatchKeyToIndex{};
+	SStats							m_Stats{};
+};
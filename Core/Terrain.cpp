@@ -37,7 +37,8 @@ void CTerrain::Create(const XMFLOAT2& TerrainSize, const CMaterial& Material, fl
 	CreateTerrainObject3D(vMaterials);
 
 	m_Object2DTextureRepresentation.release();
-	m_Object2DTextureRepresentation = make_unique<CObject2D>("TextureRepresentation", m_PtrDevice, m_PtrDeviceContext);
+	m_Object2DTextureRepresentation = make_unique<CObject2D>("TextureRepresentation", m_PtrRenderDevice,
+		&m_PtrGame->GetTransientUploadRing());
 	m_Object2DTextureRepresentation->CreateDynamic(Generate2DRectangle(XMFLOAT2(600, 480)));
 
 	CreateHeightMapTexture(true);
@@ -98,18 +99,33 @@ void CTerrain::Load(const string& FileName)
 
 	// 4B (uint32_t) Masking texture raw data size
 	READ_BYTES(4);
-	m_MaskingTextureRawData.resize(READ_BYTES_TO_UINT32);
+	const uint32_t KMaskingTexelCount{ READ_BYTES_TO_UINT32 };
 
-	// Masking texture raw data
-	for (SPixel32UInt& Pixel : m_MaskingTextureRawData)
+	m_MaskingTextureSize.x = m_Size.x * m_MaskingTextureDetail;
+	m_MaskingTextureSize.y = m_Size.y * m_MaskingTextureDetail;
+	m_Masking.Create(static_cast<uint32_t>(m_MaskingTextureSize.x), static_cast<uint32_t>(m_MaskingTextureSize.y));
+	assert(KMaskingTexelCount == m_Masking.GetWidth() * m_Masking.GetHeight());
+
+	// Masking texture raw data (written to the sparse masking row by row, so that only its non-zero tiles are allocated)
+	vector<SPixel32UInt> vMaskingRow(m_Masking.GetWidth());
+	for (uint32_t V = 0; V < m_Masking.GetHeight(); ++V)
 	{
-		// 4B (uint8_t * 4) RGBA (UNORM)
-		READ_BYTES(4);
+		for (SPixel32UInt& Pixel : vMaskingRow)
+		{
+			// 4B (uint8_t * 4) RGBA (UNORM)
+			READ_BYTES(4);
 
-		Pixel.R = ReadBytes[0];
-		Pixel.G = ReadBytes[1];
-		Pixel.B = ReadBytes[2];
-		Pixel.A = ReadBytes[3];
+			Pixel.R = ReadBytes[0];
+			Pixel.G = ReadBytes[1];
+			Pixel.B = ReadBytes[2];
+			Pixel.A = ReadBytes[3];
+		}
+
+		CMipGenerator::SRect Row{};
+		Row.Top = V;
+		Row.Right = m_Masking.GetWidth();
+		Row.Bottom = V + 1;
+		m_Masking.WriteRect(Row, &vMaskingRow[0], m_Masking.GetWidth());
 	}
 
 	// 4B (uint32_t) HeightMap texture raw data size
@@ -141,7 +157,8 @@ void CTerrain::Load(const string& FileName)
 	CreateTerrainObject3D(Model.vMaterials);
 
 	m_Object2DTextureRepresentation.release();
-	m_Object2DTextureRepresentation = make_unique<CObject2D>("TextureRepresentation", m_PtrDevice, m_PtrDeviceContext);
+	m_Object2DTextureRepresentation = make_unique<CObject2D>("TextureRepresentation", m_PtrRenderDevice,
+		&m_PtrGame->GetTransientUploadRing());
 	m_Object2DTextureRepresentation->CreateDynamic(Generate2DRectangle(XMFLOAT2(600, 480)));
 
 	CreateHeightMapTexture(false);
@@ -193,16 +210,26 @@ void CTerrain::Save(const string& FileName)
 	WRITE_FLOAT_TO_BYTES(m_MaskingTextureDetail);
 
 	// 4B (uint32_t) Masking texture raw data size
-	WRITE_UINT32_TO_BYTES(m_MaskingTextureRawData.size());
+	WRITE_UINT32_TO_BYTES(m_Masking.GetWidth() * m_Masking.GetHeight());
 
-	// Masking texture raw data
-	for (const SPixel32UInt& Pixel : m_MaskingTextureRawData)
+	// Masking texture raw data (unallocated tiles are written as 0)
+	vector<SPixel32UInt> vMaskingRow(m_Masking.GetWidth());
+	for (uint32_t V = 0; V < m_Masking.GetHeight(); ++V)
 	{
-		// 4B (uint8_t * 4) RGBA (UNORM)
-		ofs.write((const char*)&Pixel.R, 1);
-		ofs.write((const char*)&Pixel.G, 1);
-		ofs.write((const char*)&Pixel.B, 1);
-		ofs.write((const char*)&Pixel.A, 1);
+		CMipGenerator::SRect Row{};
+		Row.Top = V;
+		Row.Right = m_Masking.GetWidth();
+		Row.Bottom = V + 1;
+		m_Masking.ReadRect(Row, &vMaskingRow[0], m_Masking.GetWidth());
+
+		for (const SPixel32UInt& Pixel : vMaskingRow)
+		{
+			// 4B (uint8_t * 4) RGBA (UNORM)
+			ofs.write((const char*)&Pixel.R, 1);
+			ofs.write((const char*)&Pixel.G, 1);
+			ofs.write((const char*)&Pixel.B, 1);
+			ofs.write((const char*)&Pixel.A, 1);
+		}
 	}
 
 	// 4B (uint32_t) HeightMap texture raw data size
@@ -223,6 +250,26 @@ void CTerrain::Save(const string& FileName)
 	ofs.close();
 }
 
+void CTerrain::Generate(const CTerrainGenerator::SDesc& Desc)
+{
+	if (!m_Object3DTerrain) return;
+
+	CTerrainGenerator::SStats Stats{};
+	if (!CTerrainGenerator::GenerateHeights(Desc, static_cast<uint32_t>(m_HeightMapTextureSize.x), static_cast<uint32_t>(m_HeightMapTextureSize.y),
+		m_HeightMapTextureRawData, &Stats)) return;
+	UpdateHeightMapTexture();
+
+	OutputDebugString(("- Terrain generated. [" + to_string(Stats.TexelCount) + "] texels in [" + to_string(Stats.TileCount) + "] tiles.\n").c_str());
+
+	if (Desc.vMaskingRules.empty()) return;
+
+	CTerrainGenerator::GenerateMasking(Desc, GetSamplerSource(), m_MaskingTextureDetail, m_Masking);
+	UpdateMaskingTexture();
+
+	m_LayerAnalyzer.Analyze(m_Masking);
+	GroupLayerTileDraws();
+}
+
 void CTerrain::CreateTerrainObject3D(vector<CMaterial>& vMaterials)
 {
 	SModel Model{};
@@ -230,11 +277,12 @@ void CTerrain::CreateTerrainObject3D(vector<CMaterial>& vMaterials)
 
 	Model.vMeshes.clear();
 	Model.vMeshes.emplace_back(GenerateTerrainBase(m_Size));
+	CreateLayerTiles(Model.vMeshes[0]);
 	Model.vMaterials = vMaterials;
 	Model.bUseMultipleTexturesInSingleMesh = true; // @important
 
 	m_Object3DTerrain.release();
-	m_Object3DTerrain = make_unique<CObject3D>("Terrain", m_PtrDevice, m_PtrDeviceContext, m_PtrGame);
+	m_Object3DTerrain = make_unique<CObject3D>("Terrain", m_PtrRenderDevice, m_PtrGame);
 	m_Object3DTerrain->Create(Model);
 	m_Object3DTerrain->ShouldTessellate(true); // @important
 }
@@ -242,16 +290,31 @@ void CTerrain::CreateTerrainObject3D(vector<CMaterial>& vMaterials)
 void CTerrain::CreateHeightMapTexture(bool bShouldClear)
 {
 	m_HeightMapTexture.release();
-	m_HeightMapTexture = make_unique<CMaterial::CTexture>(m_PtrDevice, m_PtrDeviceContext);
+	m_HeightMapTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
 
 	m_HeightMapTextureSize = m_Size;
 	m_HeightMapTextureSize.x += 1.0f;
 	m_HeightMapTextureSize.y += 1.0f;
-	m_HeightMapTexture->CreateBlankTexture(DXGI_FORMAT_R8_UNORM, m_HeightMapTextureSize);
+	m_HeightMapTexture->CreateBlankTexture(DXGI_FORMAT_R8_UNORM, m_HeightMapTextureSize,
+		CMipGenerator::GetMipCount(static_cast<uint32_t>(m_HeightMapTextureSize.x), static_cast<uint32_t>(m_HeightMapTextureSize.y)));
 	m_HeightMapTexture->SetSlot(0);
 	m_HeightMapTexture->SetShaderType(EShaderType::VertexShader);
 	m_HeightMapTexture->Use();
 
+	m_NormalMapTexture.release();
+	m_NormalMapTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	m_NormalMapTexture->CreateBlankTexture(DXGI_FORMAT_R8G8_SNORM, m_HeightMapTextureSize, 1, true);
+	m_NormalMapTexture->SetSlot(KNormalMapTextureSlot);
+	m_NormalMapTexture->SetShaderType(EShaderType::VertexShader);
+	m_NormalMapTextureRawData.clear();
+
+	m_PatchErrorTexture.release();
+	m_PatchErrorTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	m_PatchErrorTexture->CreateBlankTexture(DXGI_FORMAT_R32_FLOAT, m_HeightMapTextureSize, 1, true);
+	m_PatchErrorTexture->SetSlot(KPatchErrorTextureSlot);
+	m_PatchErrorTexture->SetShaderType(EShaderType::HullShader);
+	m_vPatchErrorRawData.clear();
+
 	if (bShouldClear)
 	{
 		m_HeightMapTextureRawData.clear();
@@ -269,20 +332,46 @@ void CTerrain::CreateMaskingTexture(bool bShouldClear)
 {
 	m_MaskingTextureSize.x = m_Size.x * m_MaskingTextureDetail;
 	m_MaskingTextureSize.y = m_Size.y * m_MaskingTextureDetail;
+	const uint32_t KWidth{ static_cast<uint32_t>(m_MaskingTextureSize.x) };
+	const uint32_t KHeight{ static_cast<uint32_t>(m_MaskingTextureSize.y) };
+
+	// Every tile starts unallocated (0)
+	if (bShouldClear) m_Masking.Create(KWidth, KHeight);
+	assert(m_Masking.GetWidth() == KWidth && m_Masking.GetHeight() == KHeight);
+
+	m_MaskingIndirectionTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	m_MaskingIndirectionTexture->CreateBlankTexture(DXGI_FORMAT_R32_UINT,
+		XMFLOAT2(static_cast<float>(m_Masking.GetTileCountX()), static_cast<float>(m_Masking.GetTileCountY())), 1, true);
+	m_MaskingIndirectionTexture->SetSlot(KMaskingIndirectionTextureSlot);
+
+	const uint32_t KCoarseWidth{ (KWidth + KMaskingCoarseFactor - 1) / KMaskingCoarseFactor };
+	const uint32_t KCoarseHeight{ (KHeight + KMaskingCoarseFactor - 1) / KMaskingCoarseFactor };
+	m_MaskingCoarseTextureSize = XMFLOAT2(static_cast<float>(KCoarseWidth), static_cast<float>(KCoarseHeight));
+	m_MaskingCoarseTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	m_MaskingCoarseTexture->CreateBlankTexture(DXGI_FORMAT_R8G8B8A8_UNORM, m_MaskingCoarseTextureSize,
+		CMipGenerator::GetMipCount(KCoarseWidth, KCoarseHeight), true);
+	m_MaskingCoarseTexture->SetSlot(KMaskingCoarseTextureSlot);
+	m_MaskingCoarseTextureRawData.clear();
+	m_MaskingCoarseTextureRawData.resize(static_cast<size_t>(KCoarseWidth) * KCoarseHeight);
+
+	// The atlas is created for the slots that UpdateMaskingTexture() hands out
+	m_MaskingAtlasTexture.reset();
+	m_MaskingAtlasSlotCount = 0;
+	UpdateMaskingTexture();
 
-	m_MaskingTexture.release();
-	m_MaskingTexture = make_unique<CMaterial::CTexture>(m_PtrDevice, m_PtrDeviceContext);
-	m_MaskingTexture->CreateBlankTexture(DXGI_FORMAT_R8G8B8A8_UNORM, m_MaskingTextureSize);
-	m_MaskingTexture->SetSlot(KMaskingTextureSlot);
-	m_MaskingTexture->Use();
+	const SMaskingStats KMaskingStats{ GetMaskingStats() };
+	OutputDebugString(("- Terrain masking stored sparsely. [" + to_string(KMaskingStats.CPU.AllocatedTileCount) + " / " +
+		to_string(KMaskingStats.CPU.TileCount) + "] tiles allocated, [" + to_string(KMaskingStats.CPU.MemoryBytes / 1024) + "] KB (dense: [" +
+		to_string(KMaskingStats.CPU.DenseMemoryBytes / 1024) + "] KB), [" + to_string(KMaskingStats.AtlasUsedSlotCount) + " / " +
+		to_string(KMaskingStats.AtlasSlotCount) + "] atlas slots, [" + to_string(KMaskingStats.GPUBytes / 1024) + "] KB on the GPU (dense: [" +
+		to_string(KMaskingStats.DenseGPUBytes / 1024) + "] KB).\n").c_str());
 
-	if (bShouldClear)
-	{
-		m_MaskingTextureRawData.clear();
-		m_MaskingTextureRawData.resize(static_cast<size_t>(m_MaskingTextureSize.x) * static_cast<size_t>(m_MaskingTextureSize.y));
-	}
+	m_LayerAnalyzer.Analyze(m_Masking);
+	GroupLayerTileDraws();
 
-	UpdateMaskingTexture();
+	const CTerrainLayerAnalyzer::SStats& LayerStats{ m_LayerAnalyzer.GetStats() };
+	OutputDebugString(("- Terrain layers analyzed. [" + to_string(LayerStats.TileCount) + "] tiles, [" +
+		to_string(LayerStats.AverageLayerCount) + "] layers sampled per tile on average (of " + to_string(KMaterialMaxCount) + ").\n").c_str());
 
 	XMMATRIX Translation{ XMMatrixTranslation(m_Size.x / 2.0f, 0, m_Size.y / 2.0f) };
 	XMMATRIX Scaling{ XMMatrixScaling(1 / m_Size.x, 1.0f, 1 / m_Size.y) };
@@ -295,26 +384,88 @@ void CTerrain::CreateWater()
 	constexpr XMVECTOR KWaterColor{ 0.0f, 0.5f, 0.625f, 0.8125f };
 
 	m_Object3DWater.release();
-	m_Object3DWater = make_unique<CObject3D>("Water", m_PtrDevice, m_PtrDeviceContext, m_PtrGame);
+	m_Object3DWater = make_unique<CObject3D>("Water", m_PtrRenderDevice, m_PtrGame);
 
 	SMesh WaterMesh{ GenerateTerrainBase(m_Size, false, KWaterColor) };
 	m_Object3DWater->Create(WaterMesh);
 	m_Object3DWater->ShouldTessellate(true);
 
 	m_WaterNormalTexture.release();
-	m_WaterNormalTexture = make_unique<CMaterial::CTexture>(m_PtrDevice, m_PtrDeviceContext);
+	m_WaterNormalTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
 	m_WaterNormalTexture->CreateTextureFromFile("Asset\\water_normal.jpg", false);
 	m_WaterNormalTexture->SetSlot(0);
 	m_WaterNormalTexture->Use();
 
 	m_WaterDisplacementTexture.release();
-	m_WaterDisplacementTexture = make_unique<CMaterial::CTexture>(m_PtrDevice, m_PtrDeviceContext);
+	m_WaterDisplacementTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
 	m_WaterDisplacementTexture->CreateTextureFromFile("Asset\\water_displacement.jpg", false);
 	m_WaterDisplacementTexture->SetSlot(0);
 	m_WaterDisplacementTexture->SetShaderType(EShaderType::DomainShader);
 	m_WaterDisplacementTexture->Use();
 }
 
+void CTerrain::CreateLayerTiles(SMesh& Mesh)
+{
+	// A triangle is drawn with the tile that its centroid is in, so the tiles' margin covers the rest of the triangle (1 unit),
+	// the bilinear filter's footprint and the bulge of the tessellated patch; the analyzer widens it to the coarsest sampled mip's footprint
+	const uint32_t KMargin{ static_cast<uint32_t>(ceilf(m_MaskingTextureDetail)) + 2 };
+	m_LayerAnalyzer.Create(static_cast<uint32_t>(m_Size.x * m_MaskingTextureDetail), static_cast<uint32_t>(m_Size.y * m_MaskingTextureDetail),
+		KLayerTileSize, KMargin, KMaskingMaxMip + 1);
+
+	const size_t KTileCount{ m_LayerAnalyzer.GetTileCount() };
+	vector<size_t> vTriangleTileIndices{};
+	vector<size_t> vTileOffsets(KTileCount + 1);
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		const XMVECTOR KCentroid{ (Mesh.vVertices[Triangle.I0].Position + Mesh.vVertices[Triangle.I1].Position +
+			Mesh.vVertices[Triangle.I2].Position) / 3.0f };
+		const float KU{ (+m_Size.x / 2.0f + XMVectorGetX(KCentroid)) * m_MaskingTextureDetail };
+		const float KV{ (+m_Size.y / 2.0f - XMVectorGetZ(KCentroid)) * m_MaskingTextureDetail };
+
+		vTriangleTileIndices.emplace_back(m_LayerAnalyzer.GetTileIndex(KU, KV));
+		++vTileOffsets[vTriangleTileIndices.back() + 1];
+	}
+
+	// Counting sort by tile (stable, so each tile keeps the optimized triangle order)
+	m_vLayerTileDraws.clear();
+	m_vLayerTileDraws.resize(KTileCount);
+	for (size_t iTile = 0; iTile < KTileCount; ++iTile)
+	{
+		m_vLayerTileDraws[iTile].IndexCountPerInstance = static_cast<uint32_t>(vTileOffsets[iTile + 1] * 3);
+		m_vLayerTileDraws[iTile].StartIndexLocation = static_cast<uint32_t>(vTileOffsets[iTile] * 3);
+
+		vTileOffsets[iTile + 1] += vTileOffsets[iTile];
+	}
+
+	vector<STriangle> vSortedTriangles(Mesh.vTriangles.size());
+	for (size_t iTriangle = 0; iTriangle < Mesh.vTriangles.size(); ++iTriangle)
+	{
+		vSortedTriangles[vTileOffsets[vTriangleTileIndices[iTriangle]]++] = Mesh.vTriangles[iTriangle];
+	}
+	Mesh.vTriangles = std::move(vSortedTriangles);
+}
+
+void CTerrain::GroupLayerTileDraws()
+{
+	m_vLayerVariantDraws.clear();
+	m_vLayerVariantDraws.resize(KLayerVariantCount);
+	for (size_t iTile = 0; iTile < m_vLayerTileDraws.size(); ++iTile)
+	{
+		const SDrawIndexedArgs& TileDraw{ m_vLayerTileDraws[iTile] };
+		if (TileDraw.IndexCountPerInstance == 0) continue;
+
+		vector<SDrawIndexedArgs>& vDraws{ m_vLayerVariantDraws[m_LayerAnalyzer.GetTileLayerMask(iTile)] };
+		if (!vDraws.empty() && vDraws.back().StartIndexLocation + vDraws.back().IndexCountPerInstance == TileDraw.StartIndexLocation)
+		{
+			vDraws.back().IndexCountPerInstance += TileDraw.IndexCountPerInstance;
+		}
+		else
+		{
+			vDraws.emplace_back(TileDraw);
+		}
+	}
+}
+
 void CTerrain::AddMaterial(const CMaterial& Material)
 {
 	assert(m_Object3DTerrain);
@@ -363,31 +514,66 @@ void CTerrain::Select(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingR
 
 void CTerrain::UpdateSelection(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection)
 {
-	XMVECTOR PlaneT{};
-	if (IntersectRayPlane(PickingRayOrigin, PickingRayDirection, XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0), &PlaneT))
+	XMVECTOR PickedPoint{};
+	const bool bIsPicked{ (m_Streamer) ? PickStreamedTiles(PickingRayOrigin, PickingRayDirection, PickedPoint) :
+		PickHeightField(PickingRayOrigin, PickingRayDirection, PickedPoint) };
+	if (!bIsPicked)
 	{
-		const XMFLOAT2 KHalfSize{ m_Size.x / 2.0f, m_Size.y / 2.0f };
-		const XMVECTOR KPointOnPlane{ PickingRayOrigin + PickingRayDirection * PlaneT };
+		// Off the terrain, the selection follows the y = 0 plane
+		XMVECTOR PlaneT{};
+		if (!IntersectRayPlane(PickingRayOrigin, PickingRayDirection, XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0), &PlaneT)) return;
+
+		PickedPoint = PickingRayOrigin + PickingRayDirection * PlaneT;
+	}
+
+	const XMFLOAT2 KHalfSize{ m_Size.x / 2.0f, m_Size.y / 2.0f };
 
-		m_cbPSTerrainSelectionData.AnaloguePosition.x = XMVectorGetX(KPointOnPlane);
-		m_cbPSTerrainSelectionData.AnaloguePosition.y = XMVectorGetZ(KPointOnPlane);
+	m_cbPSTerrainSelectionData.AnaloguePosition.x = XMVectorGetX(PickedPoint);
+	m_cbPSTerrainSelectionData.AnaloguePosition.y = XMVectorGetZ(PickedPoint);
 
-		m_cbPSTerrainSelectionData.DigitalPosition.x = XMVectorGetX(KPointOnPlane);
-		if (m_cbPSTerrainSelectionData.DigitalPosition.x > 0) m_cbPSTerrainSelectionData.DigitalPosition.x += 0.5;
-		if (m_cbPSTerrainSelectionData.DigitalPosition.x < 0) m_cbPSTerrainSelectionData.DigitalPosition.x -= 0.5;
-		m_cbPSTerrainSelectionData.DigitalPosition.x = float((int)m_cbPSTerrainSelectionData.DigitalPosition.x);
+	m_cbPSTerrainSelectionData.DigitalPosition.x = XMVectorGetX(PickedPoint);
+	if (m_cbPSTerrainSelectionData.DigitalPosition.x > 0) m_cbPSTerrainSelectionData.DigitalPosition.x += 0.5;
+	if (m_cbPSTerrainSelectionData.DigitalPosition.x < 0) m_cbPSTerrainSelectionData.DigitalPosition.x -= 0.5;
+	m_cbPSTerrainSelectionData.DigitalPosition.x = float((int)m_cbPSTerrainSelectionData.DigitalPosition.x);
+
+	m_cbPSTerrainSelectionData.DigitalPosition.y = XMVectorGetZ(PickedPoint);
+	if (m_cbPSTerrainSelectionData.DigitalPosition.y > 0) m_cbPSTerrainSelectionData.DigitalPosition.y += 0.5;
+	if (m_cbPSTerrainSelectionData.DigitalPosition.y < 0) m_cbPSTerrainSelectionData.DigitalPosition.y -= 0.5;
+	m_cbPSTerrainSelectionData.DigitalPosition.y = float((int)m_cbPSTerrainSelectionData.DigitalPosition.y);
+
+	// A streamed terrain has no bounds
+	if (!m_Streamer)
+	{
 		m_cbPSTerrainSelectionData.DigitalPosition.x = min(m_cbPSTerrainSelectionData.DigitalPosition.x, +KHalfSize.x);
 		m_cbPSTerrainSelectionData.DigitalPosition.x = max(m_cbPSTerrainSelectionData.DigitalPosition.x, -KHalfSize.x);
-
-		m_cbPSTerrainSelectionData.DigitalPosition.y = XMVectorGetZ(KPointOnPlane);
-		if (m_cbPSTerrainSelectionData.DigitalPosition.y > 0) m_cbPSTerrainSelectionData.DigitalPosition.y += 0.5;
-		if (m_cbPSTerrainSelectionData.DigitalPosition.y < 0) m_cbPSTerrainSelectionData.DigitalPosition.y -= 0.5;
-		m_cbPSTerrainSelectionData.DigitalPosition.y = float((int)m_cbPSTerrainSelectionData.DigitalPosition.y);
 		m_cbPSTerrainSelectionData.DigitalPosition.y = min(m_cbPSTerrainSelectionData.DigitalPosition.y, +KHalfSize.y);
 		m_cbPSTerrainSelectionData.DigitalPosition.y = max(m_cbPSTerrainSelectionData.DigitalPosition.y, -KHalfSize.y);
-
-		m_PtrGame->UpdatePSTerrainSelection(m_cbPSTerrainSelectionData);
 	}
+
+	m_PtrGame->UpdatePSTerrainSelection(m_cbPSTerrainSelectionData);
+}
+
+bool CTerrain::PickHeightField(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection, XMVECTOR& OutPoint) const
+{
+	if (m_HeightMapTextureRawData.empty()) return false;
+
+	// World space to height field space (texel (0, 0) is at (-SizeX / 2, SizeZ / 2), +V is -Z)
+	const float KStepsPerUnit{ 255.0f / m_cbTerrainData.TerrainHeightRange };
+	const XMFLOAT3 KOrigin{
+		XMVectorGetX(PickingRayOrigin) + m_Size.x / 2.0f,
+		(XMVectorGetY(PickingRayOrigin) + m_cbTerrainData.TerrainHeightRange / 2.0f) * KStepsPerUnit,
+		m_Size.y / 2.0f - XMVectorGetZ(PickingRayOrigin) };
+	const XMFLOAT3 KDirection{
+		XMVectorGetX(PickingRayDirection),
+		XMVectorGetY(PickingRayDirection) * KStepsPerUnit,
+		-XMVectorGetZ(PickingRayDirection) };
+
+	// The mapping is affine, so T is the same in both spaces
+	CHeightFieldRayCaster::SHit Hit{};
+	if (!m_HeightFieldRayCaster.CastRay(&m_HeightMapTextureRawData[0], KOrigin, KDirection, Hit)) return false;
+
+	OutPoint = PickingRayOrigin + PickingRayDirection * Hit.T;
+	return true;
 }
 
 void CTerrain::ReleaseSelection()
@@ -413,40 +599,67 @@ void CTerrain::ReleaseSelection()
 void CTerrain::UpdateHeights(bool bIsLeftButton)
 {
 	if (!m_Object3DTerrain) return;
+	if (m_Streamer)
+	{
+		UpdateStreamedHeights(bIsLeftButton);
+		return;
+	}
+	if (m_eEditMode == EEditMode::Brush)
+	{
+		ApplyBrush(bIsLeftButton);
+		return;
+	}
 
 	int TerrainSizeX{ (int)m_Size.x };
 	int TerrainSizeZ{ (int)m_Size.y };
 	int CenterX{ (int)m_cbPSTerrainSelectionData.DigitalPosition.x + TerrainSizeX / 2 };
 	int CenterZ{ (int)(-m_cbPSTerrainSelectionData.DigitalPosition.y) + TerrainSizeZ / 2 };
 
+	// Only the texels inside the selection can change
+	CMipGenerator::SRect DirtyRect{};
 	int SelectionSize{ (int)(m_cbPSTerrainSelectionData.SelectionHalfSize * 2.0f) };
 	if (SelectionSize == 1)
 	{
 		size_t iPixel{ CenterZ * (size_t)m_HeightMapTextureSize.x + CenterX };
 		iPixel = min(iPixel, (size_t)((double)m_HeightMapTextureSize.x * m_HeightMapTextureSize.y) - 1);
 
-		UpdateHeight(iPixel, bIsLeftButton);
+		UpdateHeight(m_HeightMapTextureRawData[iPixel], bIsLeftButton);
+
+		DirtyRect.Left = static_cast<uint32_t>(iPixel % (size_t)m_HeightMapTextureSize.x);
+		DirtyRect.Top = static_cast<uint32_t>(iPixel / (size_t)m_HeightMapTextureSize.x);
+		DirtyRect.Right = DirtyRect.Left + 1;
+		DirtyRect.Bottom = DirtyRect.Top + 1;
 	}
 	else
 	{
-		for (int X = (int)(CenterX - m_cbPSTerrainSelectionData.SelectionHalfSize); X <= (int)(CenterX + m_cbPSTerrainSelectionData.SelectionHalfSize); ++X)
+		const int KMinX{ (int)(CenterX - m_cbPSTerrainSelectionData.SelectionHalfSize) };
+		const int KMaxX{ (int)(CenterX + m_cbPSTerrainSelectionData.SelectionHalfSize) };
+		const int KMinZ{ (int)(CenterZ - m_cbPSTerrainSelectionData.SelectionHalfSize) };
+		const int KMaxZ{ (int)(CenterZ + m_cbPSTerrainSelectionData.SelectionHalfSize) };
+		for (int X = KMinX; X <= KMaxX; ++X)
 		{
-			for (int Z = (int)(CenterZ - m_cbPSTerrainSelectionData.SelectionHalfSize); Z <= (int)(CenterZ + m_cbPSTerrainSelectionData.SelectionHalfSize); ++Z)
+			for (int Z = KMinZ; Z <= KMaxZ; ++Z)
 			{
 				if (X < 0 || Z < 0) continue;
 				if (X > TerrainSizeX || Z > TerrainSizeZ) continue;
 
 				size_t iPixel{ Z * (size_t)m_HeightMapTextureSize.x + X };
 
-				UpdateHeight(iPixel, bIsLeftButton);
+				UpdateHeight(m_HeightMapTextureRawData[iPixel], bIsLeftButton);
 			}
 		}
+
+		DirtyRect.Left = static_cast<uint32_t>(min(max(KMinX, 0), TerrainSizeX + 1));
+		DirtyRect.Top = static_cast<uint32_t>(min(max(KMinZ, 0), TerrainSizeZ + 1));
+		DirtyRect.Right = static_cast<uint32_t>(min(max(KMaxX + 1, 0), TerrainSizeX + 1));
+		DirtyRect.Bottom = static_cast<uint32_t>(min(max(KMaxZ + 1, 0), TerrainSizeZ + 1));
 	}
+	if (DirtyRect.IsEmpty()) return;
 
-	UpdateHeightMapTexture();
+	UpdateHeightMapTexture(DirtyRect);
 }
 
-void CTerrain::UpdateHeight(size_t iPixel, bool bIsLeftButton)
+void CTerrain::UpdateHeight(SPixel8UInt& Pixel, bool bIsLeftButton)
 {
 	switch (m_eEditMode)
 	{
@@ -455,21 +668,21 @@ void CTerrain::UpdateHeight(size_t iPixel, bool bIsLeftButton)
 			float NewY{ (m_SetHeightValue + KHeightRangeHalf) / KHeightRange };
 			NewY = min(max(NewY, 0.0f), 1.0f);
 
-			m_HeightMapTextureRawData[iPixel].R = static_cast<uint8_t>(NewY * 255);
+			Pixel.R = static_cast<uint8_t>(NewY * 255);
 		} break;
 		case EEditMode::DeltaHeight:
 		{
 			if (bIsLeftButton)
 			{
-				int NewY{ m_HeightMapTextureRawData[iPixel].R + 1 };
+				int NewY{ Pixel.R + 1 };
 				NewY = min(NewY, 255);
-				m_HeightMapTextureRawData[iPixel].R = static_cast<uint8_t>(NewY);
+				Pixel.R = static_cast<uint8_t>(NewY);
 			}
 			else
 			{
-				int NewY{ m_HeightMapTextureRawData[iPixel].R - 1 };
+				int NewY{ Pixel.R - 1 };
 				NewY = max(NewY, 0);
-				m_HeightMapTextureRawData[iPixel].R = static_cast<uint8_t>(NewY);
+				Pixel.R = static_cast<uint8_t>(NewY);
 			}
 		} break;
 		default:
@@ -479,83 +692,441 @@ void CTerrain::UpdateHeight(size_t iPixel, bool bIsLeftButton)
 	}
 }
 
+void CTerrain::ApplyBrush(bool bIsLeftButton)
+{
+	// Height map texel (U, V) is at world (U - SizeX / 2, SizeZ / 2 - V)
+	const float KCenterU{ m_cbPSTerrainSelectionData.AnaloguePosition.x + m_Size.x / 2.0f };
+	const float KCenterV{ m_Size.y / 2.0f - m_cbPSTerrainSelectionData.AnaloguePosition.y };
+	const uint32_t KWidth{ static_cast<uint32_t>(m_HeightMapTextureSize.x) };
+	const uint32_t KHeight{ static_cast<uint32_t>(m_HeightMapTextureSize.y) };
+
+	CTerrainBrush::SDesc Desc{ m_BrushDesc };
+	if (Desc.eType == CTerrainBrush::EType::Flatten)
+	{
+		if (bIsLeftButton)
+		{
+			Desc.PlaneHeight = min(max((m_SetHeightValue + KHeightRangeHalf) / KHeightRange, 0.0f), 1.0f) * 255.0f;
+		}
+		else
+		{
+			// Flattens to the height under the brush center
+			Desc.PlaneHeight = ((GetHeight(m_cbPSTerrainSelectionData.AnaloguePosition.x, m_cbPSTerrainSelectionData.AnaloguePosition.y) +
+				m_cbTerrainData.TerrainHeightRange / 2.0f) / m_cbTerrainData.TerrainHeightRange) * 255.0f;
+		}
+	}
+	if (Desc.eType == CTerrainBrush::EType::Noise && !bIsLeftButton) Desc.NoiseAmplitude = -Desc.NoiseAmplitude;
+
+	CMipGenerator::SRect DirtyRect{};
+	CTerrainBrush::Apply(&m_HeightMapTextureRawData[0], KWidth, KHeight, KCenterU, KCenterV, Desc, DirtyRect);
+	if (DirtyRect.IsEmpty()) return;
+
+	UpdateHeightMapTexture(DirtyRect);
+}
+
 void CTerrain::UpdateHeightMapTexture()
 {
+	const uint32_t KWidth{ static_cast<uint32_t>(m_HeightMapTextureSize.x) };
+	const uint32_t KHeight{ static_cast<uint32_t>(m_HeightMapTextureSize.y) };
+
 	m_HeightMapTexture->UpdateTextureRawData(&m_HeightMapTextureRawData[0]);
+	m_HeightFieldRayCaster.Create(&m_HeightMapTextureRawData[0], KWidth, KHeight);
+
+	CMipGenerator::GenerateMipChain(&m_HeightMapTextureRawData[0], KWidth, KHeight, CMipGenerator::SDesc(CMipGenerator::EFilter::Box),
+		m_vHeightMapTextureMipChain);
+	for (size_t iMip = 0; iMip < m_vHeightMapTextureMipChain.size(); ++iMip)
+	{
+		const auto& Level{ m_vHeightMapTextureMipChain[iMip] };
+		m_HeightMapTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width);
+	}
+
+	// One step of the height map is (height range / 255) and its texels are 1 unit apart
+	CNormalMapGenerator::GenerateNormalMap(&m_HeightMapTextureRawData[0], KWidth, KHeight,
+		CNormalMapGenerator::SDesc(m_cbTerrainData.TerrainHeightRange / 255.0f), m_NormalMapTextureRawData);
+	m_NormalMapTexture->UpdateTextureRawData(&m_NormalMapTextureRawData[0], 0, KWidth);
+
+	CPatchErrorEstimator::GenerateErrorMap(&m_HeightMapTextureRawData[0], KWidth, KHeight,
+		CPatchErrorEstimator::SDesc(m_cbTerrainData.TerrainHeightRange / 255.0f), m_vPatchErrorRawData);
+	m_PatchErrorTexture->UpdateTextureRawData(reinterpret_cast<const SPixel32UInt*>(&m_vPatchErrorRawData[0]), 0, KWidth);
+}
+
+void CTerrain::UpdateHeightMapTexture(const CMipGenerator::SRect& DirtyRect)
+{
+	const uint32_t KWidth{ static_cast<uint32_t>(m_HeightMapTextureSize.x) };
+	const uint32_t KHeight{ static_cast<uint32_t>(m_HeightMapTextureSize.y) };
+
+	D3D11_BOX Box{ DirtyRect.Left, DirtyRect.Top, 0, DirtyRect.Right, DirtyRect.Bottom, 1 };
+	m_HeightMapTexture->UpdateTextureRawData(&m_HeightMapTextureRawData[0], 0, KWidth, &Box);
+	m_HeightFieldRayCaster.Update(&m_HeightMapTextureRawData[0], DirtyRect);
+
+	vector<CMipGenerator::SRect> vDirtyRects{};
+	CMipGenerator::UpdateMipChain(&m_HeightMapTextureRawData[0], KWidth, KHeight, CMipGenerator::SDesc(CMipGenerator::EFilter::Box),
+		DirtyRect, m_vHeightMapTextureMipChain, vDirtyRects);
+	for (size_t iMip = 0; iMip < m_vHeightMapTextureMipChain.size(); ++iMip)
+	{
+		const CMipGenerator::SRect& Rect{ vDirtyRects[iMip] };
+		if (Rect.IsEmpty()) continue;
+
+		const auto& Level{ m_vHeightMapTextureMipChain[iMip] };
+		D3D11_BOX MipBox{ Rect.Left, Rect.Top, 0, Rect.Right, Rect.Bottom, 1 };
+		m_HeightMapTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width, &MipBox);
+	}
+
+	// The normals around the dirty texels (their Sobel taps) are uploaded along with the heights
+	CMipGenerator::SRect NormalRect{};
+	CNormalMapGenerator::UpdateNormalMap(&m_HeightMapTextureRawData[0], KWidth, KHeight,
+		CNormalMapGenerator::SDesc(m_cbTerrainData.TerrainHeightRange / 255.0f), DirtyRect, m_NormalMapTextureRawData, NormalRect);
+	if (!NormalRect.IsEmpty())
+	{
+		D3D11_BOX NormalBox{ NormalRect.Left, NormalRect.Top, 0, NormalRect.Right, NormalRect.Bottom, 1 };
+		m_NormalMapTexture->UpdateTextureRawData(&m_NormalMapTextureRawData[0], 0, KWidth, &NormalBox);
+	}
+
+	// So are the patch errors of the cells whose 4 x 4 windows reach them
+	CMipGenerator::SRect ErrorRect{};
+	CPatchErrorEstimator::UpdateErrorMap(&m_HeightMapTextureRawData[0], KWidth, KHeight,
+		CPatchErrorEstimator::SDesc(m_cbTerrainData.TerrainHeightRange / 255.0f), DirtyRect, m_vPatchErrorRawData, ErrorRect);
+	if (ErrorRect.IsEmpty()) return;
+
+	D3D11_BOX ErrorBox{ ErrorRect.Left, ErrorRect.Top, 0, ErrorRect.Right, ErrorRect.Bottom, 1 };
+	m_PatchErrorTexture->UpdateTextureRawData(reinterpret_cast<const SPixel32UInt*>(&m_vPatchErrorRawData[0]), 0, KWidth, &ErrorBox);
 }
 
 void CTerrain::UpdateMasking(EMaskingLayer eLayer, const XMFLOAT2& Position, float Value, float Radius, bool bForceSet)
 {
+	if (m_Streamer)
+	{
+		UpdateStreamedMasking(eLayer, Position, Value, Radius, bForceSet);
+		return;
+	}
+
 	const float KDetailSquare{ m_MaskingTextureDetail * m_MaskingTextureDetail };
 	const float KRadiusSquare{ Radius * Radius * KDetailSquare };
 	const int KCenterU{ static_cast<int>((+m_Size.x / 2.0f + Position.x) * m_MaskingTextureDetail) };
 	const int KCenterV{ static_cast<int>(-(-m_Size.y / 2.0f + Position.y) * m_MaskingTextureDetail) };
+	const int KRadiusInTexels{ static_cast<int>(ceilf(Radius * m_MaskingTextureDetail)) };
+	const int KWidth{ static_cast<int>(m_MaskingTextureSize.x) };
+	const int KHeight{ static_cast<int>(m_MaskingTextureSize.y) };
+
+	// Only the texels inside the brush's bounding square can change
+	CMipGenerator::SRect DirtyRect{};
+	DirtyRect.Left = static_cast<uint32_t>(min(max(KCenterU - KRadiusInTexels, 0), KWidth));
+	DirtyRect.Top = static_cast<uint32_t>(min(max(KCenterV - KRadiusInTexels, 0), KHeight));
+	DirtyRect.Right = static_cast<uint32_t>(min(max(KCenterU + KRadiusInTexels + 1, 0), KWidth));
+	DirtyRect.Bottom = static_cast<uint32_t>(min(max(KCenterV + KRadiusInTexels + 1, 0), KHeight));
+	if (DirtyRect.IsEmpty()) return;
+
+	// The GPU would read the tiles that find no atlas slot as 0, so a stroke that could need more slots than the atlas can have is refused
+	// (erasing never needs any)
+	if (Value > 0.0f && !HasMaskingAtlasSlotsFor(GetMaskingAtlasTileRect(DirtyRect)))
+	{
+		++m_MaskingRefusedStrokeCount;
+		OutputDebugString(("- Terrain masking stroke refused: the masking atlas is full ([" + to_string(m_MaskingAtlasUsedSlotCount -
+			m_vMaskingAtlasFreeSlots.size()) + "] slots in use). Erase some masking first.\n").c_str());
+		return;
+	}
+
+	for (int V = (int)DirtyRect.Top; V < (int)DirtyRect.Bottom; ++V)
+	{
+		for (int U = (int)DirtyRect.Left; U < (int)DirtyRect.Right; ++U)
+		{
+			float dU{ float(U - KCenterU) };
+			float dV{ float(V - KCenterV) };
+			float DistanceSquare{ dU * dU + dV * dV };
+			if (DistanceSquare <= KRadiusSquare)
+			{
+				const uint8_t KValue{ static_cast<uint8_t>(Value * CalculateMaskingFactor(DistanceSquare / KDetailSquare) * 255.0f) };
+				SPixel32UInt* PtrPixel{ m_Masking.FindTexel(static_cast<uint32_t>(U), static_cast<uint32_t>(V)) };
+				if (!PtrPixel)
+				{
+					// The texel's tile is 0, so writing 0 changes nothing (neither with bForceSet nor with max())
+					if (!KValue) continue;
+					PtrPixel = m_Masking.GetTexelForWrite(static_cast<uint32_t>(U), static_cast<uint32_t>(V));
+				}
+
+				uint8_t* const PtrChannel{ GetMaskingChannel(*PtrPixel, eLayer) };
+				if (!PtrChannel) continue;
+
+				*PtrChannel = (bForceSet) ? KValue : max(*PtrChannel, KValue);
+			}
+		}
+	}
+
+	// Erasing can leave tiles that are all 0
+	m_Masking.ReleaseZeroTiles(DirtyRect);
+
+	UpdateMaskingTexture(DirtyRect);
+
+	if (m_LayerAnalyzer.Update(m_Masking, DirtyRect))
+	{
+		GroupLayerTileDraws();
+	}
+}
+
+float CTerrain::CalculateMaskingFactor(float DistanceSquare) const
+{
+	float Factor{ 1.0f -
+		(sqrt(DistanceSquare) / m_MaskingRadius) * m_MaskingAttenuation - // Distance attenuation
+		(DistanceSquare / m_MaskingRadius) * m_MaskingAttenuation }; // Distance square attenuation
+	Factor = max(Factor, 0.0f);
+	Factor = min(Factor, 1.0f);
+	return Factor;
+}
+
+uint8_t* CTerrain::GetMaskingChannel(SPixel32UInt& Pixel, EMaskingLayer eLayer)
+{
+	switch (eLayer)
+	{
+	case EMaskingLayer::LayerR:
+		return &Pixel.R;
+	case EMaskingLayer::LayerG:
+		return &Pixel.G;
+	case EMaskingLayer::LayerB:
+		return &Pixel.B;
+	case EMaskingLayer::LayerA:
+		return &Pixel.A;
+	default:
+		return nullptr;
+	}
+}
 
-	for (int iPixel = 0; iPixel < (int)m_MaskingTextureRawData.size(); ++iPixel)
+void CTerrain::UpdateMaskingTexture()
+{
+	const uint32_t KTileCountX{ m_Masking.GetTileCountX() };
+	const uint32_t KTileCountY{ m_Masking.GetTileCountY() };
+
+	// Every atlas slot is handed out again
+	m_MaskingAtlasUsedSlotCount = 0;
+	m_vMaskingAtlasFreeSlots.clear();
+	m_vMaskingIndirectionRawData.assign(static_cast<size_t>(KTileCountX) * KTileCountY, 0);
+	if (!UpdateMaskingAtlasSlots(0, 0, KTileCountX, KTileCountY) || !m_MaskingAtlasTexture)
+	{
+		CreateMaskingAtlas(m_MaskingAtlasUsedSlotCount);
+	}
+	for (uint32_t TileY = 0; TileY < KTileCountY; ++TileY)
+	{
+		for (uint32_t TileX = 0; TileX < KTileCountX; ++TileX)
+		{
+			UploadMaskingAtlasSlot(TileX, TileY);
+		}
+	}
+	m_MaskingIndirectionTexture->UpdateTextureRawData(reinterpret_cast<const SPixel32UInt*>(&m_vMaskingIndirectionRawData[0]), 0, KTileCountX);
+
+	const uint32_t KCoarseWidth{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.x) };
+	const uint32_t KCoarseHeight{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.y) };
+	CMipGenerator::SRect CoarseRect{};
+	CoarseRect.Right = KCoarseWidth;
+	CoarseRect.Bottom = KCoarseHeight;
+	m_Masking.Downsample(KMaskingCoarseFactor, CoarseRect, &m_MaskingCoarseTextureRawData[0], KCoarseWidth);
+	m_MaskingCoarseTexture->UpdateTextureRawData(&m_MaskingCoarseTextureRawData[0], 0, KCoarseWidth);
+
+	CMipGenerator::GenerateMipChain(&m_MaskingCoarseTextureRawData[0], KCoarseWidth, KCoarseHeight,
+		CMipGenerator::SDesc(CMipGenerator::EFilter::Box), m_vMaskingCoarseTextureMipChain);
+	for (size_t iMip = 0; iMip < m_vMaskingCoarseTextureMipChain.size(); ++iMip)
 	{
-		int U{ iPixel % (int)m_MaskingTextureSize.x };
-		int V{ iPixel / (int)m_MaskingTextureSize.x };
+		const auto& Level{ m_vMaskingCoarseTextureMipChain[iMip] };
+		m_MaskingCoarseTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width);
+	}
+}
+
+void CTerrain::UpdateMaskingTexture(const CMipGenerator::SRect& DirtyRect)
+{
+	if (DirtyRect.IsEmpty()) return;
+
+	const uint32_t KTileCountX{ m_Masking.GetTileCountX() };
+	const uint32_t KTileCountY{ m_Masking.GetTileCountY() };
 
-		float dU{ float(U - KCenterU) };
-		float dV{ float(V - KCenterV) };
-		float DistanceSquare{ dU * dU + dV * dV };
-		if (DistanceSquare <= KRadiusSquare)
+	const CMipGenerator::SRect KTileRect{ GetMaskingAtlasTileRect(DirtyRect) };
+	const uint32_t KTileLeft{ KTileRect.Left };
+	const uint32_t KTileTop{ KTileRect.Top };
+	const uint32_t KTileRight{ KTileRect.Right };
+	const uint32_t KTileBottom{ KTileRect.Bottom };
+	if (UpdateMaskingAtlasSlots(KTileLeft, KTileTop, KTileRight, KTileBottom))
+	{
+		for (uint32_t TileY = KTileTop; TileY < KTileBottom; ++TileY)
+		{
+			for (uint32_t TileX = KTileLeft; TileX < KTileRight; ++TileX)
+			{
+				UploadMaskingAtlasSlot(TileX, TileY);
+			}
+		}
+	}
+	else
+	{
+		// The atlas grows, so every slot is uploaded again
+		CreateMaskingAtlas(m_MaskingAtlasUsedSlotCount);
+		for (uint32_t TileY = 0; TileY < KTileCountY; ++TileY)
 		{
-			float Factor{ 1.0f -
-				(sqrt(DistanceSquare / KDetailSquare) / m_MaskingRadius) * m_MaskingAttenuation - // Distance attenuation
-				((DistanceSquare / KDetailSquare) / m_MaskingRadius) * m_MaskingAttenuation }; // Distance square attenuation
-			Factor = max(Factor, 0.0f);
-			Factor = min(Factor, 1.0f);
+			for (uint32_t TileX = 0; TileX < KTileCountX; ++TileX)
+			{
+				UploadMaskingAtlasSlot(TileX, TileY);
+			}
+		}
+	}
 
-			if (bForceSet)
+	D3D11_BOX IndirectionBox{ KTileLeft, KTileTop, 0, KTileRight, KTileBottom, 1 };
+	m_MaskingIndirectionTexture->UpdateTextureRawData(reinterpret_cast<const SPixel32UInt*>(&m_vMaskingIndirectionRawData[0]), 0, KTileCountX,
+		&IndirectionBox);
+
+	UpdateMaskingCoarseTexture(DirtyRect);
+}
+
+bool CTerrain::UpdateMaskingAtlasSlots(uint32_t TileLeft, uint32_t TileTop, uint32_t TileRight, uint32_t TileBottom)
+{
+	const uint32_t KTileCountX{ m_Masking.GetTileCountX() };
+	const uint32_t KTileCountY{ m_Masking.GetTileCountY() };
+	const size_t KMaxSlotCount{ static_cast<size_t>(KMaskingAtlasMaxSlotCountPerSide) * KMaskingAtlasMaxSlotCountPerSide };
+	size_t MissingSlotCount{};
+	for (uint32_t TileY = TileTop; TileY < TileBottom; ++TileY)
+	{
+		for (uint32_t TileX = TileLeft; TileX < TileRight; ++TileX)
+		{
+			bool bCanBeNonZero{};
+			for (uint32_t Y = (TileY) ? TileY - 1 : 0; Y <= min(TileY + 1, KTileCountY - 1) && !bCanBeNonZero; ++Y)
 			{
-				switch (eLayer)
+				for (uint32_t X = (TileX) ? TileX - 1 : 0; X <= min(TileX + 1, KTileCountX - 1); ++X)
 				{
-				case EMaskingLayer::LayerR:
-					m_MaskingTextureRawData[iPixel].R = static_cast<uint8_t>(Value * Factor * 255.0f);
-					break;
-				case EMaskingLayer::LayerG:
-					m_MaskingTextureRawData[iPixel].G = static_cast<uint8_t>(Value * Factor * 255.0f);
-					break;
-				case EMaskingLayer::LayerB:
-					m_MaskingTextureRawData[iPixel].B = static_cast<uint8_t>(Value * Factor * 255.0f);
-					break;
-				case EMaskingLayer::LayerA:
-					m_MaskingTextureRawData[iPixel].A = static_cast<uint8_t>(Value * Factor * 255.0f);
-					break;
-				default:
-					break;
+					if (m_Masking.GetTileSlot(X, Y) != CSparseMasking::KEmptySlot)
+					{
+						bCanBeNonZero = true;
+						break;
+					}
 				}
 			}
-			else
+
+			uint32_t& Entry{ m_vMaskingIndirectionRawData[static_cast<size_t>(TileY) * KTileCountX + TileX] };
+			if (bCanBeNonZero && !Entry)
 			{
-				switch (eLayer)
+				if (!m_vMaskingAtlasFreeSlots.empty())
 				{
-				case EMaskingLayer::LayerR:
-					m_MaskingTextureRawData[iPixel].R = max(m_MaskingTextureRawData[iPixel].R, static_cast<uint8_t>(Value * Factor * 255.0f));
-					break;
-				case EMaskingLayer::LayerG:
-					m_MaskingTextureRawData[iPixel].G = max(m_MaskingTextureRawData[iPixel].G, static_cast<uint8_t>(Value * Factor * 255.0f));
-					break;
-				case EMaskingLayer::LayerB:
-					m_MaskingTextureRawData[iPixel].B = max(m_MaskingTextureRawData[iPixel].B, static_cast<uint8_t>(Value * Factor * 255.0f));
-					break;
-				case EMaskingLayer::LayerA:
-					m_MaskingTextureRawData[iPixel].A = max(m_MaskingTextureRawData[iPixel].A, static_cast<uint8_t>(Value * Factor * 255.0f));
-					break;
-				default:
-					break;
+					Entry = m_vMaskingAtlasFreeSlots.back() + 1;
+					m_vMaskingAtlasFreeSlots.pop_back();
+				}
+				else if (m_MaskingAtlasUsedSlotCount < KMaxSlotCount)
+				{
+					Entry = static_cast<uint32_t>(m_MaskingAtlasUsedSlotCount++) + 1;
+				}
+				else
+				{
+					++MissingSlotCount;
 				}
 			}
+			else if (!bCanBeNonZero && Entry)
+			{
+				m_vMaskingAtlasFreeSlots.emplace_back(Entry - 1);
+				Entry = 0;
+			}
+		}
+	}
+	if (MissingSlotCount)
+	{
+		// Strokes are refused before this happens (see UpdateMasking()), so it takes a loaded or generated masking
+		OutputDebugString(("- Terrain masking atlas is full: [" + to_string(MissingSlotCount) + "] tiles that can be non-zero are drawn as 0.\n").c_str());
+	}
+	return (m_MaskingAtlasUsedSlotCount <= m_MaskingAtlasSlotCount);
+}
+
+CMipGenerator::SRect CTerrain::GetMaskingAtlasTileRect(const CMipGenerator::SRect& DirtyRect) const
+{
+	// A tile's slot holds CSparseMasking::KAtlasBorder texels of its neighbours and whether it has a slot depends on them,
+	// so the tiles next to the dirtied ones are included
+	CMipGenerator::SRect TileRect{};
+	TileRect.Left = (DirtyRect.Left / CSparseMasking::KTileSize) ? DirtyRect.Left / CSparseMasking::KTileSize - 1 : 0;
+	TileRect.Top = (DirtyRect.Top / CSparseMasking::KTileSize) ? DirtyRect.Top / CSparseMasking::KTileSize - 1 : 0;
+	TileRect.Right = min((DirtyRect.Right - 1) / CSparseMasking::KTileSize + 2, m_Masking.GetTileCountX());
+	TileRect.Bottom = min((DirtyRect.Bottom - 1) / CSparseMasking::KTileSize + 2, m_Masking.GetTileCountY());
+	return TileRect;
+}
+
+bool CTerrain::HasMaskingAtlasSlotsFor(const CMipGenerator::SRect& TileRect) const
+{
+	const size_t KMaxSlotCount{ static_cast<size_t>(KMaskingAtlasMaxSlotCountPerSide) * KMaskingAtlasMaxSlotCountPerSide };
+	const size_t KAvailableSlotCount{ m_vMaskingAtlasFreeSlots.size() + (KMaxSlotCount - m_MaskingAtlasUsedSlotCount) };
+
+	// Assumes that every tile without a slot takes one
+	size_t NeededSlotCount{};
+	for (uint32_t TileY = TileRect.Top; TileY < TileRect.Bottom; ++TileY)
+	{
+		for (uint32_t TileX = TileRect.Left; TileX < TileRect.Right; ++TileX)
+		{
+			if (!m_vMaskingIndirectionRawData[static_cast<size_t>(TileY) * m_Masking.GetTileCountX() + TileX]) ++NeededSlotCount;
 		}
 	}
+	return (NeededSlotCount <= KAvailableSlotCount);
+}
 
-	UpdateMaskingTexture();
+void CTerrain::CreateMaskingAtlas(size_t SlotCount)
+{
+	// It grows by doubling, so that painting rarely recreates it
+	SlotCount = max(max(SlotCount, m_MaskingAtlasSlotCount * 2), KMaskingAtlasMinSlotCount);
+	const uint32_t KSlotCountX{ min(static_cast<uint32_t>(ceilf(sqrtf(static_cast<float>(SlotCount)))), KMaskingAtlasMaxSlotCountPerSide) };
+	const uint32_t KSlotCountY{ min(static_cast<uint32_t>((SlotCount + KSlotCountX - 1) / KSlotCountX), KMaskingAtlasMaxSlotCountPerSide) };
+	m_MaskingAtlasSlotCountX = KSlotCountX;
+	m_MaskingAtlasSlotCount = static_cast<size_t>(KSlotCountX) * KSlotCountY;
+
+	const XMFLOAT2 KAtlasSize{ static_cast<float>(KSlotCountX * CSparseMasking::KAtlasSlotSize),
+		static_cast<float>(KSlotCountY * CSparseMasking::KAtlasSlotSize) };
+	m_MaskingAtlasTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	m_MaskingAtlasTexture->CreateBlankTexture(DXGI_FORMAT_R8G8B8A8_UNORM, KAtlasSize, CSparseMasking::KAtlasMipCount);
+	m_MaskingAtlasTexture->SetSlot(KMaskingTextureSlot);
+
+	m_PtrGame->UpdatePSTerrainMaskingAtlas(m_MaskingTextureSize, KAtlasSize, KSlotCountX);
 }
 
-void CTerrain::UpdateMaskingTexture()
+void CTerrain::UploadMaskingAtlasSlot(uint32_t TileX, uint32_t TileY)
+{
+	const uint32_t KEntry{ m_vMaskingIndirectionRawData[static_cast<size_t>(TileY) * m_Masking.GetTileCountX() + TileX] };
+	if (!KEntry) return;
+
+	const uint32_t KSlot{ KEntry - 1 };
+	vector<SPixel32UInt> vSlotTexels(CSparseMasking::KAtlasSlotSize * CSparseMasking::KAtlasSlotSize);
+	m_Masking.ReadAtlasSlot(TileX, TileY, &vSlotTexels[0]);
+
+	// The slot's border is even on every level that is kept, so its mips are the masking's mips
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vSlotMipChain{};
+	CMipGenerator::GenerateMipChain(&vSlotTexels[0], CSparseMasking::KAtlasSlotSize, CSparseMasking::KAtlasSlotSize,
+		CMipGenerator::SDesc(CMipGenerator::EFilter::Box), vSlotMipChain);
+
+	const uint32_t KLeft{ (KSlot % m_MaskingAtlasSlotCountX) * CSparseMasking::KAtlasSlotSize };
+	const uint32_t KTop{ (KSlot / m_MaskingAtlasSlotCountX) * CSparseMasking::KAtlasSlotSize };
+	for (uint32_t iMip = 0; iMip < CSparseMasking::KAtlasMipCount; ++iMip)
+	{
+		const uint32_t KSize{ CSparseMasking::KAtlasSlotSize >> iMip };
+		D3D11_BOX Box{ KLeft >> iMip, KTop >> iMip, 0, (KLeft >> iMip) + KSize, (KTop >> iMip) + KSize, 1 };
+		m_MaskingAtlasTexture->UpdateTextureRegion((iMip) ? &vSlotMipChain[iMip - 1].vPixels[0] : &vSlotTexels[0], iMip, Box);
+	}
+}
+
+void CTerrain::UpdateMaskingCoarseTexture(const CMipGenerator::SRect& DirtyRect)
 {
-	m_MaskingTexture->UpdateTextureRawData(&m_MaskingTextureRawData[0]);
+	const uint32_t KCoarseWidth{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.x) };
+	const uint32_t KCoarseHeight{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.y) };
+
+	CMipGenerator::SRect CoarseRect{};
+	CoarseRect.Left = DirtyRect.Left / KMaskingCoarseFactor;
+	CoarseRect.Top = DirtyRect.Top / KMaskingCoarseFactor;
+	CoarseRect.Right = min((DirtyRect.Right + KMaskingCoarseFactor - 1) / KMaskingCoarseFactor, KCoarseWidth);
+	CoarseRect.Bottom = min((DirtyRect.Bottom + KMaskingCoarseFactor - 1) / KMaskingCoarseFactor, KCoarseHeight);
+	if (CoarseRect.IsEmpty()) return;
+
+	m_Masking.Downsample(KMaskingCoarseFactor, CoarseRect,
+		&m_MaskingCoarseTextureRawData[static_cast<size_t>(CoarseRect.Top) * KCoarseWidth + CoarseRect.Left], KCoarseWidth);
+
+	D3D11_BOX Box{ CoarseRect.Left, CoarseRect.Top, 0, CoarseRect.Right, CoarseRect.Bottom, 1 };
+	m_MaskingCoarseTexture->UpdateTextureRawData(&m_MaskingCoarseTextureRawData[0], 0, KCoarseWidth, &Box);
+
+	// Regenerate only the brush-dirtied region of each mip level
+	vector<CMipGenerator::SRect> vDirtyRects{};
+	CMipGenerator::UpdateMipChain(&m_MaskingCoarseTextureRawData[0], KCoarseWidth, KCoarseHeight, CMipGenerator::SDesc(CMipGenerator::EFilter::Box),
+		CoarseRect, m_vMaskingCoarseTextureMipChain, vDirtyRects);
+	for (size_t iMip = 0; iMip < m_vMaskingCoarseTextureMipChain.size(); ++iMip)
+	{
+		const CMipGenerator::SRect& Rect{ vDirtyRects[iMip] };
+		if (Rect.IsEmpty()) continue;
+
+		const auto& Level{ m_vMaskingCoarseTextureMipChain[iMip] };
+		D3D11_BOX MipBox{ Rect.Left, Rect.Top, 0, Rect.Right, Rect.Bottom, 1 };
+		m_MaskingCoarseTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width, &MipBox);
+	}
 }
 
 void CTerrain::SetSelectionSize(float& Size)
@@ -601,6 +1172,22 @@ void CTerrain::SetMaskingValue(float Value)
 	m_MaskingRatio = Value;
 }
 
+void CTerrain::SetBrushDesc(const CTerrainBrush::SDesc& Desc)
+{
+	m_BrushDesc = Desc;
+
+	if (m_eEditMode == EEditMode::Brush)
+	{
+		m_cbPSTerrainSelectionData.MaskingRadius = m_BrushDesc.Radius;
+		m_PtrGame->UpdatePSTerrainSelection(m_cbPSTerrainSelectionData);
+	}
+}
+
+const CTerrainBrush::SDesc& CTerrain::GetBrushDesc() const
+{
+	return m_BrushDesc;
+}
+
 void CTerrain::ShouldTessellate(bool Value)
 {
 	if (m_Object3DTerrain) m_Object3DTerrain->ShouldTessellate(Value);
@@ -639,6 +1226,13 @@ void CTerrain::SetEditMode(EEditMode Mode)
 		m_cbPSTerrainSelectionData.bIsMaskingMode = TRUE;
 		m_cbPSTerrainSelectionData.MaskingRadius = m_MaskingRadius;
 	}
+	else if (m_eEditMode == EEditMode::Brush)
+	{
+		// The brush is round as well (1 height map texel is 1 world unit)
+		ReleaseSelection();
+		m_cbPSTerrainSelectionData.bIsMaskingMode = TRUE;
+		m_cbPSTerrainSelectionData.MaskingRadius = m_BrushDesc.Radius;
+	}
 	else
 	{
 		m_cbPSTerrainSelectionData.bIsMaskingMode = FALSE;
@@ -672,6 +1266,16 @@ float CTerrain::GetTerrainTessFactor() const
 	return m_TerrainTessFactor;
 }
 
+void CTerrain::SetTerrainTessPixelError(float Value)
+{
+	m_TerrainTessPixelError = min(max(Value, KTessPixelErrorMin), KTessPixelErrorMax);
+}
+
+float CTerrain::GetTerrainTessPixelError() const
+{
+	return m_TerrainTessPixelError;
+}
+
 void CTerrain::SetWaterTessFactor(float Value)
 {
 	m_WaterTessFactor = Value;
@@ -703,91 +1307,948 @@ float CTerrain::GetMaskingDetail() const
 	return m_MaskingTextureDetail;
 }
 
-const string& CTerrain::GetFileName() const
+const CTerrainLayerAnalyzer::SStats& CTerrain::GetLayerStats() const
 {
-	return m_FileName;
+	return m_LayerAnalyzer.GetStats();
 }
 
-void CTerrain::Draw(bool bDrawNormals)
+CTerrain::SMaskingStats CTerrain::GetMaskingStats() const
 {
-	if (!m_Object3DTerrain) return;
-
-	CShader* VS{ m_PtrGame->GetBaseShader(EBaseShader::VSTerrain) };
-	CShader* PS{ m_PtrGame->GetBaseShader(EBaseShader::PSTerrain) };
-	
-	m_PtrGame->UpdateVSSpace(KMatrixIdentity);
-	VS->Use();
-	VS->UpdateAllConstantBuffers();
-
-	PS->Use();
-	PS->UpdateAllConstantBuffers();
-
-	m_HeightMapTexture->SetShaderType(EShaderType::VertexShader);
-	m_HeightMapTexture->Use();
-	m_MaskingTexture->Use();
-
-	if (bDrawNormals)
+	// Bytes of an RGBA8 or R32 texture and its first MipCount mips
+	auto CalculateTextureBytes{ [](uint32_t Width, uint32_t Height, uint32_t MipCount)
 	{
-		m_PtrGame->UpdateGSSpace();
-		m_PtrGame->GetBaseShader(EBaseShader::GSNormal)->Use();
-		m_PtrGame->GetBaseShader(EBaseShader::GSNormal)->UpdateAllConstantBuffers();
+		size_t Bytes{};
+		for (uint32_t iMip = 0; iMip < MipCount; ++iMip)
+		{
+			Bytes += static_cast<size_t>(max(Width >> iMip, 1u)) * max(Height >> iMip, 1u) * sizeof(uint32_t);
+		}
+		return Bytes;
+	} };
+
+	SMaskingStats Stats{};
+	Stats.CPU = m_Masking.GetStats();
+	Stats.AtlasSlotCount = m_MaskingAtlasSlotCount;
+	Stats.AtlasUsedSlotCount = m_MaskingAtlasUsedSlotCount - m_vMaskingAtlasFreeSlots.size();
+	if (m_MaskingAtlasSlotCountX)
+	{
+		const uint32_t KSlotCountY{ static_cast<uint32_t>(m_MaskingAtlasSlotCount / m_MaskingAtlasSlotCountX) };
+		Stats.AtlasBytes = CalculateTextureBytes(m_MaskingAtlasSlotCountX * CSparseMasking::KAtlasSlotSize,
+			KSlotCountY * CSparseMasking::KAtlasSlotSize, CSparseMasking::KAtlasMipCount);
 	}
-
-	m_Object3DTerrain->Draw();
-
-	if (bDrawNormals)
+	Stats.IndirectionBytes = CalculateTextureBytes(m_Masking.GetTileCountX(), m_Masking.GetTileCountY(), 1);
+	const uint32_t KCoarseWidth{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.x) };
+	const uint32_t KCoarseHeight{ static_cast<uint32_t>(m_MaskingCoarseTextureSize.y) };
+	if (KCoarseWidth && KCoarseHeight)
 	{
-		m_PtrDeviceContext->GSSetShader(nullptr, nullptr, 0);
+		Stats.CoarseBytes = CalculateTextureBytes(KCoarseWidth, KCoarseHeight, CMipGenerator::GetMipCount(KCoarseWidth, KCoarseHeight));
 	}
-
-	if (m_bShouldDrawWater)
+	Stats.GPUBytes = Stats.AtlasBytes + Stats.IndirectionBytes + Stats.CoarseBytes;
+	if (m_Masking.GetWidth() && m_Masking.GetHeight())
 	{
-		DrawWater();
+		Stats.DenseGPUBytes = CalculateTextureBytes(m_Masking.GetWidth(), m_Masking.GetHeight(),
+			CMipGenerator::GetMipCount(m_Masking.GetWidth(), m_Masking.GetHeight()));
 	}
+	Stats.RefusedStrokeCount = m_MaskingRefusedStrokeCount;
+	return Stats;
 }
 
-void CTerrain::DrawHeightMapTexture()
+const string& CTerrain::GetFileName() const
 {
-	if (!m_Object2DTextureRepresentation) return;
+	return m_FileName;
+}
+
+void CTerrain::Sample(const XMFLOAT2* const PtrPositionsXZ, size_t Count, float* const PtrOutHeights,
+	XMFLOAT3* const PtrOutNormals, XMFLOAT4* const PtrOutLayerWeights) const
+{
+	if (m_HeightMapTextureRawData.empty()) return;
+
+	CTerrainSampler::Sample(GetSamplerSource(), PtrPositionsXZ, Count, PtrOutHeights, PtrOutNormals, PtrOutLayerWeights);
+}
+
+float CTerrain::GetHeight(float X, float Z) const
+{
+	const XMFLOAT2 KPositionXZ{ X, Z };
+	float Height{};
+	Sample(&KPositionXZ, 1, &Height);
+	return Height;
+}
+
+void CTerrain::SnapInstancesToTerrain(CObject3D& Object3D, float HeightOffset) const
+{
+	if (m_HeightMapTextureRawData.empty() || !Object3D.IsInstanced()) return;
+
+	const size_t KInstanceCount{ Object3D.GetInstanceCount() };
+	vector<XMFLOAT2> vPositionsXZ(KInstanceCount);
+	vector<float> vHeights(KInstanceCount);
+	for (size_t iInstance = 0; iInstance < KInstanceCount; ++iInstance)
+	{
+		const auto& Instance{ Object3D.GetInstance(static_cast<int>(iInstance)) };
+		vPositionsXZ[iInstance] = XMFLOAT2(XMVectorGetX(Instance.Translation), XMVectorGetZ(Instance.Translation));
+	}
+
+	Sample(&vPositionsXZ[0], KInstanceCount, &vHeights[0]);
+
+	for (size_t iInstance = 0; iInstance < KInstanceCount; ++iInstance)
+	{
+		auto& Instance{ Object3D.GetInstance(static_cast<int>(iInstance)) };
+		Instance.Translation = XMVectorSetY(Instance.Translation, vHeights[iInstance] + HeightOffset);
+		Object3D.UpdateInstanceWorldMatrix(iInstance, false);
+	}
+	Object3D.UpdateInstanceBuffers();
+}
+
+CTerrainSampler::SSource CTerrain::GetSamplerSource() const
+{
+	CTerrainSampler::SSource Source{};
+	Source.TerrainSize = m_Size;
+	Source.HeightRange = m_cbTerrainData.TerrainHeightRange;
+	Source.PtrHeights = &m_HeightMapTextureRawData[0];
+	Source.HeightMapWidth = static_cast<uint32_t>(m_HeightMapTextureSize.x);
+	Source.HeightMapHeight = static_cast<uint32_t>(m_HeightMapTextureSize.y);
+	if (m_Masking.GetWidth() && m_Masking.GetHeight())
+	{
+		Source.PtrMasking = &m_Masking;
+		Source.MaskingDetail = m_MaskingTextureDetail;
+	}
+	return Source;
+}
+
+void CTerrain::EnableStreaming(CTerrainTileStore* const PtrStore, const CTerrainStreamer::SDesc& Desc)
+{
+	DisableStreaming();
+
+	m_Streamer = make_unique<CTerrainStreamer>(PtrStore, Desc);
+}
+
+void CTerrain::DisableStreaming()
+{
+	// The streamer saves its edited tiles before it goes
+	m_Streamer.reset();
+	m_umapStreamedTiles.clear();
+	m_vStreamingEvents.clear();
+}
+
+void CTerrain::UpdateStreaming(const XMFLOAT2& CameraPositionXZ)
+{
+	if (!m_Streamer) return;
+
+	m_vStreamingEvents.clear();
+	m_Streamer->Update(CameraPositionXZ, m_vStreamingEvents);
+	for (const CTerrainStreamer::SEvent& Event : m_vStreamingEvents)
+	{
+		switch (Event.eType)
+		{
+		case CTerrainStreamer::EEventType::Loaded:
+			CreateStreamedTile(Event.Coord);
+			InvalidateStreamedTiles(Event.Coord, false);
+			break;
+		case CTerrainStreamer::EEventType::Updated:
+			InvalidateStreamedTiles(Event.Coord, true);
+			break;
+		case CTerrainStreamer::EEventType::Evicted:
+			m_umapStreamedTiles.erase(Event.Coord.GetKey());
+			InvalidateStreamedTiles(Event.Coord, false);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Each tile is rebuilt once, however many of its neighbours changed
+	UpdateStreamedTiles();
+}
+
+CTerrainStreamer* CTerrain::GetStreamer() const
+{
+	return m_Streamer.get();
+}
+
+size_t CTerrain::GetStreamedTileCount() const
+{
+	return m_umapStreamedTiles.size();
+}
+
+void CTerrain::CreateStreamedTile(const STerrainTileCoord& Coord)
+{
+	// The tile may have been evicted later in the same update
+	const STerrainTileData* const PtrData{ m_Streamer->FindTile(Coord) };
+	if (!PtrData) return;
+
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const uint32_t KSide{ KDesc.HeightMapSize + 1 };
+
+	SMesh Mesh{};
+	Mesh.vVertices.resize(static_cast<size_t>(KSide) * KSide);
+	for (uint32_t iRow = 0; iRow < KDesc.HeightMapSize; ++iRow)
+	{
+		for (uint32_t iColumn = 0; iColumn < KDesc.HeightMapSize; ++iColumn)
+		{
+			const uint32_t I0{ iRow * KSide + iColumn };
+			const uint32_t I2{ I0 + KSide };
+			Mesh.vTriangles.emplace_back(I0, I0 + 1, I2);
+			Mesh.vTriangles.emplace_back(I0 + 1, I2 + 1, I2);
+		}
+	}
+	UpdateStreamedTileMesh(Coord, Mesh);
+
+	// Drawn with PSTerrain and the terrain's materials (see RecordStreamedTiles()), so its own material is never used
+	CMaterial Material{};
+	Material.SetName("TerrainTile");
+
+	// Texel (0, 0) is the tile's (-X, +Z) corner
+	SStreamedTile Tile{};
+	Tile.Coord = Coord;
+	Tile.Object3D = make_unique<CObject3D>("TerrainTile" + to_string(Coord.X) + "_" + to_string(Coord.Z), m_PtrRenderDevice, m_PtrGame);
+	Tile.Object3D->Create(Mesh, Material);
+	Tile.Object3D->ComponentTransform.Translation = XMVectorSet(Coord.X * KDesc.TileSize, 0, (Coord.Z + 1) * KDesc.TileSize, 1);
+	Tile.Object3D->UpdateWorldMatrix();
+
+	// The tile's masking space is the terrain's with the tile as the whole terrain
+	Tile.MatrixMaskingSpace = XMMatrixTranslation(-Coord.X * KDesc.TileSize, 0, (Coord.Z + 1) * KDesc.TileSize) *
+		XMMatrixScaling(1 / KDesc.TileSize, 1.0f, 1 / KDesc.TileSize);
+	CreateStreamedTileMasking(Tile, *PtrData);
+	CreateStreamedTileGrass(Tile, *PtrData);
+
+	m_umapStreamedTiles[Coord.GetKey()] = std::move(Tile);
+}
+
+void CTerrain::UpdateStreamedTileMesh(const STerrainTileCoord& Coord, SMesh& Mesh) const
+{
+	const STerrainTileData* const PtrData{ m_Streamer->FindTile(Coord) };
+	assert(PtrData);
+	if (!PtrData) return;
+
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const int KLast{ static_cast<int>(KDesc.HeightMapSize) };
+	const size_t KSide{ static_cast<size_t>(KLast) + 1 };
+	const float KTexelInterval{ KDesc.TileSize / KDesc.HeightMapSize };
+	const float KWorldPerStep{ m_cbTerrainData.TerrainHeightRange / 255.0f };
+
+	// The texels just outside the tile are the neighbours' second ones from their shared edges (rows go toward -Z)
+	const STerrainTileData* const PtrNegativeX{ m_Streamer->FindTile(STerrainTileCoord(Coord.X - 1, Coord.Z)) };
+	const STerrainTileData* const PtrPositiveX{ m_Streamer->FindTile(STerrainTileCoord(Coord.X + 1, Coord.Z)) };
+	const STerrainTileData* const PtrPositiveZ{ m_Streamer->FindTile(STerrainTileCoord(Coord.X, Coord.Z + 1)) };
+	const STerrainTileData* const PtrNegativeZ{ m_Streamer->FindTile(STerrainTileCoord(Coord.X, Coord.Z - 1)) };
+	auto GetHeight{ [&](int iColumn, int iRow)
+	{
+		const STerrainTileData* PtrTile{ PtrData };
+		if (iColumn < 0)
+		{
+			PtrTile = PtrNegativeX;
+			iColumn += KLast;
+		}
+		else if (iColumn > KLast)
+		{
+			PtrTile = PtrPositiveX;
+			iColumn -= KLast;
+		}
+		else if (iRow < 0)
+		{
+			PtrTile = PtrPositiveZ;
+			iRow += KLast;
+		}
+		else if (iRow > KLast)
+		{
+			PtrTile = PtrNegativeZ;
+			iRow -= KLast;
+		}
+		return PtrTile->vHeights[iRow * KSide + iColumn].R * KWorldPerStep - m_cbTerrainData.TerrainHeightRange / 2.0f;
+	} };
+
+	// Layer textures repeat once per world unit as on the whole terrain, so they line up across the tiles
+	const float KOriginU{ fmodf(Coord.X * KDesc.TileSize, 1.0f) };
+	const float KOriginV{ fmodf(-(Coord.Z + 1) * KDesc.TileSize, 1.0f) };
+	for (int iRow = 0; iRow <= KLast; ++iRow)
+	{
+		for (int iColumn = 0; iColumn <= KLast; ++iColumn)
+		{
+			// Central differences (one-sided on the borders of the tiles that have no resident neighbour)
+			const int KLeft{ (iColumn > 0 || PtrNegativeX) ? iColumn - 1 : iColumn };
+			const int KRight{ (iColumn < KLast || PtrPositiveX) ? iColumn + 1 : iColumn };
+			const int KTop{ (iRow > 0 || PtrPositiveZ) ? iRow - 1 : iRow };
+			const int KBottom{ (iRow < KLast || PtrNegativeZ) ? iRow + 1 : iRow };
+			const float KSlopeX{ (GetHeight(KRight, iRow) - GetHeight(KLeft, iRow)) / ((KRight - KLeft) * KTexelInterval) };
+			const float KSlopeZ{ (GetHeight(iColumn, KTop) - GetHeight(iColumn, KBottom)) / ((KBottom - KTop) * KTexelInterval) };
+
+			SVertex3D& Vertex{ Mesh.vVertices[iRow * KSide + iColumn] };
+			Vertex.Position = XMVectorSet(iColumn * KTexelInterval, GetHeight(iColumn, iRow), -iRow * KTexelInterval, 1);
+			Vertex.Color = KColorWhite;
+			Vertex.TexCoord = XMVectorSet(KOriginU + iColumn * KTexelInterval, KOriginV + iRow * KTexelInterval, 0, 0);
+			Vertex.Normal = XMVector3Normalize(XMVectorSet(-KSlopeX, 1, -KSlopeZ, 0));
+			Vertex.Tangent = XMVector3Normalize(XMVectorSet(1, KSlopeX, 0, 0));
+		}
+	}
+}
+
+void CTerrain::CreateStreamedTileMasking(SStreamedTile& Tile, const STerrainTileData& Data)
+{
+	const uint32_t KSize{ m_Streamer->GetDesc().MaskingSize };
+
+	Tile.MaskingTexture = make_unique<CMaterial::CTexture>(m_PtrRenderDevice);
+	Tile.MaskingTexture->CreateBlankTexture(DXGI_FORMAT_R8G8B8A8_UNORM, XMFLOAT2(static_cast<float>(KSize), static_cast<float>(KSize)),
+		CMipGenerator::GetMipCount(KSize, KSize), true);
+	Tile.MaskingTexture->SetSlot(KMaskingTextureSlot);
+	Tile.MaskingTexture->UpdateTextureRawData(&Data.vMasking[0], 0, KSize);
+
+	CMipGenerator::GenerateMipChain(&Data.vMasking[0], KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Box), Tile.vMaskingMipChain);
+	for (size_t iMip = 0; iMip < Tile.vMaskingMipChain.size(); ++iMip)
+	{
+		const auto& Level{ Tile.vMaskingMipChain[iMip] };
+		Tile.MaskingTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width);
+	}
+
+	Tile.LayerMask = CalculateStreamedTileLayerMask(Data);
+}
 
+void CTerrain::UpdateStreamedTileMasking(SStreamedTile& Tile, const STerrainTileData& Data, const CMipGenerator::SRect& DirtyRect)
+{
+	const uint32_t KSize{ m_Streamer->GetDesc().MaskingSize };
+
+	D3D11_BOX Box{ DirtyRect.Left, DirtyRect.Top, 0, DirtyRect.Right, DirtyRect.Bottom, 1 };
+	Tile.MaskingTexture->UpdateTextureRawData(&Data.vMasking[0], 0, KSize, &Box);
+
+	vector<CMipGenerator::SRect> vDirtyRects{};
+	CMipGenerator::UpdateMipChain(&Data.vMasking[0], KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Box), DirtyRect,
+		Tile.vMaskingMipChain, vDirtyRects);
+	for (size_t iMip = 0; iMip < Tile.vMaskingMipChain.size(); ++iMip)
+	{
+		const CMipGenerator::SRect& Rect{ vDirtyRects[iMip] };
+		if (Rect.IsEmpty()) continue;
+
+		const auto& Level{ Tile.vMaskingMipChain[iMip] };
+		D3D11_BOX MipBox{ Rect.Left, Rect.Top, 0, Rect.Right, Rect.Bottom, 1 };
+		Tile.MaskingTexture->UpdateTextureRawData(&Level.vPixels[0], static_cast<UINT>(iMip + 1), Level.Width, &MipBox);
+	}
+
+	Tile.LayerMask = CalculateStreamedTileLayerMask(Data);
+}
+
+void CTerrain::CreateStreamedTileGrass(SStreamedTile& Tile, const STerrainTileData& Data)
+{
+	constexpr XMVECTOR KGroundColor{ 0.4f, 0.6f, 0.0f, 1.0f };
+	constexpr XMVECTOR KTipColor{ 0.0f, 0.5f, 0.0f, 1.0f };
+	const XMVECTOR KUpDirection{ XMVectorSet(0, 1, 0, 0) };
+
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const float KTexelSize{ KDesc.TileSize / KDesc.GrassDensitySize };
+	const float KHeightTexelsPerUnit{ KDesc.HeightMapSize / KDesc.TileSize };
+	const float KOriginX{ Tile.Coord.X * KDesc.TileSize };
+	const float KOriginZ{ (Tile.Coord.Z + 1) * KDesc.TileSize };
+
+	m_vStreamedGrassVertices.clear();
+	for (uint32_t iRow = 0; iRow < KDesc.GrassDensitySize; ++iRow)
+	{
+		for (uint32_t iColumn = 0; iColumn < KDesc.GrassDensitySize; ++iColumn)
+		{
+			const uint32_t KTexel{ iRow * KDesc.GrassDensitySize + iColumn };
+			const uint8_t KDensity{ Data.vGrassDensities[KTexel] };
+			if (!KDensity) continue;
+
+			// Seeded by the texel, so that the blades stay where they are when the tile is rebuilt
+			uint32_t Seed{ (static_cast<uint32_t>(Tile.Coord.X) * 73856093u) ^ (static_cast<uint32_t>(Tile.Coord.Z) * 19349663u) ^
+				((KTexel + 1) * 83492791u) };
+			auto GetRandom{ [&Seed]()
+			{
+				Seed = Seed * 1664525u + 1013904223u;
+				return static_cast<float>(Seed >> 8) / 16777216.0f;
+			} };
+
+			const uint32_t KBladeCount{ static_cast<uint32_t>(KDensity / 255.0f * KStreamedGrassMaxBladeCount + GetRandom()) };
+			for (uint32_t iBlade = 0; iBlade < KBladeCount; ++iBlade)
+			{
+				// From the tile's (-X, +Z) corner
+				const float KX{ (iColumn + GetRandom()) * KTexelSize };
+				const float KZ{ (iRow + GetRandom()) * KTexelSize };
+				const float KHeight{ GetStreamedTileHeight(Data, KX * KHeightTexelsPerUnit, KZ * KHeightTexelsPerUnit) };
+				const float KTheta{ GetRandom() * XM_2PI };
+				const float KBendingAngle{ KStreamedGrassMinBendingAngle + GetRandom() * (KStreamedGrassMaxBendingAngle - KStreamedGrassMinBendingAngle) };
+				const float KLength{ KStreamedGrassMinBladeLength + GetRandom() * (KStreamedGrassMaxBladeLength - KStreamedGrassMinBladeLength) };
+
+				const XMVECTOR KDirection{ XMVectorSet(sinf(KTheta), 0, cosf(KTheta), 0) };
+				const XMMATRIX KBendingMatrix{ XMMatrixRotationAxis(XMVector3Cross(KUpDirection, KDirection), KBendingAngle) };
+
+				m_vStreamedGrassVertices.emplace_back();
+				CGrassField::SVertexGrass& Vertex{ m_vStreamedGrassVertices.back() };
+				Vertex.GroundPosition = XMVectorSet(KOriginX + KX, KHeight, KOriginZ - KZ, 1);
+				Vertex.TipPosition = Vertex.GroundPosition + XMVector3TransformNormal(XMVectorSet(0, KLength, 0, 0), KBendingMatrix);
+				Vertex.GroundColor = KGroundColor;
+				Vertex.TipColor = KTipColor;
+			}
+		}
+	}
+
+	Tile.GrassBladeCount = static_cast<UINT>(m_vStreamedGrassVertices.size());
+	Tile.GrassVertexBuffer.Reset();
+	if (m_vStreamedGrassVertices.empty()) return;
+
+	D3D11_BUFFER_DESC BufferDesc{};
+	BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	BufferDesc.ByteWidth = static_cast<UINT>(sizeof(CGrassField::SVertexGrass) * m_vStreamedGrassVertices.size());
+	BufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	D3D11_SUBRESOURCE_DATA SubresourceData{};
+	SubresourceData.pSysMem = &m_vStreamedGrassVertices[0];
+	m_PtrRenderDevice->CreateBuffer(BufferDesc, &SubresourceData, Tile.GrassVertexBuffer.ReleaseAndGetAddressOf());
+}
+
+void CTerrain::InvalidateStreamedTiles(const STerrainTileCoord& Coord, bool bHaveHeightsChanged)
+{
+	if (bHaveHeightsChanged)
+	{
+		auto Found{ m_umapStreamedTiles.find(Coord.GetKey()) };
+		if (Found != m_umapStreamedTiles.end())
+		{
+			Found->second.bShouldUpdateMesh = true;
+			Found->second.bShouldUpdateGrass = true;
+		}
+	}
+
+	const STerrainTileCoord KNeighbors[]{ STerrainTileCoord(Coord.X - 1, Coord.Z), STerrainTileCoord(Coord.X + 1, Coord.Z),
+		STerrainTileCoord(Coord.X, Coord.Z - 1), STerrainTileCoord(Coord.X, Coord.Z + 1) };
+	for (const STerrainTileCoord& Neighbor : KNeighbors)
+	{
+		auto Found{ m_umapStreamedTiles.find(Neighbor.GetKey()) };
+		if (Found != m_umapStreamedTiles.end()) Found->second.bShouldUpdateMesh = true;
+	}
+}
+
+void CTerrain::UpdateStreamedTiles()
+{
+	for (auto& Pair : m_umapStreamedTiles)
+	{
+		SStreamedTile& Tile{ Pair.second };
+		if (!Tile.bShouldUpdateMesh && !Tile.bShouldUpdateGrass) continue;
+
+		const STerrainTileData* const PtrData{ m_Streamer->FindTile(Tile.Coord) };
+		if (!PtrData) continue;
+
+		if (Tile.bShouldUpdateMesh)
+		{
+			UpdateStreamedTileMesh(Tile.Coord, Tile.Object3D->GetModel().vMeshes[0]);
+			Tile.Object3D->UpdateMeshBuffer();
+			Tile.bShouldUpdateMesh = false;
+		}
+
+		if (Tile.bShouldUpdateGrass)
+		{
+			CreateStreamedTileGrass(Tile, *PtrData);
+			Tile.bShouldUpdateGrass = false;
+		}
+	}
+}
+
+uint32_t CTerrain::CalculateStreamedTileLayerMask(const STerrainTileData& Data)
+{
+	const uint32_t KAllLayers{ static_cast<uint32_t>(EPSFeature::UseLayer1) | static_cast<uint32_t>(EPSFeature::UseLayer2) |
+		static_cast<uint32_t>(EPSFeature::UseLayer3) | static_cast<uint32_t>(EPSFeature::UseLayer4) };
+	uint32_t LayerMask{};
+	for (const SPixel32UInt& Pixel : Data.vMasking)
+	{
+		if (Pixel.R) LayerMask |= static_cast<uint32_t>(EPSFeature::UseLayer1);
+		if (Pixel.G) LayerMask |= static_cast<uint32_t>(EPSFeature::UseLayer2);
+		if (Pixel.B) LayerMask |= static_cast<uint32_t>(EPSFeature::UseLayer3);
+		if (Pixel.A) LayerMask |= static_cast<uint32_t>(EPSFeature::UseLayer4);
+		if (LayerMask == KAllLayers) break;
+	}
+	return LayerMask;
+}
+
+float CTerrain::GetStreamedTileHeight(const STerrainTileData& Data, float U, float V) const
+{
+	const uint32_t KLast{ m_Streamer->GetDesc().HeightMapSize };
+	const size_t KSide{ static_cast<size_t>(KLast) + 1 };
+	U = min(max(U, 0.0f), static_cast<float>(KLast));
+	V = min(max(V, 0.0f), static_cast<float>(KLast));
+	const uint32_t U0{ min(static_cast<uint32_t>(U), KLast - 1) };
+	const uint32_t V0{ min(static_cast<uint32_t>(V), KLast - 1) };
+	const float KFractionU{ U - U0 };
+	const float KFractionV{ V - V0 };
+
+	const float KTop{ Data.vHeights[V0 * KSide + U0].R * (1.0f - KFractionU) + Data.vHeights[V0 * KSide + U0 + 1].R * KFractionU };
+	const float KBottom{ Data.vHeights[(V0 + 1) * KSide + U0].R * (1.0f - KFractionU) + Data.vHeights[(V0 + 1) * KSide + U0 + 1].R * KFractionU };
+	const float KSteps{ KTop * (1.0f - KFractionV) + KBottom * KFractionV };
+	return KSteps * m_cbTerrainData.TerrainHeightRange / 255.0f - m_cbTerrainData.TerrainHeightRange / 2.0f;
+}
+
+bool CTerrain::SampleStreamedHeight(float X, float Z, float& OutHeight) const
+{
+	const STerrainTileCoord KCoord{ m_Streamer->GetTileCoord(XMFLOAT2(X, Z)) };
+	const STerrainTileData* const PtrData{ m_Streamer->FindTile(KCoord) };
+	if (!PtrData) return false;
+
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const float KTexelsPerUnit{ KDesc.HeightMapSize / KDesc.TileSize };
+	OutHeight = GetStreamedTileHeight(*PtrData, (X - KCoord.X * KDesc.TileSize) * KTexelsPerUnit,
+		((KCoord.Z + 1) * KDesc.TileSize - Z) * KTexelsPerUnit);
+	return true;
+}
+
+bool CTerrain::PickStreamedTiles(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection, XMVECTOR& OutPoint) const
+{
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const float KStep{ KDesc.TileSize / KDesc.HeightMapSize * 0.5f };
+	const float KHalfRange{ m_cbTerrainData.TerrainHeightRange / 2.0f };
+	XMFLOAT3 Origin{};
+	XMFLOAT3 Direction{};
+	XMStoreFloat3(&Origin, PickingRayOrigin);
+	XMStoreFloat3(&Direction, PickingRayDirection);
+
+	// The ray can only hit the tiles while it's inside the height range, and no resident tile is farther than the unload radius
+	float TMin{};
+	float TMax{ KDesc.UnloadRadius * 2.0f };
+	if (fabsf(Direction.y) > FLT_EPSILON)
+	{
+		const float KT0{ (+KHalfRange - Origin.y) / Direction.y };
+		const float KT1{ (-KHalfRange - Origin.y) / Direction.y };
+		TMin = max(TMin, min(KT0, KT1));
+		TMax = min(TMax, max(KT0, KT1));
+	}
+	else if (fabsf(Origin.y) > KHalfRange)
+	{
+		return false;
+	}
+
+	auto IsAboveGround{ [&](float T, bool& bIsResident)
+	{
+		float Height{};
+		bIsResident = SampleStreamedHeight(Origin.x + Direction.x * T, Origin.z + Direction.z * T, Height);
+		return !bIsResident || (Origin.y + Direction.y * T > Height);
+	} };
+
+	// Marches by half a texel, then bisects the step that went under the ground
+	float PrevT{ TMin };
+	for (float T = TMin; T <= TMax; T += KStep)
+	{
+		bool bIsResident{};
+		if (IsAboveGround(T, bIsResident))
+		{
+			PrevT = T;
+			continue;
+		}
+
+		float Low{ PrevT };
+		float High{ T };
+		for (int iIteration = 0; iIteration < 8; ++iIteration)
+		{
+			const float KMiddle{ (Low + High) * 0.5f };
+			if (IsAboveGround(KMiddle, bIsResident))
+			{
+				Low = KMiddle;
+			}
+			else
+			{
+				High = KMiddle;
+			}
+		}
+		OutPoint = PickingRayOrigin + PickingRayDirection * High;
+		return true;
+	}
+	return false;
+}
+
+void CTerrain::UpdateStreamedHeights(bool bIsLeftButton)
+{
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const float KTexelInterval{ KDesc.TileSize / KDesc.HeightMapSize };
+	const uint32_t KSide{ KDesc.HeightMapSize + 1 };
+	const bool bIsBrush{ m_eEditMode == EEditMode::Brush };
+
+	// The world square that the edit can reach
+	XMFLOAT2 Center{ m_cbPSTerrainSelectionData.DigitalPosition };
+	float HalfSize{ m_cbPSTerrainSelectionData.SelectionHalfSize };
+	CTerrainBrush::SDesc Desc{ m_BrushDesc };
+	if (bIsBrush)
+	{
+		Center = m_cbPSTerrainSelectionData.AnaloguePosition;
+		HalfSize = (m_BrushDesc.Radius + 1.0f) * KTexelInterval;
+
+		if (Desc.eType == CTerrainBrush::EType::Flatten)
+		{
+			if (bIsLeftButton)
+			{
+				Desc.PlaneHeight = min(max((m_SetHeightValue + KHeightRangeHalf) / KHeightRange, 0.0f), 1.0f) * 255.0f;
+			}
+			else
+			{
+				// Flattens to the height under the brush center
+				float Height{};
+				if (!SampleStreamedHeight(Center.x, Center.y, Height)) return;
+				Desc.PlaneHeight = ((Height + m_cbTerrainData.TerrainHeightRange / 2.0f) / m_cbTerrainData.TerrainHeightRange) * 255.0f;
+			}
+		}
+		if (Desc.eType == CTerrainBrush::EType::Noise && !bIsLeftButton) Desc.NoiseAmplitude = -Desc.NoiseAmplitude;
+	}
+
+	// Each tile edits its own copy of the shared texels and MarkEdited() stitches them to the neighbours
+	// @important: the brush only sees one tile's texels at a time, so brushes that read their neighbours (e.g. smoothing) are
+	// one-sided on the tiles' borders
+	const STerrainTileCoord KMin{ m_Streamer->GetTileCoord(XMFLOAT2(Center.x - HalfSize, Center.y - HalfSize)) };
+	const STerrainTileCoord KMax{ m_Streamer->GetTileCoord(XMFLOAT2(Center.x + HalfSize, Center.y + HalfSize)) };
+	for (int32_t Z = KMin.Z; Z <= KMax.Z; ++Z)
+	{
+		for (int32_t X = KMin.X; X <= KMax.X; ++X)
+		{
+			const STerrainTileCoord KCoord{ X, Z };
+			STerrainTileData* const PtrData{ m_Streamer->FindTileForEdit(KCoord) };
+			if (!PtrData) continue;
+
+			// Texel (U, V) is at world (OriginX + U * Interval, OriginZ - V * Interval)
+			const float KOriginX{ X * KDesc.TileSize };
+			const float KOriginZ{ (Z + 1) * KDesc.TileSize };
+			CMipGenerator::SRect DirtyRect{};
+			if (bIsBrush)
+			{
+				CTerrainBrush::Apply(&PtrData->vHeights[0], KSide, KSide, (Center.x - KOriginX) / KTexelInterval,
+					(KOriginZ - Center.y) / KTexelInterval, Desc, DirtyRect);
+			}
+			else
+			{
+				const int KSideInt{ static_cast<int>(KSide) };
+				DirtyRect.Left = static_cast<uint32_t>(min(max(static_cast<int>(ceilf((Center.x - HalfSize - KOriginX) / KTexelInterval)), 0), KSideInt));
+				DirtyRect.Right = static_cast<uint32_t>(min(max(static_cast<int>(floorf((Center.x + HalfSize - KOriginX) / KTexelInterval)) + 1, 0), KSideInt));
+				DirtyRect.Top = static_cast<uint32_t>(min(max(static_cast<int>(ceilf((KOriginZ - Center.y - HalfSize) / KTexelInterval)), 0), KSideInt));
+				DirtyRect.Bottom = static_cast<uint32_t>(min(max(static_cast<int>(floorf((KOriginZ - Center.y + HalfSize) / KTexelInterval)) + 1, 0), KSideInt));
+				for (uint32_t V = DirtyRect.Top; V < DirtyRect.Bottom; ++V)
+				{
+					for (uint32_t U = DirtyRect.Left; U < DirtyRect.Right; ++U)
+					{
+						UpdateHeight(PtrData->vHeights[V * KSide + U], bIsLeftButton);
+					}
+				}
+			}
+			if (DirtyRect.IsEmpty()) continue;
+
+			m_Streamer->MarkEdited(KCoord, DirtyRect);
+			InvalidateStreamedTiles(KCoord, true);
+		}
+	}
+
+	// The neighbours that MarkEdited() stitched are rebuilt on their Updated events
+	UpdateStreamedTiles();
+}
+
+void CTerrain::UpdateStreamedMasking(EMaskingLayer eLayer, const XMFLOAT2& Position, float Value, float Radius, bool bForceSet)
+{
+	const CTerrainStreamer::SDesc& KDesc{ m_Streamer->GetDesc() };
+	const int KSize{ static_cast<int>(KDesc.MaskingSize) };
+	const float KDetail{ KDesc.MaskingSize / KDesc.TileSize }; // Masking texels per unit
+	const float KRadiusInTexels{ Radius * KDetail };
+
+	const STerrainTileCoord KMin{ m_Streamer->GetTileCoord(XMFLOAT2(Position.x - Radius, Position.y - Radius)) };
+	const STerrainTileCoord KMax{ m_Streamer->GetTileCoord(XMFLOAT2(Position.x + Radius, Position.y + Radius)) };
+	for (int32_t Z = KMin.Z; Z <= KMax.Z; ++Z)
+	{
+		for (int32_t X = KMin.X; X <= KMax.X; ++X)
+		{
+			const STerrainTileCoord KCoord{ X, Z };
+			STerrainTileData* const PtrData{ m_Streamer->FindTileForEdit(KCoord) };
+			auto Found{ m_umapStreamedTiles.find(KCoord.GetKey()) };
+			if (!PtrData || Found == m_umapStreamedTiles.end()) continue;
+
+			// Texel (U, V)'s center is at world (OriginX + (U + 0.5) / Detail, OriginZ - (V + 0.5) / Detail)
+			const float KCenterU{ (Position.x - X * KDesc.TileSize) * KDetail - 0.5f };
+			const float KCenterV{ ((Z + 1) * KDesc.TileSize - Position.y) * KDetail - 0.5f };
+
+			// Only the texels inside the brush's bounding square can change
+			CMipGenerator::SRect DirtyRect{};
+			DirtyRect.Left = static_cast<uint32_t>(min(max(static_cast<int>(floorf(KCenterU - KRadiusInTexels)), 0), KSize));
+			DirtyRect.Top = static_cast<uint32_t>(min(max(static_cast<int>(floorf(KCenterV - KRadiusInTexels)), 0), KSize));
+			DirtyRect.Right = static_cast<uint32_t>(min(max(static_cast<int>(ceilf(KCenterU + KRadiusInTexels)) + 1, 0), KSize));
+			DirtyRect.Bottom = static_cast<uint32_t>(min(max(static_cast<int>(ceilf(KCenterV + KRadiusInTexels)) + 1, 0), KSize));
+			if (DirtyRect.IsEmpty()) continue;
+
+			for (uint32_t V = DirtyRect.Top; V < DirtyRect.Bottom; ++V)
+			{
+				for (uint32_t U = DirtyRect.Left; U < DirtyRect.Right; ++U)
+				{
+					const float dU{ U - KCenterU };
+					const float dV{ V - KCenterV };
+					const float KDistanceSquare{ dU * dU + dV * dV };
+					if (KDistanceSquare > KRadiusInTexels * KRadiusInTexels) continue;
+
+					const uint8_t KValue{ static_cast<uint8_t>(Value * CalculateMaskingFactor(KDistanceSquare / (KDetail * KDetail)) * 255.0f) };
+					uint8_t* const PtrChannel{ GetMaskingChannel(PtrData->vMasking[V * KDesc.MaskingSize + U], eLayer) };
+					if (!PtrChannel) continue;
+
+					*PtrChannel = (bForceSet) ? KValue : max(*PtrChannel, KValue);
+				}
+			}
+
+			m_Streamer->MarkEdited(KCoord, CMipGenerator::SRect());
+			UpdateStreamedTileMasking(Found->second, *PtrData, DirtyRect);
+		}
+	}
+}
+
+void CTerrain::Draw(bool bDrawNormals)
+{
+	if (!m_Object3DTerrain) return;
+
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
+	if (m_Streamer)
+	{
+		// The resident tiles replace the whole terrain
+		m_PtrGame->UpdateGSSpace();
+		RecordStreamedTiles(m_PtrGame->GetRenderDevice(), StateTracker, bDrawNormals);
+		if (m_bShouldDrawWater) DrawWater();
+		return;
+	}
+
+	CShader* VS{ m_PtrGame->GetBaseShader(EBaseShader::VSTerrain) };
+	CShader* PS{ m_PtrGame->GetBaseShader(EBaseShader::PSTerrain) };
+	
+	m_PtrGame->UpdateVSSpace(KMatrixIdentity);
+	VS->Use();
+	VS->UpdateAllConstantBuffers();
+
+	PS->Use();
+	PS->UpdateAllConstantBuffers();
+
+	m_HeightMapTexture->SetShaderType(EShaderType::VertexShader);
+	m_HeightMapTexture->Use(StateTracker);
+	m_NormalMapTexture->Use(StateTracker);
+	m_PatchErrorTexture->Use(StateTracker);
+	m_MaskingAtlasTexture->Use(StateTracker);
+	m_MaskingIndirectionTexture->Use(StateTracker);
+	m_MaskingCoarseTexture->Use(StateTracker);
+
+	if (bDrawNormals)
+	{
+		m_PtrGame->UpdateGSSpace();
+		m_PtrGame->GetBaseShader(EBaseShader::GSNormal)->Use();
+		m_PtrGame->GetBaseShader(EBaseShader::GSNormal)->UpdateAllConstantBuffers();
+	}
+
+	// Each group of tiles is drawn with the variant that samples only the layers they use
+	for (size_t iVariant = 0; iVariant < m_vLayerVariantDraws.size(); ++iVariant)
+	{
+		if (m_vLayerVariantDraws[iVariant].empty()) continue;
+
+		PS->SetPermutation(StateTracker, static_cast<uint32_t>(iVariant));
+		m_Object3DTerrain->SetVisibleDraws(0, m_vLayerVariantDraws[iVariant]);
+		m_Object3DTerrain->Draw();
+	}
+	m_Object3DTerrain->ResetVisibleDraws();
+
+	if (bDrawNormals)
+	{
+		StateTracker.SetGeometryShader(nullptr);
+	}
+
+	if (m_bShouldDrawWater)
+	{
+		DrawWater();
+	}
+}
+
+void CTerrain::Record(CRenderDevice& Device, CStateTracker& StateTracker, bool bShouldTessellate, bool bDrawNormals)
+{
+	if (!m_Object3DTerrain) return;
+
+	if (m_Streamer)
+	{
+		// The resident tiles replace the whole terrain
+		RecordStreamedTiles(Device, StateTracker, bDrawNormals);
+		if (m_bShouldDrawWater) RecordWater(Device, StateTracker);
+		return;
+	}
+
+	const CShader* const VS{ m_PtrGame->GetBaseShader(EBaseShader::VSTerrain) };
+	const CShader* const PS{ m_PtrGame->GetBaseShader(EBaseShader::PSTerrain) };
+
+	VS->Record(StateTracker);
+	m_PtrGame->RecordVSSpace(Device, StateTracker, VS, KMatrixIdentity);
+	VS->RecordConstantBuffer(Device, StateTracker, 1);
+	PS->RecordAllConstantBuffers(Device, StateTracker);
+
+	// Every material's textures are used at once (see CObject3D::Draw())
+	bool bUseDisplacement{};
+	for (const CMaterial& Material : m_Object3DTerrain->GetModel().vMaterials)
+	{
+		if (!Material.HasTexture()) continue;
+
+		if (Material.HasTexture(CMaterial::CTexture::EType::DisplacementTexture)) bUseDisplacement = true;
+		Material.UseTextures(StateTracker);
+	}
+
+	if (bShouldTessellate)
+	{
+		const CShader* const HS{ m_PtrGame->GetBaseShader(EBaseShader::HSTerrain) };
+		const CShader* const DS{ m_PtrGame->GetBaseShader(EBaseShader::DSTerrain) };
+		HS->Record(StateTracker);
+		HS->RecordAllConstantBuffers(Device, StateTracker);
+
+		DS->Record(StateTracker, static_cast<uint32_t>((bUseDisplacement) ? EDSTerrainFeature::UseDisplacement : EDSTerrainFeature::None));
+		DS->RecordAllConstantBuffers(Device, StateTracker);
+	}
+	else
+	{
+		StateTracker.SetHullShader(nullptr);
+		StateTracker.SetDomainShader(nullptr);
+	}
+
+	m_HeightMapTexture->SetShaderType(EShaderType::VertexShader);
+	m_HeightMapTexture->Use(StateTracker);
+	m_NormalMapTexture->Use(StateTracker);
+	m_PatchErrorTexture->Use(StateTracker);
+	m_MaskingAtlasTexture->Use(StateTracker);
+	m_MaskingIndirectionTexture->Use(StateTracker);
+	m_MaskingCoarseTexture->Use(StateTracker);
+
+	if (bDrawNormals)
+	{
+		const CShader* const GS{ m_PtrGame->GetBaseShader(EBaseShader::GSNormal) };
+		GS->Record(StateTracker);
+		GS->RecordAllConstantBuffers(Device, StateTracker);
+	}
+	else
+	{
+		StateTracker.SetGeometryShader(nullptr);
+	}
+
+	for (size_t iVariant = 0; iVariant < m_vLayerVariantDraws.size(); ++iVariant)
+	{
+		if (m_vLayerVariantDraws[iVariant].empty()) continue;
+
+		PS->Record(StateTracker, static_cast<uint32_t>(iVariant));
+		m_Object3DTerrain->DrawMesh(StateTracker, 0, &m_vLayerVariantDraws[iVariant]);
+	}
+
+	if (bDrawNormals)
+	{
+		StateTracker.SetGeometryShader(nullptr);
+	}
+
+	if (bShouldTessellate)
+	{
+		StateTracker.SetHullShader(nullptr);
+		StateTracker.SetDomainShader(nullptr);
+	}
+
+	if (m_bShouldDrawWater)
+	{
+		RecordWater(Device, StateTracker);
+	}
+}
+
+void CTerrain::RecordStreamedTiles(CRenderDevice& Device, CStateTracker& StateTracker, bool bDrawNormals) const
+{
+	const CShader* const VS{ m_PtrGame->GetBaseShader(EBaseShader::VSBase) };
+	const CShader* const PS{ m_PtrGame->GetBaseShader(EBaseShader::PSTerrain) };
+	const float KMaskingSize{ static_cast<float>(m_Streamer->GetDesc().MaskingSize) };
+
+	// The tiles are meshes of their own heights, so they aren't tessellated
+	StateTracker.SetHullShader(nullptr);
+	StateTracker.SetDomainShader(nullptr);
+
+	VS->Record(StateTracker);
+	PS->RecordConstantBuffer(Device, StateTracker, 1);
+	PS->RecordConstantBuffer(Device, StateTracker, 2);
+	PS->RecordConstantBuffer(Device, StateTracker, 3);
+
+	// Every material's textures are used at once (see CObject3D::Draw())
+	for (const CMaterial& Material : m_Object3DTerrain->GetModel().vMaterials)
+	{
+		if (!Material.HasTexture()) continue;
+
+		Material.UseTextures(StateTracker);
+	}
+
+	if (bDrawNormals)
+	{
+		const CShader* const GS{ m_PtrGame->GetBaseShader(EBaseShader::GSNormal) };
+		GS->Record(StateTracker);
+		GS->RecordAllConstantBuffers(Device, StateTracker);
+	}
+	else
+	{
+		StateTracker.SetGeometryShader(nullptr);
+	}
+
+	// Each tile is drawn with the variant of the layers that have non-zero masking in it
+	for (const auto& Pair : m_umapStreamedTiles)
+	{
+		const SStreamedTile& Tile{ Pair.second };
+		m_PtrGame->RecordVSSpace(Device, StateTracker, VS, Tile.Object3D->ComponentTransform.MatrixWorld);
+		m_PtrGame->RecordPSTerrainSpace(Device, StateTracker, Tile.MatrixMaskingSpace, XMFLOAT2(KMaskingSize, KMaskingSize));
+		PS->Record(StateTracker, Tile.LayerMask | static_cast<uint32_t>(EPSFeature::UseTileMasking));
+		Tile.MaskingTexture->Use(StateTracker);
+		Tile.Object3D->DrawMesh(StateTracker, 0);
+	}
+
+	StateTracker.SetGeometryShader(nullptr);
+
+	// Grass
+	const CShader* const VSGrass{ m_PtrGame->GetBaseShader(EBaseShader::VSGrassField) };
+	const CShader* const GSGrass{ m_PtrGame->GetBaseShader(EBaseShader::GSGrassField) };
+	const CShader* const PSGrass{ m_PtrGame->GetBaseShader(EBaseShader::PSGrassField) };
+	const CGrassField::SCBGSGrassData KGrassData{ KStreamedGrassBladeWidth };
+
+	VSGrass->Record(StateTracker);
+	m_PtrGame->RecordVSSpace(Device, StateTracker, VSGrass, XMMatrixIdentity());
+	GSGrass->Record(StateTracker);
+	GSGrass->RecordConstantBuffer(Device, StateTracker, 0);
+	GSGrass->RecordConstantBuffer(Device, StateTracker, 1, &KGrassData);
+	PSGrass->Record(StateTracker);
+	PSGrass->RecordAllConstantBuffers(Device, StateTracker);
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	for (const auto& Pair : m_umapStreamedTiles)
+	{
+		const SStreamedTile& Tile{ Pair.second };
+		if (!Tile.GrassBladeCount) continue;
+
+		StateTracker.SetVertexBuffer(0, Tile.GrassVertexBuffer.Get(), sizeof(CGrassField::SVertexGrass), 0);
+		StateTracker.Draw(Tile.GrassBladeCount, 0);
+	}
+	StateTracker.SetGeometryShader(nullptr);
+}
+
+void CTerrain::DrawHeightMapTexture()
+{
+	if (!m_Object2DTextureRepresentation) return;
+
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
 	m_HeightMapTexture->SetShaderType(EShaderType::PixelShader);
-	m_HeightMapTexture->Use();
+	m_HeightMapTexture->Use(StateTracker);
 
-	m_PtrDeviceContext->RSSetState(m_PtrGame->GetCommonStates()->CullCounterClockwise());
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetCommonStates()->DepthNone(), 0);
+	StateTracker.SetRasterizerState(m_PtrGame->GetRasterizerState(CGame::ERasterizerState::CullCounterClockwise));
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateNone(), 0);
 
 	m_PtrGame->UpdateVS2DSpace(KMatrixIdentity);
 	m_PtrGame->GetBaseShader(EBaseShader::VSBase2D)->Use();
 	m_PtrGame->GetBaseShader(EBaseShader::VSBase2D)->UpdateAllConstantBuffers();
 	m_PtrGame->GetBaseShader(EBaseShader::PSHeightMap2D)->Use();
 
-	m_Object2DTextureRepresentation->Draw();
+	m_Object2DTextureRepresentation->Draw(StateTracker);
 
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetCommonStates()->DepthDefault(), 0);
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateDefault(), 0);
 }
 
 void CTerrain::DrawMaskingTexture()
 {
 	if (!m_Object2DTextureRepresentation) return;
 
-	m_MaskingTexture->Use(0);
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
+	// The atlas can't be shown as one image, so the preview shows the coarse texture
+	m_MaskingCoarseTexture->Use(StateTracker, 0);
 
-	m_PtrDeviceContext->RSSetState(m_PtrGame->GetCommonStates()->CullCounterClockwise());
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetCommonStates()->DepthNone(), 0);
+	StateTracker.SetRasterizerState(m_PtrGame->GetRasterizerState(CGame::ERasterizerState::CullCounterClockwise));
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateNone(), 0);
 
 	m_PtrGame->UpdateVS2DSpace(KMatrixIdentity);
 	m_PtrGame->GetBaseShader(EBaseShader::VSBase2D)->Use();
 	m_PtrGame->GetBaseShader(EBaseShader::VSBase2D)->UpdateAllConstantBuffers();
 	m_PtrGame->GetBaseShader(EBaseShader::PSMasking2D)->Use();
 	
-	m_Object2DTextureRepresentation->Draw();
+	m_Object2DTextureRepresentation->Draw(StateTracker);
 
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetCommonStates()->DepthDefault(), 0);
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateDefault(), 0);
 }
 
 void CTerrain::DrawWater()
 {
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetDepthStencilStateLessEqualNoWrite(), 0);
+	CStateTracker& StateTracker{ m_PtrGame->GetStateTracker() };
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateLessEqualNoWrite(), 0);
 	m_PtrGame->UpdateVSSpace(XMMatrixTranslation(0, m_WaterHeight, 0));
 	m_PtrGame->UpdateHSTessFactor(m_WaterTessFactor);
 	m_PtrGame->GetBaseShader(EBaseShader::VSBase)->Use();
@@ -798,8 +2259,36 @@ void CTerrain::DrawWater()
 	m_PtrGame->GetBaseShader(EBaseShader::DSWater)->UpdateAllConstantBuffers();
 	m_PtrGame->GetBaseShader(EBaseShader::PSWater)->Use();
 	m_PtrGame->GetBaseShader(EBaseShader::PSWater)->UpdateAllConstantBuffers();
-	m_WaterNormalTexture->Use();
-	m_WaterDisplacementTexture->Use();
+	m_WaterNormalTexture->Use(StateTracker);
+	m_WaterDisplacementTexture->Use(StateTracker);
 	m_Object3DWater->Draw();
-	m_PtrDeviceContext->OMSetDepthStencilState(m_PtrGame->GetCommonStates()->DepthDefault(), 0);
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateDefault(), 0);
+}
+
+void CTerrain::RecordWater(CRenderDevice& Device, CStateTracker& StateTracker) const
+{
+	const CShader* const VS{ m_PtrGame->GetBaseShader(EBaseShader::VSBase) };
+	const CShader* const HS{ m_PtrGame->GetBaseShader(EBaseShader::HSWater) };
+	const CShader* const DS{ m_PtrGame->GetBaseShader(EBaseShader::DSWater) };
+	const CShader* const PS{ m_PtrGame->GetBaseShader(EBaseShader::PSWater) };
+
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateLessEqualNoWrite(), 0);
+	VS->Record(StateTracker);
+	m_PtrGame->RecordVSSpace(Device, StateTracker, VS, XMMatrixTranslation(0, m_WaterHeight, 0));
+	HS->Record(StateTracker);
+	HS->RecordConstantBuffer(Device, StateTracker, 0);
+	m_PtrGame->RecordHSTessFactor(Device, StateTracker, HS, m_WaterTessFactor);
+	DS->Record(StateTracker);
+	DS->RecordAllConstantBuffers(Device, StateTracker);
+	PS->Record(StateTracker);
+	PS->RecordAllConstantBuffers(Device, StateTracker);
+	m_WaterNormalTexture->Use(StateTracker);
+	m_WaterDisplacementTexture->Use(StateTracker);
+	for (size_t iMesh = 0; iMesh < m_Object3DWater->GetModel().vMeshes.size(); ++iMesh)
+	{
+		m_Object3DWater->DrawMesh(StateTracker, iMesh);
+	}
+	StateTracker.SetHullShader(nullptr);
+	StateTracker.SetDomainShader(nullptr);
+	StateTracker.SetDepthStencilState(m_PtrGame->GetDepthStencilStateDefault(), 0);
 }
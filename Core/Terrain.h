@@ -3,6 +3,16 @@
 #include "Object2D.h"
 #include "Object3D.h"
 #include "Material.h"
+#include "MipGenerator.h"
+#include "TerrainLayerAnalyzer.h"
+#include "NormalMapGenerator.h"
+#include "PatchErrorEstimator.h"
+#include "HeightFieldRayCaster.h"
+#include "TerrainSampler.h"
+#include "TerrainBrush.h"
+#include "TerrainGenerator.h"
+#include "TerrainStreamer.h"
+#include "GrassField.h"
 
 class CGame;
 
@@ -13,7 +23,8 @@ public:
 	{
 		SetHeight,
 		DeltaHeight,
-		Masking
+		Masking,
+		Brush // Sculpts with m_BrushDesc (see CTerrainBrush)
 	};
 
 	enum class EMaskingLayer
@@ -24,6 +35,17 @@ public:
 		LayerA,
 	};
 
+	// PSTerrain.hlsl's variants (the layer bits match CTerrainLayerAnalyzer's layer masks)
+	enum class EPSFeature : uint32_t
+	{
+		None = 0x00,
+		UseLayer1 = 0x01,
+		UseLayer2 = 0x02,
+		UseLayer3 = 0x04,
+		UseLayer4 = 0x08,
+		UseTileMasking = 0x10 // A streamed tile's dense masking texture instead of the sparse masking
+	};
+
 	struct SCBVSTerrainData
 	{
 		float TerrainSizeX{};
@@ -43,12 +65,39 @@ public:
 		XMFLOAT2	AnaloguePosition{};
 	};
 
+	struct SMaskingStats
+	{
+		CSparseMasking::SStats	CPU{}; // The sparse texels
+		size_t		AtlasSlotCount{};
+		size_t		AtlasUsedSlotCount{}; // Taken by tiles that can be non-zero
+		size_t		AtlasBytes{}; // Every mip
+		size_t		IndirectionBytes{};
+		size_t		CoarseBytes{}; // Every mip
+		size_t		GPUBytes{}; // The atlas, the indirection texture and the coarse texture
+		size_t		DenseGPUBytes{}; // Of one texture of every masking texel and its mips
+		size_t		RefusedStrokeCount{}; // Strokes that could have needed more atlas slots than the atlas can have (in total)
+	};
+
+	// A resident tile of a streamed terrain (see EnableStreaming())
+	struct SStreamedTile
+	{
+		STerrainTileCoord				Coord{};
+		unique_ptr<CObject3D>			Object3D{}; // The mesh of its heights, from its (-X, +Z) corner
+		unique_ptr<CMaterial::CTexture>	MaskingTexture{}; // Dense, with every mip
+		vector<CMipGenerator::SMipLevel<SPixel32UInt>>	vMaskingMipChain{};
+		XMMATRIX						MatrixMaskingSpace{};
+		uint32_t						LayerMask{}; // EPSFeature::UseLayer1 ~ UseLayer4 of the layers that are non-zero in it
+		ComPtr<ID3D11Buffer>			GrassVertexBuffer{}; // Of its grass densities
+		UINT							GrassBladeCount{};
+		bool							bShouldUpdateMesh{};
+		bool							bShouldUpdateGrass{};
+	};
+
 public:
-	CTerrain(ID3D11Device* const PtrDevice, ID3D11DeviceContext* const PtrDeviceContext, CGame* const PtrGame) :
-		m_PtrDevice{ PtrDevice }, m_PtrDeviceContext{ PtrDeviceContext }, m_PtrGame{ PtrGame }
+	CTerrain(CRenderDevice* const PtrRenderDevice, CGame* const PtrGame) :
+		m_PtrRenderDevice{ PtrRenderDevice }, m_PtrGame{ PtrGame }
 	{
-		assert(m_PtrDevice);
-		assert(m_PtrDeviceContext);
+		assert(m_PtrRenderDevice);
 	}
 	~CTerrain() {}
 
@@ -56,6 +105,8 @@ public:
 	void Create(const XMFLOAT2& TerrainSize, const CMaterial& Material, float MaskingDetail);
 	void Load(const string& FileName);
 	void Save(const string& FileName);
+	// Replaces the height map (and the masking layers, if Desc has masking rules) with generated ones
+	void Generate(const CTerrainGenerator::SDesc& Desc);
 
 private:
 	void CreateTerrainObject3D(vector<CMaterial>& vMaterialsl);
@@ -63,6 +114,9 @@ private:
 	void CreateMaskingTexture(bool bShouldClear);
 	void CreateWater();
 
+	void CreateLayerTiles(SMesh& Mesh);
+	void GroupLayerTileDraws();
+
 public:
 	void AddMaterial(const CMaterial& Material);
 	void SetMaterial(int MaterialID, const CMaterial& NewMaterial);
@@ -72,13 +126,31 @@ public:
 
 private:
 	void UpdateSelection(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection);
+	bool PickHeightField(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection, XMVECTOR& OutPoint) const;
 	void ReleaseSelection();
 	void UpdateHeights(bool bIsLeftButton);
-	void UpdateHeight(size_t iPixel, bool bIsLeftButton);
+	void UpdateHeight(SPixel8UInt& Pixel, bool bIsLeftButton);
+	void ApplyBrush(bool bIsLeftButton);
 	void UpdateHeightMapTexture();
+	void UpdateHeightMapTexture(const CMipGenerator::SRect& DirtyRect);
 
 	void UpdateMasking(EMaskingLayer eLayer, const XMFLOAT2& Position, float Value, float Radius, bool bForceSet = false);
+	// Of the brush's attenuation at DistanceSquare (in world units) from its center
+	float CalculateMaskingFactor(float DistanceSquare) const;
+	static uint8_t* GetMaskingChannel(SPixel32UInt& Pixel, EMaskingLayer eLayer);
 	void UpdateMaskingTexture();
+	void UpdateMaskingTexture(const CMipGenerator::SRect& DirtyRect);
+	// Gives an atlas slot to each tile in the range that is allocated or next to an allocated one (its border can be non-zero),
+	// and takes it back from the rest; returns false if the atlas has too few slots
+	// @important: tiles that find no slot under KMaskingAtlasMaxSlotCountPerSide^2 are read as 0 by the GPU (which is reported)
+	bool UpdateMaskingAtlasSlots(uint32_t TileLeft, uint32_t TileTop, uint32_t TileRight, uint32_t TileBottom);
+	// The tiles whose atlas slots can change when the texels in DirtyRect change
+	CMipGenerator::SRect GetMaskingAtlasTileRect(const CMipGenerator::SRect& DirtyRect) const;
+	// Whether every tile in TileRect could get a slot without exceeding the atlas's largest size
+	bool HasMaskingAtlasSlotsFor(const CMipGenerator::SRect& TileRect) const;
+	void CreateMaskingAtlas(size_t SlotCount);
+	void UploadMaskingAtlasSlot(uint32_t TileX, uint32_t TileY);
+	void UpdateMaskingCoarseTexture(const CMipGenerator::SRect& DirtyRect);
 
 public:
 	void SetSelectionSize(float& Size);
@@ -88,6 +160,8 @@ public:
 	void SetSetHeightValue(float Value);
 	void SetDeltaHeightValue(float Value);
 	void SetMaskingValue(float Value);
+	void SetBrushDesc(const CTerrainBrush::SDesc& Desc);
+	const CTerrainBrush::SDesc& GetBrushDesc() const;
 
 	void ShouldTessellate(bool Value);
 	bool ShouldTessellate() const;
@@ -103,6 +177,9 @@ public:
 	float GetWaterHeight() const;
 	void SetTerrainTessFactor(float Value);
 	float GetTerrainTessFactor() const;
+	// The hull shader subdivides each patch until its estimated error on screen is below this (in pixels), up to the tess factor
+	void SetTerrainTessPixelError(float Value);
+	float GetTerrainTessPixelError() const;
 	void SetWaterTessFactor(float Value);
 	float GetWaterTessFactor() const;
 
@@ -110,16 +187,67 @@ public:
 	int GetMaterialCount() const;
 	const XMFLOAT2& GetSelectionPosition() const;
 	float GetMaskingDetail() const;
+	const CTerrainLayerAnalyzer::SStats& GetLayerStats() const;
+	SMaskingStats GetMaskingStats() const;
 
 	const string& GetFileName() const;
 
+public:
+	// Batched queries at world XZ positions (see CTerrainSampler); any of the outputs can be nullptr
+	void Sample(const XMFLOAT2* const PtrPositionsXZ, size_t Count, float* const PtrOutHeights,
+		XMFLOAT3* const PtrOutNormals = nullptr, XMFLOAT4* const PtrOutLayerWeights = nullptr) const;
+	float GetHeight(float X, float Z) const;
+	// Puts every instance of Object3D on the ground, HeightOffset above it
+	void SnapInstancesToTerrain(CObject3D& Object3D, float HeightOffset = 0.0f) const;
+
+private:
+	CTerrainSampler::SSource GetSamplerSource() const;
+
+public:
+	// Pages a terrain that is too large for memory from PtrStore around the camera (see CTerrainStreamer)
+	// The resident tiles then stand in for the terrain: they are drawn with its layer textures, their own masking and their grass,
+	// and they are what Select() picks and edits (the edits are saved to PtrStore)
+	void EnableStreaming(CTerrainTileStore* const PtrStore, const CTerrainStreamer::SDesc& Desc);
+	void DisableStreaming();
+	// Requests the tiles around the camera and creates, updates or releases the GPU resources of the tiles whose residency changed
+	void UpdateStreaming(const XMFLOAT2& CameraPositionXZ);
+	CTerrainStreamer* GetStreamer() const;
+	size_t GetStreamedTileCount() const;
+
+private:
+	void CreateStreamedTile(const STerrainTileCoord& Coord);
+	// Its border normals are taken from its neighbours' texels (one-sided where they aren't resident)
+	void UpdateStreamedTileMesh(const STerrainTileCoord& Coord, SMesh& Mesh) const;
+	void CreateStreamedTileMasking(SStreamedTile& Tile, const STerrainTileData& Data);
+	void UpdateStreamedTileMasking(SStreamedTile& Tile, const STerrainTileData& Data, const CMipGenerator::SRect& DirtyRect);
+	void CreateStreamedTileGrass(SStreamedTile& Tile, const STerrainTileData& Data);
+	// The tile's heights change its own mesh and grass and its neighbours' border normals (so does its residency)
+	void InvalidateStreamedTiles(const STerrainTileCoord& Coord, bool bHaveHeightsChanged);
+	void UpdateStreamedTiles();
+	static uint32_t CalculateStreamedTileLayerMask(const STerrainTileData& Data);
+
+	// U, V: in height texels from the tile's (-X, +Z) corner
+	float GetStreamedTileHeight(const STerrainTileData& Data, float U, float V) const;
+	// false if the tile there isn't resident
+	bool SampleStreamedHeight(float X, float Z, float& OutHeight) const;
+	bool PickStreamedTiles(const XMVECTOR& PickingRayOrigin, const XMVECTOR& PickingRayDirection, XMVECTOR& OutPoint) const;
+	// Edit the resident tiles (through CTerrainStreamer::FindTileForEdit() and MarkEdited())
+	void UpdateStreamedHeights(bool bIsLeftButton);
+	void UpdateStreamedMasking(EMaskingLayer eLayer, const XMFLOAT2& Position, float Value, float Radius, bool bForceSet);
+
 public:
 	void Draw(bool bDrawNormals);
 	void DrawHeightMapTexture();
 	void DrawMaskingTexture();
 
+	// Draw() (and the tessellation shaders CGame::DrawTerrain() binds) for a CCommandRecorder job, which may run on any thread
+	// CGame's frame constants must be up to date (see CGame::PrepareRecording()); only the terrain itself changes
+	void Record(CRenderDevice& Device, CStateTracker& StateTracker, bool bShouldTessellate, bool bDrawNormals);
+
 private:
 	void DrawWater();
+	void RecordWater(CRenderDevice& Device, CStateTracker& StateTracker) const;
+	void RecordStreamedTiles(CRenderDevice& Device, CStateTracker& StateTracker, bool bDrawNormals) const;
 
 public:
 	static constexpr int KMaterialMaxCount{ 5 }; // It includes 1 main texture + 4 layer textures
@@ -134,6 +262,11 @@ public:
 	static constexpr float KTessFactorMin{ 2.0f };
 	static constexpr float KTessFactorMax{ 64.0f };
 
+	static constexpr float KTessPixelErrorUnit{ 0.1f };
+	static constexpr float KTessPixelErrorMin{ 0.25f };
+	static constexpr float KTessPixelErrorMax{ 8.0f };
+	static constexpr float KTessPixelErrorDefault{ 1.0f };
+
 	static constexpr float KSelectionSizeUnit{ 1.0f };
 	static constexpr float KSelectionMinSize{ 1.0f };
 	static constexpr float KSelectionMaxSize{ 10.0f };
@@ -141,7 +274,16 @@ public:
 	static constexpr int KMinSize{ 2 };
 	static constexpr int KDefaultSize{ 10 };
 
-	static constexpr size_t KMaskingTextureSlot{ 10 };
+	static constexpr size_t KNormalMapTextureSlot{ 1 }; // Vertex shader
+	static constexpr size_t KPatchErrorTextureSlot{ 0 }; // Hull shader
+	static constexpr size_t KMaskingTextureSlot{ 10 }; // The atlas
+	static constexpr size_t KMaskingIndirectionTextureSlot{ 11 };
+	static constexpr size_t KMaskingCoarseTextureSlot{ 12 };
+	static constexpr size_t KMaskingAtlasMinSlotCount{ CSparseMasking::KPoolPageTileCount };
+	static constexpr uint32_t KMaskingAtlasMaxSlotCountPerSide{ D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION / CSparseMasking::KAtlasSlotSize };
+	static constexpr uint32_t KMaskingCoarseFactor{ 1 << CSparseMasking::KAtlasMipCount }; // Coarse texels per masking texel, per axis
+	// The coarsest masking mip that PSTerrain.hlsl samples (MASKING_MAX_MIP), so that the layer tiles know how far weight is blurred
+	static constexpr uint32_t KMaskingMaxMip{ 4 };
 	static constexpr float KMaskingRatioUnit{ 0.01f };
 	static constexpr float KMaskingMinRatio{ 0.0f };
 	static constexpr float KMaskingMaxRatio{ 1.0f };
@@ -161,13 +303,23 @@ public:
 	static constexpr float KMaskingMaxDetail{ 16.0f };
 	static constexpr float KMaskingDefaultDetail{ 8.0f };
 
+	static constexpr uint32_t KLayerTileSize{ 32 }; // In masking texels
+	static constexpr size_t KLayerVariantCount{ 16 };
+
+	// The grass of the streamed tiles' densities (a density of 255 gets KStreamedGrassMaxBladeCount blades per texel)
+	static constexpr float KStreamedGrassMaxBladeCount{ 4.0f };
+	static constexpr float KStreamedGrassMinBladeLength{ 0.4f };
+	static constexpr float KStreamedGrassMaxBladeLength{ 0.8f };
+	static constexpr float KStreamedGrassBladeWidth{ 0.1f };
+	static constexpr float KStreamedGrassMinBendingAngle{ XM_PIDIV4 * 0.25f };
+	static constexpr float KStreamedGrassMaxBendingAngle{ XM_PIDIV4 };
+
 	static constexpr float KWaterHeightUnit{ 0.1f };
 	static constexpr float KWaterMinHeight{ KMinHeight };
 	static constexpr float KWaterMaxHeight{ KMaxHeight };
 
 private:
-	ID3D11Device* const			m_PtrDevice{};
-	ID3D11DeviceContext* const	m_PtrDeviceContext{};
+	CRenderDevice* const		m_PtrRenderDevice{};
 	CGame* const				m_PtrGame{};
 
 private:
@@ -178,14 +330,39 @@ private:
 	XMFLOAT2						m_HeightMapTextureSize{};
 	unique_ptr<CMaterial::CTexture>	m_HeightMapTexture{};
 	vector<SPixel8UInt>				m_HeightMapTextureRawData{};
+	vector<CMipGenerator::SMipLevel<SPixel8UInt>>	m_vHeightMapTextureMipChain{};
+	unique_ptr<CMaterial::CTexture>	m_NormalMapTexture{}; // Derived from the height map
+	vector<SPixel16Int>				m_NormalMapTextureRawData{};
+	unique_ptr<CMaterial::CTexture>	m_PatchErrorTexture{}; // Derived from the height map, 1 world error per texel (R32_FLOAT)
+	vector<float>					m_vPatchErrorRawData{};
+	CHeightFieldRayCaster			m_HeightFieldRayCaster{};
 	SCBVSTerrainData				m_cbTerrainData{};
 	float							m_TerrainTessFactor{ KTessFactorMin };
+	float							m_TerrainTessPixelError{ KTessPixelErrorDefault };
 
 	XMFLOAT2						m_MaskingTextureSize{};
-	unique_ptr<CMaterial::CTexture>	m_MaskingTexture{};
-	vector<SPixel32UInt>			m_MaskingTextureRawData{};
+	CSparseMasking					m_Masking{};
+	// The GPU reads the masking through an atlas of the tiles that can be non-zero (see UpdateMaskingAtlasSlots()),
+	// an indirection texture of each tile's atlas slot + 1 (0: the tile is 0) and, from mip CSparseMasking::KAtlasMipCount on,
+	// a dense coarse texture
+	unique_ptr<CMaterial::CTexture>	m_MaskingAtlasTexture{};
+	uint32_t						m_MaskingAtlasSlotCountX{};
+	size_t							m_MaskingAtlasSlotCount{};
+	size_t							m_MaskingAtlasUsedSlotCount{}; // Slots below it are in use or free
+	vector<uint32_t>				m_vMaskingAtlasFreeSlots{};
+	size_t							m_MaskingRefusedStrokeCount{};
+	unique_ptr<CMaterial::CTexture>	m_MaskingIndirectionTexture{};
+	vector<uint32_t>				m_vMaskingIndirectionRawData{};
+	unique_ptr<CMaterial::CTexture>	m_MaskingCoarseTexture{};
+	XMFLOAT2						m_MaskingCoarseTextureSize{};
+	vector<SPixel32UInt>			m_MaskingCoarseTextureRawData{};
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>>	m_vMaskingCoarseTextureMipChain{};
 	XMMATRIX						m_MatrixMaskingSpace{};
 
+	CTerrainLayerAnalyzer			m_LayerAnalyzer{};
+	vector<SDrawIndexedArgs>		m_vLayerTileDraws{}; // Index range of each tile
+	vector<vector<SDrawIndexedArgs>>	m_vLayerVariantDraws{}; // Tiles' index ranges grouped by their layer mask
+
 private:
 	unique_ptr<CObject3D>			m_Object3DWater{};
 	unique_ptr<CMaterial::CTexture>	m_WaterNormalTexture{};
@@ -194,6 +371,12 @@ private:
 	float							m_WaterTessFactor{ KTessFactorMin };
 	bool							m_bShouldDrawWater{ true };
 
+private:
+	unique_ptr<CTerrainStreamer>	m_Streamer{};
+	unordered_map<uint64_t, SStreamedTile>	m_umapStreamedTiles{}; // By STerrainTileCoord::GetKey()
+	vector<CTerrainStreamer::SEvent>	m_vStreamingEvents{};
+	vector<CGrassField::SVertexGrass>	m_vStreamedGrassVertices{};
+
 private:
 	SCBPSTerrainSelectionData	m_cbPSTerrainSelectionData{};
 
@@ -207,5 +390,7 @@ private:
 	float			m_MaskingAttenuation{ KMaskingMinAttenuation };
 	float			m_MaskingTextureDetail{ KMaskingDefaultDetail };
 
+	CTerrainBrush::SDesc	m_BrushDesc{};
+
 	string			m_FileName{};
 };
\ No newline at end of file
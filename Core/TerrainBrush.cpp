@@ -0,0 +1,521 @@
+#include "TerrainBrush.h"
+#include "WorkerPool.h"
+#include <DirectXPackedVector.h>
+
+using namespace PackedVector;
+
+static constexpr float KThermalRate{ 0.125f }; // <= 1 / 8 keeps the 4-neighbour update stable
+static constexpr float KWaterFlowRate{ 0.125f };
+static constexpr float KMinWater{ 1e-6f };
+
+// Working region with a border of zeros (1 texel thick) around it
+// Rows are padded so that 4-wide loads (and their +-1 neighbours) starting at any texel of a row stay in that row
+struct SGrid
+{
+	SGrid(uint32_t _Width, uint32_t _Height) :
+		Width{ _Width }, Height{ _Height }, Stride{ ((_Width + 2 + 3) & ~3u) + 4 }, vValues(static_cast<size_t>(Stride) * (_Height + 2)) {}
+
+	// Y: -1 ~ Height
+	float* GetRow(int Y) { return &vValues[static_cast<size_t>(Y + 1) * Stride + 1]; }
+	const float* GetRow(int Y) const { return &vValues[static_cast<size_t>(Y + 1) * Stride + 1]; }
+
+	uint32_t		Width{};
+	uint32_t		Height{};
+	uint32_t		Stride{};
+	vector<float>	vValues{};
+};
+
+static XMVECTOR Load4(const float* const PtrValues)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(PtrValues));
+}
+
+static void Store4(float* const PtrValues, FXMVECTOR Values)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(PtrValues), Values);
+}
+
+// Calls Function(Top, Bottom) for every tile of KTileRowCount rows in [0, RowCount); the shared worker pool pulls the tiles one by one
+// Function must only write to the rows of its tile
+template<typename TFunction>
+static void ForEachTile(uint32_t RowCount, size_t TexelCount, uint32_t ThreadCount, const TFunction& Function)
+{
+	const uint32_t KTileCount{ (RowCount + CTerrainBrush::KTileRowCount - 1) / CTerrainBrush::KTileRowCount };
+	if (TexelCount < CTerrainBrush::KMultithreadingMinTexelCount) ThreadCount = 1;
+
+	CWorkerPool::GetShared().ForEach(KTileCount, ThreadCount, [&](uint32_t iTile)
+		{
+			const uint32_t KTop{ iTile * CTerrainBrush::KTileRowCount };
+			Function(KTop, min(KTop + CTerrainBrush::KTileRowCount, RowCount));
+		});
+}
+
+// Hashes a lattice point to [-1, 1]
+static float HashLattice(int32_t X, int32_t Y, uint32_t Seed)
+{
+	uint32_t Hash{ static_cast<uint32_t>(X) * 0x27D4EB2Du ^ static_cast<uint32_t>(Y) * 0x165667B1u ^ Seed * 0x9E3779B9u };
+	Hash ^= Hash >> 15;
+	Hash *= 0x2C1B3C6Du;
+	Hash ^= Hash >> 12;
+	Hash *= 0x297A2D39u;
+	Hash ^= Hash >> 15;
+	return static_cast<float>(Hash & 0xFFFFFF) / 8388607.5f - 1.0f;
+}
+
+// Value noise with quintic interpolation, 4 points at a time
+static XMVECTOR ValueNoise(FXMVECTOR X, FXMVECTOR Y, uint32_t Seed)
+{
+	const XMVECTOR KFloorX{ XMVectorFloor(X) };
+	const XMVECTOR KFloorY{ XMVectorFloor(Y) };
+	const XMVECTOR KFractionX{ XMVectorSubtract(X, KFloorX) };
+	const XMVECTOR KFractionY{ XMVectorSubtract(Y, KFloorY) };
+
+	// t^3 * (t * (6t - 15) + 10)
+	const XMVECTOR KSix{ XMVectorReplicate(6.0f) };
+	const XMVECTOR KFifteen{ XMVectorReplicate(15.0f) };
+	const XMVECTOR KTen{ XMVectorReplicate(10.0f) };
+	const XMVECTOR KFadeX{ XMVectorMultiply(XMVectorMultiply(KFractionX, XMVectorMultiply(KFractionX, KFractionX)),
+		XMVectorMultiplyAdd(KFractionX, XMVectorSubtract(XMVectorMultiply(KFractionX, KSix), KFifteen), KTen)) };
+	const XMVECTOR KFadeY{ XMVectorMultiply(XMVectorMultiply(KFractionY, XMVectorMultiply(KFractionY, KFractionY)),
+		XMVectorMultiplyAdd(KFractionY, XMVectorSubtract(XMVectorMultiply(KFractionY, KSix), KFifteen), KTen)) };
+
+	// Lattice values are hashed lane by lane
+	int32_t LatticeX[4]{};
+	int32_t LatticeY[4]{};
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeX), XMConvertVectorFloatToInt(KFloorX, 0));
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeY), XMConvertVectorFloatToInt(KFloorY, 0));
+	float Corners[4][4]{}; // [Corner][Lane]
+	for (int iLane = 0; iLane < 4; ++iLane)
+	{
+		Corners[0][iLane] = HashLattice(LatticeX[iLane], LatticeY[iLane], Seed);
+		Corners[1][iLane] = HashLattice(LatticeX[iLane] + 1, LatticeY[iLane], Seed);
+		Corners[2][iLane] = HashLattice(LatticeX[iLane], LatticeY[iLane] + 1, Seed);
+		Corners[3][iLane] = HashLattice(LatticeX[iLane] + 1, LatticeY[iLane] + 1, Seed);
+	}
+
+	const XMVECTOR KTop{ XMVectorLerpV(Load4(Corners[0]), Load4(Corners[1]), KFadeX) };
+	const XMVECTOR KBottom{ XMVectorLerpV(Load4(Corners[2]), Load4(Corners[3]), KFadeX) };
+	return XMVectorLerpV(KTop, KBottom, KFadeY);
+}
+
+// Smoothstep from the radius (0) to the hard radius (Radius * Hardness, 1)
+static XMVECTOR CalculateFalloff(FXMVECTOR Distance, float Radius, float Hardness)
+{
+	const float KSoftWidth{ Radius * (1.0f - min(max(Hardness, 0.0f), 1.0f)) };
+	const float KInverseSoftWidth{ (KSoftWidth > 0.0f) ? 1.0f / KSoftWidth : FLT_MAX };
+	const XMVECTOR KT{ XMVectorSaturate(XMVectorScale(XMVectorSubtract(XMVectorReplicate(Radius), Distance), KInverseSoftWidth)) };
+	return XMVectorMultiply(XMVectorMultiply(KT, KT), XMVectorNegativeMultiplySubtract(XMVectorReplicate(2.0f), KT, XMVectorReplicate(3.0f)));
+}
+
+static void Smooth(SGrid& Heights, const SGrid& Mask, const CTerrainBrush::SDesc& Desc, uint32_t ThreadCount)
+{
+	const float KSigma{ max(Desc.SmoothSigma, 0.1f) };
+	const int KKernelRadius{ max(static_cast<int>(ceilf(KSigma * 3.0f)), 1) };
+	vector<float> vWeights(static_cast<size_t>(KKernelRadius) * 2 + 1);
+	float WeightSum{};
+	for (int iTap = -KKernelRadius; iTap <= KKernelRadius; ++iTap)
+	{
+		vWeights[iTap + KKernelRadius] = expf(-static_cast<float>(iTap * iTap) / (2.0f * KSigma * KSigma));
+		WeightSum += vWeights[iTap + KKernelRadius];
+	}
+	for (auto& Weight : vWeights) Weight /= WeightSum;
+
+	// Taps outside the working region are clamped to its edge (it only has no apron at the height map's edge)
+	const size_t KTexelCount{ static_cast<size_t>(Heights.Width) * Heights.Height };
+	SGrid Blurred{ Heights.Width, Heights.Height };
+	ForEachTile(Heights.Height, KTexelCount, ThreadCount, [&](uint32_t Top, uint32_t Bottom)
+		{
+			vector<float> vPaddedRow(Heights.Width + KKernelRadius * 2 + 4);
+			for (uint32_t Y = Top; Y < Bottom; ++Y)
+			{
+				const float* const PtrRow{ Heights.GetRow(Y) };
+				for (size_t iTexel = 0; iTexel < vPaddedRow.size(); ++iTexel)
+				{
+					const int KX{ min(max(static_cast<int>(iTexel) - KKernelRadius, 0), static_cast<int>(Heights.Width) - 1) };
+					vPaddedRow[iTexel] = PtrRow[KX];
+				}
+
+				float* const PtrBlurredRow{ Blurred.GetRow(Y) };
+				for (uint32_t X = 0; X < Heights.Width; X += 4)
+				{
+					XMVECTOR Sum{ XMVectorZero() };
+					for (size_t iTap = 0; iTap < vWeights.size(); ++iTap)
+					{
+						Sum = XMVectorMultiplyAdd(XMVectorReplicate(vWeights[iTap]), Load4(&vPaddedRow[X + iTap]), Sum);
+					}
+					Store4(PtrBlurredRow + X, Sum);
+				}
+			}
+		});
+
+	ForEachTile(Heights.Height, KTexelCount, ThreadCount, [&](uint32_t Top, uint32_t Bottom)
+		{
+			for (uint32_t Y = Top; Y < Bottom; ++Y)
+			{
+				float* const PtrRow{ Heights.GetRow(Y) };
+				const float* const PtrMaskRow{ Mask.GetRow(Y) };
+				for (uint32_t X = 0; X < Heights.Width; X += 4)
+				{
+					XMVECTOR Sum{ XMVectorZero() };
+					for (int iTap = -KKernelRadius; iTap <= KKernelRadius; ++iTap)
+					{
+						const int KY{ min(max(static_cast<int>(Y) + iTap, 0), static_cast<int>(Heights.Height) - 1) };
+						Sum = XMVectorMultiplyAdd(XMVectorReplicate(vWeights[iTap + KKernelRadius]), Load4(Blurred.GetRow(KY) + X), Sum);
+					}
+					const XMVECTOR KHeight{ Load4(PtrRow + X) };
+					Store4(PtrRow + X, XMVectorMultiplyAdd(Load4(PtrMaskRow + X), XMVectorSubtract(Sum, KHeight), KHeight));
+				}
+			}
+		});
+}
+
+// Flatten and Noise: Height += Mask * (Function(U, V, Height) - Height), where U, V are in height map texels
+template<typename TFunction>
+static void BlendTowards(SGrid& Heights, const SGrid& Mask, uint32_t Left, uint32_t Top, uint32_t ThreadCount, const TFunction& Function)
+{
+	const XMVECTOR KLaneOffsets{ XMVectorSet(0, 1, 2, 3) };
+	ForEachTile(Heights.Height, static_cast<size_t>(Heights.Width) * Heights.Height, ThreadCount, [&](uint32_t TileTop, uint32_t TileBottom)
+		{
+			for (uint32_t Y = TileTop; Y < TileBottom; ++Y)
+			{
+				float* const PtrRow{ Heights.GetRow(Y) };
+				const float* const PtrMaskRow{ Mask.GetRow(Y) };
+				const XMVECTOR KV{ XMVectorReplicate(static_cast<float>(Top + Y)) };
+				for (uint32_t X = 0; X < Heights.Width; X += 4)
+				{
+					const XMVECTOR KU{ XMVectorAdd(XMVectorReplicate(static_cast<float>(Left + X)), KLaneOffsets) };
+					const XMVECTOR KHeight{ Load4(PtrRow + X) };
+					const XMVECTOR KTarget{ Function(KU, KV, KHeight) };
+					Store4(PtrRow + X, XMVectorMultiplyAdd(Load4(PtrMaskRow + X), XMVectorSubtract(KTarget, KHeight), KHeight));
+				}
+			}
+		});
+}
+
+// Each texel moves material to (and takes it from) its 4 neighbours by how much their height difference exceeds the talus
+// The flow over an edge is weighted by the smaller mask of its texels, so it is symmetric (the material is preserved)
+// and texels outside the brush never change
+static void ErodeThermally(SGrid& Heights, const SGrid& Mask, const CTerrainBrush::SDesc& Desc, uint32_t ThreadCount, size_t& PassCount)
+{
+	const XMVECTOR KTalus{ XMVectorReplicate(max(Desc.TalusSteps, 0.0f)) };
+	const XMVECTOR KNegativeTalus{ XMVectorNegate(KTalus) };
+	const XMVECTOR KRate{ XMVectorReplicate(KThermalRate) };
+	SGrid Eroded{ Heights.Width, Heights.Height };
+	for (uint32_t iIteration = 0; iIteration < Desc.ErosionIterationCount; ++iIteration)
+	{
+		ForEachTile(Heights.Height, static_cast<size_t>(Heights.Width) * Heights.Height, ThreadCount, [&](uint32_t Top, uint32_t Bottom)
+			{
+				for (uint32_t Y = Top; Y < Bottom; ++Y)
+				{
+					const int KY{ static_cast<int>(Y) };
+					const float* const PtrRows[3]{ Heights.GetRow(KY - 1), Heights.GetRow(KY), Heights.GetRow(KY + 1) };
+					const float* const PtrMaskRows[3]{ Mask.GetRow(KY - 1), Mask.GetRow(KY), Mask.GetRow(KY + 1) };
+					float* const PtrErodedRow{ Eroded.GetRow(Y) };
+					for (uint32_t X = 0; X < Heights.Width; X += 4)
+					{
+						const XMVECTOR KHeight{ Load4(PtrRows[1] + X) };
+						const XMVECTOR KMask{ Load4(PtrMaskRows[1] + X) };
+						const float* const PtrNeighbours[4]{ PtrRows[1] + X - 1, PtrRows[1] + X + 1, PtrRows[0] + X, PtrRows[2] + X };
+						const float* const PtrNeighbourMasks[4]{ PtrMaskRows[1] + X - 1, PtrMaskRows[1] + X + 1, PtrMaskRows[0] + X, PtrMaskRows[2] + X };
+
+						XMVECTOR Outflow{ XMVectorZero() };
+						for (int iNeighbour = 0; iNeighbour < 4; ++iNeighbour)
+						{
+							const XMVECTOR KDifference{ XMVectorSubtract(KHeight, Load4(PtrNeighbours[iNeighbour])) };
+							const XMVECTOR KExcess{ XMVectorSubtract(KDifference, XMVectorClamp(KDifference, KNegativeTalus, KTalus)) };
+							Outflow = XMVectorMultiplyAdd(XMVectorMin(KMask, Load4(PtrNeighbourMasks[iNeighbour])), KExcess, Outflow);
+						}
+						Store4(PtrErodedRow + X, XMVectorNegativeMultiplySubtract(KRate, Outflow, KHeight));
+					}
+				}
+			});
+		swap(Heights.vValues, Eroded.vValues);
+		++PassCount;
+	}
+}
+
+struct SHydraulicState
+{
+	SHydraulicState(uint32_t Width, uint32_t Height) : Water{ Width, Height }, Sediment{ Width, Height } {}
+
+	SGrid	Water;
+	SGrid	Sediment;
+};
+
+// Grid-based hydraulic erosion, every iteration:
+// 1) rain falls (Water += RainAmount * Mask) and dissolves material (Solubility * Water moves from Height to Sediment)
+// 2) water flows to the neighbours whose water surface is lower (at most the water the source has), carrying its sediment along
+// 3) water evaporates and the sediment above the capacity of what is left is deposited
+// Flows are weighted by the smaller mask of an edge's texels like ErodeThermally(); what is left as sediment is deposited at the end
+static void ErodeHydraulically(SGrid& Heights, const SGrid& Mask, const CTerrainBrush::SDesc& Desc, uint32_t ThreadCount,
+	size_t& PassCount)
+{
+	const XMVECTOR KRain{ XMVectorReplicate(max(Desc.RainAmount, 0.0f)) };
+	const XMVECTOR KSolubility{ XMVectorReplicate(max(Desc.Solubility, 0.0f)) };
+	const XMVECTOR KRetention{ XMVectorReplicate(1.0f - min(max(Desc.Evaporation, 0.0f), 1.0f)) };
+	const XMVECTOR KCapacity{ XMVectorReplicate(max(Desc.SedimentCapacity, 0.0f)) };
+	const XMVECTOR KFlowRate{ XMVectorReplicate(KWaterFlowRate) };
+	const XMVECTOR KMinWaterVector{ XMVectorReplicate(KMinWater) };
+	const XMVECTOR KZero{ XMVectorZero() };
+
+	// Step 1 is done on the fly for a texel and its neighbours
+	auto Rain{ [&](const float* const PtrHeight, const float* const PtrWater, const float* const PtrSediment, const float* const PtrMask,
+		XMVECTOR& OutHeight, XMVECTOR& OutWater, XMVECTOR& OutSediment)
+		{
+			OutWater = XMVectorMultiplyAdd(KRain, Load4(PtrMask), Load4(PtrWater));
+			const XMVECTOR KDissolved{ XMVectorMultiply(KSolubility, OutWater) };
+			OutHeight = XMVectorSubtract(Load4(PtrHeight), KDissolved);
+			OutSediment = XMVectorAdd(Load4(PtrSediment), KDissolved);
+		} };
+
+	const size_t KTexelCount{ static_cast<size_t>(Heights.Width) * Heights.Height };
+	SHydraulicState State{ Heights.Width, Heights.Height };
+	SGrid NextHeights{ Heights.Width, Heights.Height };
+	SHydraulicState NextState{ Heights.Width, Heights.Height };
+	for (uint32_t iIteration = 0; iIteration < Desc.ErosionIterationCount; ++iIteration)
+	{
+		ForEachTile(Heights.Height, KTexelCount, ThreadCount, [&](uint32_t Top, uint32_t Bottom)
+			{
+				for (uint32_t Y = Top; Y < Bottom; ++Y)
+				{
+					const int KRows[3]{ static_cast<int>(Y), static_cast<int>(Y) - 1, static_cast<int>(Y) + 1 };
+					for (uint32_t X = 0; X < Heights.Width; X += 4)
+					{
+						// [0] is the texel itself, [1 ~ 4] are its neighbours
+						const int KOffsets[5][2]{ { 0, 0 }, { -1, 0 }, { +1, 0 }, { 0, 1 }, { 0, 2 } };
+						XMVECTOR Height[5]{};
+						XMVECTOR Water[5]{};
+						XMVECTOR Sediment[5]{};
+						XMVECTOR EdgeMask[5]{};
+						for (int iTexel = 0; iTexel < 5; ++iTexel)
+						{
+							const int KRow{ KRows[KOffsets[iTexel][1]] };
+							const size_t KX{ static_cast<size_t>(static_cast<int>(X) + KOffsets[iTexel][0]) };
+							Rain(Heights.GetRow(KRow) + KX, State.Water.GetRow(KRow) + KX, State.Sediment.GetRow(KRow) + KX,
+								Mask.GetRow(KRow) + KX, Height[iTexel], Water[iTexel], Sediment[iTexel]);
+							EdgeMask[iTexel] = Load4(Mask.GetRow(KRow) + KX);
+						}
+
+						const XMVECTOR KConcentration{ XMVectorDivide(Sediment[0], XMVectorMax(Water[0], KMinWaterVector)) };
+						XMVECTOR NewWater{ Water[0] };
+						XMVECTOR NewSediment{ Sediment[0] };
+						for (int iNeighbour = 1; iNeighbour < 5; ++iNeighbour)
+						{
+							// Positive: from the texel to the neighbour
+							const XMVECTOR KSurfaceDifference{ XMVectorSubtract(XMVectorAdd(Height[0], Water[0]),
+								XMVectorAdd(Height[iNeighbour], Water[iNeighbour])) };
+							const XMVECTOR KFlow{ XMVectorMultiply(XMVectorMultiply(KFlowRate, XMVectorMin(EdgeMask[0], EdgeMask[iNeighbour])),
+								XMVectorClamp(KSurfaceDifference, XMVectorNegate(Water[iNeighbour]), Water[0])) };
+							const XMVECTOR KNeighbourConcentration{ XMVectorDivide(Sediment[iNeighbour],
+								XMVectorMax(Water[iNeighbour], KMinWaterVector)) };
+							const XMVECTOR KSourceConcentration{ XMVectorSelect(KNeighbourConcentration, KConcentration,
+								XMVectorGreater(KFlow, KZero)) };
+
+							NewWater = XMVectorSubtract(NewWater, KFlow);
+							NewSediment = XMVectorNegativeMultiplySubtract(KFlow, KSourceConcentration, NewSediment);
+						}
+
+						NewWater = XMVectorMultiply(NewWater, KRetention);
+						const XMVECTOR KDeposited{ XMVectorMax(XMVectorNegativeMultiplySubtract(KCapacity, NewWater, NewSediment), KZero) };
+						Store4(NextHeights.GetRow(Y) + X, XMVectorAdd(Height[0], KDeposited));
+						Store4(NextState.Water.GetRow(Y) + X, NewWater);
+						Store4(NextState.Sediment.GetRow(Y) + X, XMVectorSubtract(NewSediment, KDeposited));
+					}
+				}
+			});
+		swap(Heights.vValues, NextHeights.vValues);
+		swap(State.Water.vValues, NextState.Water.vValues);
+		swap(State.Sediment.vValues, NextState.Sediment.vValues);
+		++PassCount;
+	}
+
+	for (size_t iValue = 0; iValue < Heights.vValues.size(); ++iValue)
+	{
+		Heights.vValues[iValue] += State.Sediment.vValues[iValue];
+	}
+}
+
+void CTerrainBrush::Apply(SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, float CenterU, float CenterV, const SDesc& Desc,
+	CMipGenerator::SRect& OutDirtyRect, SStats* const PtrOutStats)
+{
+	assert(PtrHeights);
+
+	OutDirtyRect = CMipGenerator::SRect();
+	if (PtrOutStats) *PtrOutStats = SStats();
+	if (Desc.Radius <= 0.0f || Desc.Strength <= 0.0f) return;
+
+	// Texels within the radius
+	CMipGenerator::SRect BrushRect{};
+	BrushRect.Left = static_cast<uint32_t>(min(max(ceilf(CenterU - Desc.Radius), 0.0f), static_cast<float>(Width)));
+	BrushRect.Top = static_cast<uint32_t>(min(max(ceilf(CenterV - Desc.Radius), 0.0f), static_cast<float>(Height)));
+	BrushRect.Right = static_cast<uint32_t>(min(max(floorf(CenterU + Desc.Radius) + 1.0f, 0.0f), static_cast<float>(Width)));
+	BrushRect.Bottom = static_cast<uint32_t>(min(max(floorf(CenterV + Desc.Radius) + 1.0f, 0.0f), static_cast<float>(Height)));
+	if (BrushRect.IsEmpty()) return;
+
+	// Texels the kernel reads
+	uint32_t Apron{};
+	if (Desc.eType == EType::Smooth) Apron = max(static_cast<uint32_t>(ceilf(Desc.SmoothSigma * 3.0f)), 1u);
+	if (Desc.eType == EType::ThermalErosion || Desc.eType == EType::HydraulicErosion) Apron = 1;
+	CMipGenerator::SRect WorkingRect{};
+	WorkingRect.Left = (BrushRect.Left > Apron) ? BrushRect.Left - Apron : 0;
+	WorkingRect.Top = (BrushRect.Top > Apron) ? BrushRect.Top - Apron : 0;
+	WorkingRect.Right = min(BrushRect.Right + Apron, Width);
+	WorkingRect.Bottom = min(BrushRect.Bottom + Apron, Height);
+
+	const uint32_t KThreadCount{ Desc.ThreadCount };
+	SGrid Heights{ WorkingRect.Right - WorkingRect.Left, WorkingRect.Bottom - WorkingRect.Top };
+	SGrid Mask{ Heights.Width, Heights.Height };
+	const size_t KTexelCount{ static_cast<size_t>(Heights.Width) * Heights.Height };
+	const XMVECTOR KLaneOffsets{ XMVectorSet(0, 1, 2, 3) };
+	ForEachTile(Heights.Height, KTexelCount, KThreadCount, [&](uint32_t Top, uint32_t Bottom)
+		{
+			for (uint32_t Y = Top; Y < Bottom; ++Y)
+			{
+				const SPixel8UInt* const PtrSourceRow{ PtrHeights + static_cast<size_t>(WorkingRect.Top + Y) * Width + WorkingRect.Left };
+				float* const PtrRow{ Heights.GetRow(Y) };
+				float* const PtrMaskRow{ Mask.GetRow(Y) };
+				uint32_t X{};
+				for (; X + 4 <= Heights.Width; X += 4)
+				{
+					Store4(PtrRow + X, XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(&PtrSourceRow[X].R)));
+				}
+				for (; X < Heights.Width; ++X)
+				{
+					PtrRow[X] = PtrSourceRow[X].R;
+				}
+
+				const XMVECTOR KDistanceV{ XMVectorReplicate(static_cast<float>(WorkingRect.Top + Y) - CenterV) };
+				for (X = 0; X < Heights.Width; X += 4)
+				{
+					const XMVECTOR KDistanceU{ XMVectorAdd(XMVectorReplicate(static_cast<float>(WorkingRect.Left + X) - CenterU), KLaneOffsets) };
+					const XMVECTOR KDistance{ XMVectorSqrt(XMVectorMultiplyAdd(KDistanceU, KDistanceU, XMVectorMultiply(KDistanceV, KDistanceV))) };
+					Store4(PtrMaskRow + X, XMVectorScale(CalculateFalloff(KDistance, Desc.Radius, Desc.Hardness), min(Desc.Strength, 1.0f)));
+				}
+				for (X = Heights.Width; X < (Heights.Width + 3) / 4 * 4; ++X)
+				{
+					PtrMaskRow[X] = 0.0f;
+				}
+			}
+		});
+
+	size_t PassCount{ 1 };
+	switch (Desc.eType)
+	{
+	case EType::Smooth:
+		Smooth(Heights, Mask, Desc, KThreadCount);
+		PassCount = 2;
+		break;
+	case EType::Flatten:
+	{
+		const XMVECTOR KCenterHeight{ XMVectorReplicate(Desc.PlaneHeight) };
+		const XMVECTOR KCenterU{ XMVectorReplicate(CenterU) };
+		const XMVECTOR KCenterV{ XMVectorReplicate(CenterV) };
+		const XMVECTOR KSlopeU{ XMVectorReplicate(Desc.PlaneSlope.x) };
+		const XMVECTOR KSlopeV{ XMVectorReplicate(Desc.PlaneSlope.y) };
+		BlendTowards(Heights, Mask, WorkingRect.Left, WorkingRect.Top, KThreadCount, [&](FXMVECTOR U, FXMVECTOR V, FXMVECTOR)
+			{
+				const XMVECTOR KPlaneHeight{ XMVectorMultiplyAdd(KSlopeU, XMVectorSubtract(U, KCenterU), KCenterHeight) };
+				return XMVectorMultiplyAdd(KSlopeV, XMVectorSubtract(V, KCenterV), KPlaneHeight);
+			});
+	} break;
+	case EType::Noise:
+	{
+		float AmplitudeSum{};
+		for (uint32_t iOctave = 0; iOctave < Desc.NoiseOctaveCount; ++iOctave) AmplitudeSum += 1.0f / static_cast<float>(1 << iOctave);
+		if (AmplitudeSum <= 0.0f) return;
+
+		const float KAmplitude{ Desc.NoiseAmplitude / AmplitudeSum };
+		BlendTowards(Heights, Mask, WorkingRect.Left, WorkingRect.Top, KThreadCount, [&](FXMVECTOR U, FXMVECTOR V, FXMVECTOR Height)
+			{
+				// fBm: every octave doubles the frequency and halves the amplitude
+				XMVECTOR Sum{ XMVectorZero() };
+				float Frequency{ Desc.NoiseFrequency };
+				float Amplitude{ KAmplitude };
+				for (uint32_t iOctave = 0; iOctave < Desc.NoiseOctaveCount; ++iOctave)
+				{
+					const XMVECTOR KNoise{ ValueNoise(XMVectorScale(U, Frequency), XMVectorScale(V, Frequency), Desc.NoiseSeed + iOctave) };
+					Sum = XMVectorMultiplyAdd(XMVectorReplicate(Amplitude), KNoise, Sum);
+					Frequency *= 2.0f;
+					Amplitude *= 0.5f;
+				}
+				return XMVectorAdd(Height, Sum);
+			});
+	} break;
+	case EType::ThermalErosion:
+		PassCount = 0;
+		ErodeThermally(Heights, Mask, Desc, KThreadCount, PassCount);
+		break;
+	case EType::HydraulicErosion:
+		PassCount = 0;
+		ErodeHydraulically(Heights, Mask, Desc, KThreadCount, PassCount);
+		break;
+	default:
+		break;
+	}
+
+	// Ordered dithering keeps the average of fractional changes (integer heights stay as they are)
+	static constexpr float KBayerMatrix[4][4]{ { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+	const uint32_t KBrushTileCount{ (BrushRect.Bottom - BrushRect.Top + KTileRowCount - 1) / KTileRowCount };
+	vector<CMipGenerator::SRect> vTileDirtyRects(KBrushTileCount, CMipGenerator::SRect{ Width, Height, 0, 0 });
+	vector<size_t> vTileChangedTexelCounts(KBrushTileCount);
+	const XMVECTOR KMaxHeight{ XMVectorReplicate(255.0f) };
+	ForEachTile(BrushRect.Bottom - BrushRect.Top, KTexelCount, KThreadCount, [&](uint32_t Top, uint32_t Bottom)
+		{
+			CMipGenerator::SRect& TileDirtyRect{ vTileDirtyRects[Top / KTileRowCount] };
+			size_t& TileChangedTexelCount{ vTileChangedTexelCounts[Top / KTileRowCount] };
+			for (uint32_t V = BrushRect.Top + Top; V < BrushRect.Top + Bottom; ++V)
+			{
+				SPixel8UInt* const PtrDestRow{ PtrHeights + static_cast<size_t>(V) * Width };
+				const float* const PtrRow{ Heights.GetRow(V - WorkingRect.Top) };
+				const float* const PtrMaskRow{ Mask.GetRow(V - WorkingRect.Top) };
+				const XMVECTOR KDither{ XMVectorScale(XMVectorAdd(XMVectorSet(
+					KBayerMatrix[V & 3][BrushRect.Left & 3], KBayerMatrix[V & 3][(BrushRect.Left + 1) & 3],
+					KBayerMatrix[V & 3][(BrushRect.Left + 2) & 3], KBayerMatrix[V & 3][(BrushRect.Left + 3) & 3]),
+					XMVectorReplicate(0.5f)), 1.0f / 16.0f) };
+				for (uint32_t U = BrushRect.Left; U < BrushRect.Right; U += 4)
+				{
+					const uint32_t KX{ U - WorkingRect.Left };
+					const XMVECTOR KNewHeights{ XMVectorClamp(XMVectorFloor(XMVectorAdd(Load4(PtrRow + KX), KDither)), XMVectorZero(), KMaxHeight) };
+					int32_t NewHeights[4]{};
+					XMStoreInt4(reinterpret_cast<uint32_t*>(NewHeights), XMConvertVectorFloatToInt(KNewHeights, 0));
+					for (uint32_t iLane = 0; iLane < 4 && U + iLane < BrushRect.Right; ++iLane)
+					{
+						if (PtrMaskRow[KX + iLane] <= 0.0f) continue;
+						if (NewHeights[iLane] == PtrDestRow[U + iLane].R) continue;
+
+						PtrDestRow[U + iLane].R = static_cast<uint8_t>(NewHeights[iLane]);
+						++TileChangedTexelCount;
+						TileDirtyRect.Left = min(TileDirtyRect.Left, U + iLane);
+						TileDirtyRect.Top = min(TileDirtyRect.Top, V);
+						TileDirtyRect.Right = max(TileDirtyRect.Right, U + iLane + 1);
+						TileDirtyRect.Bottom = max(TileDirtyRect.Bottom, V + 1);
+					}
+				}
+			}
+		});
+
+	size_t ChangedTexelCount{};
+	for (uint32_t iTile = 0; iTile < KBrushTileCount; ++iTile)
+	{
+		if (!vTileChangedTexelCounts[iTile]) continue;
+
+		const CMipGenerator::SRect& TileDirtyRect{ vTileDirtyRects[iTile] };
+		OutDirtyRect = (ChangedTexelCount) ? CMipGenerator::SRect{ min(OutDirtyRect.Left, TileDirtyRect.Left),
+			min(OutDirtyRect.Top, TileDirtyRect.Top), max(OutDirtyRect.Right, TileDirtyRect.Right),
+			max(OutDirtyRect.Bottom, TileDirtyRect.Bottom) } : TileDirtyRect;
+		ChangedTexelCount += vTileChangedTexelCounts[iTile];
+	}
+
+	if (PtrOutStats)
+	{
+		PtrOutStats->WorkingTexelCount = KTexelCount;
+		PtrOutStats->TileCount = (Heights.Height + KTileRowCount - 1) / KTileRowCount;
+		PtrOutStats->PassCount = PassCount;
+		PtrOutStats->ChangedTexelCount = ChangedTexelCount;
+	}
+}
+
+float CTerrainBrush::GetFalloff(float Distance, float Radius, float Hardness)
+{
+	return XMVectorGetX(CalculateFalloff(XMVectorReplicate(Distance), Radius, Hardness));
+}
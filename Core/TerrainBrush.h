@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MipGenerator.h"
+
+// Sculpts an 8-bit height map with a round brush
+// A dab copies the brush's square (plus the texels its kernel reads) to a float working region, filters it there 4 texels at a time
+// in tiles of rows spread over the shared worker pool, and writes it back dithered (so that changes smaller than a step still add up)
+// A dab's cost depends only on the brush's area, not on the height map's size
+class CTerrainBrush final
+{
+public:
+	enum class EType
+	{
+		Smooth, // Separable Gaussian
+		Flatten, // Towards a plane
+		Noise, // Adds fBm value noise
+		ThermalErosion, // Material slides down slopes steeper than the talus
+		HydraulicErosion // Rain dissolves material, carries it downhill and deposits it where it evaporates
+	};
+
+	struct SDesc
+	{
+		EType		eType{ EType::Smooth };
+		float		Radius{ 4.0f }; // In texels
+		float		Hardness{ 0.5f }; // Fraction of the radius at full strength, the rest falls off smoothly
+		float		Strength{ 0.5f }; // 0 ~ 1, per dab
+
+		// Smooth
+		float		SmoothSigma{ 1.0f }; // In texels
+
+		// Flatten: the plane's height at the brush center (in steps, 0 ~ 255) and its slope (in steps per texel)
+		float		PlaneHeight{ 127.5f };
+		XMFLOAT2	PlaneSlope{};
+
+		// Noise
+		float		NoiseAmplitude{ 8.0f }; // In steps
+		float		NoiseFrequency{ 0.125f }; // Of the first octave, per texel
+		uint32_t	NoiseOctaveCount{ 4 };
+		uint32_t	NoiseSeed{};
+
+		// Erosion (heights, water and sediment are in steps)
+		uint32_t	ErosionIterationCount{ 16 };
+		float		TalusSteps{ 2.0f }; // Thermal: the largest height difference between neighbours that stays as it is
+		float		RainAmount{ 0.25f }; // Hydraulic: water added per iteration
+		float		Solubility{ 0.1f }; // Hydraulic: material dissolved per unit of water per iteration
+		float		Evaporation{ 0.1f }; // Hydraulic: fraction of the water that evaporates per iteration
+		float		SedimentCapacity{ 1.0f }; // Hydraulic: sediment a unit of water can carry
+
+		uint32_t	ThreadCount{}; // Including the calling thread, 0: every thread of CWorkerPool::GetShared()
+	};
+
+	struct SStats
+	{
+		size_t		WorkingTexelCount{}; // Of the working region
+		size_t		TileCount{}; // Of each pass
+		size_t		PassCount{};
+		size_t		ChangedTexelCount{};
+	};
+
+public:
+	// CenterU, CenterV: in texels
+	// OutDirtyRect: the texels that changed (empty if none did)
+	static void Apply(SPixel8UInt* const PtrHeights, uint32_t Width, uint32_t Height, float CenterU, float CenterV, const SDesc& Desc,
+		CMipGenerator::SRect& OutDirtyRect, SStats* const PtrOutStats = nullptr);
+
+	// In [0, 1], 0 at and outside the radius
+	static float GetFalloff(float Distance, float Radius, float Hardness);
+
+public:
+	static constexpr uint32_t KTileRowCount{ 16 };
+	static constexpr size_t KMultithreadingMinTexelCount{ 128 * 128 };
+};
@@ -0,0 +1,556 @@
+#include "TerrainGenerator.h"
+#include "WorkerPool.h"
+#include <mutex>
+
+static constexpr float KSqrt2{ 1.41421356f };
+static constexpr float KSimplexSkew{ 0.36602540f }; // (sqrt(3) - 1) / 2
+static constexpr float KSimplexUnskew{ 0.21132487f }; // (3 - sqrt(3)) / 6
+static constexpr float KSimplexScale{ 99.0f }; // Unit gradients reach about +-1 / 99
+static constexpr float KOctaveOffset{ 17.31f }; // Keeps the lattices of the octaves from lining up at the origin
+
+// Unit gradients 45 degrees apart
+static constexpr float KGradients[8][2]{
+	{ +1.0f, 0.0f }, { +0.70710678f, +0.70710678f }, { 0.0f, +1.0f }, { -0.70710678f, +0.70710678f },
+	{ -1.0f, 0.0f }, { -0.70710678f, -0.70710678f }, { 0.0f, -1.0f }, { +0.70710678f, -0.70710678f } };
+
+static XMVECTOR Load4(const float* const PtrValues)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(PtrValues));
+}
+
+// Calls Function(Tile) for every KTileSize x KTileSize tile of Width x Height; the shared worker pool pulls the tiles one by one
+template<typename TFunction>
+static void ForEachTile(uint32_t Width, uint32_t Height, uint32_t ThreadCount, size_t& OutTileCount, const TFunction& Function)
+{
+	const uint32_t KTileCountX{ (Width + CTerrainGenerator::KTileSize - 1) / CTerrainGenerator::KTileSize };
+	const uint32_t KTileCount{ KTileCountX * ((Height + CTerrainGenerator::KTileSize - 1) / CTerrainGenerator::KTileSize) };
+	OutTileCount = KTileCount;
+	if (static_cast<size_t>(Width) * Height < CTerrainGenerator::KMultithreadingMinTexelCount) ThreadCount = 1;
+
+	CWorkerPool::GetShared().ForEach(KTileCount, ThreadCount, [&](uint32_t iTile)
+		{
+			CMipGenerator::SRect Tile{};
+			Tile.Left = (iTile % KTileCountX) * CTerrainGenerator::KTileSize;
+			Tile.Top = (iTile / KTileCountX) * CTerrainGenerator::KTileSize;
+			Tile.Right = min(Tile.Left + CTerrainGenerator::KTileSize, Width);
+			Tile.Bottom = min(Tile.Top + CTerrainGenerator::KTileSize, Height);
+			Function(Tile);
+		});
+}
+
+static uint32_t HashLattice(int32_t X, int32_t Z, uint32_t Seed)
+{
+	uint32_t Hash{ static_cast<uint32_t>(X) * 0x27D4EB2Du ^ static_cast<uint32_t>(Z) * 0x165667B1u ^ Seed * 0x9E3779B9u };
+	Hash ^= Hash >> 15;
+	Hash *= 0x2C1B3C6Du;
+	Hash ^= Hash >> 12;
+	Hash *= 0x297A2D39u;
+	Hash ^= Hash >> 15;
+	return Hash;
+}
+
+static uint32_t GetOctaveSeed(uint32_t Seed, const CTerrainGenerator::SNode& Node, uint32_t iOctave)
+{
+	return Seed + Node.SeedOffset * 0x85EBCA6Bu + iOctave * 0xC2B2AE35u;
+}
+
+// Lattice gradients are looked up lane by lane (there is no gather)
+static void GetGradients(const int32_t (&LatticeX)[4], const int32_t (&LatticeZ)[4], int32_t OffsetX, int32_t OffsetZ, uint32_t Seed,
+	XMVECTOR& OutGradientX, XMVECTOR& OutGradientZ)
+{
+	float GradientX[4]{};
+	float GradientZ[4]{};
+	for (int iLane = 0; iLane < 4; ++iLane)
+	{
+		const uint32_t KIndex{ HashLattice(LatticeX[iLane] + OffsetX, LatticeZ[iLane] + OffsetZ, Seed) & 7 };
+		GradientX[iLane] = KGradients[KIndex][0];
+		GradientZ[iLane] = KGradients[KIndex][1];
+	}
+	OutGradientX = Load4(GradientX);
+	OutGradientZ = Load4(GradientZ);
+}
+
+static XMVECTOR GetFade(FXMVECTOR T)
+{
+	// t^3 * (t * (6t - 15) + 10)
+	const XMVECTOR KPolynomial{ XMVectorMultiplyAdd(T, XMVectorSubtract(XMVectorScale(T, 6.0f), XMVectorReplicate(15.0f)),
+		XMVectorReplicate(10.0f)) };
+	return XMVectorMultiply(XMVectorMultiply(T, XMVectorMultiply(T, T)), KPolynomial);
+}
+
+// -1 ~ +1
+static XMVECTOR PerlinNoise(FXMVECTOR X, FXMVECTOR Z, uint32_t Seed)
+{
+	const XMVECTOR KFloorX{ XMVectorFloor(X) };
+	const XMVECTOR KFloorZ{ XMVectorFloor(Z) };
+	const XMVECTOR KX0{ XMVectorSubtract(X, KFloorX) };
+	const XMVECTOR KZ0{ XMVectorSubtract(Z, KFloorZ) };
+	const XMVECTOR KX1{ XMVectorSubtract(KX0, XMVectorSplatOne()) };
+	const XMVECTOR KZ1{ XMVectorSubtract(KZ0, XMVectorSplatOne()) };
+
+	int32_t LatticeX[4]{};
+	int32_t LatticeZ[4]{};
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeX), XMConvertVectorFloatToInt(KFloorX, 0));
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeZ), XMConvertVectorFloatToInt(KFloorZ, 0));
+
+	XMVECTOR GradientX{};
+	XMVECTOR GradientZ{};
+	GetGradients(LatticeX, LatticeZ, 0, 0, Seed, GradientX, GradientZ);
+	const XMVECTOR KDot00{ XMVectorMultiplyAdd(GradientX, KX0, XMVectorMultiply(GradientZ, KZ0)) };
+	GetGradients(LatticeX, LatticeZ, 1, 0, Seed, GradientX, GradientZ);
+	const XMVECTOR KDot10{ XMVectorMultiplyAdd(GradientX, KX1, XMVectorMultiply(GradientZ, KZ0)) };
+	GetGradients(LatticeX, LatticeZ, 0, 1, Seed, GradientX, GradientZ);
+	const XMVECTOR KDot01{ XMVectorMultiplyAdd(GradientX, KX0, XMVectorMultiply(GradientZ, KZ1)) };
+	GetGradients(LatticeX, LatticeZ, 1, 1, Seed, GradientX, GradientZ);
+	const XMVECTOR KDot11{ XMVectorMultiplyAdd(GradientX, KX1, XMVectorMultiply(GradientZ, KZ1)) };
+
+	const XMVECTOR KFadeX{ GetFade(KX0) };
+	const XMVECTOR KTop{ XMVectorLerpV(KDot00, KDot10, KFadeX) };
+	const XMVECTOR KBottom{ XMVectorLerpV(KDot01, KDot11, KFadeX) };
+	return XMVectorScale(XMVectorLerpV(KTop, KBottom, GetFade(KZ0)), KSqrt2);
+}
+
+// -1 ~ +1
+static XMVECTOR SimplexNoise(FXMVECTOR X, FXMVECTOR Z, uint32_t Seed)
+{
+	// The skewed lattice cell and which of its 2 triangles the point is in
+	const XMVECTOR KSkew{ XMVectorScale(XMVectorAdd(X, Z), KSimplexSkew) };
+	const XMVECTOR KCellX{ XMVectorFloor(XMVectorAdd(X, KSkew)) };
+	const XMVECTOR KCellZ{ XMVectorFloor(XMVectorAdd(Z, KSkew)) };
+	const XMVECTOR KUnskew{ XMVectorScale(XMVectorAdd(KCellX, KCellZ), KSimplexUnskew) };
+	const XMVECTOR KX0{ XMVectorSubtract(X, XMVectorSubtract(KCellX, KUnskew)) };
+	const XMVECTOR KZ0{ XMVectorSubtract(Z, XMVectorSubtract(KCellZ, KUnskew)) };
+	const XMVECTOR KIsLowerTriangle{ XMVectorGreater(KX0, KZ0) };
+	const XMVECTOR KOffsetX{ XMVectorSelect(XMVectorZero(), XMVectorSplatOne(), KIsLowerTriangle) };
+	const XMVECTOR KOffsetZ{ XMVectorSubtract(XMVectorSplatOne(), KOffsetX) };
+	const XMVECTOR KUnskewVector{ XMVectorReplicate(KSimplexUnskew) };
+	const XMVECTOR KX1{ XMVectorAdd(XMVectorSubtract(KX0, KOffsetX), KUnskewVector) };
+	const XMVECTOR KZ1{ XMVectorAdd(XMVectorSubtract(KZ0, KOffsetZ), KUnskewVector) };
+	const XMVECTOR KLastOffset{ XMVectorReplicate(2.0f * KSimplexUnskew - 1.0f) };
+	const XMVECTOR KX2{ XMVectorAdd(KX0, KLastOffset) };
+	const XMVECTOR KZ2{ XMVectorAdd(KZ0, KLastOffset) };
+
+	int32_t LatticeX[4]{};
+	int32_t LatticeZ[4]{};
+	int32_t MiddleX[4]{};
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeX), XMConvertVectorFloatToInt(KCellX, 0));
+	XMStoreInt4(reinterpret_cast<uint32_t*>(LatticeZ), XMConvertVectorFloatToInt(KCellZ, 0));
+	XMStoreInt4(reinterpret_cast<uint32_t*>(MiddleX), XMConvertVectorFloatToInt(KOffsetX, 0));
+
+	// Each corner adds (0.5 - d^2)^4 * dot(gradient, offset)
+	auto GetContribution{ [](FXMVECTOR OffsetX, FXMVECTOR OffsetZ, FXMVECTOR GradientX, GXMVECTOR GradientZ)
+		{
+			XMVECTOR Attenuation{ XMVectorMax(XMVectorSubtract(XMVectorReplicate(0.5f),
+				XMVectorMultiplyAdd(OffsetX, OffsetX, XMVectorMultiply(OffsetZ, OffsetZ))), XMVectorZero()) };
+			Attenuation = XMVectorMultiply(Attenuation, Attenuation);
+			Attenuation = XMVectorMultiply(Attenuation, Attenuation);
+			return XMVectorMultiply(Attenuation, XMVectorMultiplyAdd(GradientX, OffsetX, XMVectorMultiply(GradientZ, OffsetZ)));
+		} };
+
+	XMVECTOR GradientX{};
+	XMVECTOR GradientZ{};
+	GetGradients(LatticeX, LatticeZ, 0, 0, Seed, GradientX, GradientZ);
+	XMVECTOR Sum{ GetContribution(KX0, KZ0, GradientX, GradientZ) };
+
+	float MiddleGradientX[4]{};
+	float MiddleGradientZ[4]{};
+	for (int iLane = 0; iLane < 4; ++iLane)
+	{
+		const uint32_t KIndex{ HashLattice(LatticeX[iLane] + MiddleX[iLane], LatticeZ[iLane] + 1 - MiddleX[iLane], Seed) & 7 };
+		MiddleGradientX[iLane] = KGradients[KIndex][0];
+		MiddleGradientZ[iLane] = KGradients[KIndex][1];
+	}
+	Sum = XMVectorAdd(Sum, GetContribution(KX1, KZ1, Load4(MiddleGradientX), Load4(MiddleGradientZ)));
+
+	GetGradients(LatticeX, LatticeZ, 1, 1, Seed, GradientX, GradientZ);
+	Sum = XMVectorAdd(Sum, GetContribution(KX2, KZ2, GradientX, GradientZ));
+	return XMVectorClamp(XMVectorScale(Sum, KSimplexScale), XMVectorNegate(XMVectorSplatOne()), XMVectorSplatOne());
+}
+
+// Octaves of Noise, normalized by the sum of their amplitudes
+template<typename TNoise>
+static XMVECTOR EvaluateFBm(const CTerrainGenerator::SNode& Node, uint32_t Seed, FXMVECTOR X, FXMVECTOR Z, const TNoise& Noise)
+{
+	XMVECTOR Sum{ XMVectorZero() };
+	float Frequency{ Node.Frequency };
+	float Amplitude{ 1.0f };
+	float AmplitudeSum{};
+	for (uint32_t iOctave = 0; iOctave < Node.OctaveCount; ++iOctave)
+	{
+		const XMVECTOR KOffset{ XMVectorReplicate(KOctaveOffset * static_cast<float>(iOctave)) };
+		const XMVECTOR KNoise{ Noise(XMVectorMultiplyAdd(X, XMVectorReplicate(Frequency), KOffset),
+			XMVectorMultiplyAdd(Z, XMVectorReplicate(Frequency), KOffset), GetOctaveSeed(Seed, Node, iOctave)) };
+		Sum = XMVectorMultiplyAdd(XMVectorReplicate(Amplitude), KNoise, Sum);
+		AmplitudeSum += Amplitude;
+		Frequency *= Node.Lacunarity;
+		Amplitude *= Node.Gain;
+	}
+	return (AmplitudeSum > 0.0f) ? XMVectorScale(Sum, 1.0f / AmplitudeSum) : Sum;
+}
+
+static XMVECTOR EvaluateRidged(const CTerrainGenerator::SNode& Node, uint32_t Seed, FXMVECTOR X, FXMVECTOR Z)
+{
+	// Every octave's crests (1 - |noise|)^2 are weighted by the previous octave's, so the detail gathers along the ridges
+	XMVECTOR Sum{ XMVectorZero() };
+	XMVECTOR Weight{ XMVectorSplatOne() };
+	float Frequency{ Node.Frequency };
+	float Amplitude{ 1.0f };
+	float AmplitudeSum{};
+	for (uint32_t iOctave = 0; iOctave < Node.OctaveCount; ++iOctave)
+	{
+		const XMVECTOR KOffset{ XMVectorReplicate(KOctaveOffset * static_cast<float>(iOctave)) };
+		const XMVECTOR KNoise{ PerlinNoise(XMVectorMultiplyAdd(X, XMVectorReplicate(Frequency), KOffset),
+			XMVectorMultiplyAdd(Z, XMVectorReplicate(Frequency), KOffset), GetOctaveSeed(Seed, Node, iOctave)) };
+		XMVECTOR Crest{ XMVectorSubtract(XMVectorSplatOne(), XMVectorAbs(KNoise)) };
+		Crest = XMVectorMultiply(XMVectorMultiply(Crest, Crest), Weight);
+		Weight = XMVectorSaturate(XMVectorScale(Crest, 2.0f));
+		Sum = XMVectorMultiplyAdd(XMVectorReplicate(Amplitude), Crest, Sum);
+		AmplitudeSum += Amplitude;
+		Frequency *= Node.Lacunarity;
+		Amplitude *= Node.Gain;
+	}
+	if (AmplitudeSum <= 0.0f) return Sum;
+	return XMVectorSubtract(XMVectorScale(Sum, 2.0f / AmplitudeSum), XMVectorSplatOne());
+}
+
+static XMVECTOR EvaluateTerrace(const CTerrainGenerator::SNode& Node, FXMVECTOR Value)
+{
+	const float KCount{ static_cast<float>(max(Node.TerraceCount, 1u)) };
+	const float KSharpness{ min(max(Node.TerraceSharpness, 0.0f), 0.999f) };
+	const XMVECTOR KT{ XMVectorScale(XMVectorMultiplyAdd(Value, XMVectorReplicate(0.5f), XMVectorReplicate(0.5f)), KCount) };
+	const XMVECTOR KStep{ XMVectorFloor(KT) };
+
+	// Flat for the first KSharpness of a step, then a smooth ramp up to the next one
+	XMVECTOR Ramp{ XMVectorSaturate(XMVectorScale(XMVectorSubtract(XMVectorSubtract(KT, KStep), XMVectorReplicate(KSharpness)),
+		1.0f / (1.0f - KSharpness))) };
+	Ramp = XMVectorMultiply(XMVectorMultiply(Ramp, Ramp), XMVectorNegativeMultiplySubtract(XMVectorReplicate(2.0f), Ramp, XMVectorReplicate(3.0f)));
+	return XMVectorSubtract(XMVectorScale(XMVectorAdd(KStep, Ramp), 2.0f / KCount), XMVectorSplatOne());
+}
+
+static XMVECTOR EvaluateCurve(const CTerrainGenerator::SNode& Node, FXMVECTOR Value)
+{
+	const auto& vPoints{ Node.vCurvePoints };
+	if (vPoints.empty()) return Value;
+
+	// The output of the first point plus every segment's rise times how far along it the value is
+	XMVECTOR Result{ XMVectorReplicate(vPoints[0].y) };
+	for (size_t iPoint = 1; iPoint < vPoints.size(); ++iPoint)
+	{
+		const XMFLOAT2& KFrom{ vPoints[iPoint - 1] };
+		const XMFLOAT2& KTo{ vPoints[iPoint] };
+		const float KWidth{ KTo.x - KFrom.x };
+		const XMVECTOR KProgress{ (KWidth > 0.0f) ?
+			XMVectorSaturate(XMVectorScale(XMVectorSubtract(Value, XMVectorReplicate(KFrom.x)), 1.0f / KWidth)) :
+			XMVectorSelect(XMVectorZero(), XMVectorSplatOne(), XMVectorGreaterOrEqual(Value, XMVectorReplicate(KFrom.x))) };
+		Result = XMVectorMultiplyAdd(KProgress, XMVectorReplicate(KTo.y - KFrom.y), Result);
+	}
+	return Result;
+}
+
+// 0 ~ 1 inside Range, ramps down to 0 over Falloff outside it
+static XMVECTOR GetBand(FXMVECTOR Value, const XMFLOAT2& Range, float Falloff)
+{
+	if (Falloff <= 0.0f)
+	{
+		const XMVECTOR KIsInside{ XMVectorAndInt(XMVectorGreaterOrEqual(Value, XMVectorReplicate(Range.x)),
+			XMVectorLessOrEqual(Value, XMVectorReplicate(Range.y))) };
+		return XMVectorSelect(XMVectorZero(), XMVectorSplatOne(), KIsInside);
+	}
+
+	const XMVECTOR KLower{ XMVectorSaturate(XMVectorScale(XMVectorSubtract(Value, XMVectorReplicate(Range.x - Falloff)), 1.0f / Falloff)) };
+	const XMVECTOR KUpper{ XMVectorSaturate(XMVectorScale(XMVectorSubtract(XMVectorReplicate(Range.y + Falloff), Value), 1.0f / Falloff)) };
+	return XMVectorMultiply(KLower, KUpper);
+}
+
+bool CTerrainGenerator::IsValid(const SGraph& Graph)
+{
+	if (Graph.vNodes.empty()) return false;
+
+	for (size_t iNode = 0; iNode < Graph.vNodes.size(); ++iNode)
+	{
+		const SNode& Node{ Graph.vNodes[iNode] };
+		int RequiredInputCount{};
+		switch (Node.eType)
+		{
+		case ENodeType::DomainWarp:
+			RequiredInputCount = 2; // Input 2 is optional
+			break;
+		case ENodeType::Add:
+		case ENodeType::Multiply:
+			RequiredInputCount = 2;
+			break;
+		case ENodeType::Terrace:
+		case ENodeType::Curve:
+		case ENodeType::ScaleBias:
+			RequiredInputCount = 1;
+			break;
+		default:
+			break;
+		}
+
+		for (int iInput = 0; iInput < 3; ++iInput)
+		{
+			const int KInput{ Node.Inputs[iInput] };
+			if (KInput < 0 && iInput < RequiredInputCount) return false;
+			if (KInput >= static_cast<int>(iNode)) return false;
+		}
+	}
+	return true;
+}
+
+CTerrainGenerator::SGraph CTerrainGenerator::GetDefaultGraph(uint32_t Seed)
+{
+	SGraph Graph{};
+	Graph.Seed = Seed;
+	auto AddNode{ [&](ENodeType eType, int Input0 = -1, int Input1 = -1, int Input2 = -1)
+		{
+			Graph.vNodes.emplace_back();
+			Graph.vNodes.back().eType = eType;
+			Graph.vNodes.back().Inputs[0] = Input0;
+			Graph.vNodes.back().Inputs[1] = Input1;
+			Graph.vNodes.back().Inputs[2] = Input2;
+			Graph.vNodes.back().SeedOffset = static_cast<uint32_t>(Graph.vNodes.size());
+			return static_cast<int>(Graph.vNodes.size() - 1);
+		} };
+
+	const int KRidges{ AddNode(ENodeType::Ridged) };
+	Graph.vNodes[KRidges].Frequency = 1.0f / 256.0f;
+
+	const int KWarpX{ AddNode(ENodeType::SimplexFBm) };
+	Graph.vNodes[KWarpX].Frequency = 1.0f / 128.0f;
+	Graph.vNodes[KWarpX].OctaveCount = 3;
+	const int KWarpZ{ AddNode(ENodeType::SimplexFBm) };
+	Graph.vNodes[KWarpZ].Frequency = 1.0f / 128.0f;
+	Graph.vNodes[KWarpZ].OctaveCount = 3;
+	const int KWarpedRidges{ AddNode(ENodeType::DomainWarp, KRidges, KWarpX, KWarpZ) };
+	Graph.vNodes[KWarpedRidges].Scale = 24.0f;
+
+	const int KHills{ AddNode(ENodeType::PerlinFBm) };
+	Graph.vNodes[KHills].Frequency = 1.0f / 128.0f;
+	Graph.vNodes[KHills].OctaveCount = 5;
+
+	// Ridges only rise where the hills are high
+	const int KMountainMask{ AddNode(ENodeType::Curve, KHills) };
+	Graph.vNodes[KMountainMask].vCurvePoints = { XMFLOAT2(-0.2f, 0.0f), XMFLOAT2(0.4f, 1.0f) };
+	const int KMountains{ AddNode(ENodeType::Multiply, KWarpedRidges, KMountainMask) };
+	const int KScaledMountains{ AddNode(ENodeType::ScaleBias, KMountains) };
+	Graph.vNodes[KScaledMountains].Scale = 0.6f;
+	Graph.vNodes[KScaledMountains].Bias = 0.3f;
+	const int KScaledHills{ AddNode(ENodeType::ScaleBias, KHills) };
+	Graph.vNodes[KScaledHills].Scale = 0.4f;
+	const int KLandscape{ AddNode(ENodeType::Add, KScaledMountains, KScaledHills) };
+
+	const int KTerraced{ AddNode(ENodeType::Terrace, KLandscape) };
+	Graph.vNodes[KTerraced].TerraceCount = 12;
+	Graph.vNodes[KTerraced].TerraceSharpness = 0.3f;
+	return Graph;
+}
+
+bool CTerrainGenerator::GenerateHeights(const SDesc& Desc, uint32_t Width, uint32_t Height, vector<SPixel8UInt>& vOutHeights,
+	SStats* const PtrOutStats)
+{
+	if (PtrOutStats) *PtrOutStats = SStats();
+	if (!IsValid(Desc.Graph) || !Width || !Height) return false;
+
+	vOutHeights.resize(static_cast<size_t>(Width) * Height);
+
+	const size_t KOutputNode{ Desc.Graph.vNodes.size() - 1 };
+	const XMVECTOR KLaneOffsets{ XMVectorSet(0, 1, 2, 3) };
+	const XMVECTOR KHeightScale{ XMVectorReplicate(Desc.HeightScale * 255.0f) };
+	const XMVECTOR KHeightBias{ XMVectorReplicate(Desc.HeightBias * 255.0f) };
+	const XMVECTOR KMaxHeight{ XMVectorReplicate(255.0f) };
+	size_t TileCount{};
+	ForEachTile(Width, Height, Desc.ThreadCount, TileCount, [&](const CMipGenerator::SRect& Tile)
+		{
+			SEvaluationCache Cache{};
+			Cache.vValues.resize(Desc.Graph.vNodes.size());
+			Cache.vStamps.resize(Desc.Graph.vNodes.size());
+			for (uint32_t V = Tile.Top; V < Tile.Bottom; ++V)
+			{
+				SPixel8UInt* const PtrRow{ &vOutHeights[static_cast<size_t>(V) * Width] };
+				const XMVECTOR KZ{ XMVectorReplicate(static_cast<float>(V)) };
+				for (uint32_t U = Tile.Left; U < Tile.Right; U += 4)
+				{
+					const XMVECTOR KX{ XMVectorAdd(XMVectorReplicate(static_cast<float>(U)), KLaneOffsets) };
+					Cache.Stamp = ++Cache.LastStamp;
+					const XMVECTOR KValue{ EvaluateNode(Desc.Graph, KOutputNode, KX, KZ, Cache) };
+					const XMVECTOR KHeight{ XMVectorClamp(XMVectorRound(XMVectorMultiplyAdd(KValue, KHeightScale, KHeightBias)),
+						XMVectorZero(), KMaxHeight) };
+
+					int32_t Heights[4]{};
+					XMStoreInt4(reinterpret_cast<uint32_t*>(Heights), XMConvertVectorFloatToInt(KHeight, 0));
+					for (uint32_t iLane = 0; iLane < 4 && U + iLane < Tile.Right; ++iLane)
+					{
+						PtrRow[U + iLane].R = static_cast<uint8_t>(Heights[iLane]);
+					}
+				}
+			}
+		});
+
+	if (PtrOutStats)
+	{
+		PtrOutStats->TexelCount = vOutHeights.size();
+		PtrOutStats->TileCount = TileCount;
+	}
+	return true;
+}
+
+void CTerrainGenerator::GenerateMasking(const SDesc& Desc, const CTerrainSampler::SSource& Source, float MaskingDetail,
+	CSparseMasking& OutMasking, SStats* const PtrOutStats)
+{
+	if (PtrOutStats) *PtrOutStats = SStats();
+
+	OutMasking.Clear();
+	const uint32_t KMaskingWidth{ OutMasking.GetWidth() };
+	const uint32_t KMaskingHeight{ OutMasking.GetHeight() };
+	if (!KMaskingWidth || !KMaskingHeight || Desc.vMaskingRules.empty() || MaskingDetail <= 0.0f) return;
+
+	CTerrainSampler::SSource HeightSource{ Source };
+	HeightSource.PtrMasking = nullptr;
+
+	// Tiles are written to OutMasking one at a time (it allocates its tiles from a shared pool)
+	std::mutex OutMaskingMutex{};
+	size_t TileCount{};
+	ForEachTile(KMaskingWidth, KMaskingHeight, Desc.ThreadCount, TileCount, [&](const CMipGenerator::SRect& Tile)
+		{
+			const uint32_t KTileWidth{ Tile.Right - Tile.Left };
+			const uint32_t KPaddedWidth{ (KTileWidth + 3) / 4 * 4 };
+			vector<SPixel32UInt> vTexels(static_cast<size_t>(KTileWidth) * (Tile.Bottom - Tile.Top));
+			vector<XMFLOAT2> vPositionsXZ(KTileWidth);
+			vector<float> vHeights(KPaddedWidth);
+			vector<XMFLOAT3> vNormals(KPaddedWidth);
+			for (uint32_t V = Tile.Top; V < Tile.Bottom; ++V)
+			{
+				// Masking texel centers, in world space
+				for (uint32_t iTexel = 0; iTexel < KTileWidth; ++iTexel)
+				{
+					vPositionsXZ[iTexel].x = (Tile.Left + iTexel + 0.5f) / MaskingDetail - Source.TerrainSize.x / 2.0f;
+					vPositionsXZ[iTexel].y = Source.TerrainSize.y / 2.0f - (V + 0.5f) / MaskingDetail;
+				}
+				CTerrainSampler::Sample(HeightSource, &vPositionsXZ[0], KTileWidth, &vHeights[0], &vNormals[0]);
+
+				SPixel32UInt* const PtrRow{ &vTexels[static_cast<size_t>(V - Tile.Top) * KTileWidth] };
+				for (uint32_t iTexel = 0; iTexel < KTileWidth; iTexel += 4)
+				{
+					const XMVECTOR KHeight{ XMVectorScale(XMVectorAdd(Load4(&vHeights[iTexel]), XMVectorReplicate(Source.HeightRange / 2.0f)),
+						1.0f / Source.HeightRange) };
+					const XMVECTOR KSlope{ XMVectorSubtract(XMVectorSplatOne(), XMVectorSet(vNormals[iTexel].y, vNormals[iTexel + 1].y,
+						vNormals[iTexel + 2].y, vNormals[iTexel + 3].y)) };
+
+					XMVECTOR Weights[4]{};
+					for (const auto& Rule : Desc.vMaskingRules)
+					{
+						if (Rule.Layer >= 4) continue;
+
+						const XMVECTOR KWeight{ XMVectorScale(XMVectorMultiply(GetBand(KHeight, Rule.HeightRange, Rule.Falloff),
+							GetBand(KSlope, Rule.SlopeRange, Rule.Falloff)), Rule.Weight) };
+						Weights[Rule.Layer] = XMVectorMax(Weights[Rule.Layer], KWeight);
+					}
+
+					int32_t Channels[4][4]{}; // [Layer][Lane]
+					for (int iLayer = 0; iLayer < 4; ++iLayer)
+					{
+						XMStoreInt4(reinterpret_cast<uint32_t*>(Channels[iLayer]),
+							XMConvertVectorFloatToInt(XMVectorRound(XMVectorScale(XMVectorSaturate(Weights[iLayer]), 255.0f)), 0));
+					}
+					for (uint32_t iLane = 0; iLane < 4 && iTexel + iLane < KTileWidth; ++iLane)
+					{
+						SPixel32UInt& Pixel{ PtrRow[iTexel + iLane] };
+						Pixel.R = static_cast<uint8_t>(Channels[0][iLane]);
+						Pixel.G = static_cast<uint8_t>(Channels[1][iLane]);
+						Pixel.B = static_cast<uint8_t>(Channels[2][iLane]);
+						Pixel.A = static_cast<uint8_t>(Channels[3][iLane]);
+					}
+				}
+			}
+
+			std::lock_guard<std::mutex> Lock{ OutMaskingMutex };
+			OutMasking.WriteRect(Tile, &vTexels[0], KTileWidth);
+		});
+
+	if (PtrOutStats)
+	{
+		PtrOutStats->TexelCount = static_cast<size_t>(KMaskingWidth) * KMaskingHeight;
+		PtrOutStats->TileCount = TileCount;
+	}
+}
+
+XMVECTOR CTerrainGenerator::EvaluateNode(const SGraph& Graph, size_t NodeIndex, FXMVECTOR X, FXMVECTOR Z)
+{
+	SEvaluationCache Cache{};
+	Cache.vValues.resize(Graph.vNodes.size());
+	Cache.vStamps.resize(Graph.vNodes.size());
+	Cache.Stamp = ++Cache.LastStamp;
+	return EvaluateNode(Graph, NodeIndex, X, Z, Cache);
+}
+
+XMVECTOR CTerrainGenerator::EvaluateNode(const SGraph& Graph, size_t NodeIndex, FXMVECTOR X, FXMVECTOR Z, SEvaluationCache& Cache)
+{
+	if (Cache.vStamps[NodeIndex] == Cache.Stamp) return XMLoadFloat4(&Cache.vValues[NodeIndex]);
+
+	const SNode& Node{ Graph.vNodes[NodeIndex] };
+	auto GetInput{ [&](int iInput)
+		{
+			const int KInput{ Node.Inputs[iInput] };
+			return (KInput >= 0) ? EvaluateNode(Graph, static_cast<size_t>(KInput), X, Z, Cache) : XMVectorZero();
+		} };
+	// Values at other positions get a stamp of their own (so they neither use nor replace the values at X, Z)
+	auto GetInputAt{ [&](int iInput, FXMVECTOR InputX, FXMVECTOR InputZ)
+		{
+			const int KInput{ Node.Inputs[iInput] };
+			if (KInput < 0) return XMVectorZero();
+
+			const uint32_t KStamp{ Cache.Stamp };
+			Cache.Stamp = ++Cache.LastStamp;
+			const XMVECTOR KResult{ EvaluateNode(Graph, static_cast<size_t>(KInput), InputX, InputZ, Cache) };
+			Cache.Stamp = KStamp;
+			return KResult;
+		} };
+
+	XMVECTOR Result{};
+	switch (Node.eType)
+	{
+	case ENodeType::Constant:
+		Result = XMVectorReplicate(Node.Bias);
+		break;
+	case ENodeType::PerlinFBm:
+		Result = EvaluateFBm(Node, Graph.Seed, X, Z, PerlinNoise);
+		break;
+	case ENodeType::SimplexFBm:
+		Result = EvaluateFBm(Node, Graph.Seed, X, Z, SimplexNoise);
+		break;
+	case ENodeType::Ridged:
+		Result = EvaluateRidged(Node, Graph.Seed, X, Z);
+		break;
+	case ENodeType::DomainWarp:
+	{
+		const XMVECTOR KOffsetX{ GetInput(1) };
+		// Without input 2, input 1 is sampled again far away from the first sample
+		const XMVECTOR KOffsetZ{ (Node.Inputs[2] >= 0) ? GetInput(2) :
+			GetInputAt(1, XMVectorAdd(X, XMVectorReplicate(5200.0f)), XMVectorAdd(Z, XMVectorReplicate(1300.0f))) };
+		Result = GetInputAt(0, XMVectorMultiplyAdd(KOffsetX, XMVectorReplicate(Node.Scale), X),
+			XMVectorMultiplyAdd(KOffsetZ, XMVectorReplicate(Node.Scale), Z));
+	} break;
+	case ENodeType::Terrace:
+		Result = EvaluateTerrace(Node, GetInput(0));
+		break;
+	case ENodeType::Curve:
+		Result = EvaluateCurve(Node, GetInput(0));
+		break;
+	case ENodeType::Add:
+		Result = XMVectorAdd(GetInput(0), GetInput(1));
+		break;
+	case ENodeType::Multiply:
+		Result = XMVectorMultiply(GetInput(0), GetInput(1));
+		break;
+	case ENodeType::ScaleBias:
+		Result = XMVectorMultiplyAdd(GetInput(0), XMVectorReplicate(Node.Scale), XMVectorReplicate(Node.Bias));
+		break;
+	default:
+		break;
+	}
+
+	XMStoreFloat4(&Cache.vValues[NodeIndex], Result);
+	Cache.vStamps[NodeIndex] = Cache.Stamp;
+	return Result;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "MipGenerator.h"
+#include "TerrainSampler.h"
+
+// Generates a terrain's height map from a graph of noise nodes, and optionally its masking layers from height and slope rules
+// Texels are evaluated 4 at a time in tiles that worker threads pull one by one; a texel's value depends only on its position and the seed,
+// so the result is the same for any thread count
+class CTerrainGenerator final
+{
+public:
+	enum class ENodeType
+	{
+		Constant, // Bias
+		PerlinFBm, // Gradient noise octaves, about -1 ~ +1
+		SimplexFBm, // Simplex noise octaves, about -1 ~ +1
+		Ridged, // Ridged multifractal (sharp crests where the noise crosses 0), -1 ~ +1
+		DomainWarp, // Input 0 sampled at the position offset by inputs 1 (X) and 2 (Z) times Scale (in texels)
+		Terrace, // Input 0 (-1 ~ +1) in TerraceCount steps
+		Curve, // Input 0 remapped through vCurvePoints
+		Add, // Input 0 + input 1
+		Multiply, // Input 0 * input 1
+		ScaleBias // Input 0 * Scale + Bias
+	};
+
+	struct SNode
+	{
+		ENodeType			eType{ ENodeType::Constant };
+		int					Inputs[3]{ -1, -1, -1 }; // Indices of earlier nodes
+
+		// Noise (PerlinFBm, SimplexFBm, Ridged)
+		float				Frequency{ 1.0f / 64.0f }; // Of the first octave, per texel
+		uint32_t			OctaveCount{ 6 };
+		float				Lacunarity{ 2.0f }; // Frequency multiplier per octave
+		float				Gain{ 0.5f }; // Amplitude multiplier per octave
+		uint32_t			SeedOffset{};
+
+		float				Scale{ 1.0f };
+		float				Bias{};
+
+		// Terrace
+		uint32_t			TerraceCount{ 8 };
+		float				TerraceSharpness{ 0.5f }; // 0: linear ramps between the steps ~ 1: flat steps
+
+		// Curve: (input, output) points sorted by input, inputs outside them are clamped
+		vector<XMFLOAT2>	vCurvePoints{};
+	};
+
+	struct SGraph
+	{
+		vector<SNode>		vNodes{}; // The last node is the output
+		uint32_t			Seed{};
+	};
+
+	struct SMaskingRule
+	{
+		uint32_t			Layer{}; // 0 ~ 3 (R, G, B, A of the masking texture)
+		XMFLOAT2			HeightRange{ 0.0f, 1.0f }; // 0 (lowest) ~ 1 (highest)
+		XMFLOAT2			SlopeRange{ 0.0f, 1.0f }; // 1 - Normal.y, 0 (flat) ~ 1 (vertical)
+		float				Falloff{ 0.05f }; // Width of the ramps outside the ranges
+		float				Weight{ 1.0f };
+	};
+
+	struct SDesc
+	{
+		SGraph					Graph{};
+		float					HeightScale{ 0.5f }; // Height (0 ~ 1) = Output * HeightScale + HeightBias
+		float					HeightBias{ 0.5f };
+		vector<SMaskingRule>	vMaskingRules{}; // Each layer takes the largest weight of its rules
+		uint32_t				ThreadCount{}; // Including the calling thread, 0: every thread of CWorkerPool::GetShared()
+	};
+
+	struct SStats
+	{
+		size_t		TexelCount{};
+		size_t		TileCount{};
+	};
+
+public:
+	// Every node's inputs must be earlier nodes
+	static bool IsValid(const SGraph& Graph);
+	// Warped ridges blended with rolling hills, lightly terraced
+	static SGraph GetDefaultGraph(uint32_t Seed);
+
+	static bool GenerateHeights(const SDesc& Desc, uint32_t Width, uint32_t Height, vector<SPixel8UInt>& vOutHeights,
+		SStats* const PtrOutStats = nullptr);
+	// Source: the generated height map (the masking part is ignored); masking texels are MaskingDetail per world unit
+	// OutMasking keeps its size, only the tiles with non-zero weights are allocated
+	static void GenerateMasking(const SDesc& Desc, const CTerrainSampler::SSource& Source, float MaskingDetail, CSparseMasking& OutMasking,
+		SStats* const PtrOutStats = nullptr);
+
+	// 4 positions (in texels) at a time
+	static XMVECTOR EvaluateNode(const SGraph& Graph, size_t NodeIndex, FXMVECTOR X, FXMVECTOR Z);
+
+private:
+	// Node values at the positions being evaluated, so that a node that feeds several others is evaluated once
+	struct SEvaluationCache
+	{
+		vector<XMFLOAT4>	vValues{};
+		vector<uint32_t>	vStamps{}; // A value is valid if its stamp is the current one
+		uint32_t			Stamp{};
+		uint32_t			LastStamp{};
+	};
+
+	static XMVECTOR EvaluateNode(const SGraph& Graph, size_t NodeIndex, FXMVECTOR X, FXMVECTOR Z, SEvaluationCache& Cache);
+
+public:
+	static constexpr uint32_t KTileSize{ 64 };
+	static constexpr size_t KMultithreadingMinTexelCount{ 128 * 128 };
+};
@@ -0,0 +1,142 @@
+#include "TerrainLayerAnalyzer.h"
+
+void CTerrainLayerAnalyzer::Create(uint32_t Width, uint32_t Height, uint32_t TileSize, uint32_t Margin, uint32_t SampledMipCount)
+{
+	assert(TileSize);
+	assert(SampledMipCount >= 1 && SampledMipCount <= 16);
+
+	m_Width = Width;
+	m_Height = Height;
+	m_TileSize = TileSize;
+	m_Margin = Margin;
+
+	// Mip 0's bilinear footprint is in the margin; a texel of mip N averages texels up to 2^N away from a sample (odd mip sizes shift
+	// them by up to half of that) and bilinear filtering reaches one more texel of mip N
+	const uint32_t KCoarsestTexelSize{ 1u << (SampledMipCount - 1) };
+	m_Reach = m_Margin + ((SampledMipCount > 1) ? 2 * KCoarsestTexelSize : 0);
+	m_TileCountX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_TileCountY = (m_Height + m_TileSize - 1) / m_TileSize;
+
+	m_vTileLayerMasks.clear();
+	m_vTileLayerMasks.resize(static_cast<size_t>(m_TileCountX) * m_TileCountY);
+	m_LayerSum = 0;
+
+	m_Stats = SStats();
+	m_Stats.TileCount = m_vTileLayerMasks.size();
+}
+
+void CTerrainLayerAnalyzer::Analyze(const CSparseMasking& Masking)
+{
+	AnalyzeTiles(Masking, 0, 0, m_TileCountX, m_TileCountY);
+}
+
+bool CTerrainLayerAnalyzer::Update(const CSparseMasking& Masking, const CMipGenerator::SRect& DirtyRect)
+{
+	if (DirtyRect.IsEmpty() || m_vTileLayerMasks.empty()) return false;
+
+	// A texel is analyzed with every tile that reaches it
+	const uint32_t KTileLeft{ (DirtyRect.Left > m_Reach) ? (DirtyRect.Left - m_Reach) / m_TileSize : 0 };
+	const uint32_t KTileTop{ (DirtyRect.Top > m_Reach) ? (DirtyRect.Top - m_Reach) / m_TileSize : 0 };
+	const uint32_t KTileRight{ min((DirtyRect.Right - 1 + m_Reach) / m_TileSize + 1, m_TileCountX) };
+	const uint32_t KTileBottom{ min((DirtyRect.Bottom - 1 + m_Reach) / m_TileSize + 1, m_TileCountY) };
+	if (KTileLeft >= KTileRight || KTileTop >= KTileBottom) return false;
+
+	AnalyzeTiles(Masking, KTileLeft, KTileTop, KTileRight, KTileBottom);
+
+	return (m_Stats.ChangedTileCount > 0);
+}
+
+size_t CTerrainLayerAnalyzer::GetTileIndex(float U, float V) const
+{
+	assert(m_TileCountX && m_TileCountY);
+
+	uint32_t TileX{ static_cast<uint32_t>(max(U, 0.0f)) / m_TileSize };
+	uint32_t TileY{ static_cast<uint32_t>(max(V, 0.0f)) / m_TileSize };
+	TileX = min(TileX, m_TileCountX - 1);
+	TileY = min(TileY, m_TileCountY - 1);
+	return static_cast<size_t>(TileY) * m_TileCountX + TileX;
+}
+
+uint8_t CTerrainLayerAnalyzer::AnalyzeRect(const SPixel32UInt* const PtrPixels, uint32_t Width, const CMipGenerator::SRect& Rect)
+{
+	// Texels are OR'ed together, so a layer is used if its byte is non-zero in any lane
+	XMVECTOR Lanes{ XMVectorZero() };
+	uint32_t Bits{};
+	for (uint32_t V = Rect.Top; V < Rect.Bottom; ++V)
+	{
+		const uint32_t* const PtrRow{ reinterpret_cast<const uint32_t*>(PtrPixels + static_cast<size_t>(V) * Width) };
+
+		uint32_t U{ Rect.Left };
+		for (; U + 4 <= Rect.Right; U += 4)
+		{
+			Lanes = XMVectorOrInt(Lanes, XMLoadInt4(PtrRow + U));
+		}
+		for (; U < Rect.Right; ++U)
+		{
+			Bits |= PtrRow[U];
+		}
+
+		// Every layer is used, the rest can't change the result
+		uint32_t LaneBits[4]{};
+		XMStoreInt4(LaneBits, Lanes);
+		Bits |= LaneBits[0] | LaneBits[1] | LaneBits[2] | LaneBits[3];
+		if ((Bits & 0x000000FF) && (Bits & 0x0000FF00) && (Bits & 0x00FF0000) && (Bits & 0xFF000000)) break;
+	}
+
+	SPixel32UInt Pixel{};
+	memcpy(&Pixel, &Bits, sizeof(Pixel));
+
+	uint8_t LayerMask{};
+	if (Pixel.R) LayerMask |= 0x01;
+	if (Pixel.G) LayerMask |= 0x02;
+	if (Pixel.B) LayerMask |= 0x04;
+	if (Pixel.A) LayerMask |= 0x08;
+	return LayerMask;
+}
+
+uint32_t CTerrainLayerAnalyzer::CountLayers(uint8_t LayerMask)
+{
+	uint32_t Count{};
+	for (; LayerMask; LayerMask &= LayerMask - 1) ++Count;
+	return Count;
+}
+
+void CTerrainLayerAnalyzer::AnalyzeTiles(const CSparseMasking& Masking, uint32_t TileLeft, uint32_t TileTop, uint32_t TileRight,
+	uint32_t TileBottom)
+{
+	assert(Masking.GetWidth() == m_Width && Masking.GetHeight() == m_Height);
+
+	m_Stats.AnalyzedTileCount = 0;
+	m_Stats.ChangedTileCount = 0;
+	for (uint32_t TileY = TileTop; TileY < TileBottom; ++TileY)
+	{
+		for (uint32_t TileX = TileLeft; TileX < TileRight; ++TileX)
+		{
+			CMipGenerator::SRect Rect{};
+			Rect.Left = (TileX * m_TileSize > m_Reach) ? TileX * m_TileSize - m_Reach : 0;
+			Rect.Top = (TileY * m_TileSize > m_Reach) ? TileY * m_TileSize - m_Reach : 0;
+			Rect.Right = min((TileX + 1) * m_TileSize + m_Reach, m_Width);
+			Rect.Bottom = min((TileY + 1) * m_TileSize + m_Reach, m_Height);
+
+			// Unallocated masking tiles are 0, so they add no layers
+			uint8_t LayerMask{};
+			Masking.ForEachAllocatedTile(Rect, [&](const SPixel32UInt* const PtrTileTexels, uint32_t, uint32_t, const CMipGenerator::SRect& TileRect)
+				{
+					if (LayerMask != KLayerMaskAll) LayerMask |= AnalyzeRect(PtrTileTexels, CSparseMasking::KTileSize, TileRect);
+				});
+			uint8_t& TileLayerMask{ m_vTileLayerMasks[static_cast<size_t>(TileY) * m_TileCountX + TileX] };
+			++m_Stats.AnalyzedTileCount;
+			if (LayerMask == TileLayerMask) continue;
+
+			m_LayerSum -= CountLayers(TileLayerMask);
+			m_LayerSum += CountLayers(LayerMask);
+			TileLayerMask = LayerMask;
+			++m_Stats.ChangedTileCount;
+		}
+	}
+
+	if (m_Stats.TileCount)
+	{
+		m_Stats.AverageLayerCount = 1.0f + static_cast<float>(m_LayerSum) / static_cast<float>(m_Stats.TileCount);
+	}
+}
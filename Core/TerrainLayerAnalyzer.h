@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SparseMasking.h"
+
+// Finds which masking layers (R, G, B, A of the terrain's masking texture = terrain layers 1 ~ 4) have non-zero weight in each tile,
+// so that each tile can be drawn with a pixel shader that samples only those layers (layer 0 is always sampled)
+// Layer mask: bit 0 = R, bit 1 = G, bit 2 = B, bit 3 = A
+class CTerrainLayerAnalyzer final
+{
+public:
+	struct SStats
+	{
+		size_t		TileCount{};
+		size_t		AnalyzedTileCount{}; // By the last Analyze() or Update()
+		size_t		ChangedTileCount{}; // By the last Analyze() or Update()
+		float		AverageLayerCount{ 1.0f }; // Layers sampled per tile, including layer 0
+	};
+
+public:
+	CTerrainLayerAnalyzer() {}
+	~CTerrainLayerAnalyzer() {}
+
+public:
+	// Margin: texels around each tile that are analyzed with it (geometry drawn with the tile may sample them)
+	// SampledMipCount: mips of the masking that the tiles are drawn with; the coarser ones blur weight further, so the margin is
+	// widened by the footprint of the coarsest one
+	// Every tile's layer mask is 0 until Analyze() is called
+	void Create(uint32_t Width, uint32_t Height, uint32_t TileSize = KDefaultTileSize, uint32_t Margin = 1, uint32_t SampledMipCount = 1);
+
+	// Only the masking's allocated tiles are read, the rest are 0
+	void Analyze(const CSparseMasking& Masking);
+	// Re-analyzes only the tiles that DirtyRect (in texels) reaches; returns true if any tile's layer mask changed
+	bool Update(const CSparseMasking& Masking, const CMipGenerator::SRect& DirtyRect);
+
+	// U, V: in texels (clamped to the texture)
+	size_t GetTileIndex(float U, float V) const;
+	uint8_t GetTileLayerMask(size_t TileIndex) const { return m_vTileLayerMasks[TileIndex]; }
+	size_t GetTileCount() const { return m_vTileLayerMasks.size(); }
+	uint32_t GetTileCountX() const { return m_TileCountX; }
+	uint32_t GetTileCountY() const { return m_TileCountY; }
+	const SStats& GetStats() const { return m_Stats; }
+
+	// Layer mask of the texels in Rect (4 texels are tested at once)
+	static uint8_t AnalyzeRect(const SPixel32UInt* const PtrPixels, uint32_t Width, const CMipGenerator::SRect& Rect);
+	static uint32_t CountLayers(uint8_t LayerMask);
+
+private:
+	void AnalyzeTiles(const CSparseMasking& Masking, uint32_t TileLeft, uint32_t TileTop, uint32_t TileRight, uint32_t TileBottom);
+
+public:
+	static constexpr uint32_t KDefaultTileSize{ 32 };
+	static constexpr uint8_t KLayerMaskAll{ 0x0F };
+
+private:
+	uint32_t			m_Width{};
+	uint32_t			m_Height{};
+	uint32_t			m_TileSize{ KDefaultTileSize };
+	uint32_t			m_Margin{};
+	uint32_t			m_Reach{}; // Texels past a tile's edges that are analyzed with it (the margin and the coarsest mip's footprint)
+	uint32_t			m_TileCountX{};
+	uint32_t			m_TileCountY{};
+
+private:
+	vector<uint8_t>		m_vTileLayerMasks{};
+	size_t				m_LayerSum{}; // Sum of every tile's layer count (without layer 0)
+	SStats				m_Stats{};
+};
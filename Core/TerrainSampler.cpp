@@ -0,0 +1,174 @@
+#include "TerrainSampler.h"
+
+void CTerrainSampler::Sample(const SSource& Source, const XMFLOAT2* const PtrPositionsXZ, size_t Count, float* const PtrOutHeights,
+	XMFLOAT3* const PtrOutNormals, XMFLOAT4* const PtrOutLayerWeights)
+{
+	assert(Source.PtrHeights);
+	assert(Source.HeightMapWidth >= 2 && Source.HeightMapHeight >= 2);
+	assert(PtrPositionsXZ);
+	if (!Count) return;
+
+	size_t iPoint{};
+	for (; iPoint + 4 <= Count; iPoint += 4)
+	{
+		SampleFour(Source, PtrPositionsXZ + iPoint, PtrOutHeights ? PtrOutHeights + iPoint : nullptr,
+			PtrOutNormals ? PtrOutNormals + iPoint : nullptr, PtrOutLayerWeights ? PtrOutLayerWeights + iPoint : nullptr);
+	}
+	if (iPoint < Count)
+	{
+		// The last point fills the remaining lanes
+		XMFLOAT2 Positions[4]{};
+		float Heights[4]{};
+		XMFLOAT3 Normals[4]{};
+		XMFLOAT4 LayerWeights[4]{};
+		for (size_t iLane = 0; iLane < 4; ++iLane) Positions[iLane] = PtrPositionsXZ[min(iPoint + iLane, Count - 1)];
+		SampleFour(Source, Positions, Heights, Normals, LayerWeights);
+		for (size_t iLane = 0; iPoint + iLane < Count; ++iLane)
+		{
+			if (PtrOutHeights) PtrOutHeights[iPoint + iLane] = Heights[iLane];
+			if (PtrOutNormals) PtrOutNormals[iPoint + iLane] = Normals[iLane];
+			if (PtrOutLayerWeights) PtrOutLayerWeights[iPoint + iLane] = LayerWeights[iLane];
+		}
+	}
+}
+
+void CTerrainSampler::SampleFour(const SSource& Source, const XMFLOAT2* const PtrPositionsXZ, float* const PtrOutHeights,
+	XMFLOAT3* const PtrOutNormals, XMFLOAT4* const PtrOutLayerWeights)
+{
+	const XMVECTOR KX{ XMVectorSet(PtrPositionsXZ[0].x, PtrPositionsXZ[1].x, PtrPositionsXZ[2].x, PtrPositionsXZ[3].x) };
+	const XMVECTOR KZ{ XMVectorSet(PtrPositionsXZ[0].y, PtrPositionsXZ[1].y, PtrPositionsXZ[2].y, PtrPositionsXZ[3].y) };
+	const XMVECTOR KZero{ XMVectorZero() };
+	const XMVECTOR KOne{ XMVectorSplatOne() };
+
+	// Height map texel (U, V) is at world (U - SizeX / 2, SizeZ / 2 - V)
+	const XMVECTOR KU{ XMVectorClamp(XMVectorAdd(KX, XMVectorReplicate(Source.TerrainSize.x / 2.0f)), KZero,
+		XMVectorReplicate(static_cast<float>(Source.HeightMapWidth - 1))) };
+	const XMVECTOR KV{ XMVectorClamp(XMVectorSubtract(XMVectorReplicate(Source.TerrainSize.y / 2.0f), KZ), KZero,
+		XMVectorReplicate(static_cast<float>(Source.HeightMapHeight - 1))) };
+	const XMVECTOR KCellU{ XMVectorMin(XMVectorFloor(KU), XMVectorReplicate(static_cast<float>(Source.HeightMapWidth - 2))) };
+	const XMVECTOR KCellV{ XMVectorMin(XMVectorFloor(KV), XMVectorReplicate(static_cast<float>(Source.HeightMapHeight - 2))) };
+	const XMVECTOR KS{ XMVectorSubtract(KU, KCellU) };
+	const XMVECTOR KR{ XMVectorSubtract(KV, KCellV) };
+
+	// SSE has no gather, so each lane's 2x2 corners are loaded on their own
+	XMFLOAT4 CellU{};
+	XMFLOAT4 CellV{};
+	XMStoreFloat4(&CellU, KCellU);
+	XMStoreFloat4(&CellV, KCellV);
+	float H00[4]{};
+	float H10[4]{};
+	float H01[4]{};
+	float H11[4]{};
+	const float* const PtrCellU{ &CellU.x };
+	const float* const PtrCellV{ &CellV.x };
+	for (int iLane = 0; iLane < 4; ++iLane)
+	{
+		const SPixel8UInt* const PtrRow0{ Source.PtrHeights +
+			static_cast<size_t>(PtrCellV[iLane]) * Source.HeightMapWidth + static_cast<size_t>(PtrCellU[iLane]) };
+		const SPixel8UInt* const PtrRow1{ PtrRow0 + Source.HeightMapWidth };
+		H00[iLane] = PtrRow0[0].R;
+		H10[iLane] = PtrRow0[1].R;
+		H01[iLane] = PtrRow1[0].R;
+		H11[iLane] = PtrRow1[1].R;
+	}
+	const XMVECTOR KH00{ XMVectorSet(H00[0], H00[1], H00[2], H00[3]) };
+	const XMVECTOR KH10{ XMVectorSet(H10[0], H10[1], H10[2], H10[3]) };
+	const XMVECTOR KH01{ XMVectorSet(H01[0], H01[1], H01[2], H01[3]) };
+	const XMVECTOR KH11{ XMVectorSet(H11[0], H11[1], H11[2], H11[3]) };
+
+	// H(s, r) = H00 + DeltaU * s + DeltaV * r + Twist * s * r
+	const XMVECTOR KDeltaU{ XMVectorSubtract(KH10, KH00) };
+	const XMVECTOR KDeltaV{ XMVectorSubtract(KH01, KH00) };
+	const XMVECTOR KTwist{ XMVectorSubtract(XMVectorSubtract(XMVectorAdd(KH00, KH11), KH10), KH01) };
+	const float KWorldPerStep{ Source.HeightRange / 255.0f };
+
+	if (PtrOutHeights)
+	{
+		XMVECTOR Height{ XMVectorMultiplyAdd(KS, KDeltaU, KH00) };
+		Height = XMVectorMultiplyAdd(KR, XMVectorMultiplyAdd(KS, KTwist, KDeltaV), Height);
+		Height = XMVectorSubtract(XMVectorScale(Height, KWorldPerStep), XMVectorReplicate(Source.HeightRange / 2.0f));
+
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(PtrOutHeights), Height);
+	}
+
+	if (PtrOutNormals)
+	{
+		// (-dY/dX, 1, -dY/dZ), +V is -Z
+		const XMVECTOR KNormalX{ XMVectorScale(XMVectorMultiplyAdd(KR, KTwist, KDeltaU), -KWorldPerStep) };
+		const XMVECTOR KNormalZ{ XMVectorScale(XMVectorMultiplyAdd(KS, KTwist, KDeltaV), +KWorldPerStep) };
+		const XMVECTOR KLengthSquare{ XMVectorMultiplyAdd(KNormalX, KNormalX, XMVectorMultiplyAdd(KNormalZ, KNormalZ, KOne)) };
+		const XMVECTOR KInverseLength{ XMVectorDivide(KOne, XMVectorSqrt(KLengthSquare)) };
+
+		XMFLOAT4 NormalX{};
+		XMFLOAT4 NormalY{};
+		XMFLOAT4 NormalZ{};
+		XMStoreFloat4(&NormalX, XMVectorMultiply(KNormalX, KInverseLength));
+		XMStoreFloat4(&NormalY, KInverseLength);
+		XMStoreFloat4(&NormalZ, XMVectorMultiply(KNormalZ, KInverseLength));
+		for (int iLane = 0; iLane < 4; ++iLane)
+		{
+			PtrOutNormals[iLane] = XMFLOAT3((&NormalX.x)[iLane], (&NormalY.x)[iLane], (&NormalZ.x)[iLane]);
+		}
+	}
+
+	if (PtrOutLayerWeights)
+	{
+		const uint32_t KMaskingWidth{ (Source.PtrMasking) ? Source.PtrMasking->GetWidth() : 0 };
+		const uint32_t KMaskingHeight{ (Source.PtrMasking) ? Source.PtrMasking->GetHeight() : 0 };
+		if (KMaskingWidth < 2 || KMaskingHeight < 2)
+		{
+			for (int iLane = 0; iLane < 4; ++iLane) PtrOutLayerWeights[iLane] = XMFLOAT4(0, 0, 0, 0);
+			return;
+		}
+
+		// Masking texel centers are at +0.5 (as the GPU samples it)
+		const XMVECTOR KHalf{ XMVectorReplicate(0.5f) };
+		const XMVECTOR KMaskingU{ XMVectorClamp(XMVectorSubtract(XMVectorScale(XMVectorAdd(KX,
+			XMVectorReplicate(Source.TerrainSize.x / 2.0f)), Source.MaskingDetail), KHalf), KZero,
+			XMVectorReplicate(static_cast<float>(KMaskingWidth - 1))) };
+		const XMVECTOR KMaskingV{ XMVectorClamp(XMVectorSubtract(XMVectorScale(XMVectorSubtract(
+			XMVectorReplicate(Source.TerrainSize.y / 2.0f), KZ), Source.MaskingDetail), KHalf), KZero,
+			XMVectorReplicate(static_cast<float>(KMaskingHeight - 1))) };
+		const XMVECTOR KMaskingCellU{ XMVectorMin(XMVectorFloor(KMaskingU), XMVectorReplicate(static_cast<float>(KMaskingWidth - 2))) };
+		const XMVECTOR KMaskingCellV{ XMVectorMin(XMVectorFloor(KMaskingV), XMVectorReplicate(static_cast<float>(KMaskingHeight - 2))) };
+		const XMVECTOR KMaskingS{ XMVectorSubtract(KMaskingU, KMaskingCellU) };
+		const XMVECTOR KMaskingR{ XMVectorSubtract(KMaskingV, KMaskingCellV) };
+
+		XMStoreFloat4(&CellU, KMaskingCellU);
+		XMStoreFloat4(&CellV, KMaskingCellV);
+		float Corners[4][4][4]{}; // [Corner][Channel][Lane]
+		for (int iLane = 0; iLane < 4; ++iLane)
+		{
+			const uint32_t KU{ static_cast<uint32_t>(PtrCellU[iLane]) };
+			const uint32_t KV{ static_cast<uint32_t>(PtrCellV[iLane]) };
+			const SPixel32UInt KPixels[4]{ Source.PtrMasking->GetTexel(KU, KV), Source.PtrMasking->GetTexel(KU + 1, KV),
+				Source.PtrMasking->GetTexel(KU, KV + 1), Source.PtrMasking->GetTexel(KU + 1, KV + 1) };
+			for (int iCorner = 0; iCorner < 4; ++iCorner)
+			{
+				Corners[iCorner][0][iLane] = KPixels[iCorner].R;
+				Corners[iCorner][1][iLane] = KPixels[iCorner].G;
+				Corners[iCorner][2][iLane] = KPixels[iCorner].B;
+				Corners[iCorner][3][iLane] = KPixels[iCorner].A;
+			}
+		}
+
+		XMFLOAT4 Weights[4]{};
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+		{
+			const float* const PtrC00{ Corners[0][iChannel] };
+			const float* const PtrC10{ Corners[1][iChannel] };
+			const float* const PtrC01{ Corners[2][iChannel] };
+			const float* const PtrC11{ Corners[3][iChannel] };
+			const XMVECTOR KTop{ XMVectorLerpV(XMVectorSet(PtrC00[0], PtrC00[1], PtrC00[2], PtrC00[3]),
+				XMVectorSet(PtrC10[0], PtrC10[1], PtrC10[2], PtrC10[3]), KMaskingS) };
+			const XMVECTOR KBottom{ XMVectorLerpV(XMVectorSet(PtrC01[0], PtrC01[1], PtrC01[2], PtrC01[3]),
+				XMVectorSet(PtrC11[0], PtrC11[1], PtrC11[2], PtrC11[3]), KMaskingS) };
+			XMStoreFloat4(&Weights[iChannel], XMVectorScale(XMVectorLerpV(KTop, KBottom, KMaskingR), 1.0f / 255.0f));
+		}
+		for (int iLane = 0; iLane < 4; ++iLane)
+		{
+			PtrOutLayerWeights[iLane] = XMFLOAT4((&Weights[0].x)[iLane], (&Weights[1].x)[iLane], (&Weights[2].x)[iLane],
+				(&Weights[3].x)[iLane]);
+		}
+	}
+}
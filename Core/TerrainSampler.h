@@ -0,0 +1,33 @@
+#pragma once
+
+#include "SparseMasking.h"
+
+// Samples CTerrain's raw data at world XZ positions: bilinear height, the normal of that bilinear surface and the masking layer weights
+// Points are sampled 4 at a time
+class CTerrainSampler final
+{
+public:
+	struct SSource
+	{
+		XMFLOAT2			TerrainSize{}; // In world units, the height map has (TerrainSize + 1) texels 1 unit apart
+		float				HeightRange{}; // World height = (Height / 255) * HeightRange - HeightRange / 2
+
+		const SPixel8UInt*	PtrHeights{};
+		uint32_t			HeightMapWidth{};
+		uint32_t			HeightMapHeight{};
+
+		// Optional (layer weights are 0 without it)
+		const CSparseMasking*	PtrMasking{};
+		float					MaskingDetail{}; // Masking texels per world unit
+	};
+
+public:
+	// Positions outside the terrain are clamped to its edge; any of the outputs can be nullptr
+	static void Sample(const SSource& Source, const XMFLOAT2* const PtrPositionsXZ, size_t Count, float* const PtrOutHeights,
+		XMFLOAT3* const PtrOutNormals = nullptr, XMFLOAT4* const PtrOutLayerWeights = nullptr);
+
+private:
+	// Samples PtrPositionsXZ[0 ~ 3] into the outputs' [0 ~ 3]
+	static void SampleFour(const SSource& Source, const XMFLOAT2* const PtrPositionsXZ, float* const PtrOutHeights,
+		XMFLOAT3* const PtrOutNormals, XMFLOAT4* const PtrOutLayerWeights);
+};
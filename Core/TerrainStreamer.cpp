@@ -0,0 +1,534 @@
+#include "TerrainStreamer.h"
+#include <chrono>
+
+CTerrainStreamer::CTerrainStreamer(CTerrainTileStore* const PtrStore, const SDesc& Desc) : m_PtrStore{ PtrStore }, m_Desc{ Desc }
+{
+	assert(m_PtrStore);
+	assert(m_Desc.TileSize > 0.0f && m_Desc.HeightMapSize >= 2);
+	assert(m_Desc.UnloadRadius >= m_Desc.LoadRadius);
+
+	uint32_t ThreadCount{ m_Desc.ThreadCount };
+	if (ThreadCount == 0) ThreadCount = (std::thread::hardware_concurrency() > 1) ? std::thread::hardware_concurrency() - 1 : 1;
+	for (uint32_t iThread = 0; iThread < ThreadCount; ++iThread)
+	{
+		m_vThreads.emplace_back(&CTerrainStreamer::RunBackgroundThread, this);
+	}
+}
+
+CTerrainStreamer::~CTerrainStreamer()
+{
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_dqLoadQueue.clear();
+	}
+	SaveDirtyTiles();
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_bShouldStop = true;
+	}
+	m_JobCondition.notify_all();
+
+	for (auto& Thread : m_vThreads)
+	{
+		Thread.join();
+	}
+}
+
+void CTerrainStreamer::Update(const XMFLOAT2& CameraPositionXZ, vector<SEvent>& vOutEvents)
+{
+	++m_UpdateIndex;
+
+	// Finished loads become resident (even if they aren't required anymore, they are cached)
+	vector<SFinishedLoad> vFinishedLoads{};
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		vFinishedLoads.swap(m_vFinishedLoads);
+	}
+	for (auto& Load : vFinishedLoads)
+	{
+		m_usetLoadingKeys.erase(Load.Coord.GetKey());
+		if (!Load.bWasRead || !IsValidTileData(*Load.Data))
+		{
+			*Load.Data = STerrainTileData();
+			CreateFlatTile(*Load.Data);
+			++m_Stats.CreatedTileCount;
+		}
+		AddTile(Load.Coord, std::move(Load.Data));
+	}
+
+	// Required tiles stay required until they are farther than UnloadRadius (hysteresis)
+	for (auto& Pair : m_umapTiles)
+	{
+		STileState& Tile{ Pair.second };
+		const float KDistance{ CalculateDistance(Tile.Coord, CameraPositionXZ) };
+		const bool bWasRequired{ Tile.bIsRequired };
+		Tile.bIsRequired = (KDistance < m_Desc.LoadRadius) || (bWasRequired && KDistance < m_Desc.UnloadRadius);
+		if (Tile.bIsRequired) Tile.LastUsedUpdate = m_UpdateIndex;
+		if (Tile.bIsRequired && !bWasRequired) ++m_Stats.CacheHitCount;
+	}
+
+	// Missing tiles within LoadRadius are requested, nearest first
+	m_vLoadCandidates.clear();
+	const STerrainTileCoord KMin{ GetTileCoord(XMFLOAT2(CameraPositionXZ.x - m_Desc.LoadRadius, CameraPositionXZ.y - m_Desc.LoadRadius)) };
+	const STerrainTileCoord KMax{ GetTileCoord(XMFLOAT2(CameraPositionXZ.x + m_Desc.LoadRadius, CameraPositionXZ.y + m_Desc.LoadRadius)) };
+	for (int32_t Z = KMin.Z; Z <= KMax.Z; ++Z)
+	{
+		for (int32_t X = KMin.X; X <= KMax.X; ++X)
+		{
+			const STerrainTileCoord KCoord{ X, Z };
+			const float KDistance{ CalculateDistance(KCoord, CameraPositionXZ) };
+			if (KDistance >= m_Desc.LoadRadius) continue;
+			if (m_umapTiles.count(KCoord.GetKey()) || m_usetLoadingKeys.count(KCoord.GetKey())) continue;
+
+			m_vLoadCandidates.emplace_back(KDistance, KCoord);
+		}
+	}
+	std::sort(m_vLoadCandidates.begin(), m_vLoadCandidates.end(),
+		[](const std::pair<float, STerrainTileCoord>& a, const std::pair<float, STerrainTileCoord>& b) { return a.first < b.first; });
+
+	{
+		std::unique_lock<std::mutex> Lock{ m_Mutex };
+
+		// Queued loads of tiles that the camera left behind are dropped (loads that already started finish and are cached)
+		for (auto It = m_dqLoadQueue.begin(); It != m_dqLoadQueue.end();)
+		{
+			if (CalculateDistance(*It, CameraPositionXZ) >= m_Desc.UnloadRadius)
+			{
+				m_usetLoadingKeys.erase(It->GetKey());
+				It = m_dqLoadQueue.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+
+		bool bHasQueuedLoads{};
+		vector<std::pair<STerrainTileCoord, std::shared_ptr<const STerrainTileData>>> vSavedTiles{};
+		for (const auto& Candidate : m_vLoadCandidates)
+		{
+			// A tile that is still being saved is taken from its snapshot, so that it never reads a stale file
+			auto Found{ m_umapPendingSaves.find(Candidate.second.GetKey()) };
+			if (Found != m_umapPendingSaves.end())
+			{
+				vSavedTiles.emplace_back(Candidate.second, Found->second.Data);
+				continue;
+			}
+
+			if (m_usetLoadingKeys.size() >= m_Desc.MaxLoadCountInFlight) continue;
+
+			m_usetLoadingKeys.emplace(Candidate.second.GetKey());
+			m_dqLoadQueue.emplace_back(Candidate.second);
+			bHasQueuedLoads = true;
+		}
+		Lock.unlock();
+
+		if (bHasQueuedLoads) m_JobCondition.notify_all();
+		for (const auto& SavedTile : vSavedTiles)
+		{
+			AddTile(SavedTile.first, make_unique<STerrainTileData>(*SavedTile.second));
+		}
+	}
+
+	// Dirty tiles are saved once their edits stop, from a snapshot so that they can be edited again meanwhile
+	{
+		std::unique_lock<std::mutex> Lock{ m_Mutex };
+		for (auto& Pair : m_umapTiles)
+		{
+			STileState& Tile{ Pair.second };
+			if (!Tile.bIsDirty || Tile.LastEditedUpdate + m_Desc.SaveDelayUpdateCount > m_UpdateIndex) continue;
+
+			QueueSave(Tile.Coord, std::make_shared<const STerrainTileData>(*Tile.Data));
+			Tile.bIsDirty = false;
+		}
+	}
+
+	// The least recently used tiles that aren't required are evicted until the resident bytes fit in the budget
+	if (m_ResidentBytes > m_Desc.ResidentByteBudget)
+	{
+		m_vEvictionCandidates.clear();
+		for (const auto& Pair : m_umapTiles)
+		{
+			if (!Pair.second.bIsRequired) m_vEvictionCandidates.emplace_back(Pair.second.LastUsedUpdate, Pair.first);
+		}
+		std::sort(m_vEvictionCandidates.begin(), m_vEvictionCandidates.end());
+
+		for (const auto& Candidate : m_vEvictionCandidates)
+		{
+			if (m_ResidentBytes <= m_Desc.ResidentByteBudget) break;
+
+			EvictTile(Candidate.second);
+		}
+	}
+
+	m_Stats.ResidentTileCount = m_umapTiles.size();
+	m_Stats.RequiredTileCount = 0;
+	m_Stats.DirtyTileCount = 0;
+	for (const auto& Pair : m_umapTiles)
+	{
+		if (Pair.second.bIsRequired) ++m_Stats.RequiredTileCount;
+		if (Pair.second.bIsDirty) ++m_Stats.DirtyTileCount;
+	}
+	m_Stats.ResidentBytes = m_ResidentBytes;
+	m_Stats.LoadingTileCount = m_usetLoadingKeys.size();
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_Stats.SavingTileCount = m_umapPendingSaves.size();
+		m_Stats.SavedTileCount = m_SavedTileCount;
+		m_Stats.FailedSaveCount = m_FailedSaveCount;
+	}
+
+	vOutEvents.insert(vOutEvents.end(), m_vEvents.begin(), m_vEvents.end());
+	m_vEvents.clear();
+}
+
+const STerrainTileData* CTerrainStreamer::FindTile(const STerrainTileCoord& Coord) const
+{
+	auto Found{ m_umapTiles.find(Coord.GetKey()) };
+	if (Found == m_umapTiles.end()) return nullptr;
+	return Found->second.Data.get();
+}
+
+STerrainTileData* CTerrainStreamer::FindTileForEdit(const STerrainTileCoord& Coord)
+{
+	STileState* const PtrTile{ FindTileState(Coord) };
+	if (!PtrTile) return nullptr;
+	return PtrTile->Data.get();
+}
+
+void CTerrainStreamer::MarkEdited(const STerrainTileCoord& Coord, const CMipGenerator::SRect& HeightRect)
+{
+	STileState* const PtrTile{ FindTileState(Coord) };
+	assert(PtrTile);
+	if (!PtrTile) return;
+
+	PtrTile->bIsDirty = true;
+	PtrTile->LastEditedUpdate = m_UpdateIndex;
+	PtrTile->LastUsedUpdate = m_UpdateIndex;
+	if (HeightRect.IsEmpty()) return;
+
+	// The edges exclude their corners, which have their own stamps
+	const uint32_t KLast{ m_Desc.HeightMapSize };
+	const bool bHasLeftColumn{ HeightRect.Left == 0 };
+	const bool bHasRightColumn{ HeightRect.Right > KLast };
+	const bool bHasTopRow{ HeightRect.Top == 0 };
+	const bool bHasBottomRow{ HeightRect.Bottom > KLast };
+	const bool bReachesInnerRows{ HeightRect.Top < KLast && HeightRect.Bottom > 1 };
+	const bool bReachesInnerColumns{ HeightRect.Left < KLast && HeightRect.Right > 1 };
+	if (!bHasLeftColumn && !bHasRightColumn && !bHasTopRow && !bHasBottomRow) return;
+
+	STerrainTileData& Data{ *PtrTile->Data };
+	const uint64_t KStamp{ GetNextEditStamp() };
+	if (bHasLeftColumn && bReachesInnerRows) Data.EdgeStamps[STerrainTileData::EdgeNegativeX] = KStamp;
+	if (bHasRightColumn && bReachesInnerRows) Data.EdgeStamps[STerrainTileData::EdgePositiveX] = KStamp;
+	if (bHasTopRow && bReachesInnerColumns) Data.EdgeStamps[STerrainTileData::EdgePositiveZ] = KStamp;
+	if (bHasBottomRow && bReachesInnerColumns) Data.EdgeStamps[STerrainTileData::EdgeNegativeZ] = KStamp;
+	if (bHasLeftColumn && bHasTopRow) Data.CornerStamps[STerrainTileData::CornerNegativeXPositiveZ] = KStamp;
+	if (bHasRightColumn && bHasTopRow) Data.CornerStamps[STerrainTileData::CornerPositiveXPositiveZ] = KStamp;
+	if (bHasLeftColumn && bHasBottomRow) Data.CornerStamps[STerrainTileData::CornerNegativeXNegativeZ] = KStamp;
+	if (bHasRightColumn && bHasBottomRow) Data.CornerStamps[STerrainTileData::CornerPositiveXNegativeZ] = KStamp;
+
+	StitchTile(Coord);
+}
+
+void CTerrainStreamer::SaveDirtyTiles()
+{
+	std::lock_guard<std::mutex> Lock{ m_Mutex };
+	for (auto& Pair : m_umapTiles)
+	{
+		STileState& Tile{ Pair.second };
+		if (!Tile.bIsDirty) continue;
+
+		QueueSave(Tile.Coord, std::make_shared<const STerrainTileData>(*Tile.Data));
+		Tile.bIsDirty = false;
+	}
+}
+
+void CTerrainStreamer::Flush()
+{
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	m_IdleCondition.wait(Lock, [&]() { return m_dqLoadQueue.empty() && m_dqSaveQueue.empty() && m_BusyThreadCount == 0; });
+}
+
+STerrainTileCoord CTerrainStreamer::GetTileCoord(const XMFLOAT2& PositionXZ) const
+{
+	return STerrainTileCoord(static_cast<int32_t>(floorf(PositionXZ.x / m_Desc.TileSize)),
+		static_cast<int32_t>(floorf(PositionXZ.y / m_Desc.TileSize)));
+}
+
+float CTerrainStreamer::CalculateDistance(const STerrainTileCoord& Coord, const XMFLOAT2& PositionXZ) const
+{
+	const float KMinX{ Coord.X * m_Desc.TileSize };
+	const float KMinZ{ Coord.Z * m_Desc.TileSize };
+	const float dX{ max(max(KMinX - PositionXZ.x, PositionXZ.x - (KMinX + m_Desc.TileSize)), 0.0f) };
+	const float dZ{ max(max(KMinZ - PositionXZ.y, PositionXZ.y - (KMinZ + m_Desc.TileSize)), 0.0f) };
+	return sqrtf(dX * dX + dZ * dZ);
+}
+
+bool CTerrainStreamer::IsValidTileData(const STerrainTileData& Data) const
+{
+	const size_t KHeightSide{ static_cast<size_t>(m_Desc.HeightMapSize) + 1 };
+	return (Data.vHeights.size() == KHeightSide * KHeightSide)
+		&& (Data.vMasking.size() == static_cast<size_t>(m_Desc.MaskingSize) * m_Desc.MaskingSize)
+		&& (Data.vGrassDensities.size() == static_cast<size_t>(m_Desc.GrassDensitySize) * m_Desc.GrassDensitySize);
+}
+
+void CTerrainStreamer::CreateFlatTile(STerrainTileData& OutData) const
+{
+	const size_t KHeightSide{ static_cast<size_t>(m_Desc.HeightMapSize) + 1 };
+	OutData.vHeights.assign(KHeightSide * KHeightSide, SPixel8UInt{ 127 });
+	OutData.vMasking.assign(static_cast<size_t>(m_Desc.MaskingSize) * m_Desc.MaskingSize, SPixel32UInt());
+	OutData.vGrassDensities.assign(static_cast<size_t>(m_Desc.GrassDensitySize) * m_Desc.GrassDensitySize, 0);
+}
+
+void CTerrainStreamer::RunBackgroundThread()
+{
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	while (true)
+	{
+		m_JobCondition.wait(Lock, [&]() { return m_bShouldStop || m_dqSaveQueue.size() || m_dqLoadQueue.size(); });
+
+		// Saves go first, because evicted tiles keep their memory until they are written
+		if (m_dqSaveQueue.size())
+		{
+			const uint64_t KKey{ m_dqSaveQueue.front() };
+			m_dqSaveQueue.pop_front();
+			++m_BusyThreadCount;
+
+			// A tile has one save job at a time, which writes until the tile's latest snapshot is written
+			SPendingSave& Save{ m_umapPendingSaves.at(KKey) };
+			while (true)
+			{
+				const std::shared_ptr<const STerrainTileData> KData{ Save.Data };
+				const STerrainTileCoord KCoord{ Save.Coord };
+				Lock.unlock();
+				const bool bSucceeded{ m_PtrStore->WriteTile(KCoord, *KData) };
+				Lock.lock();
+
+				if (bSucceeded)
+				{
+					++m_SavedTileCount;
+				}
+				else
+				{
+					++m_FailedSaveCount;
+					OutputDebugString(("- Failed to save terrain tile [" + to_string(KCoord.X) + ", " + to_string(KCoord.Z) + "].\n").c_str());
+				}
+
+				if (Save.Data == KData)
+				{
+					m_umapPendingSaves.erase(KKey);
+					break;
+				}
+			}
+			--m_BusyThreadCount;
+		}
+		else if (m_dqLoadQueue.size())
+		{
+			const STerrainTileCoord KCoord{ m_dqLoadQueue.front() };
+			m_dqLoadQueue.pop_front();
+			++m_BusyThreadCount;
+			Lock.unlock();
+
+			SFinishedLoad Load{};
+			Load.Data = make_unique<STerrainTileData>();
+			Load.Coord = KCoord;
+			Load.bWasRead = m_PtrStore->ReadTile(KCoord, *Load.Data);
+
+			Lock.lock();
+			m_vFinishedLoads.emplace_back(std::move(Load));
+			--m_BusyThreadCount;
+		}
+		else if (m_bShouldStop)
+		{
+			return;
+		}
+
+		if (m_dqLoadQueue.empty() && m_dqSaveQueue.empty() && m_BusyThreadCount == 0) m_IdleCondition.notify_all();
+	}
+}
+
+void CTerrainStreamer::AddTile(const STerrainTileCoord& Coord, unique_ptr<STerrainTileData> Data)
+{
+	for (uint64_t Stamp : Data->EdgeStamps) m_LastEditStamp = max(m_LastEditStamp, Stamp);
+	for (uint64_t Stamp : Data->CornerStamps) m_LastEditStamp = max(m_LastEditStamp, Stamp);
+
+	STileState& Tile{ m_umapTiles[Coord.GetKey()] };
+	Tile.Data = std::move(Data);
+	Tile.Coord = Coord;
+	Tile.LastUsedUpdate = m_UpdateIndex;
+	Tile.bIsRequired = true; // It was requested within LoadRadius, so it stays required until it is farther than UnloadRadius
+	m_ResidentBytes += Tile.Data->GetByteSize();
+	++m_Stats.LoadedTileCount;
+
+	// Loaded goes first, so that the caller sees the tile before any Updated event of it
+	m_vEvents.emplace_back(SEvent{ EEventType::Loaded, Coord });
+	StitchTile(Coord);
+}
+
+void CTerrainStreamer::EvictTile(uint64_t Key)
+{
+	auto Found{ m_umapTiles.find(Key) };
+	if (Found == m_umapTiles.end()) return;
+
+	STileState& Tile{ Found->second };
+	m_ResidentBytes -= Tile.Data->GetByteSize();
+	if (Tile.bIsDirty)
+	{
+		// The save job keeps the data until it is written
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		QueueSave(Tile.Coord, std::shared_ptr<const STerrainTileData>(std::move(Tile.Data)));
+	}
+
+	m_vEvents.emplace_back(SEvent{ EEventType::Evicted, Tile.Coord });
+	m_umapTiles.erase(Found);
+	++m_Stats.EvictedTileCount;
+}
+
+void CTerrainStreamer::QueueSave(const STerrainTileCoord& Coord, std::shared_ptr<const STerrainTileData> Data)
+{
+	// If the tile is being saved already, its save job writes the new snapshot too
+	const uint64_t KKey{ Coord.GetKey() };
+	auto Found{ m_umapPendingSaves.find(KKey) };
+	if (Found != m_umapPendingSaves.end())
+	{
+		Found->second.Data = std::move(Data);
+		return;
+	}
+
+	SPendingSave& Save{ m_umapPendingSaves[KKey] };
+	Save.Data = std::move(Data);
+	Save.Coord = Coord;
+	m_dqSaveQueue.emplace_back(KKey);
+	m_JobCondition.notify_one();
+}
+
+void CTerrainStreamer::StitchTile(const STerrainTileCoord& Coord)
+{
+	STileState* const PtrTile{ FindTileState(Coord) };
+	if (!PtrTile) return;
+
+	StitchEdge(*PtrTile, STerrainTileData::EdgeNegativeX);
+	StitchEdge(*PtrTile, STerrainTileData::EdgePositiveX);
+	StitchEdge(*PtrTile, STerrainTileData::EdgePositiveZ);
+	StitchEdge(*PtrTile, STerrainTileData::EdgeNegativeZ);
+	StitchCorner(*PtrTile, STerrainTileData::CornerNegativeXPositiveZ);
+	StitchCorner(*PtrTile, STerrainTileData::CornerPositiveXPositiveZ);
+	StitchCorner(*PtrTile, STerrainTileData::CornerNegativeXNegativeZ);
+	StitchCorner(*PtrTile, STerrainTileData::CornerPositiveXNegativeZ);
+}
+
+void CTerrainStreamer::StitchEdge(STileState& Tile, STerrainTileData::EEdge eEdge)
+{
+	// Rows go toward -Z, so the +Z neighbour's last row is this tile's first row
+	static constexpr int32_t KOffsetX[4]{ -1, +1, 0, 0 };
+	static constexpr int32_t KOffsetZ[4]{ 0, 0, +1, -1 };
+	static constexpr STerrainTileData::EEdge KOppositeEdges[4]
+	{
+		STerrainTileData::EdgePositiveX, STerrainTileData::EdgeNegativeX, STerrainTileData::EdgeNegativeZ, STerrainTileData::EdgePositiveZ
+	};
+
+	STileState* const PtrNeighbour{ FindTileState(STerrainTileCoord(Tile.Coord.X + KOffsetX[eEdge], Tile.Coord.Z + KOffsetZ[eEdge])) };
+	if (!PtrNeighbour) return;
+
+	const STerrainTileData::EEdge KOppositeEdge{ KOppositeEdges[eEdge] };
+	const uint64_t KStamp{ Tile.Data->EdgeStamps[eEdge] };
+	const uint64_t KNeighbourStamp{ PtrNeighbour->Data->EdgeStamps[KOppositeEdge] };
+	if (KStamp == KNeighbourStamp) return;
+
+	STileState& Source{ (KStamp > KNeighbourStamp) ? Tile : *PtrNeighbour };
+	STileState& Destination{ (KStamp > KNeighbourStamp) ? *PtrNeighbour : Tile };
+	const STerrainTileData::EEdge KSourceEdge{ (KStamp > KNeighbourStamp) ? eEdge : KOppositeEdge };
+	const STerrainTileData::EEdge KDestinationEdge{ (KStamp > KNeighbourStamp) ? KOppositeEdge : eEdge };
+
+	const uint32_t KSide{ m_Desc.HeightMapSize + 1 };
+	auto GetTexelIndex{ [&](STerrainTileData::EEdge eSide, uint32_t i)
+	{
+		switch (eSide)
+		{
+		case STerrainTileData::EdgeNegativeX: return i * KSide;
+		case STerrainTileData::EdgePositiveX: return i * KSide + KSide - 1;
+		case STerrainTileData::EdgePositiveZ: return i;
+		default: return (KSide - 1) * KSide + i;
+		}
+	} };
+	for (uint32_t i = 1; i < KSide - 1; ++i)
+	{
+		Destination.Data->vHeights[GetTexelIndex(KDestinationEdge, i)] = Source.Data->vHeights[GetTexelIndex(KSourceEdge, i)];
+	}
+	Destination.Data->EdgeStamps[KDestinationEdge] = Source.Data->EdgeStamps[KSourceEdge];
+	MarkStitched(Destination);
+}
+
+void CTerrainStreamer::StitchCorner(STileState& Tile, STerrainTileData::ECorner eCorner)
+{
+	// A corner is shared by up to 4 tiles; its index is (+X ? 1 : 0) + (-Z ? 2 : 0), so the same corner of a neighbour flips those bits
+	const bool bIsPositiveX{ (eCorner & 1) != 0 };
+	const bool bIsNegativeZ{ (eCorner & 2) != 0 };
+	const int32_t KOffsetX{ bIsPositiveX ? +1 : -1 };
+	const int32_t KOffsetZ{ bIsNegativeZ ? -1 : +1 };
+	const uint32_t KSide{ m_Desc.HeightMapSize + 1 };
+
+	STileState* PtrTiles[4]{};
+	uint32_t Corners[4]{};
+	size_t Count{};
+	for (uint32_t iShare = 0; iShare < 4; ++iShare)
+	{
+		const bool bIsOtherX{ (iShare & 1) != 0 };
+		const bool bIsOtherZ{ (iShare & 2) != 0 };
+		STileState* const PtrShare{ (iShare == 0) ? &Tile :
+			FindTileState(STerrainTileCoord(Tile.Coord.X + (bIsOtherX ? KOffsetX : 0), Tile.Coord.Z + (bIsOtherZ ? KOffsetZ : 0))) };
+		if (!PtrShare) continue;
+
+		PtrTiles[Count] = PtrShare;
+		Corners[Count] = static_cast<uint32_t>(eCorner) ^ iShare;
+		++Count;
+	}
+	if (Count < 2) return;
+
+	size_t iNewest{};
+	for (size_t iShare = 1; iShare < Count; ++iShare)
+	{
+		if (PtrTiles[iShare]->Data->CornerStamps[Corners[iShare]] > PtrTiles[iNewest]->Data->CornerStamps[Corners[iNewest]]) iNewest = iShare;
+	}
+
+	auto GetTexelIndex{ [&](uint32_t Corner) { return ((Corner & 2) ? (KSide - 1) * KSide : 0) + ((Corner & 1) ? KSide - 1 : 0); } };
+	const STerrainTileData& KNewest{ *PtrTiles[iNewest]->Data };
+	const uint64_t KStamp{ KNewest.CornerStamps[Corners[iNewest]] };
+	const SPixel8UInt KHeight{ KNewest.vHeights[GetTexelIndex(Corners[iNewest])] };
+	for (size_t iShare = 0; iShare < Count; ++iShare)
+	{
+		STerrainTileData& Data{ *PtrTiles[iShare]->Data };
+		if (Data.CornerStamps[Corners[iShare]] == KStamp) continue;
+
+		Data.vHeights[GetTexelIndex(Corners[iShare])] = KHeight;
+		Data.CornerStamps[Corners[iShare]] = KStamp;
+		MarkStitched(*PtrTiles[iShare]);
+	}
+}
+
+void CTerrainStreamer::MarkStitched(STileState& Tile)
+{
+	Tile.bIsDirty = true;
+	Tile.LastEditedUpdate = m_UpdateIndex;
+	m_vEvents.emplace_back(SEvent{ EEventType::Updated, Tile.Coord });
+	++m_Stats.StitchedSeamCount;
+}
+
+CTerrainStreamer::STileState* CTerrainStreamer::FindTileState(const STerrainTileCoord& Coord)
+{
+	auto Found{ m_umapTiles.find(Coord.GetKey()) };
+	if (Found == m_umapTiles.end()) return nullptr;
+	return &Found->second;
+}
+
+uint64_t CTerrainStreamer::GetNextEditStamp()
+{
+	// Microseconds since the epoch, so that edits of a later session are newer even if the tiles they would be compared to aren't resident
+	const uint64_t KNow{ static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count()) };
+	m_LastEditStamp = max(m_LastEditStamp + 1, KNow);
+	return m_LastEditStamp;
+}
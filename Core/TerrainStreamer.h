@@ -0,0 +1,167 @@
+#pragma once
+
+#include "TerrainTileStore.h"
+#include "MipGenerator.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_set>
+
+// Pages the tiles of a terrain that is too large to keep in memory at once (CPU only, no device access)
+// Tiles closer to the camera than LoadRadius are read from a CTerrainTileStore on background threads, nearest first. They stay required
+// until they are farther than UnloadRadius, so a camera that moves back and forth near a tile's border doesn't reload it.
+// Tiles that aren't required stay cached. When the resident bytes exceed the budget, the least recently used ones are evicted.
+// Edited tiles are written back on background threads once the edits stop for a while, or when they are evicted.
+// Resident neighbours are stitched on their shared height texels, and the most recent edit wins (see STerrainTileData).
+class CTerrainStreamer final
+{
+public:
+	struct SDesc
+	{
+		float		TileSize{ 64.0f }; // World units per side
+		uint32_t	HeightMapSize{ 64 }; // Height texel intervals per side (a tile has HeightMapSize + 1 rows and columns)
+		uint32_t	MaskingSize{ 512 }; // Masking texels per side
+		uint32_t	GrassDensitySize{ 64 }; // Grass density texels per side
+		float		LoadRadius{ 160.0f }; // Tiles closer than this to the camera (on XZ) are loaded
+		float		UnloadRadius{ 224.0f }; // Required tiles stay required until they are farther than this
+		size_t		ResidentByteBudget{ 256 * 1024 * 1024 }; // Required tiles are never evicted, even over the budget
+		uint32_t	MaxLoadCountInFlight{ 8 };
+		uint32_t	SaveDelayUpdateCount{ 120 }; // Update()s without edits before a dirty tile is saved
+		uint32_t	ThreadCount{}; // Background threads, 0: std::thread::hardware_concurrency() - 1 (at least 1)
+	};
+
+	enum class EEventType
+	{
+		Loaded, // The tile is resident (create its GPU resources)
+		Updated, // A resident tile's height texels were stitched to a neighbour's (update its GPU resources)
+		Evicted // The tile isn't resident anymore (release its GPU resources)
+	};
+
+	struct SEvent
+	{
+		EEventType			eType{};
+		STerrainTileCoord	Coord{};
+	};
+
+	struct SStats
+	{
+		size_t		ResidentTileCount{};
+		size_t		RequiredTileCount{};
+		size_t		ResidentBytes{};
+		size_t		LoadingTileCount{}; // Queued, being read or read but not taken by Update() yet
+		size_t		SavingTileCount{}; // Queued or being written
+		size_t		DirtyTileCount{};
+		size_t		LoadedTileCount{}; // In total
+		size_t		CreatedTileCount{}; // Loaded tiles that the store didn't have (in total)
+		size_t		CacheHitCount{}; // Cached tiles that became required again (in total)
+		size_t		EvictedTileCount{}; // In total
+		size_t		SavedTileCount{}; // In total
+		size_t		FailedSaveCount{}; // In total
+		size_t		StitchedSeamCount{}; // Edges and corners copied between tiles (in total)
+	};
+
+private:
+	struct STileState
+	{
+		unique_ptr<STerrainTileData>	Data{};
+		STerrainTileCoord				Coord{};
+		uint64_t						LastUsedUpdate{};
+		uint64_t						LastEditedUpdate{};
+		bool							bIsRequired{};
+		bool							bIsDirty{};
+	};
+
+	struct SFinishedLoad
+	{
+		unique_ptr<STerrainTileData>	Data{};
+		STerrainTileCoord				Coord{};
+		bool							bWasRead{};
+	};
+
+	struct SPendingSave
+	{
+		std::shared_ptr<const STerrainTileData>	Data{}; // The latest snapshot of the tile
+		STerrainTileCoord						Coord{};
+	};
+
+public:
+	CTerrainStreamer(CTerrainTileStore* const PtrStore, const SDesc& Desc);
+	// Saves the dirty tiles and waits for every background job
+	~CTerrainStreamer();
+
+public:
+	// Takes the finished loads, requests the tiles around the camera, saves the tiles whose edits stopped and evicts over the budget
+	// vOutEvents receives every residency change since the last call, in order
+	void Update(const XMFLOAT2& CameraPositionXZ, vector<SEvent>& vOutEvents);
+
+	// nullptr if the tile isn't resident
+	const STerrainTileData* FindTile(const STerrainTileCoord& Coord) const;
+	// After editing a tile's data, call MarkEdited()
+	STerrainTileData* FindTileForEdit(const STerrainTileCoord& Coord);
+	// HeightRect: the edited height texels (empty if only the masking or grass densities were edited)
+	// The shared texels in it are stitched to the resident neighbours right away
+	void MarkEdited(const STerrainTileCoord& Coord, const CMipGenerator::SRect& HeightRect);
+
+	// Queues every dirty tile to be saved now (e.g. before quitting)
+	void SaveDirtyTiles();
+	// Waits until every queued load and save is done (finished loads are taken by the next Update())
+	void Flush();
+
+	const SDesc& GetDesc() const { return m_Desc; }
+	const SStats& GetStats() const { return m_Stats; }
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_vThreads.size()); }
+
+public:
+	STerrainTileCoord GetTileCoord(const XMFLOAT2& PositionXZ) const;
+	// From PositionXZ to the nearest point of the tile (0 inside it)
+	float CalculateDistance(const STerrainTileCoord& Coord, const XMFLOAT2& PositionXZ) const;
+	bool IsValidTileData(const STerrainTileData& Data) const;
+	// Heights in the middle of the range, no masking and no grass
+	void CreateFlatTile(STerrainTileData& OutData) const;
+
+private:
+	void RunBackgroundThread();
+
+	void AddTile(const STerrainTileCoord& Coord, unique_ptr<STerrainTileData> Data);
+	void EvictTile(uint64_t Key);
+	// The caller holds m_Mutex
+	void QueueSave(const STerrainTileCoord& Coord, std::shared_ptr<const STerrainTileData> Data);
+
+	// Copies each shared edge and corner from whichever resident tile edited it last
+	void StitchTile(const STerrainTileCoord& Coord);
+	void StitchEdge(STileState& Tile, STerrainTileData::EEdge eEdge);
+	void StitchCorner(STileState& Tile, STerrainTileData::ECorner eCorner);
+	void MarkStitched(STileState& Tile);
+	STileState* FindTileState(const STerrainTileCoord& Coord);
+	uint64_t GetNextEditStamp();
+
+private:
+	CTerrainTileStore* const		m_PtrStore{};
+	SDesc							m_Desc{};
+	SStats							m_Stats{};
+
+	// Main thread only
+	unordered_map<uint64_t, STileState>	m_umapTiles{};
+	std::unordered_set<uint64_t>		m_usetLoadingKeys{};
+	vector<SEvent>						m_vEvents{};
+	vector<std::pair<float, STerrainTileCoord>>	m_vLoadCandidates{};
+	vector<std::pair<uint64_t, uint64_t>>		m_vEvictionCandidates{}; // (LastUsedUpdate, Key)
+	uint64_t							m_UpdateIndex{};
+	uint64_t							m_LastEditStamp{};
+	size_t								m_ResidentBytes{};
+
+	// Shared with the background threads (guarded by m_Mutex)
+	vector<std::thread>						m_vThreads{};
+	std::mutex								m_Mutex{};
+	std::condition_variable					m_JobCondition{};
+	std::condition_variable					m_IdleCondition{};
+	std::deque<STerrainTileCoord>			m_dqLoadQueue{};
+	std::deque<uint64_t>					m_dqSaveQueue{};
+	unordered_map<uint64_t, SPendingSave>	m_umapPendingSaves{};
+	vector<SFinishedLoad>					m_vFinishedLoads{};
+	uint32_t								m_BusyThreadCount{};
+	size_t									m_SavedTileCount{};
+	size_t									m_FailedSaveCount{};
+	bool									m_bShouldStop{};
+};
@@ -0,0 +1,91 @@
+#include "TerrainTileStore.h"
+#include <fstream>
+
+static constexpr uint32_t KTerrainTileMagic{ 0x4C495454 }; // "TTIL"
+
+CTerrainTileFileStore::CTerrainTileFileStore(const string& Directory) : m_Directory{ Directory }
+{
+	// Fails if the directory exists already, which is fine
+	if (m_Directory.size()) CreateDirectoryA(m_Directory.c_str(), nullptr);
+}
+
+bool CTerrainTileFileStore::ReadTile(const STerrainTileCoord& Coord, STerrainTileData& OutData)
+{
+	std::ifstream ifs{};
+	ifs.open(GetTileFileName(Coord), std::ifstream::binary);
+	if (!ifs.is_open()) return false;
+
+	uint32_t Magic{};
+	uint32_t Version{};
+	int32_t X{};
+	int32_t Z{};
+	ifs.read((char*)&Magic, sizeof(Magic));
+	ifs.read((char*)&Version, sizeof(Version));
+	ifs.read((char*)&X, sizeof(X));
+	ifs.read((char*)&Z, sizeof(Z));
+	if (!ifs.good() || Magic != KTerrainTileMagic || Version != KVersion || X != Coord.X || Z != Coord.Z) return false;
+
+	ifs.read((char*)OutData.EdgeStamps, sizeof(OutData.EdgeStamps));
+	ifs.read((char*)OutData.CornerStamps, sizeof(OutData.CornerStamps));
+
+	uint32_t HeightCount{};
+	uint32_t MaskingCount{};
+	uint32_t GrassDensityCount{};
+	ifs.read((char*)&HeightCount, sizeof(HeightCount));
+	ifs.read((char*)&MaskingCount, sizeof(MaskingCount));
+	ifs.read((char*)&GrassDensityCount, sizeof(GrassDensityCount));
+	if (!ifs.good()) return false;
+
+	OutData.vHeights.resize(HeightCount);
+	OutData.vMasking.resize(MaskingCount);
+	OutData.vGrassDensities.resize(GrassDensityCount);
+	ifs.read((char*)OutData.vHeights.data(), OutData.vHeights.size() * sizeof(SPixel8UInt));
+	ifs.read((char*)OutData.vMasking.data(), OutData.vMasking.size() * sizeof(SPixel32UInt));
+	ifs.read((char*)OutData.vGrassDensities.data(), OutData.vGrassDensities.size());
+
+	// A truncated file is treated as missing
+	return ifs.good();
+}
+
+bool CTerrainTileFileStore::WriteTile(const STerrainTileCoord& Coord, const STerrainTileData& Data)
+{
+	const string KFileName{ GetTileFileName(Coord) };
+	const string KTemporaryFileName{ KFileName + ".tmp" };
+
+	std::ofstream ofs{};
+	ofs.open(KTemporaryFileName, std::ofstream::binary);
+	if (!ofs.is_open()) return false;
+
+	uint32_t Version{ KVersion };
+	uint32_t HeightCount{ static_cast<uint32_t>(Data.vHeights.size()) };
+	uint32_t MaskingCount{ static_cast<uint32_t>(Data.vMasking.size()) };
+	uint32_t GrassDensityCount{ static_cast<uint32_t>(Data.vGrassDensities.size()) };
+	ofs.write((const char*)&KTerrainTileMagic, sizeof(KTerrainTileMagic));
+	ofs.write((const char*)&Version, sizeof(Version));
+	ofs.write((const char*)&Coord.X, sizeof(Coord.X));
+	ofs.write((const char*)&Coord.Z, sizeof(Coord.Z));
+	ofs.write((const char*)Data.EdgeStamps, sizeof(Data.EdgeStamps));
+	ofs.write((const char*)Data.CornerStamps, sizeof(Data.CornerStamps));
+	ofs.write((const char*)&HeightCount, sizeof(HeightCount));
+	ofs.write((const char*)&MaskingCount, sizeof(MaskingCount));
+	ofs.write((const char*)&GrassDensityCount, sizeof(GrassDensityCount));
+	ofs.write((const char*)Data.vHeights.data(), Data.vHeights.size() * sizeof(SPixel8UInt));
+	ofs.write((const char*)Data.vMasking.data(), Data.vMasking.size() * sizeof(SPixel32UInt));
+	ofs.write((const char*)Data.vGrassDensities.data(), Data.vGrassDensities.size());
+
+	bool bSucceeded{ ofs.good() };
+	ofs.close();
+	if (!bSucceeded)
+	{
+		DeleteFileA(KTemporaryFileName.c_str());
+		return false;
+	}
+	return MoveFileExA(KTemporaryFileName.c_str(), KFileName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+string CTerrainTileFileStore::GetTileFileName(const STerrainTileCoord& Coord) const
+{
+	const string KName{ to_string(Coord.X) + "_" + to_string(Coord.Z) + ".tile" };
+	if (m_Directory.empty()) return KName;
+	return m_Directory + "/" + KName;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "Material.h"
+
+// ###########################
+// << TERRAIN TILE FILE (<Directory>/<X>_<Z>.tile) >>
+// 4B "TTIL" magic
+// 4B (uint32_t) Version
+// 4B (int32_t) X
+// 4B (int32_t) Z
+// 8B (uint64_t) * 4 Edge edit stamps
+// 8B (uint64_t) * 4 Corner edit stamps
+// 4B (uint32_t) Height texel count
+// 4B (uint32_t) Masking texel count
+// 4B (uint32_t) Grass density texel count
+// # Heights (1B each, UNORM)
+// # Masking (4B each, RGBA UNORM)
+// # Grass densities (1B each, UNORM)
+// ###########################
+
+// Tile (X, Z) of a paged terrain covers world X in [X, X + 1] * TileSize and Z in [Z, Z + 1] * TileSize
+struct STerrainTileCoord
+{
+	STerrainTileCoord() {}
+	STerrainTileCoord(int32_t _X, int32_t _Z) : X{ _X }, Z{ _Z } {}
+
+	bool operator==(const STerrainTileCoord& b) const { return X == b.X && Z == b.Z; }
+	bool operator!=(const STerrainTileCoord& b) const { return !(*this == b); }
+	uint64_t GetKey() const { return (static_cast<uint64_t>(static_cast<uint32_t>(X)) << 32) | static_cast<uint32_t>(Z); }
+
+	int32_t	X{};
+	int32_t	Z{};
+};
+
+// Rows go toward -Z and columns toward +X (as CTerrain's textures), so texel (0, 0) is the tile's (-X, +Z) corner
+struct STerrainTileData
+{
+	enum EEdge { EdgeNegativeX, EdgePositiveX, EdgePositiveZ, EdgeNegativeZ };
+	enum ECorner { CornerNegativeXPositiveZ, CornerPositiveXPositiveZ, CornerNegativeXNegativeZ, CornerPositiveXNegativeZ };
+
+	size_t GetByteSize() const
+	{
+		return vHeights.size() * sizeof(SPixel8UInt) + vMasking.size() * sizeof(SPixel32UInt) + vGrassDensities.size() * sizeof(uint8_t);
+	}
+
+	// (HeightMapSize + 1)^2 texels; the first and last rows and columns are shared with the neighbours, so that there are no cracks
+	vector<SPixel8UInt>		vHeights{};
+	// MaskingSize^2 texels (texel centers, so nothing is shared)
+	vector<SPixel32UInt>	vMasking{};
+	// GrassDensitySize^2 texels
+	vector<uint8_t>			vGrassDensities{};
+
+	// When the shared height texels of an edge (without its corners) or of a corner were last edited (0: never)
+	// Where two resident tiles disagree, the more recent edit wins (see CTerrainStreamer)
+	uint64_t				EdgeStamps[4]{};
+	uint64_t				CornerStamps[4]{};
+};
+
+// Where the tiles of a paged terrain are kept (see CTerrainStreamer)
+// @important: ReadTile() and WriteTile() are called from background threads, for different tiles at once (never for the same tile at once)
+class CTerrainTileStore
+{
+public:
+	CTerrainTileStore() {}
+	virtual ~CTerrainTileStore() {}
+
+public:
+	// Returns false if the tile has never been written or can't be read
+	virtual bool ReadTile(const STerrainTileCoord& Coord, STerrainTileData& OutData) = 0;
+	virtual bool WriteTile(const STerrainTileCoord& Coord, const STerrainTileData& Data) = 0;
+};
+
+// One file per tile in Directory (created if it doesn't exist)
+// A tile is written to a temporary file first and then renamed, so that a failed write never leaves a damaged tile behind
+class CTerrainTileFileStore final : public CTerrainTileStore
+{
+public:
+	CTerrainTileFileStore(const string& Directory);
+	~CTerrainTileFileStore() {}
+
+public:
+	bool ReadTile(const STerrainTileCoord& Coord, STerrainTileData& OutData) override;
+	bool WriteTile(const STerrainTileCoord& Coord, const STerrainTileData& Data) override;
+
+	string GetTileFileName(const STerrainTileCoord& Coord) const;
+
+public:
+	static constexpr uint32_t	KVersion{ 1 };
+
+private:
+	string		m_Directory{};
+};
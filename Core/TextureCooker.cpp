@@ -0,0 +1,1074 @@
+#include "TextureCooker.h"
+#include "RenderDevice.h"
+#include <thread>
+#include <fstream>
+#include <cfloat>
+#include <climits>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+#endif
+
+static constexpr uint32_t KDDSMagic{ 0x20534444 }; // "DDS "
+static constexpr uint32_t KDDSFourCCDX10{ 0x30315844 }; // "DX10"
+static constexpr uint32_t KBC7Weights4[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct SBlockBitWriter
+{
+	void Write(uint32_t Value, uint32_t BitCount)
+	{
+		for (uint32_t iBit = 0; iBit < BitCount; ++iBit)
+		{
+			if (Value & (1 << iBit)) PtrBytes[Offset >> 3] |= static_cast<uint8_t>(1 << (Offset & 7));
+			++Offset;
+		}
+	}
+
+	uint8_t*	PtrBytes{};
+	uint32_t	Offset{};
+};
+
+struct SBlockBitReader
+{
+	uint32_t Read(uint32_t BitCount)
+	{
+		uint32_t Result{};
+		for (uint32_t iBit = 0; iBit < BitCount; ++iBit)
+		{
+			if (PtrBytes[Offset >> 3] & (1 << (Offset & 7))) Result |= (1 << iBit);
+			++Offset;
+		}
+		return Result;
+	}
+
+	const uint8_t*	PtrBytes{};
+	uint32_t		Offset{};
+};
+
+static void GetBlockPixels(const CTextureCooker::SImage& Image, uint32_t BlockX, uint32_t BlockY, SPixel32UInt (&OutPixels)[16])
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		uint32_t SrcY{ min(BlockY * 4 + y, Image.Height - 1) };
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			uint32_t SrcX{ min(BlockX * 4 + x, Image.Width - 1) };
+			OutPixels[y * 4 + x] = Image.vPixels[static_cast<size_t>(SrcY) * Image.Width + SrcX];
+		}
+	}
+}
+
+static void SetBlockPixels(CTextureCooker::SImage& Image, uint32_t BlockX, uint32_t BlockY, const SPixel32UInt (&Pixels)[16])
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		uint32_t DestY{ BlockY * 4 + y };
+		if (DestY >= Image.Height) break;
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			uint32_t DestX{ BlockX * 4 + x };
+			if (DestX >= Image.Width) break;
+			Image.vPixels[static_cast<size_t>(DestY) * Image.Width + DestX] = Pixels[y * 4 + x];
+		}
+	}
+}
+
+// Principal axis of the block colors (power iteration on the covariance matrix)
+static void CalculatePrincipalAxis(const float (&Colors)[16][4], uint32_t ChannelCount, float (&OutMean)[4], float (&OutAxis)[4])
+{
+	float Min[4]{ 255, 255, 255, 255 };
+	float Max[4]{};
+	for (uint32_t iChannel = 0; iChannel < 4; ++iChannel) OutMean[iChannel] = OutAxis[iChannel] = 0;
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		for (uint32_t iChannel = 0; iChannel < ChannelCount; ++iChannel)
+		{
+			OutMean[iChannel] += Colors[iPixel][iChannel];
+			Min[iChannel] = min(Min[iChannel], Colors[iPixel][iChannel]);
+			Max[iChannel] = max(Max[iChannel], Colors[iPixel][iChannel]);
+		}
+	}
+	for (uint32_t iChannel = 0; iChannel < ChannelCount; ++iChannel) OutMean[iChannel] /= 16.0f;
+
+	float Covariance[4][4]{};
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		for (uint32_t i = 0; i < ChannelCount; ++i)
+		{
+			float Di{ Colors[iPixel][i] - OutMean[i] };
+			for (uint32_t j = 0; j < ChannelCount; ++j)
+			{
+				Covariance[i][j] += Di * (Colors[iPixel][j] - OutMean[j]);
+			}
+		}
+	}
+
+	for (uint32_t iChannel = 0; iChannel < ChannelCount; ++iChannel) OutAxis[iChannel] = Max[iChannel] - Min[iChannel];
+	for (int iIteration = 0; iIteration < 8; ++iIteration)
+	{
+		float Next[4]{};
+		float LengthSquared{};
+		for (uint32_t i = 0; i < ChannelCount; ++i)
+		{
+			for (uint32_t j = 0; j < ChannelCount; ++j) Next[i] += Covariance[i][j] * OutAxis[j];
+			LengthSquared += Next[i] * Next[i];
+		}
+		if (LengthSquared < 1e-8f) break;
+
+		float InvLength{ 1.0f / sqrtf(LengthSquared) };
+		for (uint32_t i = 0; i < ChannelCount; ++i) OutAxis[i] = Next[i] * InvLength;
+	}
+}
+
+static void CalculateEndpointsAlongAxis(const float (&Colors)[16][4], uint32_t ChannelCount, float (&OutE0)[4], float (&OutE1)[4])
+{
+	float Mean[4]{};
+	float Axis[4]{};
+	CalculatePrincipalAxis(Colors, ChannelCount, Mean, Axis);
+
+	float MinT{ FLT_MAX };
+	float MaxT{ -FLT_MAX };
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		float T{};
+		for (uint32_t iChannel = 0; iChannel < ChannelCount; ++iChannel) T += (Colors[iPixel][iChannel] - Mean[iChannel]) * Axis[iChannel];
+		MinT = min(MinT, T);
+		MaxT = max(MaxT, T);
+	}
+
+	for (uint32_t iChannel = 0; iChannel < 4; ++iChannel)
+	{
+		OutE0[iChannel] = min(max(Mean[iChannel] + Axis[iChannel] * MaxT, 0.0f), 255.0f);
+		OutE1[iChannel] = min(max(Mean[iChannel] + Axis[iChannel] * MinT, 0.0f), 255.0f);
+	}
+}
+
+static uint16_t PackRGB565(const float (&Color)[4])
+{
+	uint32_t R{ static_cast<uint32_t>(Color[0] * 31.0f / 255.0f + 0.5f) };
+	uint32_t G{ static_cast<uint32_t>(Color[1] * 63.0f / 255.0f + 0.5f) };
+	uint32_t B{ static_cast<uint32_t>(Color[2] * 31.0f / 255.0f + 0.5f) };
+	return static_cast<uint16_t>((min(R, 31u) << 11) | (min(G, 63u) << 5) | min(B, 31u));
+}
+
+static void UnpackRGB565(uint16_t Packed, int (&OutColor)[3])
+{
+	int R{ (Packed >> 11) & 31 };
+	int G{ (Packed >> 5) & 63 };
+	int B{ Packed & 31 };
+	OutColor[0] = (R << 3) | (R >> 2);
+	OutColor[1] = (G << 2) | (G >> 4);
+	OutColor[2] = (B << 3) | (B >> 2);
+}
+
+static void GetBC1Palette(uint16_t C0, uint16_t C1, bool bForceFourColors, int (&OutPalette)[4][3])
+{
+	UnpackRGB565(C0, OutPalette[0]);
+	UnpackRGB565(C1, OutPalette[1]);
+	for (int iChannel = 0; iChannel < 3; ++iChannel)
+	{
+		if (C0 > C1 || bForceFourColors)
+		{
+			OutPalette[2][iChannel] = (2 * OutPalette[0][iChannel] + OutPalette[1][iChannel]) / 3;
+			OutPalette[3][iChannel] = (OutPalette[0][iChannel] + 2 * OutPalette[1][iChannel]) / 3;
+		}
+		else
+		{
+			OutPalette[2][iChannel] = (OutPalette[0][iChannel] + OutPalette[1][iChannel]) / 2;
+			OutPalette[3][iChannel] = 0;
+		}
+	}
+}
+
+static uint32_t SelectBC1Indices(const float (&Colors)[16][4], uint16_t C0, uint16_t C1, uint32_t& OutIndices)
+{
+	int Palette[4][3]{};
+	GetBC1Palette(C0, C1, true, Palette);
+
+	uint32_t TotalError{};
+	OutIndices = 0;
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		uint32_t BestIndex{};
+		uint32_t BestError{ UINT_MAX };
+		for (uint32_t iPalette = 0; iPalette < 4; ++iPalette)
+		{
+			uint32_t Error{};
+			for (int iChannel = 0; iChannel < 3; ++iChannel)
+			{
+				int Delta{ static_cast<int>(Colors[iPixel][iChannel]) - Palette[iPalette][iChannel] };
+				Error += static_cast<uint32_t>(Delta * Delta);
+			}
+			if (Error < BestError)
+			{
+				BestError = Error;
+				BestIndex = iPalette;
+			}
+		}
+		OutIndices |= BestIndex << (iPixel * 2);
+		TotalError += BestError;
+	}
+	return TotalError;
+}
+
+// Always produces a 4-color block (C0 > C1), so it can be reused as the color part of BC3
+static void EncodeBC1Block(const SPixel32UInt (&Pixels)[16], uint8_t* const PtrBlock)
+{
+	float Colors[16][4]{};
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		Colors[iPixel][0] = Pixels[iPixel].R;
+		Colors[iPixel][1] = Pixels[iPixel].G;
+		Colors[iPixel][2] = Pixels[iPixel].B;
+	}
+
+	float E0[4]{};
+	float E1[4]{};
+	CalculateEndpointsAlongAxis(Colors, 3, E0, E1);
+
+	uint16_t C0{ PackRGB565(E0) };
+	uint16_t C1{ PackRGB565(E1) };
+	uint32_t Indices{};
+	uint32_t Error{ SelectBC1Indices(Colors, C0, C1, Indices) };
+
+	// Least-squares refinement of the endpoints for the chosen indices
+	{
+		static constexpr float KWeights[4]{ 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float AA{}, AB{}, BB{};
+		float AX[3]{};
+		float BX[3]{};
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+		{
+			float A{ KWeights[(Indices >> (iPixel * 2)) & 3] };
+			float B{ 1.0f - A };
+			AA += A * A;
+			AB += A * B;
+			BB += B * B;
+			for (int iChannel = 0; iChannel < 3; ++iChannel)
+			{
+				AX[iChannel] += A * Colors[iPixel][iChannel];
+				BX[iChannel] += B * Colors[iPixel][iChannel];
+			}
+		}
+
+		float Determinant{ AA * BB - AB * AB };
+		if (fabsf(Determinant) > 1e-6f)
+		{
+			float InvDeterminant{ 1.0f / Determinant };
+			float RefinedE0[4]{};
+			float RefinedE1[4]{};
+			for (int iChannel = 0; iChannel < 3; ++iChannel)
+			{
+				RefinedE0[iChannel] = min(max((AX[iChannel] * BB - BX[iChannel] * AB) * InvDeterminant, 0.0f), 255.0f);
+				RefinedE1[iChannel] = min(max((BX[iChannel] * AA - AX[iChannel] * AB) * InvDeterminant, 0.0f), 255.0f);
+			}
+
+			uint16_t RefinedC0{ PackRGB565(RefinedE0) };
+			uint16_t RefinedC1{ PackRGB565(RefinedE1) };
+			uint32_t RefinedIndices{};
+			uint32_t RefinedError{ SelectBC1Indices(Colors, RefinedC0, RefinedC1, RefinedIndices) };
+			if (RefinedError < Error)
+			{
+				C0 = RefinedC0;
+				C1 = RefinedC1;
+				Indices = RefinedIndices;
+			}
+		}
+	}
+
+	if (C0 < C1)
+	{
+		std::swap(C0, C1);
+		Indices ^= 0x55555555; // 0 <-> 1, 2 <-> 3
+	}
+	else if (C0 == C1)
+	{
+		Indices = 0;
+	}
+
+	memcpy(PtrBlock + 0, &C0, 2);
+	memcpy(PtrBlock + 2, &C1, 2);
+	memcpy(PtrBlock + 4, &Indices, 4);
+}
+
+static void DecodeBC1Block(const uint8_t* const PtrBlock, bool bForceFourColors, SPixel32UInt (&OutPixels)[16])
+{
+	uint16_t C0{};
+	uint16_t C1{};
+	uint32_t Indices{};
+	memcpy(&C0, PtrBlock + 0, 2);
+	memcpy(&C1, PtrBlock + 2, 2);
+	memcpy(&Indices, PtrBlock + 4, 4);
+
+	int Palette[4][3]{};
+	GetBC1Palette(C0, C1, bForceFourColors, Palette);
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		uint32_t Index{ (Indices >> (iPixel * 2)) & 3 };
+		OutPixels[iPixel].R = static_cast<uint8_t>(Palette[Index][0]);
+		OutPixels[iPixel].G = static_cast<uint8_t>(Palette[Index][1]);
+		OutPixels[iPixel].B = static_cast<uint8_t>(Palette[Index][2]);
+		OutPixels[iPixel].A = (!bForceFourColors && C0 <= C1 && Index == 3) ? 0 : 255;
+	}
+}
+
+static void GetBC4Palette(uint8_t E0, uint8_t E1, int (&OutPalette)[8])
+{
+	OutPalette[0] = E0;
+	OutPalette[1] = E1;
+	if (E0 > E1)
+	{
+		for (int i = 1; i < 7; ++i) OutPalette[i + 1] = ((7 - i) * E0 + i * E1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; ++i) OutPalette[i + 1] = ((5 - i) * E0 + i * E1) / 5;
+		OutPalette[6] = 0;
+		OutPalette[7] = 255;
+	}
+}
+
+static void EncodeBC4Block(const uint8_t (&Values)[16], uint8_t* const PtrBlock)
+{
+	uint8_t E0{};
+	uint8_t E1{ 255 };
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		E0 = max(E0, Values[iPixel]);
+		E1 = min(E1, Values[iPixel]);
+	}
+
+	int Palette[8]{};
+	GetBC4Palette(E0, E1, Palette);
+
+	uint64_t Indices{};
+	if (E0 != E1)
+	{
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+		{
+			uint64_t BestIndex{};
+			int BestError{ INT_MAX };
+			for (uint32_t iPalette = 0; iPalette < 8; ++iPalette)
+			{
+				int Error{ abs(static_cast<int>(Values[iPixel]) - Palette[iPalette]) };
+				if (Error < BestError)
+				{
+					BestError = Error;
+					BestIndex = iPalette;
+				}
+			}
+			Indices |= BestIndex << (iPixel * 3);
+		}
+	}
+
+	PtrBlock[0] = E0;
+	PtrBlock[1] = E1;
+	for (int iByte = 0; iByte < 6; ++iByte) PtrBlock[2 + iByte] = static_cast<uint8_t>(Indices >> (iByte * 8));
+}
+
+static void DecodeBC4Block(const uint8_t* const PtrBlock, uint8_t (&OutValues)[16])
+{
+	int Palette[8]{};
+	GetBC4Palette(PtrBlock[0], PtrBlock[1], Palette);
+
+	uint64_t Indices{};
+	for (int iByte = 0; iByte < 6; ++iByte) Indices |= static_cast<uint64_t>(PtrBlock[2 + iByte]) << (iByte * 8);
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		OutValues[iPixel] = static_cast<uint8_t>(Palette[(Indices >> (iPixel * 3)) & 7]);
+	}
+}
+
+// BC7 mode 6: 1 subset, RGBA 7.7.7.7 endpoints + unique p-bit, 4-bit indices
+static void QuantizeBC7Mode6Endpoint(const float (&Endpoint)[4], uint32_t (&OutQuantized)[4], uint32_t& OutPBit)
+{
+	float BestError{ FLT_MAX };
+	for (uint32_t PBit = 0; PBit < 2; ++PBit)
+	{
+		uint32_t Quantized[4]{};
+		float Error{};
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+		{
+			int Q{ static_cast<int>((Endpoint[iChannel] - PBit) * 0.5f + 0.5f) };
+			Quantized[iChannel] = static_cast<uint32_t>(min(max(Q, 0), 127));
+			float Delta{ static_cast<float>((Quantized[iChannel] << 1) | PBit) - Endpoint[iChannel] };
+			Error += Delta * Delta;
+		}
+		if (Error < BestError)
+		{
+			BestError = Error;
+			OutPBit = PBit;
+			memcpy(OutQuantized, Quantized, sizeof(Quantized));
+		}
+	}
+}
+
+static void EncodeBC7Block(const SPixel32UInt (&Pixels)[16], uint8_t* const PtrBlock)
+{
+	float Colors[16][4]{};
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		Colors[iPixel][0] = Pixels[iPixel].R;
+		Colors[iPixel][1] = Pixels[iPixel].G;
+		Colors[iPixel][2] = Pixels[iPixel].B;
+		Colors[iPixel][3] = Pixels[iPixel].A;
+	}
+
+	float E[2][4]{};
+	CalculateEndpointsAlongAxis(Colors, 4, E[0], E[1]);
+
+	uint32_t Quantized[2][4]{};
+	uint32_t PBits[2]{};
+	QuantizeBC7Mode6Endpoint(E[0], Quantized[0], PBits[0]);
+	QuantizeBC7Mode6Endpoint(E[1], Quantized[1], PBits[1]);
+
+	int Unquantized[2][4]{};
+	for (int iEndpoint = 0; iEndpoint < 2; ++iEndpoint)
+	{
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+		{
+			Unquantized[iEndpoint][iChannel] = static_cast<int>((Quantized[iEndpoint][iChannel] << 1) | PBits[iEndpoint]);
+		}
+	}
+
+	uint32_t Indices[16]{};
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		int BestError{ INT_MAX };
+		for (uint32_t iPalette = 0; iPalette < 16; ++iPalette)
+		{
+			int W{ static_cast<int>(KBC7Weights4[iPalette]) };
+			int Error{};
+			for (int iChannel = 0; iChannel < 4; ++iChannel)
+			{
+				int Value{ ((64 - W) * Unquantized[0][iChannel] + W * Unquantized[1][iChannel] + 32) >> 6 };
+				int Delta{ static_cast<int>(Colors[iPixel][iChannel]) - Value };
+				Error += Delta * Delta;
+			}
+			if (Error < BestError)
+			{
+				BestError = Error;
+				Indices[iPixel] = iPalette;
+			}
+		}
+	}
+
+	// @important: the anchor index's MSB is implicit (0)
+	if (Indices[0] & 8)
+	{
+		std::swap(Quantized[0], Quantized[1]);
+		std::swap(PBits[0], PBits[1]);
+		for (auto& Index : Indices) Index = 15 - Index;
+	}
+
+	memset(PtrBlock, 0, 16);
+	SBlockBitWriter Writer{ PtrBlock };
+	Writer.Write(1 << 6, 7);
+	for (int iChannel = 0; iChannel < 4; ++iChannel)
+	{
+		Writer.Write(Quantized[0][iChannel], 7);
+		Writer.Write(Quantized[1][iChannel], 7);
+	}
+	Writer.Write(PBits[0], 1);
+	Writer.Write(PBits[1], 1);
+	Writer.Write(Indices[0], 3);
+	for (uint32_t iPixel = 1; iPixel < 16; ++iPixel) Writer.Write(Indices[iPixel], 4);
+}
+
+static void DecodeBC7Block(const uint8_t* const PtrBlock, SPixel32UInt (&OutPixels)[16])
+{
+	SBlockBitReader Reader{ PtrBlock };
+	uint32_t Mode{ Reader.Read(7) };
+	assert(Mode == (1 << 6)); // Only mode 6 is cooked
+
+	uint32_t Quantized[2][4]{};
+	for (int iChannel = 0; iChannel < 4; ++iChannel)
+	{
+		Quantized[0][iChannel] = Reader.Read(7);
+		Quantized[1][iChannel] = Reader.Read(7);
+	}
+	uint32_t PBits[2]{ Reader.Read(1), Reader.Read(1) };
+
+	int Unquantized[2][4]{};
+	for (int iEndpoint = 0; iEndpoint < 2; ++iEndpoint)
+	{
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+		{
+			Unquantized[iEndpoint][iChannel] = static_cast<int>((Quantized[iEndpoint][iChannel] << 1) | PBits[iEndpoint]);
+		}
+	}
+
+	for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+	{
+		int W{ static_cast<int>(KBC7Weights4[Reader.Read((iPixel == 0) ? 3 : 4)]) };
+		uint8_t Values[4]{};
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+		{
+			Values[iChannel] = static_cast<uint8_t>(((64 - W) * Unquantized[0][iChannel] + W * Unquantized[1][iChannel] + 32) >> 6);
+		}
+		OutPixels[iPixel] = SPixel32UInt{ Values[0], Values[1], Values[2], Values[3] };
+	}
+}
+
+static void EncodeBlock(const SPixel32UInt (&Pixels)[16], CTextureCooker::EFormat eFormat, uint8_t* const PtrBlock)
+{
+	uint8_t Channel0[16]{};
+	uint8_t Channel1[16]{};
+
+	switch (eFormat)
+	{
+	case CTextureCooker::EFormat::BC1:
+		EncodeBC1Block(Pixels, PtrBlock);
+		break;
+	case CTextureCooker::EFormat::BC3:
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel) Channel0[iPixel] = Pixels[iPixel].A;
+		EncodeBC4Block(Channel0, PtrBlock);
+		EncodeBC1Block(Pixels, PtrBlock + 8);
+		break;
+	case CTextureCooker::EFormat::BC5:
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel)
+		{
+			Channel0[iPixel] = Pixels[iPixel].R;
+			Channel1[iPixel] = Pixels[iPixel].G;
+		}
+		EncodeBC4Block(Channel0, PtrBlock);
+		EncodeBC4Block(Channel1, PtrBlock + 8);
+		break;
+	case CTextureCooker::EFormat::BC7:
+		EncodeBC7Block(Pixels, PtrBlock);
+		break;
+	default:
+		break;
+	}
+}
+
+static void DecodeBlock(const uint8_t* const PtrBlock, CTextureCooker::EFormat eFormat, SPixel32UInt (&OutPixels)[16])
+{
+	uint8_t Channel0[16]{};
+	uint8_t Channel1[16]{};
+
+	switch (eFormat)
+	{
+	case CTextureCooker::EFormat::BC1:
+		DecodeBC1Block(PtrBlock, false, OutPixels);
+		break;
+	case CTextureCooker::EFormat::BC3:
+		DecodeBC1Block(PtrBlock + 8, true, OutPixels);
+		DecodeBC4Block(PtrBlock, Channel0);
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel) OutPixels[iPixel].A = Channel0[iPixel];
+		break;
+	case CTextureCooker::EFormat::BC5:
+		DecodeBC4Block(PtrBlock, Channel0);
+		DecodeBC4Block(PtrBlock + 8, Channel1);
+		for (uint32_t iPixel = 0; iPixel < 16; ++iPixel) OutPixels[iPixel] = SPixel32UInt{ Channel0[iPixel], Channel1[iPixel], 0, 255 };
+		break;
+	case CTextureCooker::EFormat::BC7:
+		DecodeBC7Block(PtrBlock, OutPixels);
+		break;
+	default:
+		break;
+	}
+}
+
+bool CTextureCooker::Cook(const string& SourceFileName, EFormat eFormat, bool bShouldGenerateMipMap, const CMipGenerator::SDesc& MipDesc)
+{
+	return Cook(SourceFileName, GetCookedFileName(SourceFileName), eFormat, bShouldGenerateMipMap, MipDesc);
+}
+
+bool CTextureCooker::Cook(const string& SourceFileName, const string& CookedFileName, EFormat eFormat, bool bShouldGenerateMipMap,
+	const CMipGenerator::SDesc& MipDesc)
+{
+	m_LastStats = SCookStats();
+
+	ULONGLONG StartTimePoint{ GetTickCount64() };
+
+	SImage Source{};
+	if (!LoadImageFromFile(SourceFileName, Source))
+	{
+		OutputDebugString(("Failed to load texture for cooking: " + SourceFileName + "\n").c_str());
+		return false;
+	}
+	if ((Source.Width % KBlockSize) || (Source.Height % KBlockSize))
+	{
+		// @important: D3D11 requires the top-level size of block-compressed textures to be a multiple of 4
+		OutputDebugString(("Texture size is not a multiple of 4: " + SourceFileName + "\n").c_str());
+		return false;
+	}
+
+	vector<SImage> vMipChain{};
+	CMipGenerator::SStats MipStats{};
+	if (bShouldGenerateMipMap)
+	{
+		GenerateMipChain(Source, MipDesc, vMipChain, &MipStats);
+	}
+	else
+	{
+		vMipChain.emplace_back(Source);
+	}
+
+	ULONGLONG EncodeStartTimePoint{ GetTickCount64() };
+	size_t EncodedPixelCount{};
+	vector<vector<uint8_t>> vMipBlocks(vMipChain.size());
+	for (size_t iMip = 0; iMip < vMipChain.size(); ++iMip)
+	{
+		EncodeImage(vMipChain[iMip], eFormat, vMipBlocks[iMip]);
+		EncodedPixelCount += vMipChain[iMip].vPixels.size();
+	}
+	ULONGLONG EncodeElapsed{ GetTickCount64() - EncodeStartTimePoint };
+
+	if (!WriteDDSFile(CookedFileName, eFormat, Source.Width, Source.Height, vMipBlocks))
+	{
+		OutputDebugString(("Failed to write cooked texture: " + CookedFileName + "\n").c_str());
+		return false;
+	}
+
+	SImage Decoded{};
+	DecodeImage(vMipBlocks[0], eFormat, Source.Width, Source.Height, Decoded);
+
+	m_LastStats.Width = Source.Width;
+	m_LastStats.Height = Source.Height;
+	m_LastStats.MipLevels = static_cast<uint32_t>(vMipChain.size());
+	m_LastStats.SourceByteSize = EncodedPixelCount * sizeof(SPixel32UInt);
+	for (const auto& vBlocks : vMipBlocks) m_LastStats.CookedByteSize += vBlocks.size();
+	m_LastStats.PSNR = CalculatePSNR(Source, Decoded, eFormat);
+	m_LastStats.MegaPixelsPerSecond = static_cast<float>(EncodedPixelCount) / 1'000.0f / static_cast<float>(max(EncodeElapsed, 1ULL));
+	m_LastStats.MipMegaPixelsPerSecond = MipStats.MegaPixelsPerSecond;
+	m_LastStats.ElapsedMilliseconds = GetTickCount64() - StartTimePoint;
+
+	static constexpr const char* KFormatNames[]{ "BC1", "BC3", "BC5", "BC7" };
+	OutputDebugString(("Cooked " + SourceFileName + " -> " + CookedFileName + " [" + KFormatNames[(int)eFormat] + "] "
+		+ to_string(m_LastStats.Width) + "x" + to_string(m_LastStats.Height) + " " + to_string(m_LastStats.MipLevels) + " mips, "
+		+ to_string(m_LastStats.SourceByteSize) + "B -> " + to_string(m_LastStats.CookedByteSize) + "B, PSNR "
+		+ to_string(m_LastStats.PSNR) + "dB, " + to_string(m_LastStats.MegaPixelsPerSecond) + "MPix/s (mips "
+		+ to_string(m_LastStats.MipMegaPixelsPerSecond) + "MPix/s) ["
+		+ to_string(m_LastStats.ElapsedMilliseconds) + "] elapsed.\n").c_str());
+
+	return true;
+}
+
+string CTextureCooker::GetCookedFileName(const string& SourceFileName)
+{
+	size_t found{ SourceFileName.find_last_of('.') };
+	return SourceFileName.substr(0, found) + ".dds";
+}
+
+bool CTextureCooker::IsCookedFileUpToDate(const string& SourceFileName, const string& CookedFileName)
+{
+	struct stat CookedStat {};
+	if (stat(CookedFileName.c_str(), &CookedStat) != 0) return false;
+
+	// @important: modification times have a resolution of 1 second, so a cooked file as old as its source counts as stale
+	struct stat SourceStat {};
+	if (stat(SourceFileName.c_str(), &SourceStat) != 0) return true;
+	return CookedStat.st_mtime > SourceStat.st_mtime;
+}
+
+DXGI_FORMAT CTextureCooker::GetDXGIFormat(EFormat eFormat)
+{
+	switch (eFormat)
+	{
+	case EFormat::BC1:
+		return DXGI_FORMAT_BC1_UNORM;
+	case EFormat::BC3:
+		return DXGI_FORMAT_BC3_UNORM;
+	case EFormat::BC5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case EFormat::BC7:
+		return DXGI_FORMAT_BC7_UNORM;
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+size_t CTextureCooker::GetBlockByteSize(EFormat eFormat)
+{
+	return (eFormat == EFormat::BC1) ? 8 : 16;
+}
+
+bool CTextureCooker::LoadImageFromFile(const string& FileName, SImage& OutImage)
+{
+	string Ext{ FileName.substr(min(FileName.find_last_of('.'), FileName.size())) };
+	for (auto& c : Ext)
+	{
+		c = static_cast<char>(toupper(c));
+	}
+	if (Ext == ".TGA" || Ext == ".BMP")
+	{
+		std::ifstream ifs{};
+		ifs.open(FileName, std::ifstream::binary);
+		if (!ifs.is_open()) return false;
+
+		const vector<uint8_t> KFileData{ std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+		return (Ext == ".TGA") ? LoadTGA(KFileData, OutImage) : LoadBMP(KFileData, OutImage);
+	}
+
+#if defined(_WIN32)
+	// @important: S_FALSE or RPC_E_CHANGED_MODE just mean COM is already initialized on this thread
+	CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+	ComPtr<IWICImagingFactory> Factory{};
+	if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(Factory.GetAddressOf())))) return false;
+
+	wstring wFileName{ FileName.begin(), FileName.end() };
+	ComPtr<IWICBitmapDecoder> Decoder{};
+	if (FAILED(Factory->CreateDecoderFromFilename(wFileName.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand,
+		Decoder.GetAddressOf()))) return false;
+
+	ComPtr<IWICBitmapFrameDecode> Frame{};
+	if (FAILED(Decoder->GetFrame(0, Frame.GetAddressOf()))) return false;
+
+	ComPtr<IWICFormatConverter> Converter{};
+	if (FAILED(Factory->CreateFormatConverter(Converter.GetAddressOf()))) return false;
+	if (FAILED(Converter->Initialize(Frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0,
+		WICBitmapPaletteTypeCustom))) return false;
+
+	UINT Width{};
+	UINT Height{};
+	if (FAILED(Converter->GetSize(&Width, &Height))) return false;
+
+	OutImage.Width = Width;
+	OutImage.Height = Height;
+	OutImage.vPixels.resize(static_cast<size_t>(Width) * Height);
+	return SUCCEEDED(Converter->CopyPixels(nullptr, Width * sizeof(SPixel32UInt),
+		static_cast<UINT>(OutImage.vPixels.size() * sizeof(SPixel32UInt)), (BYTE*)OutImage.vPixels.data()));
+#else
+	return false;
+#endif
+}
+
+bool CTextureCooker::LoadTGA(const vector<uint8_t>& vFileData, SImage& OutImage)
+{
+	// 18B header: ID length, color map type, image type (2: true color, 10: RLE true color), color map spec (5B), origin (4B),
+	// width, height, bits per pixel, descriptor (bit 5: top-left origin)
+	if (vFileData.size() < 18) return false;
+
+	const uint8_t KIDLength{ vFileData[0] };
+	const uint8_t KImageType{ vFileData[2] };
+	const uint32_t KWidth{ static_cast<uint32_t>(vFileData[12] | (vFileData[13] << 8)) };
+	const uint32_t KHeight{ static_cast<uint32_t>(vFileData[14] | (vFileData[15] << 8)) };
+	const uint32_t KByteCountPerPixel{ vFileData[16] / 8u };
+	const bool KbIsTopDown{ (vFileData[17] & 0x20) != 0 };
+	if (vFileData[1] != 0 || (KImageType != 2 && KImageType != 10) || (KByteCountPerPixel != 3 && KByteCountPerPixel != 4)) return false;
+	if (KWidth == 0 || KHeight == 0) return false;
+
+	OutImage.Width = KWidth;
+	OutImage.Height = KHeight;
+	OutImage.vPixels.resize(static_cast<size_t>(KWidth) * KHeight);
+
+	// Pixels are BGR(A), in file order; RLE packets may run across rows
+	size_t Offset{ 18u + KIDLength };
+	size_t iPixel{};
+	auto ReadPixel{ [&](SPixel32UInt& OutPixel)
+		{
+			OutPixel.B = vFileData[Offset];
+			OutPixel.G = vFileData[Offset + 1];
+			OutPixel.R = vFileData[Offset + 2];
+			OutPixel.A = (KByteCountPerPixel == 4) ? vFileData[Offset + 3] : 255;
+			Offset += KByteCountPerPixel;
+		} };
+	vector<SPixel32UInt> vFilePixels(OutImage.vPixels.size());
+	while (iPixel < vFilePixels.size())
+	{
+		uint32_t RunLength{ 1 };
+		bool bIsRun{ false };
+		if (KImageType == 10)
+		{
+			if (Offset >= vFileData.size()) return false;
+			bIsRun = (vFileData[Offset] & 0x80) != 0;
+			RunLength = (vFileData[Offset] & 0x7F) + 1u;
+			++Offset;
+		}
+		RunLength = static_cast<uint32_t>(min(static_cast<size_t>(RunLength), vFilePixels.size() - iPixel));
+		if (Offset + static_cast<size_t>((bIsRun) ? 1 : RunLength) * KByteCountPerPixel > vFileData.size()) return false;
+
+		if (bIsRun)
+		{
+			SPixel32UInt Pixel{};
+			ReadPixel(Pixel);
+			std::fill(vFilePixels.begin() + iPixel, vFilePixels.begin() + iPixel + RunLength, Pixel);
+		}
+		else
+		{
+			for (uint32_t iRun = 0; iRun < RunLength; ++iRun) ReadPixel(vFilePixels[iPixel + iRun]);
+		}
+		iPixel += RunLength;
+	}
+
+	for (uint32_t Y = 0; Y < KHeight; ++Y)
+	{
+		const uint32_t KFileRow{ (KbIsTopDown) ? Y : KHeight - 1 - Y };
+		memcpy(&OutImage.vPixels[static_cast<size_t>(Y) * KWidth], &vFilePixels[static_cast<size_t>(KFileRow) * KWidth], KWidth * sizeof(SPixel32UInt));
+	}
+	return true;
+}
+
+bool CTextureCooker::LoadBMP(const vector<uint8_t>& vFileData, SImage& OutImage)
+{
+	// 14B file header ("BM", file size, reserved, pixel data offset) + BITMAPINFOHEADER or later
+	if (vFileData.size() < 54 || vFileData[0] != 'B' || vFileData[1] != 'M') return false;
+
+	auto Read32{ [&](size_t Offset) { return static_cast<uint32_t>(vFileData[Offset] | (vFileData[Offset + 1] << 8) |
+		(vFileData[Offset + 2] << 16) | (static_cast<uint32_t>(vFileData[Offset + 3]) << 24)); } };
+	const uint32_t KPixelDataOffset{ Read32(10) };
+	const int32_t KWidth{ static_cast<int32_t>(Read32(18)) };
+	const int32_t KSignedHeight{ static_cast<int32_t>(Read32(22)) };
+	const uint32_t KBitCount{ static_cast<uint32_t>(vFileData[28] | (vFileData[29] << 8)) };
+	const uint32_t KCompression{ Read32(30) };
+
+	// Only BI_RGB; a negative height means rows are stored top-down
+	if (KCompression != 0 || (KBitCount != 24 && KBitCount != 32) || KWidth <= 0 || KSignedHeight == 0) return false;
+	const uint32_t KHeight{ static_cast<uint32_t>((KSignedHeight < 0) ? -KSignedHeight : KSignedHeight) };
+	const size_t KByteCountPerPixel{ KBitCount / 8u };
+	const size_t KRowPitch{ (static_cast<size_t>(KWidth) * KByteCountPerPixel + 3) & ~static_cast<size_t>(3) };
+	if (KPixelDataOffset + KRowPitch * KHeight > vFileData.size()) return false;
+
+	OutImage.Width = static_cast<uint32_t>(KWidth);
+	OutImage.Height = KHeight;
+	OutImage.vPixels.resize(static_cast<size_t>(KWidth) * KHeight);
+	for (uint32_t Y = 0; Y < KHeight; ++Y)
+	{
+		const uint32_t KFileRow{ (KSignedHeight < 0) ? Y : KHeight - 1 - Y };
+		const uint8_t* const PtrRow{ &vFileData[KPixelDataOffset + KRowPitch * KFileRow] };
+		for (int32_t X = 0; X < KWidth; ++X)
+		{
+			// @important: the 4th byte of 32-bit BI_RGB pixels is unused (not alpha)
+			const uint8_t* const PtrPixel{ PtrRow + X * KByteCountPerPixel };
+			OutImage.vPixels[static_cast<size_t>(Y) * KWidth + X] = SPixel32UInt{ PtrPixel[2], PtrPixel[1], PtrPixel[0], 255 };
+		}
+	}
+	return true;
+}
+
+void CTextureCooker::GenerateMipChain(const SImage& Source, const CMipGenerator::SDesc& MipDesc, vector<SImage>& vOutMipChain,
+	CMipGenerator::SStats* const PtrOutStats)
+{
+	vector<SImage> vLowerMips{};
+	CMipGenerator::GenerateMipChain(Source.vPixels.data(), Source.Width, Source.Height, MipDesc, vLowerMips, PtrOutStats);
+
+	vOutMipChain.clear();
+	vOutMipChain.reserve(vLowerMips.size() + 1);
+	vOutMipChain.emplace_back(Source);
+	for (auto& Level : vLowerMips)
+	{
+		vOutMipChain.emplace_back(std::move(Level));
+	}
+}
+
+void CTextureCooker::EncodeImage(const SImage& Image, EFormat eFormat, vector<uint8_t>& vOutBlocks)
+{
+	const uint32_t BlockCountX{ max((Image.Width + 3) / 4, 1u) };
+	const uint32_t BlockCountY{ max((Image.Height + 3) / 4, 1u) };
+	const size_t BlockByteSize{ GetBlockByteSize(eFormat) };
+	vOutBlocks.resize(BlockByteSize * BlockCountX * BlockCountY);
+
+	// Encode block rows using multiple threads
+	uint32_t ThreadCount{ min(max(std::thread::hardware_concurrency(), 1u), BlockCountY) };
+	vector<std::thread> vThreads{};
+	for (uint32_t iThread = 0; iThread < ThreadCount; ++iThread)
+	{
+		vThreads.emplace_back([&, iThread]()
+			{
+				SPixel32UInt Pixels[16]{};
+				for (uint32_t BlockY = iThread; BlockY < BlockCountY; BlockY += ThreadCount)
+				{
+					for (uint32_t BlockX = 0; BlockX < BlockCountX; ++BlockX)
+					{
+						GetBlockPixels(Image, BlockX, BlockY, Pixels);
+						EncodeBlock(Pixels, eFormat, &vOutBlocks[(static_cast<size_t>(BlockY) * BlockCountX + BlockX) * BlockByteSize]);
+					}
+				}
+			});
+	}
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+}
+
+void CTextureCooker::DecodeImage(const vector<uint8_t>& vBlocks, EFormat eFormat, uint32_t Width, uint32_t Height, SImage& OutImage)
+{
+	const uint32_t BlockCountX{ max((Width + 3) / 4, 1u) };
+	const uint32_t BlockCountY{ max((Height + 3) / 4, 1u) };
+	const size_t BlockByteSize{ GetBlockByteSize(eFormat) };
+	assert(vBlocks.size() >= BlockByteSize * BlockCountX * BlockCountY);
+
+	OutImage.Width = Width;
+	OutImage.Height = Height;
+	OutImage.vPixels.resize(static_cast<size_t>(Width) * Height);
+
+	SPixel32UInt Pixels[16]{};
+	for (uint32_t BlockY = 0; BlockY < BlockCountY; ++BlockY)
+	{
+		for (uint32_t BlockX = 0; BlockX < BlockCountX; ++BlockX)
+		{
+			DecodeBlock(&vBlocks[(static_cast<size_t>(BlockY) * BlockCountX + BlockX) * BlockByteSize], eFormat, Pixels);
+			SetBlockPixels(OutImage, BlockX, BlockY, Pixels);
+		}
+	}
+}
+
+float CTextureCooker::CalculatePSNR(const SImage& Reference, const SImage& Decoded, EFormat eFormat)
+{
+	assert(Reference.vPixels.size() == Decoded.vPixels.size());
+
+	// Only the channels the format actually stores are compared
+	uint32_t ChannelCount{ 4 };
+	if (eFormat == EFormat::BC1) ChannelCount = 3;
+	if (eFormat == EFormat::BC5) ChannelCount = 2;
+
+	double SquaredErrorSum{};
+	for (size_t iPixel = 0; iPixel < Reference.vPixels.size(); ++iPixel)
+	{
+		const uint8_t* const A{ &Reference.vPixels[iPixel].R };
+		const uint8_t* const B{ &Decoded.vPixels[iPixel].R };
+		for (uint32_t iChannel = 0; iChannel < ChannelCount; ++iChannel)
+		{
+			double Delta{ static_cast<double>(A[iChannel]) - static_cast<double>(B[iChannel]) };
+			SquaredErrorSum += Delta * Delta;
+		}
+	}
+
+	double MSE{ SquaredErrorSum / static_cast<double>(max(Reference.vPixels.size() * ChannelCount, (size_t)1)) };
+	if (MSE <= 0.0) return 99.0f;
+	return static_cast<float>(10.0 * log10(255.0 * 255.0 / MSE));
+}
+
+bool CTextureCooker::ReadDDSFileSize(const string& FileName, uint32_t& OutWidth, uint32_t& OutHeight, uint32_t& OutMipLevels,
+	DXGI_FORMAT* const PtrOutFormat)
+{
+	std::ifstream ifs{};
+	ifs.open(FileName, std::ifstream::binary);
+	if (!ifs.is_open()) return false;
+
+	SDDSHeader Header{};
+	SDDSHeaderDXT10 HeaderDXT10{};
+	DXGI_FORMAT Format{};
+	if (!ReadDDSHeaders(ifs, Header, HeaderDXT10, Format)) return false;
+
+	OutWidth = Header.Width;
+	OutHeight = Header.Height;
+	OutMipLevels = max(Header.MipMapCount, 1u);
+	if (PtrOutFormat) *PtrOutFormat = (Format == DXGI_FORMAT_UNKNOWN) ? DXGI_FORMAT_R8G8B8A8_UNORM : Format;
+	return true;
+}
+
+bool CTextureCooker::ReadDDSFileMips(const string& FileName, uint32_t FirstMip, uint32_t MipCount, vector<vector<uint8_t>>& vOutMips)
+{
+	std::ifstream ifs{};
+	ifs.open(FileName, std::ifstream::binary);
+	if (!ifs.is_open()) return false;
+
+	SDDSHeader Header{};
+	SDDSHeaderDXT10 HeaderDXT10{};
+	D3D11_TEXTURE2D_DESC Desc{};
+	if (!ReadDDSHeaders(ifs, Header, HeaderDXT10, Desc.Format)) return false;
+	if (Desc.Format == DXGI_FORMAT_UNKNOWN || (Header.Caps2 & 0x200)) return false; // DDSCAPS2_CUBEMAP
+	if (Header.PixelFormat.FourCC == KDDSFourCCDX10)
+	{
+		if (HeaderDXT10.ResourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D || HeaderDXT10.ArraySize > 1 || 
+			(HeaderDXT10.MiscFlag & 0x4)) return false; // D3D11_RESOURCE_MISC_TEXTURECUBE
+	}
+	else if (!(Header.PixelFormat.Flags & 0x4)) // DDPF_FOURCC
+	{
+		const SDDSPixelFormat& KPixelFormat{ Header.PixelFormat };
+		if (KPixelFormat.RGBBitCount != 32 || KPixelFormat.RBitMask != 0xFF || KPixelFormat.GBitMask != 0xFF00 || 
+			KPixelFormat.BBitMask != 0xFF0000) return false;
+	}
+
+	Desc.Width = Header.Width;
+	Desc.Height = Header.Height;
+	Desc.MipLevels = max(Header.MipMapCount, 1u);
+	Desc.ArraySize = 1;
+	if (MipCount == 0 || FirstMip + MipCount > Desc.MipLevels) return false;
+
+	UINT RowPitch{};
+	UINT RowCount{};
+	size_t Offset{};
+	for (UINT iMip = 0; iMip < FirstMip; ++iMip)
+	{
+		Offset += CRenderDevice::GetSubresourceByteSize(Desc, iMip, RowPitch, RowCount);
+	}
+	ifs.seekg(static_cast<std::streamoff>(Offset), std::ios::cur);
+
+	vOutMips.resize(MipCount);
+	for (uint32_t iMip = 0; iMip < MipCount; ++iMip)
+	{
+		vOutMips[iMip].resize(CRenderDevice::GetSubresourceByteSize(Desc, FirstMip + iMip, RowPitch, RowCount));
+		ifs.read((char*)vOutMips[iMip].data(), vOutMips[iMip].size());
+	}
+	return ifs.good();
+}
+
+bool CTextureCooker::ReadDDSHeaders(std::ifstream& ifs, SDDSHeader& OutHeader, SDDSHeaderDXT10& OutHeaderDXT10, DXGI_FORMAT& OutFormat)
+{
+	uint32_t Magic{};
+	ifs.read((char*)&Magic, sizeof(Magic));
+	ifs.read((char*)&OutHeader, sizeof(OutHeader));
+	if (!ifs.good() || Magic != KDDSMagic || OutHeader.Size != sizeof(SDDSHeader)) return false;
+
+	OutFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+	if (!(OutHeader.PixelFormat.Flags & 0x4)) return true; // DDPF_FOURCC
+
+	switch (OutHeader.PixelFormat.FourCC)
+	{
+	case KDDSFourCCDX10:
+		ifs.read((char*)&OutHeaderDXT10, sizeof(OutHeaderDXT10));
+		if (!ifs.good()) return false;
+		OutFormat = OutHeaderDXT10.DXGIFormat;
+		break;
+	case 0x31545844: // "DXT1"
+		OutFormat = DXGI_FORMAT_BC1_UNORM;
+		break;
+	case 0x33545844: // "DXT3"
+		OutFormat = DXGI_FORMAT_BC2_UNORM;
+		break;
+	case 0x35545844: // "DXT5"
+		OutFormat = DXGI_FORMAT_BC3_UNORM;
+		break;
+	case 0x32495441: // "ATI2"
+		OutFormat = DXGI_FORMAT_BC5_UNORM;
+		break;
+	default:
+		OutFormat = DXGI_FORMAT_UNKNOWN;
+		break;
+	}
+	return true;
+}
+
+bool CTextureCooker::WriteDDSFile(const string& FileName, EFormat eFormat, uint32_t Width, uint32_t Height,
+	const vector<vector<uint8_t>>& vMipBlocks)
+{
+	std::ofstream ofs{};
+	ofs.open(FileName, std::ofstream::binary);
+	if (!ofs.is_open()) return false;
+
+	SDDSHeader Header{};
+	Header.Flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+	Header.Height = Height;
+	Header.Width = Width;
+	Header.PitchOrLinearSize = static_cast<uint32_t>(vMipBlocks[0].size());
+	Header.MipMapCount = static_cast<uint32_t>(vMipBlocks.size());
+	Header.PixelFormat.Flags = 0x4; // DDPF_FOURCC
+	Header.PixelFormat.FourCC = KDDSFourCCDX10;
+	Header.Caps = 0x1000; // DDSCAPS_TEXTURE
+	if (vMipBlocks.size() > 1) Header.Caps |= 0x8 | 0x400000; // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+
+	SDDSHeaderDXT10 HeaderDXT10{};
+	HeaderDXT10.DXGIFormat = GetDXGIFormat(eFormat);
+	HeaderDXT10.ResourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+	HeaderDXT10.ArraySize = 1;
+
+	ofs.write((const char*)&KDDSMagic, sizeof(KDDSMagic));
+	ofs.write((const char*)&Header, sizeof(Header));
+	ofs.write((const char*)&HeaderDXT10, sizeof(HeaderDXT10));
+	for (const auto& vBlocks : vMipBlocks)
+	{
+		ofs.write((const char*)vBlocks.data(), vBlocks.size());
+	}
+
+	bool bSucceeded{ ofs.good() };
+	ofs.close();
+	return bSucceeded;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include "MipGenerator.h"
+#include <fstream>
+
+// ###########################
+// << COOKED TEXTURE (DDS) >>
+// 4B "DDS " magic
+// 124B DDS_HEADER (DDPF_FOURCC "DX10")
+// 20B DDS_HEADER_DXT10 (DXGI_FORMAT_BCn_UNORM)
+// # Mip 0 blocks ... Mip N blocks (4x4 texels each)
+// ###########################
+
+class CTextureCooker
+{
+public:
+	enum class EFormat
+	{
+		BC1, // RGB (8B / block)
+		BC3, // RGBA (16B / block)
+		BC5, // RG, for normal maps (16B / block)
+		BC7 // RGBA, mode 6 only (16B / block)
+	};
+
+	using SImage = CMipGenerator::SMipLevel<SPixel32UInt>;
+
+	struct SCookStats
+	{
+		uint32_t	Width{};
+		uint32_t	Height{};
+		uint32_t	MipLevels{};
+		size_t		SourceByteSize{};
+		size_t		CookedByteSize{};
+		float		PSNR{}; // Mip 0 only (dB)
+		float		MegaPixelsPerSecond{}; // Encoder only, all mips
+		float		MipMegaPixelsPerSecond{};
+		ULONGLONG	ElapsedMilliseconds{};
+	};
+
+private:
+	struct SDDSPixelFormat
+	{
+		uint32_t	Size{ sizeof(SDDSPixelFormat) };
+		uint32_t	Flags{};
+		uint32_t	FourCC{};
+		uint32_t	RGBBitCount{};
+		uint32_t	RBitMask{};
+		uint32_t	GBitMask{};
+		uint32_t	BBitMask{};
+		uint32_t	ABitMask{};
+	};
+
+	struct SDDSHeader
+	{
+		uint32_t		Size{ sizeof(SDDSHeader) };
+		uint32_t		Flags{};
+		uint32_t		Height{};
+		uint32_t		Width{};
+		uint32_t		PitchOrLinearSize{};
+		uint32_t		Depth{};
+		uint32_t		MipMapCount{};
+		uint32_t		Reserved1[11]{};
+		SDDSPixelFormat	PixelFormat{};
+		uint32_t		Caps{};
+		uint32_t		Caps2{};
+		uint32_t		Caps3{};
+		uint32_t		Caps4{};
+		uint32_t		Reserved2{};
+	};
+
+	struct SDDSHeaderDXT10
+	{
+		DXGI_FORMAT	DXGIFormat{};
+		uint32_t	ResourceDimension{};
+		uint32_t	MiscFlag{};
+		uint32_t	ArraySize{};
+		uint32_t	MiscFlags2{};
+	};
+
+public:
+	CTextureCooker() {}
+	~CTextureCooker() {}
+
+public:
+	bool Cook(const string& SourceFileName, const string& CookedFileName, EFormat eFormat, bool bShouldGenerateMipMap = true,
+		const CMipGenerator::SDesc& MipDesc = CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser));
+	bool Cook(const string& SourceFileName, EFormat eFormat, bool bShouldGenerateMipMap = true,
+		const CMipGenerator::SDesc& MipDesc = CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser));
+
+public:
+	const SCookStats& GetLastStats() const { return m_LastStats; }
+
+public:
+	static string GetCookedFileName(const string& SourceFileName);
+	// False if the cooked file is missing or not newer than its source (the source was edited after cooking); a missing source doesn't make
+	// an existing cooked file stale, since only the cooked file may ship
+	static bool IsCookedFileUpToDate(const string& SourceFileName, const string& CookedFileName);
+	static DXGI_FORMAT GetDXGIFormat(EFormat eFormat);
+	static size_t GetBlockByteSize(EFormat eFormat);
+
+	// TGA (uncompressed or RLE, 24 or 32 bits) and BMP (uncompressed, 24 or 32 bits) are read on every platform, other formats through WIC
+	static bool LoadImageFromFile(const string& FileName, SImage& OutImage);
+	static void GenerateMipChain(const SImage& Source, const CMipGenerator::SDesc& MipDesc, vector<SImage>& vOutMipChain,
+		CMipGenerator::SStats* const PtrOutStats = nullptr);
+	static void EncodeImage(const SImage& Image, EFormat eFormat, vector<uint8_t>& vOutBlocks);
+	static void DecodeImage(const vector<uint8_t>& vBlocks, EFormat eFormat, uint32_t Width, uint32_t Height, SImage& OutImage);
+	static float CalculatePSNR(const SImage& Reference, const SImage& Decoded, EFormat eFormat);
+
+	// Reads only the header of any DDS file (not just cooked ones); the format is R8G8B8A8_UNORM if it's neither DX10 nor DXTn/ATI2
+	static bool ReadDDSFileSize(const string& FileName, uint32_t& OutWidth, uint32_t& OutHeight, uint32_t& OutMipLevels,
+		DXGI_FORMAT* const PtrOutFormat = nullptr);
+	// Reads mips [FirstMip, FirstMip + MipCount) of a DDS file's single 2D texture, tightly packed (rows of texels or of 4x4 blocks)
+	// Fails for the uncompressed formats other than R8G8B8A8, which ReadDDSFileSize() can't tell apart
+	static bool ReadDDSFileMips(const string& FileName, uint32_t FirstMip, uint32_t MipCount, vector<vector<uint8_t>>& vOutMips);
+
+private:
+	static bool LoadTGA(const vector<uint8_t>& vFileData, SImage& OutImage);
+	static bool LoadBMP(const vector<uint8_t>& vFileData, SImage& OutImage);
+	// OutFormat is DXGI_FORMAT_UNKNOWN for unknown FourCCs and R8G8B8A8_UNORM for uncompressed files
+	static bool ReadDDSHeaders(std::ifstream& ifs, SDDSHeader& OutHeader, SDDSHeaderDXT10& OutHeaderDXT10, DXGI_FORMAT& OutFormat);
+	static bool WriteDDSFile(const string& FileName, EFormat eFormat, uint32_t Width, uint32_t Height,
+		const vector<vector<uint8_t>>& vMipBlocks);
+
+public:
+	static constexpr uint32_t KBlockSize{ 4 };
+
+private:
+	SCookStats	m_LastStats{};
+};
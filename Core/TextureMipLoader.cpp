@@ -0,0 +1,103 @@
+#include "TextureMipLoader.h"
+#include "TextureCooker.h"
+
+CTextureMipLoader::CTextureMipLoader(uint32_t ThreadCount)
+{
+	for (uint32_t iThread = 0; iThread < max(ThreadCount, 1u); ++iThread)
+	{
+		m_vThreads.emplace_back(&CTextureMipLoader::RunBackgroundThread, this);
+	}
+}
+
+CTextureMipLoader::~CTextureMipLoader()
+{
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_dqLoadQueue.clear();
+		m_bShouldStop = true;
+	}
+	m_JobCondition.notify_all();
+
+	for (auto& Thread : m_vThreads)
+	{
+		Thread.join();
+	}
+}
+
+uint64_t CTextureMipLoader::Load(size_t TextureID, const string& FileName, uint32_t FirstMip, uint32_t MipCount)
+{
+	uint64_t LoadID{};
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		LoadID = ++m_LastLoadID;
+
+		SLoad Load{};
+		Load.LoadID = LoadID;
+		Load.TextureID = TextureID;
+		Load.FileName = FileName;
+		Load.FirstMip = FirstMip;
+		Load.MipCount = MipCount;
+		m_dqLoadQueue.emplace_back(std::move(Load));
+	}
+	m_JobCondition.notify_one();
+	return LoadID;
+}
+
+void CTextureMipLoader::TakeResults(vector<SResult>& vOutResults)
+{
+	vOutResults.clear();
+
+	std::lock_guard<std::mutex> Lock{ m_Mutex };
+	vOutResults.swap(m_vResults);
+}
+
+void CTextureMipLoader::Flush()
+{
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	m_IdleCondition.wait(Lock, [&]() { return m_dqLoadQueue.empty() && m_BusyThreadCount == 0; });
+}
+
+size_t CTextureMipLoader::GetPendingLoadCount()
+{
+	std::lock_guard<std::mutex> Lock{ m_Mutex };
+	return m_dqLoadQueue.size() + m_BusyThreadCount;
+}
+
+CTextureMipLoader::SStats CTextureMipLoader::GetStats()
+{
+	std::lock_guard<std::mutex> Lock{ m_Mutex };
+	return m_Stats;
+}
+
+void CTextureMipLoader::RunBackgroundThread()
+{
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	while (true)
+	{
+		m_JobCondition.wait(Lock, [&]() { return m_bShouldStop || m_dqLoadQueue.size(); });
+		if (m_bShouldStop) return;
+
+		const SLoad KLoad{ std::move(m_dqLoadQueue.front()) };
+		m_dqLoadQueue.pop_front();
+		++m_BusyThreadCount;
+		Lock.unlock();
+
+		SResult Result{};
+		Result.LoadID = KLoad.LoadID;
+		Result.TextureID = KLoad.TextureID;
+		Result.FirstMip = KLoad.FirstMip;
+		if (!CTextureCooker::ReadDDSFileMips(KLoad.FileName, KLoad.FirstMip, KLoad.MipCount, Result.vMips)) Result.vMips.clear();
+
+		size_t ByteCount{};
+		for (const auto& vMip : Result.vMips) ByteCount += vMip.size();
+
+		Lock.lock();
+		++m_Stats.FinishedLoadCount;
+		if (Result.vMips.empty()) ++m_Stats.FailedLoadCount;
+		m_Stats.LoadedByteCount += ByteCount;
+		m_vResults.emplace_back(std::move(Result));
+		--m_BusyThreadCount;
+
+		if (m_dqLoadQueue.empty() && m_BusyThreadCount == 0) m_IdleCondition.notify_all();
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+// Reads mips of DDS files on background threads (CTextureCooker::ReadDDSFileMips()), so that streaming textures in doesn't stall the
+// render thread; the finished loads are taken on the render thread, which copies them into the textures
+class CTextureMipLoader final
+{
+public:
+	struct SResult
+	{
+		uint64_t				LoadID{};
+		size_t					TextureID{}; // As given to Load()
+		uint32_t				FirstMip{};
+		vector<vector<uint8_t>>	vMips{}; // Empty if the file couldn't be read
+	};
+
+	struct SStats
+	{
+		size_t	FinishedLoadCount{};
+		size_t	FailedLoadCount{};
+		size_t	LoadedByteCount{};
+	};
+
+private:
+	struct SLoad
+	{
+		uint64_t	LoadID{};
+		size_t		TextureID{};
+		string		FileName{};
+		uint32_t	FirstMip{};
+		uint32_t	MipCount{};
+	};
+
+public:
+	// ThreadCount background threads (at least 1)
+	CTextureMipLoader(uint32_t ThreadCount = 1);
+	~CTextureMipLoader();
+
+	CTextureMipLoader(const CTextureMipLoader&) = delete;
+	CTextureMipLoader& operator=(const CTextureMipLoader&) = delete;
+
+public:
+	// Queues a read of mips [FirstMip, FirstMip + MipCount) and returns the load's ID (never 0), which its result carries
+	uint64_t Load(size_t TextureID, const string& FileName, uint32_t FirstMip, uint32_t MipCount);
+	// Moves the finished loads to vOutResults (in the order they finished)
+	void TakeResults(vector<SResult>& vOutResults);
+	// Waits until every queued load is finished
+	void Flush();
+
+	// Queued or being read
+	size_t GetPendingLoadCount();
+	SStats GetStats();
+
+private:
+	void RunBackgroundThread();
+
+private:
+	vector<std::thread>			m_vThreads{};
+	std::mutex					m_Mutex{};
+	std::condition_variable		m_JobCondition{};
+	std::condition_variable		m_IdleCondition{};
+	std::deque<SLoad>			m_dqLoadQueue{};
+	vector<SResult>				m_vResults{};
+	uint64_t					m_LastLoadID{};
+	uint32_t					m_BusyThreadCount{};
+	SStats						m_Stats{};
+	bool						m_bShouldStop{};
+};
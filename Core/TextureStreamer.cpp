@@ -0,0 +1,353 @@
+#include "TextureStreamer.h"
+
+size_t CTextureStreamer::RegisterTexture(const STextureDesc& Desc)
+{
+	assert(Desc.Width && Desc.Height && Desc.MipCount);
+
+	size_t ID{};
+	if (m_vFreeIDs.size())
+	{
+		ID = m_vFreeIDs.back();
+		m_vFreeIDs.pop_back();
+	}
+	else
+	{
+		ID = m_vTextureStates.size();
+		m_vTextureStates.emplace_back();
+	}
+
+	STextureState& State{ m_vTextureStates[ID] };
+	State = STextureState();
+	State.Desc = Desc;
+	State.TailMip = GetTailMip(Desc.Width, Desc.Height, Desc.MipCount);
+	State.ResidentMip = State.TailMip;
+	State.RequiredMip = Desc.MipCount - 1;
+	State.FrameStartResidentMip = State.ResidentMip;
+	State.LastUsedFrame = m_FrameIndex;
+	State.bIsRegistered = true;
+
+	m_Stats.ResidentBytes += GetResidentByteSize(Desc, State.ResidentMip);
+	++m_Stats.TextureCount;
+
+	return ID;
+}
+
+void CTextureStreamer::UnregisterTexture(size_t TextureID)
+{
+	if (TextureID >= m_vTextureStates.size()) return;
+
+	STextureState& State{ m_vTextureStates[TextureID] };
+	if (!State.bIsRegistered) return;
+
+	m_Stats.ResidentBytes -= GetResidentByteSize(State.Desc, State.ResidentMip);
+	--m_Stats.TextureCount;
+
+	State.bIsRegistered = false;
+	m_vFreeIDs.emplace_back(TextureID);
+}
+
+void CTextureStreamer::Clear()
+{
+	m_vTextureStates.clear();
+	m_vFreeIDs.clear();
+	m_Stats = SStats();
+}
+
+void CTextureStreamer::BeginFrame()
+{
+	++m_FrameIndex;
+
+	for (auto& State : m_vTextureStates)
+	{
+		State.RequiredMip = State.Desc.MipCount - 1;
+		State.ScreenPixelArea = 0;
+	}
+}
+
+void CTextureStreamer::ReportUsage(size_t TextureID, float ScreenPixelArea, float UVArea)
+{
+	assert(TextureID < m_vTextureStates.size());
+	STextureState& State{ m_vTextureStates[TextureID] };
+	if (!State.bIsRegistered) return;
+
+	State.RequiredMip = min(State.RequiredMip, CalculateRequiredMip(State.Desc, ScreenPixelArea, UVArea));
+	State.ScreenPixelArea = max(State.ScreenPixelArea, ScreenPixelArea);
+	State.LastUsedFrame = m_FrameIndex;
+}
+
+void CTextureStreamer::Update(vector<SRequest>& vOutRequests)
+{
+	vOutRequests.clear();
+
+	m_Stats.UploadedBytes = 0;
+	m_Stats.EvictedBytes = 0;
+	m_Stats.StreamedMipCount = 0;
+	m_Stats.EvictedMipCount = 0;
+
+	m_vCandidateIDs.clear();
+	for (size_t iTexture = 0; iTexture < m_vTextureStates.size(); ++iTexture)
+	{
+		STextureState& State{ m_vTextureStates[iTexture] };
+		if (!State.bIsRegistered) continue;
+
+		State.FrameStartResidentMip = State.ResidentMip;
+		if (State.ResidentMip > State.RequiredMip) m_vCandidateIDs.emplace_back(iTexture);
+	}
+	m_bAreVictimsSorted = false;
+
+	// The budget might have been lowered
+	if (m_Stats.ResidentBytes > m_Budget.ResidentByteBudget)
+	{
+		Evict(m_Stats.ResidentBytes - m_Budget.ResidentByteBudget, true);
+	}
+
+	// Larger mip deficit first, then larger screen coverage
+	std::sort(m_vCandidateIDs.begin(), m_vCandidateIDs.end(), [&](size_t A, size_t B)
+		{
+			const STextureState& StateA{ m_vTextureStates[A] };
+			const STextureState& StateB{ m_vTextureStates[B] };
+			uint32_t DeficitA{ StateA.ResidentMip - StateA.RequiredMip };
+			uint32_t DeficitB{ StateB.ResidentMip - StateB.RequiredMip };
+			if (DeficitA != DeficitB) return DeficitA > DeficitB;
+			if (StateA.ScreenPixelArea != StateB.ScreenPixelArea) return StateA.ScreenPixelArea > StateB.ScreenPixelArea;
+			return A < B;
+		});
+
+	// @important: one mip per texture per pass, so that every visible texture gets sharper before any of them reaches its finest mip
+	bool bHasProgressed{ true };
+	bool bIsUploadBudgetExhausted{ false };
+	while (bHasProgressed && !bIsUploadBudgetExhausted)
+	{
+		bHasProgressed = false;
+		for (size_t ID : m_vCandidateIDs)
+		{
+			STextureState& State{ m_vTextureStates[ID] };
+			if (State.ResidentMip <= State.RequiredMip) continue;
+
+			size_t ByteSize{ GetMipByteSize(State.Desc, State.ResidentMip - 1) };
+			if (m_Stats.UploadedBytes > 0 && m_Stats.UploadedBytes + ByteSize > m_Budget.UploadByteBudgetPerFrame)
+			{
+				bIsUploadBudgetExhausted = true;
+				break;
+			}
+
+			if (m_Stats.ResidentBytes + ByteSize > m_Budget.ResidentByteBudget)
+			{
+				if (!Evict(m_Stats.ResidentBytes + ByteSize - m_Budget.ResidentByteBudget, false)) continue;
+			}
+
+			--State.ResidentMip;
+			m_Stats.ResidentBytes += ByteSize;
+			m_Stats.UploadedBytes += ByteSize;
+			++m_Stats.StreamedMipCount;
+			bHasProgressed = true;
+		}
+	}
+
+	m_Stats.RequiredBytes = 0;
+	m_Stats.PendingRequestCount = 0;
+	for (size_t iTexture = 0; iTexture < m_vTextureStates.size(); ++iTexture)
+	{
+		const STextureState& State{ m_vTextureStates[iTexture] };
+		if (!State.bIsRegistered) continue;
+
+		m_Stats.RequiredBytes += GetResidentByteSize(State.Desc, min(State.RequiredMip, State.TailMip));
+		if (State.ResidentMip > State.RequiredMip) ++m_Stats.PendingRequestCount;
+		if (State.ResidentMip != State.FrameStartResidentMip)
+		{
+			vOutRequests.emplace_back(SRequest{ iTexture, State.FrameStartResidentMip, State.ResidentMip });
+		}
+	}
+}
+
+bool CTextureStreamer::Evict(size_t ByteSize, bool bShouldEvictPartially)
+{
+	// Mips that are not required this frame can be evicted: textures unused this frame down to their tails,
+	// and used textures down to their required mips
+	auto GetEvictionLimit{ [&](const STextureState& State)
+		{
+			return (State.LastUsedFrame == m_FrameIndex) ? min(State.RequiredMip, State.TailMip) : State.TailMip;
+		} };
+
+	if (!m_bAreVictimsSorted)
+	{
+		m_vVictimIDs.clear();
+		for (size_t iTexture = 0; iTexture < m_vTextureStates.size(); ++iTexture)
+		{
+			const STextureState& State{ m_vTextureStates[iTexture] };
+			if (!State.bIsRegistered) continue;
+			if (State.ResidentMip < GetEvictionLimit(State)) m_vVictimIDs.emplace_back(iTexture);
+		}
+
+		// Least recently used first, then less screen coverage
+		std::sort(m_vVictimIDs.begin(), m_vVictimIDs.end(), [&](size_t A, size_t B)
+			{
+				const STextureState& StateA{ m_vTextureStates[A] };
+				const STextureState& StateB{ m_vTextureStates[B] };
+				if (StateA.LastUsedFrame != StateB.LastUsedFrame) return StateA.LastUsedFrame < StateB.LastUsedFrame;
+				if (StateA.ScreenPixelArea != StateB.ScreenPixelArea) return StateA.ScreenPixelArea < StateB.ScreenPixelArea;
+				return A < B;
+			});
+
+		m_VictimCursor = 0;
+		m_bAreVictimsSorted = true;
+	}
+
+	if (!bShouldEvictPartially)
+	{
+		// Don't evict anything unless the whole request can be satisfied
+		size_t EvictableByteSize{};
+		for (size_t iVictim = m_VictimCursor; iVictim < m_vVictimIDs.size() && EvictableByteSize < ByteSize; ++iVictim)
+		{
+			const STextureState& State{ m_vTextureStates[m_vVictimIDs[iVictim]] };
+			EvictableByteSize += GetResidentByteSize(State.Desc, State.ResidentMip) - GetResidentByteSize(State.Desc, GetEvictionLimit(State));
+		}
+		if (EvictableByteSize < ByteSize) return false;
+	}
+
+	size_t EvictedByteSize{};
+	while (EvictedByteSize < ByteSize && m_VictimCursor < m_vVictimIDs.size())
+	{
+		STextureState& State{ m_vTextureStates[m_vVictimIDs[m_VictimCursor]] };
+		if (State.ResidentMip >= GetEvictionLimit(State))
+		{
+			++m_VictimCursor;
+			continue;
+		}
+
+		size_t MipByteSize{ GetMipByteSize(State.Desc, State.ResidentMip) };
+		++State.ResidentMip;
+		EvictedByteSize += MipByteSize;
+		m_Stats.ResidentBytes -= MipByteSize;
+		m_Stats.EvictedBytes += MipByteSize;
+		++m_Stats.EvictedMipCount;
+	}
+
+	return (EvictedByteSize >= ByteSize);
+}
+
+uint32_t CTextureStreamer::GetResidentMip(size_t TextureID) const
+{
+	assert(TextureID < m_vTextureStates.size());
+	return m_vTextureStates[TextureID].ResidentMip;
+}
+
+uint32_t CTextureStreamer::GetRequiredMip(size_t TextureID) const
+{
+	assert(TextureID < m_vTextureStates.size());
+	return m_vTextureStates[TextureID].RequiredMip;
+}
+
+CTextureStreamer::STextureDesc CTextureStreamer::MakeTextureDesc(DXGI_FORMAT Format, uint32_t Width, uint32_t Height, uint32_t MipCount)
+{
+	STextureDesc Desc{};
+	Desc.Width = Width;
+	Desc.Height = Height;
+	Desc.MipCount = max(MipCount, 1u);
+
+	switch (Format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		Desc.BlockSize = 4;
+		Desc.BlockByteSize = 8;
+		break;
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		Desc.BlockSize = 4;
+		Desc.BlockByteSize = 16;
+		break;
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_A8_UNORM:
+		Desc.BlockByteSize = 1;
+		break;
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R16_UNORM:
+		Desc.BlockByteSize = 2;
+		break;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		Desc.BlockByteSize = 8;
+		break;
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		Desc.BlockByteSize = 16;
+		break;
+	default:
+		Desc.BlockByteSize = 4;
+		break;
+	}
+
+	return Desc;
+}
+
+uint32_t CTextureStreamer::GetTailMip(uint32_t Width, uint32_t Height, uint32_t MipCount)
+{
+	uint32_t TailMip{};
+	while (TailMip + 1 < MipCount && max(Width >> TailMip, Height >> TailMip) > KTailMaxSize) ++TailMip;
+	return TailMip;
+}
+
+uint32_t CTextureStreamer::GetAllocatableMip(const STextureDesc& Desc, uint32_t Mip)
+{
+	auto IsMadeOfWholeBlocks{ [&](uint32_t Size) { return Desc.BlockSize == 1 || (Size > 0 && Size % Desc.BlockSize == 0); } };
+	while (Mip > 0 && !(IsMadeOfWholeBlocks(Desc.Width >> Mip) && IsMadeOfWholeBlocks(Desc.Height >> Mip))) --Mip;
+	return Mip;
+}
+
+size_t CTextureStreamer::GetMipByteSize(const STextureDesc& Desc, uint32_t Mip)
+{
+	size_t MipWidth{ max(Desc.Width >> Mip, 1u) };
+	size_t MipHeight{ max(Desc.Height >> Mip, 1u) };
+	size_t BlockCountX{ (MipWidth + Desc.BlockSize - 1) / Desc.BlockSize };
+	size_t BlockCountY{ (MipHeight + Desc.BlockSize - 1) / Desc.BlockSize };
+	return BlockCountX * BlockCountY * Desc.BlockByteSize;
+}
+
+size_t CTextureStreamer::GetResidentByteSize(const STextureDesc& Desc, uint32_t ResidentMip)
+{
+	size_t ByteSize{};
+	for (uint32_t iMip = ResidentMip; iMip < Desc.MipCount; ++iMip)
+	{
+		ByteSize += GetMipByteSize(Desc, iMip);
+	}
+	return ByteSize;
+}
+
+uint32_t CTextureStreamer::CalculateRequiredMip(const STextureDesc& Desc, float ScreenPixelArea, float UVArea)
+{
+	if (ScreenPixelArea <= 0.0f || UVArea <= 0.0f) return Desc.MipCount - 1;
+
+	// Each mip halves the texel count per axis, so log2 of the texel-to-pixel area ratio is halved
+	float TexelCount{ UVArea * static_cast<float>(Desc.Width) * static_cast<float>(Desc.Height) };
+	float Mip{ 0.5f * log2f(TexelCount / ScreenPixelArea) + KMipBias };
+	if (Mip <= 0.0f) return 0;
+	return min(static_cast<uint32_t>(Mip), Desc.MipCount - 1);
+}
+
+float CTextureStreamer::CalculateScreenPixelArea(float Radius, float Distance, float FovY, const XMFLOAT2& ScreenSize)
+{
+	float FullScreenPixelArea{ ScreenSize.x * ScreenSize.y };
+	if (Distance <= Radius) return FullScreenPixelArea;
+
+	// Projected radius of the sphere's silhouette
+	float ProjectedRadius{ Radius / (sqrtf(Distance * Distance - Radius * Radius) * tanf(FovY * 0.5f)) * ScreenSize.y * 0.5f };
+	return min(XM_PI * ProjectedRadius * ProjectedRadius, FullScreenPixelArea);
+}
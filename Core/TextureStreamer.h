@@ -0,0 +1,115 @@
+#pragma once
+
+#include "SharedHeader.h"
+
+// Decides which mips of each texture should be resident (CPU only, no device access)
+// A texture whose resident mip is N has mips [N, MipCount) resident, so mip 0 is the most detailed level
+class CTextureStreamer
+{
+public:
+	struct STextureDesc
+	{
+		uint32_t	Width{};
+		uint32_t	Height{};
+		uint32_t	MipCount{ 1 };
+		uint32_t	BlockSize{ 1 }; // 4 for BCn
+		uint32_t	BlockByteSize{ 4 };
+	};
+
+	struct SBudget
+	{
+		size_t	ResidentByteBudget{ 256 * 1024 * 1024 };
+		size_t	UploadByteBudgetPerFrame{ 4 * 1024 * 1024 }; // At least one mip is streamed per frame
+	};
+
+	// Residency change to be applied to the GPU resource
+	struct SRequest
+	{
+		size_t		TextureID{};
+		uint32_t	PrevResidentMip{};
+		uint32_t	ResidentMip{};
+	};
+
+	struct SStats
+	{
+		size_t		TextureCount{};
+		size_t		ResidentBytes{};
+		size_t		RequiredBytes{}; // If every texture were resident exactly at its required mip
+		size_t		PendingRequestCount{}; // Textures that are still coarser than required after Update()
+		size_t		UploadedBytes{}; // This frame
+		size_t		EvictedBytes{}; // This frame
+		uint32_t	StreamedMipCount{}; // This frame
+		uint32_t	EvictedMipCount{}; // This frame
+	};
+
+private:
+	struct STextureState
+	{
+		STextureDesc	Desc{};
+		uint32_t		TailMip{}; // Never evicted
+		uint32_t		ResidentMip{};
+		uint32_t		RequiredMip{};
+		uint32_t		FrameStartResidentMip{};
+		uint64_t		LastUsedFrame{};
+		float			ScreenPixelArea{}; // Largest coverage reported this frame
+		bool			bIsRegistered{ false };
+	};
+
+public:
+	CTextureStreamer() {}
+	~CTextureStreamer() {}
+
+public:
+	// The texture is expected to be created with GetResidentMip() (its tail mips) resident
+	size_t RegisterTexture(const STextureDesc& Desc);
+	void UnregisterTexture(size_t TextureID);
+	void Clear();
+
+	void BeginFrame();
+
+	// ScreenPixelArea: pixels covered by the surface that uses the texture
+	// UVArea: texture coordinate area mapped onto that surface (1.0 == the whole texture once)
+	void ReportUsage(size_t TextureID, float ScreenPixelArea, float UVArea);
+
+	// Streams in and evicts one mip at a time, returns at most one request per texture
+	void Update(vector<SRequest>& vOutRequests);
+
+public:
+	void SetBudget(const SBudget& Budget) { m_Budget = Budget; }
+	const SBudget& GetBudget() const { return m_Budget; }
+	const SStats& GetStats() const { return m_Stats; }
+	uint32_t GetResidentMip(size_t TextureID) const;
+	uint32_t GetRequiredMip(size_t TextureID) const;
+	uint64_t GetFrameIndex() const { return m_FrameIndex; }
+
+public:
+	static STextureDesc MakeTextureDesc(DXGI_FORMAT Format, uint32_t Width, uint32_t Height, uint32_t MipCount);
+	static uint32_t GetTailMip(uint32_t Width, uint32_t Height, uint32_t MipCount);
+	// The finest mip not finer than Mip that a texture can start at: block-compressed textures can't start at a mip that isn't made of
+	// whole blocks (e.g. mip 1 of a 100 x 100 BC texture)
+	static uint32_t GetAllocatableMip(const STextureDesc& Desc, uint32_t Mip);
+	static size_t GetMipByteSize(const STextureDesc& Desc, uint32_t Mip);
+	static size_t GetResidentByteSize(const STextureDesc& Desc, uint32_t ResidentMip);
+	static uint32_t CalculateRequiredMip(const STextureDesc& Desc, float ScreenPixelArea, float UVArea);
+	static float CalculateScreenPixelArea(float Radius, float Distance, float FovY, const XMFLOAT2& ScreenSize);
+
+private:
+	bool Evict(size_t ByteSize, bool bShouldEvictPartially);
+
+public:
+	static constexpr size_t KInvalidID{ SIZE_MAX };
+	static constexpr uint32_t KTailMaxSize{ 64 }; // Mips whose larger side is not bigger than this are always resident
+	static constexpr float KMipBias{ 0.0f };
+
+private:
+	vector<STextureState>	m_vTextureStates{};
+	vector<size_t>			m_vFreeIDs{};
+	vector<size_t>			m_vCandidateIDs{};
+	vector<size_t>			m_vVictimIDs{};
+	size_t					m_VictimCursor{};
+	bool					m_bAreVictimsSorted{ false };
+
+	uint64_t				m_FrameIndex{};
+	SBudget					m_Budget{};
+	SStats					m_Stats{};
+};
@@ -0,0 +1,85 @@
+#include "TransientUploadRing.h"
+
+void CTransientUploadRing::SetBuffer(ID3D11Buffer* const PtrBuffer, size_t ByteSize)
+{
+	m_PtrBuffer = PtrBuffer;
+	m_Allocator.Reset(ByteSize);
+	m_bShouldDiscard = true;
+}
+
+bool CTransientUploadRing::Upload(const void* const PtrData, size_t ByteSize, STransientAllocation& OutAllocation, size_t Alignment)
+{
+	assert(m_PtrBuffer);
+
+	size_t Offset{};
+	if (!Allocate(ByteSize, Alignment, Offset)) return false;
+
+	// @important: the first map after a rename must discard, and every later map only writes ranges the GPU isn't reading
+	const D3D11_MAP KMapType{ (m_bShouldDiscard) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE };
+	uint8_t* const PtrMappedData{ static_cast<uint8_t*>(m_PtrRenderDevice->Map(m_PtrBuffer, KMapType, Offset + ByteSize)) };
+	if (!PtrMappedData) return false;
+
+	memcpy(PtrMappedData + Offset, PtrData, ByteSize);
+	m_PtrRenderDevice->Unmap(m_PtrBuffer);
+	m_bShouldDiscard = false;
+
+	OutAllocation.PtrBuffer = m_PtrBuffer;
+	OutAllocation.Offset = static_cast<UINT>(Offset);
+
+	++m_Stats.AllocationCount;
+	m_Stats.UploadedByteCount += ByteSize;
+	m_Stats.PeakUsedByteSize = max(m_Stats.PeakUsedByteSize, m_Allocator.GetUsedByteSize());
+	return true;
+}
+
+bool CTransientUploadRing::UploadToBuffer(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, const void* const PtrData, size_t ByteSize)
+{
+	STransientAllocation Allocation{};
+	if (!Upload(PtrData, ByteSize, Allocation)) return false;
+
+	m_PtrRenderDevice->CopyBufferRegion(PtrDstBuffer, DstOffset, Allocation.PtrBuffer, Allocation.Offset, static_cast<UINT>(ByteSize));
+	++m_Stats.CopyCount;
+	return true;
+}
+
+void CTransientUploadRing::BeginFrame()
+{
+	m_Stats = SStats();
+
+	m_Allocator.Retire(m_PtrRenderDevice->GetCompletedFence());
+}
+
+void CTransientUploadRing::EndFrame()
+{
+	if (!m_PtrBuffer) return;
+
+	++m_FenceValue;
+	m_Allocator.EndFrame(m_FenceValue);
+	m_PtrRenderDevice->SignalFence(m_FenceValue);
+}
+
+float CTransientUploadRing::GetOccupancy() const
+{
+	if (m_Allocator.GetByteSize() == 0) return 0.0f;
+	return static_cast<float>(m_Allocator.GetUsedByteSize()) / static_cast<float>(m_Allocator.GetByteSize());
+}
+
+bool CTransientUploadRing::Allocate(size_t ByteSize, size_t Alignment, size_t& OutOffset)
+{
+	if (ByteSize > m_Allocator.GetByteSize()) return false;
+
+	if (m_Allocator.Allocate(ByteSize, Alignment, OutOffset)) return true;
+
+	// The GPU may have caught up since BeginFrame()
+	m_Allocator.Retire(m_PtrRenderDevice->GetCompletedFence());
+	if (m_Allocator.Allocate(ByteSize, Alignment, OutOffset)) return true;
+
+	// @important: the ranges in flight keep the renamed memory, so the whole ring is free again
+	m_Allocator.Reset();
+	m_bShouldDiscard = true;
+	++m_Stats.OverflowCount;
+	OutputDebugString(("Transient upload ring overflowed. [" + to_string(ByteSize) + "] bytes requested, [" +
+		to_string(m_Allocator.GetByteSize()) + "] bytes in the ring.\n").c_str());
+
+	return m_Allocator.Allocate(ByteSize, Alignment, OutOffset);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "RingAllocator.h"
+
+// Range of the ring buffer written this frame
+struct STransientAllocation
+{
+	ID3D11Buffer*	PtrBuffer{};
+	UINT			Offset{};
+};
+
+// Shared upload ring for dynamic vertex/index data: NO_OVERWRITE suballocation of one dynamic buffer, whose ranges are reused
+// once the GPU has passed the fence of the frame they were written in.
+// @important: if the ring overflows it is renamed with WRITE_DISCARD, so an allocation must be consumed (drawn or copied)
+// before the next one is made.
+class CTransientUploadRing final
+{
+public:
+	struct SStats
+	{
+		size_t	AllocationCount{};
+		size_t	UploadedByteCount{};
+		size_t	CopyCount{}; // Uploads to persistent buffers
+		size_t	OverflowCount{}; // The ring was full of ranges in flight and has been renamed
+		size_t	PeakUsedByteSize{};
+	};
+
+public:
+	CTransientUploadRing(CRenderDevice* const PtrRenderDevice) : m_PtrRenderDevice{ PtrRenderDevice }
+	{
+		assert(m_PtrRenderDevice);
+	}
+	~CTransientUploadRing() {}
+
+public:
+	// PtrBuffer must be a dynamic buffer that is bound as vertex and index buffer
+	void SetBuffer(ID3D11Buffer* const PtrBuffer, size_t ByteSize);
+	bool IsAvailable() const { return m_PtrBuffer != nullptr; }
+
+	bool Upload(const void* const PtrData, size_t ByteSize, STransientAllocation& OutAllocation, size_t Alignment = KDefaultAlignment);
+
+	// Stages the data in the ring and copies it to [DstOffset, DstOffset + ByteSize) of a default-usage buffer
+	bool UploadToBuffer(ID3D11Buffer* const PtrDstBuffer, UINT DstOffset, const void* const PtrData, size_t ByteSize);
+
+	// Frees the ranges of the frames the GPU has finished, and resets the stats
+	void BeginFrame();
+	// Signals the fence of the ranges allocated this frame
+	void EndFrame();
+
+public:
+	const SStats& GetStats() const { return m_Stats; }
+	size_t GetByteSize() const { return m_Allocator.GetByteSize(); }
+	size_t GetUsedByteSize() const { return m_Allocator.GetUsedByteSize(); }
+	float GetOccupancy() const;
+
+private:
+	bool Allocate(size_t ByteSize, size_t Alignment, size_t& OutOffset);
+
+public:
+	static constexpr size_t KDefaultAlignment{ 16 };
+
+private:
+	CRenderDevice* const	m_PtrRenderDevice{};
+	SStats					m_Stats{};
+
+private:
+	ID3D11Buffer*			m_PtrBuffer{};
+	CRingAllocator			m_Allocator{};
+	uint64_t				m_FenceValue{};
+	bool					m_bShouldDiscard{ true };
+};
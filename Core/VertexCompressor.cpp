@@ -0,0 +1,273 @@
+#include "VertexCompressor.h"
+
+using namespace PackedVector;
+
+// Taken by address (CShader::Create()), so it needs a definition before C++17
+constexpr D3D11_INPUT_ELEMENT_DESC CVertexCompressor::KInputElementDescs[];
+
+static_assert(sizeof(SVertex3DCompressed) == 24, "SVertex3DCompressed must match CVertexCompressor::KInputElementDescs");
+static_assert(sizeof(SVertexAnimationCompressed) == 8, "SVertexAnimationCompressed must match CVertexCompressor::KInputElementDescs");
+static_assert(KMaxWeightCount == 4, "SVertexAnimationCompressed stores 4 weights");
+static_assert(KMaxBoneMatrixCount <= 256, "Bone IDs are stored in 8 bits");
+
+// atan2 keeps its precision for tiny angles, unlike acos
+static float GetAngleInDegrees(FXMVECTOR A, FXMVECTOR B)
+{
+	float Sine{ XMVectorGetX(XMVector3Length(XMVector3Cross(A, B))) };
+	float Cosine{ XMVectorGetX(XMVector3Dot(A, B)) };
+	return XMConvertToDegrees(atan2f(Sine, Cosine));
+}
+
+// Picks the best of the 4 SNORM16 neighbours instead of rounding (Cigolle et al. 2014)
+static void StoreOctahedral(XMSHORTN2* const PtrOut, FXMVECTOR Direction)
+{
+	XMVECTOR Encoded{ XMVectorScale(CVertexCompressor::EncodeOctahedral(Direction), 32767.0f) };
+	XMVECTOR Floor{ XMVectorFloor(Encoded) };
+	XMVECTOR Normalized{ XMVector3Normalize(XMVectorSetW(Direction, 0.0f)) };
+
+	float BestCosine{ -FLT_MAX };
+	for (uint32_t iCandidate = 0; iCandidate < 4; ++iCandidate)
+	{
+		XMVECTOR Candidate{ XMVectorAdd(Floor, XMVectorSet(static_cast<float>(iCandidate & 1), static_cast<float>(iCandidate >> 1), 0, 0)) };
+		Candidate = XMVectorClamp(Candidate, XMVectorReplicate(-32767.0f), XMVectorReplicate(32767.0f));
+
+		float Cosine{ XMVectorGetX(XMVector3Dot(CVertexCompressor::DecodeOctahedral(XMVectorScale(Candidate, 1.0f / 32767.0f)), Normalized)) };
+		if (Cosine > BestCosine)
+		{
+			BestCosine = Cosine;
+			PtrOut->x = static_cast<int16_t>(XMVectorGetX(Candidate));
+			PtrOut->y = static_cast<int16_t>(XMVectorGetY(Candidate));
+		}
+	}
+}
+
+CVertexCompressor::SCBVSVertexQuantizationData CVertexCompressor::CalculateQuantization(const vector<SMesh>& vMeshes)
+{
+	SCBVSVertexQuantizationData Result{};
+
+	XMVECTOR PositionMin{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR PositionMax{ XMVectorReplicate(-FLT_MAX) };
+	XMVECTOR TexCoordMin{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR TexCoordMax{ XMVectorReplicate(-FLT_MAX) };
+	size_t VertexCount{};
+	for (const SMesh& Mesh : vMeshes)
+	{
+		for (const SVertex3D& Vertex : Mesh.vVertices)
+		{
+			PositionMin = XMVectorMin(PositionMin, Vertex.Position);
+			PositionMax = XMVectorMax(PositionMax, Vertex.Position);
+			TexCoordMin = XMVectorMin(TexCoordMin, Vertex.TexCoord);
+			TexCoordMax = XMVectorMax(TexCoordMax, Vertex.TexCoord);
+		}
+		VertexCount += Mesh.vVertices.size();
+	}
+	if (VertexCount == 0) return Result;
+
+	XMVECTOR PositionCenter{ XMVectorScale(XMVectorAdd(PositionMin, PositionMax), 0.5f) };
+	XMVECTOR PositionExtent{ XMVectorMax(XMVectorScale(XMVectorSubtract(PositionMax, PositionMin), 0.5f), XMVectorReplicate(KMinExtent)) };
+	XMVECTOR TexCoordScale{ XMVectorMax(XMVectorSubtract(TexCoordMax, TexCoordMin), XMVectorReplicate(KMinExtent)) };
+
+	XMStoreFloat4(&Result.PositionCenter, XMVectorSetW(PositionCenter, 0.0f));
+	XMStoreFloat4(&Result.PositionExtent, XMVectorSetW(PositionExtent, 0.0f));
+	Result.TexCoordOffsetScale = XMFLOAT4(XMVectorGetX(TexCoordMin), XMVectorGetY(TexCoordMin),
+		XMVectorGetX(TexCoordScale), XMVectorGetY(TexCoordScale));
+	return Result;
+}
+
+void CVertexCompressor::CompressVertices(const vector<SVertex3D>& vVertices, const SCBVSVertexQuantizationData& Quantization,
+	vector<SVertex3DCompressed>& vOutVertices)
+{
+	const XMVECTOR PositionCenter{ XMLoadFloat4(&Quantization.PositionCenter) };
+	const XMVECTOR PositionInverseExtent{ XMVectorReciprocal(XMVectorSetW(XMLoadFloat4(&Quantization.PositionExtent), 1.0f)) };
+	const XMVECTOR TexCoordOffset{ XMVectorSet(Quantization.TexCoordOffsetScale.x, Quantization.TexCoordOffsetScale.y, 0, 0) };
+	const XMVECTOR TexCoordInverseScale{ XMVectorSet(1.0f / Quantization.TexCoordOffsetScale.z, 1.0f / Quantization.TexCoordOffsetScale.w, 0, 0) };
+
+	vOutVertices.resize(vVertices.size());
+	for (size_t iVertex = 0; iVertex < vVertices.size(); ++iVertex)
+	{
+		const SVertex3D& Vertex{ vVertices[iVertex] };
+		SVertex3DCompressed& OutVertex{ vOutVertices[iVertex] };
+
+		// Only the handedness of the bitangent is kept, the shaders rebuild it from the normal and the tangent
+		float BitangentSign{ (XMVectorGetX(XMVector3Dot(XMVector3Cross(Vertex.Normal, Vertex.Tangent), Vertex.Bitangent)) < 0.0f) ? -1.0f : 1.0f };
+		XMVECTOR Position{ XMVectorMultiply(XMVectorSubtract(Vertex.Position, PositionCenter), PositionInverseExtent) };
+
+		XMStoreShortN4(&OutVertex.Position, XMVectorSetW(Position, BitangentSign));
+		StoreOctahedral(&OutVertex.Normal, Vertex.Normal);
+		StoreOctahedral(&OutVertex.Tangent, Vertex.Tangent);
+		XMStoreUShortN2(&OutVertex.TexCoord, XMVectorMultiply(XMVectorSubtract(Vertex.TexCoord, TexCoordOffset), TexCoordInverseScale));
+		XMStoreUByteN4(&OutVertex.Color, Vertex.Color);
+	}
+}
+
+void CVertexCompressor::CompressVerticesAnimation(const vector<SVertexAnimation>& vVerticesAnimation,
+	vector<SVertexAnimationCompressed>& vOutVerticesAnimation)
+{
+	vOutVerticesAnimation.resize(vVerticesAnimation.size());
+	for (size_t iVertex = 0; iVertex < vVerticesAnimation.size(); ++iVertex)
+	{
+		const SVertexAnimation& VertexAnimation{ vVerticesAnimation[iVertex] };
+		SVertexAnimationCompressed& OutVertexAnimation{ vOutVerticesAnimation[iVertex] };
+
+		OutVertexAnimation.BoneIDs = XMUBYTE4(
+			static_cast<uint8_t>(VertexAnimation.BoneIDs[0]), static_cast<uint8_t>(VertexAnimation.BoneIDs[1]),
+			static_cast<uint8_t>(VertexAnimation.BoneIDs[2]), static_cast<uint8_t>(VertexAnimation.BoneIDs[3]));
+
+		float WeightSum{};
+		for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight) WeightSum += max(VertexAnimation.Weights[iWeight], 0.0f);
+		if (WeightSum <= 0.0f)
+		{
+			OutVertexAnimation.Weights = XMUBYTEN4{};
+			continue;
+		}
+
+		// @important: weights are rounded so that they sum up to exactly 255 (the rounding error goes to the largest weight)
+		int32_t Weights[KMaxWeightCount]{};
+		int32_t QuantizedSum{};
+		uint32_t iLargestWeight{};
+		for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight)
+		{
+			float Weight{ max(VertexAnimation.Weights[iWeight], 0.0f) / WeightSum };
+			Weights[iWeight] = static_cast<int32_t>(Weight * 255.0f + 0.5f);
+			QuantizedSum += Weights[iWeight];
+			if (Weights[iWeight] > Weights[iLargestWeight]) iLargestWeight = iWeight;
+		}
+		Weights[iLargestWeight] += 255 - QuantizedSum;
+
+		OutVertexAnimation.Weights = XMUBYTEN4(
+			static_cast<uint8_t>(Weights[0]), static_cast<uint8_t>(Weights[1]),
+			static_cast<uint8_t>(Weights[2]), static_cast<uint8_t>(Weights[3]));
+	}
+}
+
+SVertex3D CVertexCompressor::DecompressVertex(const SVertex3DCompressed& Vertex, const SCBVSVertexQuantizationData& Quantization)
+{
+	SVertex3D Result{};
+
+	XMVECTOR Position{ XMLoadShortN4(&Vertex.Position) };
+	float BitangentSign{ (XMVectorGetW(Position) < 0.0f) ? -1.0f : 1.0f };
+	Position = XMVectorMultiplyAdd(Position, XMLoadFloat4(&Quantization.PositionExtent), XMLoadFloat4(&Quantization.PositionCenter));
+	Result.Position = XMVectorSetW(Position, 1.0f);
+
+	Result.Normal = DecodeOctahedral(XMLoadShortN2(&Vertex.Normal));
+	Result.Tangent = DecodeOctahedral(XMLoadShortN2(&Vertex.Tangent));
+	Result.Bitangent = XMVectorScale(XMVector3Cross(Result.Normal, Result.Tangent), BitangentSign);
+
+	XMVECTOR TexCoord{ XMLoadUShortN2(&Vertex.TexCoord) };
+	Result.TexCoord = XMVectorMultiplyAdd(TexCoord,
+		XMVectorSet(Quantization.TexCoordOffsetScale.z, Quantization.TexCoordOffsetScale.w, 0, 0),
+		XMVectorSet(Quantization.TexCoordOffsetScale.x, Quantization.TexCoordOffsetScale.y, 0, 0));
+
+	Result.Color = XMLoadUByteN4(&Vertex.Color);
+	return Result;
+}
+
+SVertexAnimation CVertexCompressor::DecompressVertexAnimation(const SVertexAnimationCompressed& VertexAnimation)
+{
+	SVertexAnimation Result{};
+	Result.BoneIDs[0] = VertexAnimation.BoneIDs.x;
+	Result.BoneIDs[1] = VertexAnimation.BoneIDs.y;
+	Result.BoneIDs[2] = VertexAnimation.BoneIDs.z;
+	Result.BoneIDs[3] = VertexAnimation.BoneIDs.w;
+	Result.Weights[0] = VertexAnimation.Weights.x / 255.0f;
+	Result.Weights[1] = VertexAnimation.Weights.y / 255.0f;
+	Result.Weights[2] = VertexAnimation.Weights.z / 255.0f;
+	Result.Weights[3] = VertexAnimation.Weights.w / 255.0f;
+	return Result;
+}
+
+CVertexCompressor::SErrorStats CVertexCompressor::AnalyzeError(const vector<SMesh>& vMeshes, const SCBVSVertexQuantizationData& Quantization)
+{
+	SErrorStats Result{};
+
+	vector<SVertex3DCompressed> vCompressedVertices{};
+	vector<SVertexAnimationCompressed> vCompressedVerticesAnimation{};
+	for (const SMesh& Mesh : vMeshes)
+	{
+		CompressVertices(Mesh.vVertices, Quantization, vCompressedVertices);
+		for (size_t iVertex = 0; iVertex < Mesh.vVertices.size(); ++iVertex)
+		{
+			const SVertex3D& Vertex{ Mesh.vVertices[iVertex] };
+			SVertex3D Decompressed{ DecompressVertex(vCompressedVertices[iVertex], Quantization) };
+
+			float PositionError{ XMVectorGetX(XMVector3Length(XMVectorSubtract(Vertex.Position, Decompressed.Position))) };
+			Result.MaxPositionError = max(Result.MaxPositionError, PositionError);
+
+			float TexCoordError{ XMVectorGetX(XMVector2Length(XMVectorSubtract(Vertex.TexCoord, Decompressed.TexCoord))) };
+			Result.MaxTexCoordError = max(Result.MaxTexCoordError, TexCoordError);
+
+			// Degenerate (zero-length) directions can't be compared
+			if (XMVectorGetX(XMVector3LengthSq(Vertex.Normal)) > 0.0f)
+			{
+				XMVECTOR Original{ XMVector3Normalize(Vertex.Normal) };
+				float Angle{ GetAngleInDegrees(Original, Decompressed.Normal) };
+				Result.MaxNormalAngleError = max(Result.MaxNormalAngleError, Angle);
+			}
+			if (XMVectorGetX(XMVector3LengthSq(Vertex.Tangent)) > 0.0f)
+			{
+				XMVECTOR Original{ XMVector3Normalize(Vertex.Tangent) };
+				float Angle{ GetAngleInDegrees(Original, Decompressed.Tangent) };
+				Result.MaxTangentAngleError = max(Result.MaxTangentAngleError, Angle);
+			}
+		}
+
+		CompressVerticesAnimation(Mesh.vVerticesAnimation, vCompressedVerticesAnimation);
+		for (size_t iVertex = 0; iVertex < Mesh.vVerticesAnimation.size(); ++iVertex)
+		{
+			const SVertexAnimation& VertexAnimation{ Mesh.vVerticesAnimation[iVertex] };
+			SVertexAnimation Decompressed{ DecompressVertexAnimation(vCompressedVerticesAnimation[iVertex]) };
+
+			float WeightSum{};
+			for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight) WeightSum += max(VertexAnimation.Weights[iWeight], 0.0f);
+			if (WeightSum <= 0.0f) continue;
+
+			for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight)
+			{
+				float WeightError{ fabsf(max(VertexAnimation.Weights[iWeight], 0.0f) / WeightSum - Decompressed.Weights[iWeight]) };
+				Result.MaxWeightError = max(Result.MaxWeightError, WeightError);
+			}
+		}
+
+		Result.VertexCount += Mesh.vVertices.size();
+		Result.ByteSizeBefore += sizeof(SVertex3D) * Mesh.vVertices.size() + sizeof(SVertexAnimation) * Mesh.vVerticesAnimation.size();
+		Result.ByteSizeAfter += sizeof(SVertex3DCompressed) * Mesh.vVertices.size() +
+			sizeof(SVertexAnimationCompressed) * Mesh.vVerticesAnimation.size();
+	}
+	return Result;
+}
+
+XMVECTOR CVertexCompressor::EncodeOctahedral(FXMVECTOR Direction)
+{
+	const XMVECTOR KZero{ XMVectorZero() };
+	const XMVECTOR KOne{ XMVectorSplatOne() };
+
+	XMVECTOR L1Norm{ XMVector3Dot(XMVectorAbs(Direction), KOne) };
+	if (XMVectorGetX(L1Norm) <= 0.0f) return KZero;
+
+	// Project onto the octahedron |x| + |y| + |z| = 1
+	XMVECTOR Octahedron{ XMVectorDivide(Direction, L1Norm) };
+
+	// Fold the lower hemisphere over the diagonals
+	XMVECTOR Sign{ XMVectorSelect(XMVectorNegate(KOne), KOne, XMVectorGreaterOrEqual(Octahedron, KZero)) };
+	XMVECTOR Folded{ XMVectorMultiply(XMVectorSubtract(KOne, XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(Octahedron))), Sign) };
+	XMVECTOR Result{ XMVectorSelect(Octahedron, Folded, XMVectorLess(XMVectorSplatZ(Octahedron), KZero)) };
+
+	return XMVectorSelect(KZero, Result, g_XMSelect1100);
+}
+
+XMVECTOR CVertexCompressor::DecodeOctahedral(FXMVECTOR Encoded)
+{
+	const XMVECTOR KZero{ XMVectorZero() };
+	const XMVECTOR KOne{ XMVectorSplatOne() };
+
+	XMVECTOR XY{ XMVectorSelect(KZero, Encoded, g_XMSelect1100) };
+	XMVECTOR Z{ XMVectorSubtract(KOne, XMVector2Dot(XMVectorAbs(XY), KOne)) };
+	XMVECTOR Result{ XMVectorSelect(Z, XY, g_XMSelect1100) };
+
+	// Unfold the lower hemisphere
+	XMVECTOR T{ XMVectorMax(XMVectorNegate(Z), KZero) };
+	XMVECTOR Sign{ XMVectorSelect(XMVectorNegate(KOne), KOne, XMVectorGreaterOrEqual(Result, KZero)) };
+	Result = XMVectorSelect(Result, XMVectorSubtract(Result, XMVectorMultiply(Sign, T)), g_XMSelect1100);
+
+	return XMVector3Normalize(XMVectorSetW(Result, 0.0f));
+}
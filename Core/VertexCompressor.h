@@ -0,0 +1,86 @@
+#pragma once
+
+#include <DirectXPackedVector.h>
+#include "AssimpLoader.h"
+
+// 24 bytes (SVertex3D is 96 bytes)
+struct SVertex3DCompressed
+{
+	PackedVector::XMSHORTN4		Position{}; // xyz: SNORM16 within the model's bounds, w: bitangent sign
+	PackedVector::XMSHORTN2		Normal{}; // Octahedral
+	PackedVector::XMSHORTN2		Tangent{}; // Octahedral
+	PackedVector::XMUSHORTN2	TexCoord{}; // UNORM16 within the model's texture coordinate bounds
+	PackedVector::XMUBYTEN4		Color{};
+};
+
+// 8 bytes (SVertexAnimation is 32 bytes)
+struct SVertexAnimationCompressed
+{
+	PackedVector::XMUBYTE4		BoneIDs{};
+	PackedVector::XMUBYTEN4		Weights{}; // Sum is always 255
+};
+
+// Packs vertices for the VS*Compressed vertex shaders (see Shader/HVertexCompression.hlsli)
+class CVertexCompressor
+{
+public:
+	// Dequantization parameters of a model (all meshes share them)
+	struct SCBVSVertexQuantizationData
+	{
+		XMFLOAT4	PositionCenter{};
+		XMFLOAT4	PositionExtent{ 1, 1, 1, 0 }; // Half size of the bounds
+		XMFLOAT4	TexCoordOffsetScale{ 0, 0, 1, 1 }; // xy: offset, zw: scale
+	};
+
+	struct SErrorStats
+	{
+		float		MaxPositionError{}; // In model space
+		float		MaxNormalAngleError{}; // In degrees
+		float		MaxTangentAngleError{}; // In degrees
+		float		MaxTexCoordError{};
+		float		MaxWeightError{};
+		size_t		VertexCount{};
+		size_t		ByteSizeBefore{};
+		size_t		ByteSizeAfter{};
+	};
+
+public:
+	static SCBVSVertexQuantizationData CalculateQuantization(const vector<SMesh>& vMeshes);
+
+	static void CompressVertices(const vector<SVertex3D>& vVertices, const SCBVSVertexQuantizationData& Quantization,
+		vector<SVertex3DCompressed>& vOutVertices);
+	static void CompressVerticesAnimation(const vector<SVertexAnimation>& vVerticesAnimation,
+		vector<SVertexAnimationCompressed>& vOutVerticesAnimation);
+
+	static SVertex3D DecompressVertex(const SVertex3DCompressed& Vertex, const SCBVSVertexQuantizationData& Quantization);
+	static SVertexAnimation DecompressVertexAnimation(const SVertexAnimationCompressed& VertexAnimation);
+
+	// Compresses and decompresses the meshes, then measures the round-trip error
+	static SErrorStats AnalyzeError(const vector<SMesh>& vMeshes, const SCBVSVertexQuantizationData& Quantization);
+
+	// Unit vector <-> [-1, 1]^2
+	static XMVECTOR EncodeOctahedral(FXMVECTOR Direction);
+	static XMVECTOR DecodeOctahedral(FXMVECTOR Encoded);
+
+public:
+	// Slot 0: SVertex3DCompressed, slot 1: SVertexAnimationCompressed, slot 2: SInstanceGPUData
+	static constexpr D3D11_INPUT_ELEMENT_DESC KInputElementDescs[]
+	{
+		{ "POSITION"	, 0, DXGI_FORMAT_R16G16B16A16_SNORM	, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL"		, 0, DXGI_FORMAT_R16G16_SNORM		, 0,  8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT"		, 0, DXGI_FORMAT_R16G16_SNORM		, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD"	, 0, DXGI_FORMAT_R16G16_UNORM		, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR"		, 0, DXGI_FORMAT_R8G8B8A8_UNORM		, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+
+		{ "BLENDINDICES", 0, DXGI_FORMAT_R8G8B8A8_UINT		, 1,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "BLENDWEIGHT"	, 0, DXGI_FORMAT_R8G8B8A8_UNORM		, 1,  4, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+
+		{ "INSTANCEWORLD"	, 0, DXGI_FORMAT_R32G32B32A32_FLOAT	, 2,  0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCEWORLD"	, 1, DXGI_FORMAT_R32G32B32A32_FLOAT	, 2, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCEWORLD"	, 2, DXGI_FORMAT_R32G32B32A32_FLOAT	, 2, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCEWORLD"	, 3, DXGI_FORMAT_R32G32B32A32_FLOAT	, 2, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+
+private:
+	static constexpr float KMinExtent{ 0.0001f };
+};
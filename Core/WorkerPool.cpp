@@ -0,0 +1,99 @@
+#include "WorkerPool.h"
+
+// Loops started from inside a job run inline (a worker waiting for other workers could deadlock the pool)
+static thread_local bool s_bIsWorkerThread{};
+
+CWorkerPool::CWorkerPool(uint32_t ThreadCount)
+{
+	for (uint32_t iThread = 0; iThread < ThreadCount; ++iThread)
+	{
+		m_vThreads.emplace_back(&CWorkerPool::RunWorker, this);
+	}
+}
+
+CWorkerPool::~CWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_bShouldStop = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto& Thread : m_vThreads)
+	{
+		Thread.join();
+	}
+}
+
+CWorkerPool& CWorkerPool::GetShared()
+{
+	static CWorkerPool SharedPool{ max(std::thread::hardware_concurrency(), 1u) - 1 };
+	return SharedPool;
+}
+
+void CWorkerPool::ForEach(uint32_t JobCount, uint32_t MaxThreadCount, const std::function<void(uint32_t)>& Job)
+{
+	if (JobCount == 0) return;
+
+	if (MaxThreadCount == 0) MaxThreadCount = GetThreadCount();
+	MaxThreadCount = min(min(MaxThreadCount, GetThreadCount()), JobCount);
+
+	std::unique_lock<std::mutex> LoopLock{ m_LoopMutex, std::defer_lock };
+	if (MaxThreadCount <= 1 || s_bIsWorkerThread || !LoopLock.try_lock())
+	{
+		for (uint32_t iJob = 0; iJob < JobCount; ++iJob)
+		{
+			Job(iJob);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_PtrJob = &Job;
+		m_JobCount = JobCount;
+		m_NextJob = 0;
+		m_FreeWorkerSlotCount = MaxThreadCount - 1;
+		++m_LoopID;
+	}
+	m_WakeCondition.notify_all();
+
+	RunJobs();
+
+	// @important: workers that have joined the loop may still be running their last job
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	m_DoneCondition.wait(Lock, [&] { return m_BusyWorkerCount == 0; });
+	m_FreeWorkerSlotCount = 0;
+	m_PtrJob = nullptr;
+}
+
+void CWorkerPool::RunWorker()
+{
+	s_bIsWorkerThread = true;
+
+	uint64_t LastLoopID{};
+	std::unique_lock<std::mutex> Lock{ m_Mutex };
+	while (true)
+	{
+		m_WakeCondition.wait(Lock, [&] { return m_bShouldStop || (m_LoopID != LastLoopID && m_FreeWorkerSlotCount > 0); });
+		if (m_bShouldStop) return;
+
+		LastLoopID = m_LoopID;
+		--m_FreeWorkerSlotCount;
+		++m_BusyWorkerCount;
+		Lock.unlock();
+
+		RunJobs();
+
+		Lock.lock();
+		if (--m_BusyWorkerCount == 0) m_DoneCondition.notify_all();
+	}
+}
+
+void CWorkerPool::RunJobs()
+{
+	for (uint32_t iJob = m_NextJob++; iJob < m_JobCount; iJob = m_NextJob++)
+	{
+		(*m_PtrJob)(iJob);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SharedHeader.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Persistent worker threads for data-parallel loops (brush passes, terrain generation, mip generation...)
+// The threads are created once and sleep between loops, so a loop only costs a wake-up instead of thread creation
+// The calling thread works on the loop too. Loops that are started while another one runs (from another thread, or from inside a job)
+// run on their calling thread alone instead of waiting.
+class CWorkerPool final
+{
+public:
+	// ThreadCount worker threads (the calling thread is not counted)
+	CWorkerPool(uint32_t ThreadCount);
+	~CWorkerPool();
+
+	CWorkerPool(const CWorkerPool&) = delete;
+	CWorkerPool& operator=(const CWorkerPool&) = delete;
+
+public:
+	// std::thread::hardware_concurrency() - 1 workers, created on first use
+	static CWorkerPool& GetShared();
+
+public:
+	// Calls Job(JobIndex) for every job in [0, JobCount) and returns when all of them are done
+	// At most MaxThreadCount threads work on the jobs, including the calling thread (0: all of them)
+	void ForEach(uint32_t JobCount, uint32_t MaxThreadCount, const std::function<void(uint32_t)>& Job);
+
+	// Including the calling thread
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_vThreads.size()) + 1; }
+
+private:
+	void RunWorker();
+	void RunJobs();
+
+private:
+	vector<std::thread>						m_vThreads{};
+	std::mutex								m_LoopMutex{}; // Held by the thread whose loop the workers run
+	std::mutex								m_Mutex{};
+	std::condition_variable					m_WakeCondition{};
+	std::condition_variable					m_DoneCondition{};
+	bool									m_bShouldStop{};
+
+private:
+	const std::function<void(uint32_t)>*	m_PtrJob{};
+	uint32_t								m_JobCount{};
+	std::atomic<uint32_t>					m_NextJob{};
+	uint64_t								m_LoopID{};
+	uint32_t								m_FreeWorkerSlotCount{};
+	uint32_t								m_BusyWorkerCount{};
+};
@@ -0,0 +1,525 @@
+#pragma once
+
+// The subset of DirectXMath that Core uses, for the headless (non-Windows) build (SSE2 only, like _XM_SSE_INTRINSICS_)
+// XMVECTOR mirrors MSVC's __m128 (m128_f32 is its first member), so that code written against MSVC's layout compiles as is
+// Results match DirectXMath's SSE2 path: round-to-nearest-even conversions, zero-length vectors normalize to zero
+
+#include <emmintrin.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#define XM_CALLCONV
+#define XMGLOBALCONST static const
+
+namespace DirectX
+{
+	constexpr float XM_PI{ 3.141592654f };
+	constexpr float XM_2PI{ 6.283185307f };
+	constexpr float XM_1DIVPI{ 0.318309886f };
+	constexpr float XM_1DIV2PI{ 0.159154943f };
+	constexpr float XM_PIDIV2{ 1.570796327f };
+	constexpr float XM_PIDIV4{ 0.785398163f };
+
+	constexpr uint32_t XM_SELECT_0{ 0x00000000 };
+	constexpr uint32_t XM_SELECT_1{ 0xFFFFFFFF };
+
+	union alignas(16) XMVECTOR
+	{
+		float		m128_f32[4];
+		uint32_t	m128_u32[4];
+		int32_t		m128_i32[4];
+		__m128		v;
+	};
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	namespace Internal
+	{
+		inline XMVECTOR Make(__m128 V) { XMVECTOR Result; Result.v = V; return Result; }
+		inline XMVECTOR Make(__m128i V) { XMVECTOR Result; Result.v = _mm_castsi128_ps(V); return Result; }
+		inline __m128i AsInt(FXMVECTOR V) { return _mm_castps_si128(V.v); }
+		template <int Element> inline __m128 Splat(__m128 V) { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(Element, Element, Element, Element)); }
+	}
+
+	struct alignas(16) XMVECTORF32
+	{
+		union
+		{
+			float	f[4];
+			XMVECTOR	v;
+		};
+
+		operator XMVECTOR() const { return v; }
+		operator const float*() const { return f; }
+	};
+
+	struct alignas(16) XMVECTORU32
+	{
+		union
+		{
+			uint32_t	u[4];
+			XMVECTOR	v;
+		};
+
+		operator XMVECTOR() const { return v; }
+	};
+
+	struct alignas(16) XMVECTORI32
+	{
+		union
+		{
+			int32_t		i[4];
+			XMVECTOR	v;
+		};
+
+		operator XMVECTOR() const { return v; }
+	};
+
+	XMGLOBALCONST XMVECTORU32 g_XMSelect1000{ { { XM_SELECT_1, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 } } };
+	XMGLOBALCONST XMVECTORU32 g_XMSelect1100{ { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 } } };
+	XMGLOBALCONST XMVECTORU32 g_XMSelect1110{ { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 } } };
+	XMGLOBALCONST XMVECTORU32 g_XMSelect0111{ { { XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_1 } } };
+
+	struct alignas(16) XMMATRIX
+	{
+		XMVECTOR	r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR R0, FXMVECTOR R1, FXMVECTOR R2, CXMVECTOR R3) : r{ R0, R1, R2, R3 } {}
+		XMMATRIX(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33);
+
+		XMMATRIX operator*(const XMMATRIX& M) const;
+		XMMATRIX& operator*=(const XMMATRIX& M);
+	};
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMFLOAT2
+	{
+		float	x;
+		float	y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x{ _x }, y{ _y } {}
+		explicit XMFLOAT2(const float* const Array) : x{ Array[0] }, y{ Array[1] } {}
+	};
+
+	struct XMFLOAT3
+	{
+		float	x;
+		float	y;
+		float	z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x{ _x }, y{ _y }, z{ _z } {}
+		explicit XMFLOAT3(const float* const Array) : x{ Array[0] }, y{ Array[1] }, z{ Array[2] } {}
+	};
+
+	struct XMFLOAT4
+	{
+		float	x;
+		float	y;
+		float	z;
+		float	w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+		explicit XMFLOAT4(const float* const Array) : x{ Array[0] }, y{ Array[1] }, z{ Array[2] }, w{ Array[3] } {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		float	m[4][4];
+	};
+
+	inline constexpr float XMConvertToRadians(float Degrees) { return Degrees * (XM_PI / 180.0f); }
+	inline constexpr float XMConvertToDegrees(float Radians) { return Radians * (180.0f / XM_PI); }
+
+	// ###########################
+	// << VECTOR >>
+	// ###########################
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return Internal::Make(_mm_set_ps(w, z, y, x)); }
+	inline XMVECTOR XMVectorReplicate(float Value) { return Internal::Make(_mm_set1_ps(Value)); }
+	inline XMVECTOR XMVectorZero() { return Internal::Make(_mm_setzero_ps()); }
+	inline XMVECTOR XMVectorSplatOne() { return XMVectorReplicate(1.0f); }
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR V) { return Internal::Make(Internal::Splat<0>(V.v)); }
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR V) { return Internal::Make(Internal::Splat<1>(V.v)); }
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR V) { return Internal::Make(Internal::Splat<2>(V.v)); }
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR V) { return Internal::Make(Internal::Splat<3>(V.v)); }
+
+	inline float XMVectorGetX(FXMVECTOR V) { return _mm_cvtss_f32(V.v); }
+	inline float XMVectorGetY(FXMVECTOR V) { return _mm_cvtss_f32(Internal::Splat<1>(V.v)); }
+	inline float XMVectorGetZ(FXMVECTOR V) { return _mm_cvtss_f32(Internal::Splat<2>(V.v)); }
+	inline float XMVectorGetW(FXMVECTOR V) { return _mm_cvtss_f32(Internal::Splat<3>(V.v)); }
+	inline XMVECTOR XMVectorSetX(FXMVECTOR V, float x) { XMVECTOR Result{ V }; Result.m128_f32[0] = x; return Result; }
+	inline XMVECTOR XMVectorSetY(FXMVECTOR V, float y) { XMVECTOR Result{ V }; Result.m128_f32[1] = y; return Result; }
+	inline XMVECTOR XMVectorSetZ(FXMVECTOR V, float z) { XMVECTOR Result{ V }; Result.m128_f32[2] = z; return Result; }
+	inline XMVECTOR XMVectorSetW(FXMVECTOR V, float w) { XMVECTOR Result{ V }; Result.m128_f32[3] = w; return Result; }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_add_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_sub_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_mul_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_div_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR V, float Scale) { return Internal::Make(_mm_mul_ps(V.v, _mm_set1_ps(Scale))); }
+	// V1 * V2 + V3
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR V3) { return Internal::Make(_mm_add_ps(_mm_mul_ps(V1.v, V2.v), V3.v)); }
+	// V3 - V1 * V2
+	inline XMVECTOR XMVectorNegativeMultiplySubtract(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR V3)
+	{
+		return Internal::Make(_mm_sub_ps(V3.v, _mm_mul_ps(V1.v, V2.v)));
+	}
+	inline XMVECTOR XMVectorNegate(FXMVECTOR V) { return Internal::Make(_mm_sub_ps(_mm_setzero_ps(), V.v)); }
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR V) { return Internal::Make(_mm_div_ps(_mm_set1_ps(1.0f), V.v)); }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR V) { return Internal::Make(_mm_sqrt_ps(V.v)); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR V) { return Internal::Make(_mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), V.v), V.v)); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_min_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_max_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorClamp(FXMVECTOR V, FXMVECTOR Min, FXMVECTOR Max) { return Internal::Make(_mm_min_ps(_mm_max_ps(Min.v, V.v), Max.v)); }
+	inline XMVECTOR XMVectorSaturate(FXMVECTOR V) { return Internal::Make(_mm_min_ps(_mm_max_ps(_mm_setzero_ps(), V.v), _mm_set1_ps(1.0f))); }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR V0, FXMVECTOR V1, float t)
+	{
+		return Internal::Make(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(V1.v, V0.v), _mm_set1_ps(t)), V0.v));
+	}
+	inline XMVECTOR XMVectorLerpV(FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR T) { return Internal::Make(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(V1.v, V0.v), T.v), V0.v)); }
+
+	// Round to nearest (even); values that have no fraction (|V| >= 2^23, INF, NaN) are returned as they are
+	inline XMVECTOR XMVectorRound(FXMVECTOR V)
+	{
+		const __m128 KSign{ _mm_and_ps(V.v, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)))) };
+		const __m128 KMagic{ _mm_or_ps(_mm_castsi128_ps(_mm_set1_epi32(0x4B000000)), KSign) };
+		__m128 Rounded{ _mm_sub_ps(_mm_add_ps(V.v, KMagic), KMagic) };
+		const __m128 KAbs{ _mm_and_ps(V.v, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))) };
+		const __m128 KHasFraction{ _mm_cmple_ps(KAbs, _mm_castsi128_ps(_mm_set1_epi32(0x4B000000))) };
+		Rounded = _mm_and_ps(Rounded, KHasFraction);
+		return Internal::Make(_mm_or_ps(Rounded, _mm_andnot_ps(KHasFraction, V.v)));
+	}
+
+	inline XMVECTOR XMVectorFloor(FXMVECTOR V)
+	{
+		const __m128i KHasFraction{ _mm_cmplt_epi32(_mm_and_si128(Internal::AsInt(V), _mm_set1_epi32(0x7FFFFFFF)), _mm_set1_epi32(0x4B000000)) };
+		__m128 Result{ _mm_cvtepi32_ps(_mm_cvttps_epi32(V.v)) };
+		const __m128 KLarger{ _mm_cmpgt_ps(Result, V.v) };
+		Result = _mm_add_ps(Result, _mm_cvtepi32_ps(_mm_castps_si128(KLarger))); // 0xFFFFFFFF is -1
+		Result = _mm_and_ps(Result, _mm_castsi128_ps(KHasFraction));
+		return Internal::Make(_mm_or_ps(Result, _mm_castsi128_ps(_mm_andnot_si128(KHasFraction, Internal::AsInt(V)))));
+	}
+
+	// (V1 & ~Control) | (V2 & Control)
+	inline XMVECTOR XMVectorSelect(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR Control)
+	{
+		return Internal::Make(_mm_or_ps(_mm_andnot_ps(Control.v, V1.v), _mm_and_ps(V2.v, Control.v)));
+	}
+	inline XMVECTOR XMVectorEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_cmpeq_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorGreater(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_cmpgt_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorGreaterOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_cmpge_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorLess(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_cmplt_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorLessOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_cmple_ps(V1.v, V2.v)); }
+	inline XMVECTOR XMVectorOrInt(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_or_si128(Internal::AsInt(V1), Internal::AsInt(V2))); }
+	inline XMVECTOR XMVectorAndInt(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Make(_mm_and_si128(Internal::AsInt(V1), Internal::AsInt(V2))); }
+
+	inline XMVECTOR XMVectorSwizzle(FXMVECTOR V, uint32_t E0, uint32_t E1, uint32_t E2, uint32_t E3)
+	{
+		return XMVectorSet(V.m128_f32[E0], V.m128_f32[E1], V.m128_f32[E2], V.m128_f32[E3]);
+	}
+	template <uint32_t E0, uint32_t E1, uint32_t E2, uint32_t E3>
+	inline XMVECTOR XMVectorSwizzle(FXMVECTOR V)
+	{
+		static_assert(E0 < 4 && E1 < 4 && E2 < 4 && E3 < 4, "Swizzle element out of range");
+		return Internal::Make(_mm_shuffle_ps(V.v, V.v, _MM_SHUFFLE(E3, E2, E1, E0)));
+	}
+
+	// Truncates V * 2^DivExponent toward zero, saturating to INT_MAX
+	inline XMVECTOR XMConvertVectorFloatToInt(FXMVECTOR V, uint32_t MulExponent)
+	{
+		const __m128 KScaled{ _mm_mul_ps(V.v, _mm_set1_ps(static_cast<float>(1u << MulExponent))) };
+		const __m128 KOverflow{ _mm_cmpgt_ps(KScaled, _mm_set1_ps(2147483647.0f)) };
+		const __m128i KResult{ _mm_cvttps_epi32(KScaled) };
+		return Internal::Make(_mm_or_ps(_mm_andnot_ps(KOverflow, _mm_castsi128_ps(KResult)),
+			_mm_and_ps(KOverflow, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)))));
+	}
+	inline XMVECTOR XMConvertVectorIntToFloat(FXMVECTOR V, uint32_t DivExponent)
+	{
+		return Internal::Make(_mm_mul_ps(_mm_cvtepi32_ps(Internal::AsInt(V)), _mm_set1_ps(1.0f / static_cast<float>(1u << DivExponent))));
+	}
+
+	inline XMVECTOR XMLoadFloat(const float* const Source) { return Internal::Make(_mm_load_ss(Source)); }
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* const Source) { return XMVectorSet(Source->x, Source->y, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* const Source) { return XMVectorSet(Source->x, Source->y, Source->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* const Source) { return Internal::Make(_mm_loadu_ps(&Source->x)); }
+	inline XMVECTOR XMLoadInt4(const uint32_t* const Source) { return Internal::Make(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Source))); }
+	inline void XMStoreFloat(float* const Destination, FXMVECTOR V) { _mm_store_ss(Destination, V.v); }
+	inline void XMStoreFloat2(XMFLOAT2* const Destination, FXMVECTOR V) { Destination->x = V.m128_f32[0]; Destination->y = V.m128_f32[1]; }
+	inline void XMStoreFloat3(XMFLOAT3* const Destination, FXMVECTOR V)
+	{
+		Destination->x = V.m128_f32[0];
+		Destination->y = V.m128_f32[1];
+		Destination->z = V.m128_f32[2];
+	}
+	inline void XMStoreFloat4(XMFLOAT4* const Destination, FXMVECTOR V) { _mm_storeu_ps(&Destination->x, V.v); }
+	inline void XMStoreInt4(uint32_t* const Destination, FXMVECTOR V) { _mm_storeu_si128(reinterpret_cast<__m128i*>(Destination), Internal::AsInt(V)); }
+
+	inline XMVECTOR operator+(FXMVECTOR V) { return V; }
+	inline XMVECTOR operator-(FXMVECTOR V) { return XMVectorNegate(V); }
+	inline XMVECTOR operator+(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorAdd(V1, V2); }
+	inline XMVECTOR operator-(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorSubtract(V1, V2); }
+	inline XMVECTOR operator*(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorMultiply(V1, V2); }
+	inline XMVECTOR operator/(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorDivide(V1, V2); }
+	inline XMVECTOR operator*(FXMVECTOR V, float S) { return XMVectorScale(V, S); }
+	inline XMVECTOR operator*(float S, FXMVECTOR V) { return XMVectorScale(V, S); }
+	inline XMVECTOR operator/(FXMVECTOR V, float S) { return XMVectorDivide(V, XMVectorReplicate(S)); }
+	inline XMVECTOR& operator+=(XMVECTOR& V1, FXMVECTOR V2) { V1 = XMVectorAdd(V1, V2); return V1; }
+	inline XMVECTOR& operator-=(XMVECTOR& V1, FXMVECTOR V2) { V1 = XMVectorSubtract(V1, V2); return V1; }
+	inline XMVECTOR& operator*=(XMVECTOR& V1, FXMVECTOR V2) { V1 = XMVectorMultiply(V1, V2); return V1; }
+	inline XMVECTOR& operator/=(XMVECTOR& V1, FXMVECTOR V2) { V1 = XMVectorDivide(V1, V2); return V1; }
+	inline XMVECTOR& operator*=(XMVECTOR& V, float S) { V = XMVectorScale(V, S); return V; }
+	inline XMVECTOR& operator/=(XMVECTOR& V, float S) { V = XMVectorDivide(V, XMVectorReplicate(S)); return V; }
+
+	// ###########################
+	// << 2D, 3D AND 4D VECTOR >>
+	// ###########################
+
+	inline XMVECTOR XMVector2Dot(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorReplicate(V1.m128_f32[0] * V2.m128_f32[0] + V1.m128_f32[1] * V2.m128_f32[1]); }
+	inline XMVECTOR XMVector2Length(FXMVECTOR V) { return XMVectorSqrt(XMVector2Dot(V, V)); }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		const __m128 KProduct{ _mm_mul_ps(V1.v, V2.v) };
+		const __m128 KSum{ _mm_add_ss(_mm_add_ss(KProduct, Internal::Splat<1>(KProduct)), Internal::Splat<2>(KProduct)) };
+		return Internal::Make(Internal::Splat<0>(KSum));
+	}
+	inline XMVECTOR XMVector3Cross(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		const __m128 KA{ _mm_mul_ps(_mm_shuffle_ps(V1.v, V1.v, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(V2.v, V2.v, _MM_SHUFFLE(3, 1, 0, 2))) };
+		const __m128 KB{ _mm_mul_ps(_mm_shuffle_ps(V1.v, V1.v, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(V2.v, V2.v, _MM_SHUFFLE(3, 0, 2, 1))) };
+		return Internal::Make(_mm_and_ps(_mm_sub_ps(KA, KB), g_XMSelect1110.v.v));
+	}
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR V) { return XMVector3Dot(V, V); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR V) { return XMVectorSqrt(XMVector3Dot(V, V)); }
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR V)
+	{
+		const __m128 KLength{ _mm_sqrt_ps(XMVector3Dot(V, V).v) };
+		const __m128 KNonZero{ _mm_cmpneq_ps(_mm_setzero_ps(), KLength) };
+		return Internal::Make(_mm_and_ps(_mm_div_ps(V.v, KLength), KNonZero));
+	}
+	inline bool XMVector3Equal(FXMVECTOR V1, FXMVECTOR V2) { return (_mm_movemask_ps(_mm_cmpeq_ps(V1.v, V2.v)) & 7) == 7; }
+	inline bool XMVector3Greater(FXMVECTOR V1, FXMVECTOR V2) { return (_mm_movemask_ps(_mm_cmpgt_ps(V1.v, V2.v)) & 7) == 7; }
+	inline bool XMVector3GreaterOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return (_mm_movemask_ps(_mm_cmpge_ps(V1.v, V2.v)) & 7) == 7; }
+	inline bool XMVector3Less(FXMVECTOR V1, FXMVECTOR V2) { return (_mm_movemask_ps(_mm_cmplt_ps(V1.v, V2.v)) & 7) == 7; }
+	inline bool XMVector3LessOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return (_mm_movemask_ps(_mm_cmple_ps(V1.v, V2.v)) & 7) == 7; }
+
+	inline XMVECTOR XMVector4Dot(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		const __m128 KProduct{ _mm_mul_ps(V1.v, V2.v) };
+		const __m128 KPairs{ _mm_add_ps(KProduct, _mm_shuffle_ps(KProduct, KProduct, _MM_SHUFFLE(2, 3, 0, 1))) };
+		return Internal::Make(_mm_add_ps(KPairs, _mm_shuffle_ps(KPairs, KPairs, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+	inline XMVECTOR XMVector4Length(FXMVECTOR V) { return XMVectorSqrt(XMVector4Dot(V, V)); }
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR V)
+	{
+		const __m128 KLength{ _mm_sqrt_ps(XMVector4Dot(V, V).v) };
+		const __m128 KNonZero{ _mm_cmpneq_ps(_mm_setzero_ps(), KLength) };
+		return Internal::Make(_mm_and_ps(_mm_div_ps(V.v, KLength), KNonZero));
+	}
+	inline bool XMVector4Equal(FXMVECTOR V1, FXMVECTOR V2) { return _mm_movemask_ps(_mm_cmpeq_ps(V1.v, V2.v)) == 15; }
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR V, FXMMATRIX M)
+	{
+		__m128 Result{ _mm_mul_ps(Internal::Splat<0>(V.v), M.r[0].v) };
+		Result = _mm_add_ps(Result, _mm_mul_ps(Internal::Splat<1>(V.v), M.r[1].v));
+		Result = _mm_add_ps(Result, _mm_mul_ps(Internal::Splat<2>(V.v), M.r[2].v));
+		return Internal::Make(_mm_add_ps(Result, _mm_mul_ps(Internal::Splat<3>(V.v), M.r[3].v)));
+	}
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR V, FXMMATRIX M)
+	{
+		__m128 Result{ _mm_mul_ps(Internal::Splat<0>(V.v), M.r[0].v) };
+		Result = _mm_add_ps(Result, _mm_mul_ps(Internal::Splat<1>(V.v), M.r[1].v));
+		return Internal::Make(_mm_add_ps(Result, _mm_mul_ps(Internal::Splat<2>(V.v), M.r[2].v)));
+	}
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR V, FXMMATRIX M)
+	{
+		__m128 Result{ _mm_add_ps(XMVector3TransformNormal(V, M).v, M.r[3].v) };
+		return Internal::Make(_mm_div_ps(Result, Internal::Splat<3>(Result)));
+	}
+
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR P)
+	{
+		const float KLength{ sqrtf(XMVectorGetX(XMVector3Dot(P, P))) };
+		return (KLength > 0.0f) ? XMVectorScale(P, 1.0f / KLength) : XMVectorZero();
+	}
+	inline XMVECTOR XMPlaneDotCoord(FXMVECTOR P, FXMVECTOR V) { return XMVector4Dot(P, XMVectorSetW(V, 1.0f)); }
+
+	// ###########################
+	// << MATRIX >>
+	// ###########################
+
+	inline XMMATRIX XMMatrixSet(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
+	{
+		return XMMATRIX(XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13), XMVectorSet(m20, m21, m22, m23),
+			XMVectorSet(m30, m31, m32, m33));
+	}
+
+	inline XMMATRIX::XMMATRIX(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33) :
+		r{ XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13), XMVectorSet(m20, m21, m22, m23), XMVectorSet(m30, m31, m32, m33) }
+	{
+	}
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX(XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, 0, 1));
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX M1, CXMMATRIX M2)
+	{
+		return XMMATRIX(XMVector4Transform(M1.r[0], M2), XMVector4Transform(M1.r[1], M2), XMVector4Transform(M1.r[2], M2),
+			XMVector4Transform(M1.r[3], M2));
+	}
+	inline XMMATRIX XMMATRIX::operator*(const XMMATRIX& M) const { return XMMatrixMultiply(*this, M); }
+	inline XMMATRIX& XMMATRIX::operator*=(const XMMATRIX& M) { *this = XMMatrixMultiply(*this, M); return *this; }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX M)
+	{
+		__m128 R0{ M.r[0].v }, R1{ M.r[1].v }, R2{ M.r[2].v }, R3{ M.r[3].v };
+		_MM_TRANSPOSE4_PS(R0, R1, R2, R3);
+		return XMMATRIX(Internal::Make(R0), Internal::Make(R1), Internal::Make(R2), Internal::Make(R3));
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float OffsetX, float OffsetY, float OffsetZ)
+	{
+		XMMATRIX Result{ XMMatrixIdentity() };
+		Result.r[3] = XMVectorSet(OffsetX, OffsetY, OffsetZ, 1.0f);
+		return Result;
+	}
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR Offset) { return XMMatrixTranslation(Offset.m128_f32[0], Offset.m128_f32[1], Offset.m128_f32[2]); }
+
+	inline XMMATRIX XMMatrixScaling(float ScaleX, float ScaleY, float ScaleZ)
+	{
+		return XMMATRIX(XMVectorSet(ScaleX, 0, 0, 0), XMVectorSet(0, ScaleY, 0, 0), XMVectorSet(0, 0, ScaleZ, 0), XMVectorSet(0, 0, 0, 1));
+	}
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR Scale) { return XMMatrixScaling(Scale.m128_f32[0], Scale.m128_f32[1], Scale.m128_f32[2]); }
+
+	inline XMMATRIX XMMatrixRotationX(float Angle)
+	{
+		const float KSin{ sinf(Angle) }, KCos{ cosf(Angle) };
+		return XMMATRIX(XMVectorSet(1, 0, 0, 0), XMVectorSet(0, KCos, KSin, 0), XMVectorSet(0, -KSin, KCos, 0), XMVectorSet(0, 0, 0, 1));
+	}
+	inline XMMATRIX XMMatrixRotationY(float Angle)
+	{
+		const float KSin{ sinf(Angle) }, KCos{ cosf(Angle) };
+		return XMMATRIX(XMVectorSet(KCos, 0, -KSin, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(KSin, 0, KCos, 0), XMVectorSet(0, 0, 0, 1));
+	}
+	inline XMMATRIX XMMatrixRotationZ(float Angle)
+	{
+		const float KSin{ sinf(Angle) }, KCos{ cosf(Angle) };
+		return XMMATRIX(XMVectorSet(KCos, KSin, 0, 0), XMVectorSet(-KSin, KCos, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, 0, 1));
+	}
+	// Roll (z) first, then pitch (x), then yaw (y)
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float Pitch, float Yaw, float Roll)
+	{
+		return XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationZ(Roll), XMMatrixRotationX(Pitch)), XMMatrixRotationY(Yaw));
+	}
+	inline XMMATRIX XMMatrixRotationNormal(FXMVECTOR NormalAxis, float Angle)
+	{
+		const float X{ NormalAxis.m128_f32[0] }, Y{ NormalAxis.m128_f32[1] }, Z{ NormalAxis.m128_f32[2] };
+		const float KSin{ sinf(Angle) }, KCos{ cosf(Angle) }, KOneMinusCos{ 1.0f - KCos };
+		return XMMATRIX(
+			XMVectorSet(KCos + KOneMinusCos * X * X, KOneMinusCos * X * Y + KSin * Z, KOneMinusCos * X * Z - KSin * Y, 0),
+			XMVectorSet(KOneMinusCos * X * Y - KSin * Z, KCos + KOneMinusCos * Y * Y, KOneMinusCos * Y * Z + KSin * X, 0),
+			XMVectorSet(KOneMinusCos * X * Z + KSin * Y, KOneMinusCos * Y * Z - KSin * X, KCos + KOneMinusCos * Z * Z, 0),
+			XMVectorSet(0, 0, 0, 1));
+	}
+	inline XMMATRIX XMMatrixRotationAxis(FXMVECTOR Axis, float Angle) { return XMMatrixRotationNormal(XMVector3Normalize(Axis), Angle); }
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR Quaternion)
+	{
+		const float X{ Quaternion.m128_f32[0] }, Y{ Quaternion.m128_f32[1] }, Z{ Quaternion.m128_f32[2] }, W{ Quaternion.m128_f32[3] };
+		return XMMATRIX(
+			XMVectorSet(1 - 2 * (Y * Y + Z * Z), 2 * (X * Y + Z * W), 2 * (X * Z - Y * W), 0),
+			XMVectorSet(2 * (X * Y - Z * W), 1 - 2 * (X * X + Z * Z), 2 * (Y * Z + X * W), 0),
+			XMVectorSet(2 * (X * Z + Y * W), 2 * (Y * Z - X * W), 1 - 2 * (X * X + Y * Y), 0),
+			XMVectorSet(0, 0, 0, 1));
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float FovAngleY, float AspectRatio, float NearZ, float FarZ)
+	{
+		const float KHeight{ cosf(0.5f * FovAngleY) / sinf(0.5f * FovAngleY) };
+		const float KWidth{ KHeight / AspectRatio };
+		const float KRange{ FarZ / (FarZ - NearZ) };
+		return XMMATRIX(XMVectorSet(KWidth, 0, 0, 0), XMVectorSet(0, KHeight, 0, 0), XMVectorSet(0, 0, KRange, 1),
+			XMVectorSet(0, 0, -KRange * NearZ, 0));
+	}
+	inline XMMATRIX XMMatrixOrthographicLH(float ViewWidth, float ViewHeight, float NearZ, float FarZ)
+	{
+		const float KRange{ 1.0f / (FarZ - NearZ) };
+		return XMMATRIX(XMVectorSet(2.0f / ViewWidth, 0, 0, 0), XMVectorSet(0, 2.0f / ViewHeight, 0, 0), XMVectorSet(0, 0, KRange, 0),
+			XMVectorSet(0, 0, -KRange * NearZ, 1));
+	}
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR EyePosition, FXMVECTOR EyeDirection, FXMVECTOR UpDirection)
+	{
+		const XMVECTOR KR2{ XMVector3Normalize(EyeDirection) };
+		const XMVECTOR KR0{ XMVector3Normalize(XMVector3Cross(UpDirection, KR2)) };
+		const XMVECTOR KR1{ XMVector3Cross(KR2, KR0) };
+		const XMVECTOR KNegEye{ XMVectorNegate(EyePosition) };
+		return XMMATRIX(
+			XMVectorSet(KR0.m128_f32[0], KR1.m128_f32[0], KR2.m128_f32[0], 0),
+			XMVectorSet(KR0.m128_f32[1], KR1.m128_f32[1], KR2.m128_f32[1], 0),
+			XMVectorSet(KR0.m128_f32[2], KR1.m128_f32[2], KR2.m128_f32[2], 0),
+			XMVectorSet(XMVectorGetX(XMVector3Dot(KR0, KNegEye)), XMVectorGetX(XMVector3Dot(KR1, KNegEye)),
+				XMVectorGetX(XMVector3Dot(KR2, KNegEye)), 1));
+	}
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR EyePosition, FXMVECTOR FocusPosition, FXMVECTOR UpDirection)
+	{
+		return XMMatrixLookToLH(EyePosition, XMVectorSubtract(FocusPosition, EyePosition), UpDirection);
+	}
+
+	// PtrDeterminant may be nullptr
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* const PtrDeterminant, FXMMATRIX M)
+	{
+		float m[16]{};
+		for (int iRow = 0; iRow < 4; ++iRow) memcpy(&m[iRow * 4], M.r[iRow].m128_f32, sizeof(float) * 4);
+
+		float Inverse[16]{};
+		Inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		Inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		Inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		Inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		Inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		Inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		Inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		Inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		Inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		Inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		Inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		Inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		Inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		Inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		Inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		Inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		const float KDeterminant{ m[0] * Inverse[0] + m[1] * Inverse[4] + m[2] * Inverse[8] + m[3] * Inverse[12] };
+		if (PtrDeterminant) *PtrDeterminant = XMVectorReplicate(KDeterminant);
+
+		const float KReciprocal{ 1.0f / KDeterminant };
+		XMMATRIX Result{};
+		for (int iRow = 0; iRow < 4; ++iRow)
+		{
+			Result.r[iRow] = XMVectorScale(XMVectorSet(Inverse[iRow * 4], Inverse[iRow * 4 + 1], Inverse[iRow * 4 + 2], Inverse[iRow * 4 + 3]), KReciprocal);
+		}
+		return Result;
+	}
+
+	namespace Colors
+	{
+		XMGLOBALCONST XMVECTORF32 Black{ { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+		XMGLOBALCONST XMVECTORF32 White{ { { 1.0f, 1.0f, 1.0f, 1.0f } } };
+		XMGLOBALCONST XMVECTORF32 Red{ { { 1.0f, 0.0f, 0.0f, 1.0f } } };
+		XMGLOBALCONST XMVECTORF32 Green{ { { 0.0f, 0.501960814f, 0.0f, 1.0f } } };
+		XMGLOBALCONST XMVECTORF32 Blue{ { { 0.0f, 0.0f, 1.0f, 1.0f } } };
+		XMGLOBALCONST XMVECTORF32 CornflowerBlue{ { { 0.392156899f, 0.584313750f, 0.929411829f, 1.0f } } };
+	}
+}
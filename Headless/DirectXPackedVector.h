@@ -0,0 +1,140 @@
+#pragma once
+
+// The subset of DirectXPackedVector that Core uses, for the headless (non-Windows) build
+
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		// 4 signed 16-bit normalized values
+		struct XMSHORTN4
+		{
+			int16_t	x;
+			int16_t	y;
+			int16_t	z;
+			int16_t	w;
+
+			XMSHORTN4() = default;
+			constexpr XMSHORTN4(int16_t _x, int16_t _y, int16_t _z, int16_t _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+		};
+
+		// 2 signed 16-bit normalized values
+		struct XMSHORTN2
+		{
+			int16_t	x;
+			int16_t	y;
+
+			XMSHORTN2() = default;
+			constexpr XMSHORTN2(int16_t _x, int16_t _y) : x{ _x }, y{ _y } {}
+		};
+
+		// 2 unsigned 16-bit normalized values
+		struct XMUSHORTN2
+		{
+			uint16_t	x;
+			uint16_t	y;
+
+			XMUSHORTN2() = default;
+			constexpr XMUSHORTN2(uint16_t _x, uint16_t _y) : x{ _x }, y{ _y } {}
+		};
+
+		// 4 unsigned 8-bit normalized values
+		struct XMUBYTEN4
+		{
+			uint8_t	x;
+			uint8_t	y;
+			uint8_t	z;
+			uint8_t	w;
+
+			XMUBYTEN4() = default;
+			constexpr XMUBYTEN4(uint8_t _x, uint8_t _y, uint8_t _z, uint8_t _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+			XMUBYTEN4(float _x, float _y, float _z, float _w);
+		};
+
+		// 4 unsigned 8-bit integers
+		struct XMUBYTE4
+		{
+			uint8_t	x;
+			uint8_t	y;
+			uint8_t	z;
+			uint8_t	w;
+
+			XMUBYTE4() = default;
+			constexpr XMUBYTE4(uint8_t _x, uint8_t _y, uint8_t _z, uint8_t _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+		};
+
+		namespace Internal
+		{
+			// Clamps, scales and rounds to nearest (even), like DirectXMath's stores
+			inline XMVECTOR Quantize(FXMVECTOR V, float Min, float Max, float Scale)
+			{
+				return XMVectorRound(XMVectorScale(XMVectorClamp(V, XMVectorReplicate(Min), XMVectorReplicate(Max)), Scale));
+			}
+		}
+
+		inline XMVECTOR XMLoadShortN4(const XMSHORTN4* const Source)
+		{
+			return XMVectorMax(XMVectorScale(XMVectorSet(Source->x, Source->y, Source->z, Source->w), 1.0f / 32767.0f), XMVectorReplicate(-1.0f));
+		}
+		inline XMVECTOR XMLoadShortN2(const XMSHORTN2* const Source)
+		{
+			return XMVectorMax(XMVectorScale(XMVectorSet(Source->x, Source->y, 0, 0), 1.0f / 32767.0f), XMVectorSet(-1.0f, -1.0f, 0, 0));
+		}
+		inline XMVECTOR XMLoadUShortN2(const XMUSHORTN2* const Source)
+		{
+			return XMVectorScale(XMVectorSet(Source->x, Source->y, 0, 0), 1.0f / 65535.0f);
+		}
+		inline XMVECTOR XMLoadUByteN4(const XMUBYTEN4* const Source)
+		{
+			return XMVectorScale(XMVectorSet(Source->x, Source->y, Source->z, Source->w), 1.0f / 255.0f);
+		}
+		inline XMVECTOR XMLoadUByte4(const XMUBYTE4* const Source)
+		{
+			return XMVectorSet(Source->x, Source->y, Source->z, Source->w);
+		}
+
+		inline void XMStoreShortN4(XMSHORTN4* const Destination, FXMVECTOR V)
+		{
+			const XMVECTOR KQuantized{ Internal::Quantize(V, -1.0f, 1.0f, 32767.0f) };
+			Destination->x = static_cast<int16_t>(KQuantized.m128_f32[0]);
+			Destination->y = static_cast<int16_t>(KQuantized.m128_f32[1]);
+			Destination->z = static_cast<int16_t>(KQuantized.m128_f32[2]);
+			Destination->w = static_cast<int16_t>(KQuantized.m128_f32[3]);
+		}
+		inline void XMStoreShortN2(XMSHORTN2* const Destination, FXMVECTOR V)
+		{
+			const XMVECTOR KQuantized{ Internal::Quantize(V, -1.0f, 1.0f, 32767.0f) };
+			Destination->x = static_cast<int16_t>(KQuantized.m128_f32[0]);
+			Destination->y = static_cast<int16_t>(KQuantized.m128_f32[1]);
+		}
+		inline void XMStoreUShortN2(XMUSHORTN2* const Destination, FXMVECTOR V)
+		{
+			const XMVECTOR KQuantized{ Internal::Quantize(V, 0.0f, 1.0f, 65535.0f) };
+			Destination->x = static_cast<uint16_t>(KQuantized.m128_f32[0]);
+			Destination->y = static_cast<uint16_t>(KQuantized.m128_f32[1]);
+		}
+		inline void XMStoreUByteN4(XMUBYTEN4* const Destination, FXMVECTOR V)
+		{
+			const XMVECTOR KQuantized{ Internal::Quantize(V, 0.0f, 1.0f, 255.0f) };
+			Destination->x = static_cast<uint8_t>(KQuantized.m128_f32[0]);
+			Destination->y = static_cast<uint8_t>(KQuantized.m128_f32[1]);
+			Destination->z = static_cast<uint8_t>(KQuantized.m128_f32[2]);
+			Destination->w = static_cast<uint8_t>(KQuantized.m128_f32[3]);
+		}
+		inline void XMStoreUByte4(XMUBYTE4* const Destination, FXMVECTOR V)
+		{
+			const XMVECTOR KQuantized{ Internal::Quantize(V, 0.0f, 255.0f, 1.0f) };
+			Destination->x = static_cast<uint8_t>(KQuantized.m128_f32[0]);
+			Destination->y = static_cast<uint8_t>(KQuantized.m128_f32[1]);
+			Destination->z = static_cast<uint8_t>(KQuantized.m128_f32[2]);
+			Destination->w = static_cast<uint8_t>(KQuantized.m128_f32[3]);
+		}
+
+		inline XMUBYTEN4::XMUBYTEN4(float _x, float _y, float _z, float _w)
+		{
+			XMStoreUByteN4(this, XMVectorSet(_x, _y, _z, _w));
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Stands in for DirectXTK/DirectXTK.h in the headless (non-Windows) build, which needs DirectXMath and idle input devices from it
+
+#include "DirectXMath.h"
+#include "Windows.h"
+
+namespace DirectX
+{
+	// Nothing is ever pressed
+	class Keyboard
+	{
+	public:
+		struct State
+		{
+			bool IsKeyDown(int) const { return false; }
+			bool IsKeyUp(int) const { return true; }
+		};
+
+	public:
+		State GetState() const { return State(); }
+	};
+
+	// Stays where it is with no buttons down
+	class Mouse
+	{
+	public:
+		enum class Mode
+		{
+			MODE_ABSOLUTE,
+			MODE_RELATIVE
+		};
+
+		struct State
+		{
+			bool leftButton{};
+			bool middleButton{};
+			bool rightButton{};
+			bool xButton1{};
+			bool xButton2{};
+			int x{};
+			int y{};
+			int scrollWheelValue{};
+			Mode positionMode{ Mode::MODE_ABSOLUTE };
+		};
+
+	public:
+		State GetState() const { return State(); }
+		void SetWindow(HWND) {}
+		void SetMode(Mode) {}
+		void ResetScrollWheelValue() {}
+	};
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+// The subset of the Win32 API that Core uses, for the headless (non-Windows) build
+// @important: only included when _WIN32 is not defined (CMakeLists.txt puts this directory on the include path)
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned char UINT8;
+typedef int INT;
+typedef unsigned int UINT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef unsigned long long ULONGLONG;
+typedef long long LONGLONG;
+typedef float FLOAT;
+typedef int32_t HRESULT;
+typedef const char* LPCSTR;
+typedef char* LPSTR;
+typedef const char* LPCTSTR;
+typedef intptr_t LRESULT;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef void* HANDLE;
+typedef struct HWND__* HWND;
+typedef struct HINSTANCE__* HINSTANCE;
+typedef LRESULT(*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+
+struct GUID
+{
+	uint32_t	Data1;
+	uint16_t	Data2;
+	uint16_t	Data3;
+	uint8_t		Data4[8];
+};
+typedef const GUID& REFGUID;
+typedef const GUID& REFIID;
+
+#define TRUE 1
+#define FALSE 0
+#define STDMETHODCALLTYPE
+#define WINAPI
+#define CALLBACK
+#define TEXT(Text) Text
+
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#define S_OK static_cast<HRESULT>(0)
+#define S_FALSE static_cast<HRESULT>(1)
+#define E_FAIL static_cast<HRESULT>(0x80004005)
+#define E_NOINTERFACE static_cast<HRESULT>(0x80004002)
+#define E_INVALIDARG static_cast<HRESULT>(0x80070057)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000E)
+
+#define MB_OK 0x0
+#define MB_ICONERROR 0x10
+#define MB_ICONEXCLAMATION 0x30
+#define MB_ICONINFORMATION 0x40
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define MAX_PATH 260
+#define ARRAYSIZE(Array) (sizeof(Array) / sizeof(Array[0]))
+
+inline ULONGLONG GetTickCount64()
+{
+	return static_cast<ULONGLONG>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Debug output and message boxes go to stderr, since there is neither a debugger nor a window
+inline void OutputDebugStringA(LPCSTR OutputString) { fputs(OutputString, stderr); }
+#define OutputDebugString OutputDebugStringA
+
+inline int MessageBoxA(HWND, LPCSTR Text, LPCSTR Caption, UINT)
+{
+	fprintf(stderr, "[%s] %s\n", (Caption) ? Caption : "", (Text) ? Text : "");
+	return 1;
+}
+#define MessageBox MessageBoxA
+
+inline BOOL CreateDirectoryA(LPCSTR PathName, void*) { return (mkdir(PathName, 0755) == 0) ? TRUE : FALSE; }
+inline BOOL DeleteFileA(LPCSTR FileName) { return (remove(FileName) == 0) ? TRUE : FALSE; }
+inline BOOL MoveFileExA(LPCSTR ExistingFileName, LPCSTR NewFileName, DWORD) { return (rename(ExistingFileName, NewFileName) == 0) ? TRUE : FALSE; }
+inline DWORD GetCurrentDirectoryA(DWORD BufferLength, LPSTR Buffer)
+{
+	if (!getcwd(Buffer, BufferLength)) return 0;
+	return static_cast<DWORD>(strlen(Buffer));
+}
+
+template <size_t Size, typename... TArgs>
+inline int sprintf_s(char(&Buffer)[Size], const char* const Format, TArgs... Args)
+{
+	return snprintf(Buffer, Size, Format, Args...);
+}
+
+inline void* _aligned_malloc(size_t Size, size_t Alignment)
+{
+	void* Result{};
+	if (posix_memalign(&Result, (Alignment < sizeof(void*)) ? sizeof(void*) : Alignment, Size) != 0) return nullptr;
+	return Result;
+}
+inline void _aligned_free(void* const Memory) { free(Memory); }
@@ -0,0 +1,603 @@
+#pragma once
+
+// The subset of the D3D11 API that Core uses, for the headless (non-Windows) build
+// Interfaces have the SDK's methods (in the SDK's order), so that the objects CRenderDeviceNull creates implement them on every platform
+// ID3D11Device, ID3D11DeviceContext and IDXGISwapChain have none: headless code creates and draws through CRenderDevice
+
+#include "Windows.h"
+
+// ###########################
+// << DXGI >>
+// ###########################
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_TYPELESS = 1,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_TYPELESS = 5,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_TYPELESS = 9,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_TYPELESS = 15,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R32G8X24_TYPELESS = 19,
+	DXGI_FORMAT_D32_FLOAT_S8X24_UINT = 20,
+	DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21,
+	DXGI_FORMAT_X32_TYPELESS_G8X24_UINT = 22,
+	DXGI_FORMAT_R10G10B10A2_TYPELESS = 23,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R10G10B10A2_UINT = 25,
+	DXGI_FORMAT_R11G11B10_FLOAT = 26,
+	DXGI_FORMAT_R8G8B8A8_TYPELESS = 27,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+	DXGI_FORMAT_R8G8B8A8_SINT = 32,
+	DXGI_FORMAT_R16G16_TYPELESS = 33,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_UINT = 36,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R16G16_SINT = 38,
+	DXGI_FORMAT_R32_TYPELESS = 39,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_R24G8_TYPELESS = 44,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+	DXGI_FORMAT_X24_TYPELESS_G8_UINT = 47,
+	DXGI_FORMAT_R8G8_TYPELESS = 48,
+	DXGI_FORMAT_R8G8_UNORM = 49,
+	DXGI_FORMAT_R8G8_UINT = 50,
+	DXGI_FORMAT_R8G8_SNORM = 51,
+	DXGI_FORMAT_R8G8_SINT = 52,
+	DXGI_FORMAT_R16_TYPELESS = 53,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_D16_UNORM = 55,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R16_SNORM = 58,
+	DXGI_FORMAT_R16_SINT = 59,
+	DXGI_FORMAT_R8_TYPELESS = 60,
+	DXGI_FORMAT_R8_UNORM = 61,
+	DXGI_FORMAT_R8_UINT = 62,
+	DXGI_FORMAT_R8_SNORM = 63,
+	DXGI_FORMAT_R8_SINT = 64,
+	DXGI_FORMAT_A8_UNORM = 65,
+	DXGI_FORMAT_R1_UNORM = 66,
+	DXGI_FORMAT_R9G9B9E5_SHAREDEXP = 67,
+	DXGI_FORMAT_R8G8_B8G8_UNORM = 68,
+	DXGI_FORMAT_G8R8_G8B8_UNORM = 69,
+	DXGI_FORMAT_BC1_TYPELESS = 70,
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+	DXGI_FORMAT_BC2_TYPELESS = 73,
+	DXGI_FORMAT_BC2_UNORM = 74,
+	DXGI_FORMAT_BC2_UNORM_SRGB = 75,
+	DXGI_FORMAT_BC3_TYPELESS = 76,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+	DXGI_FORMAT_BC4_TYPELESS = 79,
+	DXGI_FORMAT_BC4_UNORM = 80,
+	DXGI_FORMAT_BC4_SNORM = 81,
+	DXGI_FORMAT_BC5_TYPELESS = 82,
+	DXGI_FORMAT_BC5_UNORM = 83,
+	DXGI_FORMAT_BC5_SNORM = 84,
+	DXGI_FORMAT_B5G6R5_UNORM = 85,
+	DXGI_FORMAT_B5G5R5A1_UNORM = 86,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+	DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+	DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM = 89,
+	DXGI_FORMAT_B8G8R8A8_TYPELESS = 90,
+	DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+	DXGI_FORMAT_B8G8R8X8_TYPELESS = 92,
+	DXGI_FORMAT_B8G8R8X8_UNORM_SRGB = 93,
+	DXGI_FORMAT_BC6H_TYPELESS = 94,
+	DXGI_FORMAT_BC6H_UF16 = 95,
+	DXGI_FORMAT_BC6H_SF16 = 96,
+	DXGI_FORMAT_BC7_TYPELESS = 97,
+	DXGI_FORMAT_BC7_UNORM = 98,
+	DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT	Count;
+	UINT	Quality;
+};
+
+// ###########################
+// << CONSTANTS AND ENUMS >>
+// ###########################
+
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT 4096
+#define D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION 16384
+#define D3D11_REQ_MIP_LEVELS 15
+#define D3D11_MAX_MAXANISOTROPY 16
+#define D3D11_FLOAT32_MAX 3.402823466e+38f
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D11_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D11_DEFAULT_STENCIL_WRITE_MASK 0xff
+
+enum D3D11_USAGE
+{
+	D3D11_USAGE_DEFAULT = 0,
+	D3D11_USAGE_IMMUTABLE = 1,
+	D3D11_USAGE_DYNAMIC = 2,
+	D3D11_USAGE_STAGING = 3,
+};
+
+enum D3D11_BIND_FLAG
+{
+	D3D11_BIND_VERTEX_BUFFER = 0x1,
+	D3D11_BIND_INDEX_BUFFER = 0x2,
+	D3D11_BIND_CONSTANT_BUFFER = 0x4,
+	D3D11_BIND_SHADER_RESOURCE = 0x8,
+	D3D11_BIND_STREAM_OUTPUT = 0x10,
+	D3D11_BIND_RENDER_TARGET = 0x20,
+	D3D11_BIND_DEPTH_STENCIL = 0x40,
+	D3D11_BIND_UNORDERED_ACCESS = 0x80,
+};
+
+enum D3D11_CPU_ACCESS_FLAG
+{
+	D3D11_CPU_ACCESS_WRITE = 0x10000,
+	D3D11_CPU_ACCESS_READ = 0x20000,
+};
+
+enum D3D11_RESOURCE_MISC_FLAG
+{
+	D3D11_RESOURCE_MISC_GENERATE_MIPS = 0x1,
+	D3D11_RESOURCE_MISC_TEXTURECUBE = 0x4,
+	D3D11_RESOURCE_MISC_RESOURCE_CLAMP = 0x800,
+};
+
+enum D3D11_MAP
+{
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5,
+};
+
+enum D3D11_CLEAR_FLAG
+{
+	D3D11_CLEAR_DEPTH = 0x1,
+	D3D11_CLEAR_STENCIL = 0x2,
+};
+
+enum D3D11_RESOURCE_DIMENSION
+{
+	D3D11_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D11_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D11_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D11_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D11_RESOURCE_DIMENSION_TEXTURE3D = 4,
+};
+
+enum D3D11_SRV_DIMENSION
+{
+	D3D11_SRV_DIMENSION_UNKNOWN = 0,
+	D3D11_SRV_DIMENSION_BUFFER = 1,
+	D3D11_SRV_DIMENSION_TEXTURE2D = 4,
+	D3D11_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+	D3D11_SRV_DIMENSION_TEXTURE2DMS = 6,
+	D3D11_SRV_DIMENSION_TEXTURECUBE = 9,
+};
+
+enum D3D11_RTV_DIMENSION
+{
+	D3D11_RTV_DIMENSION_UNKNOWN = 0,
+	D3D11_RTV_DIMENSION_TEXTURE2D = 4,
+	D3D11_RTV_DIMENSION_TEXTURE2DMS = 6,
+};
+
+enum D3D11_DSV_DIMENSION
+{
+	D3D11_DSV_DIMENSION_UNKNOWN = 0,
+	D3D11_DSV_DIMENSION_TEXTURE2D = 3,
+	D3D11_DSV_DIMENSION_TEXTURE2DMS = 5,
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+	D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST = 35,
+	D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST = 36,
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1,
+};
+
+enum D3D11_FILTER
+{
+	D3D11_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D11_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D11_FILTER_ANISOTROPIC = 0x55,
+};
+
+enum D3D11_TEXTURE_ADDRESS_MODE
+{
+	D3D11_TEXTURE_ADDRESS_WRAP = 1,
+	D3D11_TEXTURE_ADDRESS_MIRROR = 2,
+	D3D11_TEXTURE_ADDRESS_CLAMP = 3,
+	D3D11_TEXTURE_ADDRESS_BORDER = 4,
+	D3D11_TEXTURE_ADDRESS_MIRROR_ONCE = 5,
+};
+
+enum D3D11_COMPARISON_FUNC
+{
+	D3D11_COMPARISON_NEVER = 1,
+	D3D11_COMPARISON_LESS = 2,
+	D3D11_COMPARISON_EQUAL = 3,
+	D3D11_COMPARISON_LESS_EQUAL = 4,
+	D3D11_COMPARISON_GREATER = 5,
+	D3D11_COMPARISON_NOT_EQUAL = 6,
+	D3D11_COMPARISON_GREATER_EQUAL = 7,
+	D3D11_COMPARISON_ALWAYS = 8,
+};
+
+enum D3D11_DEPTH_WRITE_MASK
+{
+	D3D11_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D11_DEPTH_WRITE_MASK_ALL = 1,
+};
+
+enum D3D11_STENCIL_OP
+{
+	D3D11_STENCIL_OP_KEEP = 1,
+	D3D11_STENCIL_OP_ZERO = 2,
+	D3D11_STENCIL_OP_REPLACE = 3,
+};
+
+enum D3D11_FILL_MODE
+{
+	D3D11_FILL_WIREFRAME = 2,
+	D3D11_FILL_SOLID = 3,
+};
+
+enum D3D11_CULL_MODE
+{
+	D3D11_CULL_NONE = 1,
+	D3D11_CULL_FRONT = 2,
+	D3D11_CULL_BACK = 3,
+};
+
+enum D3D11_BLEND
+{
+	D3D11_BLEND_ZERO = 1,
+	D3D11_BLEND_ONE = 2,
+	D3D11_BLEND_SRC_COLOR = 3,
+	D3D11_BLEND_INV_SRC_COLOR = 4,
+	D3D11_BLEND_SRC_ALPHA = 5,
+	D3D11_BLEND_INV_SRC_ALPHA = 6,
+	D3D11_BLEND_DEST_ALPHA = 7,
+	D3D11_BLEND_INV_DEST_ALPHA = 8,
+	D3D11_BLEND_DEST_COLOR = 9,
+	D3D11_BLEND_INV_DEST_COLOR = 10,
+};
+
+enum D3D11_BLEND_OP
+{
+	D3D11_BLEND_OP_ADD = 1,
+	D3D11_BLEND_OP_SUBTRACT = 2,
+	D3D11_BLEND_OP_REV_SUBTRACT = 3,
+	D3D11_BLEND_OP_MIN = 4,
+	D3D11_BLEND_OP_MAX = 5,
+};
+
+enum D3D11_COLOR_WRITE_ENABLE
+{
+	D3D11_COLOR_WRITE_ENABLE_ALL = 0xf,
+};
+
+// ###########################
+// << DESCRIPTIONS >>
+// ###########################
+
+struct D3D11_BOX
+{
+	UINT	left;
+	UINT	top;
+	UINT	front;
+	UINT	right;
+	UINT	bottom;
+	UINT	back;
+};
+
+struct D3D11_VIEWPORT
+{
+	FLOAT	TopLeftX;
+	FLOAT	TopLeftY;
+	FLOAT	Width;
+	FLOAT	Height;
+	FLOAT	MinDepth;
+	FLOAT	MaxDepth;
+};
+
+struct D3D11_SUBRESOURCE_DATA
+{
+	const void*	pSysMem;
+	UINT		SysMemPitch;
+	UINT		SysMemSlicePitch;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+	void*	pData;
+	UINT	RowPitch;
+	UINT	DepthPitch;
+};
+
+struct D3D11_BUFFER_DESC
+{
+	UINT		ByteWidth;
+	D3D11_USAGE	Usage;
+	UINT		BindFlags;
+	UINT		CPUAccessFlags;
+	UINT		MiscFlags;
+	UINT		StructureByteStride;
+};
+
+struct D3D11_TEXTURE2D_DESC
+{
+	UINT				Width;
+	UINT				Height;
+	UINT				MipLevels;
+	UINT				ArraySize;
+	DXGI_FORMAT			Format;
+	DXGI_SAMPLE_DESC	SampleDesc;
+	D3D11_USAGE			Usage;
+	UINT				BindFlags;
+	UINT				CPUAccessFlags;
+	UINT				MiscFlags;
+};
+
+struct D3D11_TEX2D_SRV
+{
+	UINT	MostDetailedMip;
+	UINT	MipLevels;
+};
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC
+{
+	DXGI_FORMAT			Format;
+	D3D11_SRV_DIMENSION	ViewDimension;
+	union
+	{
+		D3D11_TEX2D_SRV	Texture2D;
+	};
+};
+
+struct D3D11_TEX2D_RTV
+{
+	UINT	MipSlice;
+};
+
+struct D3D11_RENDER_TARGET_VIEW_DESC
+{
+	DXGI_FORMAT			Format;
+	D3D11_RTV_DIMENSION	ViewDimension;
+	union
+	{
+		D3D11_TEX2D_RTV	Texture2D;
+	};
+};
+
+struct D3D11_TEX2D_DSV
+{
+	UINT	MipSlice;
+};
+
+struct D3D11_DEPTH_STENCIL_VIEW_DESC
+{
+	DXGI_FORMAT			Format;
+	D3D11_DSV_DIMENSION	ViewDimension;
+	UINT				Flags;
+	union
+	{
+		D3D11_TEX2D_DSV	Texture2D;
+	};
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	LPCSTR						SemanticName;
+	UINT						SemanticIndex;
+	DXGI_FORMAT					Format;
+	UINT						InputSlot;
+	UINT						AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION	InputSlotClass;
+	UINT						InstanceDataStepRate;
+};
+
+struct D3D11_SAMPLER_DESC
+{
+	D3D11_FILTER				Filter;
+	D3D11_TEXTURE_ADDRESS_MODE	AddressU;
+	D3D11_TEXTURE_ADDRESS_MODE	AddressV;
+	D3D11_TEXTURE_ADDRESS_MODE	AddressW;
+	FLOAT						MipLODBias;
+	UINT						MaxAnisotropy;
+	D3D11_COMPARISON_FUNC		ComparisonFunc;
+	FLOAT						BorderColor[4];
+	FLOAT						MinLOD;
+	FLOAT						MaxLOD;
+};
+
+struct D3D11_RASTERIZER_DESC
+{
+	D3D11_FILL_MODE	FillMode;
+	D3D11_CULL_MODE	CullMode;
+	BOOL			FrontCounterClockwise;
+	INT				DepthBias;
+	FLOAT			DepthBiasClamp;
+	FLOAT			SlopeScaledDepthBias;
+	BOOL			DepthClipEnable;
+	BOOL			ScissorEnable;
+	BOOL			MultisampleEnable;
+	BOOL			AntialiasedLineEnable;
+};
+
+struct D3D11_DEPTH_STENCILOP_DESC
+{
+	D3D11_STENCIL_OP		StencilFailOp;
+	D3D11_STENCIL_OP		StencilDepthFailOp;
+	D3D11_STENCIL_OP		StencilPassOp;
+	D3D11_COMPARISON_FUNC	StencilFunc;
+};
+
+struct D3D11_DEPTH_STENCIL_DESC
+{
+	BOOL						DepthEnable;
+	D3D11_DEPTH_WRITE_MASK		DepthWriteMask;
+	D3D11_COMPARISON_FUNC		DepthFunc;
+	BOOL						StencilEnable;
+	UINT8						StencilReadMask;
+	UINT8						StencilWriteMask;
+	D3D11_DEPTH_STENCILOP_DESC	FrontFace;
+	D3D11_DEPTH_STENCILOP_DESC	BackFace;
+};
+
+struct D3D11_RENDER_TARGET_BLEND_DESC
+{
+	BOOL			BlendEnable;
+	D3D11_BLEND		SrcBlend;
+	D3D11_BLEND		DestBlend;
+	D3D11_BLEND_OP	BlendOp;
+	D3D11_BLEND		SrcBlendAlpha;
+	D3D11_BLEND		DestBlendAlpha;
+	D3D11_BLEND_OP	BlendOpAlpha;
+	UINT8			RenderTargetWriteMask;
+};
+
+struct D3D11_BLEND_DESC
+{
+	BOOL							AlphaToCoverageEnable;
+	BOOL							IndependentBlendEnable;
+	D3D11_RENDER_TARGET_BLEND_DESC	RenderTarget[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+};
+
+inline UINT D3D11CalcSubresource(UINT MipSlice, UINT ArraySlice, UINT MipLevels)
+{
+	return MipSlice + ArraySlice * MipLevels;
+}
+
+// ###########################
+// << INTERFACES >>
+// ###########################
+
+struct IUnknown
+{
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+	virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
+
+struct ID3D11Device : public IUnknown {};
+struct ID3D11DeviceContext;
+
+struct ID3D11DeviceChild : public IUnknown
+{
+	virtual void STDMETHODCALLTYPE GetDevice(ID3D11Device** ppDevice) = 0;
+	virtual HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) = 0;
+};
+
+struct ID3D11DeviceContext : public ID3D11DeviceChild {};
+struct ID3D11CommandList : public ID3D11DeviceChild {};
+
+struct ID3D11Resource : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) = 0;
+	virtual void STDMETHODCALLTYPE SetEvictionPriority(UINT EvictionPriority) = 0;
+	virtual UINT STDMETHODCALLTYPE GetEvictionPriority() = 0;
+};
+
+struct ID3D11Buffer : public ID3D11Resource
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_BUFFER_DESC* pDesc) = 0;
+};
+
+struct ID3D11Texture2D : public ID3D11Resource
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_TEXTURE2D_DESC* pDesc) = 0;
+};
+
+struct ID3D11View : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetResource(ID3D11Resource** ppResource) = 0;
+};
+
+struct ID3D11ShaderResourceView : public ID3D11View
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc) = 0;
+};
+
+struct ID3D11RenderTargetView : public ID3D11View
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_RENDER_TARGET_VIEW_DESC* pDesc) = 0;
+};
+
+struct ID3D11DepthStencilView : public ID3D11View
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_DEPTH_STENCIL_VIEW_DESC* pDesc) = 0;
+};
+
+struct ID3D11VertexShader : public ID3D11DeviceChild {};
+struct ID3D11HullShader : public ID3D11DeviceChild {};
+struct ID3D11DomainShader : public ID3D11DeviceChild {};
+struct ID3D11GeometryShader : public ID3D11DeviceChild {};
+struct ID3D11PixelShader : public ID3D11DeviceChild {};
+struct ID3D11InputLayout : public ID3D11DeviceChild {};
+
+struct ID3D11SamplerState : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_SAMPLER_DESC* pDesc) = 0;
+};
+
+struct ID3D11RasterizerState : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_RASTERIZER_DESC* pDesc) = 0;
+};
+
+struct ID3D11DepthStencilState : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_DEPTH_STENCIL_DESC* pDesc) = 0;
+};
+
+struct ID3D11BlendState : public ID3D11DeviceChild
+{
+	virtual void STDMETHODCALLTYPE GetDesc(D3D11_BLEND_DESC* pDesc) = 0;
+};
+
+struct IDXGISwapChain : public IUnknown {};
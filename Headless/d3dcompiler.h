@@ -0,0 +1,16 @@
+#pragma once
+
+// Stands in for <d3dcompiler.h> in the headless (non-Windows) build, which only needs the compile flags (they are part of shader cache keys)
+// @important: there's no D3DCompile() here, so CShaderCompilerD3D isn't built; headless shaders are created through CShaderCache
+
+#define D3DCOMPILE_DEBUG						(1 << 0)
+#define D3DCOMPILE_SKIP_VALIDATION				(1 << 1)
+#define D3DCOMPILE_SKIP_OPTIMIZATION			(1 << 2)
+#define D3DCOMPILE_PACK_MATRIX_ROW_MAJOR		(1 << 3)
+#define D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR		(1 << 4)
+#define D3DCOMPILE_ENABLE_STRICTNESS			(1 << 11)
+#define D3DCOMPILE_OPTIMIZATION_LEVEL0			(1 << 14)
+#define D3DCOMPILE_OPTIMIZATION_LEVEL1			0
+#define D3DCOMPILE_OPTIMIZATION_LEVEL2			((1 << 14) | (1 << 15))
+#define D3DCOMPILE_OPTIMIZATION_LEVEL3			(1 << 15)
+#define D3DCOMPILE_WARNINGS_ARE_ERRORS			(1 << 18)
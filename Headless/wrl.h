@@ -0,0 +1,77 @@
+#pragma once
+
+// Microsoft::WRL::ComPtr for the headless (non-Windows) build
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Microsoft
+{
+	namespace WRL
+	{
+		template <typename T>
+		class ComPtr
+		{
+			template <typename U> friend class ComPtr;
+
+		public:
+			typedef T InterfaceType;
+
+		public:
+			ComPtr() {}
+			ComPtr(std::nullptr_t) {}
+			ComPtr(T* const Other) : m_Ptr{ Other } { InternalAddRef(); }
+			ComPtr(const ComPtr& Other) : m_Ptr{ Other.m_Ptr } { InternalAddRef(); }
+			ComPtr(ComPtr&& Other) : m_Ptr{ Other.m_Ptr } { Other.m_Ptr = nullptr; }
+			template <typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+			ComPtr(const ComPtr<U>& Other) : m_Ptr{ Other.m_Ptr } { InternalAddRef(); }
+			~ComPtr() { InternalRelease(); }
+
+			ComPtr& operator=(std::nullptr_t) { InternalRelease(); return *this; }
+			ComPtr& operator=(T* const Other) { ComPtr(Other).Swap(*this); return *this; }
+			ComPtr& operator=(const ComPtr& Other) { ComPtr(Other).Swap(*this); return *this; }
+			ComPtr& operator=(ComPtr&& Other) { ComPtr(std::move(Other)).Swap(*this); return *this; }
+
+		public:
+			T* Get() const { return m_Ptr; }
+			T* const* GetAddressOf() const { return &m_Ptr; }
+			T** GetAddressOf() { return &m_Ptr; }
+			T** ReleaseAndGetAddressOf() { InternalRelease(); return &m_Ptr; }
+			T** operator&() { return ReleaseAndGetAddressOf(); }
+			T* operator->() const { return m_Ptr; }
+			explicit operator bool() const { return m_Ptr != nullptr; }
+
+			void Attach(T* const Other) { InternalRelease(); m_Ptr = Other; }
+			T* Detach() { T* const Result{ m_Ptr }; m_Ptr = nullptr; return Result; }
+			unsigned long Reset() { return InternalRelease(); }
+			void Swap(ComPtr& Other) { std::swap(m_Ptr, Other.m_Ptr); }
+
+		private:
+			void InternalAddRef() const { if (m_Ptr) m_Ptr->AddRef(); }
+			unsigned long InternalRelease()
+			{
+				unsigned long RefCount{};
+				T* const Temp{ m_Ptr };
+				if (Temp)
+				{
+					m_Ptr = nullptr;
+					RefCount = Temp->Release();
+				}
+				return RefCount;
+			}
+
+		private:
+			T*	m_Ptr{};
+		};
+
+		template <typename T, typename U>
+		bool operator==(const ComPtr<T>& A, const ComPtr<U>& B) { return A.Get() == B.Get(); }
+		template <typename T>
+		bool operator==(const ComPtr<T>& A, std::nullptr_t) { return A.Get() == nullptr; }
+		template <typename T, typename U>
+		bool operator!=(const ComPtr<T>& A, const ComPtr<U>& B) { return A.Get() != B.Get(); }
+		template <typename T>
+		bool operator!=(const ComPtr<T>& A, std::nullptr_t) { return A.Get() != nullptr; }
+	}
+}
@@ -1,16 +1,12 @@
 #include "Header.hlsli"
 
+// Variants (CShaderPermutationSet): USE_DISPLACEMENT
+
 cbuffer cbSpace : register(b0)
 {
 	float4x4 ViewProjection;
 }
 
-cbuffer cbDisplacement : register(b1)
-{
-	bool UseDisplacement;
-	float3 Pads;
-}
-
 SamplerState CurrentSampler : register(s0);
 Texture2D DisplacementTexture : register(t0);
 
@@ -37,12 +33,11 @@ DS_OUTPUT main(HS_CONSTANT_DATA_OUTPUT TessFactors, float3 Domain : SV_DomainLoc
 	const float KDisplacementFactor = 0.1f;
 	float4 Bezier = GetBezier(P1, P2, P3, N1, N2, N3, Domain);
 	
-	if (UseDisplacement)
-	{
-		float Displacement = DisplacementTexture.SampleLevel(CurrentSampler, Output.UV.xy, 0).r;
-		Bezier += Output.WorldNormal * Displacement * KDisplacementFactor;
-		Bezier.y -= KDisplacementFactor;
-	}
+#if USE_DISPLACEMENT
+	float Displacement = DisplacementTexture.SampleLevel(CurrentSampler, Output.UV.xy, 0).r;
+	Bezier += Output.WorldNormal * Displacement * KDisplacementFactor;
+	Bezier.y -= KDisplacementFactor;
+#endif
 
 	Output.Position = Output.WorldPosition = Bezier;
 
@@ -8,28 +8,47 @@ cbuffer cbCamera : register(b0)
 cbuffer cbTessFactor : register(b1)
 {
 	float TessFactor;
-	float3 Pads;
+	float TessPixelError;
+	float ProjectionScale; // Pixels per world unit at a distance of 1
+	float Pad;
+	float2 TerrainSize;
+	float2 Pads;
+}
+
+// World error of the patches around each height map texel (CPatchErrorEstimator)
+Texture2D<float> PatchErrorTexture : register(t0);
+
+float GetPatchError(float4 WorldPosition)
+{
+	// Patch vertices are on height map texels (the terrain isn't transformed)
+	int2 Texel = int2(round(float2(WorldPosition.x + TerrainSize.x / 2.0f, -WorldPosition.z + TerrainSize.y / 2.0f)));
+	return PatchErrorTexture.Load(int3(clamp(Texel, int2(0, 0), int2(TerrainSize)), 0));
+}
+
+// An edge's factor depends only on its 2 vertices, so the patches on both of its sides agree and there are no cracks
+float CalcEdgeTessFactor(float4 WorldPositionA, float4 WorldPositionB, float ErrorA, float ErrorB)
+{
+	float Distance = max(distance((WorldPositionA.xyz + WorldPositionB.xyz) * 0.5f, EyePosition.xyz), 1.0f);
+	float PixelError = max(ErrorA, ErrorB) * ProjectionScale / Distance;
+
+	// Subdividing a curved patch n times shrinks its error by n^2
+	return clamp(sqrt(PixelError / TessPixelError), 1.0f, TessFactor);
 }
 
 HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(InputPatch<VS_OUTPUT, 3> Patch, uint PatchID : SV_PrimitiveID)
 {
 	HS_CONSTANT_DATA_OUTPUT Output;
 
-	const float KDistanceThreshold = 15.0f;
-	const float KEdgeMax = 0.5f * TessFactor;
-	const float KInsideMax = 1.0f * TessFactor;
-	float4 CenterPosition = (Patch[0].WorldPosition + Patch[1].WorldPosition + Patch[2].WorldPosition) / 3.0f;
-	float Distance = distance(CenterPosition, EyePosition);
-	float ThresholdDistance = max(Distance - KDistanceThreshold, 1.0f);
-	float Edge = KEdgeMax;
-	float Inside = KInsideMax / ThresholdDistance;
-	if (Distance <= KDistanceThreshold) Inside = KInsideMax;
-
-	Output.EdgeTessFactor[0] = Edge;
-	Output.EdgeTessFactor[1] = Edge;
-	Output.EdgeTessFactor[2] = Edge;
-
-	Output.InsideTessFactor = Inside;
+	float Error0 = GetPatchError(Patch[0].WorldPosition);
+	float Error1 = GetPatchError(Patch[1].WorldPosition);
+	float Error2 = GetPatchError(Patch[2].WorldPosition);
+
+	// Edge i is opposite to vertex i
+	Output.EdgeTessFactor[0] = CalcEdgeTessFactor(Patch[1].WorldPosition, Patch[2].WorldPosition, Error1, Error2);
+	Output.EdgeTessFactor[1] = CalcEdgeTessFactor(Patch[2].WorldPosition, Patch[0].WorldPosition, Error2, Error0);
+	Output.EdgeTessFactor[2] = CalcEdgeTessFactor(Patch[0].WorldPosition, Patch[1].WorldPosition, Error0, Error1);
+
+	Output.InsideTessFactor = max(Output.EdgeTessFactor[0], max(Output.EdgeTessFactor[1], Output.EdgeTessFactor[2]));
 	
 	return Output;
 }
@@ -38,7 +57,7 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(InputPatch<VS_OUTPUT, 3> Patch, uin
 [maxtessfactor(64.0f)]
 [outputcontrolpoints(3)]
 [outputtopology("triangle_cw")]
-[partitioning("fractional_even")]
+[partitioning("fractional_odd")] // A factor of 1 keeps a flat patch 1 triangle
 [patchconstantfunc("CalcHSPatchConstants")]
 HS_OUTPUT main(InputPatch<VS_OUTPUT, 3> Patch, uint i : SV_OutputControlPointID, uint PatchID : SV_PrimitiveID )
 {
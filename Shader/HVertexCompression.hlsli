@@ -0,0 +1,88 @@
+#include "Header.hlsli"
+
+// Matches SVertex3DCompressed and SVertexAnimationCompressed (see CVertexCompressor::KInputElementDescs)
+struct VS_INPUT_COMPRESSED
+{
+	float4 Position		: POSITION; // xyz: [-1, 1] within the model's bounds, w: bitangent sign
+	float2 Normal		: NORMAL; // Octahedral
+	float2 Tangent		: TANGENT; // Octahedral
+	float2 UV			: TEXCOORD; // [0, 1] within the model's texture coordinate bounds
+	float4 Color		: COLOR;
+
+	// Instance
+	float4 InstanceWorld0	: INSTANCEWORLD0;
+	float4 InstanceWorld1	: INSTANCEWORLD1;
+	float4 InstanceWorld2	: INSTANCEWORLD2;
+	float4 InstanceWorld3	: INSTANCEWORLD3;
+};
+
+struct VS_INPUT_ANIMATION_COMPRESSED
+{
+	float4	Position	: POSITION;
+	float2	Normal		: NORMAL;
+	float2	Tangent		: TANGENT;
+	float2	UV			: TEXCOORD;
+	float4	Color		: COLOR;
+
+	uint4	BoneIndex	: BLENDINDICES;
+	float4	BoneWeight	: BLENDWEIGHT;
+};
+
+struct SVertexQuantization
+{
+	float4 PositionCenter;
+	float4 PositionExtent;
+	float4 TexCoordOffsetScale; // xy: offset, zw: scale
+};
+
+static float3 DecodeOctahedral(float2 Encoded)
+{
+	float3 Result = float3(Encoded.xy, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+	float T = saturate(-Result.z);
+	Result.xy += (Result.xy >= 0.0) ? -T.xx : T.xx;
+	return normalize(Result);
+}
+
+static float4 DequantizePosition(float4 Position, SVertexQuantization Quantization)
+{
+	return float4(Position.xyz * Quantization.PositionExtent.xyz + Quantization.PositionCenter.xyz, 1);
+}
+
+static float3 DequantizeUV(float2 UV, SVertexQuantization Quantization)
+{
+	return float3(UV * Quantization.TexCoordOffsetScale.zw + Quantization.TexCoordOffsetScale.xy, 0);
+}
+
+static VS_INPUT DecompressVertex(VS_INPUT_COMPRESSED Input, SVertexQuantization Quantization)
+{
+	VS_INPUT Result;
+
+	Result.Position = DequantizePosition(Input.Position, Quantization);
+	Result.Color = Input.Color;
+	Result.UV = DequantizeUV(Input.UV, Quantization);
+	Result.Normal = float4(DecodeOctahedral(Input.Normal), 0);
+	Result.Tangent = float4(DecodeOctahedral(Input.Tangent), 0);
+
+	Result.InstanceWorld0 = Input.InstanceWorld0;
+	Result.InstanceWorld1 = Input.InstanceWorld1;
+	Result.InstanceWorld2 = Input.InstanceWorld2;
+	Result.InstanceWorld3 = Input.InstanceWorld3;
+
+	return Result;
+}
+
+static VS_INPUT_ANIMATION DecompressVertexAnimation(VS_INPUT_ANIMATION_COMPRESSED Input, SVertexQuantization Quantization)
+{
+	VS_INPUT_ANIMATION Result;
+
+	Result.Position = DequantizePosition(Input.Position, Quantization);
+	Result.Color = Input.Color;
+	Result.UV = DequantizeUV(Input.UV, Quantization);
+	Result.Normal = float4(DecodeOctahedral(Input.Normal), 0);
+	Result.Tangent = float4(DecodeOctahedral(Input.Tangent), 0);
+
+	Result.BoneIndex = Input.BoneIndex;
+	Result.BoneWeight = Input.BoneWeight;
+
+	return Result;
+}
\ No newline at end of file
@@ -1,18 +1,13 @@
 #include "Header.hlsli"
 
+// Variants (CShaderPermutationSet): USE_TEXTURE, USE_LIGHTING, HAS_DIFFUSE_TEXTURE (needs USE_TEXTURE), HAS_OPACITY_TEXTURE
+
 SamplerState CurrentSampler : register(s0);
 Texture2D DiffuseTexture : register(t0);
 //Texture2D NormalTexture : register(t5);
 Texture2D OpacityTexture : register(t10);
 
-cbuffer cbFlags : register(b0)
-{
-	bool UseTexture;
-	bool UseLighting;
-	bool2 Pads;
-}
-
-cbuffer cbLights : register(b1)
+cbuffer cbLights : register(b0)
 {
 	float4	DirectionalLightDirection;
 	float4	DirectionalLightColor;
@@ -21,18 +16,14 @@ cbuffer cbLights : register(b1)
 	float4	EyePosition;
 }
 
-cbuffer cbMaterial : register(b2)
+cbuffer cbMaterial : register(b1)
 {
 	float3	MaterialAmbient;
 	float	SpecularExponent;
 	float3	MaterialDiffuse;
 	float	SpecularIntensity;
 	float3	MaterialSpecular;
-	bool	bHasDiffuseTexture;
-
-	bool	bHasNormalTexture;
-	bool	bHasOpacityTexture;
-	bool2	Pad;
+	float	Pad;
 }
 
 float4 main(VS_OUTPUT input) : SV_TARGET
@@ -42,22 +33,19 @@ float4 main(VS_OUTPUT input) : SV_TARGET
 	float4 SpecularColor = float4(MaterialSpecular, 1);
 	float Opacity = 1.0f;
 	
-	if (UseTexture == true)
-	{
-		if (bHasDiffuseTexture == true)
-		{
-			AmbientColor = DiffuseColor = SpecularColor = DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-		}
-		
-		if (bHasOpacityTexture == true)
-		{
-			Opacity = OpacityTexture.Sample(CurrentSampler, input.UV.xy).r;
-		}
-	}
+#if USE_TEXTURE
+#if HAS_DIFFUSE_TEXTURE
+	AmbientColor = DiffuseColor = SpecularColor = DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
+#endif
+
+#if HAS_OPACITY_TEXTURE
+	Opacity = OpacityTexture.Sample(CurrentSampler, input.UV.xy).r;
+#endif
+#endif
 	DiffuseColor.xyz *= DiffuseColor.xyz;
 
 	float4 Result = DiffuseColor;
-	if (UseLighting == true)
+#if USE_LIGHTING
 	{
 		Result = CalculateAmbient(AmbientColor, AmbientLightColor, AmbientLightIntensity);
 
@@ -70,16 +58,16 @@ float4 main(VS_OUTPUT input) : SV_TARGET
 
 		Result += Directional;
 	}
+#endif
 
 	if (input.bUseVertexColor != 0)
 	{
 		return input.Color;
 	}
 
-	if (bHasOpacityTexture == true)
-	{
-		Result.a *= (1.0f - Opacity);
-	}
+#if HAS_OPACITY_TEXTURE
+	Result.a *= (1.0f - Opacity);
+#endif
 
 	return Result;
 }
\ No newline at end of file
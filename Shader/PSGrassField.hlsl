@@ -1,15 +1,11 @@
 #include "HGrassField.hlsli"
 
+// Variants (CShaderPermutationSet): USE_TEXTURE
+
 SamplerState CurrentSampler : register(s0);
 Texture2D BladeTexture : register(t0);
 
-cbuffer cbFlags : register(b0)
-{
-	bool bUseTexture;
-	float3 Pads;
-}
-
-cbuffer cbLights : register(b1)
+cbuffer cbLights : register(b0)
 {
 	float4	DirectionalLightDirection;
 	float4	DirectionalLightColor;
@@ -20,15 +16,13 @@ cbuffer cbLights : register(b1)
 
 float4 main(GS_GRASS_FIELD_OUTPUT Input) : SV_TARGET
 {
-	float4 Albedo;
-	if (bUseTexture == true)
-	{
-		Albedo = BladeTexture.Sample(CurrentSampler, Input.UV);
-	}
-	else
-	{
-		Albedo = Input.Color;
-	}
+#if USE_TEXTURE
+	float4 Albedo = BladeTexture.Sample(CurrentSampler, Input.UV);
+	// BLADE_ALPHA_REFERENCE is CGrassField::KBladeAlphaReference, whose coverage the blade texture's mips preserve
+	clip(Albedo.a - BLADE_ALPHA_REFERENCE);
+#else
+	float4 Albedo = Input.Color;
+#endif
 
 	float4 Result;
 	float4 Ambient = CalculateAmbient(Albedo, AmbientLightColor, AmbientLightIntensity);
@@ -1,5 +1,9 @@
 #include "Header.hlsli"
 
+// Variants (CShaderPermutationSet): USE_LAYER1 ~ USE_LAYER4, USE_TILE_MASKING
+// CTerrain draws each tile with the variant of the layers that have non-zero masking there (layer 0 is always sampled)
+// USE_TILE_MASKING: a streamed terrain tile, whose masking is a dense texture with a full mip chain in t10
+
 SamplerState CurrentSampler : register(s0);
 
 Texture2D Layer0DiffuseTexture : register(t0);
@@ -14,11 +18,24 @@ Texture2D Layer2NormalTexture : register(t7);
 Texture2D Layer3NormalTexture : register(t8);
 Texture2D Layer4NormalTexture : register(t9);
 
-Texture2D MaskingTexture : register(t10);
+// The masking is sparse (see CSparseMasking): the tiles that can be non-zero have a slot in the atlas, with a border of their neighbours'
+// texels for filtering, and the rest are 0; mips from KMaskingAtlasMipCount on are in the dense coarse texture
+Texture2D MaskingAtlasTexture : register(t10);
+Texture2D<uint> MaskingIndirectionTexture : register(t11); // Atlas slot + 1 of each tile, 0: the tile is 0
+Texture2D MaskingCoarseTexture : register(t12);
+
+static const float KMaskingTileSize = 32.0f;
+static const float KMaskingAtlasBorder = 4.0f;
+static const float KMaskingAtlasSlotSize = 40.0f;
+static const float KMaskingAtlasMipCount = 3.0f;
 
 cbuffer cbMaskingSpace : register(b0)
 {
 	float4x4 Matrix;
+	float2 MaskingTextureSize; // In texels
+	float2 MaskingAtlasSize; // In texels
+	uint MaskingAtlasSlotCountX;
+	float3 Pads;
 }
 
 cbuffer cbLights : register(b1)
@@ -48,36 +65,93 @@ cbuffer cbEditorTime : register(b3)
 	float2 Pad2;
 }
 
+#if USE_TILE_MASKING
+float4 SampleMasking(float2 UV)
+{
+	// Clamped to the tile's texel centers, so that the tiles don't filter across their borders
+	float2 HalfTexel = 0.5f / MaskingTextureSize;
+	return MaskingAtlasTexture.SampleGrad(CurrentSampler, clamp(UV, HalfTexel, 1.0f - HalfTexel), ddx(UV), ddy(UV));
+}
+#else
+// Samples as one masking texture with a full mip chain would: mips below KMaskingAtlasMipCount come from the atlas, the rest from the coarse texture
+// Mips coarser than MASKING_MAX_MIP (CTerrain::KMaskingMaxMip) aren't sampled, because the layer tiles only analyze weight blurred that far
+float4 SampleMasking(float2 UV)
+{
+	float2 Texel = clamp(UV, 0.0f, 1.0f) * MaskingTextureSize;
+	float2 TexelDX = ddx(Texel);
+	float2 TexelDY = ddy(Texel);
+	float LOD = 0.5f * log2(max(max(dot(TexelDX, TexelDX), dot(TexelDY, TexelDY)), 1e-8f));
+	float CoarseWeight = saturate(LOD - (KMaskingAtlasMipCount - 1.0f));
+
+	float4 Coarse = float4(0, 0, 0, 0);
+	if (CoarseWeight > 0.0f)
+	{
+		// The coarse texture covers whole blocks, so it can be a bit larger than the masking
+		float2 CoarseScale = MaskingTextureSize / (ceil(MaskingTextureSize / exp2(KMaskingAtlasMipCount)) * exp2(KMaskingAtlasMipCount));
+		float2 GradientScale = CoarseScale * exp2(min(MASKING_MAX_MIP - LOD, 0.0f));
+		Coarse = MaskingCoarseTexture.SampleGrad(CurrentSampler, UV * CoarseScale, ddx(UV) * GradientScale, ddy(UV) * GradientScale);
+		if (CoarseWeight >= 1.0f) return Coarse;
+	}
+
+	float4 Fine = float4(0, 0, 0, 0);
+	uint2 Tile = min(uint2(Texel / KMaskingTileSize), uint2(ceil(MaskingTextureSize / KMaskingTileSize)) - 1);
+	uint Entry = MaskingIndirectionTexture.Load(int3(Tile, 0));
+	if (Entry > 0)
+	{
+		uint Slot = Entry - 1;
+		float2 SlotOrigin = float2(Slot % MaskingAtlasSlotCountX, Slot / MaskingAtlasSlotCountX) * KMaskingAtlasSlotSize;
+		float2 AtlasUV = (SlotOrigin + KMaskingAtlasBorder + (Texel - Tile * KMaskingTileSize)) / MaskingAtlasSize;
+		float2 Scale = 1.0f / MaskingAtlasSize;
+		Fine = MaskingAtlasTexture.SampleGrad(CurrentSampler, AtlasUV, TexelDX * Scale, TexelDY * Scale);
+	}
+	return lerp(Fine, Coarse, CoarseWeight);
+}
+#endif
+
 float4 main(VS_OUTPUT input) : SV_TARGET
 {
 	float4 MaskingSpacePosition = mul(float4(input.WorldPosition.x, 0, -input.WorldPosition.z, 1), Matrix);
-	float4 Masking = MaskingTexture.Sample(CurrentSampler, MaskingSpacePosition.xz);
+	float4 Masking = SampleMasking(MaskingSpacePosition.xz);
 
 	float4 DiffuseLayer0 = Layer0DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-	float4 DiffuseLayer1 = Layer1DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-	float4 DiffuseLayer2 = Layer2DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-	float4 DiffuseLayer3 = Layer3DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-	float4 DiffuseLayer4 = Layer4DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
-
 	float4 Albedo = DiffuseLayer0;
+#if USE_LAYER1
+	float4 DiffuseLayer1 = Layer1DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
 	Albedo.xyz = DiffuseLayer1.xyz * Masking.r + Albedo.xyz * (1.0f - Masking.r);
+#endif
+#if USE_LAYER2
+	float4 DiffuseLayer2 = Layer2DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
 	Albedo.xyz = DiffuseLayer2.xyz * Masking.g + Albedo.xyz * (1.0f - Masking.g);
+#endif
+#if USE_LAYER3
+	float4 DiffuseLayer3 = Layer3DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
 	Albedo.xyz = DiffuseLayer3.xyz * Masking.b + Albedo.xyz * (1.0f - Masking.b);
+#endif
+#if USE_LAYER4
+	float4 DiffuseLayer4 = Layer4DiffuseTexture.Sample(CurrentSampler, input.UV.xy);
 	Albedo.xyz = DiffuseLayer4.xyz * Masking.a + Albedo.xyz * (1.0f - Masking.a);
-
-	float4 NormalLayer0 = normalize((Layer0NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
-	float4 NormalLayer1 = normalize((Layer1NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
-	float4 NormalLayer2 = normalize((Layer2NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
-	float4 NormalLayer3 = normalize((Layer3NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
-	float4 NormalLayer4 = normalize((Layer4NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
+#endif
 
 	float3x3 TextureSpace = float3x3(input.WorldTangent.xyz, input.WorldBitangent.xyz, input.WorldNormal.xyz);
+	float4 NormalLayer0 = normalize((Layer0NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
 	float4 ResultNormal;
 	ResultNormal = NormalLayer0;
+#if USE_LAYER1
+	float4 NormalLayer1 = normalize((Layer1NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
 	ResultNormal.xyz = NormalLayer1.xyz * Masking.r + ResultNormal.xyz * (1.0f - Masking.r);
+#endif
+#if USE_LAYER2
+	float4 NormalLayer2 = normalize((Layer2NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
 	ResultNormal.xyz = NormalLayer2.xyz * Masking.g + ResultNormal.xyz * (1.0f - Masking.g);
+#endif
+#if USE_LAYER3
+	float4 NormalLayer3 = normalize((Layer3NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
 	ResultNormal.xyz = NormalLayer3.xyz * Masking.b + ResultNormal.xyz * (1.0f - Masking.b);
+#endif
+#if USE_LAYER4
+	float4 NormalLayer4 = normalize((Layer4NormalTexture.Sample(CurrentSampler, input.UV.xy) * 2.0f) - 1.0f);
 	ResultNormal.xyz = NormalLayer4.xyz * Masking.a + ResultNormal.xyz * (1.0f - Masking.a);
+#endif
 	ResultNormal = normalize(ResultNormal);
 	ResultNormal = normalize(float4(mul(ResultNormal.xyz, TextureSpace), 0.0f));
 	
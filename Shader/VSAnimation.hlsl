@@ -1,4 +1,4 @@
-#include "Header.hlsli"
+#include "HVertexCompression.hlsli"
 
 cbuffer cbSpace : register(b0)
 {
@@ -11,6 +11,11 @@ cbuffer cbBones : register(b1)
 	float4x4 BoneMatrices[KBoneMatrixMaxCount];
 }
 
+cbuffer cbVertexQuantization : register(b2) // Only used by mainCompressed
+{
+	SVertexQuantization VertexQuantization;
+}
+
 VS_OUTPUT main(VS_INPUT_ANIMATION input)
 {
 	VS_OUTPUT output;
@@ -38,4 +43,9 @@ VS_OUTPUT main(VS_INPUT_ANIMATION input)
 	output.bUseVertexColor = 0;
 
 	return output;
+}
+
+VS_OUTPUT mainCompressed(VS_INPUT_ANIMATION_COMPRESSED input)
+{
+	return main(DecompressVertexAnimation(input, VertexQuantization));
 }
\ No newline at end of file
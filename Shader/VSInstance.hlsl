@@ -1,4 +1,4 @@
-#include "Header.hlsli"
+#include "HVertexCompression.hlsli"
 
 cbuffer cbSpace : register(b0)
 {
@@ -6,6 +6,11 @@ cbuffer cbSpace : register(b0)
 	float4x4 World;
 }
 
+cbuffer cbVertexQuantization : register(b1) // Only used by mainCompressed
+{
+	SVertexQuantization VertexQuantization;
+}
+
 VS_OUTPUT main(VS_INPUT input)
 {
 	VS_OUTPUT output;
@@ -25,4 +30,9 @@ VS_OUTPUT main(VS_INPUT input)
 	output.bUseVertexColor = 0;
 
 	return output;
+}
+
+VS_OUTPUT mainCompressed(VS_INPUT_COMPRESSED input)
+{
+	return main(DecompressVertex(input, VertexQuantization));
 }
\ No newline at end of file
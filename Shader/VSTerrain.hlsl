@@ -1,4 +1,4 @@
-#include "Header.hlsli"
+#include "HVertexCompression.hlsli"
 
 cbuffer cbSpace : register(b0)
 {
@@ -16,14 +16,25 @@ cbuffer cbTerrain : register(b1)
 
 SamplerState CurrentSampler : register(s0);
 Texture2D<float> HeightMapTexture : register(t0);
+Texture2D<float2> NormalMapTexture : register(t1); // Octahedral around +Y (CNormalMapGenerator)
+
+float2 GetHeightMapUV(float2 XZ)
+{
+	return float2((XZ.x + (TerrainSizeX / 2.0f)) / TerrainSizeX, (-XZ.y + (TerrainSizeZ / 2.0f)) / TerrainSizeZ);
+}
 
 float GetHeightFromHeightMap(float2 XZ)
 {
-	float2 uv = float2((XZ.x + (TerrainSizeX / 2.0f)) / TerrainSizeX, (-XZ.y + (TerrainSizeZ / 2.0f)) / TerrainSizeZ);
-	float y_norm = HeightMapTexture.SampleLevel(CurrentSampler, uv, 0);
+	float y_norm = HeightMapTexture.SampleLevel(CurrentSampler, GetHeightMapUV(XZ), 0);
 	return (y_norm * TerrainHeightRange - TerrainHeightRange / 2.0f);
 }
 
+float3 GetNormalFromNormalMap(float2 XZ)
+{
+	// DecodeOctahedral() is around +Z, so Y and Z are swapped back
+	return DecodeOctahedral(NormalMapTexture.SampleLevel(CurrentSampler, GetHeightMapUV(XZ), 0)).xzy;
+}
+
 VS_OUTPUT main(VS_INPUT input)
 {
 	VS_OUTPUT output;
@@ -36,11 +47,7 @@ VS_OUTPUT main(VS_INPUT input)
 	output.Color = input.Color;
 	output.UV = input.UV;
 
-	float HeightXMinus = GetHeightFromHeightMap(ResultPosition.xz + float2(-1, 0));
-	float HeightXPlus = GetHeightFromHeightMap(ResultPosition.xz + float2(+1, 0));
-	float HeightZMinus = GetHeightFromHeightMap(ResultPosition.xz + float2(0, -1));
-	float HeightZPlus = GetHeightFromHeightMap(ResultPosition.xz + float2(0, +1));
-	float4 ResultNormal = normalize(float4(HeightXMinus - HeightXPlus, 2.0f, HeightZMinus - HeightZPlus, 0));
+	float4 ResultNormal = float4(GetNormalFromNormalMap(ResultPosition.xz), 0);
 	output.WorldNormal = normalize(mul(ResultNormal, World));
 
 	float4 ResultBitangent = normalize(float4(cross(ResultNormal.xyz, input.Tangent.xyz), 0));
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Test and benchmark cases of CoreTests (ctest runs each case as "CoreTests <Name>")
+// Checks report every failure and keep going, so that one run shows everything that is wrong with a case
+class CTestRegistry
+{
+public:
+	struct SCase
+	{
+		const char*	Name{};
+		void		(*Function)(){};
+		bool		bIsBenchmark{};
+	};
+
+public:
+	static std::vector<SCase>& GetCases()
+	{
+		static std::vector<SCase> vCases{};
+		return vCases;
+	}
+
+	static int& GetFailureCount()
+	{
+		static int FailureCount{};
+		return FailureCount;
+	}
+
+	static bool Register(const char* const Name, void(*Function)(), bool bIsBenchmark)
+	{
+		GetCases().push_back(SCase{ Name, Function, bIsBenchmark });
+		return true;
+	}
+
+	static void ReportFailure(const char* const File, int Line, const std::string& Message)
+	{
+		fprintf(stderr, "%s(%d): check failed: %s\n", File, Line, Message.c_str());
+		++GetFailureCount();
+	}
+};
+
+// Wall-clock milliseconds since construction
+class CTestTimer
+{
+public:
+	CTestTimer() : m_Start{ std::chrono::steady_clock::now() } {}
+
+	double GetElapsedMilliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point	m_Start{};
+};
+
+// The null device never dereferences D3D11 objects, so any distinct address is a distinct object
+template <typename T>
+static T* MakeHandle(uintptr_t ID)
+{
+	return reinterpret_cast<T*>(ID * 16);
+}
+
+#define TEST_CASE_IMPL(Name, bIsBenchmark)\
+static void Name();\
+static const bool Name##Registered{ CTestRegistry::Register(#Name, Name, bIsBenchmark) };\
+static void Name()
+
+// Name must be unique across the test files (Test/CMakeLists.txt registers every case with ctest by name)
+#define TEST_CASE(Name) TEST_CASE_IMPL(Name, false)
+// Benchmarks print their measurements and get the "bench" ctest label
+#define BENCH_CASE(Name) TEST_CASE_IMPL(Name, true)
+
+#define CHECK(Condition)\
+do { if (!(Condition)) CTestRegistry::ReportFailure(__FILE__, __LINE__, #Condition); } while (false)
+
+#define CHECK_NEAR(Value, Expected, Tolerance)\
+do\
+{\
+	const double KValue_{ static_cast<double>(Value) };\
+	const double KExpected_{ static_cast<double>(Expected) };\
+	if (!(fabs(KValue_ - KExpected_) <= static_cast<double>(Tolerance)))\
+	{\
+		CTestRegistry::ReportFailure(__FILE__, __LINE__, std::string(#Value " == " #Expected " (") + std::to_string(KValue_) + " vs " +\
+			std::to_string(KExpected_) + ")");\
+	}\
+} while (false)
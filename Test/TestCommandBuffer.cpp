@@ -0,0 +1,349 @@
+#include "Test.h"
+#include "Core/CommandRecorder.h"
+#include "Core/RenderDeviceNull.h"
+
+using ECommandType = CCommandBuffer::ECommandType;
+
+static void FillPattern(void* const PtrData, size_t ByteSize, uint32_t Seed)
+{
+	uint8_t* const PtrBytes{ static_cast<uint8_t*>(PtrData) };
+	for (size_t iByte = 0; iByte < ByteSize; ++iByte) PtrBytes[iByte] = static_cast<uint8_t>(iByte * 7 + Seed);
+}
+
+static bool HasPattern(const vector<uint8_t>* const PtrMemory, size_t ByteSize, uint32_t Seed)
+{
+	if (!PtrMemory || PtrMemory->size() < ByteSize) return false;
+
+	vector<uint8_t> vExpected(ByteSize);
+	FillPattern(vExpected.data(), ByteSize, Seed);
+	return memcmp(PtrMemory->data(), vExpected.data(), ByteSize) == 0;
+}
+
+// One call of every recordable type, valid on CRenderDeviceNull (the textures must be the device's, the other objects are fake handles)
+static void IssueEveryCommand(CRenderDevice& Device, ID3D11Texture2D* const PtrDstTexture, ID3D11Texture2D* const PtrSrcTexture)
+{
+	Device.SetVertexShader(MakeHandle<ID3D11VertexShader>(0x10));
+	Device.SetHullShader(MakeHandle<ID3D11HullShader>(0x11));
+	Device.SetDomainShader(MakeHandle<ID3D11DomainShader>(0x12));
+	Device.SetGeometryShader(MakeHandle<ID3D11GeometryShader>(0x13));
+	Device.SetPixelShader(MakeHandle<ID3D11PixelShader>(0x14));
+	Device.SetInputLayout(MakeHandle<ID3D11InputLayout>(0x15));
+	Device.SetConstantBuffer(EShaderType::DomainShader, 2, MakeHandle<ID3D11Buffer>(0x20));
+	Device.SetShaderResource(EShaderType::PixelShader, 5, MakeHandle<ID3D11ShaderResourceView>(0x21));
+	Device.SetSamplerState(EShaderType::HullShader, 1, MakeHandle<ID3D11SamplerState>(0x22));
+	Device.SetConstantBufferRange(EShaderType::VertexShader, 3, MakeHandle<ID3D11Buffer>(0x23), 32, 16);
+	Device.SetRasterizerState(MakeHandle<ID3D11RasterizerState>(0x24));
+	Device.SetDepthStencilState(MakeHandle<ID3D11DepthStencilState>(0x25), 7);
+	Device.SetBlendState(MakeHandle<ID3D11BlendState>(0x26));
+	Device.SetViewport(D3D11_VIEWPORT{ 8.0f, 16.0f, 640.0f, 480.0f, 0.0f, 1.0f });
+	Device.SetRenderTarget(MakeHandle<ID3D11RenderTargetView>(0x27), MakeHandle<ID3D11DepthStencilView>(0x28));
+	const FLOAT KClearColor[4]{ 0.25f, 0.5f, 0.75f, 1.0f };
+	Device.ClearRenderTarget(MakeHandle<ID3D11RenderTargetView>(0x27), KClearColor);
+	Device.ClearDepthStencil(MakeHandle<ID3D11DepthStencilView>(0x28), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 3);
+	Device.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+	Device.SetVertexBuffer(1, MakeHandle<ID3D11Buffer>(0x29), 48, 96);
+	Device.SetIndexBuffer(MakeHandle<ID3D11Buffer>(0x2A), DXGI_FORMAT_R16_UINT, 6);
+
+	void* const PtrMapped{ Device.Map(MakeHandle<ID3D11Buffer>(0x30), D3D11_MAP_WRITE_DISCARD, 256) };
+	if (PtrMapped) FillPattern(PtrMapped, 256, 1);
+	Device.Unmap(MakeHandle<ID3D11Buffer>(0x30));
+	uint8_t UpdateData[64]{};
+	FillPattern(UpdateData, sizeof(UpdateData), 2);
+	Device.UpdateBuffer(MakeHandle<ID3D11Buffer>(0x31), UpdateData, sizeof(UpdateData));
+	Device.CopyBufferRegion(MakeHandle<ID3D11Buffer>(0x32), 16, MakeHandle<ID3D11Buffer>(0x31), 8, 32);
+
+	uint8_t Texels[8 * 8 * 4]{};
+	FillPattern(Texels, sizeof(Texels), 3);
+	const D3D11_BOX KUpdateBox{ 4, 4, 0, 12, 12, 1 };
+	Device.UpdateTexture(PtrDstTexture, 1, &KUpdateBox, Texels, 8 * 4);
+	const D3D11_BOX KCopyBox{ 0, 0, 0, 16, 16, 1 };
+	Device.CopyTextureRegion(PtrDstTexture, 0, 4, 8, PtrSrcTexture, 0, &KCopyBox);
+	Device.GenerateMips(MakeHandle<ID3D11ShaderResourceView>(0x33));
+	Device.SetResourceMinLOD(PtrDstTexture, 1.5f);
+	Device.SignalFence(0x1'0000'0002ull);
+
+	Device.Draw(30, 3);
+	Device.DrawIndexed(60, 6, -2);
+	Device.DrawIndexedInstanced(90, 4, 9, 5, 1);
+}
+
+// Textures' addresses differ between devices, so they're compared through their roles
+static bool AreCommandsEqual(const vector<CRenderDeviceNull::SCommand>& vExpected, const vector<CRenderDeviceNull::SCommand>& vCommands,
+	const void* const PtrExpectedTextures[2], const void* const PtrTextures[2])
+{
+	if (vExpected.size() != vCommands.size()) return false;
+
+	for (size_t iCommand = 0; iCommand < vCommands.size(); ++iCommand)
+	{
+		const CRenderDeviceNull::SCommand& KExpected{ vExpected[iCommand] };
+		const CRenderDeviceNull::SCommand& KCommand{ vCommands[iCommand] };
+		const void* PtrExpectedObject{ KExpected.PtrObject };
+		for (int iTexture = 0; iTexture < 2; ++iTexture)
+		{
+			if (PtrExpectedObject == PtrExpectedTextures[iTexture]) PtrExpectedObject = PtrTextures[iTexture];
+		}
+		if (KExpected.eType != KCommand.eType || KExpected.eShaderType != KCommand.eShaderType || KExpected.Slot != KCommand.Slot ||
+			PtrExpectedObject != KCommand.PtrObject || memcmp(KExpected.Arguments, KCommand.Arguments, sizeof(KCommand.Arguments)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void CreateTestTextures(CRenderDeviceNull& Device, ComPtr<ID3D11Texture2D>& DstTexture, ComPtr<ID3D11Texture2D>& SrcTexture)
+{
+	D3D11_TEXTURE2D_DESC Desc{};
+	Desc.Width = 64;
+	Desc.Height = 64;
+	Desc.MipLevels = 0;
+	Desc.ArraySize = 1;
+	Desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Desc.SampleDesc.Count = 1;
+	Desc.Usage = D3D11_USAGE_DEFAULT;
+	Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	CHECK(SUCCEEDED(Device.CreateTexture2D(Desc, nullptr, DstTexture.GetAddressOf())));
+	Desc.Width = 16;
+	Desc.Height = 16;
+	Desc.MipLevels = 1;
+	CHECK(SUCCEEDED(Device.CreateTexture2D(Desc, nullptr, SrcTexture.GetAddressOf())));
+
+	// Creation isn't part of the compared calls
+	Device.Reset();
+}
+
+TEST_CASE(CommandBuffer_ReplayMatchesDirectCalls)
+{
+	CRenderDeviceNull DirectDevice{};
+	ComPtr<ID3D11Texture2D> DirectTextures[2]{};
+	CreateTestTextures(DirectDevice, DirectTextures[0], DirectTextures[1]);
+	IssueEveryCommand(DirectDevice, DirectTextures[0].Get(), DirectTextures[1].Get());
+
+	CRenderDeviceNull ReplayDevice{};
+	ComPtr<ID3D11Texture2D> ReplayTextures[2]{};
+	CreateTestTextures(ReplayDevice, ReplayTextures[0], ReplayTextures[1]);
+	CCommandBuffer CommandBuffer{};
+	IssueEveryCommand(CommandBuffer, ReplayTextures[0].Get(), ReplayTextures[1].Get());
+
+	// Every command type is recorded once, and nothing reaches the device until the replay
+	const vector<CCommandBuffer::SCommand>& KRecorded{ CommandBuffer.GetCommands() };
+	constexpr size_t KCommandTypeCount{ static_cast<size_t>(ECommandType::DrawIndexedInstanced) + 1 };
+	CHECK(KRecorded.size() == KCommandTypeCount);
+	for (size_t iCommand = 0; iCommand < min(KRecorded.size(), KCommandTypeCount); ++iCommand)
+	{
+		CHECK(KRecorded[iCommand].eType == static_cast<ECommandType>(iCommand));
+	}
+	CHECK(CommandBuffer.GetDrawCallCount() == 3);
+	CHECK(ReplayDevice.GetCommands().empty());
+
+	CommandBuffer.Replay(ReplayDevice);
+
+	const void* const PtrDirectTextures[2]{ DirectTextures[0].Get(), DirectTextures[1].Get() };
+	const void* const PtrReplayTextures[2]{ ReplayTextures[0].Get(), ReplayTextures[1].Get() };
+	CHECK(AreCommandsEqual(DirectDevice.GetCommands(), ReplayDevice.GetCommands(), PtrDirectTextures, PtrReplayTextures));
+
+	const CRenderDeviceNull::SStats& KDirectStats{ DirectDevice.GetStats() };
+	const CRenderDeviceNull::SStats& KReplayStats{ ReplayDevice.GetStats() };
+	CHECK(KDirectStats.ValidationErrorCount == 0 && KReplayStats.ValidationErrorCount == 0);
+	CHECK(KReplayStats.CallCount == KDirectStats.CallCount);
+	CHECK(KReplayStats.DrawCallCount == KDirectStats.DrawCallCount && KReplayStats.PrimitiveCount == KDirectStats.PrimitiveCount);
+	CHECK(KReplayStats.MapCount == KDirectStats.MapCount && KReplayStats.MappedByteCount == KDirectStats.MappedByteCount);
+	CHECK(KReplayStats.UpdatedByteCount == KDirectStats.UpdatedByteCount);
+	CHECK(KReplayStats.CopyCount == KDirectStats.CopyCount && KReplayStats.CopiedByteCount == KDirectStats.CopiedByteCount);
+	CHECK(ReplayDevice.GetResourceMinLOD(ReplayTextures[0].Get()) == DirectDevice.GetResourceMinLOD(DirectTextures[0].Get()));
+	CHECK(ReplayDevice.GetCompletedFence() == DirectDevice.GetCompletedFence());
+
+	// The buffers' contents went through the recorded data
+	for (uintptr_t BufferID : { 0x30, 0x31, 0x32 })
+	{
+		const vector<uint8_t>* const PtrDirectMemory{ DirectDevice.GetBufferMemory(MakeHandle<ID3D11Buffer>(BufferID)) };
+		const vector<uint8_t>* const PtrReplayMemory{ ReplayDevice.GetBufferMemory(MakeHandle<ID3D11Buffer>(BufferID)) };
+		CHECK(PtrDirectMemory && PtrReplayMemory && *PtrDirectMemory == *PtrReplayMemory);
+	}
+	CHECK(HasPattern(ReplayDevice.GetBufferMemory(MakeHandle<ID3D11Buffer>(0x30)), 256, 1));
+}
+
+TEST_CASE(CommandBuffer_MapWriteDiscardContents)
+{
+	// Two maps open at once, and one that doesn't fit a data block
+	constexpr size_t KLargeByteSize{ CCommandBuffer::KDataBlockByteSize * 2 + 40 };
+	const size_t KByteSizes[3]{ 100, KLargeByteSize, 24 };
+	CCommandBuffer CommandBuffer{};
+	void* PtrMapped[3]{};
+	PtrMapped[0] = CommandBuffer.Map(MakeHandle<ID3D11Buffer>(1), D3D11_MAP_WRITE_DISCARD, KByteSizes[0]);
+	PtrMapped[1] = CommandBuffer.Map(MakeHandle<ID3D11Buffer>(2), D3D11_MAP_WRITE_DISCARD, KByteSizes[1]);
+	for (int iMap = 0; iMap < 2; ++iMap)
+	{
+		CHECK(PtrMapped[iMap] != nullptr && reinterpret_cast<uintptr_t>(PtrMapped[iMap]) % CCommandBuffer::KDataAlignment == 0);
+		if (PtrMapped[iMap]) FillPattern(PtrMapped[iMap], KByteSizes[iMap], iMap);
+	}
+	CommandBuffer.Unmap(MakeHandle<ID3D11Buffer>(2));
+	CommandBuffer.Unmap(MakeHandle<ID3D11Buffer>(1));
+	PtrMapped[2] = CommandBuffer.Map(MakeHandle<ID3D11Buffer>(3), D3D11_MAP_WRITE_DISCARD, KByteSizes[2]);
+	CHECK(PtrMapped[2] != nullptr);
+	if (PtrMapped[2]) FillPattern(PtrMapped[2], KByteSizes[2], 2);
+	CommandBuffer.Unmap(MakeHandle<ID3D11Buffer>(3));
+
+	// Commands are recorded on Unmap()
+	const vector<CCommandBuffer::SCommand>& KCommands{ CommandBuffer.GetCommands() };
+	CHECK(KCommands.size() == 3);
+	if (KCommands.size() == 3)
+	{
+		CHECK(KCommands[0].eType == ECommandType::WriteBuffer && KCommands[0].PtrObject == MakeHandle<ID3D11Buffer>(2));
+		CHECK(KCommands[1].PtrObject == MakeHandle<ID3D11Buffer>(1) && KCommands[2].PtrObject == MakeHandle<ID3D11Buffer>(3));
+	}
+	CHECK(CommandBuffer.GetDataByteSize() >= KByteSizes[0] + KByteSizes[1] + KByteSizes[2]);
+
+	CRenderDeviceNull Device{};
+	CommandBuffer.Replay(Device);
+	for (uint32_t iMap = 0; iMap < 3; ++iMap)
+	{
+		CHECK(HasPattern(Device.GetBufferMemory(MakeHandle<ID3D11Buffer>(iMap + 1)), KByteSizes[iMap], iMap));
+	}
+	CHECK(Device.GetStats().MapCount == 3 && Device.GetStats().MappedByteCount == KByteSizes[0] + KByteSizes[1] + KByteSizes[2]);
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+}
+
+TEST_CASE(CommandBuffer_ResetReusesDataBlocks)
+{
+	// A frame's data: small allocations, one larger than a block, then small ones again
+	auto RecordFrame{ [](CCommandBuffer& CommandBuffer, vector<void*>& vPtrData)
+	{
+		vPtrData.clear();
+		for (size_t iMap = 0; iMap < 600; ++iMap)
+		{
+			const size_t KByteSize{ (iMap == 300) ? CCommandBuffer::KDataBlockByteSize * 3 : 64 + iMap % 5 * 48 };
+			ID3D11Buffer* const PtrBuffer{ MakeHandle<ID3D11Buffer>(iMap + 1) };
+			vPtrData.emplace_back(CommandBuffer.Map(PtrBuffer, D3D11_MAP_WRITE_DISCARD, KByteSize));
+			CommandBuffer.Unmap(PtrBuffer);
+			CommandBuffer.Draw(3, 0);
+		}
+	} };
+
+	CCommandBuffer CommandBuffer{};
+	vector<void*> vFirstPtrData{};
+	RecordFrame(CommandBuffer, vFirstPtrData);
+	const size_t KDataByteSize{ CommandBuffer.GetDataByteSize() };
+	CHECK(KDataByteSize > CCommandBuffer::KDataBlockByteSize * 4);
+
+	// The same frame after Reset() gets the same memory, so no block was allocated
+	for (int iFrame = 0; iFrame < 3; ++iFrame)
+	{
+		CommandBuffer.Reset();
+		CHECK(CommandBuffer.GetCommands().empty() && CommandBuffer.GetDrawCallCount() == 0 && CommandBuffer.GetDataByteSize() == 0);
+
+		vector<void*> vPtrData{};
+		RecordFrame(CommandBuffer, vPtrData);
+		CHECK(vPtrData == vFirstPtrData);
+		CHECK(CommandBuffer.GetDataByteSize() == KDataByteSize);
+		CHECK(CommandBuffer.GetDrawCallCount() == 600);
+	}
+}
+
+// Jobs of varying length, each with its own constant buffer contents
+static void RecordTestJob(size_t JobIndex, CCommandBuffer& CommandBuffer)
+{
+	CommandBuffer.SetVertexShader(MakeHandle<ID3D11VertexShader>(0x100 + JobIndex % 4));
+	CommandBuffer.SetPixelShader(MakeHandle<ID3D11PixelShader>(0x200 + JobIndex % 3));
+	CommandBuffer.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CommandBuffer.SetIndexBuffer(MakeHandle<ID3D11Buffer>(0x300 + JobIndex), DXGI_FORMAT_R32_UINT, 0);
+
+	ID3D11Buffer* const PtrConstantBuffer{ MakeHandle<ID3D11Buffer>(0x1000 + JobIndex) };
+	const size_t KByteSize{ 64 + JobIndex * 16 };
+	void* const PtrMapped{ CommandBuffer.Map(PtrConstantBuffer, D3D11_MAP_WRITE_DISCARD, KByteSize) };
+	if (PtrMapped) FillPattern(PtrMapped, KByteSize, static_cast<uint32_t>(JobIndex));
+	CommandBuffer.Unmap(PtrConstantBuffer);
+	CommandBuffer.SetConstantBuffer(EShaderType::VertexShader, 1, PtrConstantBuffer);
+
+	for (size_t iDraw = 0; iDraw < JobIndex % 7 + 1; ++iDraw)
+	{
+		CommandBuffer.SetVertexBuffer(0, MakeHandle<ID3D11Buffer>(0x10000 + JobIndex * 8 + iDraw), 32, 0);
+		CommandBuffer.DrawIndexed(static_cast<UINT>(3 * (iDraw + 1)), static_cast<UINT>(iDraw), 0);
+	}
+}
+
+TEST_CASE(CommandRecorder_MergedOutputIndependentOfThreadCount)
+{
+	constexpr size_t KJobCount{ 97 };
+	const void* const PtrNoTextures[2]{};
+	CCommandRecorder Recorder{};
+	Recorder.Record(KJobCount, RecordTestJob, 1);
+	CHECK(Recorder.GetStats().ThreadCount == 1 && Recorder.GetCommandBufferCount() == KJobCount);
+	CRenderDeviceNull ExpectedDevice{};
+	Recorder.Replay(ExpectedDevice);
+	const size_t KCommandCount{ Recorder.GetStats().CommandCount };
+	CHECK(ExpectedDevice.GetCommands().size() == KCommandCount + KJobCount); // A recorded WriteBuffer replays as Map + Unmap
+	CHECK(ExpectedDevice.GetStats().ValidationErrorCount == 0);
+
+	// The same recorder is reused, so that its command buffers are reset in between
+	for (uint32_t ThreadCount : { 2u, 5u, 8u, 0u })
+	{
+		Recorder.Record(KJobCount, RecordTestJob, ThreadCount);
+		CHECK(Recorder.GetStats().CommandCount == KCommandCount);
+		CHECK(Recorder.GetStats().DrawCallCount == ExpectedDevice.GetStats().DrawCallCount);
+
+		CRenderDeviceNull Device{};
+		Recorder.Replay(Device);
+		CHECK(AreCommandsEqual(ExpectedDevice.GetCommands(), Device.GetCommands(), PtrNoTextures, PtrNoTextures));
+		size_t MismatchCount{};
+		for (size_t iJob = 0; iJob < KJobCount; ++iJob)
+		{
+			if (!HasPattern(Device.GetBufferMemory(MakeHandle<ID3D11Buffer>(0x1000 + iJob)), 64 + iJob * 16, static_cast<uint32_t>(iJob))) ++MismatchCount;
+		}
+		CHECK(MismatchCount == 0);
+
+		// A range of jobs replays the same commands as those jobs' part of the whole replay
+		CRenderDeviceNull RangeDevice{};
+		Recorder.Replay(RangeDevice, 0, 10);
+		vector<CRenderDeviceNull::SCommand> vExpectedRange{ ExpectedDevice.GetCommands().begin(),
+			ExpectedDevice.GetCommands().begin() + min(RangeDevice.GetCommands().size(), ExpectedDevice.GetCommands().size()) };
+		CHECK(AreCommandsEqual(vExpectedRange, RangeDevice.GetCommands(), PtrNoTextures, PtrNoTextures));
+	}
+}
+
+// Commands recorded per second by CCommandRecorder against the thread count (each job records 256 objects' state and draws)
+BENCH_CASE(CommandRecorder_RecordThroughputByThreadCount)
+{
+	constexpr size_t KJobCount{ 256 };
+	constexpr size_t KObjectCountPerJob{ 256 };
+	auto RecordJob{ [](size_t JobIndex, CCommandBuffer& CommandBuffer)
+	{
+		for (size_t iObject = 0; iObject < KObjectCountPerJob; ++iObject)
+		{
+			const uintptr_t KObjectID{ JobIndex * KObjectCountPerJob + iObject };
+			CommandBuffer.SetVertexShader(MakeHandle<ID3D11VertexShader>(0x100 + KObjectID % 8));
+			CommandBuffer.SetInputLayout(MakeHandle<ID3D11InputLayout>(0x200 + KObjectID % 8));
+			CommandBuffer.SetPixelShader(MakeHandle<ID3D11PixelShader>(0x300 + KObjectID % 3));
+			CommandBuffer.SetShaderResource(EShaderType::PixelShader, 0, MakeHandle<ID3D11ShaderResourceView>(0x400 + KObjectID % 50));
+			CommandBuffer.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			CommandBuffer.SetVertexBuffer(0, MakeHandle<ID3D11Buffer>(0x10000 + KObjectID), 48, 0);
+			CommandBuffer.SetIndexBuffer(MakeHandle<ID3D11Buffer>(0x80000 + KObjectID), DXGI_FORMAT_R32_UINT, 0);
+
+			ID3D11Buffer* const PtrConstantBuffer{ MakeHandle<ID3D11Buffer>(0x500) };
+			if (void* const PtrMapped{ CommandBuffer.Map(PtrConstantBuffer, D3D11_MAP_WRITE_DISCARD, 128) }) memset(PtrMapped, 0, 128);
+			CommandBuffer.Unmap(PtrConstantBuffer);
+			CommandBuffer.SetConstantBuffer(EShaderType::VertexShader, 0, PtrConstantBuffer);
+			CommandBuffer.DrawIndexed(300, 0, 0);
+		}
+	} };
+
+	constexpr int KFrameCount{ 8 };
+	for (uint32_t ThreadCount : { 1u, 2u, 4u, 8u, 0u })
+	{
+		// The first frame allocates the command buffers' memory, the measured ones reuse it
+		CCommandRecorder Recorder{};
+		Recorder.Record(KJobCount, RecordJob, ThreadCount);
+
+		double Milliseconds{};
+		for (int iFrame = 0; iFrame < KFrameCount; ++iFrame)
+		{
+			Recorder.Record(KJobCount, RecordJob, ThreadCount);
+			Milliseconds += Recorder.GetStats().ElapsedMilliseconds;
+		}
+		Milliseconds /= KFrameCount;
+
+		const CCommandRecorder::SStats& KStats{ Recorder.GetStats() };
+		printf("threads %2u: %8.3f ms per frame, %7.2f M commands/s (%zu commands, %zu draws, %zu KB data)\n", KStats.ThreadCount, Milliseconds,
+			KStats.CommandCount / Milliseconds / 1000.0, KStats.CommandCount, KStats.DrawCallCount, KStats.DataByteSize / 1024);
+	}
+}
@@ -0,0 +1,193 @@
+#include "Test.h"
+#include "Core/ConstantBufferUploader.h"
+#include "Core/RenderDeviceNull.h"
+#include <cstring>
+
+static const float* GetTransientData(const CRenderDeviceNull& Device, ID3D11Buffer* const PtrBuffer, const STransientConstantBuffer& Transient)
+{
+	return reinterpret_cast<const float*>(Device.GetBufferMemory(PtrBuffer)->data() + Transient.FirstConstant *
+		CConstantBufferUploader::KConstantByteSize);
+}
+
+TEST_CASE(ConstantBufferUploader_SkipsUnchangedUploads)
+{
+	ID3D11Buffer* const KBuffer{ MakeHandle<ID3D11Buffer>(0x20) };
+	CRenderDeviceNull Device{ false };
+	CStateTracker StateTracker{ &Device };
+	CConstantBufferUploader Uploader{ &Device, &StateTracker };
+
+	SConstantBufferShadow Shadow{};
+	float Data[8]{ 1, 2, 3, 4, 5, 6, 7, 8 };
+	CHECK(Uploader.Upload(KBuffer, Data, sizeof(Data), Shadow));
+	CHECK(!Uploader.Upload(KBuffer, Data, sizeof(Data), Shadow));
+	Data[3] = 9;
+	CHECK(Uploader.Upload(KBuffer, Data, sizeof(Data), Shadow));
+
+	CHECK(memcmp(Device.GetBufferMemory(KBuffer)->data(), Data, sizeof(Data)) == 0);
+	CHECK(Uploader.GetStats().MapCount == 2);
+	CHECK(Uploader.GetStats().SkippedUploadCount == 1);
+	CHECK(Uploader.GetStats().UploadedByteCount == 2 * sizeof(Data));
+	CHECK(Device.GetStats().MapCount == 2);
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+}
+
+TEST_CASE(ConstantBufferUploader_SuballocatesTransientRanges)
+{
+	ID3D11Buffer* const KTransientBuffer{ MakeHandle<ID3D11Buffer>(0x10) };
+	CRenderDeviceNull Device{};
+	CStateTracker StateTracker{ &Device };
+	CConstantBufferUploader Uploader{ &Device, &StateTracker };
+	Uploader.SetTransientBuffer(KTransientBuffer, 4096); // 16 ranges of 256 bytes
+	Uploader.BeginFrame();
+
+	vector<STransientConstantBuffer> vTransients(40);
+	float Data[48]{};
+	size_t WrongDataCount{};
+	for (size_t iTransient = 0; iTransient < vTransients.size(); ++iTransient)
+	{
+		Data[0] = static_cast<float>(iTransient);
+		Uploader.UploadTransient(EShaderType::VertexShader, 0, Data, 192, vTransients[iTransient]);
+		CHECK(vTransients[iTransient].FirstConstant % CConstantBufferUploader::KRangeAlignment == 0);
+		CHECK(vTransients[iTransient].ConstantCount == 16);
+		if (GetTransientData(Device, KTransientBuffer, vTransients[iTransient])[0] != Data[0]) ++WrongDataCount;
+	}
+	CHECK(WrongDataCount == 0);
+
+	// WRITE_DISCARD at the start of the frame and whenever the buffer is full, NO_OVERWRITE otherwise
+	CHECK(Uploader.GetStats().TransientDiscardCount == 3);
+	size_t DiscardCount{};
+	size_t NoOverwriteCount{};
+	for (const CRenderDeviceNull::SCommand& Command : Device.GetCommands())
+	{
+		if (Command.eType != CRenderDeviceNull::ECommandType::Map) continue;
+		if (Command.Arguments[0] == D3D11_MAP_WRITE_DISCARD) ++DiscardCount;
+		if (Command.Arguments[0] == D3D11_MAP_WRITE_NO_OVERWRITE) ++NoOverwriteCount;
+	}
+	CHECK(DiscardCount == 3);
+	CHECK(NoOverwriteCount == 37);
+
+	// Unchanged contents in a range that is still valid aren't uploaded again
+	Data[0] = 39.0f;
+	Uploader.UploadTransient(EShaderType::VertexShader, 0, Data, 192, vTransients[39]);
+	CHECK(Uploader.GetStats().SkippedUploadCount == 1);
+
+	// A range of a discarded generation is re-uploaded from the shadow
+	Uploader.UseTransient(EShaderType::VertexShader, 0, vTransients[0]);
+	CHECK(Uploader.GetStats().TransientAllocationCount == 41);
+	CHECK(GetTransientData(Device, KTransientBuffer, vTransients[0])[0] == 0.0f);
+
+	// A new frame discards the buffer, so even unchanged contents are uploaded again
+	Uploader.BeginFrame();
+	Uploader.UploadTransient(EShaderType::VertexShader, 0, Data, 192, vTransients[39]);
+	CHECK(Uploader.GetStats().TransientAllocationCount == 1);
+	CHECK(Uploader.GetStats().TransientDiscardCount == 1);
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+
+	// Larger than the transient buffer: nothing is issued
+	vector<uint8_t> vLargeData(8192);
+	STransientConstantBuffer Large{};
+	const size_t KCommandCount{ Device.GetCommands().size() };
+	Uploader.UploadTransient(EShaderType::VertexShader, 1, vLargeData.data(), vLargeData.size(), Large);
+	CHECK(Device.GetCommands().size() == KCommandCount);
+}
+
+TEST_CASE(ConstantBufferUploader_BindsRangesThroughStateTracker)
+{
+	ID3D11Buffer* const KTransientBuffer{ MakeHandle<ID3D11Buffer>(0x10) };
+	CRenderDeviceNull Device{};
+	CStateTracker StateTracker{ &Device };
+	CConstantBufferUploader Uploader{ &Device, &StateTracker };
+	Uploader.SetTransientBuffer(KTransientBuffer, 64 * 1024);
+	Uploader.BeginFrame();
+
+	float Data[16]{ 1 };
+	STransientConstantBuffer Transient{};
+	StateTracker.BeginTracking();
+	Uploader.UploadTransient(EShaderType::PixelShader, 2, Data, sizeof(Data), Transient);
+	Uploader.UseTransient(EShaderType::PixelShader, 2, Transient);
+	StateTracker.EndTracking();
+
+	size_t RangeBindCount{};
+	for (const CRenderDeviceNull::SCommand& Command : Device.GetCommands())
+	{
+		if (Command.eType != CRenderDeviceNull::ECommandType::SetConstantBufferRange) continue;
+		++RangeBindCount;
+		CHECK(Command.PtrObject == KTransientBuffer);
+		CHECK(Command.eShaderType == EShaderType::PixelShader);
+		CHECK(Command.Slot == 2);
+		CHECK(Command.Arguments[0] == Transient.FirstConstant);
+		CHECK(Command.Arguments[1] == Transient.ConstantCount);
+	}
+	// The second bind of the same range is skipped by the state tracker
+	CHECK(RangeBindCount == 1);
+	CHECK(StateTracker.GetStats().SkippedCallCount == 1);
+}
+
+// 2000 objects per frame: 192-byte per-draw space data, and lights, materials (20, sorted) and flags that rarely change
+BENCH_CASE(ConstantBufferUploader_SimulatedFrames)
+{
+	constexpr size_t KObjectCount{ 2'000 };
+	ID3D11Buffer* const KTransientBuffer{ MakeHandle<ID3D11Buffer>(0x10) };
+	ID3D11Buffer* const KSpaceBuffer{ MakeHandle<ID3D11Buffer>(0x40) };
+	ID3D11Buffer* const KBuffers[3]{ MakeHandle<ID3D11Buffer>(0x30), MakeHandle<ID3D11Buffer>(0x31), MakeHandle<ID3D11Buffer>(0x32) };
+
+	for (bool bUseUploader : { false, true })
+	{
+		CRenderDeviceNull Device{ false };
+		CStateTracker StateTracker{ &Device };
+		CConstantBufferUploader Uploader{ &Device, &StateTracker };
+		Uploader.SetTransientBuffer(KTransientBuffer, 4 * 1024 * 1024);
+		SConstantBufferShadow Shadows[3]{};
+		STransientConstantBuffer SpaceTransient{};
+
+		CTestTimer Timer{};
+		for (int Frame = 0; Frame < 3; ++Frame)
+		{
+			Device.Reset();
+			Uploader.BeginFrame();
+			StateTracker.BeginFrame();
+			StateTracker.BeginTracking();
+
+			float Space[48]{};
+			float Lights[16]{ 1 };
+			float Material[16]{};
+			float Flags[4]{};
+			for (size_t iObject = 0; iObject < KObjectCount; ++iObject)
+			{
+				Space[0] = static_cast<float>(iObject);
+				Space[1] = static_cast<float>(Frame);
+				Material[0] = static_cast<float>(iObject * 20 / KObjectCount);
+				Flags[0] = static_cast<float>(iObject % 2);
+
+				if (bUseUploader)
+				{
+					Uploader.UploadTransient(EShaderType::VertexShader, 0, Space, sizeof(Space), SpaceTransient);
+					Uploader.Upload(KBuffers[0], Lights, sizeof(Lights), Shadows[0]);
+					Uploader.Upload(KBuffers[1], Material, sizeof(Material), Shadows[1]);
+					Uploader.Upload(KBuffers[2], Flags, sizeof(Flags), Shadows[2]);
+				}
+				else
+				{
+					// What CShader::UpdateAllConstantBuffers() did: map every buffer of the shader on every use
+					ID3D11Buffer* const KAllBuffers[4]{ KSpaceBuffer, KBuffers[0], KBuffers[1], KBuffers[2] };
+					const size_t KByteSizes[4]{ sizeof(Space), sizeof(Lights), sizeof(Material), sizeof(Flags) };
+					for (size_t iBuffer = 0; iBuffer < 4; ++iBuffer)
+					{
+						Device.Map(KAllBuffers[iBuffer], D3D11_MAP_WRITE_DISCARD, KByteSizes[iBuffer]);
+						Device.Unmap(KAllBuffers[iBuffer]);
+					}
+					StateTracker.SetConstantBuffer(EShaderType::VertexShader, 0, KSpaceBuffer);
+				}
+				for (UINT Slot = 0; Slot < 3; ++Slot) StateTracker.SetConstantBuffer(EShaderType::PixelShader, Slot, KBuffers[Slot]);
+			}
+			StateTracker.EndTracking();
+		}
+		const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		printf("%s (last frame): %zu maps, %zu bytes uploaded, %zu uploads skipped, %zu calls issued, %zu validation errors, %.3f ms per frame\n",
+			(bUseUploader) ? "dirty-tracked + transient" : "map every buffer", Device.GetStats().MapCount,
+			(bUseUploader) ? Uploader.GetStats().UploadedByteCount : Device.GetStats().MappedByteCount, Uploader.GetStats().SkippedUploadCount,
+			StateTracker.GetStats().IssuedCallCount, Device.GetStats().ValidationErrorCount, KMilliseconds / 3);
+		CHECK(Device.GetStats().ValidationErrorCount == 0);
+	}
+}
@@ -0,0 +1,208 @@
+#include "Test.h"
+#include "Core/GeometryProcessor.h"
+#include <map>
+#include <tuple>
+
+// Unindexed UV sphere: every quad has its own 4 vertices (as PrimitiveGenerator's shapes do before welding)
+// Face normals are stored in the vertices, like CalculateNormals() in PrimitiveGenerator.h does
+static SMesh GenerateSoupSphere(uint32_t SegmentCount)
+{
+	const uint32_t KColumnCount{ SegmentCount * 2 };
+	auto GetPosition{ [&](uint32_t Column, uint32_t Row)
+		{
+			const float KTheta{ XM_PI * Row / SegmentCount };
+			const float KPhi{ XM_2PI * (Column % KColumnCount) / KColumnCount };
+			return XMVectorSet(sinf(KTheta) * cosf(KPhi), cosf(KTheta), sinf(KTheta) * sinf(KPhi), 1.0f);
+		} };
+
+	SMesh Mesh{};
+	for (uint32_t Row = 0; Row < SegmentCount; ++Row)
+	{
+		for (uint32_t Column = 0; Column < KColumnCount; ++Column)
+		{
+			const uint32_t KFirst{ static_cast<uint32_t>(Mesh.vVertices.size()) };
+			const uint32_t KColumns[4]{ Column, Column + 1, Column, Column + 1 };
+			const uint32_t KRows[4]{ Row, Row, Row + 1, Row + 1 };
+			for (uint32_t iCorner = 0; iCorner < 4; ++iCorner)
+			{
+				Mesh.vVertices.emplace_back(GetPosition(KColumns[iCorner], KRows[iCorner]), XMVectorSet(1, 1, 1, 1),
+					XMVectorSet(static_cast<float>(KColumns[iCorner]) / KColumnCount, static_cast<float>(KRows[iCorner]) / SegmentCount, 0, 0));
+			}
+			// The pole rows' other triangle would be degenerate
+			if (Row > 0) Mesh.vTriangles.emplace_back(KFirst, KFirst + 1, KFirst + 2);
+			if (Row < SegmentCount - 1) Mesh.vTriangles.emplace_back(KFirst + 1, KFirst + 3, KFirst + 2);
+		}
+	}
+
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		SVertex3D& V0{ Mesh.vVertices[Triangle.I0] };
+		SVertex3D& V1{ Mesh.vVertices[Triangle.I1] };
+		SVertex3D& V2{ Mesh.vVertices[Triangle.I2] };
+		const XMVECTOR KFaceNormal{ XMVector3Normalize(XMVector3Cross(V1.Position - V0.Position, V2.Position - V0.Position)) };
+		V0.Normal = V1.Normal = V2.Normal = KFaceNormal;
+	}
+	return Mesh;
+}
+
+// What PrimitiveGenerator.h's AverageNormals() did: the distinct normals at each position, averaged
+static void AverageNormalsReference(SMesh& Mesh)
+{
+	using SKey = std::tuple<float, float, float>;
+	std::map<SKey, vector<XMVECTOR>> mapPositionToNormals{};
+	auto GetKey{ [](const XMVECTOR& Position) { return SKey(XMVectorGetX(Position), XMVectorGetY(Position), XMVectorGetZ(Position)); } };
+	for (const SVertex3D& Vertex : Mesh.vVertices)
+	{
+		vector<XMVECTOR>& vNormals{ mapPositionToNormals[GetKey(Vertex.Position)] };
+		const bool bIsNew{ std::none_of(vNormals.begin(), vNormals.end(), [&](const XMVECTOR& Normal) { return XMVector3Equal(Normal, Vertex.Normal); }) };
+		if (bIsNew) vNormals.emplace_back(Vertex.Normal);
+	}
+	for (SVertex3D& Vertex : Mesh.vVertices)
+	{
+		XMVECTOR Sum{};
+		for (const XMVECTOR& Normal : mapPositionToNormals[GetKey(Vertex.Position)]) Sum += Normal;
+		Vertex.Normal = XMVector3Normalize(Sum);
+	}
+}
+
+static bool IsPole(const SVertex3D& Vertex)
+{
+	return fabsf(XMVectorGetY(Vertex.Position)) > 0.9999f;
+}
+
+static float GetAngleDegrees(const XMVECTOR& A, const XMVECTOR& B)
+{
+	return XMConvertToDegrees(atan2f(XMVectorGetX(XMVector3Length(XMVector3Cross(A, B))), XMVectorGetX(XMVector3Dot(A, B))));
+}
+
+// The largest angle between the vertex normals and the sphere's own normals (the vertex positions)
+static float GetMaxAnalyticNormalError(const SMesh& Mesh)
+{
+	float MaxError{};
+	for (const SVertex3D& Vertex : Mesh.vVertices)
+	{
+		MaxError = max(MaxError, GetAngleDegrees(Vertex.Normal, XMVector3Normalize(XMVectorSetW(Vertex.Position, 0))));
+	}
+	return MaxError;
+}
+
+TEST_CASE(GeometryProcessor_NormalsMatchLegacyAverage)
+{
+	SMesh Legacy{ GenerateSoupSphere(24) };
+	SMesh Processed{ Legacy };
+	AverageNormalsReference(Legacy);
+	CGeometryProcessor::CalculateNormals(Processed);
+
+	// At the poles the legacy average used to split positions that differ by float rounding, so only compare the other vertices
+	float MaxDifference{};
+	for (size_t iVertex = 0; iVertex < Legacy.vVertices.size(); ++iVertex)
+	{
+		if (IsPole(Legacy.vVertices[iVertex])) continue;
+		MaxDifference = max(MaxDifference, GetAngleDegrees(Legacy.vVertices[iVertex].Normal, Processed.vVertices[iVertex].Normal));
+	}
+	const float KLegacyError{ GetMaxAnalyticNormalError(Legacy) };
+	const float KProcessedError{ GetMaxAnalyticNormalError(Processed) };
+	printf("max difference to the legacy average %g deg; vs. the analytic normals: legacy %g deg, processed %g deg\n",
+		MaxDifference, KLegacyError, KProcessedError);
+
+	// Angle weighting only differs from the plain average where the triangles around a position have different angles
+	CHECK(MaxDifference < 0.5f);
+	CHECK(KProcessedError <= KLegacyError + 0.01f);
+}
+
+TEST_CASE(GeometryProcessor_TangentsAreOrthonormal)
+{
+	SMesh Mesh{ GenerateSoupSphere(32) };
+	CGeometryProcessor::CalculateNormals(Mesh);
+	CGeometryProcessor::CalculateTangents(Mesh);
+
+	float MaxNormalDot{};
+	float MaxLengthError{};
+	float MinHandedness{ FLT_MAX };
+	for (const SVertex3D& Vertex : Mesh.vVertices)
+	{
+		// The texture coordinates are singular at the poles
+		if (IsPole(Vertex)) continue;
+		MaxNormalDot = max(MaxNormalDot, fabsf(XMVectorGetX(XMVector3Dot(Vertex.Normal, Vertex.Tangent))));
+		MaxLengthError = max(MaxLengthError, fabsf(XMVectorGetX(XMVector3Length(Vertex.Tangent)) - 1.0f));
+		// Bitangent = cross(Normal, Tangent) * handedness, so it's always orthogonal to both
+		MinHandedness = min(MinHandedness, fabsf(XMVectorGetX(XMVector3Dot(Vertex.Bitangent, XMVector3Cross(Vertex.Normal, Vertex.Tangent)))));
+	}
+	CHECK(MaxNormalDot < 0.001f);
+	CHECK(MaxLengthError < 0.001f);
+	CHECK(MinHandedness > 0.999f);
+}
+
+TEST_CASE(GeometryProcessor_WeldUsesEpsilon)
+{
+	constexpr uint32_t KSegmentCount{ 16 };
+	SMesh Mesh{ GenerateSoupSphere(KSegmentCount) };
+	CGeometryProcessor::CalculateNormals(Mesh);
+	const size_t KVertexCountBefore{ Mesh.vVertices.size() };
+
+	CGeometryProcessor::SStats Stats{};
+	CGeometryProcessor::WeldVertices(Mesh, CGeometryProcessor::SDesc(), &Stats);
+
+	// The bottom pole's positions differ by float rounding (sin(pi) != 0), which the weld epsilon absorbs
+	CHECK(Stats.PositionCount == KSegmentCount * 2 * (KSegmentCount - 1) + 2);
+	CHECK(Stats.VertexCountBefore == KVertexCountBefore);
+	CHECK(Stats.VertexCountAfter == Mesh.vVertices.size());
+	CHECK(Mesh.vVertices.size() < KVertexCountBefore / 3);
+	CHECK(Mesh.vTriangles.size() == KSegmentCount * (KSegmentCount - 1) * 4);
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		CHECK(Triangle.I0 < Mesh.vVertices.size() && Triangle.I1 < Mesh.vVertices.size() && Triangle.I2 < Mesh.vVertices.size());
+	}
+}
+
+TEST_CASE(GeometryProcessor_DeterministicAcrossThreadCounts)
+{
+	const SMesh KSource{ GenerateSoupSphere(64) };
+	SMesh Results[2]{ KSource, KSource };
+	const uint32_t KThreadCounts[2]{ 1, 4 };
+	for (uint32_t iRun = 0; iRun < 2; ++iRun)
+	{
+		CGeometryProcessor::SDesc Desc{};
+		Desc.ThreadCount = KThreadCounts[iRun];
+		CGeometryProcessor::CalculateNormals(Results[iRun], Desc);
+		CGeometryProcessor::CalculateTangents(Results[iRun], Desc);
+		CGeometryProcessor::WeldVertices(Results[iRun], Desc);
+	}
+
+	CHECK(Results[0].vVertices.size() == Results[1].vVertices.size());
+	size_t DifferentCount{};
+	for (size_t iVertex = 0; iVertex < min(Results[0].vVertices.size(), Results[1].vVertices.size()); ++iVertex)
+	{
+		const SVertex3D& A{ Results[0].vVertices[iVertex] };
+		const SVertex3D& B{ Results[1].vVertices[iVertex] };
+		if (!XMVector4Equal(A.Normal, B.Normal) || !XMVector4Equal(A.Tangent, B.Tangent) || !XMVector4Equal(A.Position, B.Position)) ++DifferentCount;
+	}
+	CHECK(DifferentCount == 0);
+}
+
+BENCH_CASE(GeometryProcessor_MillionTriangles)
+{
+	const SMesh KSource{ GenerateSoupSphere(500) };
+	printf("%zu triangles, %zu vertices\n", KSource.vTriangles.size(), KSource.vVertices.size());
+
+	for (uint32_t ThreadCount : { 1u, 0u })
+	{
+		SMesh Mesh{ KSource };
+		CGeometryProcessor::SDesc Desc{};
+		Desc.ThreadCount = ThreadCount;
+		CGeometryProcessor::SStats Stats{};
+
+		CTestTimer Timer{};
+		CGeometryProcessor::CalculateNormals(Mesh, Desc, &Stats);
+		const double KNormalMilliseconds{ Timer.GetElapsedMilliseconds() };
+		Timer = CTestTimer();
+		CGeometryProcessor::CalculateTangents(Mesh, Desc, &Stats);
+		const double KTangentMilliseconds{ Timer.GetElapsedMilliseconds() };
+		Timer = CTestTimer();
+		CGeometryProcessor::WeldVertices(Mesh, Desc, &Stats);
+		const double KWeldMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		printf("%u thread(s): normals %.0f ms, tangents %.0f ms, weld %.0f ms (%zu -> %zu vertices)\n", Stats.ThreadCount,
+			KNormalMilliseconds, KTangentMilliseconds, KWeldMilliseconds, Stats.VertexCountBefore, Stats.VertexCountAfter);
+	}
+}
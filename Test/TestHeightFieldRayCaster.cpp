@@ -0,0 +1,271 @@
+#include "Test.h"
+#include "Core/HeightFieldRayCaster.h"
+#include <random>
+#include <cfloat>
+
+static vector<SPixel8UInt> GenerateHeights(uint32_t Width, uint32_t Height, float NoiseAmplitude, std::mt19937& Random)
+{
+	vector<SPixel8UInt> vHeights(static_cast<size_t>(Width) * Height);
+	for (uint32_t V = 0; V < Height; ++V)
+	{
+		for (uint32_t U = 0; U < Width; ++U)
+		{
+			const float KNoise{ (static_cast<float>(Random() % 1000) / 1000.0f - 0.5f) * NoiseAmplitude };
+			const float KValue{ 127.0f + 70.0f * sinf(U * 0.013f + 1.0f) * cosf(V * 0.021f) + 30.0f * sinf(U * 0.11f) * sinf(V * 0.09f) + KNoise };
+			vHeights[static_cast<size_t>(V) * Width + U].R = static_cast<uint8_t>(min(max(KValue, 0.0f), 255.0f));
+		}
+	}
+	return vHeights;
+}
+
+static double SampleBilinear(const vector<SPixel8UInt>& vHeights, uint32_t Width, uint32_t Height, double U, double V)
+{
+	const int KCellU{ static_cast<int>(min(max(floor(U), 0.0), static_cast<double>(Width) - 2)) };
+	const int KCellV{ static_cast<int>(min(max(floor(V), 0.0), static_cast<double>(Height) - 2)) };
+	const double KS{ U - KCellU };
+	const double KR{ V - KCellV };
+	auto GetHeight{ [&](int X, int Y) { return static_cast<double>(vHeights[static_cast<size_t>(Y) * Width + X].R); } };
+	return GetHeight(KCellU, KCellV) * (1 - KS) * (1 - KR) + GetHeight(KCellU + 1, KCellV) * KS * (1 - KR) +
+		GetHeight(KCellU, KCellV + 1) * (1 - KS) * KR + GetHeight(KCellU + 1, KCellV + 1) * KS * KR;
+}
+
+// Steps through every cell the ray crosses on the height map's bottom level, without the pyramid
+static bool CastRayReference(const vector<SPixel8UInt>& vHeights, uint32_t Width, uint32_t Height, const XMFLOAT3& RayOrigin,
+	const XMFLOAT3& RayDirection, double& OutT)
+{
+	const double KLength{ sqrt(static_cast<double>(RayDirection.x) * RayDirection.x + static_cast<double>(RayDirection.y) * RayDirection.y +
+		static_cast<double>(RayDirection.z) * RayDirection.z) };
+	const double KOrigin[3]{ RayOrigin.x, RayOrigin.y, RayOrigin.z };
+	const double KDirection[3]{ RayDirection.x / KLength, RayDirection.y / KLength, RayDirection.z / KLength };
+	const double KBoxMin[3]{ 0.0, -DBL_MAX, 0.0 };
+	const double KBoxMax[3]{ static_cast<double>(Width) - 1, 255.0, static_cast<double>(Height) - 1 };
+	double TMin{};
+	double TMax{ DBL_MAX };
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		if (KDirection[iAxis] == 0)
+		{
+			if (KOrigin[iAxis] < KBoxMin[iAxis] || KOrigin[iAxis] > KBoxMax[iAxis]) return false;
+			continue;
+		}
+		double TNear{ (KBoxMin[iAxis] - KOrigin[iAxis]) / KDirection[iAxis] };
+		double TFar{ (KBoxMax[iAxis] - KOrigin[iAxis]) / KDirection[iAxis] };
+		if (TNear > TFar) std::swap(TNear, TFar);
+		TMin = max(TMin, TNear);
+		TMax = min(TMax, TFar);
+		if (TMin > TMax) return false;
+	}
+
+	for (double T = TMin; T < TMax;)
+	{
+		const uint32_t KCellU{ static_cast<uint32_t>(min(max(floor(KOrigin[0] + KDirection[0] * (T + 1e-6)), 0.0), static_cast<double>(Width) - 2)) };
+		const uint32_t KCellV{ static_cast<uint32_t>(min(max(floor(KOrigin[2] + KDirection[2] * (T + 1e-6)), 0.0), static_cast<double>(Height) - 2)) };
+		double TExit{ TMax };
+		if (KDirection[0] > 0) TExit = min(TExit, (KCellU + 1 - KOrigin[0]) / KDirection[0]);
+		if (KDirection[0] < 0) TExit = min(TExit, (KCellU - KOrigin[0]) / KDirection[0]);
+		if (KDirection[2] > 0) TExit = min(TExit, (KCellV + 1 - KOrigin[2]) / KDirection[2]);
+		if (KDirection[2] < 0) TExit = min(TExit, (KCellV - KOrigin[2]) / KDirection[2]);
+
+		const double KCellOrigin[3]{ KOrigin[0] + KDirection[0] * T - KCellU, KOrigin[1] + KDirection[1] * T, KOrigin[2] + KDirection[2] * T - KCellV };
+		double PatchT{};
+		if (CHeightFieldRayCaster::IntersectPatch(vHeights.data(), Width, KCellU, KCellV, KCellOrigin, KDirection, TExit - T, PatchT))
+		{
+			OutT = (T + PatchT) / KLength;
+			return true;
+		}
+		T = max(TExit, T + 1e-6);
+	}
+	return false;
+}
+
+// From above the terrain to a point inside its bounds, or (bIsGrazing) across it at a shallow angle from the -X side
+static void GenerateRay(std::mt19937& Random, uint32_t Width, uint32_t Height, bool bIsGrazing, XMFLOAT3& OutOrigin, XMFLOAT3& OutDirection)
+{
+	auto GetRandom{ [&]() { return static_cast<float>(Random() % 100'000) / 100'000.0f; } };
+	OutOrigin = XMFLOAT3(GetRandom() * Width, 255.0f + GetRandom() * 300.0f, GetRandom() * Height);
+	XMFLOAT3 Target{ GetRandom() * Width, GetRandom() * 255.0f, GetRandom() * Height };
+	if (bIsGrazing)
+	{
+		OutOrigin.x = -10.0f;
+		OutOrigin.y = 140.0f + GetRandom() * 100.0f;
+		Target.x = static_cast<float>(Width);
+		Target.y = OutOrigin.y - GetRandom() * 120.0f;
+	}
+	OutDirection = XMFLOAT3(Target.x - OutOrigin.x, Target.y - OutOrigin.y, Target.z - OutOrigin.z);
+}
+
+static bool HaveSamePyramid(const CHeightFieldRayCaster& A, const CHeightFieldRayCaster& B)
+{
+	if (A.GetLevels().size() != B.GetLevels().size()) return false;
+	for (size_t iLevel = 0; iLevel < A.GetLevels().size(); ++iLevel)
+	{
+		const auto& vCellsA = A.GetLevels()[iLevel].vCells;
+		const auto& vCellsB = B.GetLevels()[iLevel].vCells;
+		if (vCellsA.size() != vCellsB.size()) return false;
+		for (size_t iCell = 0; iCell < vCellsA.size(); ++iCell)
+		{
+			if (vCellsA[iCell].Min != vCellsB[iCell].Min || vCellsA[iCell].Max != vCellsB[iCell].Max) return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE(HeightFieldRayCaster_MatchesCellByCellReference)
+{
+	std::mt19937 Random{ 44 };
+	for (uint32_t Width : { 2u, 3u, 17u, 100u, 257u })
+	{
+		const uint32_t KHeight{ Width + 3 };
+		const vector<SPixel8UInt> KHeights{ GenerateHeights(Width, KHeight, 60.0f, Random) };
+		CHeightFieldRayCaster RayCaster{};
+		RayCaster.Create(KHeights.data(), Width, KHeight);
+
+		size_t HitCount{};
+		size_t MismatchCount{};
+		size_t OffSurfaceCount{};
+		size_t NotFirstCount{};
+		for (int iRay = 0; iRay < 5'000; ++iRay)
+		{
+			XMFLOAT3 Origin{};
+			XMFLOAT3 Direction{};
+			GenerateRay(Random, Width, KHeight, iRay % 3 == 0, Origin, Direction);
+			CHeightFieldRayCaster::SHit Hit{};
+			double ReferenceT{};
+			const bool KbIsHit{ RayCaster.CastRay(KHeights.data(), Origin, Direction, Hit) };
+			const bool KbIsReferenceHit{ CastRayReference(KHeights, Width, KHeight, Origin, Direction, ReferenceT) };
+			if (KbIsHit != KbIsReferenceHit || (KbIsHit && fabs(Hit.T - ReferenceT) > 1e-4 * max(1.0, ReferenceT))) ++MismatchCount;
+			if (!KbIsHit) continue;
+			++HitCount;
+
+			// On the surface (rays may enter through the sides of the bounds, below the surface at the edges)
+			const double KAbove{ Hit.Position.y - SampleBilinear(KHeights, Width, KHeight, Hit.Position.x, Hit.Position.z) };
+			const bool KbIsAtEdge{ Hit.Position.x <= 1e-3f || Hit.Position.z <= 1e-3f || Hit.Position.x >= Width - 1 - 1e-3f ||
+				Hit.Position.z >= KHeight - 1 - 1e-3f };
+			if (KAbove > 2e-3 || (!KbIsAtEdge && KAbove < -2e-3)) ++OffSurfaceCount;
+
+			// The first hit: a fine march up to it stays above the surface
+			for (int iStep = 1; iStep < 200; ++iStep)
+			{
+				const double KT{ Hit.T * (iStep / 200.0) * 0.999 };
+				const double KU{ Origin.x + Direction.x * KT };
+				const double KV{ Origin.z + Direction.z * KT };
+				if (KU < 0 || KV < 0 || KU > Width - 1 || KV > KHeight - 1) continue;
+				if (Origin.y + Direction.y * KT < SampleBilinear(KHeights, Width, KHeight, KU, KV) - 1e-3)
+				{
+					++NotFirstCount;
+					break;
+				}
+			}
+		}
+		printf("%u x %u: %zu hits, %zu mismatches, %zu off the surface, %zu not the first hit\n", Width, KHeight, HitCount, MismatchCount,
+			OffSurfaceCount, NotFirstCount);
+		CHECK(HitCount > 0);
+		CHECK(MismatchCount == 0);
+		CHECK(OffSurfaceCount == 0);
+		CHECK(NotFirstCount == 0);
+	}
+}
+
+TEST_CASE(HeightFieldRayCaster_IncrementalPyramidMatchesRebuild)
+{
+	std::mt19937 Random{ 3 };
+	constexpr uint32_t KWidth{ 513 };
+	constexpr uint32_t KHeight{ 385 };
+	vector<SPixel8UInt> vHeights{ GenerateHeights(KWidth, KHeight, 30.0f, Random) };
+	CHeightFieldRayCaster Incremental{};
+	Incremental.Create(vHeights.data(), KWidth, KHeight);
+
+	// Raising and lowering, so that cells' min and max both move in both directions
+	for (int iStroke = 0; iStroke < 300; ++iStroke)
+	{
+		const int KCenterX{ static_cast<int>(Random() % KWidth) };
+		const int KCenterY{ static_cast<int>(Random() % KHeight) };
+		const int KHalfSize{ static_cast<int>(Random() % 6) };
+		CMipGenerator::SRect DirtyRect{};
+		DirtyRect.Left = static_cast<uint32_t>(max(KCenterX - KHalfSize, 0));
+		DirtyRect.Top = static_cast<uint32_t>(max(KCenterY - KHalfSize, 0));
+		DirtyRect.Right = static_cast<uint32_t>(min(KCenterX + KHalfSize + 1, static_cast<int>(KWidth)));
+		DirtyRect.Bottom = static_cast<uint32_t>(min(KCenterY + KHalfSize + 1, static_cast<int>(KHeight)));
+		for (uint32_t Y = DirtyRect.Top; Y < DirtyRect.Bottom; ++Y)
+		{
+			for (uint32_t X = DirtyRect.Left; X < DirtyRect.Right; ++X)
+			{
+				SPixel8UInt& Texel{ vHeights[static_cast<size_t>(Y) * KWidth + X] };
+				Texel.R = static_cast<uint8_t>(min(max(Texel.R + ((iStroke & 1) ? +9 : -9), 0), 255));
+			}
+		}
+		Incremental.Update(vHeights.data(), DirtyRect);
+	}
+
+	CHeightFieldRayCaster Rebuilt{};
+	Rebuilt.Create(vHeights.data(), KWidth, KHeight);
+	CHECK(HaveSamePyramid(Incremental, Rebuilt));
+
+	// The top level bounds everything
+	const auto& TopLevel = Rebuilt.GetLevels().back();
+	CHECK(TopLevel.Width == 1 && TopLevel.Height == 1);
+	const auto KMinMax = std::minmax_element(vHeights.begin(), vHeights.end(), [](const SPixel8UInt& A, const SPixel8UInt& B) { return A.R < B.R; });
+	CHECK(TopLevel.vCells[0].Min == KMinMax.first->R);
+	CHECK(TopLevel.vCells[0].Max == KMinMax.second->R);
+}
+
+// Rays per second on large terrains, from above and grazing, against stepping through every cell
+BENCH_CASE(HeightFieldRayCaster_RaysPerSecond)
+{
+	std::mt19937 Random{ 1 };
+	for (uint32_t Size : { 1025u, 4097u })
+	{
+		const vector<SPixel8UInt> KHeights{ GenerateHeights(Size, Size, 20.0f, Random) };
+		CHeightFieldRayCaster RayCaster{};
+		CTestTimer Timer{};
+		RayCaster.Create(KHeights.data(), Size, Size);
+		const double KCreateMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		for (bool bIsGrazing : { false, true })
+		{
+			const int KRayCount{ (Size > 2049) ? 10'000 : 30'000 };
+			vector<XMFLOAT3> vOrigins(KRayCount);
+			vector<XMFLOAT3> vDirections(KRayCount);
+			for (int iRay = 0; iRay < KRayCount; ++iRay)
+			{
+				GenerateRay(Random, Size, Size, bIsGrazing, vOrigins[iRay], vDirections[iRay]);
+			}
+
+			size_t HitCount{};
+			size_t VisitedNodeCount{};
+			size_t TestedPatchCount{};
+			Timer = CTestTimer();
+			for (int iRay = 0; iRay < KRayCount; ++iRay)
+			{
+				CHeightFieldRayCaster::SHit Hit{};
+				CHeightFieldRayCaster::SStats Stats{};
+				HitCount += RayCaster.CastRay(KHeights.data(), vOrigins[iRay], vDirections[iRay], Hit, &Stats);
+				VisitedNodeCount += Stats.VisitedNodeCount;
+				TestedPatchCount += Stats.TestedPatchCount;
+			}
+			const double KPyramidSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+
+			const int KReferenceRayCount{ KRayCount / 20 };
+			Timer = CTestTimer();
+			for (int iRay = 0; iRay < KReferenceRayCount; ++iRay)
+			{
+				double T{};
+				CastRayReference(KHeights, Size, Size, vOrigins[iRay], vDirections[iRay], T);
+			}
+			const double KReferenceSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+
+			printf("%u x %u %-9s: pyramid %.2f M rays/s (%.1f nodes, %.1f patches per ray, %zu%% hit), cell by cell %.3f M rays/s\n", Size, Size,
+				(bIsGrazing) ? "grazing" : "top-down", KRayCount / KPyramidSeconds / 1e6, static_cast<double>(VisitedNodeCount) / KRayCount,
+				static_cast<double>(TestedPatchCount) / KRayCount, HitCount * 100 / KRayCount, KReferenceRayCount / KReferenceSeconds / 1e6);
+		}
+
+		constexpr int KUpdateCount{ 10'000 };
+		const CMipGenerator::SRect KDirtyRect{ Size / 2 - 5, Size / 2 - 5, Size / 2 + 6, Size / 2 + 6 };
+		Timer = CTestTimer();
+		for (int iUpdate = 0; iUpdate < KUpdateCount; ++iUpdate)
+		{
+			RayCaster.Update(KHeights.data(), KDirtyRect);
+		}
+		printf("  pyramid build %.2f ms, 11 x 11 brush update %.2f us\n", KCreateMilliseconds, Timer.GetElapsedMilliseconds() * 1000.0 / KUpdateCount);
+	}
+}
@@ -0,0 +1,43 @@
+#include "Test.h"
+#include <cstring>
+
+// CoreTests            : runs every test case (not the benchmarks)
+// CoreTests --list     : prints the names of all cases
+// CoreTests <Name>...  : runs the named cases (tests or benchmarks)
+int main(int argc, char* argv[])
+{
+	const std::vector<CTestRegistry::SCase>& vCases{ CTestRegistry::GetCases() };
+	if (argc > 1 && strcmp(argv[1], "--list") == 0)
+	{
+		for (const CTestRegistry::SCase& Case : vCases)
+		{
+			printf("%s%s\n", Case.Name, (Case.bIsBenchmark) ? " (benchmark)" : "");
+		}
+		return 0;
+	}
+
+	int RunCount{};
+	for (const CTestRegistry::SCase& Case : vCases)
+	{
+		bool bShouldRun{ argc == 1 && !Case.bIsBenchmark };
+		for (int iArg = 1; iArg < argc; ++iArg)
+		{
+			if (strcmp(argv[iArg], Case.Name) == 0) bShouldRun = true;
+		}
+		if (!bShouldRun) continue;
+
+		const int KFailureCountBefore{ CTestRegistry::GetFailureCount() };
+		printf("[ RUN  ] %s\n", Case.Name);
+		fflush(stdout);
+		Case.Function();
+		printf("[ %s ] %s\n", (CTestRegistry::GetFailureCount() == KFailureCountBefore) ? " OK " : "FAIL", Case.Name);
+		++RunCount;
+	}
+
+	if (RunCount == 0)
+	{
+		fprintf(stderr, "No such case (see --list)\n");
+		return 2;
+	}
+	return (CTestRegistry::GetFailureCount() == 0) ? 0 : 1;
+}
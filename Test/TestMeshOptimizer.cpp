@@ -0,0 +1,166 @@
+#include "Test.h"
+#include "Core/MeshOptimizer.h"
+#include <array>
+#include <random>
+
+// Size x Size grid of shared vertices; bShouldShuffle shuffles triangles and vertices (as exporters that ignore the vertex cache leave them)
+static SMesh GenerateGrid(uint32_t Size, bool bShouldShuffle)
+{
+	SMesh Mesh{};
+	for (uint32_t Z = 0; Z <= Size; ++Z)
+	{
+		for (uint32_t X = 0; X <= Size; ++X)
+		{
+			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(X), 2.0f * sinf(X * 0.1f), static_cast<float>(Z), 1.0f), XMVectorSet(1, 1, 1, 1));
+		}
+	}
+	for (uint32_t Z = 0; Z < Size; ++Z)
+	{
+		for (uint32_t X = 0; X < Size; ++X)
+		{
+			const uint32_t K0{ Z * (Size + 1) + X };
+			const uint32_t K2{ K0 + Size + 1 };
+			Mesh.vTriangles.emplace_back(K0, K2, K0 + 1);
+			Mesh.vTriangles.emplace_back(K0 + 1, K2, K2 + 1);
+		}
+	}
+	if (!bShouldShuffle) return Mesh;
+
+	std::mt19937 Random{ 1 };
+	std::shuffle(Mesh.vTriangles.begin(), Mesh.vTriangles.end(), Random);
+	vector<uint32_t> vPermutation(Mesh.vVertices.size());
+	for (uint32_t iVertex = 0; iVertex < vPermutation.size(); ++iVertex) vPermutation[iVertex] = iVertex;
+	std::shuffle(vPermutation.begin(), vPermutation.end(), Random);
+	vector<SVertex3D> vVertices(Mesh.vVertices.size());
+	for (size_t iVertex = 0; iVertex < vPermutation.size(); ++iVertex) vVertices[vPermutation[iVertex]] = Mesh.vVertices[iVertex];
+	Mesh.vVertices = vVertices;
+	for (STriangle& Triangle : Mesh.vTriangles)
+	{
+		Triangle = STriangle(vPermutation[Triangle.I0], vPermutation[Triangle.I1], vPermutation[Triangle.I2]);
+	}
+	return Mesh;
+}
+
+// Sorted triangles as position triples, each rotated to start at its smallest corner (keeps the winding, ignores triangle and vertex order)
+static vector<std::array<float, 9>> GetTriangleSet(const SMesh& Mesh)
+{
+	vector<std::array<float, 9>> vTriangles{};
+	for (const STriangle& Triangle : Mesh.vTriangles)
+	{
+		std::array<std::array<float, 3>, 3> Corners{};
+		const uint32_t KIndices[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+		for (int iCorner = 0; iCorner < 3; ++iCorner)
+		{
+			XMFLOAT3 Position{};
+			XMStoreFloat3(&Position, Mesh.vVertices[KIndices[iCorner]].Position);
+			Corners[iCorner] = { Position.x, Position.y, Position.z };
+		}
+		std::rotate(Corners.begin(), std::min_element(Corners.begin(), Corners.end()), Corners.end());
+
+		std::array<float, 9> Flat{};
+		for (int iCorner = 0; iCorner < 3; ++iCorner) std::copy(Corners[iCorner].begin(), Corners[iCorner].end(), Flat.begin() + iCorner * 3);
+		vTriangles.emplace_back(Flat);
+	}
+	std::sort(vTriangles.begin(), vTriangles.end());
+	return vTriangles;
+}
+
+static bool AreIdentical(const SMesh& A, const SMesh& B)
+{
+	if (A.vTriangles.size() != B.vTriangles.size() || A.vVertices.size() != B.vVertices.size()) return false;
+	for (size_t iTriangle = 0; iTriangle < A.vTriangles.size(); ++iTriangle)
+	{
+		const STriangle& KA{ A.vTriangles[iTriangle] };
+		const STriangle& KB{ B.vTriangles[iTriangle] };
+		if (KA.I0 != KB.I0 || KA.I1 != KB.I1 || KA.I2 != KB.I2) return false;
+	}
+	for (size_t iVertex = 0; iVertex < A.vVertices.size(); ++iVertex)
+	{
+		if (!XMVector4Equal(A.vVertices[iVertex].Position, B.vVertices[iVertex].Position)) return false;
+	}
+	return true;
+}
+
+TEST_CASE(MeshOptimizer_AnalyzesVertexCache)
+{
+	// Every vertex of a lone triangle misses; a strip of quads reuses 2 vertices per triangle
+	const vector<STriangle> KTriangle{ STriangle(0, 1, 2) };
+	const CMeshOptimizer::SCacheStats KTriangleStats{ CMeshOptimizer::AnalyzeVertexCache(KTriangle, 3) };
+	CHECK_NEAR(KTriangleStats.ACMR, 3.0f, 1e-6f);
+	CHECK_NEAR(KTriangleStats.ATVR, 1.0f, 1e-6f);
+
+	vector<STriangle> vStrip{};
+	for (uint32_t iQuad = 0; iQuad < 100; ++iQuad)
+	{
+		vStrip.emplace_back(2 * iQuad, 2 * iQuad + 2, 2 * iQuad + 1);
+		vStrip.emplace_back(2 * iQuad + 1, 2 * iQuad + 2, 2 * iQuad + 3);
+	}
+	const CMeshOptimizer::SCacheStats KStripStats{ CMeshOptimizer::AnalyzeVertexCache(vStrip, 202) };
+	CHECK_NEAR(KStripStats.ACMR, 202.0f / 200.0f, 1e-5f);
+	CHECK_NEAR(KStripStats.ATVR, 1.0f, 1e-6f);
+}
+
+TEST_CASE(MeshOptimizer_ImprovesGridsDeterministically)
+{
+	for (bool bShouldShuffle : { false, true })
+	{
+		SMesh Mesh{ GenerateGrid(64, bShouldShuffle) };
+		const vector<std::array<float, 9>> KTrianglesBefore{ GetTriangleSet(Mesh) };
+		SMesh Again{ Mesh };
+
+		CMeshOptimizer::SStats Stats{};
+		CMeshOptimizer::OptimizeMesh(Mesh, CMeshOptimizer::SDesc(), &Stats);
+		CMeshOptimizer::OptimizeMesh(Again);
+		printf("%s grid: %zu triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", (bShouldShuffle) ? "Shuffled" : "Ordered", Stats.TriangleCount,
+			Stats.Before.ACMR, Stats.After.ACMR, Stats.Before.ATVR, Stats.After.ATVR);
+
+		// The same triangles (and windings), in the same order every time
+		CHECK(GetTriangleSet(Mesh) == KTrianglesBefore);
+		CHECK(AreIdentical(Mesh, Again));
+
+		// A grid's ideal ACMR is 0.5; Tipsify with a 16-entry cache gets within reach of it
+		CHECK(Stats.After.ACMR <= Stats.Before.ACMR);
+		CHECK(Stats.After.ACMR < 0.8f);
+		CHECK(Stats.After.ATVR < 1.5f);
+		if (bShouldShuffle) CHECK(Stats.Before.ACMR > 2.0f);
+
+		// Vertices are in first-use order
+		vector<bool> vIsUsed(Mesh.vVertices.size());
+		uint32_t NextVertex{};
+		bool bIsInFirstUseOrder{ true };
+		for (const STriangle& Triangle : Mesh.vTriangles)
+		{
+			for (uint32_t Index : { Triangle.I0, Triangle.I1, Triangle.I2 })
+			{
+				if (vIsUsed[Index]) continue;
+				vIsUsed[Index] = true;
+				if (Index != NextVertex++) bIsInFirstUseOrder = false;
+			}
+		}
+		CHECK(bIsInFirstUseOrder);
+	}
+
+	// Unreferenced vertices are removed
+	SMesh Mesh{ GenerateGrid(4, true) };
+	Mesh.vVertices.emplace_back(XMVectorSet(100, 100, 100, 1), XMVectorSet(1, 1, 1, 1));
+	CMeshOptimizer::SStats Stats{};
+	CMeshOptimizer::OptimizeMesh(Mesh, CMeshOptimizer::SDesc(), &Stats);
+	CHECK(Stats.VertexCountBefore == 26 && Stats.VertexCountAfter == 25);
+	CHECK(Mesh.vVertices.size() == 25);
+}
+
+// Optimization speed on a million-triangle mesh
+BENCH_CASE(MeshOptimizer_MillionTriangles)
+{
+	SMesh Mesh{ GenerateGrid(708, true) };
+	CMeshOptimizer::SStats Stats{};
+	CTestTimer Timer{};
+	CMeshOptimizer::OptimizeMesh(Mesh, CMeshOptimizer::SDesc(), &Stats);
+	const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+	printf("%zu triangles: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f in %.0f ms (%.2f M triangles/s)\n", Stats.TriangleCount, Stats.Before.ACMR,
+		Stats.After.ACMR, Stats.Before.ATVR, Stats.After.ATVR, KMilliseconds, Stats.TriangleCount / 1000.0 / KMilliseconds);
+
+	Timer = CTestTimer();
+	CMeshOptimizer::OptimizeVertexCache(Mesh.vTriangles, Mesh.vVertices.size());
+	printf("Vertex cache pass alone: %.0f ms\n", Timer.GetElapsedMilliseconds());
+}
@@ -0,0 +1,244 @@
+#include "Test.h"
+#include "Core/MeshSimplifier.h"
+#include "Core/GeometryProcessor.h"
+#include <set>
+
+// Indexed, bumpy UV sphere whose first and last columns are split vertices (a UV seam)
+static SMesh GenerateBumpySphere(uint32_t SegmentCount, float Radius)
+{
+	const uint32_t KColumnCount{ SegmentCount * 2 };
+	SMesh Mesh{};
+	for (uint32_t Row = 0; Row <= SegmentCount; ++Row)
+	{
+		for (uint32_t Column = 0; Column <= KColumnCount; ++Column)
+		{
+			const float KTheta{ XM_PI * Row / SegmentCount };
+			const float KPhi{ XM_2PI * Column / KColumnCount };
+			const float KBumpyRadius{ Radius * (1.0f + 0.05f * sinf(8.0f * KPhi) * sinf(6.0f * KTheta)) };
+			Mesh.vVertices.emplace_back(
+				XMVectorSet(KBumpyRadius * sinf(KTheta) * cosf(KPhi), KBumpyRadius * cosf(KTheta), KBumpyRadius * sinf(KTheta) * sinf(KPhi), 1.0f),
+				XMVectorSet(1, 1, 1, 1), XMVectorSet(static_cast<float>(Column) / KColumnCount, static_cast<float>(Row) / SegmentCount, 0, 0));
+		}
+	}
+	for (uint32_t Row = 0; Row < SegmentCount; ++Row)
+	{
+		for (uint32_t Column = 0; Column < KColumnCount; ++Column)
+		{
+			const uint32_t K0{ Row * (KColumnCount + 1) + Column };
+			const uint32_t K2{ K0 + KColumnCount + 1 };
+			if (Row > 0) Mesh.vTriangles.emplace_back(K0, K0 + 1, K2);
+			if (Row < SegmentCount - 1) Mesh.vTriangles.emplace_back(K0 + 1, K2 + 1, K2);
+		}
+	}
+	CGeometryProcessor::CalculateNormals(Mesh);
+	return Mesh;
+}
+
+// Wavy Size x Size grid with an open border
+static SMesh GenerateWavyPlane(uint32_t Size)
+{
+	SMesh Mesh{};
+	for (uint32_t Z = 0; Z <= Size; ++Z)
+	{
+		for (uint32_t X = 0; X <= Size; ++X)
+		{
+			Mesh.vVertices.emplace_back(XMVectorSet(static_cast<float>(X), 0.3f * sinf(X * 0.3f) * cosf(Z * 0.2f), static_cast<float>(Z), 1.0f),
+				XMVectorSet(1, 1, 1, 1), XMVectorSet(static_cast<float>(X) / Size, static_cast<float>(Z) / Size, 0, 0));
+		}
+	}
+	for (uint32_t Z = 0; Z < Size; ++Z)
+	{
+		for (uint32_t X = 0; X < Size; ++X)
+		{
+			const uint32_t K0{ Z * (Size + 1) + X };
+			const uint32_t K2{ K0 + Size + 1 };
+			Mesh.vTriangles.emplace_back(K0, K2, K0 + 1);
+			Mesh.vTriangles.emplace_back(K0 + 1, K2, K2 + 1);
+		}
+	}
+	CGeometryProcessor::CalculateNormals(Mesh);
+	Mesh.MaterialID = 1;
+	return Mesh;
+}
+
+static SModel GenerateModel(uint32_t SphereSegmentCount, uint32_t PlaneSize)
+{
+	SModel Model{};
+	Model.vMeshes.emplace_back(GenerateBumpySphere(SphereSegmentCount, 10.0f));
+	Model.vMeshes.emplace_back(GenerateWavyPlane(PlaneSize));
+	return Model;
+}
+
+static std::set<uint32_t> GetUsedVertices(const vector<STriangle>& vTriangles)
+{
+	std::set<uint32_t> UsedVertices{};
+	for (const STriangle& Triangle : vTriangles)
+	{
+		UsedVertices.insert(Triangle.I0);
+		UsedVertices.insert(Triangle.I1);
+		UsedVertices.insert(Triangle.I2);
+	}
+	return UsedVertices;
+}
+
+TEST_CASE(MeshSimplifier_LODChainShrinksWithinError)
+{
+	SModel Model{ GenerateModel(64, 48) };
+	CMeshSimplifier::SLODDesc Desc{};
+	Desc.LODCount = 4;
+	CMeshSimplifier::SLODStats Stats{};
+	CMeshSimplifier::GenerateLODs(Model, Desc, &Stats);
+
+	for (size_t iLOD = 0; iLOD < Stats.vTriangleCounts.size(); ++iLOD)
+	{
+		printf("LOD %zu: %zu triangles, relative error %g\n", iLOD, Stats.vTriangleCounts[iLOD], Stats.vRelativeErrors[iLOD]);
+	}
+
+	CHECK(Stats.vTriangleCounts.size() >= 2);
+	CHECK(Stats.vTriangleCounts.size() == Stats.vRelativeErrors.size());
+	for (size_t iLOD = 1; iLOD < Stats.vTriangleCounts.size(); ++iLOD)
+	{
+		CHECK(Stats.vTriangleCounts[iLOD] < Stats.vTriangleCounts[iLOD - 1]);
+		CHECK(Stats.vRelativeErrors[iLOD] >= Stats.vRelativeErrors[iLOD - 1]);
+		CHECK(Stats.vRelativeErrors[iLOD] <= Desc.MaxRelativeError);
+	}
+	for (const SMesh& Mesh : Model.vMeshes)
+	{
+		for (const SMeshLOD& LOD : Mesh.vLODs)
+		{
+			for (const STriangle& Triangle : LOD.vTriangles)
+			{
+				CHECK(Triangle.I0 != Triangle.I1 && Triangle.I1 != Triangle.I2 && Triangle.I2 != Triangle.I0);
+			}
+		}
+	}
+}
+
+TEST_CASE(MeshSimplifier_KeepsSeamsAndBorders)
+{
+	constexpr uint32_t KSphereSegmentCount{ 48 };
+	constexpr uint32_t KPlaneSize{ 40 };
+	SModel Model{ GenerateModel(KSphereSegmentCount, KPlaneSize) };
+	CMeshSimplifier::SLODDesc Desc{};
+	Desc.LODCount = 4;
+	CMeshSimplifier::GenerateLODs(Model, Desc);
+	CHECK(!Model.vMeshes[0].vLODs.empty() && !Model.vMeshes[1].vLODs.empty());
+	if (Model.vMeshes[0].vLODs.empty() || Model.vMeshes[1].vLODs.empty()) return;
+
+	const std::set<uint32_t> KSphereVertices{ GetUsedVertices(Model.vMeshes[0].vLODs.back().vTriangles) };
+	const uint32_t KColumnCount{ KSphereSegmentCount * 2 };
+	size_t MissingSeamVertexCount{};
+	for (uint32_t Row = 1; Row < KSphereSegmentCount; ++Row)
+	{
+		MissingSeamVertexCount += (KSphereVertices.count(Row * (KColumnCount + 1)) == 0);
+		MissingSeamVertexCount += (KSphereVertices.count(Row * (KColumnCount + 1) + KColumnCount) == 0);
+	}
+
+	const std::set<uint32_t> KPlaneVertices{ GetUsedVertices(Model.vMeshes[1].vLODs.back().vTriangles) };
+	size_t MissingBorderVertexCount{};
+	for (uint32_t i = 0; i <= KPlaneSize; ++i)
+	{
+		MissingBorderVertexCount += (KPlaneVertices.count(i) == 0);
+		MissingBorderVertexCount += (KPlaneVertices.count(KPlaneSize * (KPlaneSize + 1) + i) == 0);
+		MissingBorderVertexCount += (KPlaneVertices.count(i * (KPlaneSize + 1)) == 0);
+		MissingBorderVertexCount += (KPlaneVertices.count(i * (KPlaneSize + 1) + KPlaneSize) == 0);
+	}
+	CHECK(MissingSeamVertexCount == 0);
+	CHECK(MissingBorderVertexCount == 0);
+	// The interior must still have been simplified
+	CHECK(KPlaneVertices.size() < Model.vMeshes[1].vVertices.size() / 2);
+}
+
+TEST_CASE(MeshSimplifier_DeterministicAcrossThreadCounts)
+{
+	const SModel KSource{ GenerateModel(48, 40) };
+	SModel Models[2]{ KSource, KSource };
+	const uint32_t KThreadCounts[2]{ 1, 4 };
+	for (uint32_t iRun = 0; iRun < 2; ++iRun)
+	{
+		CMeshSimplifier::SLODDesc Desc{};
+		Desc.ThreadCount = KThreadCounts[iRun];
+		CMeshSimplifier::GenerateLODs(Models[iRun], Desc);
+	}
+
+	size_t DifferentLODCount{};
+	for (size_t iMesh = 0; iMesh < KSource.vMeshes.size(); ++iMesh)
+	{
+		const vector<SMeshLOD>& vA{ Models[0].vMeshes[iMesh].vLODs };
+		const vector<SMeshLOD>& vB{ Models[1].vMeshes[iMesh].vLODs };
+		CHECK(vA.size() == vB.size());
+		for (size_t iLOD = 0; iLOD < min(vA.size(), vB.size()); ++iLOD)
+		{
+			const bool bIsSame{ vA[iLOD].vTriangles.size() == vB[iLOD].vTriangles.size() && vA[iLOD].RelativeError == vB[iLOD].RelativeError &&
+				std::equal(vA[iLOD].vTriangles.begin(), vA[iLOD].vTriangles.end(), vB[iLOD].vTriangles.begin(),
+					[](const STriangle& A, const STriangle& B) { return A.I0 == B.I0 && A.I1 == B.I1 && A.I2 == B.I2; }) };
+			if (!bIsSame) ++DifferentLODCount;
+		}
+	}
+	CHECK(DifferentLODCount == 0);
+}
+
+TEST_CASE(MeshSimplifier_SimplifyMeshHonorsTargetAndError)
+{
+	const SMesh KMesh{ GenerateWavyPlane(40) };
+
+	CMeshSimplifier::SDesc Desc{};
+	Desc.TargetTriangleCount = KMesh.vTriangles.size() / 4;
+	CMeshSimplifier::SStats Stats{};
+	const vector<STriangle> KSimplified{ CMeshSimplifier::SimplifyMesh(KMesh, KMesh.vTriangles, Desc, &Stats) };
+	CHECK(Stats.TriangleCountBefore == KMesh.vTriangles.size());
+	CHECK(Stats.TriangleCountAfter == KSimplified.size());
+	CHECK(KSimplified.size() <= Desc.TargetTriangleCount + 2);
+
+	// A tiny error bound stops the collapses early
+	CMeshSimplifier::SDesc StrictDesc{ Desc };
+	StrictDesc.MaxError = 1e-4f;
+	CMeshSimplifier::SStats StrictStats{};
+	const vector<STriangle> KStrict{ CMeshSimplifier::SimplifyMesh(KMesh, KMesh.vTriangles, StrictDesc, &StrictStats) };
+	CHECK(KStrict.size() > KSimplified.size());
+	CHECK(StrictStats.Error <= StrictDesc.MaxError);
+}
+
+TEST_CASE(MeshSimplifier_SelectLODByProjectedRadius)
+{
+	SModel Model{ GenerateModel(64, 48) };
+	CMeshSimplifier::GenerateLODs(Model);
+	const size_t KLODCount{ Model.vMeshes[0].vLODs.size() };
+	CHECK(KLODCount > 0);
+
+	// Closer (larger on screen) never selects a coarser LOD
+	size_t PreviousLOD{ KLODCount };
+	for (float ProjectedRadius : { 1.0f, 10.0f, 100.0f, 1'000.0f, 10'000.0f })
+	{
+		const size_t KLOD{ CMeshSimplifier::SelectLOD(Model.vMeshes, ProjectedRadius) };
+		printf("projected radius %g px -> LOD %zu\n", ProjectedRadius, KLOD);
+		CHECK(KLOD <= PreviousLOD);
+		PreviousLOD = KLOD;
+	}
+	CHECK(CMeshSimplifier::SelectLOD(Model.vMeshes, 0.001f) == KLODCount);
+	CHECK(CMeshSimplifier::SelectLOD(Model.vMeshes, 1e7f) == 0);
+}
+
+BENCH_CASE(MeshSimplifier_LODGeneration)
+{
+	const SModel KSource{ GenerateModel(224, 150) };
+	size_t TriangleCount{};
+	for (const SMesh& Mesh : KSource.vMeshes) TriangleCount += Mesh.vTriangles.size();
+	printf("%zu triangles in %zu meshes\n", TriangleCount, KSource.vMeshes.size());
+
+	for (uint32_t ThreadCount : { 1u, 0u })
+	{
+		SModel Model{ KSource };
+		CMeshSimplifier::SLODDesc Desc{};
+		Desc.LODCount = 4;
+		Desc.ThreadCount = ThreadCount;
+		CMeshSimplifier::SLODStats Stats{};
+		CTestTimer Timer{};
+		CMeshSimplifier::GenerateLODs(Model, Desc, &Stats);
+		printf("thread count %u (0: hardware): %.0f ms\n", ThreadCount, Timer.GetElapsedMilliseconds());
+		for (size_t iLOD = 0; iLOD < Stats.vTriangleCounts.size(); ++iLOD)
+		{
+			printf("  LOD %zu: %zu triangles, relative error %g\n", iLOD, Stats.vTriangleCounts[iLOD], Stats.vRelativeErrors[iLOD]);
+		}
+	}
+}
@@ -0,0 +1,286 @@
+#include "Test.h"
+#include "Core/MeshletCuller.h"
+#include "Core/MeshOptimizer.h"
+
+// Indexed, bumpy UV sphere (clockwise seen from outside), in vertex cache order
+static SMesh GenerateSphere(uint32_t SegmentCount, float Radius)
+{
+	const uint32_t KColumnCount{ SegmentCount * 2 };
+	SMesh Mesh{};
+	for (uint32_t Row = 0; Row <= SegmentCount; ++Row)
+	{
+		for (uint32_t Column = 0; Column <= KColumnCount; ++Column)
+		{
+			const float KTheta{ XM_PI * Row / SegmentCount };
+			const float KPhi{ XM_2PI * Column / KColumnCount };
+			const float KBumpyRadius{ Radius * (1.0f + 0.05f * sinf(8.0f * KPhi) * sinf(6.0f * KTheta)) };
+			Mesh.vVertices.emplace_back(
+				XMVectorSet(KBumpyRadius * sinf(KTheta) * cosf(KPhi), KBumpyRadius * cosf(KTheta), KBumpyRadius * sinf(KTheta) * sinf(KPhi), 1.0f),
+				XMVectorSet(1, 1, 1, 1), XMVectorSet(static_cast<float>(Column) / KColumnCount, static_cast<float>(Row) / SegmentCount, 0, 0));
+		}
+	}
+	for (uint32_t Row = 0; Row < SegmentCount; ++Row)
+	{
+		for (uint32_t Column = 0; Column < KColumnCount; ++Column)
+		{
+			const uint32_t K0{ Row * (KColumnCount + 1) + Column };
+			const uint32_t K2{ K0 + KColumnCount + 1 };
+			if (Row > 0) Mesh.vTriangles.emplace_back(K0, K0 + 1, K2);
+			if (Row < SegmentCount - 1) Mesh.vTriangles.emplace_back(K0 + 1, K2 + 1, K2);
+		}
+	}
+	CMeshOptimizer::OptimizeVertexCache(Mesh.vTriangles, Mesh.vVertices.size());
+	return Mesh;
+}
+
+struct SCameraPath
+{
+	const char*	Name{};
+	XMMATRIX	World{};
+	float		Distance{};
+};
+
+// Orbits the sphere while looking around near its center; optionally counts front-facing on-screen triangles that were culled
+static CMeshletCuller::SStats RunCameraPath(const SMesh& Mesh, const vector<SMeshlet>& vMeshlets, const SCameraPath& Path,
+	size_t* const PtrOutWronglyCulledCount = nullptr, double* const PtrOutMilliseconds = nullptr)
+{
+	const XMMATRIX KProjection{ XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f) };
+	CMeshletCuller::SStats Stats{};
+	vector<SDrawIndexedArgs> vDraws{};
+	vector<bool> vIsDrawn(Mesh.vTriangles.size());
+	for (uint32_t Degrees = 0; Degrees < 360; Degrees += 5)
+	{
+		const float KAngle{ XMConvertToRadians(static_cast<float>(Degrees)) };
+		const XMVECTOR KEye{ XMVectorSet(Path.Distance * cosf(KAngle), Path.Distance * 0.3f, Path.Distance * sinf(KAngle), 1) };
+		const XMVECTOR KFocus{ XMVectorSet(5.0f * cosf(KAngle * 3.0f), 0, 5.0f * sinf(KAngle * 2.0f), 1) };
+		const XMMATRIX KViewProjection{ XMMatrixLookAtLH(KEye, KFocus, XMVectorSet(0, 1, 0, 0)) * KProjection };
+
+		vDraws.clear();
+		CTestTimer Timer{};
+		CMeshletCuller::CullMeshlets(vMeshlets, Path.World, CMeshletCuller::ExtractFrustum(KViewProjection), KEye, vDraws,
+			CMeshletCuller::SDesc(), &Stats);
+		if (PtrOutMilliseconds) *PtrOutMilliseconds += Timer.GetElapsedMilliseconds();
+		if (!PtrOutWronglyCulledCount) continue;
+
+		std::fill(vIsDrawn.begin(), vIsDrawn.end(), false);
+		for (const SDrawIndexedArgs& Draw : vDraws)
+		{
+			for (uint32_t iTriangle = Draw.StartIndexLocation / 3; iTriangle < (Draw.StartIndexLocation + Draw.IndexCountPerInstance) / 3; ++iTriangle)
+			{
+				vIsDrawn[iTriangle] = true;
+			}
+		}
+
+		const XMMATRIX KWorldViewProjection{ Path.World * KViewProjection };
+		for (size_t iTriangle = 0; iTriangle < Mesh.vTriangles.size(); ++iTriangle)
+		{
+			if (vIsDrawn[iTriangle]) continue;
+
+			const STriangle& Triangle{ Mesh.vTriangles[iTriangle] };
+			const uint32_t KIDs[3]{ Triangle.I0, Triangle.I1, Triangle.I2 };
+			XMVECTOR WorldPositions[3]{};
+			XMVECTOR ClipPositions[3]{};
+			for (uint32_t iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				WorldPositions[iCorner] = XMVector3TransformCoord(Mesh.vVertices[KIDs[iCorner]].Position, Path.World);
+				ClipPositions[iCorner] = XMVector4Transform(XMVectorSetW(Mesh.vVertices[KIDs[iCorner]].Position, 1), KWorldViewProjection);
+			}
+			const XMVECTOR KFaceNormal{ XMVector3Cross(WorldPositions[1] - WorldPositions[0], WorldPositions[2] - WorldPositions[0]) };
+			if (XMVectorGetX(XMVector3Dot(KFaceNormal, KEye - WorldPositions[0])) <= 0) continue;
+
+			// Outside if all three corners are beyond the same clip plane
+			bool bIsOutside{};
+			for (uint32_t iAxis = 0; iAxis < 3 && !bIsOutside; ++iAxis)
+			{
+				bool bAllBelow{ true };
+				bool bAllAbove{ true };
+				for (const XMVECTOR& Clip : ClipPositions)
+				{
+					const float KW{ XMVectorGetW(Clip) };
+					const float KValue{ Clip.m128_f32[iAxis] };
+					bAllBelow = bAllBelow && KValue < ((iAxis == 2) ? 0.0f : -KW);
+					bAllAbove = bAllAbove && KValue > KW;
+				}
+				bIsOutside = bAllBelow || bAllAbove;
+			}
+			if (!bIsOutside) ++(*PtrOutWronglyCulledCount);
+		}
+	}
+	return Stats;
+}
+
+TEST_CASE(MeshletBuilder_RespectsLimitsAndCoversMesh)
+{
+	const SMesh KMesh{ GenerateSphere(64, 10.0f) };
+	vector<SMeshlet> vMeshlets{};
+	CMeshletBuilder::BuildMeshlets(KMesh, vMeshlets);
+	CHECK(!vMeshlets.empty());
+
+	uint32_t ExpectedOffset{};
+	bool bIsContiguous{ true };
+	size_t WrongVertexCount{};
+	for (const SMeshlet& Meshlet : vMeshlets)
+	{
+		CHECK(Meshlet.TriangleCount > 0);
+		CHECK(Meshlet.TriangleCount <= CMeshletBuilder::KMaxTriangleCount);
+		CHECK(Meshlet.VertexCount <= CMeshletBuilder::KMaxVertexCount);
+		bIsContiguous = bIsContiguous && Meshlet.TriangleOffset == ExpectedOffset;
+		ExpectedOffset += Meshlet.TriangleCount;
+
+		vector<uint32_t> vVertexIDs{};
+		for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < Meshlet.TriangleOffset + Meshlet.TriangleCount; ++iTriangle)
+		{
+			const STriangle& Triangle{ KMesh.vTriangles[iTriangle] };
+			vVertexIDs.insert(vVertexIDs.end(), { Triangle.I0, Triangle.I1, Triangle.I2 });
+		}
+		std::sort(vVertexIDs.begin(), vVertexIDs.end());
+		const size_t KUniqueVertexCount{ static_cast<size_t>(std::unique(vVertexIDs.begin(), vVertexIDs.end()) - vVertexIDs.begin()) };
+		if (KUniqueVertexCount != Meshlet.VertexCount) ++WrongVertexCount;
+	}
+	CHECK(bIsContiguous);
+	CHECK(ExpectedOffset == KMesh.vTriangles.size());
+	CHECK(WrongVertexCount == 0);
+	printf("%zu triangles -> %zu meshlets (%.1f triangles each)\n", KMesh.vTriangles.size(), vMeshlets.size(),
+		static_cast<double>(KMesh.vTriangles.size()) / vMeshlets.size());
+}
+
+TEST_CASE(MeshletBuilder_BoundsContainTriangles)
+{
+	const SMesh KMesh{ GenerateSphere(48, 10.0f) };
+	vector<SMeshlet> vMeshlets{};
+	CMeshletBuilder::BuildMeshlets(KMesh, vMeshlets);
+
+	size_t OutsideVertexCount{};
+	size_t OutsideConeCount{};
+	for (const SMeshlet& Meshlet : vMeshlets)
+	{
+		const XMVECTOR KCenter{ XMLoadFloat3(&Meshlet.BoundingSphereCenter) };
+		const XMVECTOR KAxis{ XMLoadFloat3(&Meshlet.ConeAxis) };
+		for (uint32_t iTriangle = Meshlet.TriangleOffset; iTriangle < Meshlet.TriangleOffset + Meshlet.TriangleCount; ++iTriangle)
+		{
+			const STriangle& Triangle{ KMesh.vTriangles[iTriangle] };
+			const XMVECTOR KP0{ XMVectorSetW(KMesh.vVertices[Triangle.I0].Position, 0) };
+			const XMVECTOR KP1{ XMVectorSetW(KMesh.vVertices[Triangle.I1].Position, 0) };
+			const XMVECTOR KP2{ XMVectorSetW(KMesh.vVertices[Triangle.I2].Position, 0) };
+			for (const XMVECTOR& Position : { KP0, KP1, KP2 })
+			{
+				if (XMVectorGetX(XMVector3Length(Position - KCenter)) > Meshlet.BoundingSphereRadius * 1.0001f + 1e-5f) ++OutsideVertexCount;
+			}
+
+			// Every face normal must be inside the cone (cutoff = sin of the half angle, see SMeshlet)
+			if (Meshlet.ConeCutoff < 1.0f)
+			{
+				const XMVECTOR KFaceNormal{ XMVector3Normalize(XMVector3Cross(KP1 - KP0, KP2 - KP0)) };
+				const float KCosine{ XMVectorGetX(XMVector3Dot(KFaceNormal, KAxis)) };
+				if (KCosine < sqrtf(max(0.0f, 1.0f - Meshlet.ConeCutoff * Meshlet.ConeCutoff)) - 1e-4f) ++OutsideConeCount;
+			}
+		}
+	}
+	CHECK(OutsideVertexCount == 0);
+	CHECK(OutsideConeCount == 0);
+}
+
+TEST_CASE(MeshletCuller_NeverCullsVisibleTriangles)
+{
+	const SMesh KMesh{ GenerateSphere(64, 10.0f) };
+	vector<SMeshlet> vMeshlets{};
+	CMeshletBuilder::BuildMeshlets(KMesh, vMeshlets);
+
+	const SCameraPath KPaths[]
+	{
+		{ "far", XMMatrixIdentity(), 40.0f },
+		{ "near", XMMatrixIdentity(), 14.0f },
+		{ "scaled", XMMatrixScaling(2, 2, 2), 60.0f },
+		{ "non-uniformly scaled", XMMatrixScaling(1, 2, 1), 40.0f },
+	};
+	for (const SCameraPath& Path : KPaths)
+	{
+		size_t WronglyCulledCount{};
+		const CMeshletCuller::SStats KStats{ RunCameraPath(KMesh, vMeshlets, Path, &WronglyCulledCount) };
+		printf("%s: %.1f%% of the triangles culled (frustum %zu, cone %zu meshlets)\n", Path.Name,
+			100.0 * (KStats.TriangleCount - KStats.VisibleTriangleCount) / KStats.TriangleCount, KStats.FrustumCulledCount, KStats.ConeCulledCount);
+		CHECK(WronglyCulledCount == 0);
+		CHECK(KStats.VisibleTriangleCount < KStats.TriangleCount);
+		CHECK(KStats.DrawCount <= KStats.VisibleMeshletCount);
+	}
+}
+
+TEST_CASE(MeshletCuller_ConeCullsBackFacingClusters)
+{
+	const SMesh KMesh{ GenerateSphere(64, 10.0f) };
+	vector<SMeshlet> vMeshlets{};
+	CMeshletBuilder::BuildMeshlets(KMesh, vMeshlets);
+
+	// The whole sphere is on screen, so only cone culling can reject meshlets (those whose cones are narrow enough on the far side)
+	const XMVECTOR KEye{ XMVectorSet(0, 0, -60, 1) };
+	const XMMATRIX KViewProjection{ XMMatrixLookAtLH(KEye, XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.1f, 1000.0f) };
+	const CMeshletCuller::SFrustum KFrustum{ CMeshletCuller::ExtractFrustum(KViewProjection) };
+
+	vector<SDrawIndexedArgs> vDraws{};
+	CMeshletCuller::SStats Stats{};
+	CMeshletCuller::CullMeshlets(vMeshlets, XMMatrixIdentity(), KFrustum, KEye, vDraws, CMeshletCuller::SDesc(), &Stats);
+	printf("%zu of %zu meshlets cone culled\n", Stats.ConeCulledCount, vMeshlets.size());
+	CHECK(Stats.FrustumCulledCount == 0);
+	CHECK(Stats.ConeCulledCount > vMeshlets.size() / 8);
+
+	// Non-uniform scaling bends the normals, so cone culling must be skipped
+	vDraws.clear();
+	CMeshletCuller::SStats ScaledStats{};
+	CMeshletCuller::CullMeshlets(vMeshlets, XMMatrixScaling(1, 1.5f, 1), KFrustum, KEye, vDraws, CMeshletCuller::SDesc(), &ScaledStats);
+	CHECK(ScaledStats.ConeCulledCount == 0);
+
+	// Distance culling
+	CMeshletCuller::SDesc NearDesc{};
+	NearDesc.MaxDistance = 55.0f;
+	vDraws.clear();
+	CMeshletCuller::SStats NearStats{};
+	CMeshletCuller::CullMeshlets(vMeshlets, XMMatrixIdentity(), KFrustum, KEye, vDraws, NearDesc, &NearStats);
+	CHECK(NearStats.DistanceCulledCount > 0);
+	CHECK(NearStats.VisibleMeshletCount < Stats.VisibleMeshletCount);
+}
+
+TEST_CASE(MeshletCuller_ExtractFrustumPlanes)
+{
+	const XMVECTOR KEye{ XMVectorSet(0, 0, -10, 1) };
+	const XMMATRIX KViewProjection{ XMMatrixLookAtLH(KEye, XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f) };
+	const CMeshletCuller::SFrustum KFrustum{ CMeshletCuller::ExtractFrustum(KViewProjection) };
+
+	CHECK(CMeshletCuller::IsSphereInFrustum(KFrustum, XMVectorSet(0, 0, 0, 1), 0.1f));
+	CHECK(!CMeshletCuller::IsSphereInFrustum(KFrustum, XMVectorSet(0, 0, -20, 1), 1.0f)); // Behind the eye
+	CHECK(!CMeshletCuller::IsSphereInFrustum(KFrustum, XMVectorSet(0, 0, 100, 1), 1.0f)); // Beyond the far plane
+	CHECK(!CMeshletCuller::IsSphereInFrustum(KFrustum, XMVectorSet(30, 0, 0, 1), 1.0f)); // Right of the 90 degree view
+	CHECK(CMeshletCuller::IsSphereInFrustum(KFrustum, XMVectorSet(30, 0, 0, 1), 25.0f)); // ... but large enough to reach into it
+	for (const XMFLOAT4& Plane : KFrustum.Planes)
+	{
+		CHECK_NEAR(sqrtf(Plane.x * Plane.x + Plane.y * Plane.y + Plane.z * Plane.z), 1.0, 1e-4);
+	}
+}
+
+BENCH_CASE(MeshletCuller_CameraPaths)
+{
+	SMesh Mesh{ GenerateSphere(256, 10.0f) };
+	vector<SMeshlet> vMeshlets{};
+	CTestTimer Timer{};
+	CMeshletBuilder::BuildMeshlets(Mesh, vMeshlets);
+	printf("%zu triangles -> %zu meshlets in %.2f ms\n", Mesh.vTriangles.size(), vMeshlets.size(), Timer.GetElapsedMilliseconds());
+
+	const SCameraPath KPaths[]
+	{
+		{ "orbit far (d = 40)", XMMatrixIdentity(), 40.0f },
+		{ "orbit near (d = 14)", XMMatrixIdentity(), 14.0f },
+		{ "scaled x2 (d = 60)", XMMatrixScaling(2, 2, 2), 60.0f },
+		{ "non-uniform (d = 40)", XMMatrixScaling(1, 2, 1), 40.0f },
+	};
+	for (const SCameraPath& Path : KPaths)
+	{
+		double Milliseconds{};
+		const CMeshletCuller::SStats KStats{ RunCameraPath(Mesh, vMeshlets, Path, nullptr, &Milliseconds) };
+		const size_t KFrameCount{ 72 };
+		printf("%-22s %5.1f%% of the triangles culled (frustum %zu, cone %zu, distance %zu of %zu meshlets), %.1f draws, %.3f ms per frame\n",
+			Path.Name, 100.0 * (KStats.TriangleCount - KStats.VisibleTriangleCount) / KStats.TriangleCount, KStats.FrustumCulledCount,
+			KStats.ConeCulledCount, KStats.DistanceCulledCount, KStats.MeshletCount, static_cast<double>(KStats.DrawCount) / KFrameCount,
+			Milliseconds / KFrameCount);
+	}
+}
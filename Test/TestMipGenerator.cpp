@@ -0,0 +1,257 @@
+#include "Test.h"
+#include "Core/MipGenerator.h"
+#include <random>
+
+static const char* const KFilterNames[]{ "Box", "Kaiser", "Lanczos" };
+
+// Grass blades that taper to their tips with soft edges, like an alpha-tested blade opacity texture
+static vector<SPixel32UInt> GenerateBladeImage(uint32_t Width, uint32_t Height)
+{
+	constexpr uint32_t KBladeSpacing{ 16 };
+	vector<SPixel32UInt> vPixels(static_cast<size_t>(Width) * Height);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			const float KHalfWidth{ 3.0f * Y / Height };
+			const float KDistance{ fabsf(static_cast<float>(X % KBladeSpacing) + 0.5f - KBladeSpacing / 2.0f) };
+			SPixel32UInt& Pixel{ vPixels[static_cast<size_t>(Y) * Width + X] };
+			Pixel.R = 40;
+			Pixel.G = static_cast<uint8_t>(100 + Y * 100 / Height);
+			Pixel.B = 20;
+			Pixel.A = static_cast<uint8_t>(min(max(KHalfWidth - KDistance + 0.5f, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+	}
+	return vPixels;
+}
+
+static float CalculateCoverage(const vector<SPixel32UInt>& vPixels, float Reference)
+{
+	size_t CoveredCount{};
+	for (const SPixel32UInt& Pixel : vPixels)
+	{
+		if (Pixel.A / 255.0f > Reference) ++CoveredCount;
+	}
+	return static_cast<float>(CoveredCount) / static_cast<float>(vPixels.size());
+}
+
+TEST_CASE(MipGenerator_BoxMatchesScalarAverage)
+{
+	std::mt19937 Random{ 27 };
+	for (uint32_t Width : { 1u, 2u, 7u, 64u, 100u })
+	{
+		for (uint32_t Height : { 1u, 3u, 64u, 33u })
+		{
+			if (Width == 1 && Height == 1) continue;
+
+			vector<SPixel8UInt> vPixels(static_cast<size_t>(Width) * Height);
+			for (SPixel8UInt& Pixel : vPixels) Pixel.R = static_cast<uint8_t>(Random() % 256);
+			vector<CMipGenerator::SMipLevel<SPixel8UInt>> vMipChain{};
+			CMipGenerator::GenerateMipChain(vPixels.data(), Width, Height, CMipGenerator::SDesc(), vMipChain);
+			CHECK(vMipChain.size() + 1 == CMipGenerator::GetMipCount(Width, Height));
+			CHECK(vMipChain.back().Width == 1 && vMipChain.back().Height == 1);
+
+			// Even sizes average 2 x 2 texels; odd ones spread the last texel over its neighbours, which the filter table handles
+			const CMipGenerator::SMipLevel<SPixel8UInt>& KMip1{ vMipChain[0] };
+			CHECK(KMip1.Width == max(Width / 2, 1u) && KMip1.Height == max(Height / 2, 1u));
+			if (Width % 2 || Height % 2) continue;
+
+			int MaxDifference{};
+			for (uint32_t Y = 0; Y < KMip1.Height; ++Y)
+			{
+				for (uint32_t X = 0; X < KMip1.Width; ++X)
+				{
+					const int KSum{ vPixels[(2 * Y) * Width + 2 * X].R + vPixels[(2 * Y) * Width + 2 * X + 1].R +
+						vPixels[(2 * Y + 1) * Width + 2 * X].R + vPixels[(2 * Y + 1) * Width + 2 * X + 1].R };
+					MaxDifference = max(MaxDifference, abs(KMip1.vPixels[Y * KMip1.Width + X].R - (KSum + 2) / 4));
+				}
+			}
+			CHECK(MaxDifference <= 1);
+		}
+	}
+}
+
+TEST_CASE(MipGenerator_FiltersAndSRGB)
+{
+	// Constant images stay constant with every filter (the weights are normalized)
+	for (int iFilter = 0; iFilter < 3; ++iFilter)
+	{
+		vector<SPixel32UInt> vPixels(64 * 48, SPixel32UInt{ 10, 120, 200, 255 });
+		vector<CMipGenerator::SMipLevel<SPixel32UInt>> vMipChain{};
+		CMipGenerator::GenerateMipChain(vPixels.data(), 64, 48, CMipGenerator::SDesc(static_cast<CMipGenerator::EFilter>(iFilter)), vMipChain);
+		size_t WrongCount{};
+		for (const auto& Level : vMipChain)
+		{
+			for (const SPixel32UInt& Pixel : Level.vPixels)
+			{
+				if (abs(Pixel.R - 10) > 1 || abs(Pixel.G - 120) > 1 || abs(Pixel.B - 200) > 1 || Pixel.A < 254) ++WrongCount;
+			}
+		}
+		CHECK(WrongCount == 0);
+	}
+
+	// A black and white checker averages to half the light: 128 in linear space, 188 once encoded as sRGB (alpha stays linear)
+	vector<SPixel32UInt> vChecker(32 * 32);
+	for (uint32_t iPixel = 0; iPixel < vChecker.size(); ++iPixel)
+	{
+		const uint8_t KValue{ static_cast<uint8_t>((((iPixel % 32) + (iPixel / 32)) % 2) ? 255 : 0) };
+		vChecker[iPixel] = SPixel32UInt{ KValue, KValue, KValue, KValue };
+	}
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vLinear{};
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vSRGB{};
+	CMipGenerator::GenerateMipChain(vChecker.data(), 32, 32, CMipGenerator::SDesc(CMipGenerator::EFilter::Box, false), vLinear);
+	CMipGenerator::GenerateMipChain(vChecker.data(), 32, 32, CMipGenerator::SDesc(CMipGenerator::EFilter::Box, true), vSRGB);
+	CHECK(abs(vLinear[0].vPixels[5].R - 128) <= 1);
+	CHECK(abs(vSRGB[0].vPixels[5].R - 188) <= 1);
+	CHECK(abs(vSRGB[0].vPixels[5].A - 128) <= 1);
+}
+
+TEST_CASE(MipGenerator_PreservesAlphaCoverage)
+{
+	constexpr uint32_t KSize{ 256 };
+	constexpr float KReference{ 0.5f };
+	const vector<SPixel32UInt> KPixels{ GenerateBladeImage(KSize, KSize) };
+	const float KTargetCoverage{ CalculateCoverage(KPixels, KReference) };
+
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vPlain{};
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vPreserved{};
+	CMipGenerator::GenerateMipChain(KPixels.data(), KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser, true), vPlain);
+	CMipGenerator::GenerateMipChain(KPixels.data(), KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser, true, true, KReference),
+		vPreserved);
+
+	// Levels of 16 x 16 texels or more; smaller ones can't represent the coverage finely enough
+	float MaxPlainError{};
+	float MaxPreservedError{};
+	for (size_t iLevel = 0; iLevel < vPlain.size() && vPlain[iLevel].Width >= 16; ++iLevel)
+	{
+		const float KPlainCoverage{ CalculateCoverage(vPlain[iLevel].vPixels, KReference) };
+		const float KPreservedCoverage{ CalculateCoverage(vPreserved[iLevel].vPixels, KReference) };
+		printf("Mip %zu: coverage %.3f (mip 0 %.3f), %.3f preserved\n", iLevel + 1, KPlainCoverage, KTargetCoverage, KPreservedCoverage);
+		MaxPlainError = max(MaxPlainError, fabsf(KPlainCoverage - KTargetCoverage));
+		MaxPreservedError = max(MaxPreservedError, fabsf(KPreservedCoverage - KTargetCoverage));
+
+		// Only alpha is rescaled
+		CHECK(memcmp(&vPlain[iLevel].vPixels[7], &vPreserved[iLevel].vPixels[7], 3) == 0);
+	}
+	CHECK(MaxPreservedError < 0.03f);
+	CHECK(MaxPlainError > 2.0f * MaxPreservedError);
+}
+
+TEST_CASE(MipGenerator_IncrementalMatchesFull)
+{
+	std::mt19937 Random{ 3 };
+	size_t MismatchCount{};
+	size_t OutsideRectCount{};
+	for (int iFilter = 0; iFilter < 3; ++iFilter)
+	{
+		const CMipGenerator::SDesc KDesc(static_cast<CMipGenerator::EFilter>(iFilter), iFilter == 1);
+		constexpr uint32_t KWidth{ 300 };
+		constexpr uint32_t KHeight{ 170 };
+		vector<SPixel32UInt> vColors(KWidth * KHeight);
+		vector<SPixel8UInt> vHeights(KWidth * KHeight);
+		for (size_t iPixel = 0; iPixel < vColors.size(); ++iPixel)
+		{
+			vColors[iPixel] = SPixel32UInt{ static_cast<uint8_t>(Random()), static_cast<uint8_t>(Random()), static_cast<uint8_t>(Random()), 255 };
+			vHeights[iPixel].R = static_cast<uint8_t>(Random());
+		}
+		vector<CMipGenerator::SMipLevel<SPixel32UInt>> vColorMips{};
+		vector<CMipGenerator::SMipLevel<SPixel8UInt>> vHeightMips{};
+		CMipGenerator::GenerateMipChain(vColors.data(), KWidth, KHeight, KDesc, vColorMips);
+		CMipGenerator::GenerateMipChain(vHeights.data(), KWidth, KHeight, KDesc, vHeightMips);
+
+		for (int iEdit = 0; iEdit < 20; ++iEdit)
+		{
+			// Brush-sized rects, including ones at the borders
+			CMipGenerator::SRect Rect{};
+			Rect.Left = Random() % KWidth;
+			Rect.Top = Random() % KHeight;
+			Rect.Right = min(Rect.Left + 1 + static_cast<uint32_t>(Random() % 40), KWidth);
+			Rect.Bottom = min(Rect.Top + 1 + static_cast<uint32_t>(Random() % 40), KHeight);
+			for (uint32_t Y = Rect.Top; Y < Rect.Bottom; ++Y)
+			{
+				for (uint32_t X = Rect.Left; X < Rect.Right; ++X)
+				{
+					vColors[Y * KWidth + X].R = static_cast<uint8_t>(Random());
+					vHeights[Y * KWidth + X].R = static_cast<uint8_t>(Random());
+				}
+			}
+
+			const vector<CMipGenerator::SMipLevel<SPixel32UInt>> KColorMipsBefore{ vColorMips };
+			vector<CMipGenerator::SRect> vColorRects{};
+			vector<CMipGenerator::SRect> vHeightRects{};
+			CMipGenerator::UpdateMipChain(vColors.data(), KWidth, KHeight, KDesc, Rect, vColorMips, vColorRects);
+			CMipGenerator::UpdateMipChain(vHeights.data(), KWidth, KHeight, KDesc, Rect, vHeightMips, vHeightRects);
+
+			vector<CMipGenerator::SMipLevel<SPixel32UInt>> vColorReference{};
+			vector<CMipGenerator::SMipLevel<SPixel8UInt>> vHeightReference{};
+			CMipGenerator::GenerateMipChain(vColors.data(), KWidth, KHeight, KDesc, vColorReference);
+			CMipGenerator::GenerateMipChain(vHeights.data(), KWidth, KHeight, KDesc, vHeightReference);
+			for (size_t iLevel = 0; iLevel < vColorReference.size(); ++iLevel)
+			{
+				const auto& KLevel{ vColorReference[iLevel] };
+				if (memcmp(KLevel.vPixels.data(), vColorMips[iLevel].vPixels.data(), KLevel.vPixels.size() * sizeof(SPixel32UInt))) ++MismatchCount;
+				if (memcmp(vHeightReference[iLevel].vPixels.data(), vHeightMips[iLevel].vPixels.data(), vHeightReference[iLevel].vPixels.size()))
+				{
+					++MismatchCount;
+				}
+
+				// Texels outside the reported rects didn't change
+				const CMipGenerator::SRect& KRect{ vColorRects[iLevel] };
+				for (uint32_t Y = 0; Y < KLevel.Height; ++Y)
+				{
+					for (uint32_t X = 0; X < KLevel.Width; ++X)
+					{
+						if (X >= KRect.Left && X < KRect.Right && Y >= KRect.Top && Y < KRect.Bottom) continue;
+						if (memcmp(&KLevel.vPixels[Y * KLevel.Width + X], &KColorMipsBefore[iLevel].vPixels[Y * KLevel.Width + X], 4)) ++OutsideRectCount;
+					}
+				}
+			}
+		}
+	}
+	CHECK(MismatchCount == 0);
+	CHECK(OutsideRectCount == 0);
+}
+
+BENCH_CASE(MipGenerator_MegaPixelsPerSecond)
+{
+	constexpr uint32_t KSize{ 2048 };
+	const vector<SPixel32UInt> KColors{ GenerateBladeImage(KSize, KSize) };
+	for (int iFilter = 0; iFilter < 3; ++iFilter)
+	{
+		for (bool bIsSRGB : { false, true })
+		{
+			vector<CMipGenerator::SMipLevel<SPixel32UInt>> vMipChain{};
+			CTestTimer Timer{};
+			CMipGenerator::GenerateMipChain(KColors.data(), KSize, KSize, CMipGenerator::SDesc(static_cast<CMipGenerator::EFilter>(iFilter), bIsSRGB),
+				vMipChain);
+			const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+			printf("RGBA %u x %u, %-7s%s: %6.1f ms, %6.1f MPix/s of source\n", KSize, KSize, KFilterNames[iFilter], (bIsSRGB) ? " sRGB" : "     ",
+				KMilliseconds, KSize * KSize / 1000.0 / KMilliseconds);
+		}
+	}
+
+	CTestTimer Timer{};
+	vector<CMipGenerator::SMipLevel<SPixel32UInt>> vMipChain{};
+	CMipGenerator::GenerateMipChain(KColors.data(), KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Kaiser, true, true), vMipChain);
+	printf("RGBA %u x %u, Kaiser sRGB with alpha coverage: %.1f ms\n", KSize, KSize, Timer.GetElapsedMilliseconds());
+
+	// The terrain's height map: a full chain, then brush-sized updates
+	vector<SPixel8UInt> vHeights(KSize * KSize);
+	for (size_t iPixel = 0; iPixel < vHeights.size(); ++iPixel) vHeights[iPixel].R = static_cast<uint8_t>(iPixel * 7 / 5);
+	vector<CMipGenerator::SMipLevel<SPixel8UInt>> vHeightMips{};
+	Timer = CTestTimer();
+	CMipGenerator::GenerateMipChain(vHeights.data(), KSize, KSize, CMipGenerator::SDesc(), vHeightMips);
+	const double KFullMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+	constexpr int KUpdateCount{ 200 };
+	vector<CMipGenerator::SRect> vDirtyRects{};
+	Timer = CTestTimer();
+	for (int iUpdate = 0; iUpdate < KUpdateCount; ++iUpdate)
+	{
+		const uint32_t KLeft{ static_cast<uint32_t>(iUpdate * 9) % (KSize - 64) };
+		CMipGenerator::UpdateMipChain(vHeights.data(), KSize, KSize, CMipGenerator::SDesc(), CMipGenerator::SRect{ KLeft, 1000, KLeft + 64, 1064 },
+			vHeightMips, vDirtyRects);
+	}
+	printf("R8 %u x %u, Box: full chain %.1f ms (%.1f MPix/s), 64 x 64 brush update %.3f ms\n", KSize, KSize, KFullMilliseconds,
+		KSize * KSize / 1000.0 / KFullMilliseconds, Timer.GetElapsedMilliseconds() / KUpdateCount);
+}
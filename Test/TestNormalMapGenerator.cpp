@@ -0,0 +1,217 @@
+#include "Test.h"
+#include "Core/NormalMapGenerator.h"
+#include <random>
+
+// Scalar Sobel filter with clamped taps, in the same float operations as the 4-wide path
+static void GenerateNormalMapReference(const vector<SPixel8UInt>& vHeights, uint32_t Width, uint32_t Height,
+	const CNormalMapGenerator::SDesc& Desc, vector<SPixel16Int>& vOutNormals)
+{
+	auto GetHeight{ [&](int U, int V)
+		{
+			U = min(max(U, 0), static_cast<int>(Width) - 1);
+			V = min(max(V, 0), static_cast<int>(Height) - 1);
+			return static_cast<float>(vHeights[static_cast<size_t>(V) * Width + U].R);
+		} };
+
+	vOutNormals.assign(static_cast<size_t>(Width) * Height, SPixel16Int{});
+	for (int V = 0; V < static_cast<int>(Height); ++V)
+	{
+		for (int U = 0; U < static_cast<int>(Width); ++U)
+		{
+			const float KGradientU{ (GetHeight(U + 1, V - 1) - GetHeight(U - 1, V - 1)) + 2 * (GetHeight(U + 1, V) - GetHeight(U - 1, V)) +
+				(GetHeight(U + 1, V + 1) - GetHeight(U - 1, V + 1)) };
+			const float KGradientV{ (GetHeight(U - 1, V + 1) - GetHeight(U - 1, V - 1)) + 2 * (GetHeight(U, V + 1) - GetHeight(U, V - 1)) +
+				(GetHeight(U + 1, V + 1) - GetHeight(U + 1, V - 1)) };
+
+			// dH/dX = GradientU * HeightScale / (8 * spacing), and +V is -Z
+			const float KNormalX{ KGradientU * -Desc.HeightScale };
+			const float KNormalY{ 8.0f * Desc.TexelSpacing };
+			const float KNormalZ{ KGradientV * Desc.HeightScale };
+			const float KScale{ CNormalMapGenerator::KEncodingScale / (fabsf(KNormalX) + KNormalY + fabsf(KNormalZ)) };
+			vOutNormals[static_cast<size_t>(V) * Width + U].R = static_cast<int8_t>(nearbyintf(KNormalX * KScale));
+			vOutNormals[static_cast<size_t>(V) * Width + U].G = static_cast<int8_t>(nearbyintf(KNormalZ * KScale));
+		}
+	}
+}
+
+static vector<SPixel8UInt> GenerateHeights(uint32_t Width, uint32_t Height, std::mt19937& Random)
+{
+	vector<SPixel8UInt> vHeights(static_cast<size_t>(Width) * Height);
+	for (uint32_t V = 0; V < Height; ++V)
+	{
+		for (uint32_t U = 0; U < Width; ++U)
+		{
+			const float KValue{ 127.0f + 60.0f * sinf(U * 0.05f) * cosf(V * 0.07f) + static_cast<float>(Random() % 40) - 20.0f };
+			vHeights[static_cast<size_t>(V) * Width + U].R = static_cast<uint8_t>(min(max(KValue, 0.0f), 255.0f));
+		}
+	}
+	return vHeights;
+}
+
+static size_t CountMismatches(const vector<SPixel16Int>& vA, const vector<SPixel16Int>& vB, int* const PtrOutMaxDifference = nullptr)
+{
+	size_t MismatchCount{};
+	int MaxDifference{};
+	for (size_t iTexel = 0; iTexel < vA.size(); ++iTexel)
+	{
+		const int KDifference{ max(abs(vA[iTexel].R - vB[iTexel].R), abs(vA[iTexel].G - vB[iTexel].G)) };
+		if (KDifference) ++MismatchCount;
+		MaxDifference = max(MaxDifference, KDifference);
+	}
+	if (PtrOutMaxDifference) *PtrOutMaxDifference = MaxDifference;
+	return MismatchCount;
+}
+
+TEST_CASE(NormalMapGenerator_MatchesScalarReference)
+{
+	std::mt19937 Random{ 43 };
+	const CNormalMapGenerator::SDesc KDesc{ 10.0f / 255.0f };
+
+	// Sizes around the 4-wide path's edges
+	size_t MismatchCount{};
+	int MaxDifference{};
+	for (uint32_t Width : { 1u, 2u, 3u, 5u, 6u, 9u, 17u, 33u, 64u, 101u })
+	{
+		for (uint32_t Height : { 1u, 2u, 7u, 33u })
+		{
+			const vector<SPixel8UInt> KHeights{ GenerateHeights(Width, Height, Random) };
+			vector<SPixel16Int> vNormals{};
+			vector<SPixel16Int> vReference{};
+			CNormalMapGenerator::GenerateNormalMap(KHeights.data(), Width, Height, KDesc, vNormals);
+			GenerateNormalMapReference(KHeights, Width, Height, KDesc, vReference);
+			int Difference{};
+			MismatchCount += CountMismatches(vNormals, vReference, &Difference);
+			MaxDifference = max(MaxDifference, Difference);
+		}
+	}
+	printf("%zu mismatches against the scalar reference (max difference %d)\n", MismatchCount, MaxDifference);
+	CHECK(MismatchCount == 0);
+
+	// White noise with steep slopes and a non-unit spacing
+	constexpr uint32_t KWidth{ 257 };
+	constexpr uint32_t KHeight{ 129 };
+	vector<SPixel8UInt> vNoise(KWidth * KHeight);
+	for (SPixel8UInt& Texel : vNoise) Texel.R = static_cast<uint8_t>(Random() % 256);
+	const CNormalMapGenerator::SDesc KSteepDesc{ 1.0f, 0.5f };
+	vector<SPixel16Int> vNormals{};
+	vector<SPixel16Int> vReference{};
+	CNormalMapGenerator::GenerateNormalMap(vNoise.data(), KWidth, KHeight, KSteepDesc, vNormals);
+	GenerateNormalMapReference(vNoise, KWidth, KHeight, KSteepDesc, vReference);
+	CHECK(CountMismatches(vNormals, vReference) == 0);
+}
+
+TEST_CASE(NormalMapGenerator_EncodingRoundTrip)
+{
+	// Any direction, including the folded lower hemisphere
+	std::mt19937 Random{ 7 };
+	double MaxDegrees{};
+	for (int iNormal = 0; iNormal < 20'000; ++iNormal)
+	{
+		const XMVECTOR KNormal{ XMVector3Normalize(XMVectorSet(static_cast<float>(Random() % 2001) / 1000.0f - 1.0f,
+			static_cast<float>(Random() % 2001) / 1000.0f - 1.0f, static_cast<float>(Random() % 2001) / 1000.0f - 1.0f, 0)) };
+		const XMVECTOR KDecoded{ CNormalMapGenerator::DecodeNormal(CNormalMapGenerator::EncodeNormal(KNormal)) };
+		const float KCosine{ min(XMVectorGetX(XMVector3Dot(KNormal, KDecoded)), 1.0f) };
+		MaxDegrees = max(MaxDegrees, acos(static_cast<double>(KCosine)) * 180.0 / XM_PI);
+	}
+	printf("EncodeNormal -> DecodeNormal: max %.3f degrees\n", MaxDegrees);
+	CHECK(MaxDegrees < 1.0);
+
+	// Straight up and the axes of the upper hemisphere
+	CHECK(CNormalMapGenerator::EncodeNormal(XMVectorSet(0, 1, 0, 0)).R == 0);
+	CHECK(CNormalMapGenerator::EncodeNormal(XMVectorSet(0, 1, 0, 0)).G == 0);
+	CHECK(CNormalMapGenerator::EncodeNormal(XMVectorSet(1, 0, 0, 0)).R == 127);
+	CHECK(CNormalMapGenerator::EncodeNormal(XMVectorSet(0, 0, -1, 0)).G == -127);
+}
+
+TEST_CASE(NormalMapGenerator_IncrementalMatchesFull)
+{
+	std::mt19937 Random{ 5 };
+	constexpr uint32_t KSize{ 257 };
+	const CNormalMapGenerator::SDesc KDesc{ 10.0f / 255.0f };
+	vector<SPixel8UInt> vHeights{ GenerateHeights(KSize, KSize, Random) };
+	vector<SPixel16Int> vIncremental{};
+	CNormalMapGenerator::GenerateNormalMap(vHeights.data(), KSize, KSize, KDesc, vIncremental);
+
+	size_t WrongUpdatedRectCount{};
+	for (int iStroke = 0; iStroke < 500; ++iStroke)
+	{
+		// Brush-sized edits, including ones touching the edges
+		const int KCenterX{ static_cast<int>(Random() % KSize) };
+		const int KCenterY{ static_cast<int>(Random() % KSize) };
+		const int KHalfSize{ static_cast<int>(Random() % 6) };
+		CMipGenerator::SRect DirtyRect{};
+		DirtyRect.Left = static_cast<uint32_t>(max(KCenterX - KHalfSize, 0));
+		DirtyRect.Top = static_cast<uint32_t>(max(KCenterY - KHalfSize, 0));
+		DirtyRect.Right = static_cast<uint32_t>(min(KCenterX + KHalfSize + 1, static_cast<int>(KSize)));
+		DirtyRect.Bottom = static_cast<uint32_t>(min(KCenterY + KHalfSize + 1, static_cast<int>(KSize)));
+		for (uint32_t Y = DirtyRect.Top; Y < DirtyRect.Bottom; ++Y)
+		{
+			for (uint32_t X = DirtyRect.Left; X < DirtyRect.Right; ++X)
+			{
+				SPixel8UInt& Texel{ vHeights[static_cast<size_t>(Y) * KSize + X] };
+				Texel.R = static_cast<uint8_t>(min(255, Texel.R + 1 + static_cast<int>(Random() % 3)));
+			}
+		}
+
+		CMipGenerator::SRect UpdatedRect{};
+		CNormalMapGenerator::UpdateNormalMap(vHeights.data(), KSize, KSize, KDesc, DirtyRect, vIncremental, UpdatedRect);
+		if (UpdatedRect.Left != (DirtyRect.Left ? DirtyRect.Left - 1 : 0) || UpdatedRect.Bottom != min(DirtyRect.Bottom + 1, KSize))
+		{
+			++WrongUpdatedRectCount;
+		}
+	}
+	CHECK(WrongUpdatedRectCount == 0);
+
+	vector<SPixel16Int> vFull{};
+	CNormalMapGenerator::GenerateNormalMap(vHeights.data(), KSize, KSize, KDesc, vFull);
+	CHECK(CountMismatches(vIncremental, vFull) == 0);
+
+	// A normal map of the wrong size is regenerated as a whole
+	vector<SPixel16Int> vEmpty{};
+	CMipGenerator::SRect UpdatedRect{};
+	CNormalMapGenerator::UpdateNormalMap(vHeights.data(), KSize, KSize, KDesc, CMipGenerator::SRect{ 0, 0, 1, 1 }, vEmpty, UpdatedRect);
+	CHECK(UpdatedRect.Right == KSize && UpdatedRect.Bottom == KSize);
+	CHECK(CountMismatches(vEmpty, vFull) == 0);
+}
+
+// Whole terrains vs the scalar reference, and brush-sized updates
+BENCH_CASE(NormalMapGenerator_FullAndBrushUpdates)
+{
+	std::mt19937 Random{ 1 };
+	const CNormalMapGenerator::SDesc KDesc{ 10.0f / 255.0f };
+	for (uint32_t Size : { 1025u, 2049u })
+	{
+		const vector<SPixel8UInt> KHeights{ GenerateHeights(Size, Size, Random) };
+		vector<SPixel16Int> vNormals{};
+		vector<SPixel16Int> vReference{};
+		constexpr int KRepeatCount{ 5 };
+
+		CTestTimer Timer{};
+		for (int iRepeat = 0; iRepeat < KRepeatCount; ++iRepeat)
+		{
+			CNormalMapGenerator::GenerateNormalMap(KHeights.data(), Size, Size, KDesc, vNormals);
+		}
+		const double KFilterMilliseconds{ Timer.GetElapsedMilliseconds() / KRepeatCount };
+		Timer = CTestTimer();
+		for (int iRepeat = 0; iRepeat < KRepeatCount; ++iRepeat)
+		{
+			GenerateNormalMapReference(KHeights, Size, Size, KDesc, vReference);
+		}
+		const double KReferenceMilliseconds{ Timer.GetElapsedMilliseconds() / KRepeatCount };
+		printf("%u x %u: 4-wide %.2f ms, scalar reference %.2f ms\n", Size, Size, KFilterMilliseconds, KReferenceMilliseconds);
+
+		for (uint32_t HalfSize : { 0u, 5u, 32u })
+		{
+			constexpr int KUpdateCount{ 2'000 };
+			const CMipGenerator::SRect KDirtyRect{ Size / 2 - HalfSize, Size / 2 - HalfSize, Size / 2 + HalfSize + 1, Size / 2 + HalfSize + 1 };
+			CMipGenerator::SRect UpdatedRect{};
+			Timer = CTestTimer();
+			for (int iUpdate = 0; iUpdate < KUpdateCount; ++iUpdate)
+			{
+				CNormalMapGenerator::UpdateNormalMap(KHeights.data(), Size, Size, KDesc, KDirtyRect, vNormals, UpdatedRect);
+			}
+			printf("  brush %u x %u (updates %u x %u): %.2f us\n", 2 * HalfSize + 1, 2 * HalfSize + 1, UpdatedRect.Right - UpdatedRect.Left,
+				UpdatedRect.Bottom - UpdatedRect.Top, Timer.GetElapsedMilliseconds() * 1000.0 / KUpdateCount);
+		}
+	}
+}
@@ -0,0 +1,389 @@
+#include "Test.h"
+#include "Core/PatchErrorEstimator.h"
+#include "Core/TerrainBrush.h"
+#include "Core/TerrainGenerator.h"
+#include <random>
+
+static vector<SPixel8UInt> GenerateTerrainHeights(uint32_t Size, uint32_t Seed)
+{
+	CTerrainGenerator::SDesc Desc{};
+	Desc.Graph = CTerrainGenerator::GetDefaultGraph(Seed);
+	vector<SPixel8UInt> vHeights{};
+	CTerrainGenerator::GenerateHeights(Desc, Size, Size, vHeights);
+	return vHeights;
+}
+
+// Vertex errors from EstimateCellError(), one cell at a time
+static void GenerateErrorMapReference(const vector<SPixel8UInt>& vHeights, uint32_t Width, uint32_t Height, const CPatchErrorEstimator::SDesc& Desc,
+	vector<float>& vOutErrors)
+{
+	vOutErrors.assign(static_cast<size_t>(Width) * Height, 0.0f);
+	if (Width < 2 || Height < 2) return;
+
+	vector<float> vCellErrors(static_cast<size_t>(Width - 1) * (Height - 1));
+	for (uint32_t Z = 0; Z + 1 < Height; ++Z)
+	{
+		for (uint32_t X = 0; X + 1 < Width; ++X)
+		{
+			vCellErrors[static_cast<size_t>(Z) * (Width - 1) + X] = CPatchErrorEstimator::EstimateCellError(vHeights.data(), Width, Height, Desc, X, Z);
+		}
+	}
+	for (int V = 0; V < static_cast<int>(Height); ++V)
+	{
+		for (int U = 0; U < static_cast<int>(Width); ++U)
+		{
+			float Error{};
+			for (int CellZ = V - 1; CellZ <= V; ++CellZ)
+			{
+				for (int CellX = U - 1; CellX <= U; ++CellX)
+				{
+					if (CellX < 0 || CellZ < 0 || CellX >= static_cast<int>(Width) - 1 || CellZ >= static_cast<int>(Height) - 1) continue;
+					Error = max(Error, vCellErrors[static_cast<size_t>(CellZ) * (Width - 1) + CellX]);
+				}
+			}
+			vOutErrors[static_cast<size_t>(V) * Width + U] = Error;
+		}
+	}
+}
+
+// Least-squares plane of the cell's 4 x 4 neighbourhood solved in double precision, independently of the estimator's closed form
+static double EstimateCellErrorReference(const vector<SPixel8UInt>& vHeights, uint32_t Width, uint32_t Height, int CellX, int CellZ)
+{
+	auto GetRowHeight{ [&](int U, int V) -> double
+		{
+			auto GetTexel{ [&](int X) -> double { return vHeights[static_cast<size_t>(V) * Width + X].R; } };
+			if (U < 0) return 2 * GetTexel(0) - GetTexel(1);
+			if (U >= static_cast<int>(Width)) return 2 * GetTexel(Width - 1) - GetTexel(Width - 2);
+			return GetTexel(U);
+		} };
+	auto GetHeight{ [&](int U, int V) -> double
+		{
+			if (V < 0) return 2 * GetRowHeight(U, 0) - GetRowHeight(U, 1);
+			if (V >= static_cast<int>(Height)) return 2 * GetRowHeight(U, Height - 1) - GetRowHeight(U, Height - 2);
+			return GetRowHeight(U, V);
+		} };
+
+	// Plane A + B * x + C * z with x, z centered on the window, so the normal equations are diagonal
+	double Heights[4][4]{};
+	double SumH{};
+	double SumXH{};
+	double SumZH{};
+	double SumXX{};
+	double SumZZ{};
+	for (int Row = 0; Row < 4; ++Row)
+	{
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			Heights[Row][Column] = GetHeight(CellX - 1 + Column, CellZ - 1 + Row);
+			const double KX{ Column - 1.5 };
+			const double KZ{ Row - 1.5 };
+			SumH += Heights[Row][Column];
+			SumXH += KX * Heights[Row][Column];
+			SumZH += KZ * Heights[Row][Column];
+			SumXX += KX * KX;
+			SumZZ += KZ * KZ;
+		}
+	}
+	const double KA{ SumH / 16 };
+	const double KB{ SumXH / SumXX };
+	const double KC{ SumZH / SumZZ };
+	double MaxDeviation{};
+	for (int Row = 0; Row < 4; ++Row)
+	{
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			MaxDeviation = max(MaxDeviation, fabs(Heights[Row][Column] - (KA + KB * (Column - 1.5) + KC * (Row - 1.5))));
+		}
+	}
+	return MaxDeviation;
+}
+
+TEST_CASE(PatchErrorEstimator_MatchesScalarAndLeastSquares)
+{
+	std::mt19937 Random{ 50 };
+	size_t MismatchCount{};
+	double MaxLeastSquaresDifference{};
+	for (uint32_t Width : { 2u, 3u, 4u, 5u, 6u, 7u, 9u, 17u, 65u, 258u })
+	{
+		for (uint32_t Height : { 2u, 3u, 5u, 33u })
+		{
+			vector<SPixel8UInt> vHeights(static_cast<size_t>(Width) * Height);
+			for (SPixel8UInt& Texel : vHeights) Texel.R = static_cast<uint8_t>(Random() % 256);
+
+			// The 4-wide path gives exactly the scalar path's results
+			const CPatchErrorEstimator::SDesc KDesc{ 10.0f / 255.0f };
+			vector<float> vErrors{};
+			vector<float> vReference{};
+			CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), Width, Height, KDesc, vErrors);
+			GenerateErrorMapReference(vHeights, Width, Height, KDesc, vReference);
+			for (size_t iVertex = 0; iVertex < vErrors.size(); ++iVertex)
+			{
+				if (vErrors[iVertex] != vReference[iVertex]) ++MismatchCount;
+			}
+
+			for (uint32_t Z = 0; Z + 1 < Height; ++Z)
+			{
+				for (uint32_t X = 0; X + 1 < Width; ++X)
+				{
+					const double KError{ CPatchErrorEstimator::EstimateCellError(vHeights.data(), Width, Height, CPatchErrorEstimator::SDesc{}, X, Z) };
+					MaxLeastSquaresDifference = max(MaxLeastSquaresDifference, fabs(KError - EstimateCellErrorReference(vHeights, Width, Height, X, Z)));
+				}
+			}
+		}
+	}
+	printf("4-wide vs scalar: %zu mismatches; scalar vs double least squares: max %g steps\n", MismatchCount, MaxLeastSquaresDifference);
+	CHECK(MismatchCount == 0);
+	CHECK(MaxLeastSquaresDifference < 1e-3);
+}
+
+TEST_CASE(PatchErrorEstimator_PlanesCostNothing)
+{
+	// A slope, including its linearly extrapolated border
+	constexpr uint32_t KSize{ 41 };
+	vector<SPixel8UInt> vHeights(KSize * KSize);
+	for (uint32_t V = 0; V < KSize; ++V)
+	{
+		for (uint32_t U = 0; U < KSize; ++U)
+		{
+			vHeights[V * KSize + U].R = static_cast<uint8_t>(2 * U + 3 * V);
+		}
+	}
+	vector<float> vErrors{};
+	CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), KSize, KSize, CPatchErrorEstimator::SDesc{}, vErrors);
+	CHECK(*std::max_element(vErrors.begin(), vErrors.end()) <= 1e-4f);
+
+	// A bump reaches the 3 x 3 cells whose windows hold it, and their 5 x 5 vertices
+	vHeights[20 * KSize + 20].R += 10;
+	CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), KSize, KSize, CPatchErrorEstimator::SDesc{ 0.5f }, vErrors);
+	const size_t KNonZeroCount{ static_cast<size_t>(std::count_if(vErrors.begin(), vErrors.end(), [](float Error) { return Error > 1e-4f; })) };
+	CHECK(KNonZeroCount == 25);
+	CHECK(vErrors[20 * KSize + 20] > 0.5f * 10 / 2);
+}
+
+TEST_CASE(PatchErrorEstimator_IncrementalMatchesFull)
+{
+	constexpr uint32_t KSize{ 257 };
+	const CPatchErrorEstimator::SDesc KDesc{ 10.0f / 255.0f };
+	std::mt19937 Random{ 5 };
+	vector<SPixel8UInt> vHeights{ GenerateTerrainHeights(KSize, 5) };
+	vector<float> vIncremental{};
+	CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), KSize, KSize, KDesc, vIncremental);
+
+	size_t MismatchCount{};
+	size_t WrongUpdatedRectCount{};
+	for (int iDab = 0; iDab < 300; ++iDab)
+	{
+		// Smooth, flatten and noise dabs, including ones at and past the borders
+		CTerrainBrush::SDesc Brush{};
+		Brush.eType = static_cast<CTerrainBrush::EType>(Random() % 3);
+		Brush.Radius = 1.0f + Random() % 20;
+		Brush.Strength = 0.8f;
+		Brush.PlaneHeight = static_cast<float>(Random() % 256);
+		const float KCenterU{ static_cast<float>(static_cast<int>(Random() % (KSize + 20)) - 10) };
+		const float KCenterV{ static_cast<float>(static_cast<int>(Random() % (KSize + 20)) - 10) };
+		CMipGenerator::SRect DirtyRect{};
+		CTerrainBrush::Apply(vHeights.data(), KSize, KSize, KCenterU, KCenterV, Brush, DirtyRect);
+		if (DirtyRect.IsEmpty()) continue;
+
+		CMipGenerator::SRect UpdatedRect{};
+		CPatchErrorEstimator::UpdateErrorMap(vHeights.data(), KSize, KSize, KDesc, DirtyRect, vIncremental, UpdatedRect);
+		if (UpdatedRect.Left != ((DirtyRect.Left > 2) ? DirtyRect.Left - 2 : 0) || UpdatedRect.Right != min(DirtyRect.Right + 2, KSize))
+		{
+			++WrongUpdatedRectCount;
+		}
+
+		if (iDab % 30 == 0 || iDab == 299)
+		{
+			vector<float> vFull{};
+			CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), KSize, KSize, KDesc, vFull);
+			for (size_t iVertex = 0; iVertex < vFull.size(); ++iVertex)
+			{
+				if (vFull[iVertex] != vIncremental[iVertex]) ++MismatchCount;
+			}
+		}
+	}
+	CHECK(MismatchCount == 0);
+	CHECK(WrongUpdatedRectCount == 0);
+
+	// An error map of the wrong size is generated as a whole
+	vector<float> vEmpty{};
+	CMipGenerator::SRect UpdatedRect{};
+	CPatchErrorEstimator::UpdateErrorMap(vHeights.data(), KSize, KSize, KDesc, CMipGenerator::SRect{ 0, 0, 1, 1 }, vEmpty, UpdatedRect);
+	CHECK(vEmpty.size() == vHeights.size());
+	CHECK(UpdatedRect.Right == KSize && UpdatedRect.Bottom == KSize);
+}
+
+BENCH_CASE(PatchErrorEstimator_ErrorMapTime)
+{
+	for (uint32_t Size : { 257u, 1025u })
+	{
+		const vector<SPixel8UInt> KHeights{ GenerateTerrainHeights(Size, 9) };
+		const CPatchErrorEstimator::SDesc KDesc{ 10.0f / 255.0f };
+		const int KRepeatCount{ (Size > 300) ? 5 : 50 };
+		vector<float> vErrors{};
+		CTestTimer Timer{};
+		for (int iRepeat = 0; iRepeat < KRepeatCount; ++iRepeat)
+		{
+			CPatchErrorEstimator::GenerateErrorMap(KHeights.data(), Size, Size, KDesc, vErrors);
+		}
+		const double KMilliseconds{ Timer.GetElapsedMilliseconds() / KRepeatCount };
+
+		Timer = CTestTimer();
+		float Sum{};
+		for (uint32_t Z = 0; Z + 1 < Size; ++Z)
+		{
+			for (uint32_t X = 0; X + 1 < Size; ++X)
+			{
+				Sum += CPatchErrorEstimator::EstimateCellError(KHeights.data(), Size, Size, KDesc, X, Z);
+			}
+		}
+		const double KScalarMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		CMipGenerator::SRect UpdatedRect{};
+		constexpr int KUpdateCount{ 2'000 };
+		Timer = CTestTimer();
+		for (int iUpdate = 0; iUpdate < KUpdateCount; ++iUpdate)
+		{
+			CPatchErrorEstimator::UpdateErrorMap(KHeights.data(), Size, Size, KDesc, CMipGenerator::SRect{ Size / 2 - 10, Size / 2 - 10, Size / 2 + 10,
+				Size / 2 + 10 }, vErrors, UpdatedRect);
+		}
+		printf("%u x %u: error map %.2f ms (4-wide), cells one by one %.2f ms (%.0f), 20 x 20 brush update %.2f us\n", Size, Size, KMilliseconds,
+			KScalarMilliseconds, Sum, Timer.GetElapsedMilliseconds() * 1000.0 / KUpdateCount);
+	}
+}
+
+// Triangles the D3D11 tessellator makes of a tri patch for the given factors
+static uint64_t CountTessellatedTriangles(const float (&EdgeFactors)[3], float InsideFactor, bool bIsFractionalOdd)
+{
+	auto RoundFactor{ [&](float Factor) -> int
+		{
+			if (bIsFractionalOdd) return 2 * static_cast<int>(ceilf((min(max(Factor, 1.0f), 63.0f) - 1) / 2)) + 1;
+			return 2 * static_cast<int>(ceilf(min(max(Factor, 2.0f), 64.0f) / 2));
+		} };
+	const int KEdges[3]{ RoundFactor(EdgeFactors[0]), RoundFactor(EdgeFactors[1]), RoundFactor(EdgeFactors[2]) };
+	int Inside{ RoundFactor(InsideFactor) };
+	if (bIsFractionalOdd && Inside == 1)
+	{
+		if (KEdges[0] == 1 && KEdges[1] == 1 && KEdges[2] == 1) return 1;
+		Inside = 3;
+	}
+
+	// The outer ring, then rings of 2 fewer segments per side down to the center
+	uint64_t Count{ static_cast<uint64_t>(KEdges[0] + KEdges[1] + KEdges[2]) + 3ull * (Inside - 2) };
+	for (int Ring = Inside - 2; Ring >= 1; Ring -= 2)
+	{
+		if (Ring == 1)
+		{
+			Count += 1;
+			break;
+		}
+		Count += 3ull * (Ring + (Ring - 2));
+	}
+	return Count;
+}
+
+// Triangles per frame along a recorded camera path over an edited terrain (a flattened meadow and a smoothed valley among the hills):
+// HSTerrain.hlsl's former distance-only factors vs. the screen-space error factors that read the error map
+BENCH_CASE(PatchErrorEstimator_CameraPathTriangles)
+{
+	constexpr uint32_t KSize{ 256 };
+	constexpr uint32_t KWidth{ KSize + 1 };
+	constexpr float KHeightRange{ 10.0f };
+	vector<SPixel8UInt> vHeights{ GenerateTerrainHeights(KWidth, 3) };
+	CMipGenerator::SRect DirtyRect{};
+	for (int iDab = 0; iDab < 40; ++iDab)
+	{
+		CTerrainBrush::SDesc Brush{};
+		Brush.eType = CTerrainBrush::EType::Flatten;
+		Brush.Radius = 40.0f;
+		Brush.Strength = 1.0f;
+		Brush.Hardness = 0.8f;
+		Brush.PlaneHeight = 110.0f;
+		CTerrainBrush::Apply(vHeights.data(), KWidth, KWidth, 60.0f + (iDab % 4), 60.0f, Brush, DirtyRect);
+	}
+	for (int iDab = 0; iDab < 10; ++iDab)
+	{
+		CTerrainBrush::SDesc Brush{};
+		Brush.Radius = 30.0f;
+		Brush.SmoothSigma = 3.0f;
+		Brush.Strength = 1.0f;
+		CTerrainBrush::Apply(vHeights.data(), KWidth, KWidth, 190.0f, 70.0f, Brush, DirtyRect);
+	}
+	vector<float> vErrors{};
+	CPatchErrorEstimator::GenerateErrorMap(vHeights.data(), KWidth, KWidth, CPatchErrorEstimator::SDesc{ KHeightRange / 255.0f }, vErrors);
+
+	auto GetPosition{ [&](uint32_t U, uint32_t V)
+		{
+			return XMFLOAT3(U - KSize / 2.0f, vHeights[V * KWidth + U].R / 255.0f * KHeightRange - KHeightRange / 2, KSize / 2.0f - V);
+		} };
+	auto GetDistance{ [](const XMFLOAT3& A, const XMFLOAT3& B)
+		{
+			return sqrtf((A.x - B.x) * (A.x - B.x) + (A.y - B.y) * (A.y - B.y) + (A.z - B.z) * (A.z - B.z));
+		} };
+	const float KProjectionScale{ 600.0f / (2.0f * tanf(XMConvertToRadians(50.0f) / 2.0f)) }; // 800 x 600 with the default field of view
+
+	// A walk through the meadow, across the hills and down the valley, 2 units above the ground
+	vector<XMFLOAT3> vPath{};
+	for (int iFrame = 0; iFrame < 60; ++iFrame)
+	{
+		const float KT{ iFrame / 59.0f };
+		const float KX{ -80.0f + 160.0f * KT };
+		const float KZ{ 60.0f * sinf(KT * XM_2PI) - 20.0f };
+		XMFLOAT3 Eye{ GetPosition(static_cast<uint32_t>(KX + KSize / 2.0f), static_cast<uint32_t>(KSize / 2.0f - KZ)) };
+		Eye.x = KX;
+		Eye.z = KZ;
+		Eye.y += 2.0f;
+		vPath.push_back(Eye);
+	}
+
+	for (float TessFactor : { 8.0f, 16.0f, 64.0f })
+	{
+		for (float TessPixelError : { 1.0f, 2.0f })
+		{
+			uint64_t DistanceTriangleCount{};
+			uint64_t ErrorTriangleCount{};
+			for (const XMFLOAT3& Eye : vPath)
+			{
+				for (uint32_t V = 0; V < KSize; ++V)
+				{
+					for (uint32_t U = 0; U < KSize; ++U)
+					{
+						const uint32_t KTriangles[2][3][2]{ { { U, V }, { U + 1, V }, { U, V + 1 } }, { { U + 1, V }, { U + 1, V + 1 }, { U, V + 1 } } };
+						for (const auto& Triangle : KTriangles)
+						{
+							XMFLOAT3 Positions[3]{};
+							float Errors[3]{};
+							for (int iVertex = 0; iVertex < 3; ++iVertex)
+							{
+								Positions[iVertex] = GetPosition(Triangle[iVertex][0], Triangle[iVertex][1]);
+								Errors[iVertex] = vErrors[Triangle[iVertex][1] * KWidth + Triangle[iVertex][0]];
+							}
+
+							// Distance only (fractional_even): half the factor on the edges, the inside falling off past 15 units
+							const XMFLOAT3 KCenter{ (Positions[0].x + Positions[1].x + Positions[2].x) / 3, (Positions[0].y + Positions[1].y + Positions[2].y) / 3,
+								(Positions[0].z + Positions[1].z + Positions[2].z) / 3 };
+							const float KDistance{ GetDistance(KCenter, Eye) };
+							const float KDistanceEdgeFactors[3]{ 0.5f * TessFactor, 0.5f * TessFactor, 0.5f * TessFactor };
+							DistanceTriangleCount += CountTessellatedTriangles(KDistanceEdgeFactors,
+								(KDistance <= 15.0f) ? TessFactor : TessFactor / max(KDistance - 15.0f, 1.0f), false);
+
+							// Screen-space error (fractional_odd), as CalcEdgeTessFactor()
+							float EdgeFactors[3]{};
+							for (int iEdge = 0; iEdge < 3; ++iEdge)
+							{
+								const XMFLOAT3& KA{ Positions[(iEdge + 1) % 3] };
+								const XMFLOAT3& KB{ Positions[(iEdge + 2) % 3] };
+								const float KEdgeDistance{ max(GetDistance(XMFLOAT3((KA.x + KB.x) / 2, (KA.y + KB.y) / 2, (KA.z + KB.z) / 2), Eye), 1.0f) };
+								const float KPixelError{ max(Errors[(iEdge + 1) % 3], Errors[(iEdge + 2) % 3]) * KProjectionScale / KEdgeDistance };
+								EdgeFactors[iEdge] = min(max(sqrtf(KPixelError / TessPixelError), 1.0f), TessFactor);
+							}
+							ErrorTriangleCount += CountTessellatedTriangles(EdgeFactors, max(EdgeFactors[0], max(EdgeFactors[1], EdgeFactors[2])), true);
+						}
+					}
+				}
+			}
+			printf("TessFactor %2.0f, %.0f px: triangles per frame: distance %.2f M, screen-space error %.2f M (%.1f%%)\n", TessFactor, TessPixelError,
+				DistanceTriangleCount / 1e6 / vPath.size(), ErrorTriangleCount / 1e6 / vPath.size(), 100.0 * ErrorTriangleCount / DistanceTriangleCount);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#include "Test.h"
+#include "Core/RenderQueue.h"
+#include <random>
+
+static uint64_t MakeRandomSortKey(std::mt19937_64& Random)
+{
+	const float KDepth{ (Random() % 10'000) / 10'000.0f };
+	const uint32_t KShaderID{ static_cast<uint32_t>(Random() % 8) };
+	const uint32_t KTextureSetID{ static_cast<uint32_t>(Random() % 50) };
+	const uint32_t KMaterialID{ static_cast<uint32_t>(Random() % 20) };
+	return (Random() % 3 == 0) ? CRenderQueue::MakeTransparentSortKey(KDepth, KShaderID, KTextureSetID, KMaterialID) :
+		CRenderQueue::MakeOpaqueSortKey(KShaderID, KTextureSetID, KMaterialID, KDepth);
+}
+
+TEST_CASE(RenderQueue_SortMatchesStableSort)
+{
+	std::mt19937_64 Random{ 7 };
+	for (size_t PacketCount : { 0, 1, 10, 2'000, 50'000 })
+	{
+		CRenderQueue Queue{};
+		vector<CRenderQueue::SPacket> vExpected{};
+		for (size_t iPacket = 0; iPacket < PacketCount; ++iPacket)
+		{
+			const uint64_t KSortKey{ MakeRandomSortKey(Random) };
+			Queue.Add(KSortKey, static_cast<uint32_t>(iPacket));
+			vExpected.push_back(CRenderQueue::SPacket{ KSortKey, static_cast<uint32_t>(iPacket) });
+		}
+		Queue.Sort();
+		std::stable_sort(vExpected.begin(), vExpected.end(),
+			[](const CRenderQueue::SPacket& A, const CRenderQueue::SPacket& B) { return A.SortKey < B.SortKey; });
+
+		const vector<CRenderQueue::SPacket>& vPackets{ Queue.GetPackets() };
+		CHECK(vPackets.size() == PacketCount);
+		size_t MismatchCount{};
+		for (size_t iPacket = 0; iPacket < min(vPackets.size(), vExpected.size()); ++iPacket)
+		{
+			if (vPackets[iPacket].SortKey != vExpected[iPacket].SortKey || vPackets[iPacket].ItemIndex != vExpected[iPacket].ItemIndex) ++MismatchCount;
+		}
+		CHECK(MismatchCount == 0);
+	}
+}
+
+TEST_CASE(RenderQueue_SortsKeysSharingHighBits)
+{
+	// Only the lowest digit differs, so every other digit pass is skipped
+	CRenderQueue Queue{};
+	for (uint32_t iPacket = 0; iPacket < 256; ++iPacket)
+	{
+		Queue.Add(0xABCD'0000'0000'0000ull | (255 - iPacket), iPacket);
+	}
+	Queue.Sort();
+	const vector<CRenderQueue::SPacket>& vPackets{ Queue.GetPackets() };
+	for (uint32_t iPacket = 0; iPacket < 256; ++iPacket)
+	{
+		CHECK(vPackets[iPacket].ItemIndex == 255 - iPacket);
+	}
+
+	Queue.Clear();
+	CHECK(Queue.GetPackets().empty());
+}
+
+TEST_CASE(RenderQueue_KeyOrdering)
+{
+	// Every opaque packet comes before every transparent packet
+	CHECK(CRenderQueue::MakeOpaqueSortKey(4095, 65535, 65535, 1.0f) < CRenderQueue::MakeTransparentSortKey(0.0f, 0, 0, 0));
+	CHECK(CRenderQueue::GetPass(CRenderQueue::MakeOpaqueSortKey(3, 2, 1, 0.5f)) == CRenderQueue::EPass::Opaque);
+	CHECK(CRenderQueue::GetPass(CRenderQueue::MakeTransparentSortKey(0.5f, 3, 2, 1)) == CRenderQueue::EPass::Transparent);
+
+	// Opaque: shader, then texture set, then material, then front to back
+	CHECK(CRenderQueue::MakeOpaqueSortKey(1, 9, 9, 1.0f) < CRenderQueue::MakeOpaqueSortKey(2, 0, 0, 0.0f));
+	CHECK(CRenderQueue::MakeOpaqueSortKey(1, 1, 9, 1.0f) < CRenderQueue::MakeOpaqueSortKey(1, 2, 0, 0.0f));
+	CHECK(CRenderQueue::MakeOpaqueSortKey(1, 1, 1, 1.0f) < CRenderQueue::MakeOpaqueSortKey(1, 1, 2, 0.0f));
+	CHECK(CRenderQueue::MakeOpaqueSortKey(1, 1, 1, 0.1f) < CRenderQueue::MakeOpaqueSortKey(1, 1, 1, 0.2f));
+
+	// Transparent: back to front before anything else
+	CHECK(CRenderQueue::MakeTransparentSortKey(0.9f, 5, 5, 5) < CRenderQueue::MakeTransparentSortKey(0.1f, 0, 0, 0));
+
+	// Out-of-range IDs and depths are clamped instead of spilling into the other fields
+	CHECK(CRenderQueue::GetPass(CRenderQueue::MakeOpaqueSortKey(100'000, 100'000, 100'000, 2.0f)) == CRenderQueue::EPass::Opaque);
+	CHECK(CRenderQueue::MakeOpaqueSortKey(1, 0, 0, -1.0f) == CRenderQueue::MakeOpaqueSortKey(1, 0, 0, 0.0f));
+	CHECK(CRenderQueue::GetPass(CRenderQueue::MakeTransparentSortKey(-1.0f, 100'000, 100'000, 100'000)) == CRenderQueue::EPass::Transparent);
+}
+
+BENCH_CASE(RenderQueue_RadixSort)
+{
+	std::mt19937_64 Random{ 11 };
+	for (size_t PacketCount : { 2'000, 20'000, 200'000 })
+	{
+		CRenderQueue Queue{};
+		vector<CRenderQueue::SPacket> vReference{};
+		for (size_t iPacket = 0; iPacket < PacketCount; ++iPacket)
+		{
+			const uint64_t KSortKey{ MakeRandomSortKey(Random) };
+			Queue.Add(KSortKey, static_cast<uint32_t>(iPacket));
+			vReference.push_back(CRenderQueue::SPacket{ KSortKey, static_cast<uint32_t>(iPacket) });
+		}
+
+		CTestTimer Timer{};
+		Queue.Sort();
+		const double KRadixMilliseconds{ Timer.GetElapsedMilliseconds() };
+		Timer = CTestTimer();
+		std::stable_sort(vReference.begin(), vReference.end(),
+			[](const CRenderQueue::SPacket& A, const CRenderQueue::SPacket& B) { return A.SortKey < B.SortKey; });
+		const double KStableSortMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		printf("%zu packets: radix sort %.3f ms, std::stable_sort %.3f ms\n", PacketCount, KRadixMilliseconds, KStableSortMilliseconds);
+	}
+}
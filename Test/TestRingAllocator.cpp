@@ -0,0 +1,279 @@
+#include "Test.h"
+#include "Core/RingAllocator.h"
+#include <random>
+
+// Reference model: the frame that owns each byte (-1: free)
+class CRingOwnershipModel
+{
+public:
+	CRingOwnershipModel(size_t ByteSize) : m_vOwners(ByteSize, -1) {}
+
+	// Returns false if a byte is still owned by a frame in flight
+	bool Mark(size_t Offset, size_t ByteSize, int64_t Frame)
+	{
+		bool bIsFree{ true };
+		for (size_t iByte = Offset; iByte < Offset + ByteSize; ++iByte)
+		{
+			bIsFree = bIsFree && m_vOwners[iByte] < 0;
+			m_vOwners[iByte] = Frame;
+		}
+		return bIsFree;
+	}
+
+	void Retire(int64_t CompletedFrame)
+	{
+		for (int64_t& Owner : m_vOwners)
+		{
+			if (Owner >= 0 && Owner <= CompletedFrame) Owner = -1;
+		}
+	}
+
+	size_t GetLiveByteSize() const
+	{
+		return static_cast<size_t>(std::count_if(m_vOwners.begin(), m_vOwners.end(), [](int64_t Owner) { return Owner >= 0; }));
+	}
+
+private:
+	vector<int64_t>	m_vOwners{};
+};
+
+TEST_CASE(RingAllocator_AlignmentFromEveryHead)
+{
+	// Every alignment and size from every head position of an otherwise empty ring
+	size_t FailureCount{};
+	for (size_t ByteSize : { 64, 100, 256 })
+	{
+		for (size_t Head = 0; Head <= ByteSize; ++Head)
+		{
+			for (size_t Alignment = 1; Alignment <= 128; Alignment <<= 1)
+			{
+				for (size_t Size = 1; Size <= ByteSize; ++Size)
+				{
+					CRingAllocator Allocator{};
+					Allocator.Reset(ByteSize);
+					size_t Offset{};
+					if (Head > 0)
+					{
+						Allocator.Allocate(Head, 1, Offset);
+						Allocator.EndFrame(1);
+						Allocator.Retire(1);
+					}
+
+					// An empty ring fits anything up to its size, at the aligned head or else at 0
+					const size_t KAlignedHead{ (Head + Alignment - 1) / Alignment * Alignment };
+					const size_t KExpectedOffset{ (KAlignedHead + Size <= ByteSize) ? KAlignedHead : 0 };
+					const bool KbIsAllocated{ Allocator.Allocate(Size, Alignment, Offset) };
+					if (!KbIsAllocated || Offset != KExpectedOffset || Offset % Alignment != 0) ++FailureCount;
+				}
+			}
+		}
+	}
+	CHECK(FailureCount == 0);
+}
+
+TEST_CASE(RingAllocator_FullAndEmptyHeadEqualsTail)
+{
+	CRingAllocator Allocator{};
+	Allocator.Reset(100);
+	size_t Offset{};
+
+	// Empty: m_Head == m_Tail == 0
+	CHECK(Allocator.GetUsedByteSize() == 0);
+	CHECK(Allocator.Allocate(100, 1, Offset) && Offset == 0);
+
+	// Full: the head has wrapped onto the tail
+	CHECK(Allocator.GetUsedByteSize() == 100);
+	CHECK(!Allocator.Allocate(1, 1, Offset));
+	Allocator.EndFrame(1);
+	CHECK(!Allocator.Allocate(1, 1, Offset));
+
+	// Empty again with m_Head == m_Tail == 100 (the end of the ring)
+	Allocator.Retire(1);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+	CHECK(Allocator.Allocate(40, 1, Offset) && Offset == 0);
+	CHECK(Allocator.Allocate(60, 1, Offset) && Offset == 40);
+	Allocator.EndFrame(2);
+
+	// Full again with m_Head == m_Tail in the middle of the ring
+	Allocator.Retire(2);
+	CHECK(Allocator.Allocate(30, 1, Offset) && Offset == 0);
+	Allocator.EndFrame(3);
+	CHECK(Allocator.Allocate(70, 1, Offset) && Offset == 30);
+	Allocator.EndFrame(4);
+	Allocator.Retire(3);
+	CHECK(Allocator.Allocate(30, 1, Offset) && Offset == 0);
+	CHECK(Allocator.GetUsedByteSize() == 100);
+	CHECK(!Allocator.Allocate(1, 1, Offset));
+	Allocator.EndFrame(5);
+	Allocator.Retire(4);
+	CHECK(Allocator.GetUsedByteSize() == 30);
+	CHECK(Allocator.Allocate(70, 1, Offset) && Offset == 30);
+}
+
+TEST_CASE(RingAllocator_WrapPadsTheEnd)
+{
+	CRingAllocator Allocator{};
+	Allocator.Reset(100);
+	size_t Offset{};
+	CHECK(Allocator.Allocate(60, 1, Offset) && Offset == 0);
+	Allocator.EndFrame(1);
+	CHECK(Allocator.Allocate(30, 1, Offset) && Offset == 60);
+	Allocator.EndFrame(2);
+
+	// 10 bytes are left at the end, and frame 1 is still in flight
+	CHECK(!Allocator.Allocate(20, 1, Offset));
+	Allocator.Retire(1);
+
+	// Wraps: the last 10 bytes become padding owned by the new frame
+	CHECK(Allocator.Allocate(20, 1, Offset) && Offset == 0);
+	CHECK(Allocator.GetUsedByteSize() == 30 + 10 + 20);
+	CHECK(Allocator.GetFrameByteSize() == 10 + 20);
+	CHECK(Allocator.Allocate(40, 1, Offset) && Offset == 20);
+	CHECK(!Allocator.Allocate(1, 1, Offset));
+	Allocator.EndFrame(3);
+
+	Allocator.Retire(2);
+	CHECK(Allocator.GetUsedByteSize() == 70);
+	CHECK(Allocator.Allocate(30, 1, Offset) && Offset == 60);
+	Allocator.EndFrame(4);
+
+	// The padding is freed with its frame
+	Allocator.Retire(3);
+	CHECK(Allocator.GetUsedByteSize() == 30);
+	Allocator.Retire(4);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+	CHECK(Allocator.GetPendingFrameCount() == 0);
+
+	// Alignment padding at the head counts as well
+	Allocator.Reset();
+	CHECK(Allocator.Allocate(3, 1, Offset) && Offset == 0);
+	CHECK(Allocator.Allocate(8, 16, Offset) && Offset == 16);
+	CHECK(Allocator.GetUsedByteSize() == 24);
+}
+
+TEST_CASE(RingAllocator_RetiresFramesWithoutAllocations)
+{
+	CRingAllocator Allocator{};
+	Allocator.Reset(100);
+	size_t Offset{};
+
+	Allocator.EndFrame(1);
+	Allocator.EndFrame(2);
+	CHECK(Allocator.GetPendingFrameCount() == 2);
+	Allocator.Retire(2);
+	CHECK(Allocator.GetPendingFrameCount() == 0);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+
+	// Empty frames between frames with ranges must neither free nor keep anything
+	CHECK(Allocator.Allocate(50, 1, Offset) && Offset == 0);
+	Allocator.EndFrame(3);
+	Allocator.EndFrame(4);
+	CHECK(Allocator.Allocate(30, 1, Offset) && Offset == 50);
+	Allocator.EndFrame(5);
+	Allocator.EndFrame(6);
+
+	Allocator.Retire(4);
+	CHECK(Allocator.GetUsedByteSize() == 30);
+	CHECK(Allocator.Allocate(40, 1, Offset) && Offset == 0);
+	CHECK(!Allocator.Allocate(20, 1, Offset));
+	Allocator.EndFrame(7);
+	Allocator.Retire(6);
+	CHECK(Allocator.GetUsedByteSize() == 40 + 20);
+	Allocator.Retire(7);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+	CHECK(Allocator.GetPendingFrameCount() == 0);
+
+	// Retiring a fence that has already been passed does nothing
+	Allocator.Retire(7);
+	Allocator.Retire(0);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+}
+
+TEST_CASE(RingAllocator_RejectsOverflow)
+{
+	CRingAllocator Allocator{};
+	size_t Offset{ 12345 };
+
+	// A ring without memory
+	CHECK(!Allocator.Allocate(1, 1, Offset));
+
+	Allocator.Reset(100);
+	CHECK(!Allocator.Allocate(0, 1, Offset));
+	CHECK(!Allocator.Allocate(101, 1, Offset));
+	CHECK(!Allocator.Allocate(SIZE_MAX, 1, Offset));
+	CHECK(!Allocator.Allocate(SIZE_MAX - 8, 16, Offset));
+	CHECK(Offset == 12345);
+	CHECK(Allocator.GetUsedByteSize() == 0);
+
+	// Alignment larger than the ring: only offset 0 is aligned, and it's taken until frame 1 is retired
+	CHECK(Allocator.Allocate(10, 256, Offset) && Offset == 0);
+	CHECK(!Allocator.Allocate(10, 256, Offset));
+	Allocator.EndFrame(1);
+	Allocator.Retire(1);
+	CHECK(Allocator.Allocate(10, 256, Offset) && Offset == 0);
+	CHECK(Allocator.GetUsedByteSize() == 90 + 10);
+}
+
+TEST_CASE(RingAllocator_RandomAgainstOwnershipModel)
+{
+	std::mt19937_64 Random{ 37 };
+	size_t AllocationCount{};
+	size_t WrapCount{};
+	size_t OverlapCount{};
+	size_t UnderCountedCount{};
+	size_t FailureOnEmptyCount{};
+	size_t LeakCount{};
+	for (int Run = 0; Run < 200; ++Run)
+	{
+		const size_t KByteSize{ 64 + Random() % 4096 };
+		const int64_t KLatency{ static_cast<int64_t>(Random() % 4) };
+		CRingAllocator Allocator{};
+		Allocator.Reset(KByteSize);
+		CRingOwnershipModel Model{ KByteSize };
+
+		int64_t Frame{ 1 };
+		size_t LastOffset{};
+		for (int iFrame = 0; iFrame < 300; ++iFrame, ++Frame)
+		{
+			const int KAllocationCount{ static_cast<int>(Random() % 8) };
+			for (int iAllocation = 0; iAllocation < KAllocationCount; ++iAllocation)
+			{
+				const size_t KSize{ 1 + Random() % (KByteSize / 3 + 1) };
+				const size_t KAlignment{ size_t(1) << (Random() % 6) };
+				const bool KbWasEmpty{ Model.GetLiveByteSize() == 0 };
+				size_t Offset{};
+				if (Allocator.Allocate(KSize, KAlignment, Offset))
+				{
+					CHECK(Offset % KAlignment == 0 && Offset + KSize <= KByteSize);
+					if (!Model.Mark(Offset, KSize, Frame)) ++OverlapCount;
+					if (Offset < LastOffset) ++WrapCount;
+					LastOffset = Offset;
+					++AllocationCount;
+				}
+				else if (KbWasEmpty)
+				{
+					++FailureOnEmptyCount;
+				}
+			}
+			Allocator.EndFrame(static_cast<uint64_t>(Frame));
+
+			const int64_t KCompletedFrame{ Frame - KLatency };
+			if (KCompletedFrame > 0)
+			{
+				Allocator.Retire(static_cast<uint64_t>(KCompletedFrame));
+				Model.Retire(KCompletedFrame);
+			}
+			// The allocator's count includes padding, so it can only be larger than the live bytes
+			if (Allocator.GetUsedByteSize() < Model.GetLiveByteSize() || Allocator.GetUsedByteSize() > KByteSize) ++UnderCountedCount;
+		}
+
+		Allocator.Retire(static_cast<uint64_t>(Frame));
+		if (Allocator.GetUsedByteSize() != 0 || Allocator.GetPendingFrameCount() != 0) ++LeakCount;
+	}
+	printf("%zu allocations, %zu wraps\n", AllocationCount, WrapCount);
+	CHECK(OverlapCount == 0);
+	CHECK(UnderCountedCount == 0);
+	CHECK(FailureOnEmptyCount == 0);
+	CHECK(LeakCount == 0);
+	CHECK(WrapCount > 0);
+}
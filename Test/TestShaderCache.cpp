@@ -0,0 +1,237 @@
+#include "Test.h"
+#include "Core/ShaderCache.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+// "Compiles" a file to its own text (plus the flags and the entry point); sources that contain "ERROR" fail
+// CompileMilliseconds stands in for the D3D compiler's cost
+class CShaderCompilerStub final : public CShaderCompiler
+{
+public:
+	bool Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors) override
+	{
+		++CompileCount;
+		if (CompileMilliseconds) std::this_thread::sleep_for(std::chrono::milliseconds(CompileMilliseconds));
+
+		std::ifstream ifs{ Desc.FileName, std::ifstream::binary };
+		if (!ifs.is_open())
+		{
+			OutErrors = "missing file\n";
+			return false;
+		}
+		const string KSource{ std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+		if (KSource.find("ERROR") != string::npos)
+		{
+			OutErrors = "error\n";
+			return false;
+		}
+		OutBytecode.assign(KSource.begin(), KSource.end());
+		OutBytecode.emplace_back(static_cast<uint8_t>(Desc.Flags));
+		OutBytecode.insert(OutBytecode.end(), Desc.EntryPoint.begin(), Desc.EntryPoint.end());
+		return true;
+	}
+
+public:
+	std::atomic<int>	CompileCount{};
+	int					CompileMilliseconds{};
+};
+
+static string GetTestDirectory()
+{
+	const string KDirectory{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/ShaderCache" };
+	CreateDirectoryA(KDirectory.c_str(), nullptr);
+	CreateDirectoryA((KDirectory + "/Shader").c_str(), nullptr);
+	return KDirectory;
+}
+
+static void WriteTextFile(const string& FileName, const string& Text)
+{
+	std::ofstream ofs{ FileName, std::ofstream::binary };
+	ofs << Text;
+}
+
+TEST_CASE(ShaderCache_KeyCoversSourcesAndDesc)
+{
+	const string KDirectory{ GetTestDirectory() };
+	WriteTextFile(KDirectory + "/Shader/Shared.hlsli", "float a;\n");
+	WriteTextFile(KDirectory + "/Shader/Header.hlsli", "#include \"Shared.hlsli\"\nfloat b;\n");
+	WriteTextFile(KDirectory + "/Shader/VS.hlsl", "#include \"Header.hlsli\"\nvoid main(){}\n");
+	WriteTextFile(KDirectory + "/Shader/PS.hlsl", "#include <Header.hlsli>\n// A cycle\n#include \"PS.hlsl\"\nvoid main(){}\n");
+
+	CShaderCompilerStub Compiler{};
+	CShaderCache Cache{ &Compiler, KDirectory + "/Cache" };
+	SShaderCompileDesc Desc{};
+	Desc.FileName = KDirectory + "/Shader/VS.hlsl";
+	Desc.EntryPoint = "main";
+	Desc.Profile = "vs_4_0";
+	Desc.Flags = 1;
+	const uint64_t KKey{ Cache.CalculateKey(Desc) };
+	CHECK(KKey != 0);
+	CHECK(Cache.CalculateKey(Desc) == KKey);
+
+	// Every part of the desc
+	SShaderCompileDesc Changed{ Desc };
+	Changed.EntryPoint = "mainCompressed";
+	CHECK(Cache.CalculateKey(Changed) != KKey);
+	Changed = Desc;
+	Changed.Profile = "vs_5_0";
+	CHECK(Cache.CalculateKey(Changed) != KKey);
+	Changed = Desc;
+	Changed.Flags = 2;
+	CHECK(Cache.CalculateKey(Changed) != KKey);
+	Changed = Desc;
+	Changed.vDefines.push_back(SShaderDefine{ "USE_TEXTURE", "1" });
+	const uint64_t KDefineKey{ Cache.CalculateKey(Changed) };
+	CHECK(KDefineKey != KKey);
+	Changed.vDefines[0].Value = "0";
+	CHECK(Cache.CalculateKey(Changed) != KDefineKey);
+
+	// Files included by included files, and include cycles
+	WriteTextFile(KDirectory + "/Shader/Shared.hlsli", "float a2;\n");
+	CHECK(Cache.CalculateKey(Desc) != KKey);
+	WriteTextFile(KDirectory + "/Shader/Shared.hlsli", "float a;\n");
+	CHECK(Cache.CalculateKey(Desc) == KKey);
+
+	SShaderCompileDesc PixelShaderDesc{ Desc };
+	PixelShaderDesc.FileName = KDirectory + "/Shader/PS.hlsl";
+	PixelShaderDesc.Profile = "ps_4_0";
+	const uint64_t KPixelShaderKey{ Cache.CalculateKey(PixelShaderDesc) };
+	CHECK(KPixelShaderKey != 0);
+	WriteTextFile(KDirectory + "/Shader/Shared.hlsli", "float a3;\n");
+	CHECK(Cache.CalculateKey(PixelShaderDesc) != KPixelShaderKey);
+	WriteTextFile(KDirectory + "/Shader/Shared.hlsli", "float a;\n");
+
+	// '\\' separators (as the engine names its shaders) resolve on every platform
+	Changed = Desc;
+	Changed.FileName = KDirectory + "\\Shader\\VS.hlsl";
+	CHECK(Cache.CalculateKey(Changed) != 0);
+
+	// Missing sources aren't cached
+	Changed = Desc;
+	Changed.FileName = KDirectory + "/Shader/Missing.hlsl";
+	CHECK(Cache.CalculateKey(Changed) == 0);
+}
+
+TEST_CASE(ShaderCache_HitsMissesAndBatches)
+{
+	const string KDirectory{ GetTestDirectory() };
+	WriteTextFile(KDirectory + "/Shader/Header.hlsli", "float b;\n");
+	WriteTextFile(KDirectory + "/Shader/VSCached.hlsl", "#include \"Header.hlsli\"\nvoid main(){}\n");
+	WriteTextFile(KDirectory + "/Shader/PSCached.hlsl", "#include \"Header.hlsli\"\nfloat4 main() : SV_TARGET { return 0; }\n");
+	WriteTextFile(KDirectory + "/Shader/Bad.hlsl", "ERROR\n");
+
+	CShaderCompilerStub Compiler{};
+	CShaderCache Cache{ &Compiler, KDirectory + "/Cache" };
+	SShaderCompileDesc Desc{};
+	Desc.FileName = KDirectory + "/Shader/VSCached.hlsl";
+	Desc.EntryPoint = "main";
+	Desc.Profile = "vs_4_0";
+	const uint64_t KKey{ Cache.CalculateKey(Desc) };
+	std::remove(Cache.GetCacheFileName(KKey).c_str());
+
+	// A miss, then a hit
+	int CallbackCount{};
+	vector<uint8_t> vCompiled{};
+	vector<uint8_t> vLoaded{};
+	Cache.Request(Desc, [&](const vector<uint8_t>& vBytecode) { ++CallbackCount; vCompiled = vBytecode; });
+	CHECK(CallbackCount == 1 && Compiler.CompileCount == 1);
+	Cache.Request(Desc, [&](const vector<uint8_t>& vBytecode) { ++CallbackCount; vLoaded = vBytecode; });
+	CHECK(CallbackCount == 2 && Compiler.CompileCount == 1);
+	CHECK(vLoaded == vCompiled);
+	CHECK(Cache.GetStats().HitCount == 1 && Cache.GetStats().MissCount == 1);
+
+	// Damaged and truncated files are compiled again
+	{
+		std::fstream fs{ Cache.GetCacheFileName(KKey), std::fstream::in | std::fstream::out | std::fstream::binary };
+		fs.seekp(33);
+		fs.put('Z');
+	}
+	vLoaded.clear();
+	Cache.Request(Desc, [&](const vector<uint8_t>& vBytecode) { ++CallbackCount; vLoaded = vBytecode; });
+	CHECK(CallbackCount == 3 && Compiler.CompileCount == 2);
+	CHECK(vLoaded == vCompiled);
+	WriteTextFile(Cache.GetCacheFileName(KKey), "SHCC");
+	vLoaded.clear();
+	Cache.Request(Desc, [&](const vector<uint8_t>& vBytecode) { ++CallbackCount; vLoaded = vBytecode; });
+	CHECK(CallbackCount == 4 && Compiler.CompileCount == 3);
+	CHECK(vLoaded == vCompiled);
+
+	// Failures don't call back
+	SShaderCompileDesc BadDesc{ Desc };
+	BadDesc.FileName = KDirectory + "/Shader/Bad.hlsl";
+	Cache.Request(BadDesc, [&](const vector<uint8_t>&) { ++CallbackCount; });
+	CHECK(CallbackCount == 4);
+	CHECK(Cache.GetStats().FailureCount == 1);
+
+	// Batches call back in request order, and requests that share a key are compiled once
+	SShaderCompileDesc FlaggedDesc{ Desc };
+	FlaggedDesc.Flags = 7;
+	SShaderCompileDesc PixelShaderDesc{ Desc };
+	PixelShaderDesc.FileName = KDirectory + "/Shader/PSCached.hlsl";
+	PixelShaderDesc.Profile = "ps_4_0";
+	std::remove(Cache.GetCacheFileName(Cache.CalculateKey(FlaggedDesc)).c_str());
+	std::remove(Cache.GetCacheFileName(Cache.CalculateKey(PixelShaderDesc)).c_str());
+
+	vector<int> vOrder{};
+	Cache.BeginBatch();
+	Cache.Request(FlaggedDesc, [&](const vector<uint8_t>&) { vOrder.emplace_back(0); });
+	Cache.Request(PixelShaderDesc, [&](const vector<uint8_t>&) { vOrder.emplace_back(1); });
+	Cache.Request(FlaggedDesc, [&](const vector<uint8_t>&) { vOrder.emplace_back(2); });
+	Cache.Request(BadDesc, [&](const vector<uint8_t>&) { vOrder.emplace_back(3); });
+	Cache.Request(Desc, [&](const vector<uint8_t>&) { vOrder.emplace_back(4); });
+	const int KCompileCountBefore{ Compiler.CompileCount };
+	CHECK(vOrder.empty());
+	Cache.EndBatch(4);
+	CHECK((vOrder == vector<int>{ 0, 1, 2, 4 }));
+	CHECK(Compiler.CompileCount - KCompileCountBefore == 3); // FlaggedDesc, PixelShaderDesc and BadDesc (Desc is cached)
+
+	// Without a directory nothing is written (not even to the working directory), so every request compiles
+	CShaderCache Uncached{ &Compiler, "" };
+	std::remove(Uncached.GetCacheFileName(KKey).c_str());
+	Uncached.Request(Desc, [](const vector<uint8_t>&) {});
+	Uncached.Request(Desc, [](const vector<uint8_t>&) {});
+	CHECK(Uncached.GetStats().HitCount == 0 && Uncached.GetStats().MissCount == 2);
+	CHECK(!std::ifstream(Uncached.GetCacheFileName(KKey)).is_open());
+}
+
+// CGame::CreateBaseShaders() requests about 34 shaders; each stub compile takes 40 ms
+BENCH_CASE(ShaderCache_StartupTime)
+{
+	const string KDirectory{ GetTestDirectory() };
+	WriteTextFile(KDirectory + "/Shader/Header.hlsli", "float b;\n");
+	constexpr int KShaderCount{ 34 };
+	vector<SShaderCompileDesc> vDescs{};
+	for (int iShader = 0; iShader < KShaderCount; ++iShader)
+	{
+		SShaderCompileDesc Desc{};
+		Desc.FileName = KDirectory + "/Shader/Startup" + to_string(iShader) + ".hlsl";
+		Desc.EntryPoint = "main";
+		Desc.Profile = "vs_4_0";
+		WriteTextFile(Desc.FileName, "#include \"Header.hlsli\"\nvoid main(){} // " + to_string(iShader) + "\n");
+		vDescs.emplace_back(Desc);
+	}
+
+	auto RunStartup{ [&](uint32_t ThreadCount, bool bIsCold)
+		{
+			CShaderCompilerStub Compiler{};
+			Compiler.CompileMilliseconds = 40;
+			CShaderCache Cache{ &Compiler, KDirectory + "/StartupCache" };
+			if (bIsCold)
+			{
+				for (const SShaderCompileDesc& Desc : vDescs) std::remove(Cache.GetCacheFileName(Cache.CalculateKey(Desc)).c_str());
+			}
+
+			CTestTimer Timer{};
+			Cache.BeginBatch();
+			for (const SShaderCompileDesc& Desc : vDescs) Cache.Request(Desc, [](const vector<uint8_t>&) {});
+			Cache.EndBatch(ThreadCount);
+			printf("%u thread(s), %s cache: %.0f ms (%zu hits, %zu misses)\n", ThreadCount, (bIsCold) ? "cold" : "warm", Timer.GetElapsedMilliseconds(),
+				Cache.GetStats().HitCount, Cache.GetStats().MissCount);
+			return Cache.GetStats();
+		} };
+	RunStartup(1, true);
+	RunStartup(8, true);
+	const CShaderCache::SStats KWarmStats{ RunStartup(8, false) };
+	CHECK(KWarmStats.HitCount == KShaderCount && KWarmStats.MissCount == 0);
+}
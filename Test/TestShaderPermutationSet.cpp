@@ -0,0 +1,118 @@
+#include "Test.h"
+#include "Core/ShaderPermutationSet.h"
+#include <random>
+
+// The feature sets CGame::CreateShaderPermutationSets() declares
+static void AddPSBaseFeatures(CShaderPermutationSet& PermutationSet)
+{
+	PermutationSet.AddFeature(0x1, "USE_TEXTURE");
+	PermutationSet.AddFeature(0x2, "USE_LIGHTING");
+	PermutationSet.AddFeature(0x4, "HAS_DIFFUSE_TEXTURE", 0x1);
+	PermutationSet.AddFeature(0x8, "HAS_OPACITY_TEXTURE");
+}
+
+static void AddPSTerrainFeatures(CShaderPermutationSet& PermutationSet)
+{
+	PermutationSet.AddFeature(0x1, "USE_LAYER1");
+	PermutationSet.AddFeature(0x2, "USE_LAYER2");
+	PermutationSet.AddFeature(0x4, "USE_LAYER3");
+	PermutationSet.AddFeature(0x8, "USE_LAYER4");
+	PermutationSet.AddFeature(0x10, "USE_TILE_MASKING");
+}
+
+TEST_CASE(ShaderPermutationSet_PrunesAndLooksUpVariants)
+{
+	CShaderPermutationSet Empty{};
+	CHECK(Empty.GetVariantCount() == 1);
+	CHECK(Empty.GetVariantIndex(0xFFFF) == 0);
+	CHECK(Empty.GetDefines(0xFFFF).empty());
+
+	// HAS_DIFFUSE_TEXTURE without USE_TEXTURE can't differ from no diffuse texture
+	CShaderPermutationSet PSBase{};
+	AddPSBaseFeatures(PSBase);
+	CHECK(PSBase.GetFeatureCount() == 4 && PSBase.GetFeatureMask() == 0xF);
+	CHECK(PSBase.GetVariantCount() == 12);
+	CHECK(PSBase.Normalize(0x4) == 0);
+	CHECK(PSBase.Normalize(0x5) == 0x5);
+	CHECK(PSBase.Normalize(0xE) == 0xA);
+	CHECK(PSBase.Normalize(0x30) == 0);
+
+	// Every key, in or out of the mask, finds its normalized key's variant; variants are sorted by key
+	for (uint32_t Key = 0; Key < 64; ++Key)
+	{
+		CHECK(PSBase.GetVariantKey(PSBase.GetVariantIndex(Key)) == PSBase.Normalize(Key));
+	}
+	for (size_t iVariant = 1; iVariant < PSBase.GetVariantCount(); ++iVariant)
+	{
+		CHECK(PSBase.GetVariantKey(iVariant - 1) < PSBase.GetVariantKey(iVariant));
+	}
+	CHECK(PSBase.GetVariantKey(0) == 0);
+
+	// Every feature is defined, pruned ones as 0
+	const vector<SShaderDefine> KDefines{ PSBase.GetDefines(0x6) };
+	CHECK(KDefines.size() == 4);
+	if (KDefines.size() == 4)
+	{
+		CHECK(KDefines[0].Name == "USE_TEXTURE" && KDefines[0].Value == "0");
+		CHECK(KDefines[1].Name == "USE_LIGHTING" && KDefines[1].Value == "1");
+		CHECK(KDefines[2].Name == "HAS_DIFFUSE_TEXTURE" && KDefines[2].Value == "0");
+		CHECK(KDefines[3].Name == "HAS_OPACITY_TEXTURE" && KDefines[3].Value == "0");
+	}
+
+	// Chains of requirements
+	CShaderPermutationSet Chain{};
+	Chain.AddFeature(0x1, "A");
+	Chain.AddFeature(0x2, "B", 0x1);
+	Chain.AddFeature(0x4, "C", 0x2);
+	CHECK(Chain.GetVariantCount() == 4);
+	CHECK(Chain.Normalize(0x6) == 0);
+	CHECK(Chain.Normalize(0x5) == 0x1);
+	CHECK(Chain.Normalize(0x7) == 0x7);
+
+	// Features that aren't the low bits
+	CShaderPermutationSet Sparse{};
+	Sparse.AddFeature(0x10, "HIGH");
+	Sparse.AddFeature(0x2, "LOW");
+	CHECK(Sparse.GetVariantCount() == 4);
+	CHECK(Sparse.GetVariantKey(Sparse.GetVariantIndex(0x13)) == 0x12);
+
+	// Constants are defined in every variant and don't add any
+	Sparse.AddConstant("REFERENCE", "0.5");
+	CHECK(Sparse.GetVariantCount() == 4);
+	for (size_t iVariant = 0; iVariant < Sparse.GetVariantCount(); ++iVariant)
+	{
+		const vector<SShaderDefine> KVariantDefines{ Sparse.GetDefines(Sparse.GetVariantKey(iVariant)) };
+		CHECK(KVariantDefines.size() == 3);
+		if (KVariantDefines.size() == 3) CHECK(KVariantDefines[2].Name == "REFERENCE" && KVariantDefines[2].Value == "0.5");
+	}
+}
+
+// Variants compiled per shader, and what resolving a draw's key costs (the renderer does it instead of uploading flag constant buffers)
+BENCH_CASE(ShaderPermutationSet_VariantCountAndLookup)
+{
+	CShaderPermutationSet PSBase{};
+	AddPSBaseFeatures(PSBase);
+	CShaderPermutationSet DSTerrain{};
+	DSTerrain.AddFeature(0x1, "USE_DISPLACEMENT");
+	CShaderPermutationSet PSTerrain{};
+	AddPSTerrainFeatures(PSTerrain);
+	CShaderPermutationSet PSGrassField{};
+	PSGrassField.AddFeature(0x1, "USE_TEXTURE");
+	printf("Variants: PSBase %zu (of %u keys), DSTerrain %zu, PSTerrain %zu, PSGrassField %zu; %zu in total\n", PSBase.GetVariantCount(),
+		PSBase.GetFeatureMask() + 1, DSTerrain.GetVariantCount(), PSTerrain.GetVariantCount(), PSGrassField.GetVariantCount(),
+		PSBase.GetVariantCount() + DSTerrain.GetVariantCount() + PSTerrain.GetVariantCount() + PSGrassField.GetVariantCount());
+	CHECK(PSBase.GetVariantCount() + DSTerrain.GetVariantCount() + PSTerrain.GetVariantCount() + PSGrassField.GetVariantCount() == 48);
+
+	std::mt19937 Random{ 41 };
+	vector<uint32_t> vKeys(1 << 16);
+	for (uint32_t& Key : vKeys) Key = Random() & 0xFF;
+	constexpr int KRepeatCount{ 100 };
+	size_t Sum{};
+	CTestTimer Timer{};
+	for (int iRepeat = 0; iRepeat < KRepeatCount; ++iRepeat)
+	{
+		for (uint32_t Key : vKeys) Sum += PSBase.GetVariantIndex(Key);
+	}
+	const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+	printf("GetVariantIndex(): %.2f ns per key (%zu)\n", KMilliseconds * 1e6 / (static_cast<double>(vKeys.size()) * KRepeatCount), Sum);
+}
@@ -0,0 +1,395 @@
+#include "Test.h"
+#include "Core/SparseMasking.h"
+#include <random>
+
+// Sizes that aren't multiples of the tile size, so that the edge tiles are partial
+constexpr uint32_t KWidth{ 100 };
+constexpr uint32_t KHeight{ 70 };
+
+static uint32_t GetBits(const SPixel32UInt& Texel)
+{
+	uint32_t Bits{};
+	memcpy(&Bits, &Texel, sizeof(Bits));
+	return Bits;
+}
+
+static SPixel32UInt MakeTexel(uint32_t Bits)
+{
+	SPixel32UInt Texel{};
+	memcpy(&Texel, &Bits, sizeof(Bits));
+	return Texel;
+}
+
+static CMipGenerator::SRect MakeRandomRect(std::mt19937& Random, uint32_t Width, uint32_t Height)
+{
+	CMipGenerator::SRect Rect{};
+	Rect.Left = Random() % Width;
+	Rect.Top = Random() % Height;
+	Rect.Right = Rect.Left + 1 + Random() % (Width - Rect.Left);
+	Rect.Bottom = Rect.Top + 1 + Random() % (Height - Rect.Top);
+	return Rect;
+}
+
+static size_t CountMismatches(const CSparseMasking& Masking, const vector<SPixel32UInt>& vDense)
+{
+	size_t MismatchCount{};
+	for (uint32_t V = 0; V < Masking.GetHeight(); ++V)
+	{
+		for (uint32_t U = 0; U < Masking.GetWidth(); ++U)
+		{
+			if (GetBits(Masking.GetTexel(U, V)) != GetBits(vDense[static_cast<size_t>(V) * Masking.GetWidth() + U])) ++MismatchCount;
+		}
+	}
+	return MismatchCount;
+}
+
+// Tiles of the dense texels that have a non-zero texel
+static size_t CountNonZeroTiles(const vector<SPixel32UInt>& vDense, uint32_t Width, uint32_t Height)
+{
+	constexpr uint32_t KTileSize{ CSparseMasking::KTileSize };
+	size_t NonZeroTileCount{};
+	for (uint32_t TileY = 0; TileY < (Height + KTileSize - 1) / KTileSize; ++TileY)
+	{
+		for (uint32_t TileX = 0; TileX < (Width + KTileSize - 1) / KTileSize; ++TileX)
+		{
+			uint32_t Bits{};
+			for (uint32_t V = TileY * KTileSize; V < min((TileY + 1) * KTileSize, Height); ++V)
+			{
+				for (uint32_t U = TileX * KTileSize; U < min((TileX + 1) * KTileSize, Width); ++U)
+				{
+					Bits |= GetBits(vDense[static_cast<size_t>(V) * Width + U]);
+				}
+			}
+			if (Bits) ++NonZeroTileCount;
+		}
+	}
+	return NonZeroTileCount;
+}
+
+TEST_CASE(SparseMasking_UnallocatedTilesReadZero)
+{
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	CHECK(Masking.GetTileCountX() == 4 && Masking.GetTileCountY() == 3);
+
+	const vector<SPixel32UInt> KDense(static_cast<size_t>(KWidth) * KHeight);
+	CHECK(CountMismatches(Masking, KDense) == 0);
+	CHECK(Masking.FindTexel(0, 0) == nullptr);
+	CHECK(Masking.FindTexel(KWidth - 1, KHeight - 1) == nullptr);
+	for (uint32_t TileY = 0; TileY < Masking.GetTileCountY(); ++TileY)
+	{
+		for (uint32_t TileX = 0; TileX < Masking.GetTileCountX(); ++TileX)
+		{
+			CHECK(Masking.GetTileSlot(TileX, TileY) == CSparseMasking::KEmptySlot);
+		}
+	}
+
+	// ReadRect() overwrites whatever the output held
+	vector<SPixel32UInt> vRead(static_cast<size_t>(KWidth) * KHeight, MakeTexel(0xDEADBEEF));
+	Masking.ReadRect(CMipGenerator::SRect{ 0, 0, KWidth, KHeight }, vRead.data(), KWidth);
+	size_t NonZeroCount{};
+	for (const SPixel32UInt& Texel : vRead) if (GetBits(Texel)) ++NonZeroCount;
+	CHECK(NonZeroCount == 0);
+
+	// Only the tile table takes memory
+	const CSparseMasking::SStats KStats{ Masking.GetStats() };
+	CHECK(KStats.TileCount == 12);
+	CHECK(KStats.AllocatedTileCount == 0 && KStats.PoolTileCount == 0);
+	CHECK(KStats.MemoryBytes == KStats.TileCount * sizeof(uint32_t));
+	CHECK(KStats.DenseMemoryBytes == KDense.size() * sizeof(SPixel32UInt));
+}
+
+TEST_CASE(SparseMasking_GetTexelForWriteAllocatesTile)
+{
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	vector<SPixel32UInt> vDense(static_cast<size_t>(KWidth) * KHeight);
+
+	// The texel's tile is allocated with 0 texels, its neighbours stay unallocated
+	SPixel32UInt* const PtrTexel{ Masking.GetTexelForWrite(40, 3) };
+	CHECK(PtrTexel != nullptr && GetBits(*PtrTexel) == 0);
+	*PtrTexel = MakeTexel(0x11223344);
+	vDense[3 * KWidth + 40] = MakeTexel(0x11223344);
+	CHECK(Masking.GetTileSlot(1, 0) != CSparseMasking::KEmptySlot);
+	CHECK(Masking.GetTileSlot(0, 0) == CSparseMasking::KEmptySlot && Masking.GetTileSlot(2, 0) == CSparseMasking::KEmptySlot);
+	CHECK(Masking.GetTileSlot(1, 1) == CSparseMasking::KEmptySlot);
+	CHECK(Masking.FindTexel(40, 3) == PtrTexel && Masking.FindTexel(63, 31) != nullptr && Masking.FindTexel(64, 3) == nullptr);
+	CHECK(Masking.GetStats().AllocatedTileCount == 1);
+	CHECK(Masking.GetPoolTileCount() == CSparseMasking::KPoolPageTileCount);
+
+	// Texels of an allocated tile don't allocate again
+	CHECK(Masking.GetTexelForWrite(63, 31) == Masking.FindTexel(63, 31));
+	CHECK(Masking.GetStats().AllocatedTileCount == 1);
+
+	// The partial corner tile
+	Masking.GetTexelForWrite(KWidth - 1, KHeight - 1)->A = 200;
+	vDense[static_cast<size_t>(KHeight - 1) * KWidth + KWidth - 1].A = 200;
+	CHECK(Masking.GetTileSlot(3, 2) != CSparseMasking::KEmptySlot);
+	CHECK(Masking.GetStats().AllocatedTileCount == 2);
+
+	CHECK(CountMismatches(Masking, vDense) == 0);
+}
+
+TEST_CASE(SparseMasking_WriteReadRectRoundTrip)
+{
+	std::mt19937 Random{ 48 };
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	vector<SPixel32UInt> vDense(static_cast<size_t>(KWidth) * KHeight);
+
+	// Writing zeros doesn't allocate tiles
+	const vector<SPixel32UInt> KZeros(static_cast<size_t>(KWidth) * KHeight);
+	Masking.WriteRect(CMipGenerator::SRect{ 0, 0, KWidth, KHeight }, KZeros.data(), KWidth);
+	CHECK(Masking.GetStats().AllocatedTileCount == 0);
+
+	vector<SPixel32UInt> vSource{};
+	vector<SPixel32UInt> vRead{};
+	for (int iWrite = 0; iWrite < 200; ++iWrite)
+	{
+		// Sources are wider than their rects, and a quarter of them are zero
+		const CMipGenerator::SRect KWriteRect{ MakeRandomRect(Random, KWidth, KHeight) };
+		const uint32_t KSourceWidth{ KWriteRect.Right - KWriteRect.Left + static_cast<uint32_t>(Random() % 5) };
+		const bool bIsZero{ Random() % 4 == 0 };
+		vSource.assign(static_cast<size_t>(KSourceWidth) * (KWriteRect.Bottom - KWriteRect.Top), SPixel32UInt());
+		if (!bIsZero) for (SPixel32UInt& Texel : vSource) Texel = MakeTexel(static_cast<uint32_t>(Random()));
+
+		Masking.WriteRect(KWriteRect, vSource.data(), KSourceWidth);
+		for (uint32_t V = KWriteRect.Top; V < KWriteRect.Bottom; ++V)
+		{
+			for (uint32_t U = KWriteRect.Left; U < KWriteRect.Right; ++U)
+			{
+				vDense[static_cast<size_t>(V) * KWidth + U] = vSource[static_cast<size_t>(V - KWriteRect.Top) * KSourceWidth + (U - KWriteRect.Left)];
+			}
+		}
+
+		const CMipGenerator::SRect KReadRect{ MakeRandomRect(Random, KWidth, KHeight) };
+		const uint32_t KOutWidth{ KReadRect.Right - KReadRect.Left + static_cast<uint32_t>(Random() % 5) };
+		vRead.assign(static_cast<size_t>(KOutWidth) * (KReadRect.Bottom - KReadRect.Top), MakeTexel(0xDEADBEEF));
+		Masking.ReadRect(KReadRect, vRead.data(), KOutWidth);
+		size_t MismatchCount{};
+		for (uint32_t V = KReadRect.Top; V < KReadRect.Bottom; ++V)
+		{
+			for (uint32_t U = KReadRect.Left; U < KReadRect.Right; ++U)
+			{
+				if (GetBits(vRead[static_cast<size_t>(V - KReadRect.Top) * KOutWidth + (U - KReadRect.Left)]) !=
+					GetBits(vDense[static_cast<size_t>(V) * KWidth + U])) ++MismatchCount;
+			}
+		}
+		CHECK(MismatchCount == 0);
+	}
+	CHECK(CountMismatches(Masking, vDense) == 0);
+}
+
+TEST_CASE(SparseMasking_ReleaseZeroTiles)
+{
+	std::mt19937 Random{ 480 };
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	vector<SPixel32UInt> vDense(static_cast<size_t>(KWidth) * KHeight);
+
+	// One texel in every tile
+	for (uint32_t TileY = 0; TileY < Masking.GetTileCountY(); ++TileY)
+	{
+		for (uint32_t TileX = 0; TileX < Masking.GetTileCountX(); ++TileX)
+		{
+			const uint32_t KU{ min(TileX * CSparseMasking::KTileSize + 5, KWidth - 1) };
+			const uint32_t KV{ min(TileY * CSparseMasking::KTileSize + 7, KHeight - 1) };
+			Masking.GetTexelForWrite(KU, KV)->G = 255;
+			vDense[static_cast<size_t>(KV) * KWidth + KU].G = 255;
+		}
+	}
+	CHECK(Masking.GetStats().AllocatedTileCount == 12);
+
+	// Erasing the left half leaves zero tiles allocated until they're released
+	const CMipGenerator::SRect KEraseRect{ 0, 0, 64, KHeight };
+	const vector<SPixel32UInt> KZeros(static_cast<size_t>(KWidth) * KHeight);
+	Masking.WriteRect(KEraseRect, KZeros.data(), KWidth);
+	for (uint32_t V = KEraseRect.Top; V < KEraseRect.Bottom; ++V)
+	{
+		for (uint32_t U = KEraseRect.Left; U < KEraseRect.Right; ++U) vDense[static_cast<size_t>(V) * KWidth + U] = SPixel32UInt();
+	}
+	CHECK(Masking.GetStats().AllocatedTileCount == 12);
+
+	// Only the tiles that Rect reaches are released
+	CHECK(Masking.ReleaseZeroTiles(CMipGenerator::SRect{ 0, 0, 10, 10 }) == 1);
+	CHECK(Masking.ReleaseZeroTiles(CMipGenerator::SRect{ 0, 0, KWidth, KHeight }) == 5);
+	CHECK(Masking.GetStats().AllocatedTileCount == CountNonZeroTiles(vDense, KWidth, KHeight));
+	CHECK(Masking.GetTileSlot(0, 0) == CSparseMasking::KEmptySlot && Masking.GetTileSlot(2, 0) != CSparseMasking::KEmptySlot);
+	CHECK(Masking.ReleaseZeroTiles(CMipGenerator::SRect{ 0, 0, KWidth, KHeight }) == 0);
+	CHECK(CountMismatches(Masking, vDense) == 0);
+
+	// Released slots are reused instead of growing the pool
+	const size_t KPoolTileCount{ Masking.GetPoolTileCount() };
+	for (int iTexel = 0; iTexel < 100; ++iTexel)
+	{
+		const uint32_t KU{ static_cast<uint32_t>(Random() % 64) };
+		const uint32_t KV{ static_cast<uint32_t>(Random() % KHeight) };
+		Masking.GetTexelForWrite(KU, KV)->R = 1;
+		vDense[static_cast<size_t>(KV) * KWidth + KU].R = 1;
+	}
+	CHECK(Masking.GetPoolTileCount() == KPoolTileCount);
+	CHECK(Masking.GetStats().AllocatedTileCount == CountNonZeroTiles(vDense, KWidth, KHeight));
+	CHECK(CountMismatches(Masking, vDense) == 0);
+}
+
+TEST_CASE(SparseMasking_AtlasSlotBorders)
+{
+	std::mt19937 Random{ 4800 };
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	vector<SPixel32UInt> vDense(static_cast<size_t>(KWidth) * KHeight);
+
+	// Tile (1, 1) stays unallocated, so that its neighbours' texels are all its slot has
+	for (uint32_t V = 0; V < KHeight; ++V)
+	{
+		for (uint32_t U = 0; U < KWidth; ++U)
+		{
+			if (U / CSparseMasking::KTileSize == 1 && V / CSparseMasking::KTileSize == 1) continue;
+
+			const SPixel32UInt KTexel{ MakeTexel(static_cast<uint32_t>(Random()) | 1) };
+			*Masking.GetTexelForWrite(U, V) = KTexel;
+			vDense[static_cast<size_t>(V) * KWidth + U] = KTexel;
+		}
+	}
+
+	// Borders are the neighbours' texels, clamped to the texture's edge
+	constexpr uint32_t KSlotSize{ CSparseMasking::KAtlasSlotSize };
+	vector<SPixel32UInt> vSlot(static_cast<size_t>(KSlotSize) * KSlotSize);
+	for (uint32_t TileY = 0; TileY < Masking.GetTileCountY(); ++TileY)
+	{
+		for (uint32_t TileX = 0; TileX < Masking.GetTileCountX(); ++TileX)
+		{
+			Masking.ReadAtlasSlot(TileX, TileY, vSlot.data());
+
+			size_t MismatchCount{};
+			for (uint32_t Y = 0; Y < KSlotSize; ++Y)
+			{
+				const int KV{ static_cast<int>(TileY * CSparseMasking::KTileSize + Y) - static_cast<int>(CSparseMasking::KAtlasBorder) };
+				const size_t KClampedV{ static_cast<size_t>(min(max(KV, 0), static_cast<int>(KHeight) - 1)) };
+				for (uint32_t X = 0; X < KSlotSize; ++X)
+				{
+					const int KU{ static_cast<int>(TileX * CSparseMasking::KTileSize + X) - static_cast<int>(CSparseMasking::KAtlasBorder) };
+					const size_t KClampedU{ static_cast<size_t>(min(max(KU, 0), static_cast<int>(KWidth) - 1)) };
+					if (GetBits(vSlot[Y * KSlotSize + X]) != GetBits(vDense[KClampedV * KWidth + KClampedU])) ++MismatchCount;
+				}
+			}
+			CHECK(MismatchCount == 0);
+		}
+	}
+}
+
+TEST_CASE(SparseMasking_DownsampleMatchesDenseAverage)
+{
+	std::mt19937 Random{ 48000 };
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+	vector<SPixel32UInt> vDense(static_cast<size_t>(KWidth) * KHeight);
+	for (int iWrite = 0; iWrite < 20; ++iWrite)
+	{
+		const CMipGenerator::SRect KRect{ MakeRandomRect(Random, KWidth, KHeight) };
+		for (uint32_t V = KRect.Top; V < KRect.Bottom; ++V)
+		{
+			for (uint32_t U = KRect.Left; U < KRect.Right; ++U)
+			{
+				const SPixel32UInt KTexel{ MakeTexel(static_cast<uint32_t>(Random())) };
+				*Masking.GetTexelForWrite(U, V) = KTexel;
+				vDense[static_cast<size_t>(V) * KWidth + U] = KTexel;
+			}
+		}
+	}
+
+	// Blocks at the right and bottom edges are partial and average only the texels they have
+	for (uint32_t Factor : { 1u, 2u, 4u, 8u, 32u })
+	{
+		const uint32_t KBlockCountX{ (KWidth + Factor - 1) / Factor };
+		const uint32_t KBlockCountY{ (KHeight + Factor - 1) / Factor };
+		vector<SPixel32UInt> vOut(static_cast<size_t>(KBlockCountX) * KBlockCountY, MakeTexel(0xDEADBEEF));
+		Masking.Downsample(Factor, CMipGenerator::SRect{ 0, 0, KBlockCountX, KBlockCountY }, vOut.data(), KBlockCountX);
+
+		size_t MismatchCount{};
+		for (uint32_t BlockY = 0; BlockY < KBlockCountY; ++BlockY)
+		{
+			for (uint32_t BlockX = 0; BlockX < KBlockCountX; ++BlockX)
+			{
+				uint32_t Sums[4]{};
+				uint32_t Count{};
+				for (uint32_t V = BlockY * Factor; V < min((BlockY + 1) * Factor, KHeight); ++V)
+				{
+					for (uint32_t U = BlockX * Factor; U < min((BlockX + 1) * Factor, KWidth); ++U)
+					{
+						const SPixel32UInt& KTexel{ vDense[static_cast<size_t>(V) * KWidth + U] };
+						Sums[0] += KTexel.R;
+						Sums[1] += KTexel.G;
+						Sums[2] += KTexel.B;
+						Sums[3] += KTexel.A;
+						++Count;
+					}
+				}
+
+				const SPixel32UInt& KOut{ vOut[static_cast<size_t>(BlockY) * KBlockCountX + BlockX] };
+				if (KOut.R != (Sums[0] + Count / 2) / Count || KOut.G != (Sums[1] + Count / 2) / Count ||
+					KOut.B != (Sums[2] + Count / 2) / Count || KOut.A != (Sums[3] + Count / 2) / Count) ++MismatchCount;
+			}
+		}
+		CHECK(MismatchCount == 0);
+	}
+
+	// A sub-rect writes to the start of its output rows
+	vector<SPixel32UInt> vFull(static_cast<size_t>(13) * 9);
+	Masking.Downsample(8, CMipGenerator::SRect{ 0, 0, 13, 9 }, vFull.data(), 13);
+	vector<SPixel32UInt> vPart(static_cast<size_t>(6) * 4);
+	Masking.Downsample(8, CMipGenerator::SRect{ 7, 5, 13, 9 }, vPart.data(), 6);
+	size_t MismatchCount{};
+	for (uint32_t Y = 0; Y < 4; ++Y)
+	{
+		for (uint32_t X = 0; X < 6; ++X) if (GetBits(vPart[Y * 6 + X]) != GetBits(vFull[(Y + 5) * 13 + (X + 7)])) ++MismatchCount;
+	}
+	CHECK(MismatchCount == 0);
+}
+
+// Memory of painted masking against how much of it is painted (brush discs at random positions, like layers painted in the editor)
+BENCH_CASE(SparseMasking_MemoryByCoverage)
+{
+	constexpr uint32_t KSize{ 4096 };
+	constexpr int KRadius{ 48 };
+	for (float TargetCoverage : { 0.0f, 0.01f, 0.05f, 0.1f, 0.25f, 0.5f, 1.0f })
+	{
+		std::mt19937 Random{ 4 };
+		CSparseMasking Masking{};
+		Masking.Create(KSize, KSize);
+		vector<uint8_t> vIsPainted(static_cast<size_t>(KSize) * KSize);
+		const size_t KTargetCount{ static_cast<size_t>(TargetCoverage * vIsPainted.size()) };
+		size_t PaintedCount{};
+
+		CTestTimer Timer{};
+		if (TargetCoverage >= 1.0f)
+		{
+			vector<SPixel32UInt> vRow(KSize, MakeTexel(0xFF000000));
+			for (uint32_t V = 0; V < KSize; ++V) Masking.WriteRect(CMipGenerator::SRect{ 0, V, KSize, V + 1 }, vRow.data(), KSize);
+			PaintedCount = vIsPainted.size();
+		}
+		while (PaintedCount < KTargetCount)
+		{
+			const int KCenterU{ static_cast<int>(Random() % KSize) };
+			const int KCenterV{ static_cast<int>(Random() % KSize) };
+			for (int V = max(KCenterV - KRadius, 0); V < min(KCenterV + KRadius + 1, static_cast<int>(KSize)); ++V)
+			{
+				for (int U = max(KCenterU - KRadius, 0); U < min(KCenterU + KRadius + 1, static_cast<int>(KSize)); ++U)
+				{
+					if ((U - KCenterU) * (U - KCenterU) + (V - KCenterV) * (V - KCenterV) > KRadius * KRadius) continue;
+
+					Masking.GetTexelForWrite(static_cast<uint32_t>(U), static_cast<uint32_t>(V))->A = 255;
+					uint8_t& bIsPainted{ vIsPainted[static_cast<size_t>(V) * KSize + U] };
+					if (!bIsPainted) ++PaintedCount;
+					bIsPainted = 1;
+				}
+			}
+		}
+		const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		const CSparseMasking::SStats KStats{ Masking.GetStats() };
+		printf("coverage %5.1f%%: %6zu / %6zu tiles, %8.2f MB (dense %6.2f MB, %5.1f%%), painted in %8.2f ms\n",
+			100.0 * PaintedCount / vIsPainted.size(), KStats.AllocatedTileCount, KStats.TileCount, KStats.MemoryBytes / 1048576.0,
+			KStats.DenseMemoryBytes / 1048576.0, 100.0 * KStats.MemoryBytes / KStats.DenseMemoryBytes, KMilliseconds);
+	}
+}
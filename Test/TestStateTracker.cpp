@@ -0,0 +1,226 @@
+#include "Test.h"
+#include "Core/StateTracker.h"
+#include "Core/RenderDeviceNull.h"
+#include "Core/RenderQueue.h"
+#include <map>
+#include <random>
+#include <tuple>
+
+struct SSceneObject
+{
+	uint32_t	ShaderID{};
+	uint32_t	TextureSetID{};
+	uint32_t	MaterialID{};
+	float		Depth{};
+	bool		bIsTransparent{};
+};
+
+// What CObject3D::Draw() sets for a (non-instanced, non-tessellated) object
+static void DrawSceneObject(CStateTracker& StateTracker, const SSceneObject& Object, uint32_t ObjectIndex)
+{
+	StateTracker.SetVertexShader(MakeHandle<ID3D11VertexShader>(0x100 + Object.ShaderID));
+	StateTracker.SetInputLayout(MakeHandle<ID3D11InputLayout>(0x200 + Object.ShaderID));
+	for (UINT Slot = 0; Slot < 3; ++Slot) StateTracker.SetConstantBuffer(EShaderType::VertexShader, Slot, MakeHandle<ID3D11Buffer>(0x300 + Slot));
+	StateTracker.SetHullShader(nullptr);
+	StateTracker.SetDomainShader(nullptr);
+	StateTracker.SetPixelShader(MakeHandle<ID3D11PixelShader>(0x400 + Object.ShaderID % 3));
+	StateTracker.SetConstantBuffer(EShaderType::PixelShader, 0, MakeHandle<ID3D11Buffer>(0x500 + Object.MaterialID));
+	StateTracker.SetShaderResource(EShaderType::PixelShader, 0, MakeHandle<ID3D11ShaderResourceView>(0x600 + Object.TextureSetID));
+	StateTracker.SetShaderResource(EShaderType::PixelShader, 5, MakeHandle<ID3D11ShaderResourceView>(0x700 + Object.TextureSetID));
+	StateTracker.SetSamplerState(EShaderType::PixelShader, 0, MakeHandle<ID3D11SamplerState>(0x800));
+	StateTracker.SetRasterizerState(MakeHandle<ID3D11RasterizerState>(0x900));
+	StateTracker.SetDepthStencilState(MakeHandle<ID3D11DepthStencilState>(0xA00), 0);
+	StateTracker.SetBlendState(MakeHandle<ID3D11BlendState>((Object.bIsTransparent) ? 0xB01 : 0xB00));
+	StateTracker.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	StateTracker.SetVertexBuffer(0, MakeHandle<ID3D11Buffer>(0x10000 + ObjectIndex), 48, 0);
+	StateTracker.SetIndexBuffer(MakeHandle<ID3D11Buffer>(0x20000 + ObjectIndex), DXGI_FORMAT_R32_UINT, 0);
+	StateTracker.DrawIndexed(300, 0, 0);
+}
+
+static vector<SSceneObject> GenerateScene(size_t ObjectCount, uint32_t Seed)
+{
+	std::mt19937 Random{ Seed };
+	vector<SSceneObject> vObjects{};
+	for (size_t iObject = 0; iObject < ObjectCount; ++iObject)
+	{
+		vObjects.push_back(SSceneObject{ static_cast<uint32_t>(Random() % 8), static_cast<uint32_t>(Random() % 50),
+			static_cast<uint32_t>(Random() % 20), (Random() % 10'000) / 10'000.0f, Random() % 10 == 0 });
+	}
+	return vObjects;
+}
+
+// The state bound at each draw, rebuilt from the recorded commands
+using SBoundState = std::map<std::tuple<int, int, UINT>, std::tuple<const void*, UINT, UINT, UINT>>;
+static vector<SBoundState> GetBoundStatesAtDraws(const vector<CRenderDeviceNull::SCommand>& vCommands)
+{
+	using ECommandType = CRenderDeviceNull::ECommandType;
+
+	vector<SBoundState> vStates{};
+	SBoundState State{};
+	for (const CRenderDeviceNull::SCommand& Command : vCommands)
+	{
+		switch (Command.eType)
+		{
+		case ECommandType::Draw:
+		case ECommandType::DrawIndexed:
+		case ECommandType::DrawIndexedInstanced:
+			vStates.emplace_back(State);
+			break;
+		case ECommandType::SetConstantBufferRange:
+			// Binds the same slot as SetConstantBuffer
+			State[std::make_tuple(static_cast<int>(ECommandType::SetConstantBuffer), static_cast<int>(Command.eShaderType), Command.Slot)] =
+				std::make_tuple(Command.PtrObject, Command.Arguments[0], Command.Arguments[1], Command.Arguments[2]);
+			break;
+		default:
+			State[std::make_tuple(static_cast<int>(Command.eType), static_cast<int>(Command.eShaderType), Command.Slot)] =
+				std::make_tuple(Command.PtrObject, Command.Arguments[0], Command.Arguments[1], Command.Arguments[2]);
+			break;
+		}
+	}
+	return vStates;
+}
+
+TEST_CASE(StateTracker_SkipsOnlyRedundantCalls)
+{
+	const vector<SSceneObject> KObjects{ GenerateScene(500, 3) };
+	CRenderDeviceNull Direct{};
+	CRenderDeviceNull Tracked{};
+	CStateTracker DirectTracker{ &Direct };
+	CStateTracker TrackedTracker{ &Tracked };
+	TrackedTracker.BeginTracking();
+	for (uint32_t iObject = 0; iObject < KObjects.size(); ++iObject)
+	{
+		DrawSceneObject(DirectTracker, KObjects[iObject], iObject);
+		DrawSceneObject(TrackedTracker, KObjects[iObject], iObject);
+	}
+	TrackedTracker.EndTracking();
+
+	// Same bound state at every draw, with fewer calls
+	const vector<SBoundState> KDirectStates{ GetBoundStatesAtDraws(Direct.GetCommands()) };
+	const vector<SBoundState> KTrackedStates{ GetBoundStatesAtDraws(Tracked.GetCommands()) };
+	CHECK(KDirectStates.size() == KObjects.size());
+	CHECK(KTrackedStates.size() == KObjects.size());
+	size_t DifferentStateCount{};
+	for (size_t iDraw = 0; iDraw < min(KDirectStates.size(), KTrackedStates.size()); ++iDraw)
+	{
+		if (KDirectStates[iDraw] != KTrackedStates[iDraw]) ++DifferentStateCount;
+	}
+	CHECK(DifferentStateCount == 0);
+
+	const CStateTracker::SStats& KStats{ TrackedTracker.GetStats() };
+	CHECK(Tracked.GetStats().CallCount < Direct.GetStats().CallCount);
+	CHECK(KStats.SkippedCallCount == Direct.GetStats().CallCount - Tracked.GetStats().CallCount);
+	CHECK(KStats.DrawCallCount == KObjects.size());
+	CHECK(DirectTracker.GetStats().SkippedCallCount == 0);
+	CHECK(Direct.GetStats().ValidationErrorCount == 0);
+	CHECK(Tracked.GetStats().ValidationErrorCount == 0);
+}
+
+TEST_CASE(StateTracker_InvalidateAndTrackingRange)
+{
+	CRenderDeviceNull Device{};
+	CStateTracker StateTracker{ &Device };
+	ID3D11PixelShader* const KShader{ MakeHandle<ID3D11PixelShader>(1) };
+
+	// Outside of tracking every call is forwarded
+	StateTracker.SetPixelShader(KShader);
+	StateTracker.SetPixelShader(KShader);
+	CHECK(Device.GetStats().CallCount == 2);
+	CHECK(StateTracker.GetLastShader(EShaderType::PixelShader) == KShader);
+
+	// The cache starts invalid, so the first call is issued even if it matches what was set before tracking
+	StateTracker.BeginTracking();
+	StateTracker.SetPixelShader(KShader);
+	StateTracker.SetPixelShader(KShader);
+	CHECK(Device.GetStats().CallCount == 3);
+
+	// Code that bound state behind the tracker's back must invalidate it
+	StateTracker.Invalidate();
+	StateTracker.SetPixelShader(KShader);
+	CHECK(Device.GetStats().CallCount == 4);
+
+	// Slots above the tracked range are always forwarded
+	const UINT KUntrackedSlot{ static_cast<UINT>(CStateTracker::KTrackedShaderResourceSlotCount) };
+	ID3D11ShaderResourceView* const KView{ MakeHandle<ID3D11ShaderResourceView>(2) };
+	StateTracker.SetShaderResource(EShaderType::PixelShader, KUntrackedSlot, KView);
+	StateTracker.SetShaderResource(EShaderType::PixelShader, KUntrackedSlot, KView);
+	CHECK(Device.GetStats().CallCount == 6);
+
+	// Constant buffer ranges of the same buffer are different bindings
+	ID3D11Buffer* const KBuffer{ MakeHandle<ID3D11Buffer>(3) };
+	StateTracker.SetConstantBufferRange(EShaderType::VertexShader, 1, KBuffer, 0, 16);
+	StateTracker.SetConstantBufferRange(EShaderType::VertexShader, 1, KBuffer, 16, 16);
+	StateTracker.SetConstantBufferRange(EShaderType::VertexShader, 1, KBuffer, 16, 16);
+	StateTracker.SetConstantBuffer(EShaderType::VertexShader, 1, KBuffer);
+	CHECK(Device.GetStats().CallCount == 9);
+	StateTracker.EndTracking();
+
+	StateTracker.SetPixelShader(KShader);
+	CHECK(Device.GetStats().CallCount == 10);
+	CHECK(StateTracker.GetStats().SkippedCallCount == 2);
+	StateTracker.BeginFrame();
+	CHECK(StateTracker.GetStats().SkippedCallCount == 0);
+}
+
+TEST_CASE(RenderDeviceNull_ValidatesCalls)
+{
+	CRenderDeviceNull Device{};
+	Device.DrawIndexed(3, 0, 0);
+	CHECK(Device.GetStats().ValidationErrorCount > 0);
+
+	const size_t KErrorCount{ Device.GetStats().ValidationErrorCount };
+	Device.SetConstantBuffer(EShaderType::PixelShader, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, nullptr);
+	CHECK(Device.GetStats().ValidationErrorCount == KErrorCount + 1);
+	CHECK(!Device.GetLastValidationError().empty());
+
+	CRenderDeviceNull NoRangeDevice{ true, false };
+	NoRangeDevice.SetConstantBufferRange(EShaderType::VertexShader, 0, MakeHandle<ID3D11Buffer>(1), 0, 16);
+	CHECK(NoRangeDevice.GetStats().ValidationErrorCount == 1);
+
+	// The recording is cleared, the bound state is kept
+	CRenderDeviceNull ValidDevice{};
+	ValidDevice.SetVertexShader(MakeHandle<ID3D11VertexShader>(1));
+	ValidDevice.SetPixelShader(MakeHandle<ID3D11PixelShader>(1));
+	ValidDevice.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	ValidDevice.Reset();
+	CHECK(ValidDevice.GetCommands().empty());
+	ValidDevice.Draw(3, 0);
+	CHECK(ValidDevice.GetStats().ValidationErrorCount == 0);
+	CHECK(ValidDevice.GetStats().DrawCallCount == 1);
+}
+
+BENCH_CASE(StateTracker_SortedScene)
+{
+	const vector<SSceneObject> KObjects{ GenerateScene(2'000, 7) };
+	for (bool bShouldSort : { false, true })
+	{
+		CRenderDeviceNull Device{};
+		CStateTracker StateTracker{ &Device };
+		CRenderQueue Queue{};
+		for (uint32_t iObject = 0; iObject < KObjects.size(); ++iObject)
+		{
+			const SSceneObject& Object{ KObjects[iObject] };
+			Queue.Add((Object.bIsTransparent) ?
+				CRenderQueue::MakeTransparentSortKey(Object.Depth, Object.ShaderID, Object.TextureSetID, Object.MaterialID) :
+				CRenderQueue::MakeOpaqueSortKey(Object.ShaderID, Object.TextureSetID, Object.MaterialID, Object.Depth), iObject);
+		}
+
+		CTestTimer Timer{};
+		StateTracker.BeginFrame();
+		if (bShouldSort)
+		{
+			Queue.Sort();
+			StateTracker.BeginTracking();
+		}
+		for (const CRenderQueue::SPacket& Packet : Queue.GetPackets())
+		{
+			DrawSceneObject(StateTracker, KObjects[Packet.ItemIndex], Packet.ItemIndex);
+		}
+		StateTracker.EndTracking();
+		const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		const CStateTracker::SStats& KStats{ StateTracker.GetStats() };
+		printf("%s: %zu device calls for %zu draws, %zu state changes avoided, %.3f ms\n", (bShouldSort) ? "sorted + tracked" : "insertion order",
+			Device.GetStats().CallCount, Device.GetStats().DrawCallCount, KStats.SkippedCallCount, KMilliseconds);
+	}
+}
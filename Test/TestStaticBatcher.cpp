@@ -0,0 +1,100 @@
+#include "Test.h"
+#include "Core/StaticBatcher.h"
+
+// A unit quad in the XZ plane (4 vertices, 2 triangles)
+static SMesh GenerateQuad()
+{
+	SMesh Mesh{};
+	Mesh.vVertices.emplace_back(XMVectorSet(0, 0, 0, 1), XMVectorSet(1, 1, 1, 1));
+	Mesh.vVertices.emplace_back(XMVectorSet(1, 0, 0, 1), XMVectorSet(1, 1, 1, 1));
+	Mesh.vVertices.emplace_back(XMVectorSet(0, 0, 1, 1), XMVectorSet(1, 1, 1, 1));
+	Mesh.vVertices.emplace_back(XMVectorSet(1, 0, 1, 1), XMVectorSet(1, 1, 1, 1));
+	Mesh.vTriangles.emplace_back(0, 2, 1);
+	Mesh.vTriangles.emplace_back(1, 2, 3);
+	return Mesh;
+}
+
+TEST_CASE(StaticBatcher_MergesByKeyAndCell)
+{
+	const SMesh KQuad{ GenerateQuad() };
+	CStaticBatcher::SDesc Desc{};
+	Desc.CellSize = 16.0f;
+	CStaticBatcher Batcher{ Desc };
+
+	// Keys 1 and 2 in cell (0, 0, 0), key 1 in cell (2, 0, 0)
+	const size_t KMember0{ Batcher.RegisterMember(&KQuad, XMMatrixTranslation(1, 0, 1), 1) };
+	const size_t KMember1{ Batcher.RegisterMember(&KQuad, XMMatrixTranslation(5, 0, 1), 1) };
+	Batcher.RegisterMember(&KQuad, XMMatrixTranslation(9, 0, 1), 1);
+	Batcher.RegisterMember(&KQuad, XMMatrixTranslation(1, 0, 5), 2);
+	Batcher.RegisterMember(&KQuad, XMMatrixTranslation(40, 0, 1), 1);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().MemberCount == 5 && Batcher.GetStats().BatchCount == 3);
+	CHECK(Batcher.GetStats().RebuiltBatchCount == 3);
+
+	size_t VertexCount{};
+	for (const CStaticBatcher::SBatch& Batch : Batcher.GetBatches())
+	{
+		VertexCount += Batch.Mesh.vVertices.size();
+		if (Batch.Key == 1 && Batch.CellX == 0) CHECK(Batch.vMemberIDs.size() == 3 && Batch.Mesh.vTriangles.size() == 6);
+	}
+	CHECK(VertexCount == 20);
+
+	// Nothing changed: nothing is rebuilt
+	Batcher.UpdateMember(KMember0, XMMatrixTranslation(1, 0, 1), 1);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().RebuiltBatchCount == 0);
+
+	// Moving within the cell rebuilds its batch only, moving to another cell rebuilds both batches
+	Batcher.UpdateMember(KMember0, XMMatrixTranslation(2, 0, 1), 1);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().RebuiltBatchCount == 1);
+	Batcher.UpdateMember(KMember1, XMMatrixTranslation(41, 0, 1), 1);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().RebuiltBatchCount == 2 && Batcher.GetStats().BatchCount == 3);
+
+	// A new key moves the member to a batch of its own
+	Batcher.UpdateMember(KMember0, XMMatrixTranslation(2, 0, 1), 3);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().BatchCount == 4);
+
+	Batcher.UnregisterMember(KMember0);
+	Batcher.Update();
+	CHECK(Batcher.GetStats().MemberCount == 4 && Batcher.GetStats().BatchCount == 3);
+}
+
+BENCH_CASE(StaticBatcher_DrawCallsAndBuildTime)
+{
+	static constexpr uint64_t KKeyCount{ 8 };
+
+	const SMesh KQuad{ GenerateQuad() };
+	for (size_t MemberCountPerSide : { 32, 100, 316 })
+	{
+		CStaticBatcher Batcher{};
+		vector<size_t> vMemberIDs{};
+		for (size_t iZ = 0; iZ < MemberCountPerSide; ++iZ)
+		{
+			for (size_t iX = 0; iX < MemberCountPerSide; ++iX)
+			{
+				const XMMATRIX KWorld{ XMMatrixTranslation(4.0f * iX, 0, 4.0f * iZ) };
+				vMemberIDs.emplace_back(Batcher.RegisterMember(&KQuad, KWorld, (iZ * MemberCountPerSide + iX) % KKeyCount));
+			}
+		}
+
+		CTestTimer Timer{};
+		Batcher.Update();
+		const double KBuildMilliseconds{ Timer.GetElapsedMilliseconds() };
+		const CStaticBatcher::SStats KStats{ Batcher.GetStats() };
+		CHECK(KStats.MemberCount == vMemberIDs.size());
+		CHECK(KStats.BatchCount < KStats.MemberCount);
+
+		// A member moving every frame (as with the gizmos) only rebuilds its batch
+		Timer = CTestTimer();
+		Batcher.UpdateMember(vMemberIDs[0], XMMatrixTranslation(1, 0, 1), 0);
+		Batcher.Update();
+		const double KRebuildMilliseconds{ Timer.GetElapsedMilliseconds() };
+		CHECK(Batcher.GetStats().RebuiltBatchCount == 1);
+
+		printf("%zu meshes: %zu draw calls -> %zu batches, built in %.3f ms, one moved mesh rebuilt in %.3f ms\n", KStats.MemberCount,
+			KStats.MemberCount, KStats.BatchCount, KBuildMilliseconds, KRebuildMilliseconds);
+	}
+}
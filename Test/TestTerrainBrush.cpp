@@ -0,0 +1,159 @@
+#include "Test.h"
+#include "Core/TerrainBrush.h"
+#include <cstring>
+
+using EBrushType = CTerrainBrush::EType;
+
+static constexpr EBrushType KBrushTypes[]{ EBrushType::Smooth, EBrushType::Flatten, EBrushType::Noise, EBrushType::ThermalErosion,
+	EBrushType::HydraulicErosion };
+static constexpr const char* KBrushTypeNames[]{ "smooth", "flatten", "noise", "thermal", "hydraulic" };
+
+// Rolling hills with a little texel noise
+static vector<SPixel8UInt> GenerateHeights(uint32_t Width, uint32_t Height)
+{
+	vector<SPixel8UInt> vHeights(static_cast<size_t>(Width) * Height);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			const float KValue{ 128.0f + 60.0f * sinf(X * 0.11f) * cosf(Y * 0.07f) + 20.0f * sinf(X * 0.5f + Y * 0.3f) +
+				static_cast<float>((X * 7 + Y * 13) % 9) - 4.0f };
+			vHeights[static_cast<size_t>(Y) * Width + X].R = static_cast<uint8_t>(min(max(KValue, 0.0f), 255.0f));
+		}
+	}
+	return vHeights;
+}
+
+TEST_CASE(TerrainBrush_ChangesOnlyInsideRadiusAndDirtyRect)
+{
+	constexpr uint32_t KSize{ 96 };
+	const vector<SPixel8UInt> KOriginal{ GenerateHeights(KSize, KSize) };
+	for (size_t iType = 0; iType < 5; ++iType)
+	{
+		size_t OutsideRadiusCount{};
+		size_t OutsideDirtyRectCount{};
+		size_t ChangedCount{};
+		// Centers inside, on the border of and outside the map
+		for (const XMFLOAT2& Center : { XMFLOAT2(48.0f, 48.0f), XMFLOAT2(3.5f, 90.0f), XMFLOAT2(-6.0f, 20.0f), XMFLOAT2(95.0f, 95.0f) })
+		{
+			vector<SPixel8UInt> vHeights{ KOriginal };
+			CTerrainBrush::SDesc Desc{};
+			Desc.eType = KBrushTypes[iType];
+			Desc.Radius = 12.0f;
+			Desc.Strength = 1.0f;
+			Desc.PlaneHeight = 200.0f;
+			CMipGenerator::SRect DirtyRect{};
+			CTerrainBrush::Apply(vHeights.data(), KSize, KSize, Center.x, Center.y, Desc, DirtyRect);
+
+			for (uint32_t Y = 0; Y < KSize; ++Y)
+			{
+				for (uint32_t X = 0; X < KSize; ++X)
+				{
+					const size_t KIndex{ static_cast<size_t>(Y) * KSize + X };
+					if (vHeights[KIndex].R == KOriginal[KIndex].R) continue;
+					++ChangedCount;
+					const float KDistance{ sqrtf((X - Center.x) * (X - Center.x) + (Y - Center.y) * (Y - Center.y)) };
+					if (KDistance >= Desc.Radius) ++OutsideRadiusCount;
+					if (X < DirtyRect.Left || X >= DirtyRect.Right || Y < DirtyRect.Top || Y >= DirtyRect.Bottom) ++OutsideDirtyRectCount;
+				}
+			}
+		}
+		printf("%-9s: %zu texels changed\n", KBrushTypeNames[iType], ChangedCount);
+		CHECK(ChangedCount > 0);
+		CHECK(OutsideRadiusCount == 0);
+		CHECK(OutsideDirtyRectCount == 0);
+	}
+}
+
+TEST_CASE(TerrainBrush_DeterministicAcrossThreadCounts)
+{
+	// Large enough for the passes to be spread over the worker pool
+	constexpr uint32_t KSize{ 256 };
+	const vector<SPixel8UInt> KOriginal{ GenerateHeights(KSize, KSize) };
+	for (size_t iType = 0; iType < 5; ++iType)
+	{
+		vector<SPixel8UInt> vResults[3]{};
+		const uint32_t KThreadCounts[3]{ 1, 3, 0 };
+		for (size_t iRun = 0; iRun < 3; ++iRun)
+		{
+			vResults[iRun] = KOriginal;
+			CTerrainBrush::SDesc Desc{};
+			Desc.eType = KBrushTypes[iType];
+			Desc.Radius = 90.0f;
+			Desc.ThreadCount = KThreadCounts[iRun];
+			CMipGenerator::SRect DirtyRect{};
+			CTerrainBrush::SStats Stats{};
+			CTerrainBrush::Apply(vResults[iRun].data(), KSize, KSize, 128.0f, 120.0f, Desc, DirtyRect, &Stats);
+			CHECK(Stats.WorkingTexelCount >= CTerrainBrush::KMultithreadingMinTexelCount);
+		}
+		CHECK(memcmp(vResults[0].data(), vResults[1].data(), vResults[0].size()) == 0);
+		CHECK(memcmp(vResults[0].data(), vResults[2].data(), vResults[0].size()) == 0);
+	}
+}
+
+TEST_CASE(TerrainBrush_DitheringAccumulatesSmallSteps)
+{
+	// 2% per dab towards 200 from 100: a rounded 8-bit result would never move
+	constexpr uint32_t KSize{ 64 };
+	vector<SPixel8UInt> vHeights(KSize * KSize, SPixel8UInt{ 100 });
+	CTerrainBrush::SDesc Desc{};
+	Desc.eType = EBrushType::Flatten;
+	Desc.PlaneHeight = 200.0f;
+	Desc.Radius = 20.0f;
+	Desc.Hardness = 1.0f;
+	Desc.Strength = 0.02f;
+	CMipGenerator::SRect DirtyRect{};
+	for (int iDab = 0; iDab < 10; ++iDab)
+	{
+		CTerrainBrush::Apply(vHeights.data(), KSize, KSize, 32.0f, 32.0f, Desc, DirtyRect);
+	}
+
+	double Sum{};
+	size_t Count{};
+	for (int Y = 0; Y < static_cast<int>(KSize); ++Y)
+	{
+		for (int X = 0; X < static_cast<int>(KSize); ++X)
+		{
+			if ((X - 32) * (X - 32) + (Y - 32) * (Y - 32) >= 18 * 18) continue;
+			Sum += vHeights[Y * KSize + X].R;
+			++Count;
+		}
+	}
+	CHECK_NEAR(Sum / Count, 200.0 - 100.0 * pow(0.98, 10), 0.5);
+}
+
+// Dabs in the middle of a 2048 x 2048 map; small dabs are the ones whose passes used to be dominated by spawning threads
+BENCH_CASE(TerrainBrush_DabThroughput)
+{
+	constexpr uint32_t KSize{ 2048 };
+	vector<SPixel8UInt> vHeights{ GenerateHeights(KSize, KSize) };
+	for (float Radius : { 8.0f, 32.0f, 128.0f })
+	{
+		for (size_t iType = 0; iType < 5; ++iType)
+		{
+			for (uint32_t ThreadCount : { 1u, 0u })
+			{
+				CTerrainBrush::SDesc Desc{};
+				Desc.eType = KBrushTypes[iType];
+				Desc.Radius = Radius;
+				Desc.SmoothSigma = 2.0f;
+				Desc.ThreadCount = ThreadCount;
+				CMipGenerator::SRect DirtyRect{};
+				CTerrainBrush::SStats Stats{};
+
+				int DabCount{ static_cast<int>(max(4.0f, 50'000.0f / (Radius * Radius))) };
+				if (KBrushTypes[iType] == EBrushType::ThermalErosion || KBrushTypes[iType] == EBrushType::HydraulicErosion) DabCount = max(2, DabCount / 8);
+
+				CTestTimer Timer{};
+				for (int iDab = 0; iDab < DabCount; ++iDab)
+				{
+					CTerrainBrush::Apply(vHeights.data(), KSize, KSize, 1024.0f + (iDab % 7), 1024.0f + (iDab % 5), Desc, DirtyRect, &Stats);
+				}
+				const double KMilliseconds{ Timer.GetElapsedMilliseconds() / DabCount };
+				printf("radius %5.0f %-9s threads %-3s: %8.3f ms per dab, %7.1f M texel-passes/s (%zu texels, %zu tiles, %zu passes)\n",
+					Radius, KBrushTypeNames[iType], (ThreadCount) ? "1" : "all", KMilliseconds,
+					Stats.WorkingTexelCount * Stats.PassCount / KMilliseconds / 1000.0, Stats.WorkingTexelCount, Stats.TileCount, Stats.PassCount);
+			}
+		}
+	}
+}
@@ -0,0 +1,265 @@
+#include "Test.h"
+#include "Core/TerrainGenerator.h"
+#include <cstring>
+
+using ENodeType = CTerrainGenerator::ENodeType;
+
+static float EvaluateAt(const CTerrainGenerator::SGraph& Graph, size_t NodeIndex, float X, float Z)
+{
+	return XMVectorGetX(CTerrainGenerator::EvaluateNode(Graph, NodeIndex, XMVectorReplicate(X), XMVectorReplicate(Z)));
+}
+
+TEST_CASE(TerrainGenerator_NoiseRangesAndContinuity)
+{
+	const ENodeType KNoiseTypes[3]{ ENodeType::PerlinFBm, ENodeType::SimplexFBm, ENodeType::Ridged };
+	const char* const KNoiseNames[3]{ "perlin", "simplex", "ridged" };
+	for (int iType = 0; iType < 3; ++iType)
+	{
+		CTerrainGenerator::SGraph Graph{};
+		Graph.vNodes.emplace_back();
+		Graph.vNodes[0].eType = KNoiseTypes[iType];
+		Graph.vNodes[0].OctaveCount = 1;
+		Graph.vNodes[0].Frequency = 1.0f / 7.3f;
+
+		double Min{ +1e9 };
+		double Max{ -1e9 };
+		double Sum{};
+		size_t Count{};
+		for (int Z = 0; Z < 500; ++Z)
+		{
+			for (int X = 0; X < 1000; X += 4)
+			{
+				XMFLOAT4 Values{};
+				XMStoreFloat4(&Values, CTerrainGenerator::EvaluateNode(Graph, 0, XMVectorSet(static_cast<float>(X), X + 1.0f, X + 2.0f, X + 3.0f),
+					XMVectorReplicate(static_cast<float>(Z))));
+				for (float Value : { Values.x, Values.y, Values.z, Values.w })
+				{
+					Min = min(Min, static_cast<double>(Value));
+					Max = max(Max, static_cast<double>(Value));
+					Sum += Value;
+					++Count;
+				}
+			}
+		}
+		printf("%-7s 1 octave: min %.3f, max %.3f, mean %.3f\n", KNoiseNames[iType], Min, Max, Sum / Count);
+		CHECK(Min >= -1.0001 && Max <= 1.0001);
+		CHECK(Max - Min > 1.0);
+
+		// Neighbouring samples differ little
+		if (KNoiseTypes[iType] == ENodeType::Ridged) continue;
+		Graph.vNodes[0].Frequency = 1.0f;
+		double MaxDelta{};
+		for (int iSample = 0; iSample < 50'000; ++iSample)
+		{
+			const float KX{ (iSample % 1000) * 0.0137f };
+			const float KZ{ (iSample / 1000) * 0.0291f };
+			MaxDelta = max(MaxDelta, static_cast<double>(fabsf(EvaluateAt(Graph, 0, KX, KZ) - EvaluateAt(Graph, 0, KX + 1e-3f, KZ))));
+			MaxDelta = max(MaxDelta, static_cast<double>(fabsf(EvaluateAt(Graph, 0, KX, KZ) - EvaluateAt(Graph, 0, KX, KZ + 1e-3f))));
+		}
+		CHECK(MaxDelta < 0.05);
+	}
+}
+
+TEST_CASE(TerrainGenerator_CurveAndTerraceMatchScalar)
+{
+	CTerrainGenerator::SGraph Graph{};
+	Graph.vNodes.resize(3);
+	Graph.vNodes[0].eType = ENodeType::PerlinFBm;
+	Graph.vNodes[1].eType = ENodeType::Curve;
+	Graph.vNodes[1].Inputs[0] = 0;
+	Graph.vNodes[1].vCurvePoints = { { -0.5f, -1.0f }, { 0.0f, 0.2f }, { 0.0f, 0.4f }, { 0.6f, 1.0f } }; // With a step at 0
+	Graph.vNodes[2].eType = ENodeType::Terrace;
+	Graph.vNodes[2].Inputs[0] = 0;
+	Graph.vNodes[2].TerraceCount = 5;
+	Graph.vNodes[2].TerraceSharpness = 0.4f;
+
+	double MaxCurveError{};
+	double MaxTerraceError{};
+	for (int iSample = 0; iSample < 20'000; ++iSample)
+	{
+		const float KX{ iSample * 0.37f };
+		const float KZ{ iSample * 0.11f };
+		const float KInput{ EvaluateAt(Graph, 0, KX, KZ) };
+
+		float ExpectedCurve{};
+		if (KInput <= -0.5f) ExpectedCurve = -1.0f;
+		else if (KInput < 0.0f) ExpectedCurve = -1.0f + 1.2f * (KInput + 0.5f) / 0.5f;
+		else if (KInput < 0.6f) ExpectedCurve = 0.4f + 0.6f * KInput / 0.6f;
+		else ExpectedCurve = 1.0f;
+		MaxCurveError = max(MaxCurveError, static_cast<double>(fabsf(EvaluateAt(Graph, 1, KX, KZ) - ExpectedCurve)));
+
+		// Smoothstep ramps over the last (1 - sharpness) of each step
+		const float KSteps{ (KInput * 0.5f + 0.5f) * 5 };
+		const float KStep{ floorf(KSteps) };
+		float Ramp{ min(max((KSteps - KStep - 0.4f) / 0.6f, 0.0f), 1.0f) };
+		Ramp = Ramp * Ramp * (3 - 2 * Ramp);
+		const float KExpectedTerrace{ (KStep + Ramp) / 5 * 2 - 1 };
+		MaxTerraceError = max(MaxTerraceError, static_cast<double>(fabsf(EvaluateAt(Graph, 2, KX, KZ) - KExpectedTerrace)));
+	}
+	CHECK(MaxCurveError <= 1e-5);
+	CHECK(MaxTerraceError <= 1e-5);
+}
+
+TEST_CASE(TerrainGenerator_ValidatesGraphs)
+{
+	CTerrainGenerator::SGraph Graph{};
+	Graph.vNodes.resize(2);
+	Graph.vNodes[1].eType = ENodeType::Add;
+	Graph.vNodes[1].Inputs[0] = 0;
+	CHECK(!CTerrainGenerator::IsValid(Graph)); // Missing input
+
+	Graph.vNodes[1].Inputs[1] = 1;
+	CHECK(!CTerrainGenerator::IsValid(Graph)); // Its own input
+
+	Graph.vNodes[1].Inputs[1] = 0;
+	CHECK(CTerrainGenerator::IsValid(Graph));
+	CHECK(CTerrainGenerator::IsValid(CTerrainGenerator::GetDefaultGraph(1)));
+	CHECK(!CTerrainGenerator::IsValid(CTerrainGenerator::SGraph{}));
+
+	CTerrainGenerator::SDesc Desc{};
+	Desc.Graph.vNodes.resize(1);
+	Desc.Graph.vNodes[0].eType = ENodeType::Add;
+	vector<SPixel8UInt> vHeights{};
+	CHECK(!CTerrainGenerator::GenerateHeights(Desc, 16, 16, vHeights));
+}
+
+TEST_CASE(TerrainGenerator_DeterministicAcrossThreadCounts)
+{
+	constexpr uint32_t KWidth{ 513 };
+	constexpr uint32_t KHeight{ 385 };
+	CTerrainGenerator::SDesc Desc{};
+	Desc.Graph = CTerrainGenerator::GetDefaultGraph(42);
+
+	vector<SPixel8UInt> vHeights[3]{};
+	const uint32_t KThreadCounts[3]{ 1, 7, 0 };
+	CTerrainGenerator::SStats Stats{};
+	for (int iRun = 0; iRun < 3; ++iRun)
+	{
+		Desc.ThreadCount = KThreadCounts[iRun];
+		CHECK(CTerrainGenerator::GenerateHeights(Desc, KWidth, KHeight, vHeights[iRun], &Stats));
+	}
+	CHECK(Stats.TexelCount == KWidth * KHeight);
+	CHECK(Stats.TileCount == 9 * 7);
+	CHECK(memcmp(vHeights[0].data(), vHeights[1].data(), vHeights[0].size()) == 0);
+	CHECK(memcmp(vHeights[0].data(), vHeights[2].data(), vHeights[0].size()) == 0);
+
+	// Not flat: the default graph spans a good part of the 8-bit range
+	uint8_t Min{ 255 };
+	uint8_t Max{};
+	for (const SPixel8UInt& Texel : vHeights[0])
+	{
+		Min = min(Min, Texel.R);
+		Max = max(Max, Texel.R);
+	}
+	printf("heights %u ~ %u\n", Min, Max);
+	CHECK(Max - Min > 64);
+
+	// Another seed gives another terrain
+	Desc.Graph.Seed = 43;
+	vector<SPixel8UInt> vOtherSeed{};
+	CTerrainGenerator::GenerateHeights(Desc, KWidth, KHeight, vOtherSeed);
+	size_t DifferentCount{};
+	for (size_t iTexel = 0; iTexel < vOtherSeed.size(); ++iTexel)
+	{
+		if (vOtherSeed[iTexel].R != vHeights[0][iTexel].R) ++DifferentCount;
+	}
+	CHECK(DifferentCount > vOtherSeed.size() / 2);
+}
+
+TEST_CASE(TerrainGenerator_MaskingFollowsRules)
+{
+	constexpr uint32_t KSize{ 257 };
+	CTerrainGenerator::SDesc Desc{};
+	Desc.Graph = CTerrainGenerator::GetDefaultGraph(42);
+	vector<SPixel8UInt> vHeights{};
+	CTerrainGenerator::GenerateHeights(Desc, KSize, KSize, vHeights);
+
+	CTerrainSampler::SSource Source{};
+	Source.TerrainSize = XMFLOAT2(KSize - 1.0f, KSize - 1.0f);
+	Source.HeightRange = 10.0f;
+	Source.PtrHeights = vHeights.data();
+	Source.HeightMapWidth = KSize;
+	Source.HeightMapHeight = KSize;
+
+	// Hard-edged rules: layer 0 on high ground, layer 1 on slopes
+	CTerrainGenerator::SMaskingRule HighRule{};
+	HighRule.Layer = 0;
+	HighRule.HeightRange = XMFLOAT2(0.7f, 1.0f);
+	HighRule.Falloff = 0.0f;
+	CTerrainGenerator::SMaskingRule SlopeRule{};
+	SlopeRule.Layer = 1;
+	SlopeRule.SlopeRange = XMFLOAT2(0.02f, 1.0f);
+	SlopeRule.Falloff = 0.0f;
+	Desc.vMaskingRules = { HighRule, SlopeRule };
+
+	constexpr float KMaskingDetail{ 2.0f };
+	constexpr uint32_t KMaskingSize{ (KSize - 1) * 2 };
+	CSparseMasking Masking[2]{};
+	for (int iRun = 0; iRun < 2; ++iRun)
+	{
+		Masking[iRun].Create(KMaskingSize, KMaskingSize);
+		Desc.ThreadCount = (iRun == 0) ? 1 : 5;
+		CTerrainGenerator::GenerateMasking(Desc, Source, KMaskingDetail, Masking[iRun]);
+	}
+
+	size_t ThreadMismatchCount{};
+	size_t RuleMismatchCount{};
+	size_t CoveredCount[2]{};
+	for (uint32_t V = 0; V < KMaskingSize; ++V)
+	{
+		for (uint32_t U = 0; U < KMaskingSize; ++U)
+		{
+			const SPixel32UInt KTexel{ Masking[0].GetTexel(U, V) };
+			const SPixel32UInt KOtherTexel{ Masking[1].GetTexel(U, V) };
+			if (memcmp(&KTexel, &KOtherTexel, sizeof(KTexel)) != 0) ++ThreadMismatchCount;
+			if (KTexel.R) ++CoveredCount[0];
+			if (KTexel.G) ++CoveredCount[1];
+
+			// Rules against the sampled surface at the texel's center (ignoring texels right at a range's edge)
+			const XMFLOAT2 KPosition{ (U + 0.5f) / KMaskingDetail - Source.TerrainSize.x / 2, Source.TerrainSize.y / 2 - (V + 0.5f) / KMaskingDetail };
+			float Height{};
+			XMFLOAT3 Normal{};
+			CTerrainSampler::Sample(Source, &KPosition, 1, &Height, &Normal);
+			const float KNormalizedHeight{ (Height + Source.HeightRange / 2) / Source.HeightRange };
+			const bool KbIsHigh{ KNormalizedHeight >= 0.7f };
+			const bool KbIsSloped{ 1.0f - Normal.y >= 0.02f };
+			if (fabsf(KNormalizedHeight - 0.7f) > 1e-4f && (KTexel.R == 255) != KbIsHigh) ++RuleMismatchCount;
+			if (fabsf(1.0f - Normal.y - 0.02f) > 1e-4f && (KTexel.G == 255) != KbIsSloped) ++RuleMismatchCount;
+		}
+	}
+	printf("%zu / %zu texels high, %zu sloped\n", CoveredCount[0], static_cast<size_t>(KMaskingSize) * KMaskingSize, CoveredCount[1]);
+	CHECK(ThreadMismatchCount == 0);
+	CHECK(RuleMismatchCount == 0);
+	CHECK(CoveredCount[0] > 0 && CoveredCount[1] > 0);
+
+	// Only tiles with non-zero weights are allocated
+	CHECK(Masking[0].GetStats().AllocatedTileCount <= Masking[0].GetStats().TileCount);
+}
+
+// 4096 x 4096 height maps from single noise nodes and from the default graph
+BENCH_CASE(TerrainGenerator_MegaTexelsPerSecond)
+{
+	constexpr uint32_t KSize{ 4096 };
+	const char* const KNames[4]{ "perlin fBm, 6 octaves", "simplex fBm, 6 octaves", "ridged, 6 octaves", "default graph (warped)" };
+	for (int iGraph = 0; iGraph < 4; ++iGraph)
+	{
+		CTerrainGenerator::SDesc Desc{};
+		if (iGraph == 3)
+		{
+			Desc.Graph = CTerrainGenerator::GetDefaultGraph(7);
+		}
+		else
+		{
+			Desc.Graph.vNodes.emplace_back();
+			Desc.Graph.vNodes[0].eType = (iGraph == 0) ? ENodeType::PerlinFBm : (iGraph == 1) ? ENodeType::SimplexFBm : ENodeType::Ridged;
+		}
+
+		vector<SPixel8UInt> vHeights{};
+		CTerrainGenerator::SStats Stats{};
+		CTestTimer Timer{};
+		CTerrainGenerator::GenerateHeights(Desc, KSize, KSize, vHeights, &Stats);
+		const double KSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+		printf("%u x %u %-24s (%zu nodes, %zu tiles): %.2f s, %.1f M texels/s\n", KSize, KSize, KNames[iGraph], Desc.Graph.vNodes.size(),
+			Stats.TileCount, KSeconds, Stats.TexelCount / KSeconds / 1e6);
+	}
+}
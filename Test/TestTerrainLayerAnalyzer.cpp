@@ -0,0 +1,294 @@
+#include "Test.h"
+#include "Core/TerrainLayerAnalyzer.h"
+#include <random>
+
+static uint8_t AnalyzeRectReference(const vector<SPixel32UInt>& vPixels, uint32_t Width, const CMipGenerator::SRect& Rect)
+{
+	uint8_t LayerMask{};
+	for (uint32_t V = Rect.Top; V < Rect.Bottom; ++V)
+	{
+		for (uint32_t U = Rect.Left; U < Rect.Right; ++U)
+		{
+			const SPixel32UInt& KPixel{ vPixels[static_cast<size_t>(V) * Width + U] };
+			if (KPixel.R) LayerMask |= 0x01;
+			if (KPixel.G) LayerMask |= 0x02;
+			if (KPixel.B) LayerMask |= 0x04;
+			if (KPixel.A) LayerMask |= 0x08;
+		}
+	}
+	return LayerMask;
+}
+
+static uint8_t AnalyzeTileReference(const vector<SPixel32UInt>& vPixels, uint32_t Width, uint32_t Height, uint32_t TileSize, uint32_t Margin,
+	uint32_t TileX, uint32_t TileY)
+{
+	CMipGenerator::SRect Rect{};
+	Rect.Left = (TileX * TileSize > Margin) ? TileX * TileSize - Margin : 0;
+	Rect.Top = (TileY * TileSize > Margin) ? TileY * TileSize - Margin : 0;
+	Rect.Right = min((TileX + 1) * TileSize + Margin, Width);
+	Rect.Bottom = min((TileY + 1) * TileSize + Margin, Height);
+	return AnalyzeRectReference(vPixels, Width, Rect);
+}
+
+// Paints one channel of a disc into both the dense reference and the sparse masking (as CTerrain::UpdateMasking() would)
+static CMipGenerator::SRect PaintDisc(vector<SPixel32UInt>& vPixels, CSparseMasking& Masking, int CenterU, int CenterV, int Radius, int Channel,
+	uint8_t Value)
+{
+	const int KWidth{ static_cast<int>(Masking.GetWidth()) };
+	const int KHeight{ static_cast<int>(Masking.GetHeight()) };
+	CMipGenerator::SRect Rect{};
+	Rect.Left = static_cast<uint32_t>(min(max(CenterU - Radius, 0), KWidth));
+	Rect.Top = static_cast<uint32_t>(min(max(CenterV - Radius, 0), KHeight));
+	Rect.Right = static_cast<uint32_t>(min(max(CenterU + Radius + 1, 0), KWidth));
+	Rect.Bottom = static_cast<uint32_t>(min(max(CenterV + Radius + 1, 0), KHeight));
+	for (uint32_t V = Rect.Top; V < Rect.Bottom; ++V)
+	{
+		for (uint32_t U = Rect.Left; U < Rect.Right; ++U)
+		{
+			const int KDU{ static_cast<int>(U) - CenterU };
+			const int KDV{ static_cast<int>(V) - CenterV };
+			if (KDU * KDU + KDV * KDV > Radius * Radius) continue;
+
+			(&vPixels[static_cast<size_t>(V) * KWidth + U].R)[Channel] = Value;
+			SPixel32UInt* const PtrTexel{ (Value) ? Masking.GetTexelForWrite(U, V) : Masking.FindTexel(U, V) };
+			if (PtrTexel) (&PtrTexel->R)[Channel] = Value;
+		}
+	}
+	Masking.ReleaseZeroTiles(Rect);
+	return Rect;
+}
+
+TEST_CASE(TerrainLayerAnalyzer_AnalyzeRectMatchesScalar)
+{
+	// Odd sizes, so that rects have 4-wide parts and tails
+	std::mt19937 Random{ 42 };
+	constexpr uint32_t KWidth{ 37 };
+	constexpr uint32_t KHeight{ 23 };
+	vector<SPixel32UInt> vPixels(KWidth * KHeight);
+	size_t MismatchCount{};
+	for (int iRect = 0; iRect < 2'000; ++iRect)
+	{
+		std::fill(vPixels.begin(), vPixels.end(), SPixel32UInt());
+		const int KPaintedCount{ static_cast<int>(Random() % 4) };
+		for (int iPainted = 0; iPainted < KPaintedCount; ++iPainted)
+		{
+			(&vPixels[Random() % vPixels.size()].R)[Random() % 4] = static_cast<uint8_t>(1 + Random() % 255);
+		}
+
+		CMipGenerator::SRect Rect{};
+		Rect.Left = Random() % KWidth;
+		Rect.Right = Rect.Left + Random() % (KWidth - Rect.Left + 1);
+		Rect.Top = Random() % KHeight;
+		Rect.Bottom = Rect.Top + Random() % (KHeight - Rect.Top + 1);
+		if (CTerrainLayerAnalyzer::AnalyzeRect(vPixels.data(), KWidth, Rect) != AnalyzeRectReference(vPixels, KWidth, Rect)) ++MismatchCount;
+	}
+	CHECK(MismatchCount == 0);
+
+	CHECK(CTerrainLayerAnalyzer::CountLayers(0) == 0);
+	CHECK(CTerrainLayerAnalyzer::CountLayers(0x5) == 2);
+	CHECK(CTerrainLayerAnalyzer::CountLayers(CTerrainLayerAnalyzer::KLayerMaskAll) == 4);
+}
+
+TEST_CASE(TerrainLayerAnalyzer_IncrementalMatchesReference)
+{
+	// A 100 x 60 terrain at masking detail 8, with a margin that isn't a multiple of anything
+	constexpr uint32_t KWidth{ 800 };
+	constexpr uint32_t KHeight{ 480 };
+	constexpr uint32_t KTileSize{ 32 };
+	constexpr uint32_t KMargin{ 10 };
+	std::mt19937 Random{ 42 };
+	vector<SPixel32UInt> vPixels(KWidth * KHeight);
+	CSparseMasking Masking{};
+	Masking.Create(KWidth, KHeight);
+
+	CTerrainLayerAnalyzer Analyzer{};
+	Analyzer.Create(KWidth, KHeight, KTileSize, KMargin);
+	CHECK(Analyzer.GetTileCountX() == 25 && Analyzer.GetTileCountY() == 15 && Analyzer.GetTileCount() == 375);
+	Analyzer.Analyze(Masking);
+	CHECK(Analyzer.GetStats().AverageLayerCount == 1.0f);
+
+	size_t MismatchCount{};
+	size_t AverageMismatchCount{};
+	size_t AnalyzedTileSum{};
+	constexpr int KStrokeCount{ 400 };
+	for (int iStroke = 0; iStroke < KStrokeCount; ++iStroke)
+	{
+		// One in five strokes erases
+		const int KCenterU{ static_cast<int>(Random() % KWidth) };
+		const int KCenterV{ static_cast<int>(Random() % KHeight) };
+		const int KRadius{ 2 + static_cast<int>(Random() % 30) };
+		const int KChannel{ static_cast<int>(Random() % 4) };
+		const uint8_t KValue{ (Random() % 5) ? static_cast<uint8_t>(1 + Random() % 255) : static_cast<uint8_t>(0) };
+		Analyzer.Update(Masking, PaintDisc(vPixels, Masking, KCenterU, KCenterV, KRadius, KChannel, KValue));
+		AnalyzedTileSum += Analyzer.GetStats().AnalyzedTileCount;
+
+		if (iStroke % 50 == 0 || iStroke == KStrokeCount - 1)
+		{
+			size_t LayerSum{};
+			for (uint32_t TileY = 0; TileY < Analyzer.GetTileCountY(); ++TileY)
+			{
+				for (uint32_t TileX = 0; TileX < Analyzer.GetTileCountX(); ++TileX)
+				{
+					const uint8_t KLayerMask{ AnalyzeTileReference(vPixels, KWidth, KHeight, KTileSize, KMargin, TileX, TileY) };
+					if (Analyzer.GetTileLayerMask(static_cast<size_t>(TileY) * Analyzer.GetTileCountX() + TileX) != KLayerMask) ++MismatchCount;
+					LayerSum += CTerrainLayerAnalyzer::CountLayers(KLayerMask);
+				}
+			}
+			if (fabsf(Analyzer.GetStats().AverageLayerCount - (1.0f + static_cast<float>(LayerSum) / 375.0f)) > 1e-4f) ++AverageMismatchCount;
+		}
+	}
+	CHECK(MismatchCount == 0);
+	CHECK(AverageMismatchCount == 0);
+	printf("%d strokes re-analyzed %.1f of %zu tiles on average; %.2f layers per tile\n", KStrokeCount,
+		static_cast<double>(AnalyzedTileSum) / KStrokeCount, Analyzer.GetTileCount(), Analyzer.GetStats().AverageLayerCount);
+
+	// A full analysis agrees with the incremental one
+	CTerrainLayerAnalyzer Full{};
+	Full.Create(KWidth, KHeight, KTileSize, KMargin);
+	Full.Analyze(Masking);
+	size_t FullMismatchCount{};
+	for (size_t iTile = 0; iTile < Full.GetTileCount(); ++iTile)
+	{
+		if (Full.GetTileLayerMask(iTile) != Analyzer.GetTileLayerMask(iTile)) ++FullMismatchCount;
+	}
+	CHECK(FullMismatchCount == 0);
+
+	// Empty dirty rects change nothing
+	CHECK(!Analyzer.Update(Masking, CMipGenerator::SRect{ 5, 5, 5, 9 }));
+
+	// Positions are clamped to the texture
+	CHECK(Analyzer.GetTileIndex(-10.0f, -10.0f) == 0);
+	CHECK(Analyzer.GetTileIndex(1e6f, 1e6f) == Analyzer.GetTileCount() - 1);
+	CHECK(Analyzer.GetTileIndex(33.0f, 65.0f) == 2 * 25 + 1);
+}
+
+// Layers of the texels that bilinear filtering of mips 0 ~ (MipCount - 1) reads for samples in the tile and SampleMargin texels around it
+static uint8_t AnalyzeTileMipsReference(const vector<SPixel32UInt>& vPixels, const vector<CMipGenerator::SMipLevel<SPixel32UInt>>& vMipChain,
+	uint32_t Width, uint32_t Height, uint32_t TileSize, uint32_t SampleMargin, uint32_t MipCount, uint32_t TileX, uint32_t TileY)
+{
+	const float KLeft{ static_cast<float>(TileX * TileSize) - static_cast<float>(SampleMargin) };
+	const float KTop{ static_cast<float>(TileY * TileSize) - static_cast<float>(SampleMargin) };
+	const float KRight{ static_cast<float>((TileX + 1) * TileSize + SampleMargin) };
+	const float KBottom{ static_cast<float>((TileY + 1) * TileSize + SampleMargin) };
+
+	uint8_t LayerMask{};
+	for (uint32_t iMip = 0; iMip < MipCount; ++iMip)
+	{
+		const uint32_t KMipWidth{ (iMip) ? vMipChain[iMip - 1].Width : Width };
+		const uint32_t KMipHeight{ (iMip) ? vMipChain[iMip - 1].Height : Height };
+		const vector<SPixel32UInt>& KMipPixels{ (iMip) ? vMipChain[iMip - 1].vPixels : vPixels };
+
+		// Bilinear filtering reads the texels around (U - 0.5, V - 0.5) in the mip's texels
+		const float KScaleU{ static_cast<float>(KMipWidth) / static_cast<float>(Width) };
+		const float KScaleV{ static_cast<float>(KMipHeight) / static_cast<float>(Height) };
+		CMipGenerator::SRect Rect{};
+		Rect.Left = static_cast<uint32_t>(max(floorf(KLeft * KScaleU - 0.5f), 0.0f));
+		Rect.Top = static_cast<uint32_t>(max(floorf(KTop * KScaleV - 0.5f), 0.0f));
+		Rect.Right = min(static_cast<uint32_t>(max(floorf(KRight * KScaleU - 0.5f) + 2.0f, 0.0f)), KMipWidth);
+		Rect.Bottom = min(static_cast<uint32_t>(max(floorf(KBottom * KScaleV - 0.5f) + 2.0f, 0.0f)), KMipHeight);
+		LayerMask |= AnalyzeRectReference(KMipPixels, KMipWidth, Rect);
+	}
+	return LayerMask;
+}
+
+TEST_CASE(TerrainLayerAnalyzer_CoversCoarseMipFootprints)
+{
+	// Odd mip sizes (200, 100, 50, 25, 12) and small dots, whose weight only the coarse mips spread past the margin
+	constexpr uint32_t KSize{ 200 };
+	constexpr uint32_t KTileSize{ 32 };
+	constexpr uint32_t KMargin{ 3 };
+	constexpr uint32_t KMipCount{ 5 };
+	std::mt19937 Random{ 42 };
+	vector<SPixel32UInt> vPixels(KSize * KSize);
+	CSparseMasking Masking{};
+	Masking.Create(KSize, KSize);
+
+	CTerrainLayerAnalyzer Analyzer{};
+	Analyzer.Create(KSize, KSize, KTileSize, KMargin, KMipCount);
+	Analyzer.Analyze(Masking);
+	CTerrainLayerAnalyzer FineAnalyzer{};
+	FineAnalyzer.Create(KSize, KSize, KTileSize, KMargin);
+
+	size_t MissingCount{};
+	size_t FineMissingCount{};
+	size_t FullMismatchCount{};
+	for (int iStroke = 0; iStroke < 40; ++iStroke)
+	{
+		const int KCenterU{ static_cast<int>(Random() % KSize) };
+		const int KCenterV{ static_cast<int>(Random() % KSize) };
+		const int KChannel{ static_cast<int>(Random() % 4) };
+		Analyzer.Update(Masking, PaintDisc(vPixels, Masking, KCenterU, KCenterV, 1, KChannel, 255));
+		if (iStroke % 8 != 7) continue;
+
+		vector<CMipGenerator::SMipLevel<SPixel32UInt>> vMipChain{};
+		CMipGenerator::GenerateMipChain(vPixels.data(), KSize, KSize, CMipGenerator::SDesc(CMipGenerator::EFilter::Box), vMipChain);
+		FineAnalyzer.Analyze(Masking);
+		CTerrainLayerAnalyzer Full{};
+		Full.Create(KSize, KSize, KTileSize, KMargin, KMipCount);
+		Full.Analyze(Masking);
+		for (uint32_t TileY = 0; TileY < Analyzer.GetTileCountY(); ++TileY)
+		{
+			for (uint32_t TileX = 0; TileX < Analyzer.GetTileCountX(); ++TileX)
+			{
+				// The margin holds mip 0's bilinear footprint, so samples are up to KMargin - 1 texels away
+				const uint8_t KSampled{ AnalyzeTileMipsReference(vPixels, vMipChain, KSize, KSize, KTileSize, KMargin - 1, KMipCount, TileX, TileY) };
+				const size_t KTileIndex{ static_cast<size_t>(TileY) * Analyzer.GetTileCountX() + TileX };
+				if ((Analyzer.GetTileLayerMask(KTileIndex) & KSampled) != KSampled) ++MissingCount;
+				if ((FineAnalyzer.GetTileLayerMask(KTileIndex) & KSampled) != KSampled) ++FineMissingCount;
+				if (Full.GetTileLayerMask(KTileIndex) != Analyzer.GetTileLayerMask(KTileIndex)) ++FullMismatchCount;
+			}
+		}
+	}
+	CHECK(MissingCount == 0);
+	CHECK(FullMismatchCount == 0);
+	// Analyzing only mip 0 drops layers, which is what the coarse mips' footprint is for
+	CHECK(FineMissingCount > 0);
+}
+
+// A 2048 x 2048 masking (a 128 terrain at masking detail 16) with mostly one or two layers painted
+BENCH_CASE(TerrainLayerAnalyzer_AnalysisTime)
+{
+	constexpr uint32_t KSize{ 2048 };
+	constexpr uint32_t KMargin{ 18 };
+	std::mt19937 Random{ 42 };
+	vector<SPixel32UInt> vPixels(KSize * KSize);
+	CSparseMasking Masking{};
+	Masking.Create(KSize, KSize);
+	for (int iStroke = 0; iStroke < 200; ++iStroke)
+	{
+		const int KCenterU{ static_cast<int>(Random() % KSize) };
+		const int KCenterV{ static_cast<int>(Random() % KSize) };
+		PaintDisc(vPixels, Masking, KCenterU, KCenterV, 20 + static_cast<int>(Random() % 60), static_cast<int>(Random() % 2), 200);
+	}
+
+	CTerrainLayerAnalyzer Analyzer{};
+	Analyzer.Create(KSize, KSize, CTerrainLayerAnalyzer::KDefaultTileSize, KMargin);
+	double BestMilliseconds{ 1e9 };
+	for (int iRepeat = 0; iRepeat < 5; ++iRepeat)
+	{
+		CTestTimer Timer{};
+		Analyzer.Analyze(Masking);
+		BestMilliseconds = min(BestMilliseconds, Timer.GetElapsedMilliseconds());
+	}
+
+	double BestReferenceMilliseconds{ 1e9 };
+	size_t Sum{};
+	for (int iRepeat = 0; iRepeat < 3; ++iRepeat)
+	{
+		CTestTimer Timer{};
+		for (uint32_t TileY = 0; TileY < Analyzer.GetTileCountY(); ++TileY)
+		{
+			for (uint32_t TileX = 0; TileX < Analyzer.GetTileCountX(); ++TileX)
+			{
+				Sum += AnalyzeTileReference(vPixels, KSize, KSize, CTerrainLayerAnalyzer::KDefaultTileSize, KMargin, TileX, TileY);
+			}
+		}
+		BestReferenceMilliseconds = min(BestReferenceMilliseconds, Timer.GetElapsedMilliseconds());
+	}
+	printf("Full analysis of %zu tiles: %.2f ms (4-wide, sparse) vs %.2f ms (dense, texel by texel, %zu); %.2f layers sampled per tile\n",
+		Analyzer.GetTileCount(), BestMilliseconds, BestReferenceMilliseconds, Sum, Analyzer.GetStats().AverageLayerCount);
+
+	CTestTimer Timer{};
+	Analyzer.Update(Masking, PaintDisc(vPixels, Masking, 1000, 1000, 16, 2, 255));
+	printf("Brush update (radius 16): %zu tiles re-analyzed in %.3f ms\n", Analyzer.GetStats().AnalyzedTileCount, Timer.GetElapsedMilliseconds());
+}
@@ -0,0 +1,230 @@
+#include "Test.h"
+#include "Core/TerrainSampler.h"
+#include <random>
+
+// Random heights and masking texels, with the masking written through CSparseMasking
+struct STestTerrain
+{
+	vector<SPixel8UInt>			vHeights{};
+	vector<SPixel32UInt>		vMasking{};
+	CSparseMasking				Masking{};
+	CTerrainSampler::SSource	Source{};
+};
+
+static void CreateTerrain(uint32_t Size, float MaskingDetail, std::mt19937& Random, STestTerrain& OutTerrain)
+{
+	const uint32_t KHeightMapSize{ Size + 1 };
+	OutTerrain.vHeights.resize(static_cast<size_t>(KHeightMapSize) * KHeightMapSize);
+	for (SPixel8UInt& Texel : OutTerrain.vHeights) Texel.R = static_cast<uint8_t>(Random() % 256);
+
+	const uint32_t KMaskingSize{ static_cast<uint32_t>(Size * MaskingDetail) };
+	OutTerrain.vMasking.resize(static_cast<size_t>(KMaskingSize) * KMaskingSize);
+	for (SPixel32UInt& Texel : OutTerrain.vMasking)
+	{
+		Texel = SPixel32UInt{ static_cast<uint8_t>(Random() % 256), static_cast<uint8_t>(Random() % 256), static_cast<uint8_t>(Random() % 256),
+			static_cast<uint8_t>(Random() % 256) };
+	}
+	OutTerrain.Masking.Create(KMaskingSize, KMaskingSize);
+	OutTerrain.Masking.WriteRect(CMipGenerator::SRect{ 0, 0, KMaskingSize, KMaskingSize }, OutTerrain.vMasking.data(), KMaskingSize);
+
+	OutTerrain.Source.TerrainSize = XMFLOAT2(static_cast<float>(Size), static_cast<float>(Size));
+	OutTerrain.Source.HeightRange = 10.0f;
+	OutTerrain.Source.PtrHeights = OutTerrain.vHeights.data();
+	OutTerrain.Source.HeightMapWidth = KHeightMapSize;
+	OutTerrain.Source.HeightMapHeight = KHeightMapSize;
+	OutTerrain.Source.PtrMasking = &OutTerrain.Masking;
+	OutTerrain.Source.MaskingDetail = MaskingDetail;
+}
+
+// One point at a time, straight from the plain arrays
+static void SampleReference(const STestTerrain& Terrain, const XMFLOAT2& PositionXZ, float& OutHeight, XMFLOAT3& OutNormal,
+	XMFLOAT4& OutLayerWeights)
+{
+	const CTerrainSampler::SSource& KSource{ Terrain.Source };
+	const float KU{ min(max(PositionXZ.x + KSource.TerrainSize.x / 2, 0.0f), static_cast<float>(KSource.HeightMapWidth - 1)) };
+	const float KV{ min(max(KSource.TerrainSize.y / 2 - PositionXZ.y, 0.0f), static_cast<float>(KSource.HeightMapHeight - 1)) };
+	const int KCellU{ min(static_cast<int>(KU), static_cast<int>(KSource.HeightMapWidth) - 2) };
+	const int KCellV{ min(static_cast<int>(KV), static_cast<int>(KSource.HeightMapHeight) - 2) };
+	const float KS{ KU - KCellU };
+	const float KR{ KV - KCellV };
+	auto GetHeight{ [&](int U, int V) { return static_cast<float>(Terrain.vHeights[static_cast<size_t>(V) * KSource.HeightMapWidth + U].R); } };
+
+	const float KWorldPerStep{ KSource.HeightRange / 255.0f };
+	const float KHeight{ GetHeight(KCellU, KCellV) * (1 - KS) * (1 - KR) + GetHeight(KCellU + 1, KCellV) * KS * (1 - KR) +
+		GetHeight(KCellU, KCellV + 1) * (1 - KS) * KR + GetHeight(KCellU + 1, KCellV + 1) * KS * KR };
+	OutHeight = KHeight * KWorldPerStep - KSource.HeightRange / 2;
+
+	const float KDerivativeS{ (GetHeight(KCellU + 1, KCellV) - GetHeight(KCellU, KCellV)) * (1 - KR) +
+		(GetHeight(KCellU + 1, KCellV + 1) - GetHeight(KCellU, KCellV + 1)) * KR };
+	const float KDerivativeR{ (GetHeight(KCellU, KCellV + 1) - GetHeight(KCellU, KCellV)) * (1 - KS) +
+		(GetHeight(KCellU + 1, KCellV + 1) - GetHeight(KCellU + 1, KCellV)) * KS };
+	const float KNormalX{ -KDerivativeS * KWorldPerStep };
+	const float KNormalZ{ KDerivativeR * KWorldPerStep };
+	const float KLength{ sqrtf(KNormalX * KNormalX + 1 + KNormalZ * KNormalZ) };
+	OutNormal = XMFLOAT3(KNormalX / KLength, 1 / KLength, KNormalZ / KLength);
+
+	const uint32_t KMaskingSize{ Terrain.Masking.GetWidth() };
+	const float KMaskingU{ min(max((PositionXZ.x + KSource.TerrainSize.x / 2) * KSource.MaskingDetail - 0.5f, 0.0f), static_cast<float>(KMaskingSize - 1)) };
+	const float KMaskingV{ min(max((KSource.TerrainSize.y / 2 - PositionXZ.y) * KSource.MaskingDetail - 0.5f, 0.0f), static_cast<float>(KMaskingSize - 1)) };
+	const int KMaskingCellU{ min(static_cast<int>(KMaskingU), static_cast<int>(KMaskingSize) - 2) };
+	const int KMaskingCellV{ min(static_cast<int>(KMaskingV), static_cast<int>(KMaskingSize) - 2) };
+	const float KMaskingS{ KMaskingU - KMaskingCellU };
+	const float KMaskingR{ KMaskingV - KMaskingCellV };
+	float Weights[4]{};
+	for (int iChannel = 0; iChannel < 4; ++iChannel)
+	{
+		auto GetWeight{ [&](int U, int V)
+			{
+				return static_cast<float>((&Terrain.vMasking[static_cast<size_t>(V) * KMaskingSize + U].R)[iChannel]);
+			} };
+		Weights[iChannel] = (GetWeight(KMaskingCellU, KMaskingCellV) * (1 - KMaskingS) * (1 - KMaskingR) +
+			GetWeight(KMaskingCellU + 1, KMaskingCellV) * KMaskingS * (1 - KMaskingR) +
+			GetWeight(KMaskingCellU, KMaskingCellV + 1) * (1 - KMaskingS) * KMaskingR +
+			GetWeight(KMaskingCellU + 1, KMaskingCellV + 1) * KMaskingS * KMaskingR) / 255.0f;
+	}
+	OutLayerWeights = XMFLOAT4(Weights[0], Weights[1], Weights[2], Weights[3]);
+}
+
+static float GetRandomUnit(std::mt19937& Random)
+{
+	return static_cast<float>(Random() % 1'000'000) / 1'000'000.0f;
+}
+
+TEST_CASE(TerrainSampler_MatchesScalarReference)
+{
+	std::mt19937 Random{ 45 };
+	double MaxHeightError{};
+	double MaxNormalError{};
+	double MaxWeightError{};
+	for (uint32_t Size : { 2u, 10u, 63u, 256u })
+	{
+		// Counts that leave 0 ~ 3 points for the padded last group
+		for (size_t Count : { 1u, 3u, 7u, 1000u, 5001u })
+		{
+			STestTerrain Terrain{};
+			CreateTerrain(Size, (Size < 10) ? 1.0f : 8.0f, Random, Terrain);
+
+			// Including positions outside the terrain, which are clamped to its edge
+			vector<XMFLOAT2> vPositions(Count);
+			for (XMFLOAT2& Position : vPositions)
+			{
+				Position = XMFLOAT2((GetRandomUnit(Random) * 1.2f - 0.6f) * Size, (GetRandomUnit(Random) * 1.2f - 0.6f) * Size);
+			}
+			vector<float> vHeights(Count);
+			vector<XMFLOAT3> vNormals(Count);
+			vector<XMFLOAT4> vLayerWeights(Count);
+			CTerrainSampler::Sample(Terrain.Source, vPositions.data(), Count, vHeights.data(), vNormals.data(), vLayerWeights.data());
+
+			for (size_t iPoint = 0; iPoint < Count; ++iPoint)
+			{
+				float Height{};
+				XMFLOAT3 Normal{};
+				XMFLOAT4 Weights{};
+				SampleReference(Terrain, vPositions[iPoint], Height, Normal, Weights);
+				MaxHeightError = max(MaxHeightError, static_cast<double>(fabsf(Height - vHeights[iPoint])));
+				MaxNormalError = max(MaxNormalError, static_cast<double>(max(max(fabsf(Normal.x - vNormals[iPoint].x), fabsf(Normal.y - vNormals[iPoint].y)),
+					fabsf(Normal.z - vNormals[iPoint].z))));
+				MaxWeightError = max(MaxWeightError, static_cast<double>(max(max(fabsf(Weights.x - vLayerWeights[iPoint].x),
+					fabsf(Weights.y - vLayerWeights[iPoint].y)), max(fabsf(Weights.z - vLayerWeights[iPoint].z), fabsf(Weights.w - vLayerWeights[iPoint].w)))));
+			}
+		}
+	}
+	printf("max errors: height %g, normal %g, layer weights %g\n", MaxHeightError, MaxNormalError, MaxWeightError);
+	CHECK(MaxHeightError <= 1e-4);
+	CHECK(MaxNormalError <= 1e-5);
+	CHECK(MaxWeightError <= 1e-5);
+}
+
+TEST_CASE(TerrainSampler_OptionalOutputsAndMasking)
+{
+	std::mt19937 Random{ 2 };
+	STestTerrain Terrain{};
+	CreateTerrain(32, 2.0f, Random, Terrain);
+	const XMFLOAT2 KPositions[5]{ { 0.0f, 0.0f }, { 3.3f, -7.1f }, { -16.0f, 16.0f }, { 100.0f, -100.0f }, { 15.9f, 0.2f } };
+
+	float Heights[5]{};
+	XMFLOAT3 Normals[5]{};
+	XMFLOAT4 LayerWeights[5]{};
+	CTerrainSampler::Sample(Terrain.Source, KPositions, 5, Heights, Normals, LayerWeights);
+
+	// Each output alone gives the same values
+	float HeightsOnly[5]{};
+	XMFLOAT3 NormalsOnly[5]{};
+	CTerrainSampler::Sample(Terrain.Source, KPositions, 5, HeightsOnly);
+	CTerrainSampler::Sample(Terrain.Source, KPositions, 5, nullptr, NormalsOnly);
+	for (int iPoint = 0; iPoint < 5; ++iPoint)
+	{
+		CHECK(HeightsOnly[iPoint] == Heights[iPoint]);
+		CHECK(NormalsOnly[iPoint].y == Normals[iPoint].y);
+		CHECK(Normals[iPoint].y > 0.0f);
+		CHECK(Heights[iPoint] >= -5.0f && Heights[iPoint] <= 5.0f);
+	}
+
+	// Without masking the layer weights are 0
+	CTerrainSampler::SSource Source{ Terrain.Source };
+	Source.PtrMasking = nullptr;
+	CTerrainSampler::Sample(Source, KPositions, 5, nullptr, nullptr, LayerWeights);
+	for (const XMFLOAT4& Weights : LayerWeights)
+	{
+		CHECK(Weights.x == 0.0f && Weights.y == 0.0f && Weights.z == 0.0f && Weights.w == 0.0f);
+	}
+
+	// A flat terrain at the middle of its range is at 0 with straight-up normals
+	vector<SPixel8UInt> vFlat(33 * 33, SPixel8UInt{ 128 });
+	Source.PtrHeights = vFlat.data();
+	CTerrainSampler::Sample(Source, KPositions, 5, Heights, Normals);
+	for (int iPoint = 0; iPoint < 5; ++iPoint)
+	{
+		CHECK_NEAR(Heights[iPoint], 10.0f * 128 / 255 - 5.0f, 1e-5);
+		CHECK(Normals[iPoint].x == 0.0f && Normals[iPoint].y == 1.0f && Normals[iPoint].z == 0.0f);
+	}
+}
+
+// 1M points spread over the whole terrain and clustered (as instances placed in patches are)
+BENCH_CASE(TerrainSampler_PointsPerSecond)
+{
+	std::mt19937 Random{ 1 };
+	for (uint32_t Size : { 1024u, 2048u })
+	{
+		STestTerrain Terrain{};
+		CreateTerrain(Size, 4.0f, Random, Terrain);
+		constexpr size_t KCount{ 1 << 20 };
+		for (bool bIsClustered : { false, true })
+		{
+			vector<XMFLOAT2> vPositions(KCount);
+			for (size_t iPoint = 0; iPoint < KCount; ++iPoint)
+			{
+				if (bIsClustered)
+				{
+					const float KClusterX{ static_cast<float>((iPoint / 4096) % 32) / 32.0f };
+					const float KClusterZ{ static_cast<float>((iPoint / 4096) / 32) / 8.0f };
+					vPositions[iPoint] = XMFLOAT2((KClusterX + GetRandomUnit(Random) / 32 - 0.5f) * Size, (KClusterZ + GetRandomUnit(Random) / 8 - 0.5f) * Size);
+				}
+				else
+				{
+					vPositions[iPoint] = XMFLOAT2((GetRandomUnit(Random) - 0.5f) * Size, (GetRandomUnit(Random) - 0.5f) * Size);
+				}
+			}
+			vector<float> vHeights(KCount);
+			vector<XMFLOAT3> vNormals(KCount);
+			vector<XMFLOAT4> vLayerWeights(KCount);
+
+			CTestTimer Timer{};
+			CTerrainSampler::Sample(Terrain.Source, vPositions.data(), KCount, vHeights.data());
+			const double KHeightSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+			Timer = CTestTimer();
+			CTerrainSampler::Sample(Terrain.Source, vPositions.data(), KCount, vHeights.data(), vNormals.data(), vLayerWeights.data());
+			const double KAllSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+			Timer = CTestTimer();
+			for (size_t iPoint = 0; iPoint < KCount; ++iPoint)
+			{
+				SampleReference(Terrain, vPositions[iPoint], vHeights[iPoint], vNormals[iPoint], vLayerWeights[iPoint]);
+			}
+			const double KReferenceSeconds{ Timer.GetElapsedMilliseconds() / 1000.0 };
+
+			printf("%u x %u %-9s: height %.1f M points/s, height + normal + weights %.1f M points/s, scalar reference %.1f M points/s\n",
+				Size, Size, (bIsClustered) ? "clustered" : "random", KCount / KHeightSeconds / 1e6, KCount / KAllSeconds / 1e6,
+				KCount / KReferenceSeconds / 1e6);
+		}
+	}
+}
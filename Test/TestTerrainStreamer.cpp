@@ -0,0 +1,194 @@
+#include "Test.h"
+#include "Core/TerrainStreamer.h"
+
+// Keeps the tiles in memory (ReadTile() and WriteTile() are called from the streamer's threads)
+class CTerrainTileMemoryStore final : public CTerrainTileStore
+{
+public:
+	bool ReadTile(const STerrainTileCoord& Coord, STerrainTileData& OutData) override
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		auto Found{ m_umapTiles.find(Coord.GetKey()) };
+		if (Found == m_umapTiles.end()) return false;
+
+		OutData = Found->second;
+		return true;
+	}
+
+	bool WriteTile(const STerrainTileCoord& Coord, const STerrainTileData& Data) override
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		m_umapTiles[Coord.GetKey()] = Data;
+		++m_WriteCount;
+		return true;
+	}
+
+	size_t GetWriteCount()
+	{
+		std::lock_guard<std::mutex> Lock{ m_Mutex };
+		return m_WriteCount;
+	}
+
+private:
+	std::mutex								m_Mutex{};
+	unordered_map<uint64_t, STerrainTileData>	m_umapTiles{};
+	size_t									m_WriteCount{};
+};
+
+// Small tiles; with the camera at a tile's center, only that tile is closer than LoadRadius
+static CTerrainStreamer::SDesc GetSingleTileDesc()
+{
+	CTerrainStreamer::SDesc Desc{};
+	Desc.TileSize = 16.0f;
+	Desc.HeightMapSize = 8;
+	Desc.MaskingSize = 8;
+	Desc.GrassDensitySize = 4;
+	Desc.LoadRadius = 4.0f;
+	Desc.UnloadRadius = 6.0f;
+	Desc.ThreadCount = 2;
+	return Desc;
+}
+
+static XMFLOAT2 GetTileCenter(const CTerrainStreamer::SDesc& Desc, int32_t X, int32_t Z)
+{
+	return XMFLOAT2((X + 0.5f) * Desc.TileSize, (Z + 0.5f) * Desc.TileSize);
+}
+
+// Updates until every tile that the camera requires is resident
+static void UpdateUntilLoaded(CTerrainStreamer& Streamer, const XMFLOAT2& CameraPositionXZ, vector<CTerrainStreamer::SEvent>& vOutEvents)
+{
+	Streamer.Update(CameraPositionXZ, vOutEvents);
+	while (Streamer.GetStats().LoadingTileCount)
+	{
+		Streamer.Flush();
+		Streamer.Update(CameraPositionXZ, vOutEvents);
+	}
+}
+
+static size_t CountEvents(const vector<CTerrainStreamer::SEvent>& vEvents, CTerrainStreamer::EEventType eType)
+{
+	size_t Count{};
+	for (const CTerrainStreamer::SEvent& Event : vEvents)
+	{
+		if (Event.eType == eType) ++Count;
+	}
+	return Count;
+}
+
+TEST_CASE(TerrainStreamer_LoadsTilesAroundCamera)
+{
+	CTerrainStreamer::SDesc Desc{ GetSingleTileDesc() };
+	Desc.LoadRadius = 10.0f;
+	Desc.UnloadRadius = 14.0f;
+
+	// The store has (1, 0) only, the rest are created flat
+	CTerrainTileMemoryStore Store{};
+	{
+		CTerrainStreamer Creator{ &Store, Desc };
+		STerrainTileData Data{};
+		Creator.CreateFlatTile(Data);
+		for (auto& Height : Data.vHeights) Height.R = 200;
+		Store.WriteTile(STerrainTileCoord(1, 0), Data);
+	}
+
+	CTerrainStreamer Streamer{ &Store, Desc };
+	vector<CTerrainStreamer::SEvent> vEvents{};
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 0, 0), vEvents);
+
+	// The tile and its 4 edge neighbours are 8 units away at most, the diagonal ones 11.3
+	const CTerrainStreamer::SStats& KStats{ Streamer.GetStats() };
+	CHECK(CountEvents(vEvents, CTerrainStreamer::EEventType::Loaded) == 5);
+	CHECK(CountEvents(vEvents, CTerrainStreamer::EEventType::Evicted) == 0);
+	CHECK(KStats.ResidentTileCount == 5 && KStats.RequiredTileCount == 5);
+	CHECK(KStats.LoadedTileCount == 5 && KStats.CreatedTileCount == 4);
+	CHECK(Streamer.FindTile(STerrainTileCoord(0, 0)) && Streamer.FindTile(STerrainTileCoord(0, -1)));
+	CHECK(!Streamer.FindTile(STerrainTileCoord(1, 1)));
+
+	// The inner texels of the stored tile are its own (its shared ones may be stitched to the flat neighbours)
+	const STerrainTileData* const PtrStoredTile{ Streamer.FindTile(STerrainTileCoord(1, 0)) };
+	CHECK(PtrStoredTile && PtrStoredTile->vHeights[4 * 9 + 4].R == 200);
+	CHECK(Streamer.FindTile(STerrainTileCoord(0, 0))->vHeights[4 * 9 + 4].R == 127);
+
+	// Within the budget nothing is evicted, even far away; the tiles are cached
+	vEvents.clear();
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 10, 0), vEvents);
+	CHECK(CountEvents(vEvents, CTerrainStreamer::EEventType::Evicted) == 0);
+	CHECK(Streamer.GetStats().ResidentTileCount == 10 && Streamer.GetStats().RequiredTileCount == 5);
+}
+
+TEST_CASE(TerrainStreamer_EvictsLeastRecentlyUsed)
+{
+	CTerrainStreamer::SDesc Desc{ GetSingleTileDesc() };
+	CTerrainTileMemoryStore Store{};
+	size_t TileByteSize{};
+	{
+		STerrainTileData Data{};
+		CTerrainStreamer{ &Store, Desc }.CreateFlatTile(Data);
+		TileByteSize = Data.GetByteSize();
+	}
+	Desc.ResidentByteBudget = 3 * TileByteSize;
+
+	CTerrainStreamer Streamer{ &Store, Desc };
+	vector<CTerrainStreamer::SEvent> vEvents{};
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 0, 0), vEvents);
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 1, 0), vEvents);
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 2, 0), vEvents);
+	CHECK(Streamer.GetStats().ResidentTileCount == 3 && Streamer.GetStats().RequiredTileCount == 1);
+	CHECK(CountEvents(vEvents, CTerrainStreamer::EEventType::Evicted) == 0);
+
+	// Going back to (0, 0) hits the cache and makes it the most recently used
+	vEvents.clear();
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 0, 0), vEvents);
+	CHECK(vEvents.empty());
+	CHECK(Streamer.GetStats().CacheHitCount == 1 && Streamer.GetStats().LoadedTileCount == 3);
+
+	// So (1, 0) and then (2, 0) are evicted, although (0, 0) was loaded first
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 3, 0), vEvents);
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 4, 0), vEvents);
+	vector<STerrainTileCoord> vEvicted{};
+	for (const CTerrainStreamer::SEvent& Event : vEvents)
+	{
+		if (Event.eType == CTerrainStreamer::EEventType::Evicted) vEvicted.emplace_back(Event.Coord);
+	}
+	CHECK(vEvicted.size() == 2 && vEvicted[0] == STerrainTileCoord(1, 0) && vEvicted[1] == STerrainTileCoord(2, 0));
+	CHECK(Streamer.FindTile(STerrainTileCoord(0, 0)) && Streamer.FindTile(STerrainTileCoord(3, 0)));
+	CHECK(Streamer.GetStats().ResidentBytes <= Desc.ResidentByteBudget && Streamer.GetStats().EvictedTileCount == 2);
+}
+
+TEST_CASE(TerrainStreamer_SavesEditedTilesOnEviction)
+{
+	CTerrainStreamer::SDesc Desc{ GetSingleTileDesc() };
+	Desc.ResidentByteBudget = 0; // Only the required tile stays
+	CTerrainTileMemoryStore Store{};
+	CTerrainStreamer Streamer{ &Store, Desc };
+	vector<CTerrainStreamer::SEvent> vEvents{};
+
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 0, 0), vEvents);
+	STerrainTileData* const PtrTile{ Streamer.FindTileForEdit(STerrainTileCoord(0, 0)) };
+	CHECK(PtrTile);
+	if (!PtrTile) return;
+
+	// An inner texel, so no neighbour is stitched
+	PtrTile->vHeights[4 * 9 + 4].R = 42;
+	CMipGenerator::SRect Rect{};
+	Rect.Left = 4;
+	Rect.Top = 4;
+	Rect.Right = 5;
+	Rect.Bottom = 5;
+	Streamer.MarkEdited(STerrainTileCoord(0, 0), Rect);
+
+	// Evicted before its save delay is over, so the eviction saves it
+	vEvents.clear();
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 5, 0), vEvents);
+	CHECK(CountEvents(vEvents, CTerrainStreamer::EEventType::Evicted) == 1);
+	CHECK(!Streamer.FindTile(STerrainTileCoord(0, 0)));
+	Streamer.Flush();
+	CHECK(Store.GetWriteCount() == 1);
+
+	// Read back from the store, not created again
+	const size_t KCreatedTileCount{ Streamer.GetStats().CreatedTileCount };
+	UpdateUntilLoaded(Streamer, GetTileCenter(Desc, 0, 0), vEvents);
+	const STerrainTileData* const PtrReloadedTile{ Streamer.FindTile(STerrainTileCoord(0, 0)) };
+	CHECK(PtrReloadedTile && PtrReloadedTile->vHeights[4 * 9 + 4].R == 42);
+	CHECK(Streamer.GetStats().CreatedTileCount == KCreatedTileCount);
+}
@@ -0,0 +1,290 @@
+#include "Test.h"
+#include "Core/TextureCooker.h"
+#include <fstream>
+#include <random>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+// Smooth gradients with a little noise, like a typical albedo; alpha is a soft radial falloff
+static CTextureCooker::SImage GenerateImage(uint32_t Width, uint32_t Height)
+{
+	std::mt19937 Random{ 26 };
+	CTextureCooker::SImage Image{};
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.vPixels.resize(static_cast<size_t>(Width) * Height);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			const int KNoise{ static_cast<int>(Random() % 9) - 4 };
+			const float KDX{ static_cast<float>(X) / Width - 0.5f };
+			const float KDY{ static_cast<float>(Y) / Height - 0.5f };
+			auto ToByte{ [](float Value) { return static_cast<uint8_t>(min(max(Value, 0.0f), 255.0f)); } };
+			SPixel32UInt& Pixel{ Image.vPixels[static_cast<size_t>(Y) * Width + X] };
+			Pixel.R = ToByte(128.0f + 100.0f * sinf(X * 0.05f) + KNoise);
+			Pixel.G = ToByte(128.0f + 100.0f * cosf(Y * 0.03f) + KNoise);
+			Pixel.B = ToByte(static_cast<float>((X + Y) * 255 / (Width + Height)) + KNoise);
+			Pixel.A = ToByte(255.0f - 600.0f * (KDX * KDX + KDY * KDY));
+		}
+	}
+	return Image;
+}
+
+static void WriteFile(const string& FileName, const vector<uint8_t>& vData)
+{
+	std::ofstream ofs{};
+	ofs.open(FileName, std::ofstream::binary);
+	ofs.write(reinterpret_cast<const char*>(vData.data()), static_cast<std::streamsize>(vData.size()));
+}
+
+// 32-bit TGA; RLE packs runs of equal pixels (the synthetic image has few, so raw packets are tested too)
+static vector<uint8_t> EncodeTGA(const CTextureCooker::SImage& Image, bool bIsRLE, bool bIsTopDown)
+{
+	vector<uint8_t> vData(18);
+	vData[2] = (bIsRLE) ? 10 : 2;
+	vData[12] = static_cast<uint8_t>(Image.Width & 0xFF);
+	vData[13] = static_cast<uint8_t>(Image.Width >> 8);
+	vData[14] = static_cast<uint8_t>(Image.Height & 0xFF);
+	vData[15] = static_cast<uint8_t>(Image.Height >> 8);
+	vData[16] = 32;
+	vData[17] = (bIsTopDown) ? 0x28 : 0x08;
+
+	vector<SPixel32UInt> vFilePixels{};
+	for (uint32_t iRow = 0; iRow < Image.Height; ++iRow)
+	{
+		const uint32_t KY{ (bIsTopDown) ? iRow : Image.Height - 1 - iRow };
+		vFilePixels.insert(vFilePixels.end(), Image.vPixels.begin() + static_cast<size_t>(KY) * Image.Width,
+			Image.vPixels.begin() + static_cast<size_t>(KY + 1) * Image.Width);
+	}
+	auto WritePixel{ [&](const SPixel32UInt& Pixel) { vData.insert(vData.end(), { Pixel.B, Pixel.G, Pixel.R, Pixel.A }); } };
+	auto IsEqual{ [](const SPixel32UInt& A, const SPixel32UInt& B) { return A.R == B.R && A.G == B.G && A.B == B.B && A.A == B.A; } };
+	size_t iPixel{};
+	while (iPixel < vFilePixels.size())
+	{
+		if (!bIsRLE)
+		{
+			WritePixel(vFilePixels[iPixel++]);
+			continue;
+		}
+		size_t RunLength{ 1 };
+		while (iPixel + RunLength < vFilePixels.size() && RunLength < 128 && IsEqual(vFilePixels[iPixel + RunLength], vFilePixels[iPixel])) ++RunLength;
+		if (RunLength > 1)
+		{
+			vData.emplace_back(static_cast<uint8_t>(0x80 | (RunLength - 1)));
+			WritePixel(vFilePixels[iPixel]);
+		}
+		else
+		{
+			// One raw pixel per packet keeps this simple; the loader doesn't care
+			vData.emplace_back(0);
+			WritePixel(vFilePixels[iPixel]);
+		}
+		iPixel += RunLength;
+	}
+	return vData;
+}
+
+// 24-bit BI_RGB BMP, bottom-up unless bIsTopDown
+static vector<uint8_t> EncodeBMP(const CTextureCooker::SImage& Image, bool bIsTopDown)
+{
+	const size_t KRowPitch{ (static_cast<size_t>(Image.Width) * 3 + 3) & ~static_cast<size_t>(3) };
+	vector<uint8_t> vData(54 + KRowPitch * Image.Height);
+	auto Write32{ [&](size_t Offset, uint32_t Value) { for (int iByte = 0; iByte < 4; ++iByte) vData[Offset + iByte] = (Value >> (8 * iByte)) & 0xFF; } };
+	vData[0] = 'B';
+	vData[1] = 'M';
+	Write32(2, static_cast<uint32_t>(vData.size()));
+	Write32(10, 54);
+	Write32(14, 40);
+	Write32(18, Image.Width);
+	Write32(22, (bIsTopDown) ? static_cast<uint32_t>(-static_cast<int32_t>(Image.Height)) : Image.Height);
+	vData[26] = 1;
+	vData[28] = 24;
+	for (uint32_t iRow = 0; iRow < Image.Height; ++iRow)
+	{
+		const uint32_t KY{ (bIsTopDown) ? iRow : Image.Height - 1 - iRow };
+		for (uint32_t X = 0; X < Image.Width; ++X)
+		{
+			const SPixel32UInt& KPixel{ Image.vPixels[static_cast<size_t>(KY) * Image.Width + X] };
+			uint8_t* const PtrPixel{ &vData[54 + KRowPitch * iRow + X * 3] };
+			PtrPixel[0] = KPixel.B;
+			PtrPixel[1] = KPixel.G;
+			PtrPixel[2] = KPixel.R;
+		}
+	}
+	return vData;
+}
+
+static bool AreIdentical(const CTextureCooker::SImage& A, const CTextureCooker::SImage& B, bool bShouldCompareAlpha)
+{
+	if (A.Width != B.Width || A.Height != B.Height || A.vPixels.size() != B.vPixels.size()) return false;
+	for (size_t iPixel = 0; iPixel < A.vPixels.size(); ++iPixel)
+	{
+		const SPixel32UInt& KA{ A.vPixels[iPixel] };
+		const SPixel32UInt& KB{ B.vPixels[iPixel] };
+		if (KA.R != KB.R || KA.G != KB.G || KA.B != KB.B) return false;
+		if (KB.A != ((bShouldCompareAlpha) ? KA.A : 255)) return false;
+	}
+	return true;
+}
+
+static void SetModificationTime(const string& FileName, time_t Time)
+{
+	struct utimbuf Times {};
+	Times.actime = Time;
+	Times.modtime = Time;
+	utime(FileName.c_str(), &Times);
+}
+
+TEST_CASE(TextureCooker_EncodesWithinPSNR)
+{
+	// Floors a few dB under what the encoders reach on this image, so that quality regressions show up
+	const CTextureCooker::SImage KImage{ GenerateImage(256, 128) };
+	constexpr CTextureCooker::EFormat KFormats[]{ CTextureCooker::EFormat::BC1, CTextureCooker::EFormat::BC3, CTextureCooker::EFormat::BC5,
+		CTextureCooker::EFormat::BC7 };
+	constexpr const char* KFormatNames[]{ "BC1", "BC3", "BC5", "BC7" };
+	constexpr float KMinPSNRs[]{ 34.0f, 34.0f, 40.0f, 40.0f };
+	for (int iFormat = 0; iFormat < 4; ++iFormat)
+	{
+		vector<uint8_t> vBlocks{};
+		CTextureCooker::EncodeImage(KImage, KFormats[iFormat], vBlocks);
+		CHECK(vBlocks.size() == (256 / 4) * (128 / 4) * CTextureCooker::GetBlockByteSize(KFormats[iFormat]));
+
+		CTextureCooker::SImage Decoded{};
+		CTextureCooker::DecodeImage(vBlocks, KFormats[iFormat], KImage.Width, KImage.Height, Decoded);
+		const float KPSNR{ CTextureCooker::CalculatePSNR(KImage, Decoded, KFormats[iFormat]) };
+		printf("%s: PSNR %.2f dB\n", KFormatNames[iFormat], KPSNR);
+		CHECK(KPSNR >= KMinPSNRs[iFormat]);
+	}
+
+	// Flat blocks are exact
+	CTextureCooker::SImage Flat{};
+	Flat.Width = 8;
+	Flat.Height = 8;
+	Flat.vPixels.assign(64, SPixel32UInt{ 200, 100, 50, 255 });
+	for (CTextureCooker::EFormat eFormat : KFormats)
+	{
+		vector<uint8_t> vBlocks{};
+		CTextureCooker::EncodeImage(Flat, eFormat, vBlocks);
+		CTextureCooker::SImage Decoded{};
+		CTextureCooker::DecodeImage(vBlocks, eFormat, Flat.Width, Flat.Height, Decoded);
+		CHECK(CTextureCooker::CalculatePSNR(Flat, Decoded, eFormat) >= 40.0f);
+	}
+}
+
+TEST_CASE(TextureCooker_LoadsTGAAndBMP)
+{
+	// Odd sizes, so that BMP rows are padded
+	const CTextureCooker::SImage KImage{ GenerateImage(37, 21) };
+	CTextureCooker::SImage Loaded{};
+	for (bool bIsRLE : { false, true })
+	{
+		for (bool bIsTopDown : { false, true })
+		{
+			const string KFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCooker.tga" };
+			WriteFile(KFileName, EncodeTGA(KImage, bIsRLE, bIsTopDown));
+			CHECK(CTextureCooker::LoadImageFromFile(KFileName, Loaded));
+			CHECK(AreIdentical(KImage, Loaded, true));
+		}
+	}
+	for (bool bIsTopDown : { false, true })
+	{
+		const string KFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCooker.bmp" };
+		WriteFile(KFileName, EncodeBMP(KImage, bIsTopDown));
+		CHECK(CTextureCooker::LoadImageFromFile(KFileName, Loaded));
+		CHECK(AreIdentical(KImage, Loaded, false));
+	}
+
+	// RLE runs, including one across rows
+	CTextureCooker::SImage Flat{};
+	Flat.Width = 100;
+	Flat.Height = 3;
+	Flat.vPixels.assign(300, SPixel32UInt{ 1, 2, 3, 4 });
+	Flat.vPixels[150] = SPixel32UInt{ 9, 9, 9, 9 };
+	const string KFlatFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCookerFlat.tga" };
+	const vector<uint8_t> KFlatData{ EncodeTGA(Flat, true, true) };
+	CHECK(KFlatData.size() < 18 + 20 * 5);
+	WriteFile(KFlatFileName, KFlatData);
+	CHECK(CTextureCooker::LoadImageFromFile(KFlatFileName, Loaded));
+	CHECK(AreIdentical(Flat, Loaded, true));
+
+	// Truncated or unsupported files fail instead of reading past the end
+	vector<uint8_t> vTruncated{ EncodeTGA(KImage, false, false) };
+	vTruncated.resize(vTruncated.size() / 2);
+	WriteFile(KFlatFileName, vTruncated);
+	CHECK(!CTextureCooker::LoadImageFromFile(KFlatFileName, Loaded));
+	vector<uint8_t> vCompressedBMP{ EncodeBMP(KImage, false) };
+	vCompressedBMP[30] = 1;
+	const string KBMPFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCooker.bmp" };
+	WriteFile(KBMPFileName, vCompressedBMP);
+	CHECK(!CTextureCooker::LoadImageFromFile(KBMPFileName, Loaded));
+	CHECK(!CTextureCooker::LoadImageFromFile(string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/Missing.tga", Loaded));
+}
+
+TEST_CASE(TextureCooker_CooksAndDetectsStaleFiles)
+{
+	const string KSourceFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCookerSource.tga" };
+	const string KCookedFileName{ CTextureCooker::GetCookedFileName(KSourceFileName) };
+	CHECK(KCookedFileName == string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureCookerSource.dds");
+	remove(KCookedFileName.c_str());
+	WriteFile(KSourceFileName, EncodeTGA(GenerateImage(64, 32), false, false));
+	CHECK(!CTextureCooker::IsCookedFileUpToDate(KSourceFileName, KCookedFileName));
+
+	CTextureCooker Cooker{};
+	CHECK(Cooker.Cook(KSourceFileName, CTextureCooker::EFormat::BC7));
+	const CTextureCooker::SCookStats& KStats{ Cooker.GetLastStats() };
+	CHECK(KStats.Width == 64 && KStats.Height == 32 && KStats.MipLevels == 7);
+	// Mips smaller than a block still take a whole block
+	CHECK(KStats.CookedByteSize == (128 + 32 + 8 + 2 + 1 + 1 + 1) * 16);
+	CHECK(KStats.PSNR >= 36.0f);
+
+	uint32_t Width{};
+	uint32_t Height{};
+	uint32_t MipLevels{};
+	CHECK(CTextureCooker::ReadDDSFileSize(KCookedFileName, Width, Height, MipLevels));
+	CHECK(Width == 64 && Height == 32 && MipLevels == 7);
+	struct stat CookedStat {};
+	CHECK(stat(KCookedFileName.c_str(), &CookedStat) == 0 && static_cast<size_t>(CookedStat.st_size) == 4 + 124 + 20 + KStats.CookedByteSize);
+
+	// Times are set explicitly instead of sleeping past the file system's resolution
+	const time_t KNow{ time(nullptr) };
+	SetModificationTime(KSourceFileName, KNow - 100);
+	SetModificationTime(KCookedFileName, KNow - 50);
+	CHECK(CTextureCooker::IsCookedFileUpToDate(KSourceFileName, KCookedFileName));
+	SetModificationTime(KSourceFileName, KNow - 50);
+	CHECK(!CTextureCooker::IsCookedFileUpToDate(KSourceFileName, KCookedFileName));
+	SetModificationTime(KSourceFileName, KNow);
+	CHECK(!CTextureCooker::IsCookedFileUpToDate(KSourceFileName, KCookedFileName));
+
+	// Only the cooked file may ship
+	CHECK(CTextureCooker::IsCookedFileUpToDate(string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/Missing.tga", KCookedFileName));
+
+	// Block compression needs multiple-of-4 sizes
+	WriteFile(KSourceFileName, EncodeTGA(GenerateImage(30, 32), false, false));
+	CHECK(!Cooker.Cook(KSourceFileName, CTextureCooker::EFormat::BC1));
+}
+
+// Encoder throughput per format on a 1024 x 1024 image
+BENCH_CASE(TextureCooker_EncoderThroughput)
+{
+	const CTextureCooker::SImage KImage{ GenerateImage(1024, 1024) };
+	constexpr CTextureCooker::EFormat KFormats[]{ CTextureCooker::EFormat::BC1, CTextureCooker::EFormat::BC3, CTextureCooker::EFormat::BC5,
+		CTextureCooker::EFormat::BC7 };
+	constexpr const char* KFormatNames[]{ "BC1", "BC3", "BC5", "BC7" };
+	for (int iFormat = 0; iFormat < 4; ++iFormat)
+	{
+		vector<uint8_t> vBlocks{};
+		CTestTimer Timer{};
+		CTextureCooker::EncodeImage(KImage, KFormats[iFormat], vBlocks);
+		const double KMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+		CTextureCooker::SImage Decoded{};
+		CTextureCooker::DecodeImage(vBlocks, KFormats[iFormat], KImage.Width, KImage.Height, Decoded);
+		printf("%s: %.2f MPix/s, PSNR %.2f dB, %zu -> %zu bytes\n", KFormatNames[iFormat], KImage.vPixels.size() / 1000.0 / max(KMilliseconds, 1e-3),
+			CTextureCooker::CalculatePSNR(KImage, Decoded, KFormats[iFormat]), KImage.vPixels.size() * sizeof(SPixel32UInt), vBlocks.size());
+	}
+}
@@ -0,0 +1,310 @@
+#include "Test.h"
+#include "Core/TextureStreamer.h"
+#include "Core/TextureMipLoader.h"
+#include "Core/TextureCooker.h"
+#include "Core/RenderDeviceNull.h"
+#include <fstream>
+
+// One frame of a synthetic scene: the textures in vUsages are seen with (ScreenPixelArea, UVArea), the others aren't
+static void RunFrame(CTextureStreamer& Streamer, const vector<std::pair<size_t, XMFLOAT2>>& vUsages,
+	vector<CTextureStreamer::SRequest>& vOutRequests)
+{
+	Streamer.BeginFrame();
+	for (const auto& Usage : vUsages)
+	{
+		Streamer.ReportUsage(Usage.first, Usage.second.x, Usage.second.y);
+	}
+	Streamer.Update(vOutRequests);
+}
+
+static bool HasRequest(const vector<CTextureStreamer::SRequest>& vRequests, size_t TextureID, uint32_t PrevResidentMip, uint32_t ResidentMip)
+{
+	for (const CTextureStreamer::SRequest& Request : vRequests)
+	{
+		if (Request.TextureID == TextureID && Request.PrevResidentMip == PrevResidentMip && Request.ResidentMip == ResidentMip) return true;
+	}
+	return false;
+}
+
+// Unit spheres at 6, 24, 96 and 384 units: each is 4 times farther than the previous one, so it needs 2 mips less
+static vector<std::pair<size_t, XMFLOAT2>> GetSphereRowUsages(const vector<size_t>& vTextureIDs)
+{
+	static constexpr float KDistances[]{ 6.0f, 24.0f, 96.0f, 384.0f };
+
+	vector<std::pair<size_t, XMFLOAT2>> vUsages{};
+	for (size_t iTexture = 0; iTexture < vTextureIDs.size(); ++iTexture)
+	{
+		const float KScreenPixelArea{ CTextureStreamer::CalculateScreenPixelArea(1.0f, KDistances[iTexture], XM_PIDIV4, XMFLOAT2(1920, 1080)) };
+		vUsages.emplace_back(vTextureIDs[iTexture], XMFLOAT2(KScreenPixelArea, 0.5f));
+	}
+	return vUsages;
+}
+
+TEST_CASE(TextureStreamer_StreamsByScreenCoverage)
+{
+	// 1024 x 1024 BC1: mip 4 (64 x 64) is the tail
+	const CTextureStreamer::STextureDesc KDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_BC1_UNORM, 1024, 1024, 11) };
+	CTextureStreamer Streamer{};
+	vector<size_t> vTextureIDs{};
+	for (int iTexture = 0; iTexture < 4; ++iTexture) vTextureIDs.emplace_back(Streamer.RegisterTexture(KDesc));
+	CHECK(Streamer.GetResidentMip(vTextureIDs[0]) == 4);
+	CHECK(Streamer.GetStats().ResidentBytes == 4 * CTextureStreamer::GetResidentByteSize(KDesc, 4));
+
+	const vector<std::pair<size_t, XMFLOAT2>> KUsages{ GetSphereRowUsages(vTextureIDs) };
+	vector<CTextureStreamer::SRequest> vRequests{};
+	RunFrame(Streamer, KUsages, vRequests);
+	for (int iFrame = 0; iFrame < 16 && Streamer.GetStats().PendingRequestCount; ++iFrame) RunFrame(Streamer, KUsages, vRequests);
+
+	// The farthest one would need mip 6, but the tail is never streamed out
+	const uint32_t KRequiredMips[]{ 0, 2, 4, 6 };
+	const uint32_t KResidentMips[]{ 0, 2, 4, 4 };
+	for (size_t iTexture = 0; iTexture < vTextureIDs.size(); ++iTexture)
+	{
+		CHECK(Streamer.GetRequiredMip(vTextureIDs[iTexture]) == KRequiredMips[iTexture]);
+		CHECK(Streamer.GetResidentMip(vTextureIDs[iTexture]) == KResidentMips[iTexture]);
+	}
+	CHECK(Streamer.GetStats().PendingRequestCount == 0);
+	CHECK(Streamer.GetStats().ResidentBytes == Streamer.GetStats().RequiredBytes);
+
+	// Nothing changes while the scene doesn't
+	RunFrame(Streamer, KUsages, vRequests);
+	CHECK(vRequests.empty() && Streamer.GetStats().UploadedBytes == 0);
+}
+
+TEST_CASE(TextureStreamer_RespectsUploadBudget)
+{
+	const CTextureStreamer::STextureDesc KDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_BC1_UNORM, 1024, 1024, 11) };
+	CTextureStreamer Streamer{};
+	CTextureStreamer::SBudget Budget{};
+	Budget.UploadByteBudgetPerFrame = CTextureStreamer::GetMipByteSize(KDesc, 3);
+	Streamer.SetBudget(Budget);
+
+	vector<size_t> vTextureIDs{};
+	vTextureIDs.emplace_back(Streamer.RegisterTexture(KDesc));
+	vTextureIDs.emplace_back(Streamer.RegisterTexture(KDesc));
+	const vector<std::pair<size_t, XMFLOAT2>> KUsages{ GetSphereRowUsages(vTextureIDs) };
+
+	// The larger mip deficit goes first, and the budget holds exactly one mip 3
+	vector<CTextureStreamer::SRequest> vRequests{};
+	RunFrame(Streamer, KUsages, vRequests);
+	CHECK(vRequests.size() == 1 && HasRequest(vRequests, vTextureIDs[0], 4, 3));
+	CHECK(Streamer.GetStats().UploadedBytes == Budget.UploadByteBudgetPerFrame && Streamer.GetStats().StreamedMipCount == 1);
+	CHECK(Streamer.GetStats().PendingRequestCount == 2);
+
+	// Finer mips are larger than the budget, so they are streamed one per frame
+	size_t FrameCount{ 1 };
+	while (Streamer.GetStats().PendingRequestCount && FrameCount < 32)
+	{
+		RunFrame(Streamer, KUsages, vRequests);
+		const CTextureStreamer::SStats& KStats{ Streamer.GetStats() };
+		CHECK(KStats.UploadedBytes <= Budget.UploadByteBudgetPerFrame || KStats.StreamedMipCount == 1);
+		++FrameCount;
+	}
+	CHECK(FrameCount == 6);
+	CHECK(Streamer.GetResidentMip(vTextureIDs[0]) == 0 && Streamer.GetResidentMip(vTextureIDs[1]) == 2);
+}
+
+TEST_CASE(TextureStreamer_EvictsLeastRecentlyUsed)
+{
+	// 256 x 256 R8G8B8A8: mip 2 (64 x 64) is the tail
+	const CTextureStreamer::STextureDesc KDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 9) };
+	const size_t KFullByteSize{ CTextureStreamer::GetResidentByteSize(KDesc, 0) };
+	const size_t KTailByteSize{ CTextureStreamer::GetResidentByteSize(KDesc, 2) };
+	CTextureStreamer Streamer{};
+	CTextureStreamer::SBudget Budget{};
+	Budget.ResidentByteBudget = 2 * KFullByteSize + KTailByteSize;
+	Streamer.SetBudget(Budget);
+
+	const size_t KTexture0{ Streamer.RegisterTexture(KDesc) };
+	const size_t KTexture1{ Streamer.RegisterTexture(KDesc) };
+	const size_t KTexture2{ Streamer.RegisterTexture(KDesc) };
+	const XMFLOAT2 KNearUsage{ 1.0e6f, 1.0f };
+
+	// 0 and then 1 are seen up close, which fills the budget exactly
+	vector<CTextureStreamer::SRequest> vRequests{};
+	RunFrame(Streamer, { { KTexture0, KNearUsage } }, vRequests);
+	CHECK(vRequests.size() == 1 && HasRequest(vRequests, KTexture0, 2, 0));
+	RunFrame(Streamer, { { KTexture1, KNearUsage } }, vRequests);
+	CHECK(vRequests.size() == 1 && HasRequest(vRequests, KTexture1, 2, 0));
+	CHECK(Streamer.GetStats().ResidentBytes == Budget.ResidentByteBudget && Streamer.GetStats().EvictedMipCount == 0);
+
+	// 2 makes room by evicting 0 (the least recently used) down to its tail, while 1 keeps its mips
+	RunFrame(Streamer, { { KTexture2, KNearUsage } }, vRequests);
+	CHECK(vRequests.size() == 2 && HasRequest(vRequests, KTexture0, 0, 2) && HasRequest(vRequests, KTexture2, 2, 0));
+	CHECK(Streamer.GetResidentMip(KTexture1) == 0);
+	CHECK(Streamer.GetStats().EvictedMipCount == 2 && Streamer.GetStats().EvictedBytes == KFullByteSize - KTailByteSize);
+	CHECK(Streamer.GetStats().ResidentBytes == Budget.ResidentByteBudget);
+
+	// Without any budget, everything is evicted but the tails
+	Budget.ResidentByteBudget = 0;
+	Streamer.SetBudget(Budget);
+	RunFrame(Streamer, {}, vRequests);
+	CHECK(Streamer.GetResidentMip(KTexture0) == 2 && Streamer.GetResidentMip(KTexture1) == 2 && Streamer.GetResidentMip(KTexture2) == 2);
+	CHECK(Streamer.GetStats().ResidentBytes == 3 * KTailByteSize);
+
+	// Even when a texture is seen up close
+	RunFrame(Streamer, { { KTexture0, KNearUsage } }, vRequests);
+	CHECK(vRequests.empty() && Streamer.GetStats().PendingRequestCount == 1);
+
+	Streamer.UnregisterTexture(KTexture1);
+	CHECK(Streamer.GetStats().TextureCount == 2 && Streamer.GetStats().ResidentBytes == 2 * KTailByteSize);
+}
+
+// A DX10 DDS file of R8G8B8A8 texels whose bytes are their mip index
+static void WriteMipIndexDDSFile(const string& FileName, uint32_t Width, uint32_t Height, uint32_t MipLevels)
+{
+	uint32_t Header[1 + 31 + 5]{};
+	Header[0] = 0x20534444; // "DDS "
+	Header[1] = 124;
+	Header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT
+	Header[3] = Height;
+	Header[4] = Width;
+	Header[7] = MipLevels;
+	Header[19] = 32;
+	Header[20] = 0x4; // DDPF_FOURCC
+	Header[21] = 0x30315844; // "DX10"
+	Header[27] = 0x1000 | 0x8 | 0x400000; // DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+	Header[32] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Header[33] = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+	Header[35] = 1;
+
+	std::ofstream ofs{};
+	ofs.open(FileName, std::ofstream::binary);
+	ofs.write(reinterpret_cast<const char*>(Header), sizeof(Header));
+	for (uint32_t iMip = 0; iMip < MipLevels; ++iMip)
+	{
+		const vector<char> KTexels(static_cast<size_t>(max(Width >> iMip, 1u)) * max(Height >> iMip, 1u) * 4, static_cast<char>(iMip));
+		ofs.write(KTexels.data(), static_cast<std::streamsize>(KTexels.size()));
+	}
+}
+
+TEST_CASE(TextureMipLoader_ReadsMipsInBackground)
+{
+	const string KFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureMipLoader.dds" };
+	WriteMipIndexDDSFile(KFileName, 64, 32, 7);
+
+	vector<vector<uint8_t>> vMips{};
+	CHECK(!CTextureCooker::ReadDDSFileMips(KFileName, 5, 3, vMips));
+	CHECK(CTextureCooker::ReadDDSFileMips(KFileName, 6, 1, vMips) && vMips.size() == 1 && vMips[0].size() == 4 && vMips[0][3] == 6);
+
+	CTextureMipLoader Loader{ 2 };
+	const uint64_t KLoadID{ Loader.Load(7, KFileName, 2, 3) };
+	const uint64_t KMissingLoadID{ Loader.Load(8, string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/Missing.dds", 0, 1) };
+	CHECK(KLoadID != 0 && KMissingLoadID != KLoadID);
+	Loader.Flush();
+	CHECK(Loader.GetPendingLoadCount() == 0);
+
+	vector<CTextureMipLoader::SResult> vResults{};
+	Loader.TakeResults(vResults);
+	CHECK(vResults.size() == 2);
+	for (const CTextureMipLoader::SResult& Result : vResults)
+	{
+		if (Result.LoadID == KMissingLoadID)
+		{
+			CHECK(Result.TextureID == 8 && Result.vMips.empty());
+			continue;
+		}
+
+		// 16 x 8, 8 x 4 and 4 x 2 texels
+		CHECK(Result.LoadID == KLoadID && Result.TextureID == 7 && Result.FirstMip == 2 && Result.vMips.size() == 3);
+		if (Result.vMips.size() != 3) continue;
+		CHECK(Result.vMips[0].size() == 16 * 8 * 4 && Result.vMips[1].size() == 8 * 4 * 4 && Result.vMips[2].size() == 4 * 2 * 4);
+		CHECK(Result.vMips[0].front() == 2 && Result.vMips[1].back() == 3 && Result.vMips[2][5] == 4);
+	}
+	CHECK(Loader.GetStats().FinishedLoadCount == 2 && Loader.GetStats().FailedLoadCount == 1);
+	Loader.TakeResults(vResults);
+	CHECK(vResults.empty());
+}
+
+TEST_CASE(TextureMipLoader_ReallocatesWithResidentMips)
+{
+	const string KFileName{ string(GRASSFIELD_TEST_OUTPUT_DIRECTORY) + "/TextureMipLoaderResident.dds" };
+	WriteMipIndexDDSFile(KFileName, 256, 256, 9);
+	const CTextureStreamer::STextureDesc KStreamingDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 9) };
+
+	// Like CMaterial::CTexture::Reallocate(): the texture only has the resident mips [ResidentMip, 9), the newly read ones are copied
+	// from an upload texture and the others from the previous texture
+	CRenderDeviceNull Device{};
+	auto Reallocate{ [&](ID3D11Texture2D* const PtrPrevTexture, UINT PrevResidentMip, UINT ResidentMip, const vector<vector<uint8_t>>& vLoadedMips)
+		{
+			D3D11_TEXTURE2D_DESC Desc{};
+			Desc.Width = 256 >> ResidentMip;
+			Desc.Height = 256 >> ResidentMip;
+			Desc.MipLevels = 9 - ResidentMip;
+			Desc.ArraySize = 1;
+			Desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			Desc.SampleDesc.Count = 1;
+			Desc.Usage = D3D11_USAGE_DEFAULT;
+			Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			ComPtr<ID3D11Texture2D> Texture{};
+			CHECK(SUCCEEDED(Device.CreateTexture2D(Desc, nullptr, Texture.GetAddressOf())));
+
+			if (vLoadedMips.size())
+			{
+				D3D11_TEXTURE2D_DESC UploadDesc{ Desc };
+				UploadDesc.MipLevels = static_cast<UINT>(vLoadedMips.size());
+				UploadDesc.Usage = D3D11_USAGE_IMMUTABLE;
+				vector<D3D11_SUBRESOURCE_DATA> vData{};
+				for (UINT iMip = 0; iMip < UploadDesc.MipLevels; ++iMip)
+				{
+					vData.push_back({ vLoadedMips[iMip].data(), (Desc.Width >> iMip) * 4, 0 });
+				}
+				ComPtr<ID3D11Texture2D> UploadTexture{};
+				CHECK(SUCCEEDED(Device.CreateTexture2D(UploadDesc, vData.data(), UploadTexture.GetAddressOf())));
+				for (UINT iMip = 0; iMip < UploadDesc.MipLevels; ++iMip)
+				{
+					Device.CopyTextureRegion(Texture.Get(), iMip, 0, 0, UploadTexture.Get(), iMip, nullptr);
+				}
+			}
+			for (UINT iMip = ResidentMip + static_cast<UINT>(vLoadedMips.size()); iMip < 9; ++iMip)
+			{
+				Device.CopyTextureRegion(Texture.Get(), iMip - ResidentMip, 0, 0, PtrPrevTexture, iMip - PrevResidentMip, nullptr);
+			}
+			return Texture;
+		} };
+
+	vector<vector<uint8_t>> vTailMips{};
+	CHECK(CTextureCooker::ReadDDSFileMips(KFileName, 2, 7, vTailMips));
+	ComPtr<ID3D11Texture2D> TailTexture{ Reallocate(nullptr, 9, 2, vTailMips) };
+	CHECK(Device.GetStats().CopiedByteCount == CTextureStreamer::GetResidentByteSize(KStreamingDesc, 2));
+
+	CTextureMipLoader Loader{};
+	Loader.Load(0, KFileName, 1, 1);
+	Loader.Flush();
+	vector<CTextureMipLoader::SResult> vResults{};
+	Loader.TakeResults(vResults);
+	CHECK(vResults.size() == 1 && vResults[0].vMips.size() == 1);
+	if (vResults.size() != 1 || vResults[0].vMips.size() != 1) return;
+
+	// Streaming in mip 1 uploads it and copies mips [2, 9) over
+	Device.Reset();
+	ComPtr<ID3D11Texture2D> Texture{ Reallocate(TailTexture.Get(), 2, 1, vResults[0].vMips) };
+	const D3D11_TEXTURE2D_DESC* PtrDesc{ Device.GetTextureDesc(Texture.Get()) };
+	CHECK(PtrDesc && PtrDesc->Width == 128 && PtrDesc->MipLevels == 8);
+	CHECK(Device.GetStats().CopyCount == 8 && Device.GetStats().CopiedByteCount == CTextureStreamer::GetResidentByteSize(KStreamingDesc, 1));
+
+	// Evicting it again allocates mips [2, 9) only, so mip 1's memory goes with the previous texture
+	Device.Reset();
+	ComPtr<ID3D11Texture2D> EvictedTexture{ Reallocate(Texture.Get(), 1, 2, {}) };
+	PtrDesc = Device.GetTextureDesc(EvictedTexture.Get());
+	CHECK(PtrDesc && PtrDesc->Width == 64 && PtrDesc->MipLevels == 7);
+	CHECK(Device.GetStats().CreatedByteCount == CTextureStreamer::GetResidentByteSize(KStreamingDesc, 2));
+	CHECK(Device.GetStats().CopiedByteCount == CTextureStreamer::GetResidentByteSize(KStreamingDesc, 2));
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+}
+
+TEST_CASE(TextureStreamer_AllocatableMipIsMadeOfWholeBlocks)
+{
+	// 100 x 100: mip 1 (50 x 50) and mip 2 (25 x 25) aren't made of 4 x 4 blocks
+	const CTextureStreamer::STextureDesc KBCDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_BC1_UNORM, 100, 100, 7) };
+	CHECK(CTextureStreamer::GetAllocatableMip(KBCDesc, 0) == 0);
+	CHECK(CTextureStreamer::GetAllocatableMip(KBCDesc, 2) == 0);
+
+	// 256 x 128: mip 5 is 8 x 4, mip 6 is 4 x 2
+	const CTextureStreamer::STextureDesc KBC7Desc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_BC7_UNORM, 256, 128, 9) };
+	CHECK(CTextureStreamer::GetAllocatableMip(KBC7Desc, 5) == 5);
+	CHECK(CTextureStreamer::GetAllocatableMip(KBC7Desc, 8) == 5);
+
+	const CTextureStreamer::STextureDesc KDesc{ CTextureStreamer::MakeTextureDesc(DXGI_FORMAT_R8G8B8A8_UNORM, 100, 100, 7) };
+	CHECK(CTextureStreamer::GetAllocatableMip(KDesc, 6) == 6);
+}
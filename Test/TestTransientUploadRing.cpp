@@ -0,0 +1,139 @@
+#include "Test.h"
+#include "Core/TransientUploadRing.h"
+#include "Core/RenderDeviceNull.h"
+#include <cstring>
+
+TEST_CASE(TransientUploadRing_UploadsWithNoOverwrite)
+{
+	ID3D11Buffer* const KRingBuffer{ MakeHandle<ID3D11Buffer>(0x10) };
+	ID3D11Buffer* const KMeshBuffer{ MakeHandle<ID3D11Buffer>(0x20) };
+	CRenderDeviceNull Device{};
+	Device.SetFenceLatency(2);
+	CTransientUploadRing Ring{ &Device };
+	Ring.SetBuffer(KRingBuffer, 64 * 1024);
+
+	size_t OverflowCount{};
+	size_t WrongDataCount{};
+	for (int Frame = 0; Frame < 100; ++Frame)
+	{
+		Ring.BeginFrame();
+
+		// 20 dynamic objects of 48 to 1200 bytes
+		for (int iObject = 0; iObject < 20; ++iObject)
+		{
+			const vector<uint8_t> KData(48 * (1 + (Frame * 7 + iObject) % 25), static_cast<uint8_t>(Frame + iObject));
+			STransientAllocation Allocation{};
+			CHECK(Ring.Upload(KData.data(), KData.size(), Allocation));
+			CHECK(Allocation.PtrBuffer == KRingBuffer);
+			CHECK(Allocation.Offset % CTransientUploadRing::KDefaultAlignment == 0);
+			if (memcmp(Device.GetBufferMemory(KRingBuffer)->data() + Allocation.Offset, KData.data(), KData.size()) != 0) ++WrongDataCount;
+		}
+
+		const vector<uint8_t> KMeshData(4096, static_cast<uint8_t>(Frame));
+		CHECK(Ring.UploadToBuffer(KMeshBuffer, 128, KMeshData.data(), KMeshData.size()));
+		if (memcmp(Device.GetBufferMemory(KMeshBuffer)->data() + 128, KMeshData.data(), KMeshData.size()) != 0) ++WrongDataCount;
+
+		OverflowCount += Ring.GetStats().OverflowCount;
+		CHECK(Ring.GetOccupancy() > 0.0f && Ring.GetOccupancy() <= 1.0f);
+		Ring.EndFrame();
+	}
+	CHECK(WrongDataCount == 0);
+
+	// Only the very first map renames the buffer
+	size_t DiscardCount{};
+	for (const CRenderDeviceNull::SCommand& Command : Device.GetCommands())
+	{
+		if (Command.eType == CRenderDeviceNull::ECommandType::Map && Command.Arguments[0] == D3D11_MAP_WRITE_DISCARD) ++DiscardCount;
+	}
+	CHECK(OverflowCount == 0);
+	CHECK(DiscardCount == 1);
+	CHECK(Device.GetStats().CopyCount == 100);
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+}
+
+TEST_CASE(TransientUploadRing_RenamesOnOverflow)
+{
+	ID3D11Buffer* const KRingBuffer{ MakeHandle<ID3D11Buffer>(0x10) };
+	CRenderDeviceNull Device{};
+	Device.SetFenceLatency(2);
+	CTransientUploadRing Ring{ &Device };
+	Ring.SetBuffer(KRingBuffer, 8 * 1024);
+
+	// 6000 bytes per frame with 3 frames in flight don't fit in 8 KB
+	size_t OverflowCount{};
+	const vector<uint8_t> KData(3000, 1);
+	for (int Frame = 0; Frame < 10; ++Frame)
+	{
+		Ring.BeginFrame();
+		STransientAllocation Allocation{};
+		CHECK(Ring.Upload(KData.data(), KData.size(), Allocation));
+		CHECK(Ring.Upload(KData.data(), KData.size(), Allocation));
+		OverflowCount += Ring.GetStats().OverflowCount;
+		Ring.EndFrame();
+	}
+
+	size_t DiscardCount{};
+	for (const CRenderDeviceNull::SCommand& Command : Device.GetCommands())
+	{
+		if (Command.eType == CRenderDeviceNull::ECommandType::Map && Command.Arguments[0] == D3D11_MAP_WRITE_DISCARD) ++DiscardCount;
+	}
+	CHECK(OverflowCount > 0);
+	CHECK(DiscardCount == OverflowCount + 1);
+	CHECK(Device.GetStats().ValidationErrorCount == 0);
+
+	// Larger than the ring: refused without a rename
+	const vector<uint8_t> KLargeData(9000);
+	STransientAllocation Allocation{};
+	Ring.BeginFrame();
+	CHECK(!Ring.Upload(KLargeData.data(), KLargeData.size(), Allocation));
+	CHECK(Ring.GetStats().OverflowCount == 0);
+
+	// Once the GPU is idle the whole ring is free again
+	Ring.EndFrame();
+	Device.CompleteFences();
+	Ring.BeginFrame();
+	CHECK(Ring.GetUsedByteSize() == 0);
+}
+
+// 200 dynamic objects per frame: one WRITE_DISCARD buffer per object vs. the shared ring (the null device's own cost isn't timed)
+BENCH_CASE(TransientUploadRing_DynamicObjects)
+{
+	constexpr size_t KObjectCount{ 200 };
+	const vector<uint8_t> KData(48 * 64);
+
+	CRenderDeviceNull PerObjectDevice{ false };
+	for (int Frame = 0; Frame < 3; ++Frame)
+	{
+		for (uintptr_t iObject = 0; iObject < KObjectCount; ++iObject)
+		{
+			void* const PtrData{ PerObjectDevice.Map(MakeHandle<ID3D11Buffer>(0x100 + iObject), D3D11_MAP_WRITE_DISCARD, KData.size()) };
+			memcpy(PtrData, KData.data(), KData.size());
+			PerObjectDevice.Unmap(MakeHandle<ID3D11Buffer>(0x100 + iObject));
+		}
+	}
+
+	CRenderDeviceNull RingDevice{};
+	RingDevice.SetFenceLatency(2);
+	CTransientUploadRing Ring{ &RingDevice };
+	Ring.SetBuffer(MakeHandle<ID3D11Buffer>(0x10), 8 * 1024 * 1024);
+	float PeakOccupancy{};
+	for (int Frame = 0; Frame < 3; ++Frame)
+	{
+		Ring.BeginFrame();
+		for (size_t iObject = 0; iObject < KObjectCount; ++iObject)
+		{
+			STransientAllocation Allocation{};
+			Ring.Upload(KData.data(), KData.size(), Allocation);
+		}
+		PeakOccupancy = max(PeakOccupancy, Ring.GetOccupancy());
+		Ring.EndFrame();
+	}
+
+	size_t RingDiscardCount{};
+	for (const CRenderDeviceNull::SCommand& Command : RingDevice.GetCommands())
+	{
+		if (Command.eType == CRenderDeviceNull::ECommandType::Map && Command.Arguments[0] == D3D11_MAP_WRITE_DISCARD) ++RingDiscardCount;
+	}
+	printf("%zu objects x 3 frames: per-object buffers %zu renames, ring %zu renames, %zu overflows, peak occupancy %.3f\n",
+		KObjectCount, PerObjectDevice.GetStats().MapCount, RingDiscardCount, Ring.GetStats().OverflowCount, PeakOccupancy);
+}
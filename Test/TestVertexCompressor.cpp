@@ -0,0 +1,144 @@
+#include "Test.h"
+#include "Core/VertexCompressor.h"
+#include <cstddef>
+#include <random>
+
+// Random vertices in a 100 x 6 x 40 box with unit normals, orthogonal tangents of both handedness and normalized skinning weights
+// The first vertices point along the axes and the octahedron's folds, where octahedral encoding is the least precise
+static SMesh GenerateRandomMesh(size_t VertexCount, uint32_t Seed)
+{
+	static constexpr float KAxes[8][3]
+	{
+		{ 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0.577f, -0.577f, -0.577f }, { -0.7071f, 0, -0.7071f }
+	};
+
+	std::mt19937 Random{ Seed };
+	std::uniform_real_distribution<float> Signed{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float> Unsigned{ 0.0f, 1.0f };
+
+	SMesh Mesh{};
+	for (size_t iVertex = 0; iVertex < VertexCount; ++iVertex)
+	{
+		SVertex3D Vertex{};
+		Vertex.Position = XMVectorSet(Signed(Random) * 50.0f + 10.0f, Signed(Random) * 3.0f, Signed(Random) * 20.0f, 1.0f);
+		Vertex.Normal = (iVertex < 8) ? XMVector3Normalize(XMVectorSet(KAxes[iVertex][0], KAxes[iVertex][1], KAxes[iVertex][2], 0)) :
+			XMVector3Normalize(XMVectorSet(Signed(Random), Signed(Random), Signed(Random), 0));
+		Vertex.Tangent = XMVector3Normalize(XMVector3Cross(Vertex.Normal, XMVectorSet(0.3f, 1.0f, 0.2f, 0)));
+		Vertex.Bitangent = XMVectorScale(XMVector3Cross(Vertex.Normal, Vertex.Tangent), (iVertex & 1) ? 1.0f : -1.0f);
+		Vertex.TexCoord = XMVectorSet(Unsigned(Random) * 4.0f - 1.0f, Unsigned(Random), 0, 0);
+		Vertex.Color = XMVectorSet(Unsigned(Random), Unsigned(Random), Unsigned(Random), 1.0f);
+		Mesh.vVertices.emplace_back(Vertex);
+
+		SVertexAnimation Animation{};
+		float Weights[KMaxWeightCount]{ Unsigned(Random), Unsigned(Random), Unsigned(Random) * 0.1f, 0.0f };
+		const float KWeightSum{ Weights[0] + Weights[1] + Weights[2] };
+		for (uint32_t iWeight = 0; iWeight < KMaxWeightCount; ++iWeight)
+		{
+			Animation.BoneIDs[iWeight] = Random() % KMaxBoneMatrixCount;
+			Animation.Weights[iWeight] = Weights[iWeight] / KWeightSum;
+		}
+		Mesh.vVerticesAnimation.emplace_back(Animation);
+	}
+	return Mesh;
+}
+
+TEST_CASE(VertexCompressor_LayoutMatchesInputElements)
+{
+	CHECK(sizeof(SVertex3DCompressed) == 24);
+	CHECK(sizeof(SVertexAnimationCompressed) == 8);
+
+	const D3D11_INPUT_ELEMENT_DESC* const KDescs{ CVertexCompressor::KInputElementDescs };
+	CHECK(KDescs[0].AlignedByteOffset == offsetof(SVertex3DCompressed, Position));
+	CHECK(KDescs[1].AlignedByteOffset == offsetof(SVertex3DCompressed, Normal));
+	CHECK(KDescs[2].AlignedByteOffset == offsetof(SVertex3DCompressed, Tangent));
+	CHECK(KDescs[3].AlignedByteOffset == offsetof(SVertex3DCompressed, TexCoord));
+	CHECK(KDescs[4].AlignedByteOffset == offsetof(SVertex3DCompressed, Color));
+	CHECK(KDescs[5].AlignedByteOffset == offsetof(SVertexAnimationCompressed, BoneIDs));
+	CHECK(KDescs[6].AlignedByteOffset == offsetof(SVertexAnimationCompressed, Weights));
+}
+
+TEST_CASE(VertexCompressor_RoundTripErrorIsBounded)
+{
+	const vector<SMesh> KMeshes{ GenerateRandomMesh(100'000, 7) };
+	const CVertexCompressor::SCBVSVertexQuantizationData KQuantization{ CVertexCompressor::CalculateQuantization(KMeshes) };
+	const CVertexCompressor::SErrorStats KStats{ CVertexCompressor::AnalyzeError(KMeshes, KQuantization) };
+
+	printf("position %g (extent %g), normal %g deg, tangent %g deg, texcoord %g, weight %g, %zu -> %zu bytes\n",
+		KStats.MaxPositionError, KQuantization.PositionExtent.x, KStats.MaxNormalAngleError, KStats.MaxTangentAngleError,
+		KStats.MaxTexCoordError, KStats.MaxWeightError, KStats.ByteSizeBefore, KStats.ByteSizeAfter);
+
+	// Half a SNORM16 / UNORM16 step of the bounds (plus float rounding)
+	const float KMaxExtent{ max(KQuantization.PositionExtent.x, max(KQuantization.PositionExtent.y, KQuantization.PositionExtent.z)) };
+	CHECK(KStats.VertexCount == 100'000);
+	CHECK(KStats.MaxPositionError <= KMaxExtent / 32767.0f);
+	CHECK(KStats.MaxTexCoordError <= 4.0f / 65535.0f);
+	// Octahedral SNORM16 is good to about 0.005 degrees
+	CHECK(KStats.MaxNormalAngleError < 0.02f);
+	CHECK(KStats.MaxTangentAngleError < 0.02f);
+	// Weights are rounded to 1/255 and then renormalized to sum to 255
+	CHECK(KStats.MaxWeightError <= 2.0f / 255.0f);
+	// 96 + 32 bytes -> 24 + 8 bytes per vertex
+	CHECK(KStats.ByteSizeBefore == 100'000 * (sizeof(SVertex3D) + sizeof(SVertexAnimation)));
+	CHECK(KStats.ByteSizeAfter == 100'000 * 32);
+}
+
+TEST_CASE(VertexCompressor_KeepsBitangentHandedness)
+{
+	const SMesh KMesh{ GenerateRandomMesh(10'000, 11) };
+	const CVertexCompressor::SCBVSVertexQuantizationData KQuantization{ CVertexCompressor::CalculateQuantization(vector<SMesh>{ KMesh }) };
+
+	vector<SVertex3DCompressed> vCompressed{};
+	CVertexCompressor::CompressVertices(KMesh.vVertices, KQuantization, vCompressed);
+	CHECK(vCompressed.size() == KMesh.vVertices.size());
+
+	size_t FlippedCount{};
+	for (size_t iVertex = 0; iVertex < vCompressed.size(); ++iVertex)
+	{
+		const SVertex3D KDecompressed{ CVertexCompressor::DecompressVertex(vCompressed[iVertex], KQuantization) };
+		if (XMVectorGetX(XMVector3Dot(KDecompressed.Bitangent, KMesh.vVertices[iVertex].Bitangent)) <= 0.0f) ++FlippedCount;
+	}
+	CHECK(FlippedCount == 0);
+}
+
+TEST_CASE(VertexCompressor_WeightsSumTo255)
+{
+	const SMesh KMesh{ GenerateRandomMesh(10'000, 13) };
+
+	vector<SVertexAnimationCompressed> vCompressed{};
+	CVertexCompressor::CompressVerticesAnimation(KMesh.vVerticesAnimation, vCompressed);
+	CHECK(vCompressed.size() == KMesh.vVerticesAnimation.size());
+
+	size_t WrongSumCount{};
+	size_t WrongBoneCount{};
+	for (size_t iVertex = 0; iVertex < vCompressed.size(); ++iVertex)
+	{
+		const SVertexAnimationCompressed& Compressed{ vCompressed[iVertex] };
+		if (Compressed.Weights.x + Compressed.Weights.y + Compressed.Weights.z + Compressed.Weights.w != 255) ++WrongSumCount;
+		if (Compressed.BoneIDs.x != KMesh.vVerticesAnimation[iVertex].BoneIDs[0]) ++WrongBoneCount;
+	}
+	CHECK(WrongSumCount == 0);
+	CHECK(WrongBoneCount == 0);
+}
+
+BENCH_CASE(VertexCompressor_Throughput)
+{
+	const SMesh KMesh{ GenerateRandomMesh(1'000'000, 17) };
+	const CVertexCompressor::SCBVSVertexQuantizationData KQuantization{ CVertexCompressor::CalculateQuantization(vector<SMesh>{ KMesh }) };
+
+	vector<SVertex3DCompressed> vCompressed{};
+	CTestTimer Timer{};
+	CVertexCompressor::CompressVertices(KMesh.vVertices, KQuantization, vCompressed);
+	const double KCompressMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+	Timer = CTestTimer();
+	float Checksum{};
+	for (const SVertex3DCompressed& Vertex : vCompressed)
+	{
+		Checksum += XMVectorGetX(CVertexCompressor::DecompressVertex(Vertex, KQuantization).Position);
+	}
+	const double KDecompressMilliseconds{ Timer.GetElapsedMilliseconds() };
+
+	printf("compress: %.1f Mvertices/s, decompress: %.1f Mvertices/s (checksum %g)\n",
+		1'000.0 / KCompressMilliseconds, 1'000.0 / KDecompressMilliseconds, Checksum);
+	CHECK(vCompressed.size() == KMesh.vVertices.size());
+}
@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "Core/WorkerPool.h"
+
+TEST_CASE(WorkerPool_RunsEveryJobOnce)
+{
+	CWorkerPool Pool{ 3 };
+	CHECK(Pool.GetThreadCount() == 4);
+
+	size_t WrongCount{};
+	for (uint32_t JobCount : { 0u, 1u, 2u, 3u, 7u, 64u, 1000u })
+	{
+		for (uint32_t MaxThreadCount : { 0u, 1u, 2u, 4u, 16u })
+		{
+			vector<std::atomic<uint32_t>> vRunCounts(JobCount);
+			Pool.ForEach(JobCount, MaxThreadCount, [&](uint32_t iJob) { ++vRunCounts[iJob]; });
+			for (const auto& RunCount : vRunCounts)
+			{
+				if (RunCount != 1) ++WrongCount;
+			}
+		}
+	}
+	CHECK(WrongCount == 0);
+}
+
+TEST_CASE(WorkerPool_LimitsThreadCount)
+{
+	CWorkerPool Pool{ 3 };
+	for (uint32_t MaxThreadCount : { 1u, 2u, 3u })
+	{
+		std::mutex Mutex{};
+		vector<std::thread::id> vThreadIDs{};
+		Pool.ForEach(256, MaxThreadCount, [&](uint32_t)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+				std::lock_guard<std::mutex> Lock{ Mutex };
+				if (std::find(vThreadIDs.begin(), vThreadIDs.end(), std::this_thread::get_id()) == vThreadIDs.end())
+				{
+					vThreadIDs.push_back(std::this_thread::get_id());
+				}
+			});
+		CHECK(vThreadIDs.size() <= MaxThreadCount);
+	}
+
+	// A single thread is the calling thread
+	std::thread::id ThreadID{};
+	Pool.ForEach(8, 1, [&](uint32_t) { ThreadID = std::this_thread::get_id(); });
+	CHECK(ThreadID == std::this_thread::get_id());
+}
+
+TEST_CASE(WorkerPool_NestedAndConcurrentLoops)
+{
+	CWorkerPool Pool{ 3 };
+
+	// Loops started from inside a job run inline instead of waiting for the busy workers
+	std::atomic<uint32_t> InnerRunCount{};
+	Pool.ForEach(16, 0, [&](uint32_t)
+		{
+			Pool.ForEach(16, 0, [&](uint32_t) { ++InnerRunCount; });
+		});
+	CHECK(InnerRunCount == 16 * 16);
+
+	// Loops started from several threads at once: one gets the workers, the others run on their own thread
+	std::atomic<uint32_t> RunCount{};
+	vector<std::thread> vThreads{};
+	for (int iThread = 0; iThread < 4; ++iThread)
+	{
+		vThreads.emplace_back([&]()
+			{
+				for (int iLoop = 0; iLoop < 200; ++iLoop)
+				{
+					Pool.ForEach(32, 0, [&](uint32_t) { ++RunCount; });
+				}
+			});
+	}
+	for (auto& Thread : vThreads)
+	{
+		Thread.join();
+	}
+	CHECK(RunCount == 4 * 200 * 32);
+}
+
+// The cost of a loop of 16 empty jobs: threads spawned for each loop (what the brush, terrain generator and mip generator did) vs. the pool
+BENCH_CASE(WorkerPool_LoopOverhead)
+{
+	constexpr uint32_t KJobCount{ 16 };
+	constexpr int KLoopCount{ 2'000 };
+	const uint32_t KThreadCount{ 4 };
+
+	CTestTimer Timer{};
+	std::atomic<uint32_t> RunCount{};
+	for (int iLoop = 0; iLoop < KLoopCount; ++iLoop)
+	{
+		std::atomic<uint32_t> NextJob{};
+		auto RunJobs{ [&]()
+			{
+				for (uint32_t iJob = NextJob++; iJob < KJobCount; iJob = NextJob++) ++RunCount;
+			} };
+		vector<std::thread> vThreads{};
+		for (uint32_t iThread = 1; iThread < KThreadCount; ++iThread)
+		{
+			vThreads.emplace_back(RunJobs);
+		}
+		RunJobs();
+		for (auto& Thread : vThreads)
+		{
+			Thread.join();
+		}
+	}
+	const double KSpawnMicroseconds{ Timer.GetElapsedMilliseconds() * 1000.0 / KLoopCount };
+
+	CWorkerPool Pool{ KThreadCount - 1 };
+	Timer = CTestTimer();
+	for (int iLoop = 0; iLoop < KLoopCount; ++iLoop)
+	{
+		Pool.ForEach(KJobCount, 0, [&](uint32_t) { ++RunCount; });
+	}
+	const double KPoolMicroseconds{ Timer.GetElapsedMilliseconds() * 1000.0 / KLoopCount };
+
+	CHECK(RunCount == 2 * KLoopCount * KJobCount);
+	printf("%u threads, %u empty jobs per loop: spawning threads %.2f us per loop, worker pool %.2f us per loop\n",
+		KThreadCount, KJobCount, KSpawnMicroseconds, KPoolMicroseconds);
+}
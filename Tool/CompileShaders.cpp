@@ -0,0 +1,132 @@
+#include "Core/Game.h"
+#include "Core/RenderDeviceNull.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Compiles with an fxc or dxc executable (dxc only takes shader model 6, so the engine's SM4/SM5 profiles are raised to 6.0 for it)
+class CShaderCompilerExternal final : public CShaderCompiler
+{
+public:
+	CShaderCompilerExternal(const string& CompilerFileName, const string& TemporaryDirectory) :
+		m_CompilerFileName{ CompilerFileName }, m_TemporaryDirectory{ TemporaryDirectory }
+	{
+		const size_t KNameBegin{ CompilerFileName.find_last_of("\\/") + 1 };
+		string Name{ CompilerFileName.substr(KNameBegin) };
+		for (auto& c : Name)
+		{
+			c = static_cast<char>(tolower(c));
+		}
+		m_bIsDXC = (Name.compare(0, 3, "dxc") == 0);
+	}
+	~CShaderCompilerExternal() {}
+
+public:
+	bool Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors) override
+	{
+		const string KIndex{ to_string(m_NextFileIndex++) };
+		const string KOutputFileName{ m_TemporaryDirectory + "/Shader" + KIndex + ".cso" };
+		const string KLogFileName{ m_TemporaryDirectory + "/Shader" + KIndex + ".log" };
+
+		string Profile{ Desc.Profile };
+		if (m_bIsDXC && Profile.size() > 3) Profile = Profile.substr(0, 3) + "6_0";
+
+		string Command{ "\"" + m_CompilerFileName + "\" -nologo -T " + Profile + " -E " + Desc.EntryPoint };
+		for (const SShaderDefine& Define : Desc.vDefines)
+		{
+			Command += " -D " + Define.Name + "=" + ((Define.Value.empty()) ? "1" : Define.Value);
+		}
+		Command += GetFlagOptions(Desc.Flags);
+		Command += " -Fo \"" + KOutputFileName + "\" \"" + GetPortableFileName(Desc.FileName) + "\" > \"" + KLogFileName + "\" 2>&1";
+#if defined(_WIN32)
+		// cmd.exe strips the outer quotes of a command that starts with one
+		Command = "\"" + Command + "\"";
+#endif
+
+		const bool bSucceeded{ std::system(Command.c_str()) == 0 };
+		OutErrors = ReadFile(KLogFileName);
+		string Bytecode{ (bSucceeded) ? ReadFile(KOutputFileName) : string() };
+		OutBytecode.assign(Bytecode.begin(), Bytecode.end());
+		remove(KLogFileName.c_str());
+		remove(KOutputFileName.c_str());
+		return bSucceeded && !OutBytecode.empty();
+	}
+
+private:
+	static string GetFlagOptions(UINT Flags)
+	{
+		string Options{};
+		if (Flags & D3DCOMPILE_DEBUG) Options += " -Zi";
+		if (Flags & D3DCOMPILE_SKIP_VALIDATION) Options += " -Vd";
+		if (Flags & D3DCOMPILE_SKIP_OPTIMIZATION) Options += " -Od";
+		if (Flags & D3DCOMPILE_PACK_MATRIX_ROW_MAJOR) Options += " -Zpr";
+		if (Flags & D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR) Options += " -Zpc";
+		if (Flags & D3DCOMPILE_ENABLE_STRICTNESS) Options += " -Ges";
+		if (Flags & D3DCOMPILE_WARNINGS_ARE_ERRORS) Options += " -WX";
+
+		// The optimization level takes two bits (level 1 is 0)
+		constexpr UINT KOptimizationMask{ D3DCOMPILE_OPTIMIZATION_LEVEL0 | D3DCOMPILE_OPTIMIZATION_LEVEL3 };
+		switch (Flags & KOptimizationMask)
+		{
+		case D3DCOMPILE_OPTIMIZATION_LEVEL0: Options += " -O0"; break;
+		case D3DCOMPILE_OPTIMIZATION_LEVEL2: Options += " -O2"; break;
+		case D3DCOMPILE_OPTIMIZATION_LEVEL3: Options += " -O3"; break;
+		default: Options += " -O1"; break;
+		}
+		return Options;
+	}
+
+	// The engine names shaders with '\\' separators, which only Windows resolves
+	static string GetPortableFileName(const string& FileName)
+	{
+		string Result{ FileName };
+		std::replace(Result.begin(), Result.end(), '\\', '/');
+		return Result;
+	}
+
+	static string ReadFile(const string& FileName)
+	{
+		std::ifstream ifs{ FileName, std::ifstream::binary };
+		if (!ifs.is_open()) return string();
+
+		std::stringstream Stream{};
+		Stream << ifs.rdbuf();
+		return Stream.str();
+	}
+
+private:
+	string					m_CompilerFileName{};
+	string					m_TemporaryDirectory{};
+	bool					m_bIsDXC{};
+	std::atomic<uint32_t>	m_NextFileIndex{};
+};
+
+// Compiles every shader permutation that CGame creates (through a headless CGame, so the list can't drift from the engine's)
+// Exits with 77 (which ctest reports as skipped) if no compiler is given
+// Usage: CompileShaders <fxc or dxc> <temporary directory>
+int main(int argc, char* argv[])
+{
+	if (argc < 3 || strlen(argv[1]) == 0)
+	{
+		printf("No fxc or dxc was found: shaders aren't compiled\n");
+		return 77;
+	}
+
+	const string KTemporaryDirectory{ argv[2] };
+	// Fails if the directory exists already, which is fine
+	CreateDirectoryA(KTemporaryDirectory.c_str(), nullptr);
+
+	// No cache directory, so every permutation is compiled on every run
+	CGame Game{ nullptr, XMFLOAT2(800, 600) };
+	Game.CreateHeadless(make_unique<CRenderDeviceNull>(false), make_unique<CShaderCompilerExternal>(argv[1], KTemporaryDirectory), "");
+
+	const CShaderCache::SStats& KStats{ Game.GetShaderCacheStats() };
+	printf("%s: %zu shaders compiled, %zu failed in %llu ms\n", argv[1], KStats.MissCount, KStats.FailureCount,
+		static_cast<unsigned long long>(KStats.ElapsedMilliseconds));
+	Game.Destroy();
+	return (KStats.FailureCount || KStats.MissCount == 0) ? 1 : 0;
+}
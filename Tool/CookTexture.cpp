@@ -0,0 +1,61 @@
+#include "Core/TextureCooker.h"
+#include <cstdio>
+#include <cstring>
+
+// Cooks each texture into <stem>.dds next to it, which CMaterial::CTexture loads instead of the source while it's up to date
+// Textures whose cooked files are up to date are skipped unless -force is given
+// Usage: CookTexture [-bc1 | -bc3 | -bc5 | -bc7] [-nomips] [-srgb] [-alphacoverage] [-force] <texture> ...
+int main(int argc, char* argv[])
+{
+	CTextureCooker::EFormat eFormat{ CTextureCooker::EFormat::BC7 };
+	CMipGenerator::SDesc MipDesc{ CMipGenerator::EFilter::Kaiser };
+	bool bShouldGenerateMipMap{ true };
+	bool bShouldForce{ false };
+	vector<string> vFileNames{};
+	for (int iArgument = 1; iArgument < argc; ++iArgument)
+	{
+		const char* const KArgument{ argv[iArgument] };
+		if (strcmp(KArgument, "-bc1") == 0) eFormat = CTextureCooker::EFormat::BC1;
+		else if (strcmp(KArgument, "-bc3") == 0) eFormat = CTextureCooker::EFormat::BC3;
+		else if (strcmp(KArgument, "-bc5") == 0) eFormat = CTextureCooker::EFormat::BC5;
+		else if (strcmp(KArgument, "-bc7") == 0) eFormat = CTextureCooker::EFormat::BC7;
+		else if (strcmp(KArgument, "-nomips") == 0) bShouldGenerateMipMap = false;
+		else if (strcmp(KArgument, "-srgb") == 0) MipDesc.bIsSRGB = true;
+		else if (strcmp(KArgument, "-alphacoverage") == 0) MipDesc.bShouldPreserveAlphaCoverage = true;
+		else if (strcmp(KArgument, "-force") == 0) bShouldForce = true;
+		else if (KArgument[0] == '-')
+		{
+			fprintf(stderr, "Unknown option: %s\n", KArgument);
+			return 2;
+		}
+		else vFileNames.emplace_back(KArgument);
+	}
+	if (vFileNames.empty())
+	{
+		fprintf(stderr, "Usage: CookTexture [-bc1 | -bc3 | -bc5 | -bc7] [-nomips] [-srgb] [-alphacoverage] [-force] <texture> ...\n");
+		return 2;
+	}
+
+	CTextureCooker Cooker{};
+	int FailureCount{};
+	for (const string& FileName : vFileNames)
+	{
+		const string KCookedFileName{ CTextureCooker::GetCookedFileName(FileName) };
+		if (!bShouldForce && CTextureCooker::IsCookedFileUpToDate(FileName, KCookedFileName))
+		{
+			printf("%s: up to date\n", KCookedFileName.c_str());
+			continue;
+		}
+		if (!Cooker.Cook(FileName, KCookedFileName, eFormat, bShouldGenerateMipMap, MipDesc))
+		{
+			fprintf(stderr, "%s: failed to cook\n", FileName.c_str());
+			++FailureCount;
+			continue;
+		}
+
+		const CTextureCooker::SCookStats& KStats{ Cooker.GetLastStats() };
+		printf("%s: %ux%u, %u mips, %zu -> %zu bytes, PSNR %.2f dB, %.1f MPix/s\n", KCookedFileName.c_str(), KStats.Width, KStats.Height,
+			KStats.MipLevels, KStats.SourceByteSize, KStats.CookedByteSize, KStats.PSNR, KStats.MegaPixelsPerSecond);
+	}
+	return (FailureCount) ? 1 : 0;
+}
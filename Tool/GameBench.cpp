@@ -0,0 +1,225 @@
+#include "Core/Game.h"
+#include "Core/RenderDeviceNull.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Stands in for the D3D compiler: the "bytecode" is a hash of the desc, so that every permutation gets distinct shader objects
+class CShaderCompilerNull final : public CShaderCompiler
+{
+public:
+	bool Compile(const SShaderCompileDesc& Desc, vector<uint8_t>& OutBytecode, string& OutErrors) override
+	{
+		uint64_t Hash{ 14695981039346656037ull };
+		auto HashString{ [&](const string& String)
+		{
+			for (char Character : String) Hash = (Hash ^ static_cast<uint8_t>(Character)) * 1099511628211ull;
+			Hash = (Hash ^ 0xFF) * 1099511628211ull;
+		} };
+		HashString(Desc.FileName);
+		HashString(Desc.EntryPoint);
+		HashString(Desc.Profile);
+		for (const SShaderDefine& Define : Desc.vDefines)
+		{
+			HashString(Define.Name);
+			HashString(Define.Value);
+		}
+		OutBytecode.resize(sizeof(Hash));
+		memcpy(OutBytecode.data(), &Hash, sizeof(Hash));
+		OutErrors.clear();
+		return true;
+	}
+};
+
+// Runs CGame frames on CRenderDeviceNull (terrain, grass, particles and a grid of primitives) and reports the CPU time per frame
+// The first frame (which creates every shader variant) is reported separately
+// -record: the frames are then drawn again with EFlagsRendering::RecordInParallel on 1, 2, 4 and 8 threads, reporting the recording
+// time of each and failing if they don't draw what the immediate frames drew
+// -stream: the terrain's tiles around the camera are also paged from the directory (flat tiles where it has none)
+// Usage: GameBench [-frames <count>] [-objects <count per side>] [-cache <shader cache directory>] [-record] [-stream <tile directory>]
+int main(int argc, char* argv[])
+{
+	static constexpr uint32_t KRecordingThreadCounts[]{ 1, 2, 4, 8 };
+
+	int FrameCount{ 300 };
+	int ObjectCountPerSide{ 8 };
+	string ShaderCacheDirectory{ "GameBenchShaderCache" };
+	bool bShouldRecord{};
+	string TerrainTileDirectory{};
+	for (int iArgument = 1; iArgument < argc; ++iArgument)
+	{
+		const char* const KArgument{ argv[iArgument] };
+		const bool bHasValue{ iArgument + 1 < argc };
+		if (strcmp(KArgument, "-frames") == 0 && bHasValue) FrameCount = atoi(argv[++iArgument]);
+		else if (strcmp(KArgument, "-objects") == 0 && bHasValue) ObjectCountPerSide = atoi(argv[++iArgument]);
+		else if (strcmp(KArgument, "-cache") == 0 && bHasValue) ShaderCacheDirectory = argv[++iArgument];
+		else if (strcmp(KArgument, "-record") == 0) bShouldRecord = true;
+		else if (strcmp(KArgument, "-stream") == 0 && bHasValue) TerrainTileDirectory = argv[++iArgument];
+		else
+		{
+			fprintf(stderr, "Usage: GameBench [-frames <count>] [-objects <count per side>] [-cache <shader cache directory>] [-record] "
+				"[-stream <tile directory>]\n");
+			return 2;
+		}
+	}
+	if (FrameCount < 1 || ObjectCountPerSide < 0)
+	{
+		fprintf(stderr, "Invalid frame or object count\n");
+		return 2;
+	}
+
+	// Not recording keeps memory flat over many frames; the stats are still counted
+	unique_ptr<CRenderDeviceNull> RenderDevice{ make_unique<CRenderDeviceNull>(false) };
+	CRenderDeviceNull* const PtrRenderDevice{ RenderDevice.get() };
+
+	CGame Game{ nullptr, XMFLOAT2(800, 600) };
+	Game.CreateHeadless(std::move(RenderDevice), make_unique<CShaderCompilerNull>(), ShaderCacheDirectory);
+
+	Game.SetAmbientlLight(XMFLOAT3(1, 1, 1), 0.2f);
+	Game.SetDirectionalLight(XMVectorSet(0, 1, 0, 0), XMVectorSet(1, 1, 1, 1));
+	const CGame::EFlagsRendering KFlags{ CGame::EFlagsRendering::UseLighting | CGame::EFlagsRendering::DrawMiniAxes |
+		CGame::EFlagsRendering::TessellateTerrain | CGame::EFlagsRendering::UseStaticBatching };
+	Game.SetGameRenderingFlags(KFlags);
+	Game.AddCamera(CCamera::SCameraData(CCamera::EType::FreeLook, XMVectorSet(0, 20, -40, 0), XMVectorSet(0, 0, 0, 0)));
+
+	CMaterial TerrainMaterial{};
+	TerrainMaterial.SetName("Ground");
+	TerrainMaterial.SetUniformColor(XMFLOAT3(0.4f, 0.6f, 0.2f));
+	Game.CreateTerrain(XMFLOAT2(64, 64), TerrainMaterial, 4.0f);
+
+	if (!TerrainTileDirectory.empty())
+	{
+		CTerrainStreamer::SDesc StreamerDesc{};
+		StreamerDesc.MaskingSize = 64;
+		Game.SetTerrainTileDirectory(TerrainTileDirectory, StreamerDesc);
+	}
+
+	const float KObjectInterval{ 4.0f };
+	const float KObjectOffset{ -0.5f * KObjectInterval * static_cast<float>(ObjectCountPerSide) };
+	for (int iZ = 0; iZ < ObjectCountPerSide; ++iZ)
+	{
+		for (int iX = 0; iX < ObjectCountPerSide; ++iX)
+		{
+			const string KName{ "Object" + to_string(iZ * ObjectCountPerSide + iX) };
+			Game.InsertObject3D(KName);
+			CObject3D* const Object3D{ Game.GetObject3D(KName) };
+			Object3D->Create(((iX + iZ) % 2) ? GenerateCube() : GenerateSphere(16));
+			Object3D->ComponentTransform.Translation = XMVectorSet(KObjectOffset + KObjectInterval * iX, 1.0f,
+				KObjectOffset + KObjectInterval * iZ, 1.0f);
+			Object3D->UpdateWorldMatrix();
+		}
+	}
+
+	CGrassField GrassField{ PtrRenderDevice, &Game };
+	GrassField.Create(18, 2.0f, 3.0f, 0.2f, XM_PIDIV2 * 0.75f, XM_PIDIV2, 0.3f, XMVectorSet(0.4f, 0.6f, 0, 1), XMVectorSet(0.0f, 0.5f, 0, 1),
+		"Asset/grass_blade.jpg");
+	Game.AddGrassField(&GrassField);
+
+	// Spawned once and never updated, so that every frame draws the same particles
+	CParticlePool ParticlePool{ PtrRenderDevice, &Game.GetTransientUploadRing() };
+	ParticlePool.Create(256);
+	for (int iParticle = 0; iParticle < 256; ++iParticle)
+	{
+		ParticlePool.SpawnParticle();
+	}
+	Game.AddParticlePool(&ParticlePool);
+
+	const float KDeltaTime{ 1.0f / 60.0f };
+	auto DrawFrame{ [&]()
+	{
+		Game.BeginRendering(Colors::CornflowerBlue);
+		Game.Animate();
+		Game.Draw(KDeltaTime);
+		Game.EndRendering();
+	} };
+
+	using std::chrono::steady_clock;
+	const steady_clock::time_point KFirstFrameStart{ steady_clock::now() };
+	DrawFrame();
+	// Every tile around the (still) camera is made resident first, so that every frame draws the same tiles
+	CTerrainStreamer* const PtrStreamer{ Game.GetTerrain()->GetStreamer() };
+	while (PtrStreamer && PtrStreamer->GetStats().LoadingTileCount)
+	{
+		PtrStreamer->Flush();
+		DrawFrame();
+	}
+	const double KFirstFrameMilliseconds{ std::chrono::duration<double, std::milli>(steady_clock::now() - KFirstFrameStart).count() };
+	const double KBatchBuildMilliseconds{ Game.GetStaticBatcherStats().ElapsedMilliseconds };
+
+	PtrRenderDevice->Reset();
+	const steady_clock::time_point KStart{ steady_clock::now() };
+	for (int iFrame = 0; iFrame < FrameCount; ++iFrame)
+	{
+		DrawFrame();
+	}
+	const double KMilliseconds{ std::chrono::duration<double, std::milli>(steady_clock::now() - KStart).count() };
+
+	const CRenderDeviceNull::SStats& KStats{ PtrRenderDevice->GetStats() };
+	printf("%d objects, %d frames: first frame %.2f ms, then %.3f ms/frame (%.0f frames/s)\n", ObjectCountPerSide * ObjectCountPerSide,
+		FrameCount, KFirstFrameMilliseconds, KMilliseconds / FrameCount, FrameCount * 1000.0 / KMilliseconds);
+	printf("Per frame: %.1f device calls, %.1f draw calls, %.0f primitives, %.1f maps (%.1f KB), %.1f KB updated\n",
+		static_cast<double>(KStats.CallCount) / FrameCount, static_cast<double>(KStats.DrawCallCount) / FrameCount,
+		static_cast<double>(KStats.PrimitiveCount) / FrameCount, static_cast<double>(KStats.MapCount) / FrameCount,
+		KStats.MappedByteCount / 1024.0 / FrameCount, KStats.UpdatedByteCount / 1024.0 / FrameCount);
+	const CStaticBatcher::SStats& KBatcherStats{ Game.GetStaticBatcherStats() };
+	printf("Static batching: %zu meshes -> %zu batches (%zu drawn), built in %.3f ms on the first frame\n", KBatcherStats.MemberCount,
+		KBatcherStats.BatchCount, Game.GetStaticBatchDrawCount(), KBatchBuildMilliseconds);
+	printf("Shader cache: %zu compiled, %zu loaded\n", Game.GetShaderCacheStats().MissCount, Game.GetShaderCacheStats().HitCount);
+	const CTerrain::SMaskingStats KMaskingStats{ Game.GetTerrain()->GetMaskingStats() };
+	printf("Terrain masking: %.1f KB on the CPU (dense %.1f KB), %.1f KB on the GPU (dense %.1f KB) in %zu / %zu atlas slots\n",
+		KMaskingStats.CPU.MemoryBytes / 1024.0, KMaskingStats.CPU.DenseMemoryBytes / 1024.0, KMaskingStats.GPUBytes / 1024.0,
+		KMaskingStats.DenseGPUBytes / 1024.0, KMaskingStats.AtlasUsedSlotCount, KMaskingStats.AtlasSlotCount);
+	if (PtrStreamer)
+	{
+		const CTerrainStreamer::SStats& KStreamerStats{ PtrStreamer->GetStats() };
+		printf("Terrain streaming: %zu tiles resident (%.1f MB), %zu loaded (%zu created), %zu drawn\n", KStreamerStats.ResidentTileCount,
+			KStreamerStats.ResidentBytes / 1024.0 / 1024.0, KStreamerStats.LoadedTileCount, KStreamerStats.CreatedTileCount,
+			Game.GetTerrain()->GetStreamedTileCount());
+	}
+
+	size_t ValidationErrorCount{ KStats.ValidationErrorCount };
+	bool bHasMismatch{};
+	if (bShouldRecord)
+	{
+		const CRenderDeviceNull::SStats KImmediateStats{ KStats };
+
+		Game.SetGameRenderingFlags(KFlags | CGame::EFlagsRendering::RecordInParallel);
+		for (uint32_t ThreadCount : KRecordingThreadCounts)
+		{
+			Game.SetRecordingThreadCount(ThreadCount);
+			PtrRenderDevice->Reset();
+
+			double RecordingMilliseconds{};
+			const steady_clock::time_point KRecordingStart{ steady_clock::now() };
+			for (int iFrame = 0; iFrame < FrameCount; ++iFrame)
+			{
+				DrawFrame();
+				RecordingMilliseconds += Game.GetCommandRecorderStats().ElapsedMilliseconds;
+			}
+			const double KRecordedMilliseconds{ std::chrono::duration<double, std::milli>(steady_clock::now() - KRecordingStart).count() };
+
+			const CRenderDeviceNull::SStats& KRecordedStats{ PtrRenderDevice->GetStats() };
+			const CCommandRecorder::SStats& KRecorderStats{ Game.GetCommandRecorderStats() };
+			printf("Recorded on %u thread(s): %.3f ms/frame recording %zu jobs (%zu commands, %.1f KB), %.3f ms/frame in total\n", 
+				KRecorderStats.ThreadCount, RecordingMilliseconds / FrameCount, KRecorderStats.JobCount, KRecorderStats.CommandCount,
+				KRecorderStats.DataByteSize / 1024.0, KRecordedMilliseconds / FrameCount);
+
+			// The same draws as the immediate frames, whatever the thread count
+			if (KRecordedStats.DrawCallCount != KImmediateStats.DrawCallCount || KRecordedStats.PrimitiveCount != KImmediateStats.PrimitiveCount)
+			{
+				fprintf(stderr, "Recorded frames drew %zu calls (%zu primitives) instead of %zu (%zu)\n", KRecordedStats.DrawCallCount,
+					KRecordedStats.PrimitiveCount, KImmediateStats.DrawCallCount, KImmediateStats.PrimitiveCount);
+				bHasMismatch = true;
+			}
+			ValidationErrorCount += KRecordedStats.ValidationErrorCount;
+		}
+	}
+
+	Game.Destroy();
+	if (ValidationErrorCount)
+	{
+		fprintf(stderr, "%zu validation errors, the last: %s\n", ValidationErrorCount, PtrRenderDevice->GetLastValidationError().c_str());
+		return 1;
+	}
+	return (bHasMismatch) ? 1 : 0;
+}
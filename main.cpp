@@ -24,7 +24,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
 	Game.SetGameRenderingFlags(CGame::EFlagsRendering::UseLighting | CGame::EFlagsRendering::DrawMiniAxes |
 		CGame::EFlagsRendering::DrawTerrainHeightMapTexture | CGame::EFlagsRendering::DrawTerrainMaskingTexture | 
-		CGame::EFlagsRendering::TessellateTerrain | CGame::EFlagsRendering::Use3DGizmos);
+		CGame::EFlagsRendering::TessellateTerrain | CGame::EFlagsRendering::Use3DGizmos | CGame::EFlagsRendering::UseStaticBatching);
 
 	CCamera* MainCamera{ Game.AddCamera(CCamera::SCameraData(CCamera::EType::FreeLook, XMVectorSet(0, 0, -2, 0), XMVectorSet(0, 0, -1, 0))) };
 
@@ -33,10 +33,19 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 		CObject3DLine* Grid{ Game.GetObject3DLine("Grid") };
 		Grid->Create(Generate3DGrid(0));
 	}
+
+	// The terrain is streamed from its tiles, which are created flat where there are none yet
+	CMaterial TerrainMaterial{};
+	TerrainMaterial.SetName("Ground");
+	TerrainMaterial.SetUniformColor(XMFLOAT3(0.4f, 0.6f, 0.2f));
+	Game.CreateTerrain(XMFLOAT2(64, 64), TerrainMaterial, CTerrain::KMaskingDefaultDetail);
+	Game.GetTerrain()->ShouldDrawWater(false); // The flat tiles would be under the water
+	Game.SetTerrainTileDirectory("Asset\\TerrainTiles");
 	
-	CGrassField GrassField{ Game.GetDevicePtr(), Game.GetDeviceContextPtr(), &Game };
+	CGrassField GrassField{ &Game.GetRenderDevice(), &Game };
 	GrassField.Create(18, 2.0f, 3.0f, 0.2f, XM_PIDIV2 * 0.75f, XM_PIDIV2, 0.3f, XMVectorSet(0.4f, 0.6f, 0, 1), XMVectorSet(0.0f, 0.5f, 0, 1),
 		"Asset\\grass_blade.jpg");
+	Game.AddGrassField(&GrassField);
 
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
@@ -134,6 +143,25 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 			{
 				Game.ToggleGameRenderingFlags(CGame::EFlagsRendering::DrawBoundingSphere);
 			}
+			if (KeyDown == VK_F5)
+			{
+				Game.ToggleGameRenderingFlags(CGame::EFlagsRendering::UseStaticBatching);
+			}
+			if (KeyDown == VK_F6)
+			{
+				Game.ToggleGameRenderingFlags(CGame::EFlagsRendering::RecordInParallel);
+			}
+			if (KeyDown == VK_F7)
+			{
+				Game.SetEditMode((Game.GetEditMode() == CGame::EEditMode::EditTerrain) ?
+					CGame::EEditMode::EditObject : CGame::EEditMode::EditTerrain);
+			}
+			if (KeyDown == VK_F8)
+			{
+				// SetHeight -> DeltaHeight -> Masking -> Brush
+				CTerrain* const PtrTerrain{ Game.GetTerrain() };
+				Game.SetTerrainEditMode(static_cast<CTerrain::EEditMode>((static_cast<int>(PtrTerrain->GetEditMode()) + 1) % 4));
+			}
 
 			// Mouse input
 			const Mouse::State& MouseState{ Game.GetMouseState() };
@@ -186,7 +214,6 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
 			Game.Animate();
 			Game.Draw(DeltaTimeF);
-			GrassField.Draw();
 
 			ImGui_ImplDX11_NewFrame();
 			ImGui_ImplWin32_NewFrame();